@@ -21,12 +21,14 @@ int main( int, char *[] )
     REGISTER_TESTGROUP( TestMemPoolBlock )
     REGISTER_TESTGROUP( TestMutex )
     REGISTER_TESTGROUP( TestPathUtils )
+    REGISTER_TESTGROUP( TestProcess )
     REGISTER_TESTGROUP( TestReflection )
     REGISTER_TESTGROUP( TestSemaphore )
     REGISTER_TESTGROUP( TestSharedMemory )
     REGISTER_TESTGROUP( TestSmallBlockAllocator )
     REGISTER_TESTGROUP( TestSystemMutex )
     REGISTER_TESTGROUP( TestTestTCPConnectionPool )
+    REGISTER_TESTGROUP( TestThreadPool )
     REGISTER_TESTGROUP( TestTimer )
 
     UnitTestManager utm;
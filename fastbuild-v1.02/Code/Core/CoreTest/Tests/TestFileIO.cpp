@@ -30,6 +30,7 @@ private:
     void FileCopy() const;
     void FileCopySymlink() const;
     void FileMove() const;
+    void FileHardLink() const;
     void ReadOnly() const;
     void FileTime() const;
     void LongPaths() const;
@@ -47,6 +48,7 @@ REGISTER_TESTS_BEGIN( TestFileIO )
     REGISTER_TEST( FileCopy )
     REGISTER_TEST( FileCopySymlink )
     REGISTER_TEST( FileMove )
+    REGISTER_TEST( FileHardLink )
     REGISTER_TEST( ReadOnly )
     REGISTER_TEST( FileTime )
     REGISTER_TEST( LongPaths )
@@ -229,6 +231,46 @@ void TestFileIO::FileMove() const
     VERIFY( FileIO::FileDelete( pathCopy.Get() ) );
 }
 
+// FileHardLink
+//------------------------------------------------------------------------------
+void TestFileIO::FileHardLink() const
+{
+    // generate a process unique file path
+    AStackString<> path;
+    GenerateTempFileName( path );
+
+    // generate link file name
+    AStackString<> pathLink( path );
+    pathLink += ".link";
+
+    // make sure nothing is left from previous runs
+    FileIO::FileDelete( path.Get() );
+    FileIO::FileDelete( pathLink.Get() );
+
+    // create it
+    FileStream f;
+    TEST_ASSERT( f.Open( path.Get(), FileStream::WRITE_ONLY ) == true );
+    TEST_ASSERT( f.WriteBuffer( "data", 4 ) == 4 );
+    f.Close();
+
+    // link it
+    TEST_ASSERT( FileIO::FileHardLink( path, pathLink ) );
+    TEST_ASSERT( FileIO::FileExists( path.Get() ) == true );
+    FileIO::FileInfo info;
+    TEST_ASSERT( FileIO::GetFileInfo( pathLink, info ) == true );
+    TEST_ASSERT( info.m_Size == 4 );
+
+    // the link survives the original
+    VERIFY( FileIO::FileDelete( path.Get() ) );
+    TEST_ASSERT( FileIO::FileExists( pathLink.Get() ) == true );
+
+    // linking to an existing file fails
+    TEST_ASSERT( FileIO::FileHardLink( pathLink, pathLink ) == false );
+
+    // cleanup
+    VERIFY( FileIO::FileDelete( pathLink.Get() ) );
+}
+
 // ReadOnly
 //------------------------------------------------------------------------------
 void TestFileIO::ReadOnly() const
@@ -24,6 +24,7 @@ private:
 
     void CompareHashTimes_Large() const;
     void CompareHashTimes_Small() const;
+    void xxHashStream() const;
 };
 
 // Register Tests
@@ -31,6 +32,7 @@ private:
 REGISTER_TESTS_BEGIN( TestHash )
     REGISTER_TEST( CompareHashTimes_Large )
     REGISTER_TEST( CompareHashTimes_Small )
+    REGISTER_TEST( xxHashStream )
 REGISTER_TESTS_END
 
 // CompareHashTimes_Large
@@ -243,4 +245,35 @@ void TestHash::CompareHashTimes_Small() const
     }
 }
 
+// xxHashStream
+//------------------------------------------------------------------------------
+void TestHash::xxHashStream() const
+{
+    // use pseudo-random (but deterministic) data
+    Random r( 0xB1234567 );
+    const size_t dataSize( 1024 * 1024 + 7 );
+    AutoPtr< uint8_t > data( (uint8_t *)ALLOC( dataSize ) );
+    for ( size_t i = 0; i < dataSize; ++i )
+    {
+        data.Get()[ i ] = (uint8_t)r.GetRand();
+    }
+    const uint64_t expected = xxHash::Calc64( data.Get(), dataSize );
+
+    // Hashing in pieces (of any size) gives the same result as all at once
+    const size_t chunkSizes[] = { 1, 31, 32, 4096, dataSize };
+    for ( const size_t chunkSize : chunkSizes )
+    {
+        xxHash64Stream stream;
+        for ( size_t pos = 0; pos < dataSize; pos += chunkSize )
+        {
+            const size_t len = ( ( dataSize - pos ) < chunkSize ) ? ( dataSize - pos ) : chunkSize;
+            stream.Update( data.Get() + pos, len );
+        }
+        TEST_ASSERT( stream.Digest() == expected );
+    }
+
+    // Including nothing at all
+    TEST_ASSERT( xxHash64Stream().Digest() == xxHash::Calc64( nullptr, 0 ) );
+}
+
 //------------------------------------------------------------------------------
@@ -0,0 +1,151 @@
+// TestProcess.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "TestFramework/UnitTest.h"
+
+#include "Core/Mem/Mem.h"
+#include "Core/Process/Process.h"
+#include "Core/Strings/AString.h"
+#include "Core/Time/Timer.h"
+#include "Core/Tracing/Tracing.h"
+
+// System
+#include <string.h>
+#if defined( __LINUX__ ) || defined( __APPLE__ )
+    #include <errno.h>
+    #include <sys/wait.h>
+    #include <unistd.h>
+#endif
+
+// TestProcess
+//------------------------------------------------------------------------------
+class TestProcess : public UnitTest
+{
+private:
+    DECLARE_TESTS
+
+    void CaptureOutput() const;
+    void SpawnFailure() const;
+    void SpawnFromLargeHeap() const;
+
+    // Helpers
+    static float SpawnWithProcess( const char * executable, uint32_t numSpawns );
+    #if defined( __LINUX__ ) || defined( __APPLE__ )
+        static float SpawnWithFork( const char * executable, uint32_t numSpawns );
+    #endif
+};
+
+// Register Tests
+//------------------------------------------------------------------------------
+REGISTER_TESTS_BEGIN( TestProcess )
+    #if defined( __LINUX__ )
+        REGISTER_TEST( CaptureOutput )
+        REGISTER_TEST( SpawnFailure )
+        REGISTER_TEST( SpawnFromLargeHeap )
+    #endif
+REGISTER_TESTS_END
+
+// CaptureOutput
+//------------------------------------------------------------------------------
+void TestProcess::CaptureOutput() const
+{
+    Process p;
+    TEST_ASSERT( p.Spawn( "/bin/sh", "-c \"echo out; echo err 1>&2; exit 3\"", nullptr, nullptr ) );
+
+    AString out;
+    AString err;
+    TEST_ASSERT( p.ReadAllData( out, err ) );
+    TEST_ASSERT( p.WaitForExit() == 3 );
+    TEST_ASSERT( out == "out\n" );
+    TEST_ASSERT( err == "err\n" );
+}
+
+// SpawnFailure
+//------------------------------------------------------------------------------
+void TestProcess::SpawnFailure() const
+{
+    // Failure to exec is reported by Spawn, with the reason
+    Process p;
+    errno = 0;
+    TEST_ASSERT( p.Spawn( "/does/not/exist", nullptr, nullptr, nullptr ) == false );
+    TEST_ASSERT( errno == ENOENT );
+
+    // As is a bad working dir
+    Process p2;
+    TEST_ASSERT( p2.Spawn( "/bin/true", nullptr, "/does/not/exist", nullptr ) == false );
+}
+
+// SpawnFromLargeHeap
+//------------------------------------------------------------------------------
+void TestProcess::SpawnFromLargeHeap() const
+{
+    // Spawning from a process with a lot of memory mapped (like a build
+    // with a large node graph) should not cost more than from a small one
+    #if defined( DEBUG )
+        const uint32_t numSpawns( 200 );
+    #else
+        const uint32_t numSpawns( 1000 );
+    #endif
+    const size_t heapSize( 512 * MEGABYTE );
+    const char * executable( "/bin/true" );
+
+    // Small heap
+    const float timeSmall = SpawnWithProcess( executable, numSpawns );
+
+    // Large heap (touched so it's really mapped)
+    void * heap = ALLOC( heapSize );
+    memset( heap, 1, heapSize );
+    const float timeLarge = SpawnWithProcess( executable, numSpawns );
+    const float timeLargeFork = SpawnWithFork( executable, numSpawns );
+    FREE( heap );
+
+    OUTPUT( "Spawn (small heap)        : %2.3fs - %u spawns @ %u spawns/sec\n", (double)timeSmall, numSpawns, (uint32_t)( (float)numSpawns / timeSmall ) );
+    OUTPUT( "Spawn (512 MiB heap)      : %2.3fs - %u spawns @ %u spawns/sec\n", (double)timeLarge, numSpawns, (uint32_t)( (float)numSpawns / timeLarge ) );
+    OUTPUT( "fork+exec (512 MiB heap)  : %2.3fs - %u spawns @ %u spawns/sec\n", (double)timeLargeFork, numSpawns, (uint32_t)( (float)numSpawns / timeLargeFork ) );
+}
+
+// SpawnWithProcess
+//------------------------------------------------------------------------------
+/*static*/ float TestProcess::SpawnWithProcess( const char * executable, uint32_t numSpawns )
+{
+    Timer t;
+    for ( uint32_t i = 0; i < numSpawns; ++i )
+    {
+        Process p;
+        TEST_ASSERT( p.Spawn( executable, nullptr, nullptr, nullptr ) );
+        AString out;
+        AString err;
+        TEST_ASSERT( p.ReadAllData( out, err ) );
+        TEST_ASSERT( p.WaitForExit() == 0 );
+    }
+    return t.GetElapsed();
+}
+
+// SpawnWithFork
+//------------------------------------------------------------------------------
+#if defined( __LINUX__ ) || defined( __APPLE__ )
+    /*static*/ float TestProcess::SpawnWithFork( const char * executable, uint32_t numSpawns )
+    {
+        // For comparison: what Process::Spawn used to do
+        Timer t;
+        for ( uint32_t i = 0; i < numSpawns; ++i )
+        {
+            const pid_t pid = fork();
+            TEST_ASSERT( pid != -1 );
+            if ( pid == 0 )
+            {
+                char * const argV[] = { const_cast< char * >( executable ), nullptr };
+                execv( executable, argV );
+                _exit( -1 );
+            }
+            int status = 0;
+            TEST_ASSERT( waitpid( pid, &status, 0 ) == pid );
+            TEST_ASSERT( WIFEXITED( status ) && ( WEXITSTATUS( status ) == 0 ) );
+        }
+        return t.GetElapsed();
+    }
+#endif
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,110 @@
+// TestThreadPool.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "TestFramework/UnitTest.h"
+
+// Core
+#include "Core/Containers/Array.h"
+#include "Core/Process/Atomic.h"
+#include "Core/Process/ThreadPool.h"
+
+// TestThreadPool
+//------------------------------------------------------------------------------
+class TestThreadPool : public UnitTest
+{
+private:
+    DECLARE_TESTS
+
+    void CreateDestroy() const;
+    void SingleThread() const;
+    void AllItemsProcessedOnce() const;
+    void Repeated() const;
+
+    // Internal helpers
+    static void CountItem( void * userData, uint32_t index );
+    static void RunAndCheck( ThreadPool & pool, uint32_t count );
+};
+
+// Register Tests
+//------------------------------------------------------------------------------
+REGISTER_TESTS_BEGIN( TestThreadPool )
+    REGISTER_TEST( CreateDestroy )
+    REGISTER_TEST( SingleThread )
+    REGISTER_TEST( AllItemsProcessedOnce )
+    REGISTER_TEST( Repeated )
+REGISTER_TESTS_END
+
+// CreateDestroy
+//------------------------------------------------------------------------------
+void TestThreadPool::CreateDestroy() const
+{
+    ThreadPool pool( 4 );
+    TEST_ASSERT( pool.GetNumThreads() == 4 );
+}
+
+// SingleThread
+//------------------------------------------------------------------------------
+void TestThreadPool::SingleThread() const
+{
+    // Only the calling thread does any work
+    ThreadPool pool( 1 );
+    RunAndCheck( pool, 0 );
+    RunAndCheck( pool, 1 );
+    RunAndCheck( pool, 1000 );
+}
+
+// AllItemsProcessedOnce
+//------------------------------------------------------------------------------
+void TestThreadPool::AllItemsProcessedOnce() const
+{
+    ThreadPool pool( 8 );
+
+    // Fewer items than threads, uneven batches and large counts
+    RunAndCheck( pool, 1 );
+    RunAndCheck( pool, 3 );
+    RunAndCheck( pool, 1001 );
+    RunAndCheck( pool, 100000 );
+}
+
+// Repeated
+//------------------------------------------------------------------------------
+void TestThreadPool::Repeated() const
+{
+    // Pool must be re-usable with no state leaking between calls
+    ThreadPool pool( 4 );
+    for ( uint32_t i = 0; i < 1000; ++i )
+    {
+        RunAndCheck( pool, ( i % 64 ) );
+    }
+}
+
+// CountItem
+//------------------------------------------------------------------------------
+/*static*/ void TestThreadPool::CountItem( void * userData, uint32_t index )
+{
+    Array< uint32_t > & counts = *static_cast< Array< uint32_t > * >( userData );
+    AtomicIncU32( &counts[ index ] );
+}
+
+// RunAndCheck
+//------------------------------------------------------------------------------
+/*static*/ void TestThreadPool::RunAndCheck( ThreadPool & pool, uint32_t count )
+{
+    Array< uint32_t > counts( count, false );
+    counts.SetSize( count );
+    for ( uint32_t & c : counts )
+    {
+        c = 0;
+    }
+
+    pool.ParallelFor( count, CountItem, &counts );
+
+    for ( const uint32_t c : counts )
+    {
+        TEST_ASSERT( c == 1 );
+    }
+}
+
+//------------------------------------------------------------------------------
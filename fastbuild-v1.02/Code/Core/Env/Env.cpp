@@ -36,6 +36,10 @@
     };
 #endif
 
+#if defined( __LINUX__ ) || defined( __APPLE__ )
+    extern char ** environ;
+#endif
+
 // GetNumProcessors
 //------------------------------------------------------------------------------
 /*static*/ uint32_t Env::GetNumProcessors()
@@ -168,6 +172,35 @@
     #endif
 }
 
+// GetEnvironment
+//------------------------------------------------------------------------------
+/*static*/ void Env::GetEnvironment( Array< AString > & outEnvironment )
+{
+    #if defined( __WINDOWS__ )
+        char * envStrings = ::GetEnvironmentStringsA();
+        if ( envStrings == nullptr )
+        {
+            return;
+        }
+        for ( const char * pos = envStrings; *pos; pos += ( AString::StrLen( pos ) + 1 ) )
+        {
+            // Skip the per-drive current directory entries (e.g. "=C:=C:\")
+            if ( *pos != '=' )
+            {
+                outEnvironment.EmplaceBack( pos );
+            }
+        }
+        ::FreeEnvironmentStringsA( envStrings );
+    #elif defined( __LINUX__ ) || defined( __APPLE__ )
+        for ( char ** env = environ; env && *env; ++env )
+        {
+            outEnvironment.EmplaceBack( *env );
+        }
+    #else
+        #error Unknown platform
+    #endif
+}
+
 // GetCmdLine
 //------------------------------------------------------------------------------
 /*static*/ void Env::GetCmdLine( AString & cmdLine )
@@ -9,6 +9,7 @@
 // Core
 #include "Core/Env/ErrorFormat.h"
 #include "Core/FileIO/PathUtils.h"
+#include "Core/Mem/Mem.h"
 #include "Core/Process/Thread.h"
 #include "Core/Profile/Profile.h"
 #include "Core/Strings/AStackString.h"
@@ -30,11 +31,15 @@
 #endif
 #if defined( __LINUX__ )
     #include <fcntl.h>
+    #include <linux/fs.h>
+    #include <sys/ioctl.h>
     #include <sys/sendfile.h>
+    #include <sys/syscall.h>
 #endif
 #if defined( __APPLE__ )
     #include <copyfile.h>
     #include <dlfcn.h>
+    #include <fcntl.h>
     #include <sys/time.h>
 #endif
 
@@ -252,17 +257,145 @@
         return false;
     }
 
-    ssize_t bytesCopied = sendfile( dest, source, 0, stat_source.st_size );
+    const bool result = SendFile( source, dest, (uint64_t)stat_source.st_size );
 
     close( source );
     close( dest );
 
-    return ( bytesCopied == stat_source.st_size );
+    return result;
 #else
     #error Unknown platform
 #endif
 }
 
+// FileCopyFast
+//------------------------------------------------------------------------------
+/*static*/ bool FileIO::FileCopyFast( const char * srcFileName,
+                                      const char * dstFileName,
+                                      bool allowHardLink,
+                                      CopyMethod & outMethod )
+{
+    // A previous copy may be a hard link, which must not be written through
+    FileDelete( dstFileName );
+
+#if defined( __LINUX__ )
+    struct stat stat_source;
+    if ( ( lstat( srcFileName, &stat_source ) != 0 ) || S_ISLNK( stat_source.st_mode ) )
+    {
+        // Missing files fail, symlinks are re-created
+        outMethod = COPY_METHOD_BYTES;
+        return FileCopy( srcFileName, dstFileName );
+    }
+
+    int source = open( srcFileName, O_RDONLY, 0 );
+    if ( source < 0 )
+    {
+        return false;
+    }
+    int dest = open( dstFileName, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+    if ( dest < 0 )
+    {
+        close( source );
+        return false;
+    }
+
+    // Reflinks are free on filesystems which support them (btrfs, xfs etc.)
+    #if defined( FICLONE )
+        if ( ioctl( dest, FICLONE, source ) == 0 )
+        {
+            close( source );
+            const bool result = ( fchmod( dest, stat_source.st_mode ) == 0 );
+            close( dest );
+            outMethod = COPY_METHOD_REFLINK;
+            return result;
+        }
+    #endif
+
+    // Hard links are free too, but share all later changes
+    if ( allowHardLink )
+    {
+        close( dest );
+        FileDelete( dstFileName );
+        if ( link( srcFileName, dstFileName ) == 0 )
+        {
+            close( source );
+            outMethod = COPY_METHOD_HARDLINK;
+            return true;
+        }
+        dest = open( dstFileName, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+        if ( dest < 0 )
+        {
+            close( source );
+            return false;
+        }
+    }
+
+    // set permissions to match the source file's (see FileCopy)
+    if ( fchmod( dest, stat_source.st_mode ) < 0 )
+    {
+        close( source );
+        close( dest );
+        return false;
+    }
+
+    // Copy in the kernel, which may also be offloaded (e.g. on NFS)
+    const uint64_t size = (uint64_t)stat_source.st_size;
+    uint64_t copied = 0;
+    #if defined( SYS_copy_file_range )
+        while ( copied < size )
+        {
+            const ssize_t result = (ssize_t)syscall( SYS_copy_file_range, source, nullptr, dest, nullptr, (size_t)( size - copied ), 0 );
+            if ( result <= 0 )
+            {
+                break; // Unsupported (e.g. across filesystems on older kernels) or failed
+            }
+            copied += (uint64_t)result;
+        }
+        if ( copied == size )
+        {
+            close( source );
+            close( dest );
+            outMethod = COPY_METHOD_KERNEL;
+            return true;
+        }
+    #endif
+
+    // Copy what's left
+    const bool result = SendFile( source, dest, ( size - copied ) );
+    close( source );
+    close( dest );
+    outMethod = COPY_METHOD_BYTES;
+    return result;
+#else
+    if ( allowHardLink && FileHardLink( AStackString<>( srcFileName ), AStackString<>( dstFileName ) ) )
+    {
+        outMethod = COPY_METHOD_HARDLINK;
+        return true;
+    }
+    outMethod = COPY_METHOD_BYTES;
+    return FileCopy( srcFileName, dstFileName );
+#endif
+}
+
+// SendFile
+//------------------------------------------------------------------------------
+#if defined( __LINUX__ )
+    /*static*/ bool FileIO::SendFile( int source, int dest, uint64_t size )
+    {
+        // sendfile copies at most ~2GiB per call
+        while ( size > 0 )
+        {
+            const ssize_t bytesCopied = sendfile( dest, source, nullptr, (size_t)size );
+            if ( bytesCopied <= 0 )
+            {
+                return false;
+            }
+            size -= (uint64_t)bytesCopied;
+        }
+        return true;
+    }
+#endif
+
 // FileMove
 //------------------------------------------------------------------------------
 /*static*/ bool FileIO::FileMove( const AString & srcFileName, const AString & dstFileName )
@@ -276,6 +409,101 @@
 #endif
 }
 
+// FileHardLink
+//------------------------------------------------------------------------------
+/*static*/ bool FileIO::FileHardLink( const AString & srcFileName, const AString & dstFileName )
+{
+#if defined( __WINDOWS__ )
+    return ( TRUE == ::CreateHardLink( dstFileName.Get(), srcFileName.Get(), nullptr ) );
+#elif defined( __LINUX__ ) || defined( __APPLE__ )
+    return ( link( srcFileName.Get(), dstFileName.Get() ) == 0 );
+#else
+    #error Unknown platform
+#endif
+}
+
+// FilePrefetch
+//------------------------------------------------------------------------------
+/*static*/ bool FileIO::FilePrefetch( const char * fileName, uint64_t & outSize )
+{
+    PROFILE_FUNCTION
+
+    outSize = 0;
+#if defined( __WINDOWS__ )
+    // Map the file and ask for it to be read ahead. Like the other platforms,
+    // this costs nothing if it's already cached. PrefetchVirtualMemory is only
+    // available on Windows 8 and later.
+    typedef struct
+    {
+        PVOID   VirtualAddress;
+        SIZE_T  NumberOfBytes;
+    } MemoryRangeEntry; // WIN32_MEMORY_RANGE_ENTRY
+    typedef BOOL ( WINAPI * PrefetchVirtualMemoryFunc )( HANDLE, ULONG_PTR, MemoryRangeEntry *, ULONG );
+    static const PrefetchVirtualMemoryFunc prefetchVirtualMemory = reinterpret_cast< PrefetchVirtualMemoryFunc >( reinterpret_cast< void * >( ::GetProcAddress( ::GetModuleHandleA( "kernel32.dll" ), "PrefetchVirtualMemory" ) ) );
+    if ( prefetchVirtualMemory == nullptr )
+    {
+        return false;
+    }
+
+    const HANDLE hFile = CreateFileA( fileName, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+    if ( hFile == INVALID_HANDLE_VALUE )
+    {
+        return false;
+    }
+    bool ok = false;
+    LARGE_INTEGER size;
+    if ( GetFileSizeEx( hFile, &size ) && ( size.QuadPart > 0 ) )
+    {
+        const HANDLE hMapping = CreateFileMappingA( hFile, nullptr, PAGE_READONLY, 0, 0, nullptr );
+        if ( hMapping )
+        {
+            void * view = MapViewOfFile( hMapping, FILE_MAP_READ, 0, 0, 0 );
+            if ( view )
+            {
+                // The pages stay in the file cache once the view is unmapped
+                MemoryRangeEntry range = { view, (SIZE_T)size.QuadPart };
+                ok = ( prefetchVirtualMemory( GetCurrentProcess(), 1, &range, 0 ) != FALSE );
+                UnmapViewOfFile( view );
+            }
+            CloseHandle( hMapping );
+        }
+    }
+    CloseHandle( hFile );
+    if ( ok )
+    {
+        outSize = (uint64_t)size.QuadPart;
+    }
+    return ok;
+#elif defined( __LINUX__ ) || defined( __APPLE__ )
+    // Ask the kernel to read the file ahead asynchronously. This costs nothing
+    // if it's already cached.
+    const int fd = open( fileName, O_RDONLY );
+    if ( fd == -1 )
+    {
+        return false;
+    }
+    struct stat st;
+    if ( fstat( fd, &st ) != 0 )
+    {
+        close( fd );
+        return false;
+    }
+    #if defined( __LINUX__ )
+        const bool ok = ( posix_fadvise( fd, 0, 0, POSIX_FADV_WILLNEED ) == 0 );
+    #else
+        struct radvisory advice;
+        advice.ra_offset = 0;
+        advice.ra_count = ( st.st_size > INT_MAX ) ? INT_MAX : (int)st.st_size;
+        const bool ok = ( fcntl( fd, F_RDADVISE, &advice ) != -1 );
+    #endif
+    close( fd );
+    outSize = (uint64_t)st.st_size;
+    return ok;
+#else
+    #error Unknown platform
+#endif
+}
+
 // GetFiles
 //------------------------------------------------------------------------------
 /*static*/ bool FileIO::GetFiles( const AString & path,
@@ -17,10 +17,24 @@
 class FileIO
 {
 public:
+    // How FileCopyFast copied a file, cheapest first
+    enum CopyMethod : uint8_t
+    {
+        COPY_METHOD_REFLINK,    // (Linux) Copy-on-write clone sharing the source's extents
+        COPY_METHOD_HARDLINK,   // Link to the source (only if allowed)
+        COPY_METHOD_KERNEL,     // (Linux) In-kernel copy (copy_file_range)
+        COPY_METHOD_BYTES,      // Regular copy
+
+        NUM_COPY_METHODS
+    };
+
     static bool FileExists( const char * fileName );
     static bool FileDelete( const char * fileName );
     static bool FileCopy( const char * srcFileName, const char * dstFileName, bool allowOverwrite = true );
+    static bool FileCopyFast( const char * srcFileName, const char * dstFileName, bool allowHardLink, CopyMethod & outMethod );
     static bool FileMove( const AString & srcFileName, const AString & dstFileName );
+    static bool FileHardLink( const AString & srcFileName, const AString & dstFileName );
+    static bool FilePrefetch( const char * fileName, uint64_t & outSize ); // bring into the OS file cache
     static bool DirectoryDelete( const AString & path );
 
     // directory listing
@@ -82,6 +96,9 @@ private:
     #if defined( __WINDOWS__ )
         static bool IsWindowsLongPathSupportEnabledInternal();
     #endif
+    #if defined( __LINUX__ )
+        static bool SendFile( int source, int dest, uint64_t size );
+    #endif
 
     static void GetFilesRecurse( AString & path,
                                  const AString & wildCard,
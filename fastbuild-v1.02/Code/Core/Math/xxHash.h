@@ -12,6 +12,13 @@ extern "C"
 {
     unsigned int XXH32( const void * input, size_t length, unsigned seed );
     unsigned long long XXH64( const void * input, size_t length, unsigned long long seed );
+
+    struct XXH64_state_s;
+    XXH64_state_s * XXH64_createState( void );
+    int XXH64_freeState( XXH64_state_s * statePtr );
+    int XXH64_reset( XXH64_state_s * statePtr, unsigned long long seed );
+    int XXH64_update( XXH64_state_s * statePtr, const void * input, size_t length );
+    unsigned long long XXH64_digest( const XXH64_state_s * statePtr );
 };
 
 // xxHash
@@ -25,9 +32,29 @@ public:
     inline static uint32_t  Calc32( const AString & string ) { return Calc32( string.Get(), string.GetLength() ); }
     inline static uint64_t  Calc64( const AString & string ) { return Calc64( string.Get(), string.GetLength() ); }
 private:
+    friend class xxHash64Stream;
     enum { XXHASH_SEED = 0x0 }; // arbitrarily chosen random seed
 };
 
+// xxHash64Stream
+//------------------------------------------------------------------------------
+// Incremental version of xxHash::Calc64 (the result is the same), for data
+// which is not all in memory at once
+class xxHash64Stream
+{
+public:
+    inline xxHash64Stream();
+    inline ~xxHash64Stream();
+
+    inline void     Update( const void * buffer, size_t len );
+    inline uint64_t Digest() const;
+private:
+    xxHash64Stream( const xxHash64Stream & ) = delete;
+    xxHash64Stream & operator = ( const xxHash64Stream & ) = delete;
+
+    XXH64_state_s * m_State;
+};
+
 // Calc32
 //------------------------------------------------------------------------------
 /*static*/ uint32_t xxHash::Calc32( const void * buffer, size_t len )
@@ -42,4 +69,33 @@ private:
     return XXH64( buffer, len, XXHASH_SEED );
 }
 
+// CONSTRUCTOR (xxHash64Stream)
+//------------------------------------------------------------------------------
+xxHash64Stream::xxHash64Stream()
+    : m_State( XXH64_createState() )
+{
+    XXH64_reset( m_State, xxHash::XXHASH_SEED );
+}
+
+// DESTRUCTOR (xxHash64Stream)
+//------------------------------------------------------------------------------
+xxHash64Stream::~xxHash64Stream()
+{
+    XXH64_freeState( m_State );
+}
+
+// Update (xxHash64Stream)
+//------------------------------------------------------------------------------
+void xxHash64Stream::Update( const void * buffer, size_t len )
+{
+    XXH64_update( m_State, buffer, len );
+}
+
+// Digest (xxHash64Stream)
+//------------------------------------------------------------------------------
+uint64_t xxHash64Stream::Digest() const
+{
+    return XXH64_digest( m_State );
+}
+
 //------------------------------------------------------------------------------
@@ -28,14 +28,126 @@
 #if defined( __LINUX__ ) || defined( __APPLE__ )
     #include <errno.h>
     #include <fcntl.h>
+    #include <poll.h>
     #include <signal.h>
     #include <stdio.h>
     #include <stdlib.h>
     #include <string.h>
+    #include <sys/ioctl.h>
+    #include <sys/resource.h>
     #include <sys/wait.h>
     #include <unistd.h>
     #include <wordexp.h>
 #endif
+#if defined( __LINUX__ )
+    #include <sched.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+#endif
+
+// Defines
+//------------------------------------------------------------------------------
+#if defined( __LINUX__ )
+    #define PROCESS_SPAWN_STACK_SIZE ( 64 * KILOBYTE )  // Stack for the child until it calls exec
+    #define PROCESS_ABORT_CHECK_INTERVAL_MS ( 10 )      // How often to check abort flags while waiting for output
+    #define PROCESS_MEMORY_SAMPLE_INTERVAL_MS ( 10 )    // How often to sample the peak memory of a running child
+#endif
+
+#if defined( __LINUX__ ) || defined( __APPLE__ )
+namespace
+{
+    // Everything the child needs between being created and calling exec
+    struct SpawnChildArgs
+    {
+        const char *    m_Executable;
+        char * const *  m_ArgV;
+        char * const *  m_EnvV;             // nullptr to inherit our environment
+        const char *    m_WorkingDir;
+        const char *    m_CGroupProcsFile;
+        int             m_StdOutWrite;
+        int             m_StdErrWrite;
+        sigset_t        m_SignalMask;       // restored before exec
+        volatile int    m_Error;            // why exec could not happen (0 if it did)
+    };
+
+    // SpawnChild
+    //--------------------------------------------------------------------------
+    // On Linux, this runs in the parent's address space (CLONE_VM) so it must
+    // only make async-signal-safe calls and must not touch any other memory.
+    int SpawnChild( void * param )
+    {
+        SpawnChildArgs * args = static_cast< SpawnChildArgs * >( param );
+
+        // Handlers installed by the parent would run in the parent's memory
+        for ( int sig = 1; sig < NSIG; ++sig )
+        {
+            struct sigaction sa;
+            if ( ( sigaction( sig, nullptr, &sa ) == 0 ) &&
+                 ( sa.sa_handler != SIG_DFL ) &&
+                 ( sa.sa_handler != SIG_IGN ) )
+            {
+                sa.sa_handler = SIG_DFL;
+                sa.sa_flags = 0;
+                sigemptyset( &sa.sa_mask );
+                sigaction( sig, &sa, nullptr );
+            }
+        }
+
+        // Put child process into its own process group.
+        // This will allow as to send signals to the whole group which we use to implement KillProcessTree.
+        // The new process group will have ID equal to the PID of the child process.
+        if ( setpgid( 0, 0 ) != 0 )
+        {
+            args->m_Error = errno;
+            _exit( -1 );
+        }
+
+        #if defined( __LINUX__ )
+            // Join the cgroup before exec so all memory and CPU use is
+            // accounted to it.
+            if ( args->m_CGroupProcsFile )
+            {
+                const int cgroupFD = open( args->m_CGroupProcsFile, O_WRONLY | O_CLOEXEC );
+                if ( ( cgroupFD == -1 ) || ( write( cgroupFD, "0", 1 ) != 1 ) )
+                {
+                    args->m_Error = errno;
+                    _exit( -1 ); // Don't run outside the requested limits
+                }
+                close( cgroupFD );
+            }
+        #endif
+
+        // Pipes are close-on-exec, so only these copies survive
+        if ( ( dup2( args->m_StdOutWrite, STDOUT_FILENO ) == -1 ) ||
+             ( dup2( args->m_StdErrWrite, STDERR_FILENO ) == -1 ) )
+        {
+            args->m_Error = errno;
+            _exit( -1 );
+        }
+
+        if ( args->m_WorkingDir && ( chdir( args->m_WorkingDir ) != 0 ) )
+        {
+            args->m_Error = errno;
+            _exit( -1 );
+        }
+
+        sigprocmask( SIG_SETMASK, &args->m_SignalMask, nullptr );
+
+        // transfer execution to new executable
+        if ( args->m_EnvV )
+        {
+            execve( args->m_Executable, args->m_ArgV, args->m_EnvV );
+        }
+        else
+        {
+            execv( args->m_Executable, args->m_ArgV );
+        }
+
+        args->m_Error = errno; // only get here if exec fails
+        _exit( -1 );
+    }
+}
+#endif
 
 // Static Data
 //------------------------------------------------------------------------------
@@ -56,6 +168,12 @@ Process::Process( const volatile bool * mainAbortFlag,
     , m_ChildPID( -1 )
     , m_HasAlreadyWaitTerminated( false )
 #endif
+#if defined( __LINUX__ )
+    , m_CGroupProcsFile( nullptr )
+    , m_PidFD( -1 )
+#endif
+    , m_PeakMemoryBytes( 0 )
+    , m_CPUTimeUS( 0 )
     , m_HasAborted( false )
     , m_MainAbortFlag( mainAbortFlag )
     , m_AbortFlag( abortFlag )
@@ -291,10 +409,20 @@ bool Process::Spawn( const char * executable,
         (void)shareHandles; // unsupported
 
         // create StdOut and StdErr pipes to capture output of spawned process
+        // (close-on-exec so they don't leak into other processes we're spawning concurrently)
         int stdOutPipeFDs[ 2 ];
         int stdErrPipeFDs[ 2 ];
-        VERIFY( pipe( stdOutPipeFDs ) == 0 );
-        VERIFY( pipe( stdErrPipeFDs ) == 0 );
+        #if defined( __LINUX__ )
+            VERIFY( pipe2( stdOutPipeFDs, O_CLOEXEC ) == 0 );
+            VERIFY( pipe2( stdErrPipeFDs, O_CLOEXEC ) == 0 );
+        #else
+            VERIFY( pipe( stdOutPipeFDs ) == 0 );
+            VERIFY( pipe( stdErrPipeFDs ) == 0 );
+            VERIFY( fcntl( stdOutPipeFDs[ 0 ], F_SETFD, FD_CLOEXEC ) == 0 );
+            VERIFY( fcntl( stdOutPipeFDs[ 1 ], F_SETFD, FD_CLOEXEC ) == 0 );
+            VERIFY( fcntl( stdErrPipeFDs[ 0 ], F_SETFD, FD_CLOEXEC ) == 0 );
+            VERIFY( fcntl( stdErrPipeFDs[ 1 ], F_SETFD, FD_CLOEXEC ) == 0 );
+        #endif
 
         // Increase buffer sizes to reduce stalls
         #if defined( __LINUX__ )
@@ -366,71 +494,104 @@ bool Process::Spawn( const char * executable,
         }
         envVector.Append( nullptr ); // env must be terminated with a nullptr
 
-        // fork the process
-        const pid_t childProcessPid = fork();
+        SpawnChildArgs childArgs;
+        childArgs.m_Executable = executable;
+        childArgs.m_ArgV = (char * const *)argVector.Begin();
+        childArgs.m_EnvV = environment ? (char * const *)envVector.Begin() : nullptr;
+        childArgs.m_WorkingDir = workingDir;
+        #if defined( __LINUX__ )
+            childArgs.m_CGroupProcsFile = m_CGroupProcsFile;
+        #else
+            childArgs.m_CGroupProcsFile = nullptr;
+        #endif
+        childArgs.m_StdOutWrite = stdOutPipeFDs[ 1 ];
+        childArgs.m_StdErrWrite = stdErrPipeFDs[ 1 ];
+        childArgs.m_Error = 0;
+
+        #if defined( __LINUX__ )
+            // Create the child with clone( CLONE_VM | CLONE_VFORK ) instead of fork().
+            // The child borrows our address space until it calls exec, so no page tables
+            // are copied no matter how large our heap is, and we are suspended until the
+            // exec has either happened or failed (which we can then report).
+            pid_t childProcessPid = -1;
+            int spawnError = 0;
+            void * childStack = mmap( nullptr, PROCESS_SPAWN_STACK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0 );
+            if ( childStack != MAP_FAILED )
+            {
+                // No signal handlers can run in the child until it has reset them
+                sigset_t allSignals;
+                sigfillset( &allSignals );
+                pthread_sigmask( SIG_BLOCK, &allSignals, &childArgs.m_SignalMask );
+
+                childProcessPid = clone( SpawnChild,
+                                         static_cast< char * >( childStack ) + PROCESS_SPAWN_STACK_SIZE, // stack grows down
+                                         CLONE_VM | CLONE_VFORK | SIGCHLD,
+                                         &childArgs );
+                spawnError = errno;
+
+                pthread_sigmask( SIG_SETMASK, &childArgs.m_SignalMask, nullptr );
+                VERIFY( munmap( childStack, PROCESS_SPAWN_STACK_SIZE ) == 0 );
+            }
+            else
+            {
+                spawnError = errno;
+            }
+        #else
+            sigprocmask( SIG_SETMASK, nullptr, &childArgs.m_SignalMask );
+
+            // fork the process
+            const pid_t childProcessPid = fork();
+            const int spawnError = errno;
+            if ( childProcessPid == 0 )
+            {
+                SpawnChild( &childArgs ); // does not return
+            }
+        #endif
+
+        // close write pipes (we never write anything)
+        VERIFY( close( stdOutPipeFDs[ 1 ] ) == 0 );
+        VERIFY( close( stdErrPipeFDs[ 1 ] ) == 0 );
+
         if ( childProcessPid == -1 )
         {
             // cleanup pipes
             VERIFY( close( stdOutPipeFDs[ 0 ] ) == 0 );
-            VERIFY( close( stdOutPipeFDs[ 1 ] ) == 0 );
             VERIFY( close( stdErrPipeFDs[ 0 ] ) == 0 );
-            VERIFY( close( stdErrPipeFDs[ 1 ] ) == 0 );
 
             ASSERT( false ); // fork failed - should not happen in normal operation
+            errno = spawnError;
             return false;
         }
 
-        const bool isChild = ( childProcessPid == 0 );
-        if ( isChild )
+        // did the child fail before or during exec?
+        if ( childArgs.m_Error != 0 )
         {
-            // Put child process into its own process group.
-            // This will allow as to send signals to the whole group which we use to implement KillProcessTree.
-            // The new process group will have ID equal to the PID of the child process.
-            VERIFY( setpgid( 0, 0 ) == 0 );
-
-            VERIFY( dup2( stdOutPipeFDs[ 1 ], STDOUT_FILENO ) != -1 );
-            VERIFY( dup2( stdErrPipeFDs[ 1 ], STDERR_FILENO ) != -1 );
+            // reap it and report why
+            int status;
+            while ( ( waitpid( childProcessPid, &status, 0 ) == -1 ) && ( errno == EINTR ) ) {}
 
             VERIFY( close( stdOutPipeFDs[ 0 ] ) == 0 );
-            VERIFY( close( stdOutPipeFDs[ 1 ] ) == 0 );
             VERIFY( close( stdErrPipeFDs[ 0 ] ) == 0 );
-            VERIFY( close( stdErrPipeFDs[ 1 ] ) == 0 );
 
-            if ( workingDir )
-            {
-                VERIFY( chdir( workingDir ) == 0 );
-            }
-
-            // transfer execution to new executable
-            char * const * argV = (char * const *)argVector.Begin();
-            if ( environment )
-            {
-                char * const * envV = (char * const *)envVector.Begin();
-                execve( executable, argV, envV );
-            }
-            else
-            {
-                execv( executable, argV );
-            }
-
-            exit( -1 ); // only get here if execv fails
+            errno = childArgs.m_Error;
+            return false;
         }
-        else
-        {
-            // close write pipes (we never write anything)
-            VERIFY( close( stdOutPipeFDs[ 1 ] ) == 0 );
-            VERIFY( close( stdErrPipeFDs[ 1 ] ) == 0 );
 
-            // keep pipes for reading child process
-            m_StdOutRead = stdOutPipeFDs[ 0 ];
-            m_StdErrRead = stdErrPipeFDs[ 0 ];
-            m_ChildPID = (int)childProcessPid;
+        // keep pipes for reading child process
+        m_StdOutRead = stdOutPipeFDs[ 0 ];
+        m_StdErrRead = stdErrPipeFDs[ 0 ];
+        m_ChildPID = (int)childProcessPid;
 
-            // TODO: How can we tell if child spawn failed?
-            m_Started = true;
-            m_HasAlreadyWaitTerminated = false;
-            return true;
-        }
+        #if defined( __LINUX__ )
+            // A pidfd lets us wait for exit alongside output (Linux 5.3+)
+            #if defined( SYS_pidfd_open )
+                m_PidFD = (int)syscall( SYS_pidfd_open, childProcessPid, 0 );
+            #endif
+        #endif
+
+        m_Started = true;
+        m_HasAlreadyWaitTerminated = false;
+        return true;
     #else
         #error Unknown platform
     #endif
@@ -462,7 +623,8 @@ bool Process::IsRunning() const
 
         // non-blocking "wait"
         int status( -1 );
-        pid_t result = waitpid( m_ChildPID, &status, WNOHANG );
+        struct rusage usage;
+        pid_t result = wait4( m_ChildPID, &status, WNOHANG, &usage );
         ASSERT ( result != -1 ); // usage error
         if ( result == 0 )
         {
@@ -471,6 +633,7 @@ bool Process::IsRunning() const
 
         // store wait result: can't call again if we just cleaned up process
         ASSERT( result == m_ChildPID );
+        StoreResourceUsage( usage );
         if ( WIFEXITED( status ) )
         {
             m_ReturnStatus = WEXITSTATUS( status ); // process terminated normally, use exit code
@@ -517,6 +680,15 @@ int32_t Process::WaitForExit()
 
             // get the result code
             VERIFY( GetExitCodeProcess( GetProcessInfo().hProcess, (LPDWORD)&exitCode ) );
+
+            // get the cpu time (FILETIMEs are in 100ns units)
+            FILETIME creationTime, exitTime, kernelTime, userTime;
+            if ( GetProcessTimes( GetProcessInfo().hProcess, &creationTime, &exitTime, &kernelTime, &userTime ) )
+            {
+                const uint64_t kernel = ( (uint64_t)kernelTime.dwHighDateTime << 32 ) | kernelTime.dwLowDateTime;
+                const uint64_t user = ( (uint64_t)userTime.dwHighDateTime << 32 ) | userTime.dwLowDateTime;
+                m_CPUTimeUS = ( kernel + user ) / 10;
+            }
         }
 
         // cleanup
@@ -530,12 +702,20 @@ int32_t Process::WaitForExit()
     #elif defined( __LINUX__ ) || defined( __APPLE__ )
         VERIFY( close( m_StdOutRead ) == 0 );
         VERIFY( close( m_StdErrRead ) == 0 );
+        #if defined( __LINUX__ )
+            if ( m_PidFD != -1 )
+            {
+                VERIFY( close( m_PidFD ) == 0 );
+                m_PidFD = -1;
+            }
+        #endif
         if ( m_HasAlreadyWaitTerminated == false )
         {
             int status;
+            struct rusage usage;
             for( ;; )
             {
-                pid_t ret = waitpid( m_ChildPID, &status, 0 );
+                pid_t ret = wait4( m_ChildPID, &status, 0, &usage );
                 if ( ret == -1 )
                 {
                     if ( errno == EINTR )
@@ -545,6 +725,7 @@ int32_t Process::WaitForExit()
                     ASSERT( false ); // Usage error
                 }
                 ASSERT( ret == m_ChildPID );
+                StoreResourceUsage( usage );
                 if ( WIFEXITED( status ) )
                 {
                     m_ReturnStatus = WEXITSTATUS( status ); // process terminated normally, use exit code
@@ -600,7 +781,18 @@ bool Process::ReadAllData( AString & outMem,
                            AString & errMem,
                            uint32_t timeOutMS )
 {
+    #if defined( __LINUX__ )
+        // Wait for output and exit together if we can
+        if ( m_PidFD != -1 )
+        {
+            return ReadAllDataEvents( outMem, errMem, timeOutMS );
+        }
+    #endif
+
     Timer t;
+    #if defined( __LINUX__ )
+        Timer sampleTimer;
+    #endif
 
 
     //#if defined( __LINUX__ )
@@ -690,8 +882,16 @@ bool Process::ReadAllData( AString & outMem,
                     sleepIntervalMS = Math::Min<uint32_t>( sleepIntervalMS * 2, 8 );
                 #endif
                 */
+                #if defined( __LINUX__ )
+                    if ( sampleTimer.GetElapsedMS() >= PROCESS_MEMORY_SAMPLE_INTERVAL_MS )
+                    {
+                        SamplePeakMemory();
+                        sampleTimer.Start();
+                    }
+                #endif
+
                 // TODO:C Investigate waiting on an event when process terminates
-                // to reduce overall process spawn time
+                // to reduce overall process spawn time (done on Linux 5.3+, see ReadAllDataEvents)
                 Thread::Sleep( sleepIntervalMS );
 
                 // Increase sleep interval upto limit
@@ -756,45 +956,176 @@ bool Process::ReadAllData( AString & outMem,
 // Read
 //------------------------------------------------------------------------------
 #if defined( __LINUX__ ) || defined( __APPLE__ )
-    void Process::Read( int handle, AString & buffer )
+    bool Process::Read( int handle, AString & buffer )
     {
         // any data available?
-        timeval timeout;
-        timeout.tv_sec = 0;
-        timeout.tv_usec = 0;
-        fd_set fdSet;
-        FD_ZERO( &fdSet );
-        FD_SET( handle, &fdSet );
-        int ret = select( handle+1, &fdSet, nullptr, nullptr, &timeout );
+        struct pollfd pfd;
+        pfd.fd = handle;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        const int ret = poll( &pfd, 1, 0 );
         if ( ret == -1 )
         {
-            ASSERT( false ); // usage error?
-            return;
+            ASSERT( errno == EINTR ); // usage error?
+            return true;
         }
         if ( ret == 0 )
         {
-            return; // no data available
+            return true; // no data available
+        }
+
+        // readable with nothing to read means the other end was closed
+        int bytesAvail = 0;
+        if ( ( ioctl( handle, FIONREAD, &bytesAvail ) == 0 ) && ( bytesAvail == 0 ) )
+        {
+            return false; // closed
         }
 
         // how much space do we have left for reading into?
-        const uint32_t spaceInBuffer = ( buffer.GetReserved() - buffer.GetLength() );
+        uint32_t spaceInBuffer = ( buffer.GetReserved() - buffer.GetLength() );
         if ( spaceInBuffer == 0 )
         {
             // Expand buffer for new data in large chunks
             const uint32_t newBufferSize = ( buffer.GetReserved() + ( 16 * MEGABYTE ) );
             buffer.SetReserved( newBufferSize );
+            spaceInBuffer = ( buffer.GetReserved() - buffer.GetLength() );
         }
 
         // read the new data
         ssize_t result = read( handle, buffer.Get() + buffer.GetLength(), spaceInBuffer );
         if ( result == -1 )
         {
-            ASSERT( false ); // error!
-            result = 0; // no bytes read
+            ASSERT( errno == EINTR ); // error!
+            return true; // no bytes read
         }
-        
+        if ( result == 0 )
+        {
+            return false; // closed
+        }
+
         // Update length
         buffer.SetLength( buffer.GetLength() + (uint32_t)result );
+        return true;
+    }
+#endif
+
+// ReadAllDataEvents
+//------------------------------------------------------------------------------
+#if defined( __LINUX__ )
+    bool Process::ReadAllDataEvents( AString & outMem, AString & errMem, uint32_t timeOutMS )
+    {
+        Timer t;
+        Timer sampleTimer;
+
+        // Sleep until there is output, the process exits, or it's time to check
+        // the abort flags (which can't be waited on)
+        struct pollfd fds[ 3 ];
+        fds[ 0 ].fd = m_StdOutRead;
+        fds[ 1 ].fd = m_StdErrRead;
+        fds[ 2 ].fd = m_PidFD;
+        for ( struct pollfd & pfd : fds )
+        {
+            pfd.events = POLLIN;
+        }
+
+        for ( ;; )
+        {
+            const bool mainAbort = ( m_MainAbortFlag && AtomicLoadRelaxed( m_MainAbortFlag ) );
+            const bool abort = ( m_AbortFlag && AtomicLoadRelaxed( m_AbortFlag ) );
+            if ( abort || mainAbort )
+            {
+                PROFILE_SECTION( "Abort" )
+                KillProcessTree();
+                m_HasAborted = true;
+                return true;
+            }
+
+            uint32_t waitMS = PROCESS_ABORT_CHECK_INTERVAL_MS;
+            if ( timeOutMS > 0 )
+            {
+                const uint32_t elapsedMS = (uint32_t)t.GetElapsedMS();
+                if ( elapsedMS >= timeOutMS )
+                {
+                    Terminate();
+                    return false; // Timed out
+                }
+                waitMS = Math::Min( waitMS, timeOutMS - elapsedMS );
+            }
+
+            for ( struct pollfd & pfd : fds )
+            {
+                pfd.revents = 0;
+            }
+            const int ret = poll( fds, 3, (int)waitMS );
+            if ( ret == -1 )
+            {
+                ASSERT( errno == EINTR ); // usage error?
+                continue;
+            }
+
+            // Read output, ignoring pipes once closed
+            if ( fds[ 0 ].revents && ( Read( m_StdOutRead, outMem ) == false ) )
+            {
+                fds[ 0 ].fd = -1;
+            }
+            if ( fds[ 1 ].revents && ( Read( m_StdErrRead, errMem ) == false ) )
+            {
+                fds[ 1 ].fd = -1;
+            }
+
+            if ( fds[ 2 ].revents )
+            {
+                // Exited - get remaining output. Don't wait for the pipes to close
+                // as they can be held open by processes the child left running.
+                bool gotData = true;
+                while ( gotData )
+                {
+                    const uint32_t prevOutSize = outMem.GetLength();
+                    const uint32_t prevErrSize = errMem.GetLength();
+                    Read( m_StdOutRead, outMem );
+                    Read( m_StdErrRead, errMem );
+                    gotData = ( prevOutSize != outMem.GetLength() ) || ( prevErrSize != errMem.GetLength() );
+                }
+                return true;
+            }
+
+            if ( sampleTimer.GetElapsedMS() >= PROCESS_MEMORY_SAMPLE_INTERVAL_MS )
+            {
+                SamplePeakMemory();
+                sampleTimer.Start();
+            }
+        }
+    }
+#endif
+
+// SamplePeakMemory
+//------------------------------------------------------------------------------
+#if defined( __LINUX__ )
+    void Process::SamplePeakMemory() const
+    {
+        // VmHWM is gone once the child exits, so is sampled while it runs
+        char fileName[ 32 ];
+        snprintf( fileName, sizeof( fileName ), "/proc/%i/status", m_ChildPID );
+        const int fd = open( fileName, O_RDONLY | O_CLOEXEC );
+        if ( fd == -1 )
+        {
+            return;
+        }
+        char buffer[ 4096 ];
+        const ssize_t size = read( fd, buffer, sizeof( buffer ) - 1 );
+        close( fd );
+        if ( size <= 0 )
+        {
+            return;
+        }
+        buffer[ size ] = 0;
+
+        const char * entry = strstr( buffer, "VmHWM:" );
+        unsigned long long peakKiB = 0;
+        if ( entry && ( sscanf( entry + 6, "%llu", &peakKiB ) == 1 ) )
+        {
+            m_PeakMemoryBytes = Math::Max( m_PeakMemoryBytes, (uint64_t)peakKiB * 1024 );
+        }
     }
 #endif
 
@@ -822,6 +1153,28 @@ void Process::Terminate()
     #endif
 }
 
+// StoreResourceUsage
+//------------------------------------------------------------------------------
+#if defined( __LINUX__ ) || ( defined( __APPLE__) && !defined( APPLE_PROCESS_USE_NSTASK ) )
+    void Process::StoreResourceUsage( const struct rusage & usage ) const
+    {
+        // ru_maxrss includes the high-water mark this process had when the child
+        // called exec, so is only the child's own (or its descendants') if it is
+        // above ours. Otherwise, the peak sampled while it ran is kept.
+        struct rusage selfUsage;
+        if ( ( getrusage( RUSAGE_SELF, &selfUsage ) == 0 ) && ( usage.ru_maxrss > selfUsage.ru_maxrss ) )
+        {
+            #if defined( __APPLE__ )
+                m_PeakMemoryBytes = (uint64_t)usage.ru_maxrss; // bytes
+            #else
+                m_PeakMemoryBytes = ( (uint64_t)usage.ru_maxrss * 1024 ); // KiB
+            #endif
+        }
+        m_CPUTimeUS = ( ( (uint64_t)usage.ru_utime.tv_sec + (uint64_t)usage.ru_stime.tv_sec ) * 1000000 ) +
+                      (uint64_t)usage.ru_utime.tv_usec + (uint64_t)usage.ru_stime.tv_usec;
+    }
+#endif
+
 //------------------------------------------------------------------------------
 
 
@@ -22,6 +22,9 @@
 // Forward Declarations
 //------------------------------------------------------------------------------
 class AString;
+#if defined( __LINUX__ ) || defined( __APPLE__ )
+    struct rusage;
+#endif
 
 // Process
 //------------------------------------------------------------------------------
@@ -55,6 +58,18 @@ public:
     bool HasAborted() const { return m_HasAborted; }
     static uint32_t GetCurrentId();
 
+    #if defined( __LINUX__ )
+        // Place the child in an existing cgroup v2 before it executes. The
+        // path (a "cgroup.procs" file) must remain valid until Spawn returns.
+        inline void SetCGroupProcsFile( const char * cgroupProcsFile ) { m_CGroupProcsFile = cgroupProcsFile; }
+    #endif
+
+    // Resource usage of the exited process (0 if unavailable on this platform).
+    // Peak memory is sampled while output is read (Linux), so is approximate
+    // for processes which don't need more memory than this one.
+    inline uint64_t GetPeakMemoryBytes() const { return m_PeakMemoryBytes; }
+    inline uint64_t GetCPUTimeUS() const { return m_CPUTimeUS; }
+
 private:
     #if defined( __WINDOWS__ )
         void KillProcessTreeInternal( const void * hProc, // HANDLE
@@ -65,11 +80,19 @@ private:
     #elif defined( __APPLE__ ) && defined( APPLE_PROCESS_USE_NSTASK )
         void Read( NSData * availableData, AutoPtr< char > & buffer, uint32_t & sizeSoFar, uint32_t & bufferSize );
     #else
-        void Read( int handle, AString & buffer );
+        bool Read( int handle, AString & buffer ); // false once the pipe is closed
+    #endif
+    #if defined( __LINUX__ )
+        bool ReadAllDataEvents( AString & memOut, AString & errOut, uint32_t timeOutMS );
+        void SamplePeakMemory() const;
     #endif
 
     void Terminate();
 
+    #if defined( __LINUX__ ) || ( defined( __APPLE__) && !defined( APPLE_PROCESS_USE_NSTASK ) )
+        void StoreResourceUsage( const struct rusage & usage ) const;
+    #endif
+
     #if defined( __WINDOWS__ )
         // This messyness is to avoid including windows.h in this file
         inline struct _PROCESS_INFORMATION & GetProcessInfo() const
@@ -102,6 +125,12 @@ private:
         int m_StdOutRead;
         int m_StdErrRead;
     #endif
+    #if defined( __LINUX__ )
+        const char * m_CGroupProcsFile;
+        int m_PidFD;            // -1 if unsupported by the kernel
+    #endif
+    mutable uint64_t m_PeakMemoryBytes;
+    mutable uint64_t m_CPUTimeUS;
 
  
     #if defined( __APPLE__) && defined( APPLE_PROCESS_USE_NSTASK )
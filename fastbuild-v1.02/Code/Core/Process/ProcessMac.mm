@@ -26,6 +26,8 @@ Process::Process( const volatile bool * masterAbortFlag,
     , m_Task( nil )
     , m_StdOutRead( nil )
     , m_StdErrRead( nil )
+    , m_PeakMemoryBytes( 0 )
+    , m_CPUTimeUS( 0 )
     , m_HasAborted( false )
     , m_MasterAbortFlag( masterAbortFlag )
     , m_AbortFlag( abortFlag )
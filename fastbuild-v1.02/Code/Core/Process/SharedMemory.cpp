@@ -53,7 +53,12 @@ bool PosixMapMemory( const char * name,
     }
 
     *memory = mmap( nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, *mapFile, 0 );
-    return ( *memory != MAP_FAILED );
+    if ( *memory == MAP_FAILED )
+    {
+        *memory = nullptr;
+        return false;
+    }
+    return true;
 }
 }
 #endif
@@ -67,6 +72,7 @@ SharedMemory::SharedMemory()
     #elif defined(__LINUX__) || defined(__APPLE__)
         , m_MapFile( -1 )
         , m_Length( 0 )
+        , m_Created( false )
     #else
         #error Unknown Platform
     #endif
@@ -87,7 +93,10 @@ SharedMemory::~SharedMemory()
         if ( m_MapFile != -1 )
         {
             close( m_MapFile );
-            shm_unlink( m_Name.Get() );
+            if ( m_Created )
+            {
+                shm_unlink( m_Name.Get() ); // Only the creator removes the name
+            }
         }
     #else
         #error Unknown Platform
@@ -118,6 +127,7 @@ void SharedMemory::Create( const char * name, unsigned int size )
     #elif defined( __APPLE__ ) || defined( __LINUX__ )
         PosixMapMemory(name, size, true, &m_MapFile, &m_Memory, m_Name);
         m_Length = size;
+        m_Created = true;
     #else
         #error Unknown Platform
     #endif
@@ -33,6 +33,7 @@ private:
         int m_MapFile;
         size_t m_Length;
         AString m_Name;
+        bool m_Created;
     #else
         #error Unknown Platform
     #endif
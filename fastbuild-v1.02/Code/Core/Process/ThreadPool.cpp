@@ -0,0 +1,139 @@
+// ThreadPool.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "ThreadPool.h"
+
+// Core
+#include "Core/Env/Assert.h"
+#include "Core/Math/Conversions.h"
+#include "Core/Process/Atomic.h"
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+ThreadPool::ThreadPool( uint32_t numThreads )
+    : m_Threads( 0, true )
+    , m_Exit( false )
+    , m_Function( nullptr )
+    , m_UserData( nullptr )
+    , m_Count( 0 )
+    , m_BatchSize( 1 )
+    , m_NextIndex( 0 )
+    , m_NumParallelFors( 0 )
+{
+    ASSERT( numThreads > 0 );
+    m_Threads.SetCapacity( numThreads - 1 );
+    for ( uint32_t i = 1; i < numThreads; ++i )
+    {
+        m_Threads.Append( Thread::CreateThread( ThreadFuncStatic, "ThreadPool", ( 256 * KILOBYTE ), this ) );
+    }
+
+    // Wait for threads to start, so any allocations made by thread startup are
+    // complete when we return
+    for ( uint32_t i = 1; i < numThreads; ++i )
+    {
+        m_DoneSemaphore.Wait();
+    }
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+ThreadPool::~ThreadPool()
+{
+    if ( m_Threads.IsEmpty() )
+    {
+        return;
+    }
+
+    AtomicStoreRelease( &m_Exit, true );
+    m_WorkSemaphore.Signal( (uint32_t)m_Threads.GetSize() );
+    for ( Thread::ThreadHandle h : m_Threads )
+    {
+        Thread::WaitForThread( h );
+        Thread::CloseHandle( h );
+    }
+}
+
+// ParallelFor
+//------------------------------------------------------------------------------
+void ThreadPool::ParallelFor( uint32_t count, ItemFunction function, void * userData )
+{
+    if ( count == 0 )
+    {
+        return;
+    }
+
+    m_Function = function;
+    m_UserData = userData;
+    m_Count = count;
+    m_BatchSize = Math::Max< uint32_t >( 1, count / ( GetNumThreads() * 8 ) ); // Balance load vs contention
+    m_NextIndex = 0;
+    ++m_NumParallelFors;
+
+    // Wake helpers (the Semaphore ensures they see the state above)
+    const uint32_t numHelpers = (uint32_t)m_Threads.GetSize();
+    if ( numHelpers > 0 )
+    {
+        m_WorkSemaphore.Signal( numHelpers );
+    }
+
+    ProcessItems();
+
+    // Wait for helpers to finish any items they claimed
+    for ( uint32_t i = 0; i < numHelpers; ++i )
+    {
+        m_DoneSemaphore.Wait();
+    }
+}
+
+// ThreadFuncStatic
+//------------------------------------------------------------------------------
+/*static*/ uint32_t ThreadPool::ThreadFuncStatic( void * param )
+{
+    ThreadPool * pool = static_cast< ThreadPool * >( param );
+    pool->ThreadFunc();
+    return 0;
+}
+
+// ThreadFunc
+//------------------------------------------------------------------------------
+void ThreadPool::ThreadFunc()
+{
+    m_DoneSemaphore.Signal(); // Started
+
+    for ( ;; )
+    {
+        m_WorkSemaphore.Wait();
+        if ( AtomicLoadAcquire( &m_Exit ) )
+        {
+            return;
+        }
+
+        ProcessItems();
+
+        m_DoneSemaphore.Signal();
+    }
+}
+
+// ProcessItems
+//------------------------------------------------------------------------------
+void ThreadPool::ProcessItems()
+{
+    for ( ;; )
+    {
+        const uint32_t end = AtomicAddU32( &m_NextIndex, (int32_t)m_BatchSize );
+        const uint32_t start = ( end - m_BatchSize );
+        if ( start >= m_Count )
+        {
+            return;
+        }
+        const uint32_t batchEnd = Math::Min( end, m_Count );
+        for ( uint32_t index = start; index < batchEnd; ++index )
+        {
+            m_Function( m_UserData, index );
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
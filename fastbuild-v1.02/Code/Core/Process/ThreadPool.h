@@ -0,0 +1,55 @@
+// ThreadPool.h
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Containers/Array.h"
+#include "Core/Env/Types.h"
+#include "Core/Process/Semaphore.h"
+#include "Core/Process/Thread.h"
+
+// ThreadPool
+//------------------------------------------------------------------------------
+// A set of threads which can help the calling thread work through a list of
+// independent items.
+//
+// The pool performs no memory allocations once created, so it can be used while
+// the SmallBlockAllocator is in single threaded mode, as long as the supplied
+// function doesn't allocate either.
+//------------------------------------------------------------------------------
+class ThreadPool
+{
+public:
+    explicit ThreadPool( uint32_t numThreads ); // Including the calling thread
+    ~ThreadPool();
+
+    typedef void (*ItemFunction)( void * userData, uint32_t index );
+
+    // Call the function for each index in [0, count). The calling thread
+    // participates, and the call returns when all items are complete.
+    void ParallelFor( uint32_t count, ItemFunction function, void * userData );
+
+    uint32_t GetNumThreads() const { return ( (uint32_t)m_Threads.GetSize() + 1 ); }
+    uint32_t GetNumParallelFors() const { return m_NumParallelFors; }
+
+private:
+    static uint32_t ThreadFuncStatic( void * param );
+    void ThreadFunc();
+    void ProcessItems();
+
+    Array< Thread::ThreadHandle >   m_Threads;
+    Semaphore                       m_WorkSemaphore;    // Signalled once per helper thread for each ParallelFor
+    Semaphore                       m_DoneSemaphore;    // Signalled by each helper thread when items are exhausted
+    volatile bool                   m_Exit;
+
+    // Current ParallelFor
+    ItemFunction                    m_Function;
+    void *                          m_UserData;
+    uint32_t                        m_Count;
+    uint32_t                        m_BatchSize;
+    volatile uint32_t               m_NextIndex;
+    uint32_t                        m_NumParallelFors;
+};
+
+//------------------------------------------------------------------------------
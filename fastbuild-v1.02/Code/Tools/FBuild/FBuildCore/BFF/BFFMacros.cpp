@@ -8,6 +8,7 @@
 
 // Core
 #include "Core/Env/Assert.h"
+#include "Core/Math/xxHash.h"
 #include "Core/Strings/AString.h"
 
 // CONSTRUCTOR
@@ -87,4 +88,17 @@ bool BFFMacros::Undefine( const AString & token )
     }
 }
 
+// GetHash
+//------------------------------------------------------------------------------
+uint64_t BFFMacros::GetHash() const
+{
+    // Order independent, as the order of definition doesn't matter
+    uint64_t hash = m_Tokens.GetSize();
+    for ( const AString & token : m_Tokens )
+    {
+        hash += xxHash::Calc64( token );
+    }
+    return hash;
+}
+
 //------------------------------------------------------------------------------
@@ -26,6 +26,10 @@ public:
     bool Define( const AString & token );
     bool Undefine( const AString & token );
 
+    // Identify/restore the set of defines (for BFFTokenCache)
+    uint64_t GetHash() const;
+    void SetTokens( const Array< AString > & tokens ) { m_Tokens = tokens; }
+
 private:
     Array< AString > m_Tokens;
 };
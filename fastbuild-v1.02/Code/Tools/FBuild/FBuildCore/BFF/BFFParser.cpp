@@ -43,10 +43,16 @@ BFFParser::~BFFParser() = default;
 
 // ParseFromFile
 //------------------------------------------------------------------------------
-bool BFFParser::ParseFromFile( const char * fileName )
+bool BFFParser::ParseFromFile( const char * fileName, const char * tokenCacheFile )
 {
     PROFILE_FUNCTION
 
+    // Re-use tokens for unchanged files?
+    if ( tokenCacheFile )
+    {
+        m_Tokenizer.LoadCache( AStackString<>( tokenCacheFile ) );
+    }
+
     // Tokenize file
     const BFFToken * token = nullptr; // The root include doesn't have an associated token
     if ( m_Tokenizer.TokenizeFromFile( AStackString<>( fileName ), token ) == false )
@@ -54,6 +60,11 @@ bool BFFParser::ParseFromFile( const char * fileName )
         return false; // Tokenize will have emitted an error
     }
 
+    if ( tokenCacheFile )
+    {
+        m_Tokenizer.SaveCache(); // Failure is not fatal
+    }
+
     const Array<BFFToken>& tokens = m_Tokenizer.GetTokens();
     if ( tokens.IsEmpty() )
     {
@@ -30,7 +30,7 @@ public:
     ~BFFParser();
 
     // Parse BFF data
-    bool ParseFromFile( const char * fileName );
+    bool ParseFromFile( const char * fileName, const char * tokenCacheFile = nullptr );
     bool ParseFromString( const char * fileName, const char * fileContents );
     bool Parse( BFFTokenRange & tokenRange );
 
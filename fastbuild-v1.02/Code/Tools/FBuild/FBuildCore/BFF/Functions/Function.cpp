@@ -647,14 +647,27 @@ bool Function::GetNodeList( NodeGraph & nodeGraph,
                                         const char * inputVarName,
                                         Dependencies & nodes )
 {
-    const AString * const  end = files.End();
-    for ( const AString * it = files.Begin(); it != end; ++it )
+    // Clean and hash all names up front (in parallel for large lists)
+    Array< NodeGraph::NodeNameKey > keys( 0, true );
+    NodeGraph::CalcNodeNameKeys( files, keys );
+
+    nodes.SetCapacity( nodes.GetSize() + files.GetSize() );
+    const size_t numFiles = files.GetSize();
+    for ( size_t i = 0; i < numFiles; ++i )
     {
-        const AString & file = *it;
-        if (!GetFileNode( nodeGraph, iter, function, file, inputVarName, nodes ))
+        // get node for the file we depend on
+        Node * node = nodeGraph.FindNode( files[ i ], keys[ i ] );
+        if ( node == nullptr )
+        {
+            node = nodeGraph.CreateFileNode( keys[ i ].m_CleanName, false ); // already clean
+        }
+        else if ( node->IsAFile() == false )
         {
-            return false; // GetFileNode will have emitted an error
+            Error::Error_1005_UnsupportedNodeType( iter, function, inputVarName, node->GetName(), node->GetType() );
+            return false;
         }
+
+        nodes.EmplaceBack( node );
     }
     return true;
 }
@@ -853,6 +866,26 @@ bool Function::GetStrings( const BFFToken * iter, Array< AString > & strings, co
     return true;
 }
 
+// GetBool
+//------------------------------------------------------------------------------
+bool Function::GetBool( const BFFToken * iter, bool & var, const char * name ) const
+{
+    const BFFVariable * v = BFFStackFrame::GetVar( name );
+    if ( v == nullptr )
+    {
+        return true; // not provided: keep default
+    }
+
+    if ( v->IsBool() == false )
+    {
+        Error::Error_1050_PropertyMustBeOfType( iter, this, name, v->GetType(), BFFVariable::VAR_BOOL );
+        return false;
+    }
+
+    var = v->GetBool();
+    return true;
+}
+
 // ProcessAlias
 //------------------------------------------------------------------------------
 bool Function::ProcessAlias( NodeGraph & nodeGraph, const BFFToken * iter, Node * nodeToAlias ) const
@@ -1072,8 +1105,32 @@ bool Function::PopulateStringHelper( NodeGraph & nodeGraph, const BFFToken * ite
 {
     if ( variable->IsArrayOfStrings() )
     {
-        for ( const AString & string : variable->GetArrayOfStrings() )
+        const Array< AString > & strings = variable->GetArrayOfStrings();
+
+        // Full paths to files are cleaned and hashed up front (in parallel for large lists)
+        Array< NodeGraph::NodeNameKey > keys( 0, true );
+        if ( fileMD && ( !fileMD->IsRelative() ) )
         {
+            NodeGraph::CalcNodeNameKeys( strings, keys );
+            outStrings.SetCapacity( outStrings.GetSize() + strings.GetSize() );
+        }
+
+        const size_t numStrings = strings.GetSize();
+        for ( size_t i = 0; i < numStrings; ++i )
+        {
+            const AString & string = strings[ i ];
+
+            // Common case: a file which doesn't match an existing node
+            if ( ( keys.IsEmpty() == false ) &&
+                 ( string.IsEmpty() == false ) &&
+                 ( nodeGraph.FindNode( string, keys[ i ] ) == nullptr ) &&
+                 ( PathUtils::IsFolderPath( keys[ i ].m_CleanName ) == false ) )
+            {
+                outStrings.Append( keys[ i ].m_CleanName );
+                continue;
+            }
+
+            // Aliases, other nodes and errors
             if ( !PopulateStringHelper( nodeGraph, iter, pathMD, fileMD, allowNonFileMD, variable, string, outStrings ) )
             {
                 return false; // PopulateStringHelper will have emitted an error
@@ -143,6 +143,7 @@ protected:
     bool GetString( const BFFToken * iter, AString & var, const char * name, bool required = false ) const;
     bool GetStringOrArrayOfStrings( const BFFToken * iter, const BFFVariable * & var, const char * name, bool required ) const;
     bool GetStrings( const BFFToken * iter, Array< AString > & strings, const char * name, bool required = false ) const;
+    bool GetBool( const BFFToken * iter, bool & var, const char * name ) const; // optional, var is unchanged if not set
 
     // helper function to make alias for target
     bool ProcessAlias( NodeGraph & nodeGraph, const BFFToken * iter, Node * nodeToAlias ) const;
@@ -57,6 +57,11 @@ FunctionCopy::FunctionCopy()
         PathUtils::EnsureTrailingSlash( cleanValue );
         sourceBasePath = cleanValue;
     }
+    bool allowHardLinks = false;
+    if ( !GetBool( funcStartIter, allowHardLinks, ".AllowHardLinks" ) )
+    {
+        return false; // GetBool will have emitted errors
+    }
 
     // check sources are not paths
     {
@@ -158,6 +163,7 @@ FunctionCopy::FunctionCopy()
         CopyFileNode * copyFileNode = nodeGraph.CreateCopyFileNode( dst );
         copyFileNode->m_Source = srcNode->GetName();
         copyFileNode->m_PreBuildDependencyNames = preBuildDependencyNames;
+        copyFileNode->m_AllowHardLinks = allowHardLinks;
         if ( !copyFileNode->Initialize( nodeGraph, funcStartIter, this ) )
         {
             return false; // Initialize will have emitted an error
@@ -18,6 +18,7 @@ BFFToken::BFFToken( const BFFFile & file,
     , m_Boolean( false )
     , m_Integer( 0 )
     , m_String( valueStart, valueEnd )
+    , m_Value( &m_String )
     , m_BFFFile( file )
     , m_SourcePos( sourcePos )
 {
@@ -36,6 +37,7 @@ BFFToken::BFFToken( const BFFFile & file,
 BFFToken::BFFToken( const BFFFile & file, const char * sourcePos, BFFTokenType type, const AString & stringValue )
     : m_Type( type )
     , m_String( stringValue )
+    , m_Value( &m_String )
     , m_BFFFile( file )
     , m_SourcePos( sourcePos )
 {
@@ -47,11 +49,34 @@ BFFToken::BFFToken( const BFFFile & file, const char * sourcePos, BFFTokenType t
     : m_Type( type )
     , m_Boolean( boolValue )
     , m_String( boolValue ? "true" : "false" )
+    , m_Value( &m_String )
     , m_BFFFile( file )
     , m_SourcePos( sourcePos )
 {
 }
 
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+BFFToken::BFFToken( const BFFFile & file, const char * sourcePos, BFFTokenType type, const AString * sharedValue )
+    : m_Type( type )
+    , m_Value( sharedValue )
+    , m_BFFFile( file )
+    , m_SourcePos( sourcePos )
+{
+    if ( type == BFFTokenType::Number )
+    {
+        #if defined( __WINDOWS__ )
+            VERIFY( sscanf_s( m_Value->Get(), "%i", &m_Integer ) == 1 );
+        #else
+            VERIFY( sscanf( m_Value->Get(), "%i", &m_Integer ) == 1 );
+        #endif
+    }
+    else if ( type == BFFTokenType::Boolean )
+    {
+        m_Boolean = ( *m_Value == "true" );
+    }
+}
+
 // CONSTRUCTOR (Move)
 //------------------------------------------------------------------------------
 BFFToken::BFFToken( BFFToken && other )
@@ -59,6 +84,7 @@ BFFToken::BFFToken( BFFToken && other )
     , m_Boolean( other.m_Boolean )
     , m_Integer( other.m_Integer )
     , m_String( Move( other.m_String ) )
+    , m_Value( ( other.m_Value == &other.m_String ) ? &m_String : other.m_Value )
     , m_BFFFile( other.m_BFFFile )
     , m_SourcePos( other.m_SourcePos )
 {
@@ -43,6 +43,7 @@ public:
     BFFToken( const BFFFile & file, const char * sourcePos, BFFTokenType type, const char * valueStart, const char * valueEnd );
     BFFToken( const BFFFile & file, const char * sourcePos, BFFTokenType type, const AString & stringValue );
     BFFToken( const BFFFile & file, const char * sourcePos, BFFTokenType type, const bool boolValue );
+    BFFToken( const BFFFile & file, const char * sourcePos, BFFTokenType type, const AString * sharedValue ); // sharedValue must outlive the token
 
     // Allow move construction
     BFFToken( BFFToken && other );
@@ -56,21 +57,21 @@ public:
     bool IsIdentifier() const                       { return ( m_Type == BFFTokenType::Identifier ); }
     bool IsFunction() const                         { return ( m_Type == BFFTokenType::Function ); }
     bool IsKeyword() const                          { return ( m_Type == BFFTokenType::Keyword ); }
-    bool IsKeyword( const char * keyword ) const    { return ( m_Type == BFFTokenType::Keyword ) && ( m_String == keyword ); }
+    bool IsKeyword( const char * keyword ) const    { return ( m_Type == BFFTokenType::Keyword ) && ( *m_Value == keyword ); }
     bool IsNumber() const                           { return ( m_Type == BFFTokenType::Number ); }
     bool IsOperator() const                         { return ( m_Type == BFFTokenType::Operator ); }
-    bool IsOperator( const char * op ) const        { return ( m_Type == BFFTokenType::Operator ) && ( m_String == op ); }
-    bool IsOperator( const char op ) const          { return ( m_Type == BFFTokenType::Operator ) && ( m_String[ 0 ] == op ) && ( m_String.GetLength() == 1 ); }
-    bool IsRoundBracket( const char c ) const       { return ( m_Type == BFFTokenType::RoundBracket ) && ( m_String[ 0 ] == c ); }
-    bool IsCurlyBracket( const char c ) const       { return ( m_Type == BFFTokenType::CurlyBracket ) && ( m_String[ 0 ] == c ); }
-    bool IsSquareBracket( const char c ) const      { return ( m_Type == BFFTokenType::SquareBracket ) && ( m_String[ 0 ] == c ); }
+    bool IsOperator( const char * op ) const        { return ( m_Type == BFFTokenType::Operator ) && ( *m_Value == op ); }
+    bool IsOperator( const char op ) const          { return ( m_Type == BFFTokenType::Operator ) && ( (*m_Value)[ 0 ] == op ) && ( m_Value->GetLength() == 1 ); }
+    bool IsRoundBracket( const char c ) const       { return ( m_Type == BFFTokenType::RoundBracket ) && ( (*m_Value)[ 0 ] == c ); }
+    bool IsCurlyBracket( const char c ) const       { return ( m_Type == BFFTokenType::CurlyBracket ) && ( (*m_Value)[ 0 ] == c ); }
+    bool IsSquareBracket( const char c ) const      { return ( m_Type == BFFTokenType::SquareBracket ) && ( (*m_Value)[ 0 ] == c ); }
     bool IsString() const                           { return ( m_Type == BFFTokenType::String ); }
     bool IsBooelan() const                          { return ( m_Type == BFFTokenType::Boolean ); }
     bool IsVariable() const                         { return ( m_Type == BFFTokenType::Variable ); }
     bool IsComma() const                            { return ( m_Type == BFFTokenType::Comma ); }
 
     BFFTokenType    GetType() const                 { return m_Type; }
-    const AString & GetValueString() const          { return m_String; }
+    const AString & GetValueString() const          { return *m_Value; }
     int32_t         GetValueInt() const             { return m_Integer; }
     bool            GetBoolean() const              { return m_Boolean; }
 
@@ -85,7 +86,8 @@ private:
     BFFTokenType    m_Type;
     bool            m_Boolean   = false;
     int32_t         m_Integer   = 0;
-    AString         m_String;
+    AString         m_String;   // Value, unless shared
+    const AString * m_Value;    // Points to m_String or shared value
     const BFFFile & m_BFFFile;
     const char *    m_SourcePos = nullptr;
 };
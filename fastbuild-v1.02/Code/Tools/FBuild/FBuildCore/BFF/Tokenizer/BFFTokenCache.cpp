@@ -0,0 +1,370 @@
+// BFFTokenCache.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "BFFTokenCache.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/BFF/Tokenizer/BFFTokenStringTable.h"
+#include "Tools/FBuild/FBuildCore/FBuildVersion.h"
+#include "Tools/FBuild/FBuildCore/FLog.h"
+
+// Core
+#include "Core/Containers/AutoPtr.h"
+#include "Core/FileIO/ConstMemoryStream.h"
+#include "Core/FileIO/FileIO.h"
+#include "Core/FileIO/FileStream.h"
+#include "Core/FileIO/MemoryStream.h"
+#include "Core/FileIO/PathUtils.h"
+#include "Core/Mem/Mem.h"
+#include "Core/Profile/Profile.h"
+#include "Core/Strings/AStackString.h"
+
+// Defines
+//------------------------------------------------------------------------------
+#define BFF_TOKEN_CACHE_MAGIC   ( 0x43544246 ) // 'FBTC'
+#define BFF_TOKEN_CACHE_VERSION ( 1 )
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+BFFTokenCache::BFFTokenCache( BFFTokenStringTable & strings )
+    : m_Strings( strings )
+    , m_Entries( 0, true )
+{
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+BFFTokenCache::~BFFTokenCache()
+{
+    for ( Entry * entry : m_Entries )
+    {
+        FDELETE( entry );
+    }
+}
+
+// Load
+//------------------------------------------------------------------------------
+bool BFFTokenCache::Load( const AString & fileName )
+{
+    PROFILE_FUNCTION
+
+    FileStream fs;
+    if ( fs.Open( fileName.Get(), FileStream::READ_ONLY ) == false )
+    {
+        return false; // Not an error (no cache yet)
+    }
+
+    // Read it all into memory
+    const size_t size = (size_t)fs.GetFileSize();
+    AutoPtr< void > mem( ALLOC( size ) );
+    if ( fs.Read( mem.Get(), size ) != size )
+    {
+        FLOG_WARN( "Failed to read BFF token cache '%s'", fileName.Get() );
+        return false;
+    }
+
+    ConstMemoryStream stream( mem.Get(), size );
+    if ( Load( stream ) == false )
+    {
+        // Discard anything partially loaded
+        for ( Entry * entry : m_Entries )
+        {
+            FDELETE( entry );
+        }
+        m_Entries.Clear();
+
+        FLOG_VERBOSE( "BFF token cache '%s' is incompatible or corrupt (ignored)", fileName.Get() );
+        return false;
+    }
+
+    FLOG_VERBOSE( "Loaded BFF token cache '%s' (%u entries)", fileName.Get(), (uint32_t)m_Entries.GetSize() );
+    return true;
+}
+
+// Save
+//------------------------------------------------------------------------------
+bool BFFTokenCache::Save( const AString & fileName ) const
+{
+    PROFILE_FUNCTION
+
+    // serialize into memory first
+    MemoryStream memoryStream( 1024 * 1024, 1024 * 1024 );
+    Save( memoryStream );
+
+    // Ensure output dir exists
+    const char * lastSlash = fileName.FindLast( NATIVE_SLASH );
+    if ( lastSlash )
+    {
+        AStackString<> pathOnly( fileName.Get(), lastSlash );
+        if ( FileIO::EnsurePathExists( pathOnly ) == false )
+        {
+            return false;
+        }
+    }
+
+    // Write to a tmp file first so an interrupted write can't leave a partial cache
+    AStackString<> tmpFileName( fileName );
+    tmpFileName += ".tmp";
+    FileStream fileStream;
+    if ( ( fileStream.Open( tmpFileName.Get(), FileStream::WRITE_ONLY ) == false ) ||
+         ( fileStream.Write( memoryStream.GetData(), memoryStream.GetSize() ) != memoryStream.GetSize() ) )
+    {
+        return false;
+    }
+    fileStream.Close();
+
+    return FileIO::FileMove( tmpFileName, fileName );
+}
+
+// Find
+//------------------------------------------------------------------------------
+BFFTokenCache::Entry * BFFTokenCache::Find( const AString & fileName, uint64_t fileHash, uint64_t macroHash )
+{
+    for ( Entry * entry : m_Entries )
+    {
+        if ( ( entry->m_FileHash == fileHash ) &&
+             ( entry->m_MacroHash == macroHash ) &&
+             PathUtils::ArePathsEqual( entry->m_FileName, fileName ) )
+        {
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+// Add
+//------------------------------------------------------------------------------
+void BFFTokenCache::Add( Entry * entry )
+{
+    entry->m_Used = true;
+    ++m_NumMisses;
+
+    // Replace any entry which is no longer valid (due to a changed dependency)
+    Entry * existing = Find( entry->m_FileName, entry->m_FileHash, entry->m_MacroHash );
+    if ( existing )
+    {
+        *m_Entries.Find( existing ) = entry;
+        FDELETE( existing );
+        return;
+    }
+    m_Entries.Append( entry );
+}
+
+// Load
+//------------------------------------------------------------------------------
+bool BFFTokenCache::Load( IOStream & stream )
+{
+    // Header
+    uint32_t magic;
+    uint32_t version;
+    AStackString<> fbuildVersion;
+    if ( ( stream.Read( magic ) == false ) || ( magic != BFF_TOKEN_CACHE_MAGIC ) ||
+         ( stream.Read( version ) == false ) || ( version != BFF_TOKEN_CACHE_VERSION ) ||
+         ( stream.Read( fbuildVersion ) == false ) || ( fbuildVersion != FBUILD_VERSION_STRING " " FBUILD_VERSION_PLATFORM ) )
+    {
+        return false; // Keywords, functions etc may differ
+    }
+
+    // Strings (re-indexed into our table)
+    uint32_t numStrings;
+    if ( stream.Read( numStrings ) == false )
+    {
+        return false;
+    }
+    Array< uint32_t > remap( numStrings, false );
+    AStackString<> string;
+    for ( uint32_t i = 0; i < numStrings; ++i )
+    {
+        if ( stream.Read( string ) == false )
+        {
+            return false;
+        }
+        remap.Append( m_Strings.Add( string ) );
+    }
+
+    // Entries
+    uint32_t numEntries;
+    if ( stream.Read( numEntries ) == false )
+    {
+        return false;
+    }
+    m_Entries.SetCapacity( numEntries );
+    for ( uint32_t i = 0; i < numEntries; ++i )
+    {
+        Entry * entry = FNEW( Entry );
+        m_Entries.Append( entry );
+
+        uint32_t numOps;
+        if ( ( stream.Read( entry->m_FileName ) == false ) ||
+             ( stream.Read( entry->m_FileHash ) == false ) ||
+             ( stream.Read( entry->m_MacroHash ) == false ) ||
+             ( stream.Read( numOps ) == false ) )
+        {
+            return false;
+        }
+        entry->m_Ops.SetCapacity( numOps );
+        for ( uint32_t j = 0; j < numOps; ++j )
+        {
+            uint8_t type;
+            Op op;
+            if ( ( stream.Read( type ) == false ) ||
+                 ( type > OP_FILE_EXISTS ) ||
+                 ( stream.Read( op.m_Value ) == false ) ||
+                 ( stream.Read( op.m_Hash ) == false ) )
+            {
+                return false;
+            }
+            op.m_Type = (OpType)type;
+            if ( ( op.m_Type != OP_TOKENS ) && ( op.m_Type != OP_ONCE ) )
+            {
+                if ( op.m_Value >= numStrings )
+                {
+                    return false;
+                }
+                op.m_Value = remap[ op.m_Value ];
+            }
+            entry->m_Ops.Append( op );
+        }
+
+        uint32_t numTokens;
+        if ( stream.Read( numTokens ) == false )
+        {
+            return false;
+        }
+        const uint64_t tokensSize = ( numTokens * sizeof( Token ) );
+        if ( tokensSize > ( stream.GetFileSize() - stream.Tell() ) )
+        {
+            return false; // Truncated
+        }
+        entry->m_Tokens.SetSize( numTokens );
+        if ( stream.Read( entry->m_Tokens.Begin(), (size_t)tokensSize ) != tokensSize )
+        {
+            return false;
+        }
+        for ( Token & token : entry->m_Tokens )
+        {
+            if ( ( token.m_Type > BFFTokenType::EndOfFile ) || ( token.m_Value >= numStrings ) )
+            {
+                return false;
+            }
+            token.m_Value = remap[ token.m_Value ];
+        }
+
+        uint32_t numMacros;
+        if ( stream.Read( numMacros ) == false )
+        {
+            return false;
+        }
+        entry->m_Macros.SetCapacity( numMacros );
+        for ( uint32_t j = 0; j < numMacros; ++j )
+        {
+            uint32_t macro;
+            if ( ( stream.Read( macro ) == false ) || ( macro >= numStrings ) )
+            {
+                return false;
+            }
+            entry->m_Macros.Append( remap[ macro ] );
+        }
+    }
+
+    return true;
+}
+
+// Save
+//------------------------------------------------------------------------------
+void BFFTokenCache::Save( IOStream & stream ) const
+{
+    // Only entries used this time are kept, so the cache doesn't grow unbounded
+    // as files are edited. Gather the strings they use.
+    Array< uint32_t > remap( m_Strings.GetSize(), false );
+    remap.SetSize( m_Strings.GetSize() );
+    for ( uint32_t & index : remap )
+    {
+        index = UNUSED_STRING;
+    }
+    Array< uint32_t > strings( m_Strings.GetSize(), false );
+    uint32_t numEntries = 0;
+    for ( const Entry * entry : m_Entries )
+    {
+        if ( entry->m_Used == false )
+        {
+            continue;
+        }
+        ++numEntries;
+        for ( const Op & op : entry->m_Ops )
+        {
+            if ( ( op.m_Type != OP_TOKENS ) && ( op.m_Type != OP_ONCE ) )
+            {
+                UseString( op.m_Value, remap, strings );
+            }
+        }
+        for ( const Token & token : entry->m_Tokens )
+        {
+            UseString( token.m_Value, remap, strings );
+        }
+        for ( const uint32_t macro : entry->m_Macros )
+        {
+            UseString( macro, remap, strings );
+        }
+    }
+
+    // Header
+    stream.Write( (uint32_t)BFF_TOKEN_CACHE_MAGIC );
+    stream.Write( (uint32_t)BFF_TOKEN_CACHE_VERSION );
+    stream.Write( AStackString<>( FBUILD_VERSION_STRING " " FBUILD_VERSION_PLATFORM ) );
+
+    // Strings
+    stream.Write( (uint32_t)strings.GetSize() );
+    for ( const uint32_t index : strings )
+    {
+        stream.Write( m_Strings.Get( index ) );
+    }
+
+    // Entries
+    stream.Write( numEntries );
+    for ( const Entry * entry : m_Entries )
+    {
+        if ( entry->m_Used == false )
+        {
+            continue;
+        }
+        stream.Write( entry->m_FileName );
+        stream.Write( entry->m_FileHash );
+        stream.Write( entry->m_MacroHash );
+        stream.Write( (uint32_t)entry->m_Ops.GetSize() );
+        for ( const Op & op : entry->m_Ops )
+        {
+            const bool isString = ( ( op.m_Type != OP_TOKENS ) && ( op.m_Type != OP_ONCE ) );
+            stream.Write( (uint8_t)op.m_Type );
+            stream.Write( isString ? remap[ op.m_Value ] : op.m_Value );
+            stream.Write( op.m_Hash );
+        }
+        stream.Write( (uint32_t)entry->m_Tokens.GetSize() );
+        Array< Token > tokens( entry->m_Tokens );
+        for ( Token & token : tokens )
+        {
+            token.m_Value = remap[ token.m_Value ];
+        }
+        stream.Write( tokens.Begin(), tokens.GetSize() * sizeof( Token ) );
+        stream.Write( (uint32_t)entry->m_Macros.GetSize() );
+        for ( const uint32_t macro : entry->m_Macros )
+        {
+            stream.Write( remap[ macro ] );
+        }
+    }
+}
+
+// UseString
+//------------------------------------------------------------------------------
+/*static*/ void BFFTokenCache::UseString( uint32_t index, Array< uint32_t > & remap, Array< uint32_t > & strings )
+{
+    if ( remap[ index ] == UNUSED_STRING )
+    {
+        remap[ index ] = (uint32_t)strings.GetSize();
+        strings.Append( index );
+    }
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,108 @@
+// BFFTokenCache.h
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/BFF/Tokenizer/BFFToken.h"
+
+// Core
+#include "Core/Containers/Array.h"
+#include "Core/Env/Types.h"
+#include "Core/Strings/AString.h"
+
+// Forward Declarations
+//------------------------------------------------------------------------------
+class BFFTokenStringTable;
+class IOStream;
+
+// BFFTokenCache
+//------------------------------------------------------------------------------
+// Persists the output of the BFFTokenizer so unchanged files don't need to be
+// tokenized again.
+//
+// There is an Entry for each tokenized file, for each set of #defines it was
+// tokenized with. An Entry records the tokens from that file along with
+// everything the tokenization depended on or affected, in order:
+//  - #include (the included file has its own Entry)
+//  - #once
+//  - environment variables (#import and exists())
+//  - file_exists()
+//
+// An Entry can be used if the file contents and #defines match, and replaying
+// the recorded operations would take the same path as tokenizing the file.
+//------------------------------------------------------------------------------
+class BFFTokenCache
+{
+public:
+    enum OpType : uint8_t
+    {
+        OP_TOKENS           = 0, // m_Value: Number of tokens
+        OP_INCLUDE          = 1, // m_Value: Clean file name, m_Hash: macro hash
+        OP_INCLUDE_SKIPPED  = 2, // m_Value: Clean file name (skipped due to #once)
+        OP_ONCE             = 3, //
+        OP_ENV_VAR          = 4, // m_Value: Variable name, m_Hash: value hash (0 if missing)
+        OP_FILE_EXISTS      = 5, // m_Value: File name, m_Hash: 1 if exists
+    };
+
+    struct Op
+    {
+        OpType      m_Type;
+        uint32_t    m_Value; // Count or string index (see OpType)
+        uint64_t    m_Hash;
+    };
+
+    struct Token // Serialized as is
+    {
+        uint32_t        m_Value;        // String index
+        uint32_t        m_SourceOffset;
+        BFFTokenType    m_Type;
+        uint8_t         m_Padding[ 3 ];
+    };
+    static_assert( sizeof( Token ) == 12, "Unexpected padding" );
+
+    class Entry
+    {
+    public:
+        AString             m_FileName;
+        uint64_t            m_FileHash  = 0;
+        uint64_t            m_MacroHash = 0;
+        Array< Op >         m_Ops;
+        Array< Token >      m_Tokens;
+        Array< uint32_t >   m_Macros;   // Defines after tokenizing (string indices)
+        bool                m_Used      = false;
+    };
+
+    // Strings are stored in the supplied table
+    explicit BFFTokenCache( BFFTokenStringTable & strings );
+    ~BFFTokenCache();
+
+    bool Load( const AString & fileName );
+    bool Save( const AString & fileName ) const;
+
+    Entry * Find( const AString & fileName, uint64_t fileHash, uint64_t macroHash );
+    void    Add( Entry * entry ); // Takes ownership, replacing any existing entry
+
+    // Stats
+    void        RecordHit()                 { ++m_NumHits; }
+    uint32_t    GetNumHits() const          { return m_NumHits; }
+    uint32_t    GetNumMisses() const        { return m_NumMisses; }
+    bool        IsDirty() const             { return ( m_NumMisses > 0 ); }
+
+private:
+    bool Load( IOStream & stream );
+    void Save( IOStream & stream ) const;
+
+    enum : uint32_t { UNUSED_STRING = 0xFFFFFFFF };
+    static void UseString( uint32_t index, Array< uint32_t > & remap, Array< uint32_t > & strings );
+
+    BFFTokenStringTable &   m_Strings;
+    Array< Entry * >        m_Entries;
+    uint32_t                m_NumHits   = 0;
+    uint32_t                m_NumMisses = 0;
+
+    BFFTokenCache & operator = ( BFFTokenCache & other ) = delete;
+};
+
+//------------------------------------------------------------------------------
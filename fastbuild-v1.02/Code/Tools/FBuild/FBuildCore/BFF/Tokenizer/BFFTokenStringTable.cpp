@@ -0,0 +1,122 @@
+// BFFTokenStringTable.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "BFFTokenStringTable.h"
+
+// Core
+#include "Core/Math/xxHash.h"
+#include "Core/Mem/Mem.h"
+#include "Core/Strings/AString.h"
+
+#include <string.h>
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+BFFTokenStringTable::BFFTokenStringTable()
+    : m_Blocks( 0, true )
+    , m_Hashes( 0, true )
+    , m_HashTable( 0, true )
+    , m_Size( 0 )
+{
+    m_HashTable.SetSize( 1024 );
+    memset( m_HashTable.Begin(), 0, m_HashTable.GetSize() * sizeof( uint32_t ) );
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+BFFTokenStringTable::~BFFTokenStringTable()
+{
+    for ( AString * block : m_Blocks )
+    {
+        FDELETE_ARRAY( block );
+    }
+}
+
+// Add
+//------------------------------------------------------------------------------
+uint32_t BFFTokenStringTable::Add( const char * start, const char * end )
+{
+    const size_t len = (size_t)( end - start );
+    const uint32_t hash = xxHash::Calc32( start, len );
+
+    // Find existing
+    const uint32_t mask = (uint32_t)( m_HashTable.GetSize() - 1 );
+    uint32_t slot = ( hash & mask );
+    for ( ;; )
+    {
+        const uint32_t entry = m_HashTable[ slot ];
+        if ( entry == 0 )
+        {
+            break; // Not found
+        }
+        const uint32_t index = ( entry - 1 );
+        if ( m_Hashes[ index ] == hash )
+        {
+            const AString & existing = Get( index );
+            if ( ( existing.GetLength() == len ) && ( AString::StrNCmp( existing.Get(), start, len ) == 0 ) )
+            {
+                return index;
+            }
+        }
+        slot = ( ( slot + 1 ) & mask );
+    }
+
+    // Add new
+    const uint32_t index = m_Size;
+    if ( ( index % BLOCK_SIZE ) == 0 )
+    {
+        m_Blocks.Append( FNEW_ARRAY( AString[ BLOCK_SIZE ] ) );
+    }
+    m_Blocks.Top()[ index % BLOCK_SIZE ].Assign( start, end );
+    m_Hashes.Append( hash );
+    m_HashTable[ slot ] = ( index + 1 );
+    ++m_Size;
+
+    // Keep load factor below 50%
+    if ( ( m_Size * 2 ) > m_HashTable.GetSize() )
+    {
+        Grow();
+    }
+
+    return index;
+}
+
+// Add
+//------------------------------------------------------------------------------
+uint32_t BFFTokenStringTable::Add( const AString & string )
+{
+    return Add( string.Get(), string.GetEnd() );
+}
+
+// Get
+//------------------------------------------------------------------------------
+const AString & BFFTokenStringTable::Get( uint32_t index ) const
+{
+    ASSERT( index < m_Size );
+    return m_Blocks[ index / BLOCK_SIZE ][ index % BLOCK_SIZE ];
+}
+
+// Grow
+//------------------------------------------------------------------------------
+void BFFTokenStringTable::Grow()
+{
+    const size_t newSize = ( m_HashTable.GetSize() * 2 );
+    m_HashTable.SetSize( newSize );
+    memset( m_HashTable.Begin(), 0, newSize * sizeof( uint32_t ) );
+
+    // Re-insert all strings
+    const uint32_t mask = (uint32_t)( newSize - 1 );
+    for ( uint32_t index = 0; index < m_Size; ++index )
+    {
+        uint32_t slot = ( m_Hashes[ index ] & mask );
+        while ( m_HashTable[ slot ] != 0 )
+        {
+            slot = ( ( slot + 1 ) & mask );
+        }
+        m_HashTable[ slot ] = ( index + 1 );
+    }
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,45 @@
+// BFFTokenStringTable.h
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+// Core
+#include "Core/Containers/Array.h"
+#include "Core/Env/Types.h"
+
+// Forward Declarations
+//------------------------------------------------------------------------------
+class AString;
+
+// BFFTokenStringTable
+//------------------------------------------------------------------------------
+// Storage for token values. Each unique string is stored once, at a stable
+// address, so tokens can reference it instead of allocating their own copy.
+// Large configs repeat the same few strings (operators, brackets, commas and
+// common identifiers) many times.
+class BFFTokenStringTable
+{
+public:
+    BFFTokenStringTable();
+    ~BFFTokenStringTable();
+
+    // Find or add a string, returning its index
+    uint32_t        Add( const char * start, const char * end );
+    uint32_t        Add( const AString & string );
+
+    const AString & Get( uint32_t index ) const;
+    uint32_t        GetSize() const { return m_Size; }
+
+private:
+    void Grow();
+
+    enum : uint32_t { BLOCK_SIZE = 4096 }; // Strings per block
+
+    Array< AString * >  m_Blocks;       // Fixed size blocks so addresses are stable
+    Array< uint32_t >   m_Hashes;       // Hash of each string
+    Array< uint32_t >   m_HashTable;    // Open addressed, index + 1 (0 is empty)
+    uint32_t            m_Size;
+};
+
+//------------------------------------------------------------------------------
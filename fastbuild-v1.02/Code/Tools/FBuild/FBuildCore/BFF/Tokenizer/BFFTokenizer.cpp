@@ -12,10 +12,14 @@
 #include "Tools/FBuild/FBuildCore/BFF/Tokenizer/BFFTokenRange.h"
 #include "Tools/FBuild/FBuildCore/Error.h"
 #include "Tools/FBuild/FBuildCore/FBuild.h"
+#include "Tools/FBuild/FBuildCore/FLog.h"
 #include "Tools/FBuild/FBuildCore/Graph/NodeGraph.h"
 
 // Core
+#include "Core/Env/Env.h"
+#include "Core/FileIO/FileIO.h"
 #include "Core/FileIO/PathUtils.h"
+#include "Core/Math/xxHash.h"
 #include "Core/Strings/AStackString.h"
 #include "Core/Profile/Profile.h"
 
@@ -96,6 +100,13 @@ BFFTokenizer::~BFFTokenizer()
     {
         FDELETE( file );
     }
+
+    // Cleanup incomplete recordings (if tokenization failed)
+    for ( Recording & recording : m_Recordings )
+    {
+        FDELETE( recording.m_Entry );
+    }
+    FDELETE( m_Cache );
 }
 
 // TokenizeFromFile
@@ -112,27 +123,17 @@ bool BFFTokenizer::TokenizeFromFile( const AString & fileName, const BFFToken *
     NodeGraph::CleanPath( fileName, cleanFileName );
 
     // Have we seen this file before?
-    const BFFFile * fileToParse = nullptr;
-    for ( const BFFFile * previousInclude : m_Files )
+    const BFFFile * fileToParse = FindFile( cleanFileName );
+    if ( fileToParse )
     {
-        if ( PathUtils::ArePathsEqual( previousInclude->GetFileName(), cleanFileName ) )
+        // Already seen and should only be parsed once?
+        if ( fileToParse->IsParseOnce() )
         {
-            // Already seen and should only be parsed once?
-            if ( previousInclude->IsParseOnce() )
-            {
-                return true;
-            }
-
-            // Already included, but can be included again
-            fileToParse = previousInclude;
-            break;
+            return true;
         }
-    }
 
-    // Parse a previously seen file again?
-    if ( fileToParse )
-    {
-        return Tokenize( *fileToParse, fileToParse->GetSourceFileContents().Get(), fileToParse->GetSourceFileContents().GetEnd() );
+        // Already included, but can be included again
+        return Tokenize( fileToParse );
     }
 
     // A file seen for the first time
@@ -166,16 +167,67 @@ bool BFFTokenizer::TokenizeFromString( const AString & fileName, const AString &
     return Tokenize( newFile );
 }
 
+// LoadCache
+//------------------------------------------------------------------------------
+void BFFTokenizer::LoadCache( const AString & cacheFileName )
+{
+    ASSERT( m_Cache == nullptr );
+    ASSERT( m_Tokens.IsEmpty() ); // Must be enabled before tokenizing
+
+    m_CacheFileName = cacheFileName;
+    m_Cache = FNEW( BFFTokenCache( m_Strings ) );
+    m_Cache->Load( cacheFileName ); // Ok to fail (missing, old or corrupt cache)
+}
+
+// SaveCache
+//------------------------------------------------------------------------------
+bool BFFTokenizer::SaveCache() const
+{
+    // Anything new to save?
+    if ( ( m_Cache == nullptr ) || ( m_Cache->IsDirty() == false ) )
+    {
+        return true;
+    }
+
+    FLOG_VERBOSE( "BFF token cache: %u files re-used, %u files tokenized", m_Cache->GetNumHits(), m_Cache->GetNumMisses() );
+
+    if ( m_Cache->Save( m_CacheFileName ) == false )
+    {
+        FLOG_WARN( "Failed to save BFF token cache '%s'", m_CacheFileName.Get() );
+        return false;
+    }
+    return true;
+}
+
 // Tokenize
 //------------------------------------------------------------------------------
 bool BFFTokenizer::Tokenize( const BFFFile * file )
 {
     ASSERT( m_Files.Find( file ) );
 
+    // Re-use tokens from a previous run?
+    if ( m_Cache )
+    {
+        if ( TokenizeFromCache( *file ) )
+        {
+            return true;
+        }
+        BeginRecording( *file );
+    }
+
     // Tokenize the stream
     const char * pos = file->GetSourceFileContents().Get();
     const char * end = file->GetSourceFileContents().GetEnd();
-    return Tokenize( *file, pos, end );
+    if ( Tokenize( *file, pos, end ) == false )
+    {
+        return false; // Tokenize will have emitted an error
+    }
+
+    if ( m_Cache )
+    {
+        EndRecording();
+    }
+    return true;
 }
 
 // Tokenize
@@ -230,7 +282,7 @@ bool BFFTokenizer::Tokenize( const BFFFile & file, const char * pos, const char
             {
                 return false; // GetQuotedString will have emitted an error
             }
-            m_Tokens.EmplaceBack( file, tokenStart, BFFTokenType::String, string );
+            m_Tokens.EmplaceBack( file, tokenStart, BFFTokenType::String, GetSharedString( string ) );
             continue;
         }
 
@@ -250,7 +302,7 @@ bool BFFTokenizer::Tokenize( const BFFFile & file, const char * pos, const char
                      ( opString == "&&" ) ||
                      ( opString == "||" ) )
                 {
-                    m_Tokens.EmplaceBack( file, pos, BFFTokenType::Operator, pos, pos + 2 );
+                    m_Tokens.EmplaceBack( file, pos, BFFTokenType::Operator, GetSharedString( pos, pos + 2 ) );
                     pos += 2;
                     continue;
                 }
@@ -267,7 +319,7 @@ bool BFFTokenizer::Tokenize( const BFFFile & file, const char * pos, const char
             const bool isNegatedNumber = ( ( c == '-' ) && IsNumber( pos[ 1 ] ) );
             if ( isNegatedNumber == false )
             {
-                m_Tokens.EmplaceBack( file, tokenStart, BFFTokenType::Operator, pos, pos + 1 );
+                m_Tokens.EmplaceBack( file, tokenStart, BFFTokenType::Operator, GetSharedString( pos, pos + 1 ) );
                 pos++;
                 continue;
             }
@@ -283,7 +335,7 @@ bool BFFTokenizer::Tokenize( const BFFFile & file, const char * pos, const char
             {
                 ++pos;
             }
-            m_Tokens.EmplaceBack( file, tokenStart, BFFTokenType::Number, tokenStart, pos );
+            m_Tokens.EmplaceBack( file, tokenStart, BFFTokenType::Number, GetSharedString( tokenStart, pos ) );
             continue;
         }
 
@@ -291,14 +343,14 @@ bool BFFTokenizer::Tokenize( const BFFFile & file, const char * pos, const char
         if ( IsComma( c ) )
         {
             ++pos;
-            m_Tokens.EmplaceBack( file, tokenStart, BFFTokenType::Comma, tokenStart, pos );
+            m_Tokens.EmplaceBack( file, tokenStart, BFFTokenType::Comma, GetSharedString( tokenStart, pos ) );
             continue;
         }
 
         // Round Brackets?
         if ( ( c == '(' ) || ( c == ')' ) )
         {
-            m_Tokens.EmplaceBack( file, tokenStart, BFFTokenType::RoundBracket, pos, pos + 1 );
+            m_Tokens.EmplaceBack( file, tokenStart, BFFTokenType::RoundBracket, GetSharedString( pos, pos + 1 ) );
             pos++;
             continue;
         }
@@ -306,7 +358,7 @@ bool BFFTokenizer::Tokenize( const BFFFile & file, const char * pos, const char
         // Curly Brackets?
         if ( ( c == '{' ) || ( c == '}' ) )
         {
-            m_Tokens.EmplaceBack( file, tokenStart, BFFTokenType::CurlyBracket, pos, pos + 1 );
+            m_Tokens.EmplaceBack( file, tokenStart, BFFTokenType::CurlyBracket, GetSharedString( pos, pos + 1 ) );
             pos++;
             continue;
         }
@@ -314,7 +366,7 @@ bool BFFTokenizer::Tokenize( const BFFFile & file, const char * pos, const char
         // Square Brackets?
         if ( ( c == '[' ) || ( c == ']' ) )
         {
-            m_Tokens.EmplaceBack( file, tokenStart, BFFTokenType::SquareBracket, pos, pos + 1 );
+            m_Tokens.EmplaceBack( file, tokenStart, BFFTokenType::SquareBracket, GetSharedString( pos, pos + 1 ) );
             pos++;
             continue;
         }
@@ -335,7 +387,7 @@ bool BFFTokenizer::Tokenize( const BFFFile & file, const char * pos, const char
         return false;
     }
 
-    m_Tokens.EmplaceBack( file, end, BFFTokenType::EndOfFile, AString::GetEmpty() );
+    m_Tokens.EmplaceBack( file, end, BFFTokenType::EndOfFile, &AString::GetEmpty() );
     return true;
 }
 
@@ -365,12 +417,12 @@ bool BFFTokenizer::HandleIdentifier( const char * & pos, const char * /*end*/, c
     // - Booleans
     if ( identifier == BFF_KEYWORD_TRUE )
     {
-        m_Tokens.EmplaceBack( file, idStart, BFFTokenType::Boolean, true );
+        m_Tokens.EmplaceBack( file, idStart, BFFTokenType::Boolean, GetSharedString( identifier ) );
         return true;
     }
     if ( identifier == BFF_KEYWORD_FALSE )
     {
-        m_Tokens.EmplaceBack( file, idStart, BFFTokenType::Boolean, false );
+        m_Tokens.EmplaceBack( file, idStart, BFFTokenType::Boolean, GetSharedString( identifier ) );
         return true;
     }
 
@@ -388,19 +440,19 @@ bool BFFTokenizer::HandleIdentifier( const char * & pos, const char * /*end*/, c
          ( identifier == BFF_KEYWORD_ONCE ) ||
          ( identifier == BFF_KEYWORD_UNDEF ) )
     {
-        m_Tokens.EmplaceBack( file, idStart, BFFTokenType::Keyword, identifier );
+        m_Tokens.EmplaceBack( file, idStart, BFFTokenType::Keyword, GetSharedString( identifier ) );
         return true;
     }
 
     // - Functions
     if ( Function::Find( identifier ) )
     {
-        m_Tokens.EmplaceBack( file, idStart, BFFTokenType::Function, identifier );
+        m_Tokens.EmplaceBack( file, idStart, BFFTokenType::Function, GetSharedString( identifier ) );
         return true;
     }
 
     // Unspecified Identifier
-    m_Tokens.EmplaceBack( file, idStart, BFFTokenType::Identifier, identifier );
+    m_Tokens.EmplaceBack( file, idStart, BFFTokenType::Identifier, GetSharedString( identifier ) );
     return true;
 }
 
@@ -444,7 +496,7 @@ bool BFFTokenizer::HandleVariable( const char * & pos, const char * /*end*/, con
         return false;
     }
 
-    m_Tokens.EmplaceBack( file, variableStart, BFFTokenType::Variable, variableName );
+    m_Tokens.EmplaceBack( file, variableStart, BFFTokenType::Variable, GetSharedString( variableName ) );
     return true;
 }
 
@@ -776,6 +828,7 @@ bool BFFTokenizer::HandleDirective_IfExists( BFFTokenRange & iter, bool & outRes
     // TODO:C Move ImportEnvironmentVar to BFFTokenizer
     FBuild::Get().ImportEnvironmentVar( varName.Get(), optional, varValue, varHash );
     outResult = ( varHash != 0 ); // a hash of 0 means the env var was not found
+    RecordOp( BFFTokenCache::OP_ENV_VAR, varName, varHash );
     return true;
 }
 
@@ -814,6 +867,7 @@ bool BFFTokenizer::HandleDirective_IfFileExists( const BFFFile & file, BFFTokenR
 
     // check if file exists
     outResult = FBuild::Get().AddFileExistsCheck( includePath );
+    RecordOp( BFFTokenCache::OP_FILE_EXISTS, includePath, outResult ? 1 : 0 );
     return true;
 }
 
@@ -934,6 +988,7 @@ bool BFFTokenizer::HandleDirective_Import( const BFFFile & file, const char * &
             return false;
         }
     }
+    RecordOp( BFFTokenCache::OP_ENV_VAR, envVarToImport, varHash );
     argsIter++;
 
     // We must escape ^ and $ so they won't be interpretted as special chars
@@ -943,9 +998,9 @@ bool BFFTokenizer::HandleDirective_Import( const BFFFile & file, const char * &
     // Inject variable declaration
     AStackString<> varName( "." );
     varName += envVarToImport;
-    m_Tokens.EmplaceBack( file, pos, BFFTokenType::Variable, varName );
-    m_Tokens.EmplaceBack( file, pos, BFFTokenType::Operator, AStackString<>( "=" ) );
-    m_Tokens.EmplaceBack( file, pos, BFFTokenType::String, varValue );
+    m_Tokens.EmplaceBack( file, pos, BFFTokenType::Variable, GetSharedString( varName ) );
+    m_Tokens.EmplaceBack( file, pos, BFFTokenType::Operator, GetSharedString( AStackString<>( "=" ) ) );
+    m_Tokens.EmplaceBack( file, pos, BFFTokenType::String, GetSharedString( varValue ) );
 
     return true;
 }
@@ -958,7 +1013,7 @@ bool BFFTokenizer::HandleDirective_Include( const BFFFile & file, const char * &
 
     // Check include depth to detect cyclic includes
     m_Depth++;
-    if ( m_Depth >= 128 )
+    if ( m_Depth >= MAX_INCLUDE_DEPTH )
     {
         Error::Error_1035_ExcessiveDepthComplexity( argsIter.GetCurrent() );
         return false;
@@ -977,10 +1032,30 @@ bool BFFTokenizer::HandleDirective_Include( const BFFFile & file, const char * &
 
     ExpandIncludePath( file, include );
 
+    // Take note of the state the include depends on for the token cache
+    const bool recording = ( m_Recordings.IsEmpty() == false );
+    AStackString<> cleanInclude;
+    bool skipped = false;
+    uint64_t macroHash = 0;
+    if ( recording )
+    {
+        RecordTokens();
+        NodeGraph::CleanPath( include, cleanInclude );
+        const BFFFile * includeFile = FindFile( cleanInclude );
+        skipped = ( includeFile && includeFile->IsParseOnce() );
+        macroHash = m_Macros.GetHash();
+    }
+
     // Recursively tokenize
     const bool result = TokenizeFromFile( include, argsIter.GetCurrent() );
     argsIter++;
 
+    if ( result && recording )
+    {
+        RecordOp( skipped ? BFFTokenCache::OP_INCLUDE_SKIPPED : BFFTokenCache::OP_INCLUDE, cleanInclude, macroHash );
+        m_Recordings.Top().m_TokensStart = m_Tokens.GetSize(); // Tokens from the include are not ours
+    }
+
     --m_Depth;
 
     return result;
@@ -998,6 +1073,7 @@ bool BFFTokenizer::HandleDirective_Once( const BFFFile & file, const char * & /*
     ASSERT( file.IsParseOnce() == false ); // Shouldn't be parsing a second time
 
     file.SetParseOnce();
+    RecordOp( BFFTokenCache::OP_ONCE );
     return true;
 }
 
@@ -1133,4 +1209,328 @@ void BFFTokenizer::ExpandIncludePath( const BFFFile & file, AString & includePat
     }
 }
 
+// FindFile
+//------------------------------------------------------------------------------
+const BFFFile * BFFTokenizer::FindFile( const AString & cleanFileName ) const
+{
+    for ( const BFFFile * file : m_Files )
+    {
+        if ( PathUtils::ArePathsEqual( file->GetFileName(), cleanFileName ) )
+        {
+            return file;
+        }
+    }
+    return nullptr;
+}
+
+// GetSharedString
+//------------------------------------------------------------------------------
+const AString * BFFTokenizer::GetSharedString( const char * start, const char * end )
+{
+    return &m_Strings.Get( m_Strings.Add( start, end ) );
+}
+
+// TokenizeFromCache
+//------------------------------------------------------------------------------
+bool BFFTokenizer::TokenizeFromCache( const BFFFile & file )
+{
+    BFFTokenCache::Entry * entry = m_Cache->Find( file.GetFileName(), file.GetHash(), m_Macros.GetHash() );
+    if ( entry == nullptr )
+    {
+        return false;
+    }
+
+    // Check nothing the entry depends on has changed before modifying any state
+    CacheState state;
+    if ( ValidateCacheEntry( *entry, file, m_Depth, state ) == false )
+    {
+        for ( BFFFile * loadedFile : state.m_LoadedFiles )
+        {
+            FDELETE( loadedFile );
+        }
+        return false;
+    }
+
+    m_Tokens.SetCapacity( m_Tokens.GetSize() + state.m_NumTokens );
+    ReplayCacheEntry( *entry, file, state );
+    ASSERT( state.m_LoadedFiles.IsEmpty() ); // All should now be owned by m_Files
+    return true;
+}
+
+// ValidateCacheEntry
+//------------------------------------------------------------------------------
+bool BFFTokenizer::ValidateCacheEntry( const BFFTokenCache::Entry & entry, const BFFFile & file, uint32_t depth, CacheState & state )
+{
+    state.m_NumTokens += entry.m_Tokens.GetSize();
+
+    for ( const BFFTokenCache::Op & op : entry.m_Ops )
+    {
+        switch ( op.m_Type )
+        {
+            case BFFTokenCache::OP_TOKENS:
+            {
+                break;
+            }
+            case BFFTokenCache::OP_INCLUDE:
+            case BFFTokenCache::OP_INCLUDE_SKIPPED:
+            {
+                if ( ( depth + 1 ) >= MAX_INCLUDE_DEPTH )
+                {
+                    return false; // Tokenizing will report the error
+                }
+
+                // Find the file, if already loaded
+                const AString & fileName = m_Strings.Get( op.m_Value );
+                const BFFFile * includeFile = FindFile( fileName );
+                if ( includeFile == nullptr )
+                {
+                    for ( const BFFFile * loadedFile : state.m_LoadedFiles )
+                    {
+                        if ( PathUtils::ArePathsEqual( loadedFile->GetFileName(), fileName ) )
+                        {
+                            includeFile = loadedFile;
+                            break;
+                        }
+                    }
+                }
+
+                // Must be skipped (or not) due to #once as it was before
+                const bool once = ( includeFile && ( includeFile->IsParseOnce() || state.m_OnceFiles.Find( includeFile ) ) );
+                if ( once != ( op.m_Type == BFFTokenCache::OP_INCLUDE_SKIPPED ) )
+                {
+                    return false;
+                }
+                if ( once )
+                {
+                    break;
+                }
+
+                // Load the file to check its contents
+                if ( includeFile == nullptr )
+                {
+                    if ( FileIO::FileExists( fileName.Get() ) == false )
+                    {
+                        return false; // Tokenizing will report the error
+                    }
+                    BFFFile * newFile = FNEW( BFFFile() );
+                    state.m_LoadedFiles.Append( newFile );
+                    if ( newFile->Load( fileName, nullptr ) == false )
+                    {
+                        return false;
+                    }
+                    includeFile = newFile;
+                }
+
+                const BFFTokenCache::Entry * includeEntry = m_Cache->Find( fileName, includeFile->GetHash(), op.m_Hash );
+                if ( ( includeEntry == nullptr ) ||
+                     ( ValidateCacheEntry( *includeEntry, *includeFile, depth + 1, state ) == false ) )
+                {
+                    return false;
+                }
+                break;
+            }
+            case BFFTokenCache::OP_ONCE:
+            {
+                state.m_OnceFiles.Append( &file );
+                break;
+            }
+            case BFFTokenCache::OP_ENV_VAR:
+            {
+                // a hash of 0 means the env var was not found
+                AStackString<> value;
+                const uint32_t hash = Env::GetEnvVariable( m_Strings.Get( op.m_Value ).Get(), value ) ? xxHash::Calc32( value ) : 0;
+                if ( hash != op.m_Hash )
+                {
+                    return false;
+                }
+                break;
+            }
+            case BFFTokenCache::OP_FILE_EXISTS:
+            {
+                if ( FileIO::FileExists( m_Strings.Get( op.m_Value ).Get() ) != ( op.m_Hash != 0 ) )
+                {
+                    return false;
+                }
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+// ReplayCacheEntry
+//------------------------------------------------------------------------------
+void BFFTokenizer::ReplayCacheEntry( BFFTokenCache::Entry & entry, const BFFFile & file, CacheState & state )
+{
+    const char * contents = file.GetSourceFileContents().Get();
+    const BFFTokenCache::Token * token = entry.m_Tokens.Begin();
+
+    for ( const BFFTokenCache::Op & op : entry.m_Ops )
+    {
+        switch ( op.m_Type )
+        {
+            case BFFTokenCache::OP_TOKENS:
+            {
+                for ( uint32_t i = 0; i < op.m_Value; ++i )
+                {
+                    ASSERT( token->m_SourceOffset <= file.GetSourceFileContents().GetLength() );
+                    m_Tokens.EmplaceBack( file, contents + token->m_SourceOffset, token->m_Type, &m_Strings.Get( token->m_Value ) );
+                    ++token;
+                }
+                break;
+            }
+            case BFFTokenCache::OP_INCLUDE:
+            {
+                // Take ownership of files loaded during validation
+                const AString & fileName = m_Strings.Get( op.m_Value );
+                const BFFFile * includeFile = FindFile( fileName );
+                if ( includeFile == nullptr )
+                {
+                    for ( BFFFile * & loadedFile : state.m_LoadedFiles )
+                    {
+                        if ( PathUtils::ArePathsEqual( loadedFile->GetFileName(), fileName ) )
+                        {
+                            m_Files.Append( loadedFile );
+                            includeFile = loadedFile;
+                            state.m_LoadedFiles.Erase( &loadedFile );
+                            break;
+                        }
+                    }
+                }
+                ASSERT( includeFile );
+
+                BFFTokenCache::Entry * includeEntry = m_Cache->Find( fileName, includeFile->GetHash(), op.m_Hash );
+                ASSERT( includeEntry );
+                ++m_Depth;
+                ReplayCacheEntry( *includeEntry, *includeFile, state );
+                --m_Depth;
+                break;
+            }
+            case BFFTokenCache::OP_INCLUDE_SKIPPED:
+            {
+                break;
+            }
+            case BFFTokenCache::OP_ONCE:
+            {
+                file.SetParseOnce();
+                break;
+            }
+            case BFFTokenCache::OP_ENV_VAR:
+            {
+                // Register the dependency as tokenizing would
+                if ( FBuild::IsValid() )
+                {
+                    AStackString<> value;
+                    uint32_t hash;
+                    FBuild::Get().ImportEnvironmentVar( m_Strings.Get( op.m_Value ).Get(), true, value, hash );
+                }
+                break;
+            }
+            case BFFTokenCache::OP_FILE_EXISTS:
+            {
+                // Register the dependency as tokenizing would
+                if ( FBuild::IsValid() )
+                {
+                    FBuild::Get().AddFileExistsCheck( m_Strings.Get( op.m_Value ) );
+                }
+                break;
+            }
+        }
+    }
+    ASSERT( token == entry.m_Tokens.End() );
+
+    // Restore defines as they were after tokenizing
+    Array< AString > macros( entry.m_Macros.GetSize(), false );
+    for ( const uint32_t macro : entry.m_Macros )
+    {
+        macros.Append( m_Strings.Get( macro ) );
+    }
+    m_Macros.SetTokens( macros );
+
+    entry.m_Used = true;
+    m_Cache->RecordHit();
+}
+
+// BeginRecording
+//------------------------------------------------------------------------------
+void BFFTokenizer::BeginRecording( const BFFFile & file )
+{
+    BFFTokenCache::Entry * entry = FNEW( BFFTokenCache::Entry );
+    entry->m_FileName = file.GetFileName();
+    entry->m_FileHash = file.GetHash();
+    entry->m_MacroHash = m_Macros.GetHash();
+
+    Recording recording;
+    recording.m_Entry = entry;
+    recording.m_File = &file;
+    recording.m_TokensStart = m_Tokens.GetSize();
+    m_Recordings.Append( recording );
+}
+
+// EndRecording
+//------------------------------------------------------------------------------
+void BFFTokenizer::EndRecording()
+{
+    RecordTokens();
+
+    Recording & recording = m_Recordings.Top();
+    for ( const AString & macro : m_Macros.Tokens() )
+    {
+        recording.m_Entry->m_Macros.Append( m_Strings.Add( macro ) );
+    }
+    m_Cache->Add( recording.m_Entry ); // Cache takes ownership
+    m_Recordings.Pop();
+}
+
+// RecordTokens
+//------------------------------------------------------------------------------
+void BFFTokenizer::RecordTokens()
+{
+    Recording & recording = m_Recordings.Top();
+    const size_t numTokens = ( m_Tokens.GetSize() - recording.m_TokensStart );
+    if ( numTokens == 0 )
+    {
+        return;
+    }
+
+    BFFTokenCache::Entry & entry = *recording.m_Entry;
+    BFFTokenCache::Op op;
+    op.m_Type = BFFTokenCache::OP_TOKENS;
+    op.m_Value = (uint32_t)numTokens;
+    op.m_Hash = 0;
+    entry.m_Ops.Append( op );
+
+    const char * contents = recording.m_File->GetSourceFileContents().Get();
+    entry.m_Tokens.SetCapacity( entry.m_Tokens.GetSize() + numTokens );
+    for ( size_t i = recording.m_TokensStart; i < m_Tokens.GetSize(); ++i )
+    {
+        const BFFToken & token = m_Tokens[ i ];
+        ASSERT( &token.GetSourceFile() == recording.m_File );
+
+        BFFTokenCache::Token cacheToken;
+        cacheToken.m_Value = m_Strings.Add( token.GetValueString() );
+        cacheToken.m_SourceOffset = (uint32_t)( token.GetSourcePos() - contents );
+        cacheToken.m_Type = token.GetType();
+        cacheToken.m_Padding[ 0 ] = cacheToken.m_Padding[ 1 ] = cacheToken.m_Padding[ 2 ] = 0;
+        entry.m_Tokens.Append( cacheToken );
+    }
+    recording.m_TokensStart = m_Tokens.GetSize();
+}
+
+// RecordOp
+//------------------------------------------------------------------------------
+void BFFTokenizer::RecordOp( BFFTokenCache::OpType type, const AString & value, uint64_t hash )
+{
+    if ( m_Recordings.IsEmpty() )
+    {
+        return;
+    }
+
+    BFFTokenCache::Op op;
+    op.m_Type = type;
+    op.m_Value = ( type == BFFTokenCache::OP_ONCE ) ? 0 : m_Strings.Add( value );
+    op.m_Hash = hash;
+    m_Recordings.Top().m_Entry->m_Ops.Append( op );
+}
+
 //------------------------------------------------------------------------------
@@ -7,6 +7,8 @@
 // FBuildCore
 #include "Tools/FBuild/FBuildCore/BFF/BFFMacros.h"
 #include "Tools/FBuild/FBuildCore/BFF/Tokenizer/BFFToken.h"
+#include "Tools/FBuild/FBuildCore/BFF/Tokenizer/BFFTokenCache.h"
+#include "Tools/FBuild/FBuildCore/BFF/Tokenizer/BFFTokenStringTable.h"
 
 // Core
 #include "Core/Containers/Array.h"
@@ -31,11 +33,18 @@ public:
     // Preocess from an buffer in memory (for tests)
     bool TokenizeFromString( const AString & fileName, const AString & fileContents );
 
+    // Re-use tokens from previous runs for unchanged files
+    void LoadCache( const AString & cacheFileName );
+    bool SaveCache() const;
+    const BFFTokenCache * GetCache() const { return m_Cache; }
+
     // Access results
     const Array<BFFToken> &     GetTokens() const { return m_Tokens; }
     const Array<BFFFile *> &    GetUsedFiles() const { return m_Files; }
 
 protected:
+    static const uint32_t MAX_INCLUDE_DEPTH = 128;
+
     bool Tokenize( const BFFFile * file );
     bool Tokenize( const BFFFile & file, const char * pos, const char * end );
 
@@ -59,6 +68,31 @@ protected:
     bool HandleDirective_Undef( const BFFFile & file, const char * & pos, const char * end, BFFTokenRange & argsIter );
 
     void ExpandIncludePath( const BFFFile & file, AString & includePath ) const;
+    const BFFFile * FindFile( const AString & cleanFileName ) const;
+    const AString * GetSharedString( const char * start, const char * end );
+    const AString * GetSharedString( const AString & string ) { return GetSharedString( string.Get(), string.GetEnd() ); }
+
+    // Token cache
+    struct CacheState
+    {
+        Array< BFFFile * >          m_LoadedFiles;  // Files loaded to validate entries
+        Array< const BFFFile * >    m_OnceFiles;    // Files which will be marked #once
+        size_t                      m_NumTokens = 0;
+    };
+    bool TokenizeFromCache( const BFFFile & file );
+    bool ValidateCacheEntry( const BFFTokenCache::Entry & entry, const BFFFile & file, uint32_t depth, CacheState & state );
+    void ReplayCacheEntry( BFFTokenCache::Entry & entry, const BFFFile & file, CacheState & state );
+    void BeginRecording( const BFFFile & file );
+    void EndRecording();
+    void RecordTokens();
+    void RecordOp( BFFTokenCache::OpType type, const AString & value = AString::GetEmpty(), uint64_t hash = 0 );
+
+    struct Recording
+    {
+        BFFTokenCache::Entry *  m_Entry;
+        const BFFFile *         m_File;
+        size_t                  m_TokensStart;  // First token not yet recorded
+    };
 
     struct IncludedFile
     {
@@ -71,6 +105,10 @@ protected:
     BFFMacros           m_Macros;
     uint32_t            m_Depth = 0;
     bool                m_ParsingDirective = false;
+    BFFTokenStringTable m_Strings;              // Token values
+    BFFTokenCache *     m_Cache = nullptr;
+    AString             m_CacheFileName;
+    Array<Recording>    m_Recordings;           // Files being tokenized into the cache
 };
 
 //------------------------------------------------------------------------------
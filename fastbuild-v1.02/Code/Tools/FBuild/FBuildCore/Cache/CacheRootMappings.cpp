@@ -0,0 +1,186 @@
+// CacheRootMappings
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "CacheRootMappings.h"
+
+// Core
+#include "Core/FileIO/PathUtils.h"
+#include "Core/Math/xxHash.h"
+#include "Core/Profile/Profile.h"
+
+// Defines
+//------------------------------------------------------------------------------
+#if defined( __WINDOWS__ )
+    #define ROOT_CHAR( c ) ( ( ( c >= 'A' ) && ( c <= 'Z' ) ) ? (char)( c + ( 'a' - 'A' ) ) : c )
+#else
+    #define ROOT_CHAR( c ) ( c )
+#endif
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+CacheRootMappings::CacheRootMappings() = default;
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+CacheRootMappings::~CacheRootMappings() = default;
+
+// ParseMapping
+//------------------------------------------------------------------------------
+/*static*/ bool CacheRootMappings::ParseMapping( const AString & mapping, AString & outRoot, AString & outName )
+{
+    // Paths can contain '=', but names can't
+    const char * equals = mapping.FindLast( '=' );
+    if ( ( equals == nullptr ) || ( equals == mapping.Get() ) || ( equals + 1 == mapping.GetEnd() ) )
+    {
+        return false;
+    }
+    outRoot.Assign( mapping.Get(), equals );
+    outName.Assign( equals + 1, mapping.GetEnd() );
+    return true;
+}
+
+// Add
+//------------------------------------------------------------------------------
+void CacheRootMappings::Add( const AString & root, const AString & name )
+{
+    Mapping mapping;
+    mapping.m_Root = root;
+    while ( mapping.m_Root.EndsWith( NATIVE_SLASH ) || mapping.m_Root.EndsWith( OTHER_SLASH ) )
+    {
+        mapping.m_Root.Trim( 0, 1 );
+    }
+    #if defined( __WINDOWS__ )
+        mapping.m_Root.ToLower();
+    #endif
+    mapping.m_Name = name;
+    if ( mapping.m_Root.IsEmpty() == false )
+    {
+        m_Mappings.Append( mapping );
+    }
+}
+
+// Normalize
+//------------------------------------------------------------------------------
+bool CacheRootMappings::Normalize( const char * begin, const char * end, AString & out ) const
+{
+    PROFILE_FUNCTION
+
+    out.Clear();
+    const char * copyFrom = begin;
+    const char * pos = begin;
+    while ( pos < end )
+    {
+        size_t matched = 0;
+        for ( const Mapping & mapping : m_Mappings )
+        {
+            matched = MatchRoot( pos, end, mapping.m_Root );
+            if ( matched )
+            {
+                if ( out.IsEmpty() )
+                {
+                    out.SetReserved( (size_t)( end - begin ) );
+                }
+                out.Append( copyFrom, (size_t)( pos - copyFrom ) );
+                out += mapping.m_Name;
+                break;
+            }
+        }
+        if ( matched )
+        {
+            pos += matched;
+            copyFrom = pos;
+            continue;
+        }
+        ++pos;
+    }
+
+    if ( copyFrom == begin )
+    {
+        return false; // no roots found
+    }
+    out.Append( copyFrom, (size_t)( end - copyFrom ) );
+    return true;
+}
+
+// Calc64
+//------------------------------------------------------------------------------
+uint64_t CacheRootMappings::Calc64( const void * data, size_t size ) const
+{
+    if ( m_Mappings.IsEmpty() == false )
+    {
+        const char * begin = static_cast< const char * >( data );
+        AString normalized;
+        if ( Normalize( begin, begin + size, normalized ) )
+        {
+            return xxHash::Calc64( normalized );
+        }
+    }
+    return xxHash::Calc64( data, size );
+}
+
+// Calc32
+//------------------------------------------------------------------------------
+uint32_t CacheRootMappings::Calc32( const AString & string ) const
+{
+    if ( m_Mappings.IsEmpty() == false )
+    {
+        AString normalized;
+        if ( Normalize( string.Get(), string.GetEnd(), normalized ) )
+        {
+            return xxHash::Calc32( normalized );
+        }
+    }
+    return xxHash::Calc32( string );
+}
+
+// MatchRoot
+//------------------------------------------------------------------------------
+/*static*/ size_t CacheRootMappings::MatchRoot( const char * pos, const char * end, const AString & root )
+{
+    const char * text = pos;
+    for ( const char * r = root.Get(); r < root.GetEnd(); ++r )
+    {
+        if ( text >= end )
+        {
+            return 0;
+        }
+        const char c = *r;
+        if ( ( c == NATIVE_SLASH ) || ( c == OTHER_SLASH ) )
+        {
+            if ( ( *text != NATIVE_SLASH ) && ( *text != OTHER_SLASH ) )
+            {
+                return 0;
+            }
+            // Backslashes are escaped in string literals and #line directives
+            if ( ( *text == '\\' ) && ( text + 1 < end ) && ( text[ 1 ] == '\\' ) )
+            {
+                ++text;
+            }
+            ++text;
+            continue;
+        }
+        if ( ROOT_CHAR( *text ) != c )
+        {
+            return 0;
+        }
+        ++text;
+    }
+
+    // Must match the whole of the last path component
+    if ( text < end )
+    {
+        const char c = *text;
+        if ( ( ( c >= 'a' ) && ( c <= 'z' ) ) ||
+             ( ( c >= 'A' ) && ( c <= 'Z' ) ) ||
+             ( ( c >= '0' ) && ( c <= '9' ) ) ||
+             ( c == '_' ) || ( c == '-' ) || ( c == '.' ) )
+        {
+            return 0;
+        }
+    }
+    return (size_t)( text - pos );
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,49 @@
+// CacheRootMappings - make cache keys independent of where code is checked out
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Containers/Array.h"
+#include "Core/Env/Types.h"
+#include "Core/Strings/AString.h"
+
+// CacheRootMappings
+//------------------------------------------------------------------------------
+// Preprocessed output and command lines contain absolute paths, so the same
+// code checked out in two places gets different cache keys. Each mapping
+// names a root (e.g. "C:\p4\ue4=UE4") and the root is replaced by its name
+// before hashing. Paths are matched with either slash (and the escaped
+// backslashes of #line directives), case-insensitively on Windows.
+//------------------------------------------------------------------------------
+class CacheRootMappings
+{
+public:
+    explicit CacheRootMappings();
+    ~CacheRootMappings();
+
+    // Split a "<root>=<name>" mapping
+    static bool ParseMapping( const AString & mapping, AString & outRoot, AString & outName );
+
+    void Add( const AString & root, const AString & name );
+    inline bool IsEmpty() const { return m_Mappings.IsEmpty(); }
+
+    // Replace roots in the text (returns false, leaving out empty, if there were none)
+    bool Normalize( const char * begin, const char * end, AString & out ) const;
+
+    // Hash as if roots had been replaced
+    uint64_t Calc64( const void * data, size_t size ) const;
+    uint32_t Calc32( const AString & string ) const;
+
+private:
+    static size_t MatchRoot( const char * pos, const char * end, const AString & root );
+
+    struct Mapping
+    {
+        AString m_Root;
+        AString m_Name;
+    };
+    Array< Mapping > m_Mappings;
+};
+
+//------------------------------------------------------------------------------
@@ -6,8 +6,10 @@
 #include "LightCache.h"
 
 // FBuildCore
+#include "Tools/FBuild/FBuildCore/FBuild.h"
 #include "Tools/FBuild/FBuildCore/Graph/NodeGraph.h"
 #include "Tools/FBuild/FBuildCore/Graph/ObjectNode.h"
+#include "Tools/FBuild/FBuildCore/Graph/SettingsNode.h"
 #include "Tools/FBuild/FBuildCore/Helpers/ProjectGeneratorBase.h"
 #include "Tools/FBuild/FBuildCore/FLog.h"
 
@@ -255,6 +257,7 @@ LightCache::LightCache()
     : m_IncludePaths( 32, true )
     , m_AllIncludedFiles( 2048, true )
     , m_IncludeStack( 32, true )
+    , m_QuoteIncludeFromParentOnly( false )
 {
 }
 
@@ -271,6 +274,8 @@ bool LightCache::Hash( ObjectNode * node,
 {
     PROFILE_FUNCTION
 
+    m_QuoteIncludeFromParentOnly = ( node->IsMSVC() == false );
+
     ProjectGeneratorBase::ExtractIncludePaths( compilerArgs,
                                                m_IncludePaths,
                                                false ); // escapeQuotes
@@ -307,9 +312,12 @@ bool LightCache::Hash( ObjectNode * node,
     const size_t numIncludes = m_AllIncludedFiles.GetSize();
     Array< uint64_t > hashes( numIncludes * 2, false );
     outIncludes.SetCapacity( numIncludes );
+    const CacheRootMappings & cacheRoots = FBuild::Get().GetSettings()->GetCacheRootMappings();
     for ( const IncludedFile * file : m_AllIncludedFiles )
     {
-        hashes.Append( file->m_FileNameHash ); // Filename can change compilation result
+        // Filename can change compilation result (but not where the root is)
+        hashes.Append( cacheRoots.IsEmpty() ? file->m_FileNameHash
+                                            : cacheRoots.Calc64( file->m_FileName.Get(), file->m_FileName.GetLength() ) );
         hashes.Append( file->m_ContentHash );
         outIncludes.Append( file->m_FileName );
     }
@@ -318,6 +326,17 @@ bool LightCache::Hash( ObjectNode * node,
     return true;
 }
 
+// GetContentHashes
+//------------------------------------------------------------------------------
+void LightCache::GetContentHashes( Array< uint64_t > & outHashes ) const
+{
+    outHashes.SetCapacity( m_AllIncludedFiles.GetSize() );
+    for ( const IncludedFile * file : m_AllIncludedFiles )
+    {
+        outHashes.Append( file->m_ContentHash );
+    }
+}
+
 // ClearCachedFiles
 //------------------------------------------------------------------------------
 /*static*/ void LightCache::ClearCachedFiles()
@@ -400,6 +419,13 @@ bool LightCache::ParseDirective( IncludedFile & file, const char * & pos )
     pos++;
     SkipWhitespace( pos );
 
+    // GCC/Clang extension which depends on where the includer was found
+    if ( AString::StrNCmp( pos, "include_next", 12 ) == 0 )
+    {
+        AddError( &file, pos, "Unsupported directive #include_next." );
+        return false;
+    }
+
     // Handle directives we understand and care about
     if ( AString::StrNCmp( pos, "include", 7 ) == 0 )
     {
@@ -766,6 +792,12 @@ const IncludedFile * LightCache::ProcessIncludeFromIncludeStack( const AString &
             return file;
         }
 
+        // GCC and Clang only search the directory of the including file
+        if ( m_QuoteIncludeFromParentOnly )
+        {
+            break;
+        }
+
         // Try the next level of include stack
         // TODO: Could optimize out extra checks if path is the same
     }
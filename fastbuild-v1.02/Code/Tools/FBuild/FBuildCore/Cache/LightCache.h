@@ -36,6 +36,9 @@ public:
     // Get text description of problem(s) if Hash() fails
     const AString & GetErrors() const { return m_Errors; }
 
+    // Content hashes of files returned by Hash(), in the same order
+    void GetContentHashes( Array< uint64_t > & outHashes ) const;
+
     static void ClearCachedFiles();
 
 protected:
@@ -71,6 +74,7 @@ protected:
     Array< const IncludedFile * >   m_IncludeStack;             // Stack of includes, for file relative checks
     Array< const IncludeDefine * >  m_IncludeDefines;           // Macros describing files to include
     AString                         m_Errors;                   // Did we encounter some code we couldn't parse?
+    bool                            m_QuoteIncludeFromParentOnly; // GCC/Clang don't search the whole include stack
 };
 
 //------------------------------------------------------------------------------
@@ -724,6 +724,14 @@
     FormatError( iter, 1504u, function, "CSAssembly requires a C# Compiler." );
 }
 
+// Error_1505_HeaderShippingIncompatibleWithCompiler
+//------------------------------------------------------------------------------
+/*static*/ void Error::Error_1505_HeaderShippingIncompatibleWithCompiler( const BFFToken * iter,
+                                                                          const Function * function )
+{
+    FormatError( iter, 1505u, function, "HeaderShipping only compatible with Clang and GCC Compilers." );
+}
+
 // Error_1999_UserError
 //------------------------------------------------------------------------------
 /*static*/ void Error::Error_1999_UserError( const BFFToken * iter,
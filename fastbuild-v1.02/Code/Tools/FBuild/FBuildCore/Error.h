@@ -221,6 +221,8 @@ public:
                                                               const Function * function );
     static void Error_1504_CSAssemblyRequiresACSharpCompiler( const BFFToken * iter,
                                                               const Function * function );
+    static void Error_1505_HeaderShippingIncompatibleWithCompiler( const BFFToken * iter,
+                                                                   const Function * function );
 
     // 1900-1999 : User-generate errors
     //------------------------------------------------------------------------------
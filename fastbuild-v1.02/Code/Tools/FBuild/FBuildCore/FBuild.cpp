@@ -16,7 +16,10 @@
 #include "Graph/NodeGraph.h"
 #include "Graph/NodeProxy.h"
 #include "Graph/SettingsNode.h"
+#include "Helpers/BuildMetrics.h"
+#include "Helpers/BuildTrace.h"
 #include "Helpers/CompilationDatabase.h"
+#include "Helpers/MonitorStream.h"
 #include "Helpers/Report.h"
 #include "Protocol/Client.h"
 #include "Protocol/Protocol.h"
@@ -34,6 +37,7 @@
 #include "Core/Mem/SmallBlockAllocator.h"
 #include "Core/Process/Atomic.h"
 #include "Core/Process/SystemMutex.h"
+#include "Core/Process/ThreadPool.h"
 #include "Core/Profile/Profile.h"
 #include "Core/Strings/AStackString.h"
 #include "Core/Tracing/Tracing.h"
@@ -58,6 +62,8 @@ FBuild::FBuild( const FBuildOptions & options )
     : m_DependencyGraph( nullptr )
     , m_JobQueue( nullptr )
     , m_Client( nullptr )
+    , m_ThreadPool( nullptr )
+    , m_NumParallelParseLoops( 0 )
     , m_Cache( nullptr )
     , m_LastProgressOutputTime( 0.0f )
     , m_LastProgressCalcTime( 0.0f )
@@ -87,6 +93,10 @@ FBuild::FBuild( const FBuildOptions & options )
     FLog::SetShowErrors( m_Options.m_ShowErrors );
     FLog::SetShowProgress( m_Options.m_ShowProgress );
     FLog::SetMonitorEnabled( m_Options.m_EnableMonitor );
+    if ( m_Options.m_EnableMonitorStream )
+    {
+        MonitorStream::Open( m_Options.m_MonitorStreamName.IsEmpty() ? MonitorStream::DEFAULT_NAME : m_Options.m_MonitorStreamName.Get() );
+    }
 
     Function::Create();
 
@@ -101,6 +111,8 @@ FBuild::~FBuild()
 
     Function::Destroy();
 
+    MonitorStream::Close();
+
     FDELETE m_DependencyGraph;
     FDELETE m_Client;
     FREE( m_EnvironmentString );
@@ -119,6 +131,7 @@ FBuild::~FBuild()
     }
 
     LightCache::ClearCachedFiles();
+    Node::ClearFileContentHashes();
 }
 
 // Initialize
@@ -163,6 +176,14 @@ bool FBuild::Initialize( const char * nodeGraphDBFile )
 
     SmallBlockAllocator::SetSingleThreadedMode( false );
 
+    // Helper threads are only created if the BFF was parsed
+    if ( m_ThreadPool )
+    {
+        m_NumParallelParseLoops = m_ThreadPool->GetNumParallelFors();
+        FDELETE( m_ThreadPool );
+        m_ThreadPool = nullptr;
+    }
+
     if ( m_DependencyGraph == nullptr )
     {
         return false;
@@ -199,6 +220,24 @@ bool FBuild::Initialize( const char * nodeGraphDBFile )
     return true;
 }
 
+// CreateThreadPool
+//------------------------------------------------------------------------------
+void FBuild::CreateThreadPool()
+{
+    ASSERT( Thread::IsMainThread() );
+    ASSERT( m_ThreadPool == nullptr );
+
+    const uint32_t numParseThreads = Math::Min( Math::Max( m_Options.m_NumWorkerThreads, 1u ), Env::GetNumProcessors() );
+    if ( numParseThreads > 1 )
+    {
+        // Thread creation allocates, so leave single threaded mode while the
+        // helper threads start (the pool waits for them)
+        SmallBlockAllocator::SetSingleThreadedMode( false );
+        m_ThreadPool = FNEW( ThreadPool( numParseThreads ) );
+        SmallBlockAllocator::SetSingleThreadedMode( true );
+    }
+}
+
 // Build
 //------------------------------------------------------------------------------
 bool FBuild::Build( const char* target )
@@ -369,6 +408,10 @@ bool FBuild::Build( Node * nodeToBuild )
     // create worker threads
     m_JobQueue = FNEW( JobQueue( m_Options.m_NumWorkerThreads ) );
 
+    // limit the combined memory of local jobs (only if requested, as recorded
+    // peaks are approximate and unavailable on some platforms)
+    m_JobQueue->GetMemoryBudget().SetBudget( (uint64_t)m_Options.m_MemoryBudgetMiB * MEGABYTE );
+
     // create the connection management system if needed
     // (must be after JobQueue is created)
     if ( m_Options.m_AllowDistributed )
@@ -394,8 +437,16 @@ bool FBuild::Build( Node * nodeToBuild )
         }
         else
         {
-            OUTPUT( "Distributed Compilation : %u Workers in pool '%s'\n", (uint32_t)workers.GetSize(), m_WorkerBrokerage.GetBrokerageRootPaths().Get() );
-            m_Client = FNEW( Client( workers, m_Options.m_DistributionPort, settings->GetWorkerConnectionLimit(), m_Options.m_DistVerbose ) );
+            const bool fromBroker = m_WorkerBrokerage.WorkersCameFromBroker();
+            if ( fromBroker )
+            {
+                OUTPUT( "Distributed Compilation : %u Workers from broker '%s'\n", (uint32_t)workers.GetSize(), m_WorkerBrokerage.GetBrokerAddress().Get() );
+            }
+            else
+            {
+                OUTPUT( "Distributed Compilation : %u Workers in pool '%s'\n", (uint32_t)workers.GetSize(), m_WorkerBrokerage.GetBrokerageRootPaths().Get() );
+            }
+            m_Client = FNEW( Client( workers, m_Options.m_DistributionPort, settings->GetWorkerConnectionLimit(), m_Options.m_DistVerbose, fromBroker ) );
         }
     }
 
@@ -405,6 +456,15 @@ bool FBuild::Build( Node * nodeToBuild )
     m_SmoothedProgressCurrent = 0.0f;
     m_SmoothedProgressTarget = 0.0f;
     FLog::StartBuild();
+    BuildMetrics::StartBuild();
+    if ( MonitorStream::IsEnabled() )
+    {
+        MonitorStream::StartBuild();
+    }
+    if ( m_Options.m_TraceFile.IsEmpty() == false )
+    {
+        BuildTrace::Start();
+    }
 
     // create worker dir for main thread build case
     if ( m_Options.m_NumWorkerThreads == 0 )
@@ -489,6 +549,29 @@ bool FBuild::Build( Node * nodeToBuild )
     m_JobQueue = nullptr;
 
     FLog::StopBuild();
+    if ( MonitorStream::IsEnabled() )
+    {
+        MonitorStream::StopBuild();
+    }
+    if ( BuildTrace::IsEnabled() )
+    {
+        BuildTrace::Stop( m_Options.m_TraceFile );
+    }
+    BuildMetrics::StopBuild();
+    if ( m_Options.m_MetricsFile.IsEmpty() == false )
+    {
+        if ( BuildMetrics::WriteJSON( m_Options.m_MetricsFile ) == false )
+        {
+            FLOG_WARN( "Failed to write metrics file '%s'", m_Options.m_MetricsFile.Get() );
+        }
+    }
+    if ( m_Options.m_MetricsPrometheusFile.IsEmpty() == false )
+    {
+        if ( BuildMetrics::WritePrometheus( m_Options.m_MetricsPrometheusFile ) == false )
+        {
+            FLOG_WARN( "Failed to write metrics file '%s'", m_Options.m_MetricsPrometheusFile.Get() );
+        }
+    }
 
     // even if the build has failed, we can still save the graph.
     // This is desireable because:
@@ -629,7 +712,8 @@ void FBuild::UpdateBuildStatus( const Node * node )
 
     if ( FBuild::Get().GetOptions().m_ShowProgress == false )
     {
-        if ( FBuild::Get().GetOptions().m_EnableMonitor == false )
+        if ( ( FBuild::Get().GetOptions().m_EnableMonitor == false ) &&
+             ( MonitorStream::IsEnabled() == false ) )
         {
             return;
         }
@@ -685,6 +769,10 @@ void FBuild::UpdateBuildStatus( const Node * node )
     }
 
     FLOG_MONITOR( "PROGRESS_STATUS %f \n", (double)m_SmoothedProgressCurrent );
+    if ( MonitorStream::IsEnabled() )
+    {
+        MonitorStream::Progress( m_SmoothedProgressCurrent );
+    }
 
     m_LastProgressOutputTime = timeNow;
 }
@@ -732,6 +820,7 @@ void FBuild::DisplayTargetList( bool showHidden ) const
             case Node::XCODEPROJECT_NODE:   break;
             case Node::SETTINGS_NODE:       break;
             case Node::TEXT_FILE_NODE:      displayName = true; hidden = node->IsHidden(); break;
+            case Node::LINK_PREP_NODE:      break;
             case Node::NUM_NODE_TYPES:      ASSERT( false );                        break;
         }
         if ( displayName && ( !hidden || showHidden ) )
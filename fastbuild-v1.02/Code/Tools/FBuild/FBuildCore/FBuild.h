@@ -26,6 +26,7 @@ class IOStream;
 class JobQueue;
 class Node;
 class NodeGraph;
+class ThreadPool;
 
 // FBuild
 //------------------------------------------------------------------------------
@@ -104,6 +105,11 @@ public:
 
     inline ICache * GetCache() const { return m_Cache; }
 
+    // Helper threads for CPU heavy work while parsing the BFF (nullptr otherwise)
+    void CreateThreadPool();
+    inline ThreadPool * GetThreadPool() const { return m_ThreadPool; }
+    inline uint32_t GetNumParallelParseLoops() const { return m_NumParallelParseLoops; }
+
     static bool GetTempDir( AString & outTempDir );
 
     bool CacheOutputInfo() const;
@@ -120,6 +126,8 @@ protected:
     NodeGraph * m_DependencyGraph;
     JobQueue * m_JobQueue;
     Client * m_Client; // manage connections to worker servers
+    ThreadPool * m_ThreadPool; // only valid while parsing the BFF
+    uint32_t m_NumParallelParseLoops;
 
     AString m_DependencyGraphFile;
     ICache * m_Cache;
@@ -232,11 +232,97 @@ FBuildOptions::OptionsResult FBuildOptions::ProcessCommandLine( int argc, char *
                     continue; // 'numWorkers' will contain value now
                 }
             }
+            else if ( thisArg == "-memorybudget" )
+            {
+                const int sizeIndex = ( i + 1 );
+                PRAGMA_DISABLE_PUSH_MSVC( 4996 ) // This function or variable may be unsafe...
+                if ( ( sizeIndex >= argc ) ||
+                     ( sscanf( argv[ sizeIndex ], "%i", &m_MemoryBudgetMiB ) ) != 1 || // TODO:C Consider using sscanf_s
+                     ( m_MemoryBudgetMiB < 0 ) )
+                PRAGMA_DISABLE_POP_MSVC // 4996
+                {
+                    OUTPUT( "FBuild: Error: Missing or bad <sizeMiB> for '-memorybudget' argument\n" );
+                    OUTPUT( "Try \"%s -help\"\n", programName.Get() );
+                    return OPTIONS_ERROR;
+                }
+                i++; // skip extra arg we've consumed
+
+                // add to args we might pass to subprocess
+                m_Args += ' ';
+                m_Args += argv[ sizeIndex ];
+                continue;
+            }
+            else if ( thisArg == "-metrics" )
+            {
+                int pathIndex = ( i + 1 );
+                if ( pathIndex >= argc )
+                {
+                    OUTPUT( "FBuild: Error: Missing <file> for '-metrics' argument\n" );
+                    OUTPUT( "Try \"%s -help\"\n", programName.Get() );
+                    return OPTIONS_ERROR;
+                }
+                m_MetricsFile = argv[ pathIndex ];
+                i++; // skip extra arg we've consumed
+
+                // add to args we might pass to subprocess
+                m_Args += ' ';
+                m_Args += '"'; // surround file with quotes to avoid problems with spaces in the path
+                m_Args += m_MetricsFile;
+                m_Args += '"';
+                continue;
+            }
+            else if ( thisArg == "-metricsprom" )
+            {
+                int pathIndex = ( i + 1 );
+                if ( pathIndex >= argc )
+                {
+                    OUTPUT( "FBuild: Error: Missing <file> for '-metricsprom' argument\n" );
+                    OUTPUT( "Try \"%s -help\"\n", programName.Get() );
+                    return OPTIONS_ERROR;
+                }
+                m_MetricsPrometheusFile = argv[ pathIndex ];
+                i++; // skip extra arg we've consumed
+
+                // add to args we might pass to subprocess
+                m_Args += ' ';
+                m_Args += '"'; // surround file with quotes to avoid problems with spaces in the path
+                m_Args += m_MetricsPrometheusFile;
+                m_Args += '"';
+                continue;
+            }
             else if ( thisArg == "-monitor" )
             {
                 m_EnableMonitor = true;
                 continue;
             }
+            else if ( thisArg == "-monitorstream" )
+            {
+                m_EnableMonitorStream = true;
+                continue;
+            }
+            else if ( thisArg == "-monitorstreamname" )
+            {
+                int nameIndex = ( i + 1 );
+                if ( nameIndex >= argc )
+                {
+                    OUTPUT( "FBuild: Error: Missing <name> for '-monitorstreamname' argument\n" );
+                    OUTPUT( "Try \"%s -help\"\n", programName.Get() );
+                    return OPTIONS_ERROR;
+                }
+                m_EnableMonitorStream = true; // implied
+                m_MonitorStreamName = argv[ nameIndex ];
+                i++; // skip extra arg we've consumed
+
+                // add to args we might pass to subprocess
+                m_Args += ' ';
+                m_Args += m_MonitorStreamName;
+                continue;
+            }
+            else if ( thisArg == "-nobffcache" )
+            {
+                m_UseBFFTokenCache = false;
+                continue;
+            }
             else if (thisArg == "-nolocalrace")
             {
                 m_AllowLocalRace = false;
@@ -323,6 +409,25 @@ FBuildOptions::OptionsResult FBuildOptions::ProcessCommandLine( int argc, char *
                 m_ShowSummary = true;
                 continue;
             }
+            else if ( thisArg == "-trace" )
+            {
+                int pathIndex = ( i + 1 );
+                if ( pathIndex >= argc )
+                {
+                    OUTPUT( "FBuild: Error: Missing <file> for '-trace' argument\n" );
+                    OUTPUT( "Try \"%s -help\"\n", programName.Get() );
+                    return OPTIONS_ERROR;
+                }
+                m_TraceFile = argv[ pathIndex ];
+                i++; // skip extra arg we've consumed
+
+                // add to args we might pass to subprocess
+                m_Args += ' ';
+                m_Args += '"'; // surround file with quotes to avoid problems with spaces in the path
+                m_Args += m_TraceFile;
+                m_Args += '"';
+                continue;
+            }
             else if ( thisArg == "-verbose" )
             {
                 m_ShowVerbose = true;
@@ -549,7 +654,18 @@ void FBuildOptions::DisplayHelp( const AString & programName ) const
             "                   -wrapper (Windows)\n"
             " -j<x>             Explicitly set LOCAL worker thread count X, instead of\n"
             "                   default of hardware thread count.\n"
+            " -memorybudget <size>\n"
+            "                   Limit combined peak memory (from previous builds) of\n"
+            "                   local jobs to <size> MiB. (default: 0, no limit)\n"
+            " -metrics <file>   Write phase timing metrics for the build to <file> (JSON).\n"
+            " -metricsprom <file>\n"
+            "                   Write phase timing metrics for the build to <file>\n"
+            "                   (Prometheus text format).\n"
             " -monitor          Emit a machine-readable file while building.\n"
+            " -monitorstream    Publish machine-readable build events to shared memory.\n"
+            " -monitorstreamname <name>\n"
+            "                   Publish build events under <name>. Implies -monitorstream.\n"
+            " -nobffcache       Don't re-use tokens from unchanged bff files.\n"
             " -nolocalrace      Disable local race of remotely started jobs.\n"
             " -noprogress       Don't show the progress bar while building.\n"
             " -nounity          (Experimental) Build files individually, ignoring Unity.\n"
@@ -565,6 +681,7 @@ void FBuildOptions::DisplayHelp( const AString & programName ) const
             " -showtargets      Display primary targets, excluding those marked \"Hidden\".\n"
             " -showalltargets   Display primary targets, including those marked \"Hidden\".\n"
             " -summary          Show a summary at the end of the build.\n"
+            " -trace <file>     Write a Chrome/Perfetto trace of all jobs to <file>.\n"
             " -verbose          Show detailed diagnostic info. (Increases built time)\n"
             " -version          Print version and exit.\n"
             " -vs               VisualStudio mode. Same as -ide.\n"
@@ -88,14 +88,21 @@ public:
     bool        m_GenerateReport                    = false;
     bool        m_GenerateGsReport                  = false;
     bool        m_EnableMonitor                     = false;
+    bool        m_EnableMonitorStream               = false;
+    AString     m_MonitorStreamName; // Shared memory name for -monitorstream (default if empty)
+    AString     m_TraceFile; // Chrome/Perfetto trace of all jobs (if not empty)
+    AString     m_MetricsFile; // JSON phase metrics (if not empty)
+    AString     m_MetricsPrometheusFile; // Prometheus text format phase metrics (if not empty)
 
     // DB loading/saving
     bool        m_SaveDBOnCompletion                = false;
     bool        m_FixupErrorPaths                   = false;
     bool        m_ForceDBMigration_Debug            = false; // Force migration even if bff has not changed (for tests)
     bool        m_ContinueAfterDBMove               = false;
+    bool        m_UseBFFTokenCache                  = true;
 
     uint32_t    m_NumWorkerThreads                  = 0; // True default detected in constructor
+    int32_t     m_MemoryBudgetMiB                   = 0; // Limit for combined memory of local jobs (0 = unlimited)
     AString     m_ConfigFile;
 
     inline uint32_t GetWorkingDirHash() const                   { return m_WorkingDirHash; }
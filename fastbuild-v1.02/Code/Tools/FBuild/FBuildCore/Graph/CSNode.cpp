@@ -12,6 +12,7 @@
 #include "Tools/FBuild/FBuildCore/Graph/DirectoryListNode.h"
 #include "Tools/FBuild/FBuildCore/Helpers/Args.h"
 #include "Tools/FBuild/FBuildCore/Helpers/ResponseFile.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/Job.h"
 
 #include "Core/Env/ErrorFormat.h"
 #include "Core/FileIO/FileIO.h"
@@ -206,6 +207,7 @@ CSNode::~CSNode() = default;
 
     // Get result
     int result = p.WaitForExit();
+    job->AddResourceUsage( p.GetPeakMemoryBytes(), p.GetCPUTimeUS() );
     if ( p.HasAborted() )
     {
         return NODE_RESULT_FAILED;
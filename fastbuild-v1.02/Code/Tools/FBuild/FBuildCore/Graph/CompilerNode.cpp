@@ -33,6 +33,7 @@ REFLECT_NODE_BEGIN( CompilerNode, Node, MetaNone() )
     REFLECT( m_UseLightCache,       "UseLightCache_Experimental", MetaOptional() )
     REFLECT( m_UseRelativePaths,    "UseRelativePaths_Experimental", MetaOptional() )
     REFLECT( m_SourceMapping,       "SourceMapping_Experimental", MetaOptional() )
+    REFLECT( m_UseHeaderShipping,   "UseHeaderShipping_Experimental", MetaOptional() )
 
     // Internal
     REFLECT( m_CompilerFamilyEnum,  "CompilerFamilyEnum",   MetaHidden() )
@@ -54,6 +55,7 @@ CompilerNode::CompilerNode()
     , m_SimpleDistributionMode( false )
     , m_UseLightCache( false )
     , m_UseRelativePaths( false )
+    , m_UseHeaderShipping( false )
     , m_EnvironmentString( nullptr )
 {
 }
@@ -138,6 +140,14 @@ CompilerNode::CompilerNode()
         return false;
     }
 
+    // Header shipping relies on -fdebug-prefix-map/-fmacro-prefix-map to hide
+    // the worker's include root from the output
+    if ( m_UseHeaderShipping && ( m_CompilerFamilyEnum != CLANG ) && ( m_CompilerFamilyEnum != GCC ) )
+    {
+        Error::Error_1505_HeaderShippingIncompatibleWithCompiler( iter, function );
+        return false;
+    }
+
     m_Manifest.Initialize( m_ExecutableRootPath, m_StaticDependencies, m_CustomEnvironmentVariables );
 
     return true;
@@ -23,6 +23,7 @@ REFLECT_NODE_BEGIN( CopyDirNode, Node, MetaNone() )
     REFLECT_ARRAY(  m_SourcePathsPattern,       "SourcePathsPattern",       MetaOptional() )
     REFLECT_ARRAY(  m_SourceExcludePaths,       "SourceExcludePaths",       MetaOptional() + MetaPath() )
     REFLECT(        m_SourcePathsRecurse,       "SourcePathsRecurse",       MetaOptional() )
+    REFLECT(        m_AllowHardLinks,           "AllowHardLinks",           MetaOptional() )
     REFLECT_ARRAY(  m_PreBuildDependencyNames,  "PreBuildDependencies",     MetaOptional() + MetaFile() + MetaAllowNonFile() )
 REFLECT_END( CopyDirNode )
 
@@ -141,6 +142,7 @@ CopyDirNode::~CopyDirNode() = default;
                 CopyFileNode * copyFileNode = nodeGraph.CreateCopyFileNode( dstFile );
                 copyFileNode->m_Source = srcFileNode->GetName();
                 copyFileNode->m_PreBuildDependencyNames = preBuildDependencyNames; // inherit PreBuildDependencies
+                copyFileNode->m_AllowHardLinks = m_AllowHardLinks;
                 BFFToken * token = nullptr;
                 if ( !copyFileNode->Initialize( nodeGraph, token, nullptr ) )
                 {
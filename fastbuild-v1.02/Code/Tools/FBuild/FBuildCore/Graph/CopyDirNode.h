@@ -34,6 +34,7 @@ private:
     Array< AString >    m_SourcePathsPattern;
     Array< AString >    m_SourceExcludePaths;
     bool                m_SourcePathsRecurse = true;
+    bool                m_AllowHardLinks = false;
 
     Array< AString >    m_PreBuildDependencyNames;
 };
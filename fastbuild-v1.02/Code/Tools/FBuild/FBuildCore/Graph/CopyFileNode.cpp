@@ -9,11 +9,13 @@
 #include "Tools/FBuild/FBuildCore/FLog.h"
 #include "Tools/FBuild/FBuildCore/BFF/Functions/Function.h"
 #include "Tools/FBuild/FBuildCore/Graph/NodeGraph.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildMetrics.h"
 
 #include "Core/Env/ErrorFormat.h"
 #include "Core/FileIO/FileIO.h"
 #include "Core/FileIO/FileStream.h"
 #include "Core/Strings/AStackString.h"
+#include "Core/Time/Timer.h"
 
 // REFLECTION
 //------------------------------------------------------------------------------
@@ -21,6 +23,7 @@ REFLECT_NODE_BEGIN( CopyFileNode, Node, MetaNone() )
     REFLECT(        m_Source,                   "Source",                   MetaFile() )
     REFLECT(        m_Dest,                     "Dest",                     MetaPath() )
     REFLECT_ARRAY(  m_PreBuildDependencyNames,  "PreBuildDependencies",     MetaOptional() + MetaFile() + MetaAllowNonFile() )
+    REFLECT(        m_AllowHardLinks,           "AllowHardLinks",           MetaOptional() )
 REFLECT_END( CopyFileNode )
 
 // CONSTRUCTOR
@@ -61,13 +64,20 @@ CopyFileNode::~CopyFileNode() = default;
     EmitCopyMessage();
 
     // copy the file
-    if ( FileIO::FileCopy( GetSourceNode()->GetName().Get(), m_Name.Get() ) == false )
+    const int64_t startTime = Timer::GetNow();
+    FileIO::CopyMethod method;
+    if ( FileIO::FileCopyFast( GetSourceNode()->GetName().Get(), m_Name.Get(), m_AllowHardLinks, method ) == false )
     {
         FLOG_ERROR( "Copy failed. Error: %s Target: '%s'", LAST_ERROR_STR, GetName().Get() );
         return NODE_RESULT_FAILED; // copy failed
     }
+    FileIO::FileInfo dstInfo;
+    const uint64_t size = FileIO::GetFileInfo( m_Name, dstInfo ) ? dstInfo.m_Size : 0;
+    BuildMetrics::RecordTicks( (BuildMetrics::Metric)( BuildMetrics::METRIC_COPY_REFLINK + method ), ( Timer::GetNow() - startTime ), size );
 
-    if ( FileIO::SetReadOnly( m_Name.Get(), false ) == false )
+    // A hard link shares its attributes with the source, which is left alone
+    if ( ( method != FileIO::COPY_METHOD_HARDLINK ) &&
+         ( FileIO::SetReadOnly( m_Name.Get(), false ) == false ) )
     {
         FLOG_ERROR( "Copy read-only flag set failed. Error: %s Target: '%s'", LAST_ERROR_STR, GetName().Get() );
         return NODE_RESULT_FAILED; // failed to remove read-only
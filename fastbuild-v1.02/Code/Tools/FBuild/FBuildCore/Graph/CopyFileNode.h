@@ -34,6 +34,7 @@ private:
     AString             m_Source;
     AString             m_Dest;
     Array< AString >    m_PreBuildDependencyNames;
+    bool                m_AllowHardLinks = false;
 };
 
 //------------------------------------------------------------------------------
@@ -6,15 +6,20 @@
 #include "ExecNode.h"
 
 #include "Tools/FBuild/FBuildCore/BFF/Functions/Function.h"
+#include "Tools/FBuild/FBuildCore/Cache/ICache.h"
 #include "Tools/FBuild/FBuildCore/FBuild.h"
 #include "Tools/FBuild/FBuildCore/FLog.h"
 #include "Tools/FBuild/FBuildCore/Graph/NodeGraph.h"
 #include "Tools/FBuild/FBuildCore/Graph/DirectoryListNode.h"
+#include "Tools/FBuild/FBuildCore/Graph/SettingsNode.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/Job.h"
 
 #include "Core/Env/ErrorFormat.h"
 #include "Core/FileIO/FileIO.h"
 #include "Core/FileIO/FileStream.h"
 #include "Core/Math/Conversions.h"
+#include "Core/Math/xxHash.h"
+#include "Core/Profile/Profile.h"
 #include "Core/Strings/AStackString.h"
 #include "Core/Process/Process.h"
 
@@ -35,6 +40,8 @@ REFLECT_NODE_BEGIN( ExecNode, Node, MetaName( "ExecOutput" ) + MetaFile() )
     REFLECT(        m_ExecAlwaysShowOutput,     "ExecAlwaysShowOutput",     MetaOptional() )
     REFLECT(        m_ExecUseStdOutAsOutput,    "ExecUseStdOutAsOutput",    MetaOptional() )
     REFLECT(        m_ExecAlways,               "ExecAlways",               MetaOptional() )
+    REFLECT(        m_ExecCacheable,            "ExecCacheable",            MetaOptional() )
+    REFLECT_ARRAY(  m_ExecExtraOutputs,         "ExecExtraOutputs",         MetaOptional() + MetaFile() )
     REFLECT_ARRAY(  m_PreBuildDependencyNames,  "PreBuildDependencies",     MetaOptional() + MetaFile() + MetaAllowNonFile() )
 
     // Internal State
@@ -50,6 +57,7 @@ ExecNode::ExecNode()
     , m_ExecUseStdOutAsOutput( false )
     , m_ExecAlways( false )
     , m_ExecInputPathRecurse( true )
+    , m_ExecCacheable( false )
     , m_NumExecInputFiles( 0 )
 {
     m_Type = EXEC_NODE;
@@ -179,6 +187,19 @@ ExecNode::~ExecNode() = default;
     AStackString< 4 * KILOBYTE > fullArgs;
     GetFullArgs(fullArgs);
 
+    // Restore the outputs if this has run before
+    AStackString<> cacheName;
+    Array< AString > cacheFileNames;
+    const bool useCache = ShouldUseCache() && GetCacheName( fullArgs, cacheName );
+    if ( useCache )
+    {
+        GetCacheFilePaths( cacheFileNames );
+    }
+    if ( useCache && RetrieveFilesFromCache( cacheName, cacheFileNames, "Run: " ) )
+    {
+        return NODE_RESULT_OK;
+    }
+
     EmitCompilationMessage( fullArgs );
 
     // spawn the process
@@ -206,6 +227,7 @@ ExecNode::~ExecNode() = default;
 
     // Get result
     int result = p.WaitForExit();
+    job->AddResourceUsage( p.GetPeakMemoryBytes(), p.GetCPUTimeUS() );
     if ( p.HasAborted() )
     {
         return NODE_RESULT_FAILED;
@@ -243,9 +265,79 @@ ExecNode::~ExecNode() = default;
     // record new file time
     RecordStampFromBuiltFile();
 
+    if ( useCache )
+    {
+        WriteFilesToCache( cacheName, cacheFileNames, "Run: " );
+    }
+
     return NODE_RESULT_OK;
 }
 
+// ShouldUseCache
+//------------------------------------------------------------------------------
+bool ExecNode::ShouldUseCache() const
+{
+    return m_ExecCacheable &&
+           ( FBuild::Get().GetOptions().m_UseCacheRead ||
+             FBuild::Get().GetOptions().m_UseCacheWrite );
+}
+
+// GetCacheName
+//------------------------------------------------------------------------------
+bool ExecNode::GetCacheName( const AString & fullArgs, AString & outCacheName ) const
+{
+    PROFILE_FUNCTION
+
+    // The executable and declared inputs, by content
+    uint64_t toolKey;
+    if ( GetFileContentHash( GetExecutable()->GetName(), toolKey ) == false )
+    {
+        return false;
+    }
+    Array< uint64_t > inputHashes( m_NumExecInputFiles + m_DynamicDependencies.GetSize(), false );
+    for ( size_t i = 1; i < ( 1 + m_NumExecInputFiles ); ++i ) // Note: Skip first dep (executable)
+    {
+        uint64_t hash;
+        if ( GetFileContentHash( m_StaticDependencies[ i ].GetNode()->GetName(), hash ) == false )
+        {
+            return false;
+        }
+        inputHashes.Append( hash );
+    }
+    for ( const Dependency & dep : m_DynamicDependencies ) // files found in .ExecInputPath
+    {
+        uint64_t hash;
+        if ( GetFileContentHash( dep.GetNode()->GetName(), hash ) == false )
+        {
+            return false;
+        }
+        inputHashes.Append( hash );
+    }
+    const uint64_t inputsKey = xxHash::Calc64( inputHashes.Begin(), inputHashes.GetSize() * sizeof( uint64_t ) );
+
+    // Everything else which affects the outputs
+    AStackString< 4 * KILOBYTE > commandLine( fullArgs );
+    commandLine.AppendFormat( "|%s|%i|%u", m_ExecWorkingDir.Get(), m_ExecReturnCode, (uint32_t)m_ExecUseStdOutAsOutput );
+    for ( const AString & extraOutput : m_ExecExtraOutputs )
+    {
+        commandLine += '|';
+        commandLine += extraOutput;
+    }
+    const uint32_t commandLineKey = FBuild::Get().GetSettings()->GetCacheRootMappings().Calc32( commandLine );
+
+    ICache::GetCacheId( inputsKey, commandLineKey, toolKey, 0, outCacheName );
+    return true;
+}
+
+// GetCacheFilePaths
+//------------------------------------------------------------------------------
+void ExecNode::GetCacheFilePaths( Array< AString > & outFileNames ) const
+{
+    outFileNames.SetCapacity( 1 + m_ExecExtraOutputs.GetSize() );
+    outFileNames.Append( m_Name );
+    outFileNames.Append( m_ExecExtraOutputs );
+}
+
 // EmitCompilationMessage
 //------------------------------------------------------------------------------
 void ExecNode::EmitCompilationMessage( const AString & args ) const
@@ -33,6 +33,11 @@ private:
 
     void EmitCompilationMessage( const AString & args ) const;
 
+    // Caching
+    bool ShouldUseCache() const;
+    bool GetCacheName( const AString & fullArgs, AString & outCacheName ) const;
+    void GetCacheFilePaths( Array< AString > & outFileNames ) const;
+
     // Exposed Properties
     AString             m_ExecExecutable;
     Array< AString >    m_ExecInput;
@@ -48,6 +53,8 @@ private:
     bool                m_ExecUseStdOutAsOutput;
     bool                m_ExecAlways;
     bool                m_ExecInputPathRecurse;
+    bool                m_ExecCacheable;
+    Array< AString >    m_ExecExtraOutputs;
     Array< AString >    m_PreBuildDependencyNames;
 
     // Internal State
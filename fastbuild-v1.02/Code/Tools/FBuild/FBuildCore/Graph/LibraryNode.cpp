@@ -27,9 +27,15 @@
 #include "Core/FileIO/PathUtils.h"
 #include "Core/Process/Process.h"
 #include "Core/Strings/AStackString.h"
+#include "Core/Time/Timer.h"
 
 // Reflection
 //------------------------------------------------------------------------------
+REFLECT_STRUCT_BEGIN_BASE( LibraryMember )
+    REFLECT( m_Name,                            "Name",                         MetaNone() )
+    REFLECT( m_Stamp,                           "Stamp",                        MetaNone() )
+REFLECT_END( LibraryMember )
+
 REFLECT_NODE_BEGIN( LibraryNode, ObjectListNode, MetaName( "LibrarianOutput" ) + MetaFile() )
     REFLECT( m_Librarian,                       "Librarian",                    MetaFile() )
     REFLECT( m_LibrarianOptions,                "LibrarianOptions",             MetaNone() )
@@ -38,9 +44,12 @@ REFLECT_NODE_BEGIN( LibraryNode, ObjectListNode, MetaName( "LibrarianOutput" ) +
     REFLECT_ARRAY( m_LibrarianAdditionalInputs, "LibrarianAdditionalInputs",    MetaOptional() + MetaFile() + MetaAllowNonFile( Node::OBJECT_LIST_NODE ) )
     REFLECT( m_LibrarianAllowResponseFile,      "LibrarianAllowResponseFile",   MetaOptional() )
     REFLECT( m_LibrarianForceResponseFile,      "LibrarianForceResponseFile",   MetaOptional() )   
+    REFLECT( m_LibrarianIncremental,            "LibrarianIncremental",         MetaOptional() )
 
     REFLECT( m_NumLibrarianAdditionalInputs,    "NumLibrarianAdditionalInputs", MetaHidden() )
     REFLECT( m_LibrarianFlags,                  "LibrarianFlags",               MetaHidden() )
+    REFLECT( m_FullBuildTimeMS,                 "FullBuildTimeMS",              MetaHidden() + MetaIgnoreForComparison() )
+    REFLECT_ARRAY_OF_STRUCT( m_Members,         "Members",  LibraryMember,      MetaHidden() + MetaIgnoreForComparison() )
     REFLECT_ARRAY( m_Environment,               "Environment",                  MetaOptional() )
 REFLECT_END( LibraryNode )
 
@@ -51,6 +60,7 @@ LibraryNode::LibraryNode()
 , m_LibrarianType( "auto" )
 , m_LibrarianAllowResponseFile( false )
 , m_LibrarianForceResponseFile( false )
+, m_LibrarianIncremental( false )
 {
     m_Type = LIBRARY_NODE;
     m_LastBuildTimeMs = 10000; // TODO:C Reduce this when dynamic deps are saved
@@ -147,12 +157,22 @@ LibraryNode::~LibraryNode()
 //------------------------------------------------------------------------------
 /*virtual*/ Node::BuildResult LibraryNode::DoBuild( Job * job )
 {
+    // Can we replace only the changed members of the existing library?
+    Array< LibraryMember > members;
+    Array< AString > changedFiles;
+    if ( m_LibrarianIncremental )
+    {
+        GetMembers( members );
+    }
+    const bool incremental = CanUpdateIncrementally() && GetChangedMembers( members, changedFiles );
+
     // Delete library from previous build (if present) if:
     // - A clean build is being triggered
     // - A non-msvc librarian is used (librarians like ar can cause duplicate
     //                                symbols because of how they update archives)
-    if ( FBuild::Get().GetOptions().m_ForceCleanBuild ||
-         ( GetFlag( Flag::LIB_FLAG_LIB ) == false ) )
+    if ( ( incremental == false ) &&
+         ( FBuild::Get().GetOptions().m_ForceCleanBuild ||
+           ( GetFlag( Flag::LIB_FLAG_LIB ) == false ) ) )
     {
         if ( DoPreBuildFileDeletion( GetName() ) == false )
         {
@@ -162,11 +182,17 @@ LibraryNode::~LibraryNode()
 
     // Format compiler args string
     Args fullArgs;
-    if ( !BuildArgs( fullArgs ) )
+    if ( !BuildArgs( fullArgs, incremental ? &changedFiles : nullptr ) )
     {
         return NODE_RESULT_FAILED; // BuildArgs will have emitted an error
     }
 
+    // If the librarian fails, the library must be fully rebuilt next time
+    m_Members.Clear();
+    m_NumMembersUpdated = 0;
+    m_IncrementalSavedMS = 0;
+    const Timer t;
+
     // use the exe launch dir as the working dir
     const char * workingDir = nullptr;
 
@@ -199,6 +225,7 @@ LibraryNode::~LibraryNode()
 
     // Get result
     int result = p.WaitForExit();
+    job->AddResourceUsage( p.GetPeakMemoryBytes(), p.GetCPUTimeUS() );
     if ( p.HasAborted() )
     {
         return NODE_RESULT_FAILED;
@@ -233,12 +260,41 @@ LibraryNode::~LibraryNode()
     // record new file time
     RecordStampFromBuiltFile();
 
+    // Track the members for the next incremental update
+    if ( m_LibrarianIncremental )
+    {
+        const uint32_t timeMS = (uint32_t)t.GetElapsedMS();
+        if ( incremental )
+        {
+            m_NumMembersUpdated = (uint32_t)changedFiles.GetSize();
+            m_IncrementalSavedMS = ( m_FullBuildTimeMS > timeMS ) ? ( m_FullBuildTimeMS - timeMS ) : 0;
+        }
+        else
+        {
+            m_FullBuildTimeMS = timeMS;
+        }
+        m_Members = Move( members );
+    }
+
     return NODE_RESULT_OK;
 }
 
+// Migrate
+//------------------------------------------------------------------------------
+/*virtual*/ void LibraryNode::Migrate( const Node & oldNode )
+{
+    // Migrate Node level properties
+    ObjectListNode::Migrate( oldNode );
+
+    // Migrate the members of the existing library
+    const LibraryNode * oldLibraryNode = oldNode.CastTo< LibraryNode >();
+    m_FullBuildTimeMS = oldLibraryNode->m_FullBuildTimeMS;
+    m_Members = oldLibraryNode->m_Members;
+}
+
 // BuildArgs
 //------------------------------------------------------------------------------
-bool LibraryNode::BuildArgs( Args & fullArgs ) const
+bool LibraryNode::BuildArgs( Args & fullArgs, const Array< AString > * inputFiles ) const
 {
     Array< AString > tokens( 1024, true );
     m_LibrarianOptions.Tokenize( tokens );
@@ -261,7 +317,14 @@ bool LibraryNode::BuildArgs( Args & fullArgs ) const
             }
 
             // concatenate files, unquoted
-            GetInputFiles( fullArgs, pre, AString::GetEmpty(), objectsInsteadOfLibs );
+            if ( inputFiles )
+            {
+                AddInputFiles( fullArgs, pre, AString::GetEmpty(), *inputFiles );
+            }
+            else
+            {
+                GetInputFiles( fullArgs, pre, AString::GetEmpty(), objectsInsteadOfLibs );
+            }
         }
         else if ( token.EndsWith( "\"%1\"" ) )
         {
@@ -270,7 +333,14 @@ bool LibraryNode::BuildArgs( Args & fullArgs ) const
             AStackString<> post( "\"" );
 
             // concatenate files, quoted
-            GetInputFiles( fullArgs, pre, post, objectsInsteadOfLibs );
+            if ( inputFiles )
+            {
+                AddInputFiles( fullArgs, pre, post, *inputFiles );
+            }
+            else
+            {
+                GetInputFiles( fullArgs, pre, post, objectsInsteadOfLibs );
+            }
         }
         else if ( token.EndsWith( "%2" ) )
         {
@@ -450,4 +520,156 @@ ArgsResponseFileMode LibraryNode::GetResponseFileMode() const
     return ArgsResponseFileMode::NEVER;
 }
 
+// AddInputFiles
+//------------------------------------------------------------------------------
+/*static*/ void LibraryNode::AddInputFiles( Args & fullArgs, const AString & pre, const AString & post, const Array< AString > & files )
+{
+    for ( const AString & file : files )
+    {
+        fullArgs += pre;
+        fullArgs += file;
+        fullArgs += post;
+        fullArgs.AddDelimiter();
+    }
+}
+
+// GetMembers
+//------------------------------------------------------------------------------
+void LibraryNode::GetMembers( Array< LibraryMember > & outMembers ) const
+{
+    outMembers.SetCapacity( m_DynamicDependencies.GetSize() );
+    GetMembersRecurse( m_DynamicDependencies, outMembers );
+}
+
+// GetMembersRecurse
+//------------------------------------------------------------------------------
+/*static*/ void LibraryNode::GetMembersRecurse( const Dependencies & deps, Array< LibraryMember > & outMembers )
+{
+    // NOTE: This follows GetInputFiles when merging objects instead of libs
+    for ( const Dependency & dep : deps )
+    {
+        const Node * n = dep.GetNode();
+
+        AStackString<> name( n->GetName() );
+        if ( n->GetType() == Node::OBJECT_NODE )
+        {
+            const ObjectNode * on = n->CastTo< ObjectNode >();
+            if ( on->IsCreatingPCH() )
+            {
+                if ( on->IsMSVC() == false )
+                {
+                    continue; // Clang/GCC/SNC don't have an object to link for a pch
+                }
+                name = on->GetPCHObjectName();
+            }
+        }
+        else if ( ( n->GetType() == Node::OBJECT_LIST_NODE ) || ( n->GetType() == Node::LIBRARY_NODE ) )
+        {
+            GetMembersRecurse( n->GetDynamicDependencies(), outMembers );
+            continue;
+        }
+
+        LibraryMember member;
+        member.m_Name = name;
+        member.m_Stamp = n->GetStamp();
+        outMembers.Append( member );
+    }
+}
+
+// CanUpdateIncrementally
+//------------------------------------------------------------------------------
+bool LibraryNode::CanUpdateIncrementally() const
+{
+    if ( ( m_LibrarianIncremental == false ) ||
+         FBuild::Get().GetOptions().m_ForceCleanBuild ||
+         m_Members.IsEmpty() ) // not built since enabled, or last build failed
+    {
+        return false;
+    }
+
+    // Only ar-style librarians replace members in place, and only when
+    // the operation is 'r' (not 'q' which would append duplicates)
+    if ( GetFlag( LIB_FLAG_AR ) == false )
+    {
+        return false;
+    }
+    Array< AString > tokens;
+    m_LibrarianOptions.Tokenize( tokens );
+    if ( tokens.IsEmpty() ||
+         ( tokens[ 0 ].Find( 'r' ) == nullptr ) ||
+         ( tokens[ 0 ].Find( 'q' ) != nullptr ) ||
+         ( tokens[ 0 ].Find( '%' ) != nullptr ) )
+    {
+        return false;
+    }
+
+    return FileIO::FileExists( m_Name.Get() );
+}
+
+// GetChangedMembers
+//------------------------------------------------------------------------------
+bool LibraryNode::GetChangedMembers( const Array< LibraryMember > & members, Array< AString > & outChangedFiles ) const
+{
+    // Members are replaced by file name, so names must be unique
+    {
+        Array< AString > fileNames( members.GetSize(), false );
+        for ( const LibraryMember & member : members )
+        {
+            const char * lastSlash = member.m_Name.FindLast( NATIVE_SLASH );
+            fileNames.EmplaceBack( lastSlash ? ( lastSlash + 1 ) : member.m_Name.Get() );
+        }
+        fileNames.Sort();
+        for ( size_t i = 1; i < fileNames.GetSize(); ++i )
+        {
+            if ( fileNames[ i ] == fileNames[ i - 1 ] )
+            {
+                return false;
+            }
+        }
+    }
+
+    // Find the member in the previous build for each one in this build. This is
+    // usually at the same position, so only search when it isn't.
+    Array< bool > oldMemberFound( m_Members.GetSize(), false );
+    for ( size_t i = 0; i < m_Members.GetSize(); ++i )
+    {
+        oldMemberFound.Append( false );
+    }
+    for ( size_t i = 0; i < members.GetSize(); ++i )
+    {
+        const LibraryMember & member = members[ i ];
+        const LibraryMember * oldMember = nullptr;
+        if ( ( i < m_Members.GetSize() ) && ( m_Members[ i ].m_Name == member.m_Name ) )
+        {
+            oldMember = &m_Members[ i ];
+        }
+        else
+        {
+            oldMember = m_Members.Find( member );
+        }
+
+        if ( oldMember )
+        {
+            oldMemberFound[ (size_t)( oldMember - m_Members.Begin() ) ] = true;
+            if ( oldMember->m_Stamp == member.m_Stamp )
+            {
+                continue; // unchanged
+            }
+        }
+        outChangedFiles.Append( member.m_Name );
+    }
+
+    // A removed member would remain in the library, so it must be rebuilt
+    for ( const bool found : oldMemberFound )
+    {
+        if ( found == false )
+        {
+            return false;
+        }
+    }
+
+    // Something else changed (the librarian for example)
+    return ( outChangedFiles.IsEmpty() == false );
+}
+
 //------------------------------------------------------------------------------
@@ -16,6 +16,18 @@ class NodeGraph;
 class ObjectNode;
 enum class ArgsResponseFileMode : uint32_t;
 
+// LibraryMember - an input of the library, as of the last build
+//------------------------------------------------------------------------------
+class LibraryMember : public Struct
+{
+    REFLECT_STRUCT_DECLARE( LibraryMember )
+public:
+    AString             m_Name;
+    uint64_t            m_Stamp = 0;
+
+    inline bool operator == ( const LibraryMember & other ) const { return ( m_Name == other.m_Name ); }
+};
+
 // LibraryNode
 //------------------------------------------------------------------------------
 class LibraryNode : public ObjectListNode
@@ -39,14 +51,20 @@ public:
         LIB_FLAG_WARNINGS_AS_ERRORS_MSVC = 0x10,
     };
     static uint32_t DetermineFlags( const AString & librarianType, const AString & librarianName, const AString & args );
+
+    // Incremental update stats (from this build)
+    inline uint32_t GetNumMembers() const               { return (uint32_t)m_Members.GetSize(); }
+    inline uint32_t GetNumMembersUpdated() const        { return m_NumMembersUpdated; }
+    inline uint32_t GetIncrementalSavedMS() const       { return m_IncrementalSavedMS; }
 private:
     friend class FunctionLibrary;
 
     virtual bool GatherDynamicDependencies( NodeGraph & nodeGraph, bool forceClean ) override;
     virtual BuildResult DoBuild( Job * job ) override;
+    virtual void Migrate( const Node & oldNode ) override;
 
     // internal helpers
-    bool BuildArgs( Args & fullArgs ) const;
+    bool BuildArgs( Args & fullArgs, const Array< AString > * inputFiles = nullptr ) const;
     void EmitCompilationMessage( const Args & fullArgs ) const;
     FileNode * GetLibrarian() const;
 
@@ -54,6 +72,13 @@ private:
 
     ArgsResponseFileMode GetResponseFileMode() const;
 
+    // Incremental updates replace only the changed members of an existing archive
+    void GetMembers( Array< LibraryMember > & outMembers ) const;
+    static void GetMembersRecurse( const Dependencies & deps, Array< LibraryMember > & outMembers );
+    bool GetChangedMembers( const Array< LibraryMember > & members, Array< AString > & outChangedFiles ) const;
+    bool CanUpdateIncrementally() const;
+    static void AddInputFiles( Args & fullArgs, const AString & pre, const AString & post, const Array< AString > & files );
+
     // Exposed Properties
     AString             m_Librarian;
     AString             m_LibrarianOptions;
@@ -63,11 +88,16 @@ private:
     Array< AString >    m_Environment;
     bool                m_LibrarianAllowResponseFile;
     bool                m_LibrarianForceResponseFile;
+    bool                m_LibrarianIncremental;
 
     // Internal State
     uint32_t            m_NumLibrarianAdditionalInputs  = 0;
     uint32_t            m_LibrarianFlags                = 0;
+    uint32_t            m_FullBuildTimeMS               = 0;
+    Array< LibraryMember > m_Members;
     mutable const char * m_EnvironmentString            = nullptr;
+    uint32_t            m_NumMembersUpdated             = 0; // Not serialized
+    uint32_t            m_IncrementalSavedMS            = 0; // Not serialized
 };
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,160 @@
+// LinkPrepNode.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "LinkPrepNode.h"
+
+#include "Tools/FBuild/FBuildCore/FLog.h"
+#include "Tools/FBuild/FBuildCore/Graph/CopyFileNode.h"
+#include "Tools/FBuild/FBuildCore/Graph/DLLNode.h"
+#include "Tools/FBuild/FBuildCore/Graph/MetaData/Meta_IgnoreForComparison.h"
+#include "Tools/FBuild/FBuildCore/Graph/ObjectNode.h"
+
+#include "Core/FileIO/FileIO.h"
+#include "Core/Strings/AStackString.h"
+#include "Core/Time/Timer.h"
+
+// Reflection
+//------------------------------------------------------------------------------
+REFLECT_NODE_BEGIN( LinkPrepNode, Node, MetaNone() )
+    // Internal State
+    REFLECT_ARRAY( m_InputFiles,    "InputFiles",   MetaHidden() + MetaIgnoreForComparison() )
+REFLECT_END( LinkPrepNode )
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+LinkPrepNode::LinkPrepNode()
+    : Node( AString::GetEmpty(), Node::LINK_PREP_NODE, Node::FLAG_ALWAYS_BUILD )
+{
+    m_LastBuildTimeMs = 1; // prefetching only issues requests to the OS
+    m_Hidden = true;
+}
+
+// Initialize
+//------------------------------------------------------------------------------
+/*virtual*/ bool LinkPrepNode::Initialize( NodeGraph & /*nodeGraph*/, const BFFToken * /*iter*/, const Function * /*function*/ )
+{
+    ASSERT( false ); // Should never get here
+    return false;
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+LinkPrepNode::~LinkPrepNode() = default;
+
+// RecordInputs
+//------------------------------------------------------------------------------
+void LinkPrepNode::RecordInputs( const Dependency * begin, const Dependency * end, bool linkObjects )
+{
+    m_InputFiles.Clear();
+    for ( const Dependency * it = begin; it != end; ++it )
+    {
+        RecordInput( it->GetNode(), linkObjects );
+    }
+}
+
+// DoBuild
+//------------------------------------------------------------------------------
+/*virtual*/ Node::BuildResult LinkPrepNode::DoBuild( Job * /*job*/ )
+{
+    const Timer t;
+
+    // Prefetch whatever is still on disk from the last link. Inputs which are
+    // being rebuilt will be replaced, but everything else will be read as-is.
+    // This costs nothing for files which are already cached. Failures are not
+    // errors, since the link will report missing files.
+    m_BytesPrefetched = 0;
+    uint32_t numPrefetched = 0;
+    for ( const AString & inputFile : m_InputFiles )
+    {
+        uint64_t size = 0;
+        if ( FileIO::FilePrefetch( inputFile.Get(), size ) )
+        {
+            m_BytesPrefetched += size;
+            ++numPrefetched;
+        }
+    }
+
+    FLOG_VERBOSE( "Prefetched %u of %u link inputs (%" PRIu64 " KiB) in %2.3fs for '%s'",
+                  numPrefetched,
+                  (uint32_t)m_InputFiles.GetSize(),
+                  ( m_BytesPrefetched / 1024 ),
+                  (double)t.GetElapsed(),
+                  GetName().Get() );
+
+    m_Stamp = 1; // Non-zero (this node never triggers a link)
+    return NODE_RESULT_OK;
+}
+
+// Migrate
+//------------------------------------------------------------------------------
+/*virtual*/ void LinkPrepNode::Migrate( const Node & oldNode )
+{
+    // Migrate Node level properties
+    Node::Migrate( oldNode );
+
+    // Keep the inputs of the last link
+    m_InputFiles = oldNode.CastTo< LinkPrepNode >()->m_InputFiles;
+}
+
+// RecordInput
+//------------------------------------------------------------------------------
+void LinkPrepNode::RecordInput( const Node * node, bool linkObjects )
+{
+    switch ( node->GetType() )
+    {
+        case Node::LIBRARY_NODE:
+        case Node::OBJECT_LIST_NODE:
+        {
+            if ( ( node->GetType() == Node::LIBRARY_NODE ) && ( linkObjects == false ) )
+            {
+                m_InputFiles.Append( node->GetName() ); // link the lib directly
+                break;
+            }
+            for ( const Dependency & dep : node->GetDynamicDependencies() )
+            {
+                RecordInput( dep.GetNode(), linkObjects );
+            }
+            break;
+        }
+        case Node::OBJECT_NODE:
+        {
+            const ObjectNode * objectNode = node->CastTo< ObjectNode >();
+            if ( objectNode->IsCreatingPCH() )
+            {
+                // Only MSVC has an object to link for a pch
+                if ( objectNode->IsMSVC() )
+                {
+                    m_InputFiles.Append( objectNode->GetPCHObjectName() );
+                }
+                break;
+            }
+            m_InputFiles.Append( node->GetName() );
+            break;
+        }
+        case Node::DLL_NODE:
+        {
+            // for a DLL, the import library is linked
+            AStackString<> importLibName;
+            node->CastTo< DLLNode >()->GetImportLibName( importLibName );
+            m_InputFiles.Append( importLibName );
+            break;
+        }
+        case Node::COPY_FILE_NODE:
+        {
+            RecordInput( node->CastTo< CopyFileNode >()->GetSourceNode(), linkObjects );
+            break;
+        }
+        default:
+        {
+            if ( node->IsAFile() )
+            {
+                m_InputFiles.Append( node->GetName() );
+            }
+            break;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,48 @@
+// LinkPrepNode.h - prepare the inputs of a link while they are being built
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Node.h"
+#include "Core/Containers/Array.h"
+
+// LinkPrepNode
+//------------------------------------------------------------------------------
+// A link can only start once all of its inputs are built, but most of them
+// are usually unchanged from the last link. This node has no dependencies and
+// is ordered before (but doesn't trigger) the link, so it runs while the
+// remaining inputs are still compiling, asking the OS to bring the files used
+// by the last link into the file cache.
+//------------------------------------------------------------------------------
+class LinkPrepNode : public Node
+{
+    REFLECT_NODE_DECLARE( LinkPrepNode )
+public:
+    explicit LinkPrepNode();
+    virtual bool Initialize( NodeGraph & nodeGraph, const BFFToken * iter, const Function * function ) override;
+    virtual ~LinkPrepNode() override;
+
+    static inline Node::Type GetTypeS() { return Node::LINK_PREP_NODE; }
+
+    virtual bool IsAFile() const override { return false; }
+
+    // Recorded by the linker after each successful link, from its inputs
+    // expanded as they are passed to the linker
+    void RecordInputs( const Dependency * begin, const Dependency * end, bool linkObjects );
+    inline const Array< AString > & GetInputFiles() const { return m_InputFiles; }
+
+    inline uint64_t GetBytesPrefetched() const { return m_BytesPrefetched; }
+
+private:
+    virtual BuildResult DoBuild( Job * job ) override;
+    virtual void Migrate( const Node & oldNode ) override;
+
+    void RecordInput( const Node * node, bool linkObjects );
+
+    // Internal State
+    Array< AString >    m_InputFiles;
+    uint64_t            m_BytesPrefetched = 0; // Not serialized
+};
+
+//------------------------------------------------------------------------------
@@ -14,6 +14,7 @@
 #include "Tools/FBuild/FBuildCore/Graph/DLLNode.h"
 #include "Tools/FBuild/FBuildCore/Graph/FileNode.h"
 #include "Tools/FBuild/FBuildCore/Graph/LibraryNode.h"
+#include "Tools/FBuild/FBuildCore/Graph/LinkPrepNode.h"
 #include "Tools/FBuild/FBuildCore/Graph/ObjectListNode.h"
 #include "Tools/FBuild/FBuildCore/Graph/ObjectNode.h"
 #include "Tools/FBuild/FBuildCore/Graph/NodeGraph.h"
@@ -35,6 +36,7 @@ REFLECT_NODE_BEGIN( LinkerNode, Node, MetaName( "LinkerOutput" ) + MetaFile() )
     REFLECT( m_LinkerType,                      "LinkerType",                   MetaOptional() )
     REFLECT( m_LinkerAllowResponseFile,         "LinkerAllowResponseFile",      MetaOptional() )
     REFLECT( m_LinkerForceResponseFile,         "LinkerForceResponseFile",      MetaOptional() )
+    REFLECT( m_LinkerPrepare,                   "LinkerPrepare",                MetaOptional() )
     REFLECT_ARRAY( m_Libraries,                 "Libraries",                    MetaFile() + MetaAllowNonFile() )
     REFLECT_ARRAY( m_LinkerAssemblyResources,   "LinkerAssemblyResources",      MetaOptional() + MetaFile() + MetaAllowNonFile( Node::OBJECT_LIST_NODE ) )
     REFLECT( m_LinkerLinkObjects,               "LinkerLinkObjects",            MetaOptional() )
@@ -47,6 +49,7 @@ REFLECT_NODE_BEGIN( LinkerNode, Node, MetaName( "LinkerOutput" ) + MetaFile() )
     REFLECT( m_Flags,                           "Flags",                        MetaHidden() )
     REFLECT( m_AssemblyResourcesStartIndex,     "AssemblyResourcesStartIndex",  MetaHidden() )
     REFLECT( m_AssemblyResourcesNum,            "AssemblyResourcesNum",         MetaHidden() )
+    REFLECT( m_LinkPrepIndex,                   "LinkPrepIndex",                MetaHidden() )
     REFLECT( m_ImportLibName,                   "ImportLibName",                MetaHidden() )
 REFLECT_END( LinkerNode )
 
@@ -142,11 +145,22 @@ LinkerNode::LinkerNode()
         ASSERT( linkerStampExe.GetSize() == 1 );
     }
 
+    // .LinkerPrepare
+    Dependencies linkPrep;
+    if ( m_LinkerPrepare )
+    {
+        if ( !CreateLinkPrepNode( nodeGraph, iter, function, linkPrep ) )
+        {
+            return false; // CreateLinkPrepNode will have emitted an error
+        }
+    }
+
     // Store all dependencies
     m_StaticDependencies.SetCapacity( 1 + // for .Linker
                                       libraries.GetSize() +
                                       assemblyResources.GetSize() +
                                       otherLibraryNodes.GetSize() +
+                                      linkPrep.GetSize() +
                                       ( linkerStampExe.IsEmpty() ? 0 : 1 ) );
     m_StaticDependencies.Append( linkerExe );
     m_StaticDependencies.Append( libraries );
@@ -154,6 +168,8 @@ LinkerNode::LinkerNode()
     m_StaticDependencies.Append( assemblyResources );
     m_AssemblyResourcesNum = (uint32_t)assemblyResources.GetSize();
     m_StaticDependencies.Append( otherLibraryNodes );
+    m_LinkPrepIndex = linkPrep.IsEmpty() ? 0 : (uint32_t)m_StaticDependencies.GetSize();
+    m_StaticDependencies.Append( linkPrep );
     m_StaticDependencies.Append( linkerStampExe );
 
     return true;
@@ -235,6 +251,7 @@ LinkerNode::~LinkerNode()
         ASSERT( !p.IsRunning() );
         // Get result
         int result = p.WaitForExit();
+        job->AddResourceUsage( p.GetPeakMemoryBytes(), p.GetCPUTimeUS() );
         if ( p.HasAborted() )
         {
             return NODE_RESULT_FAILED;
@@ -338,6 +355,7 @@ LinkerNode::~LinkerNode()
 
         // Get result
         int result = stampProcess.WaitForExit();
+        job->AddResourceUsage( stampProcess.GetPeakMemoryBytes(), stampProcess.GetCPUTimeUS() );
         if ( stampProcess.HasAborted() )
         {
             return NODE_RESULT_FAILED;
@@ -365,6 +383,15 @@ LinkerNode::~LinkerNode()
     // record new file time
     RecordStampFromBuiltFile();
 
+    // remember what was linked, to prepare the next link
+    if ( m_LinkPrepIndex != 0 )
+    {
+        LinkPrepNode * linkPrepNode = m_StaticDependencies[ m_LinkPrepIndex ].GetNode()->CastTo< LinkPrepNode >();
+        linkPrepNode->RecordInputs( m_StaticDependencies.Begin() + 1, // skip .Linker
+                                    m_StaticDependencies.Begin() + m_LinkPrepIndex,
+                                    m_LinkerLinkObjects );
+    }
+
     return NODE_RESULT_OK;
 }
 
@@ -620,6 +647,24 @@ void LinkerNode::GetAssemblyResourceFiles( Args & fullArgs, const AString & pre,
     }
 }
 
+// CreateLinkPrepNode
+//------------------------------------------------------------------------------
+bool LinkerNode::CreateLinkPrepNode( NodeGraph & nodeGraph, const BFFToken * iter, const Function * function, Dependencies & linkPrep ) const
+{
+    AStackString<> linkPrepName( m_Name );
+    linkPrepName += ".linkprep";
+    if ( nodeGraph.FindNode( linkPrepName ) )
+    {
+        Error::Error_1100_AlreadyDefined( iter, function, linkPrepName );
+        return false;
+    }
+
+    // The link waits for the preparation, but is never triggered by it
+    LinkPrepNode * linkPrepNode = nodeGraph.CreateLinkPrepNode( linkPrepName );
+    linkPrep.EmplaceBack( linkPrepNode, (uint64_t)0, true ); // isWeak
+    return true;
+}
+
 // DetermineLinkerTypeFlags
 //------------------------------------------------------------------------------
 /*static*/ uint32_t LinkerNode::DetermineLinkerTypeFlags(const AString & linkerType, const AString & linkerName)
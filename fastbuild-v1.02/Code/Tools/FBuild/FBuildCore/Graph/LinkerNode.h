@@ -56,6 +56,7 @@ protected:
     void GetInputFiles( Args & fullArgs, const AString & pre, const AString & post ) const;
     void GetInputFiles( Node * n, Args & fullArgs, const AString & pre, const AString & post ) const;
     void GetAssemblyResourceFiles( Args & fullArgs, const AString & pre, const AString & post ) const;
+    bool CreateLinkPrepNode( NodeGraph & nodeGraph, const BFFToken * iter, const Function * function, Dependencies & linkPrep ) const;
     void EmitCompilationMessage( const Args & fullArgs ) const;
     void EmitStampMessage() const;
 
@@ -95,6 +96,7 @@ protected:
     bool                m_LinkerLinkObjects             = false;
     bool                m_LinkerAllowResponseFile;
     bool                m_LinkerForceResponseFile;    
+    bool                m_LinkerPrepare                 = false;
     AString             m_LinkerStampExe;
     AString             m_LinkerStampExeArgs;
     Array< AString >    m_PreBuildDependencyNames;
@@ -104,6 +106,7 @@ protected:
     uint32_t            m_Flags                         = 0;
     uint32_t            m_AssemblyResourcesStartIndex   = 0;
     uint32_t            m_AssemblyResourcesNum          = 0;
+    uint32_t            m_LinkPrepIndex                 = 0; // 0 if not preparing inputs
     AString             m_ImportLibName;
     mutable const char * m_EnvironmentString            = nullptr;
 };
@@ -7,6 +7,7 @@
 #include "FileNode.h"
 
 #include "Tools/FBuild/FBuildCore/BFF/Functions/Function.h"
+#include "Tools/FBuild/FBuildCore/Cache/ICache.h"
 #include "Tools/FBuild/FBuildCore/FBuild.h"
 #include "Tools/FBuild/FBuildCore/FLog.h"
 #include "Tools/FBuild/FBuildCore/Graph/AliasNode.h"
@@ -20,6 +21,7 @@
 #include "Tools/FBuild/FBuildCore/Graph/ExecNode.h"
 #include "Tools/FBuild/FBuildCore/Graph/FileNode.h"
 #include "Tools/FBuild/FBuildCore/Graph/LibraryNode.h"
+#include "Tools/FBuild/FBuildCore/Graph/LinkPrepNode.h"
 #include "Tools/FBuild/FBuildCore/Graph/NodeGraph.h"
 #include "Tools/FBuild/FBuildCore/Graph/NodeProxy.h"
 #include "Tools/FBuild/FBuildCore/Graph/ObjectListNode.h"
@@ -37,20 +39,29 @@
 #include "Tools/FBuild/FBuildCore/Graph/MetaData/Meta_IgnoreForComparison.h"
 #include "Tools/FBuild/FBuildCore/Graph/MetaData/Meta_InheritFromOwner.h"
 #include "Tools/FBuild/FBuildCore/Graph/MetaData/Meta_Name.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildMetrics.h"
+#include "Tools/FBuild/FBuildCore/Helpers/Compressor.h"
+#include "Tools/FBuild/FBuildCore/Helpers/MultiBuffer.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/Job.h"
 
 // Core
 #include "Core/Containers/Array.h"
+#include "Core/Containers/AutoPtr.h"
 #include "Core/Env/Env.h"
+#include "Core/Env/ErrorFormat.h"
 #include "Core/FileIO/FileIO.h"
+#include "Core/FileIO/FileStream.h"
 #include "Core/FileIO/IOStream.h"
 #include "Core/FileIO/PathUtils.h"
+#include "Core/Math/Conversions.h"
 #include "Core/Math/CRC32.h"
+#include "Core/Math/xxHash.h"
 #include "Core/Process/Atomic.h"
 #include "Core/Process/Mutex.h"
 #include "Core/Profile/Profile.h"
 #include "Core/Reflection/ReflectedProperty.h"
 #include "Core/Strings/AStackString.h"
+#include "Core/Time/Timer.h"
 
 // system
 #include <stdio.h>
@@ -82,9 +93,31 @@
     "Settings",
     "VSExtProj",
     "TextFile",
+    "LinkPrep",
 };
 static Mutex g_NodeEnvStringMutex;
 
+// File content hashes (see GetFileContentHash)
+#define FILE_CONTENT_HASH_NUM_BUCKETS ( 64 )
+#define FILE_CONTENT_HASH_READ_SIZE ( 1 * MEGABYTE )
+class FileContentHashBucket
+{
+public:
+    struct Entry
+    {
+        AString     m_FileName;
+        uint64_t    m_LastWriteTime;
+        uint64_t    m_Size;
+        uint64_t    m_Hash;
+    };
+
+    FileContentHashBucket() : m_Entries( 0, true ) {}
+
+    Mutex           m_Mutex;
+    Array< Entry >  m_Entries;
+};
+static FileContentHashBucket g_FileContentHashes[ FILE_CONTENT_HASH_NUM_BUCKETS ];
+
 // Custom MetaData
 //------------------------------------------------------------------------------
 IMetaData & MetaName( const char * name )
@@ -129,6 +162,7 @@ Node::Node( const AString & name, Type type, uint32_t controlFlags )
     , m_Type( type )
     , m_Next( nullptr )
     , m_LastBuildTimeMs( 0 )
+    , m_LastPeakMemory( 0 )
     , m_ProcessingTime( 0 )
     , m_CachingTime( 0 )
     , m_ProgressAccumulator( 0 )
@@ -315,6 +349,20 @@ void Node::SetLastBuildTime( uint32_t ms )
     AtomicStoreRelaxed( &m_LastBuildTimeMs, ms );
 }
 
+// GetLastPeakMemory
+//------------------------------------------------------------------------------
+uint64_t Node::GetLastPeakMemory() const
+{
+    return AtomicLoadRelaxed( &m_LastPeakMemory );
+}
+
+// SetLastPeakMemory
+//------------------------------------------------------------------------------
+void Node::SetLastPeakMemory( uint64_t bytes )
+{
+    AtomicStoreRelaxed( &m_LastPeakMemory, bytes );
+}
+
 // CreateNode
 //------------------------------------------------------------------------------
 /*static*/ Node * Node::CreateNode( NodeGraph & nodeGraph, Node::Type nodeType, const AString & name )
@@ -344,6 +392,7 @@ void Node::SetLastBuildTime( uint32_t ms )
         case Node::XCODEPROJECT_NODE:   return nodeGraph.CreateXCodeProjectNode( name );
         case Node::SETTINGS_NODE:       return nodeGraph.CreateSettingsNode( name );
         case Node::TEXT_FILE_NODE:      return nodeGraph.CreateTextFileNode( name );
+        case Node::LINK_PREP_NODE:      return nodeGraph.CreateLinkPrepNode( name );
         case Node::NUM_NODE_TYPES:      ASSERT( false ); return nullptr;
     }
 
@@ -657,6 +706,7 @@ bool Node::Deserialize( NodeGraph & nodeGraph, IOStream & stream )
 
     // Transfer previous build costs used for progress estimates
     m_LastBuildTimeMs = oldNode.m_LastBuildTimeMs;
+    m_LastPeakMemory = oldNode.m_LastPeakMemory;
 }
 
 // Deserialize
@@ -1169,4 +1219,229 @@ void Node::RecordStampFromBuiltFile()
     #endif
 }
 
+// RetrieveFilesFromCache
+//------------------------------------------------------------------------------
+bool Node::RetrieveFilesFromCache( const AString & cacheName,
+                                   const Array< AString > & fileNames,
+                                   const char * summaryPrefix )
+{
+    if ( FBuild::Get().GetOptions().m_UseCacheRead == false )
+    {
+        return false;
+    }
+
+    PROFILE_FUNCTION
+    BuildMetricsScope metricsScope( BuildMetrics::METRIC_CACHE_READ );
+
+    Timer t;
+
+    ICache * cache = FBuild::Get().GetCache();
+    ASSERT( cache );
+
+    void * cacheData( nullptr );
+    size_t cacheDataSize( 0 );
+    if ( cache->Retrieve( cacheName, cacheData, cacheDataSize ) )
+    {
+        metricsScope.SetBytes( cacheDataSize );
+
+        Compressor c;
+        if ( ( c.IsValidData( cacheData, cacheDataSize ) == false ) || ( c.Decompress( cacheData ) == false ) )
+        {
+            cache->FreeMemory( cacheData, cacheDataSize );
+            FLOG_WARN( "Cache returned invalid data\n"
+                       " - File: '%s'\n"
+                       " - Key : %s\n",
+                       m_Name.Get(), cacheName.Get() );
+            return false;
+        }
+        cache->FreeMemory( cacheData, cacheDataSize );
+
+        // Extract the files
+        const MultiBuffer buffer( c.GetResult(), c.GetResultSize() );
+        for ( size_t i = 0; i < fileNames.GetSize(); ++i )
+        {
+            if ( ( EnsurePathExistsForFile( fileNames[ i ] ) == false ) ||
+                 ( buffer.ExtractFile( i, fileNames[ i ] ) == false ) ||
+                 ( FileIO::SetFileLastWriteTimeToNow( fileNames[ i ] ) == false ) )
+            {
+                FLOG_ERROR( "Failed to write local file during cache retrieval. Error: %s Target: '%s'", LAST_ERROR_STR, fileNames[ i ].Get() );
+                return false;
+            }
+        }
+
+        RecordStampFromBuiltFile();
+
+        // Output
+        if ( FBuild::Get().GetOptions().m_ShowCommandSummary ||
+             FBuild::Get().GetOptions().m_CacheVerbose )
+        {
+            AStackString<> output;
+            output.Format( "%s%s <CACHE>\n", summaryPrefix, GetName().Get() );
+            if ( FBuild::Get().GetOptions().m_CacheVerbose )
+            {
+                output.AppendFormat( " - Cache Hit: %u ms (Compressed: %zu - Uncompressed: %zu) '%s'\n", uint32_t( t.GetElapsedMS() ), cacheDataSize, c.GetResultSize(), cacheName.Get() );
+            }
+            FLOG_OUTPUT( output );
+        }
+
+        SetStatFlag( Node::STATS_CACHE_HIT );
+        return true;
+    }
+
+    // Output
+    if ( FBuild::Get().GetOptions().m_CacheVerbose )
+    {
+        FLOG_OUTPUT( "%s%s\n"
+                     " - Cache Miss: %u ms '%s'\n",
+                     summaryPrefix, GetName().Get(), uint32_t( t.GetElapsedMS() ), cacheName.Get() );
+    }
+
+    SetStatFlag( Node::STATS_CACHE_MISS );
+    return false;
+}
+
+// WriteFilesToCache
+//------------------------------------------------------------------------------
+void Node::WriteFilesToCache( const AString & cacheName,
+                              const Array< AString > & fileNames,
+                              const char * summaryPrefix )
+{
+    if ( FBuild::Get().GetOptions().m_UseCacheWrite == false )
+    {
+        return;
+    }
+
+    PROFILE_FUNCTION
+    BuildMetricsScope metricsScope( BuildMetrics::METRIC_CACHE_WRITE );
+
+    Timer t;
+
+    ICache * cache = FBuild::Get().GetCache();
+    ASSERT( cache );
+
+    // All files must have been written
+    MultiBuffer buffer;
+    size_t problemFileIndex = 0;
+    if ( buffer.CreateFromFiles( fileNames, &problemFileIndex ) )
+    {
+        Compressor c;
+        c.Compress( buffer.GetData(), (size_t)buffer.GetDataSize(), FBuild::Get().GetOptions().m_CacheCompressionLevel );
+        if ( cache->Publish( cacheName, c.GetResult(), c.GetResultSize() ) )
+        {
+            metricsScope.SetBytes( c.GetResultSize() );
+            SetStatFlag( Node::STATS_CACHE_STORE );
+
+            const uint32_t cachingTime = uint32_t( t.GetElapsedMS() );
+            AddCachingTime( cachingTime );
+
+            // Output
+            if ( FBuild::Get().GetOptions().m_CacheVerbose )
+            {
+                FLOG_OUTPUT( "%s%s\n"
+                             " - Cache Store: %u ms (Compressed: %zu - Uncompressed: %zu) '%s'\n",
+                             summaryPrefix, GetName().Get(), cachingTime, c.GetResultSize(), (size_t)buffer.GetDataSize(), cacheName.Get() );
+            }
+            return;
+        }
+    }
+    else
+    {
+        FLOG_WARN( "Output missing, not stored in cache: '%s' Target: '%s'\n", fileNames[ problemFileIndex ].Get(), GetName().Get() );
+    }
+
+    // Output
+    if ( FBuild::Get().GetOptions().m_CacheVerbose )
+    {
+        FLOG_OUTPUT( "%s%s\n"
+                     " - Cache Store Fail: %u ms '%s'\n",
+                     summaryPrefix, GetName().Get(), uint32_t( t.GetElapsedMS() ), cacheName.Get() );
+    }
+}
+
+// GetFileContentHash
+//------------------------------------------------------------------------------
+/*static*/ bool Node::GetFileContentHash( const AString & fileName, uint64_t & outHash, IOStream * outContents )
+{
+    PROFILE_FUNCTION
+
+    FileIO::FileInfo info;
+    if ( FileIO::GetFileInfo( fileName, info ) == false )
+    {
+        return false;
+    }
+
+    // Files used by several nodes (like the executable of a sharded test) are
+    // only read once
+    FileContentHashBucket & bucket = g_FileContentHashes[ xxHash::Calc32( fileName ) % FILE_CONTENT_HASH_NUM_BUCKETS ];
+    if ( outContents == nullptr )
+    {
+        MutexHolder mh( bucket.m_Mutex );
+        for ( const FileContentHashBucket::Entry & entry : bucket.m_Entries )
+        {
+            if ( ( entry.m_FileName == fileName ) &&
+                 ( entry.m_LastWriteTime == info.m_LastWriteTime ) &&
+                 ( entry.m_Size == info.m_Size ) )
+            {
+                outHash = entry.m_Hash;
+                return true;
+            }
+        }
+    }
+
+    FileStream fs;
+    if ( fs.Open( fileName.Get(), FileStream::READ_ONLY ) == false )
+    {
+        return false;
+    }
+    uint64_t remaining = fs.GetFileSize();
+    const size_t bufferSize = (size_t)Math::Min< uint64_t >( remaining, FILE_CONTENT_HASH_READ_SIZE );
+    AutoPtr< char > buffer( (char *)ALLOC( bufferSize ) );
+    xxHash64Stream hash;
+    while ( remaining > 0 )
+    {
+        const size_t readSize = (size_t)Math::Min< uint64_t >( remaining, bufferSize );
+        if ( fs.ReadBuffer( buffer.Get(), readSize ) != readSize )
+        {
+            return false;
+        }
+        hash.Update( buffer.Get(), readSize );
+        if ( outContents )
+        {
+            outContents->WriteBuffer( buffer.Get(), readSize );
+        }
+        remaining -= readSize;
+    }
+    outHash = hash.Digest();
+
+    MutexHolder mh( bucket.m_Mutex );
+    for ( FileContentHashBucket::Entry & entry : bucket.m_Entries )
+    {
+        if ( entry.m_FileName == fileName )
+        {
+            entry.m_LastWriteTime = info.m_LastWriteTime;
+            entry.m_Size = info.m_Size;
+            entry.m_Hash = outHash;
+            return true;
+        }
+    }
+    FileContentHashBucket::Entry entry;
+    entry.m_FileName = fileName;
+    entry.m_LastWriteTime = info.m_LastWriteTime;
+    entry.m_Size = info.m_Size;
+    entry.m_Hash = outHash;
+    bucket.m_Entries.Append( entry );
+    return true;
+}
+
+// ClearFileContentHashes
+//------------------------------------------------------------------------------
+/*static*/ void Node::ClearFileContentHashes()
+{
+    for ( FileContentHashBucket & bucket : g_FileContentHashes )
+    {
+        MutexHolder mh( bucket.m_Mutex );
+        bucket.m_Entries.Destruct();
+    }
+}
+
 //------------------------------------------------------------------------------
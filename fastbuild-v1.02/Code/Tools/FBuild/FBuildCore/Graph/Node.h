@@ -79,6 +79,7 @@ public:
         SETTINGS_NODE       = 20,
         VSPROJEXTERNAL_NODE = 21,
         TEXT_FILE_NODE      = 22,
+        LINK_PREP_NODE      = 23,
         // Make sure you update 's_NodeTypeNames' in the cpp
         NUM_NODE_TYPES      // leave this last
     };
@@ -143,6 +144,7 @@ public:
     inline void SetStatFlag( StatsFlag flag ) const { m_StatsFlags |= flag; }
 
     uint32_t GetLastBuildTime() const;
+    uint64_t GetLastPeakMemory() const;
     inline uint32_t GetProcessingTime() const   { return m_ProcessingTime; }
     inline uint32_t GetCachingTime() const      { return m_CachingTime; }
     inline uint32_t GetRecursiveCost() const    { return m_RecursiveCost; }
@@ -163,6 +165,12 @@ public:
     static bool EnsurePathExistsForFile( const AString & name );
     static bool DoPreBuildFileDeletion( const AString & fileName );
 
+    // Hash of a file's contents (as xxHash::Calc64), read in fixed size pieces
+    // and optionally copied to outContents. Hashes are remembered for the rest
+    // of the build while files are unchanged.
+    static bool GetFileContentHash( const AString & fileName, uint64_t & outHash, IOStream * outContents = nullptr );
+    static void ClearFileContentHashes();
+
     inline uint64_t GetStamp() const { return m_Stamp; }
 
     inline uint32_t GetIndex() const { return m_Index; }
@@ -223,6 +231,7 @@ protected:
     virtual bool Finalize( NodeGraph & nodeGraph );
 
     void SetLastBuildTime( uint32_t ms );
+    void SetLastPeakMemory( uint64_t bytes );
     inline void     AddProcessingTime( uint32_t ms )  { m_ProcessingTime += ms; }
     inline void     AddCachingTime( uint32_t ms )     { m_CachingTime += ms; }
 
@@ -248,6 +257,14 @@ protected:
 
     void RecordStampFromBuiltFile();
 
+    // Store/restore output files in the cache, for nodes other than objects
+    bool RetrieveFilesFromCache( const AString & cacheName,
+                                 const Array< AString > & fileNames,
+                                 const char * summaryPrefix );
+    void WriteFilesToCache( const AString & cacheName,
+                            const Array< AString > & fileNames,
+                            const char * summaryPrefix );
+
     AString m_Name;
 
     State m_State;
@@ -260,6 +277,7 @@ protected:
     Node *          m_Next; // node map linked list pointer
     uint32_t        m_NameCRC;
     uint32_t m_LastBuildTimeMs; // time it took to do last known full build of this node
+    uint64_t m_LastPeakMemory;  // peak memory (bytes) of the process(es) in the last known build of this node
     uint32_t m_ProcessingTime;  // time spent on this node
     uint32_t m_CachingTime;  // time spent caching this node
     mutable uint32_t m_ProgressAccumulator;
@@ -23,6 +23,7 @@
 #include "ExecNode.h"
 #include "FileNode.h"
 #include "LibraryNode.h"
+#include "LinkPrepNode.h"
 #include "ObjectListNode.h"
 #include "ObjectNode.h"
 #include "RemoveDirNode.h"
@@ -47,6 +48,7 @@
 #include "Core/Math/xxHash.h"
 #include "Core/Mem/Mem.h"
 #include "Core/Process/Thread.h"
+#include "Core/Process/ThreadPool.h"
 #include "Core/Profile/Profile.h"
 #include "Core/Reflection/ReflectedProperty.h"
 #include "Core/Strings/AStackString.h"
@@ -65,13 +67,14 @@
 // CONSTRUCTOR
 //------------------------------------------------------------------------------
 NodeGraph::NodeGraph()
-: m_AllNodes( 1024, true )
+: m_NodeMapMask( NODEMAP_TABLE_INITIAL_SIZE - 1 )
+, m_AllNodes( 1024, true )
 , m_NextNodeIndex( 0 )
 , m_UsedFiles( 16, true )
 , m_Settings( nullptr )
 {
-    m_NodeMap = FNEW_ARRAY( Node *[NODEMAP_TABLE_SIZE] );
-    memset( m_NodeMap, 0, sizeof( Node * ) * NODEMAP_TABLE_SIZE );
+    m_NodeMap = FNEW_ARRAY( Node *[NODEMAP_TABLE_INITIAL_SIZE] );
+    memset( m_NodeMap, 0, sizeof( Node * ) * NODEMAP_TABLE_INITIAL_SIZE );
 }
 
 // DESTRUCTOR
@@ -99,6 +102,15 @@ NodeGraph::~NodeGraph()
     ASSERT( bffFile ); // must be supplied (or left as default)
     ASSERT( nodeGraphDBFile ); // must be supplied (or left as default)
 
+    // Tokenized BFF files are cached alongside the DB
+    AStackString<> tokenCacheFileName;
+    if ( FBuild::Get().GetOptions().m_UseBFFTokenCache )
+    {
+        tokenCacheFileName = nodeGraphDBFile;
+        tokenCacheFileName += ".bffcache";
+    }
+    const char * tokenCacheFile = tokenCacheFileName.IsEmpty() ? nullptr : tokenCacheFileName.Get();
+
     // Try to load the old DB
     NodeGraph * oldNG = FNEW( NodeGraph );
     LoadResult res = oldNG->Load( nodeGraphDBFile );
@@ -142,8 +154,9 @@ NodeGraph::~NodeGraph()
             
             // Create a fresh DB by parsing the BFF
             FDELETE( oldNG );
+            FBuild::Get().CreateThreadPool();
             NodeGraph * newNG = FNEW( NodeGraph );
-            if ( newNG->ParseFromRoot( bffFile ) == false )
+            if ( newNG->ParseFromRoot( bffFile, tokenCacheFile ) == false )
             {
                 FDELETE( newNG );
                 return nullptr; // ParseFromRoot will have emitted an error
@@ -153,8 +166,9 @@ NodeGraph::~NodeGraph()
         case LoadResult::OK_BFF_NEEDS_REPARSING:
         {
             // Create a fresh DB by parsing the modified BFF
+            FBuild::Get().CreateThreadPool();
             NodeGraph * newNG = FNEW( NodeGraph );
-            if ( newNG->ParseFromRoot( bffFile ) == false )
+            if ( newNG->ParseFromRoot( bffFile, tokenCacheFile ) == false )
             {
                 FDELETE( newNG );
                 FDELETE( oldNG );
@@ -184,13 +198,13 @@ NodeGraph::~NodeGraph()
 
 // ParseFromRoot
 //------------------------------------------------------------------------------
-bool NodeGraph::ParseFromRoot( const char * bffFile )
+bool NodeGraph::ParseFromRoot( const char * bffFile, const char * tokenCacheFile )
 {
     ASSERT( m_UsedFiles.IsEmpty() ); // NodeGraph cannot be recycled
 
     // re-parse the BFF from scratch, clean build will result
     BFFParser bffParser( *this );
-    const bool ok = bffParser.ParseFromFile( bffFile );
+    const bool ok = bffParser.ParseFromFile( bffFile, tokenCacheFile );
     if ( ok )
     {
         // Store a pointer to the SettingsNode as defined by the BFF, or create a
@@ -495,6 +509,14 @@ bool NodeGraph::LoadNode( IOStream & stream )
     }
     n->SetLastBuildTime( lastTimeToBuild );
 
+    // load peak memory
+    uint64_t lastPeakMemory;
+    if ( stream.Read( lastPeakMemory ) == false )
+    {
+        return false;
+    }
+    n->SetLastPeakMemory( lastPeakMemory );
+
     return true;
 }
 
@@ -609,6 +631,9 @@ void NodeGraph::Save( IOStream & stream, const char* nodeGraphDBFile ) const
     uint32_t lastBuildTime = node->GetLastBuildTime();
     stream.Write( lastBuildTime );
 
+    // save peak memory
+    stream.Write( node->GetLastPeakMemory() );
+
     savedNodeFlags[ nodeIndex ] = true; // mark as saved
 }
 
@@ -703,9 +728,89 @@ Node * NodeGraph::FindNode( const AString & nodeName ) const
     // the expanding to a full path
     AStackString< 1024 > fullPath;
     CleanPath( nodeName, fullPath );
+    if ( fullPath == nodeName )
+    {
+        return nullptr; // already checked
+    }
     return FindNodeInternal( fullPath );
 }
 
+// FindNode (AString &, NodeNameKey &)
+//------------------------------------------------------------------------------
+Node * NodeGraph::FindNode( const AString & nodeName, const NodeNameKey & key ) const
+{
+    // try to find node 'as is'
+    Node * n = FindNodeInternal( nodeName, key.m_NameCRC );
+    if ( n )
+    {
+        return n;
+    }
+
+    // then the full path
+    if ( ( key.m_CleanNameCRC == key.m_NameCRC ) && ( key.m_CleanName == nodeName ) )
+    {
+        return nullptr; // already checked
+    }
+    return FindNodeInternal( key.m_CleanName, key.m_CleanNameCRC );
+}
+
+// CalcNodeNameKeysContext
+//------------------------------------------------------------------------------
+struct CalcNodeNameKeysContext
+{
+    const Array< AString > *                m_Names;
+    Array< NodeGraph::NodeNameKey > *       m_Keys;
+};
+
+// CalcNodeNameKeys
+//------------------------------------------------------------------------------
+/*static*/ void NodeGraph::CalcNodeNameKeys( const Array< AString > & names, Array< NodeNameKey > & outKeys )
+{
+    PROFILE_FUNCTION
+
+    ASSERT( Thread::IsMainThread() );
+    ASSERT( outKeys.IsEmpty() );
+
+    // Reserve enough space for each clean name on the main thread, so the
+    // keys can be calculated without any allocations (the SmallBlockAllocator
+    // is in single threaded mode while parsing)
+    const uint32_t workingDirLength = FBuild::IsValid() ? FBuild::Get().GetWorkingDir().GetLength() : 0;
+    const uint32_t numNames = (uint32_t)names.GetSize();
+    outKeys.SetSize( numNames );
+    for ( uint32_t i = 0; i < numNames; ++i )
+    {
+        outKeys[ i ].m_CleanName.SetReserved( workingDirLength + 1 + names[ i ].GetLength() );
+    }
+
+    // Clean and hash
+    CalcNodeNameKeysContext context = { &names, &outKeys };
+    ThreadPool * pool = FBuild::IsValid() ? FBuild::Get().GetThreadPool() : nullptr;
+    if ( pool && ( numNames >= 128 ) ) // Not worth waking threads for short lists
+    {
+        pool->ParallelFor( numNames, CalcNodeNameKey, &context );
+    }
+    else
+    {
+        for ( uint32_t i = 0; i < numNames; ++i )
+        {
+            CalcNodeNameKey( &context, i );
+        }
+    }
+}
+
+// CalcNodeNameKey
+//------------------------------------------------------------------------------
+/*static*/ void NodeGraph::CalcNodeNameKey( void * userData, uint32_t index )
+{
+    // NOTE: Can be called from any thread and must not allocate
+    const CalcNodeNameKeysContext & context = *static_cast< const CalcNodeNameKeysContext * >( userData );
+    const AString & name = ( *context.m_Names )[ index ];
+    NodeNameKey & key = ( *context.m_Keys )[ index ];
+    CleanPath( name, key.m_CleanName );
+    key.m_NameCRC = CRC32::CalcLower( name );
+    key.m_CleanNameCRC = CRC32::CalcLower( key.m_CleanName );
+}
+
 // FindNodeExact (AString &)
 //------------------------------------------------------------------------------
 Node * NodeGraph::FindNodeExact( const AString & nodeName ) const
@@ -1028,6 +1133,19 @@ TextFileNode* NodeGraph::CreateTextFileNode( const AString& nodeName )
     return node;
 }
 
+// CreateLinkPrepNode
+//------------------------------------------------------------------------------
+LinkPrepNode * NodeGraph::CreateLinkPrepNode( const AString & nodeName )
+{
+    ASSERT( Thread::IsMainThread() );
+    ASSERT( IsCleanPath( nodeName ) );
+
+    LinkPrepNode * node = FNEW( LinkPrepNode() );
+    node->SetName( nodeName );
+    AddNode( node );
+    return node;
+}
+
 // AddNode
 //------------------------------------------------------------------------------
 void NodeGraph::AddNode( Node * node )
@@ -1039,8 +1157,8 @@ void NodeGraph::AddNode( Node * node )
     ASSERT( FindNodeInternal( node->GetName() ) == nullptr ); // node name must be unique
 
     // track in NodeMap
-    const uint32_t crc = CRC32::CalcLower( node->GetName() );
-    const size_t key = ( crc & 0xFFFF );
+    ASSERT( node->GetNameCRC() == CRC32::CalcLower( node->GetName() ) );
+    const size_t key = ( node->GetNameCRC() & m_NodeMapMask );
     node->m_Next = m_NodeMap[ key ];
     m_NodeMap[ key ] = node;
 
@@ -1060,6 +1178,43 @@ void NodeGraph::AddNode( Node * node )
     // set index on node
     node->SetIndex( m_NextNodeIndex );
     m_NextNodeIndex = (uint32_t)m_AllNodes.GetSize();
+
+    // keep chains short as the graph grows
+    if ( m_AllNodes.GetSize() > m_NodeMapMask )
+    {
+        GrowNodeMap();
+    }
+}
+
+// GrowNodeMap
+//------------------------------------------------------------------------------
+void NodeGraph::GrowNodeMap()
+{
+    PROFILE_FUNCTION
+
+    const uint32_t oldSize = ( m_NodeMapMask + 1 );
+    const uint32_t newSize = ( oldSize * 2 );
+    Node ** newNodeMap = FNEW_ARRAY( Node *[ newSize ] );
+    memset( newNodeMap, 0, sizeof( Node * ) * newSize );
+
+    // re-link all nodes into new buckets
+    const uint32_t newMask = ( newSize - 1 );
+    for ( uint32_t i = 0; i < oldSize; ++i )
+    {
+        Node * node = m_NodeMap[ i ];
+        while ( node )
+        {
+            Node * next = node->m_Next;
+            const size_t key = ( node->GetNameCRC() & newMask );
+            node->m_Next = newNodeMap[ key ];
+            newNodeMap[ key ] = node;
+            node = next;
+        }
+    }
+
+    FDELETE_ARRAY( m_NodeMap );
+    m_NodeMap = newNodeMap;
+    m_NodeMapMask = newMask;
 }
 
 // Build
@@ -1472,11 +1627,18 @@ bool NodeGraph::CheckDependencies( Node * nodeToBuild, const Dependencies & depe
 // FindNodeInternal
 //------------------------------------------------------------------------------
 Node * NodeGraph::FindNodeInternal( const AString & fullPath ) const
+{
+    return FindNodeInternal( fullPath, CRC32::CalcLower( fullPath ) );
+}
+
+// FindNodeInternal
+//------------------------------------------------------------------------------
+Node * NodeGraph::FindNodeInternal( const AString & fullPath, uint32_t crc ) const
 {
     ASSERT( Thread::IsMainThread() );
+    ASSERT( crc == CRC32::CalcLower( fullPath ) );
 
-    const uint32_t crc = CRC32::CalcLower( fullPath );
-    const size_t key = ( crc & 0xFFFF );
+    const size_t key = ( crc & m_NodeMapMask );
 
     Node * n = m_NodeMap[ key ];
     while ( n )
@@ -1508,7 +1670,7 @@ void NodeGraph::FindNearestNodesInternal( const AString & fullPath, Array< NodeW
 
     uint32_t worstMinDistance = fullPath.GetLength() + 1;
 
-    for ( size_t i = 0 ; i < NODEMAP_TABLE_SIZE ; i++ )
+    for ( size_t i = 0 ; i <= m_NodeMapMask ; i++ )
     {
         for ( Node * node = m_NodeMap[i] ; nullptr != node ; node = node->m_Next )
         {
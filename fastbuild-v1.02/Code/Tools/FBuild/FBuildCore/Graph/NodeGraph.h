@@ -29,6 +29,7 @@ class FileNode;
 class IOStream;
 class LibraryNode;
 class LinkerNode;
+class LinkPrepNode;
 class Node;
 class ObjectListNode;
 class ObjectNode;
@@ -58,7 +59,7 @@ public:
     }
     inline ~NodeGraphHeader() = default;
 
-    enum : uint8_t { NODE_GRAPH_CURRENT_VERSION = 155 };
+    enum : uint8_t { NODE_GRAPH_CURRENT_VERSION = 167 };
 
     bool IsValid() const
     {
@@ -128,9 +129,21 @@ public:
     XCodeProjectNode * CreateXCodeProjectNode( const AString & name );
     SettingsNode * CreateSettingsNode( const AString & name );
     TextFileNode * CreateTextFileNode( const AString & name );
+    LinkPrepNode * CreateLinkPrepNode( const AString & name );
 
     void DoBuildPass( Node * nodeToBuild );
 
+    // Pre-calculated lookup information for a node name, allowing the expensive
+    // parts of FindNode to be done up front (and in parallel) for large lists
+    struct NodeNameKey
+    {
+        AString     m_CleanName;    // as per CleanPath
+        uint32_t    m_NameCRC;      // of name 'as is'
+        uint32_t    m_CleanNameCRC; // of m_CleanName
+    };
+    static void CalcNodeNameKeys( const Array< AString > & names, Array< NodeNameKey > & outKeys );
+    Node * FindNode( const AString & nodeName, const NodeNameKey & key ) const;
+
     static void CleanPath( AString & name, bool makeFullPath = true );
     static void CleanPath( const AString & name, AString & cleanPath, bool makeFullPath = true );
     #if defined( ASSERTS_ENABLED )
@@ -143,7 +156,7 @@ public:
 private:
     friend class FBuild;
 
-    bool ParseFromRoot( const char * bffFile );
+    bool ParseFromRoot( const char * bffFile, const char * tokenCacheFile );
 
     void AddNode( Node * node );
 
@@ -157,6 +170,9 @@ private:
                                           uint32_t & totalNodeTime );
 
     Node * FindNodeInternal( const AString & fullPath ) const;
+    Node * FindNodeInternal( const AString & fullPath, uint32_t fullPathCRC ) const;
+    void GrowNodeMap();
+    static void CalcNodeNameKey( void * userData, uint32_t index );
 
     struct NodeWithDistance
     {
@@ -191,8 +207,9 @@ private:
     static bool AreNodesTheSame( const void * baseA, const void * baseB, const ReflectedProperty & property );
     static bool DoDependenciesMatch( const Dependencies & depsA, const Dependencies & depsB );
 
-    enum { NODEMAP_TABLE_SIZE = 65536 };
+    enum { NODEMAP_TABLE_INITIAL_SIZE = 65536 }; // must be a power of 2
     Node **         m_NodeMap;
+    uint32_t        m_NodeMapMask;  // table size - 1
     Array< Node * > m_AllNodes;
     uint32_t        m_NextNodeIndex;
 
@@ -15,13 +15,19 @@
 #include "Tools/FBuild/FBuildCore/Graph/NodeProxy.h"
 #include "Tools/FBuild/FBuildCore/Graph/SettingsNode.h"
 #include "Tools/FBuild/FBuildCore/Helpers/Args.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildMetrics.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildTrace.h"
 #include "Tools/FBuild/FBuildCore/Helpers/CIncludeParser.h"
 #include "Tools/FBuild/FBuildCore/Helpers/Compressor.h"
+#include "Tools/FBuild/FBuildCore/Helpers/HeaderBundle.h"
+#include "Tools/FBuild/FBuildCore/Helpers/JobPhaseScope.h"
 #include "Tools/FBuild/FBuildCore/Helpers/MultiBuffer.h"
 #include "Tools/FBuild/FBuildCore/Helpers/ResponseFile.h"
 #include "Tools/FBuild/FBuildCore/Helpers/ToolManifest.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/Job.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/JobQueue.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/MemoryStaging.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/WorkerCGroups.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/WorkerThread.h"
 
 // Core
@@ -30,8 +36,10 @@
 #include "Core/FileIO/ConstMemoryStream.h"
 #include "Core/FileIO/FileIO.h"
 #include "Core/FileIO/FileStream.h"
+#include "Core/FileIO/MemoryStream.h"
 #include "Core/FileIO/PathUtils.h"
 #include "Core/Math/xxHash.h"
+#include "Core/Process/Atomic.h"
 #include "Core/Process/Process.h"
 #include "Core/Profile/Profile.h"
 #include "Core/Process/Thread.h"
@@ -70,6 +78,7 @@ REFLECT_NODE_BEGIN( ObjectNode, Node, MetaNone() )
     REFLECT( m_Flags,                               "Flags",                            MetaHidden() )
     REFLECT( m_PreprocessorFlags,                   "PreprocessorFlags",                MetaHidden() )
     REFLECT( m_PCHCacheKey,                         "PCHCacheKey",                      MetaHidden() + MetaIgnoreForComparison() )
+    REFLECT( m_PCHContentHash,                      "PCHContentHash",                   MetaHidden() + MetaIgnoreForComparison() )
     REFLECT( m_OwnerObjectList,                     "OwnerObjectList",                  MetaHidden() )
 REFLECT_END( ObjectNode )
 
@@ -307,6 +316,9 @@ ObjectNode::~ObjectNode()
     // to prevent unnecessary rebuilds of object that depend on this one, if this
     // is a precompiled header object.
     m_PCHCacheKey = oldNode.CastTo< ObjectNode >()->m_PCHCacheKey;
+
+    // Likewise the hash users of a shipped PCH refer to it by
+    m_PCHContentHash = oldNode.CastTo< ObjectNode >()->m_PCHContentHash;
 }
 
 // DoBuildMSCL_NoCache
@@ -326,6 +338,7 @@ ObjectNode::~ObjectNode()
     EmitCompilationMessage( fullArgs, useDeoptimization );
 
     // spawn the process
+    JobPhaseScope phaseScope( BuildTrace::PHASE_COMPILE, job );
     CompileHelper ch;
     if ( !ch.SpawnCompiler( job, GetName(), GetCompiler(), GetCompiler()->GetExecutable(), fullArgs ) ) // use response file for MSVC
     {
@@ -382,33 +395,53 @@ Node::BuildResult ObjectNode::DoBuildWithPreProcessor( Job * job, bool useDeopti
         return NODE_RESULT_FAILED; // BuildArgs will have emitted an error
     }
 
-    // Try to use the light cache if enabled
-    if ( useCache && GetCompiler()->GetUseLightCache() )
+    // Distribute the source and the headers it includes instead of preprocessed output?
+    const bool useHeaderShipping = ( useSimpleDist == false ) && CanUseHeaderShipping( useCache );
+
+    // Try to use the light cache if enabled (header shipping uses it to find the headers)
+    const bool useLightCache = ( useCache && GetCompiler()->GetUseLightCache() );
+    if ( useLightCache || useHeaderShipping )
     {
         LightCache lc;
-        if ( lc.Hash( this, fullArgs.GetFinalArgs(), m_LightCacheKey, m_Includes ) == false )
+        uint64_t lightCacheKey = 0;
+        const bool hashed = lc.Hash( this, fullArgs.GetFinalArgs(), lightCacheKey, m_Includes );
+        if ( useLightCache )
+        {
+            m_LightCacheKey = lightCacheKey;
+        }
+        if ( hashed == false )
         {
             // Light cache could not be used (can't parse includes)
-            if ( FBuild::Get().GetOptions().m_CacheVerbose )
+            if ( useLightCache && FBuild::Get().GetOptions().m_CacheVerbose )
             {
                 FLOG_OUTPUT( "LightCache cannot be used for '%s'\n"
                              "%s",
                               GetName().Get(),
                               lc.GetErrors().Get() );
             }
+            if ( useHeaderShipping )
+            {
+                FLOG_VERBOSE( "Header shipping cannot be used for '%s'\n"
+                              "%s",
+                              GetName().Get(),
+                              lc.GetErrors().Get() );
+            }
 
             // Fall through to generate preprocessed output for old style cache and distribution....
         }
         else
         {
-            // LightCache hashing was successful
-            SetStatFlag( Node::STATS_LIGHT_CACHE ); // Light compatible
-
-            // Try retrieve from cache
-            GetCacheName( job ); // Prepare the cache key (always done here even if write only mode)
-            if ( RetrieveFromCache( job ) )
+            if ( useLightCache )
             {
-                return NODE_RESULT_OK_CACHE;
+                // LightCache hashing was successful
+                SetStatFlag( Node::STATS_LIGHT_CACHE ); // Light compatible
+
+                // Try retrieve from cache
+                GetCacheName( job ); // Prepare the cache key (always done here even if write only mode)
+                if ( RetrieveFromCache( job ) )
+                {
+                    return NODE_RESULT_OK_CACHE;
+                }
             }
 
             // Cache miss
@@ -423,6 +456,44 @@ Node::BuildResult ObjectNode::DoBuildWithPreProcessor( Job * job, bool useDeopti
                 return DoBuildWithPreProcessor2( job, useDeoptimization, stealingRemoteJob, racingRemoteJob );
             }
 
+            if ( useHeaderShipping )
+            {
+                // Describe the source and headers (the content is sent to each worker once)
+                Array< uint64_t > contentHashes;
+                lc.GetContentHashes( contentHashes );
+                ASSERT( contentHashes.GetSize() == m_Includes.GetSize() );
+                HeaderBundle bundle;
+                const size_t numFiles = m_Includes.GetSize();
+                for ( size_t i = 0; i < numFiles; ++i )
+                {
+                    bundle.AddFile( m_Includes[ i ], contentHashes[ i ] );
+                }
+
+                // The PCH goes where the compiler will look for it (beside the header, or on
+                // the include path). It's sent to each worker once like any other header.
+                if ( GetFlag( FLAG_USING_PCH ) )
+                {
+                    const ObjectNode * pch = GetPrecompiledHeader();
+                    bundle.AddFile( pch->GetName(), pch->GetPCHContentHash() );
+                }
+                MemoryStream ms;
+                bundle.Save( ms );
+
+                // compress job data
+                {
+                    JobPhaseScope phaseScope( BuildTrace::PHASE_COMPRESS, job );
+                    BuildMetricsScope metricsScope( BuildMetrics::METRIC_COMPRESS, ms.GetSize() );
+                    Compressor c;
+                    c.Compress( ms.GetData(), ms.GetSize() );
+                    const size_t compressedSize = c.GetResultSize();
+                    job->OwnData( c.ReleaseResult(), compressedSize, true );
+                    job->SetDataIsHeaderBundle( true );
+                }
+
+                // re-queue for secondary build
+                return NODE_RESULT_NEED_SECOND_BUILD_PASS;
+            }
+
             // Fall through to generate preprocessed output for distribution....
         }
     }
@@ -467,15 +538,20 @@ Node::BuildResult ObjectNode::DoBuildWithPreProcessor( Job * job, bool useDeopti
     }
 
     // can we do the rest of the work remotely?
-    const bool canDistribute = useSimpleDist || ( GetFlag( FLAG_CAN_BE_DISTRIBUTED ) && m_AllowDistribution && FBuild::Get().GetOptions().m_AllowDistributed );
+    // (a PCH created from preprocessed output could not accelerate its users)
+    const bool canDistribute = useSimpleDist || ( GetFlag( FLAG_CAN_BE_DISTRIBUTED ) && m_AllowDistribution && FBuild::Get().GetOptions().m_AllowDistributed && ( GetFlag( FLAG_CREATING_PCH ) == false ) );
     const bool belowMemoryLimit = ( ( Job::GetTotalLocalDataMemoryUsage() / MEGABYTE ) < FBuild::Get().GetSettings()->GetDistributableJobMemoryLimitMiB() );
     if ( canDistribute && belowMemoryLimit )
     {
         // compress job data
-        Compressor c;
-        c.Compress( job->GetData(), job->GetDataSize() );
-        size_t compressedSize = c.GetResultSize();
-        job->OwnData( c.ReleaseResult(), compressedSize, true );
+        {
+            JobPhaseScope phaseScope( BuildTrace::PHASE_COMPRESS, job );
+            BuildMetricsScope metricsScope( BuildMetrics::METRIC_COMPRESS, job->GetDataSize() );
+            Compressor c;
+            c.Compress( job->GetData(), job->GetDataSize() );
+            size_t compressedSize = c.GetResultSize();
+            job->OwnData( c.ReleaseResult(), compressedSize, true );
+        }
 
         // yes... re-queue for secondary build
         return NODE_RESULT_NEED_SECOND_BUILD_PASS;
@@ -567,9 +643,17 @@ Node::BuildResult ObjectNode::DoBuildWithPreProcessor2( Job * job, bool useDeopt
         }
     }
 
+    // Header bundles are compiled from source (on a worker, in a virtual include root)
+    if ( job->IsDataHeaderBundle() )
+    {
+        usePreProcessedOutput = false;
+    }
+
     Args fullArgs;
     AStackString<> tmpDirectoryName;
     AStackString<> tmpFileName;
+    HeaderBundle bundle;
+    AStackString<> includeRoot;
     if ( usePreProcessedOutput )
     {
         if ( WriteTmpFile( job, tmpDirectoryName, tmpFileName ) == false )
@@ -585,6 +669,40 @@ Node::BuildResult ObjectNode::DoBuildWithPreProcessor2( Job * job, bool useDeopt
             return NODE_RESULT_FAILED; // BuildArgs will have emitted an error
         }
     }
+    else if ( job->IsDataHeaderBundle() && ( job->IsLocal() == false ) )
+    {
+        if ( bundle.LoadFromJob( job ) == false )
+        {
+            job->Error( "Failed to load header bundle. Target: '%s'", GetName().Get() );
+            job->OnSystemError();
+            return NODE_RESULT_FAILED;
+        }
+
+        // Recreate the client's layout of the source and headers
+        // (on disk, so files can be linked from the HeaderStore)
+        WorkerThread::GetDiskTempFileDirectory( includeRoot );
+        includeRoot += "root";
+        includeRoot += NATIVE_SLASH;
+        AStackString<> error;
+        if ( HeaderStore::Get().CreateRoot( bundle, includeRoot, error ) == false )
+        {
+            HeaderStore::DeleteRoot( bundle, includeRoot );
+            job->Error( "Failed to create include root. %s Target: '%s'", error.Get(), GetName().Get() );
+            job->OnSystemError();
+            return NODE_RESULT_FAILED;
+        }
+        AStackString<> sourceFile;
+        HeaderBundle::GetPathInRoot( includeRoot, bundle.GetFileName( 0 ), sourceFile );
+
+        const bool showIncludes( false );
+        const bool useSourceMapping( true );
+        const bool finalize( true );
+        if ( !BuildArgs( job, fullArgs, PASS_COMPILE, useDeoptimization, showIncludes, useSourceMapping, finalize, sourceFile, includeRoot ) )
+        {
+            HeaderStore::DeleteRoot( bundle, includeRoot );
+            return NODE_RESULT_FAILED; // BuildArgs will have emitted an error
+        }
+    }
     else
     {
         const bool showIncludes( false );
@@ -607,6 +725,12 @@ Node::BuildResult ObjectNode::DoBuildWithPreProcessor2( Job * job, bool useDeopt
 
     bool result = BuildFinalOutput( job, fullArgs );
 
+    // report the headers used from outside the include root
+    if ( result && ( includeRoot.IsEmpty() == false ) )
+    {
+        result = RecordUnshippedHeaders( job, includeRoot );
+    }
+
     // cleanup temp file
     if ( tmpFileName.IsEmpty() == false )
     {
@@ -619,6 +743,23 @@ Node::BuildResult ObjectNode::DoBuildWithPreProcessor2( Job * job, bool useDeopt
         FileIO::DirectoryDelete( tmpDirectoryName );
     }
 
+    // cleanup include root, hiding it from any errors or warnings
+    if ( includeRoot.IsEmpty() == false )
+    {
+        const AStackString<> rootPrefix( includeRoot.Get(), includeRoot.GetEnd() - 1 ); // keep the leading slash of client paths
+        Array< AString > messages( job->GetMessages() );
+        for ( AString & message : messages )
+        {
+            message.Replace( rootPrefix.Get(), "" );
+        }
+        job->SetMessages( messages );
+
+        HeaderStore::DeleteRoot( bundle, includeRoot );
+        AStackString<> depFile;
+        GetIncludeRootDepFile( includeRoot, depFile );
+        FileIO::FileDelete( depFile.Get() );
+    }
+
     if ( result == false )
     {
         return NODE_RESULT_FAILED; // BuildFinalOutput will have emitted error
@@ -629,6 +770,7 @@ Node::BuildResult ObjectNode::DoBuildWithPreProcessor2( Job * job, bool useDeopt
     {
         // record new file time
         RecordStampFromBuiltFile();
+        RecordPCHContentHash();
 
         const bool useCache = ShouldUseCache();
         if ( m_Stamp && useCache )
@@ -730,6 +872,7 @@ Node::BuildResult ObjectNode::DoBuild_QtRCC( Job * job )
     EmitCompilationMessage( fullArgs, useDeoptimization );
 
     // spawn the process
+    JobPhaseScope phaseScope( BuildTrace::PHASE_COMPILE, job );
     CompileHelper ch;
     if ( !ch.SpawnCompiler( job, GetName(), GetCompiler(), GetCompiler()->GetExecutable(), fullArgs ) )
     {
@@ -1003,10 +1146,12 @@ bool ObjectNode::ProcessIncludesWithPreProcessor( Job * job )
     if ( flags & ( ObjectNode::FLAG_CLANG | ObjectNode::FLAG_GCC | ObjectNode::FLAG_SNC | ObjectNode::CODEWARRIOR_WII | ObjectNode::GREENHILLS_WIIU ) )
     {
         // creation of the PCH must be done locally to generate a usable PCH
+        // (unless GCC can create it remotely from the shipped headers)
         // Objective C/C++ cannot be distributed
         // Source mappings are not currently forwarded so can only compiled locally
         const bool hasSourceMapping = ( compilerNode->GetSourceMapping().IsEmpty() == false );
-        if ( !creatingPCH && !objectiveC && !hasSourceMapping )
+        const bool canDistributePCH = ( ( flags & ObjectNode::FLAG_GCC ) != 0 ) && compilerNode->GetUseHeaderShipping();
+        if ( ( !creatingPCH || canDistributePCH ) && !objectiveC && !hasSourceMapping )
         {
             if ( isDistributableCompiler )
             {
@@ -1193,9 +1338,12 @@ const AString & ObjectNode::GetCacheName( Job * job ) const
 
     PROFILE_FUNCTION
 
+    // paths under mapped roots are hashed relative to those roots
+    const CacheRootMappings & cacheRoots = FBuild::Get().GetSettings()->GetCacheRootMappings();
+
     // hash the pre-processed input data
     ASSERT( m_LightCacheKey || job->GetData() );
-    const uint64_t preprocessedSourceKey = m_LightCacheKey ? m_LightCacheKey : xxHash::Calc64( job->GetData(), job->GetDataSize() );
+    const uint64_t preprocessedSourceKey = m_LightCacheKey ? m_LightCacheKey : cacheRoots.Calc64( job->GetData(), job->GetDataSize() );
     ASSERT( preprocessedSourceKey );
 
     // hash the build "environment"
@@ -1218,7 +1366,7 @@ const AString & ObjectNode::GetCacheName( Job * job ) const
             args += sourceMapping;
         }
 
-        commandLineKey = xxHash::Calc32( args.GetRawArgs().Get(), args.GetRawArgs().GetLength() );
+        commandLineKey = cacheRoots.Calc32( args.GetRawArgs() );
     }
     ASSERT( commandLineKey );
 
@@ -1251,6 +1399,8 @@ bool ObjectNode::RetrieveFromCache( Job * job )
     }
 
     PROFILE_FUNCTION
+    JobPhaseScope phaseScope( BuildTrace::PHASE_CACHE_RETRIEVE, job );
+    BuildMetricsScope metricsScope( BuildMetrics::METRIC_CACHE_READ );
 
     const AString & cacheFileName = GetCacheName(job);
 
@@ -1264,6 +1414,7 @@ bool ObjectNode::RetrieveFromCache( Job * job )
     if ( cache->Retrieve( cacheFileName, cacheData, cacheDataSize ) )
     {
         const uint32_t retrieveTime = uint32_t( t.GetElapsedMS() );
+        metricsScope.SetBytes( cacheDataSize );
 
         // Hash the PCH result if we will need it later
         uint64_t pchKey = 0;
@@ -1275,6 +1426,7 @@ bool ObjectNode::RetrieveFromCache( Job * job )
         const uint32_t startDecompress = uint32_t( t.GetElapsedMS() );
 
         // do decompression
+        const int64_t decompressStartTime = Timer::GetNow();
         Compressor c;
         if ( c.IsValidData( cacheData, cacheDataSize ) == false )
         {
@@ -1296,6 +1448,7 @@ bool ObjectNode::RetrieveFromCache( Job * job )
         const size_t dataSize = c.GetResultSize();
 
         const uint32_t stopDecompress = uint32_t( t.GetElapsedMS() );
+        BuildMetrics::RecordTicks( BuildMetrics::METRIC_CACHE_DECOMPRESS, Timer::GetNow() - decompressStartTime, dataSize );
 
         MultiBuffer buffer( data, dataSize );
 
@@ -1334,6 +1487,7 @@ bool ObjectNode::RetrieveFromCache( Job * job )
         // record new file time (note that time may differ from what we set above due to
         // file system precision)
         RecordStampFromBuiltFile();
+        RecordPCHContentHash();
 
         // Output
         if ( FBuild::Get().GetOptions().m_ShowCommandSummary ||
@@ -1381,6 +1535,8 @@ void ObjectNode::WriteToCache( Job * job )
     }
 
     PROFILE_FUNCTION
+    JobPhaseScope phaseScope( BuildTrace::PHASE_CACHE_STORE, job );
+    BuildMetricsScope metricsScope( BuildMetrics::METRIC_CACHE_WRITE );
 
     const AString & cacheFileName = GetCacheName(job);
     ASSERT(!cacheFileName.IsEmpty());
@@ -1411,6 +1567,7 @@ void ObjectNode::WriteToCache( Job * job )
         {
             // cache store complete
             const uint32_t stopPublish( (uint32_t)t.GetElapsedMS() );
+            metricsScope.SetBytes( dataSize );
 
             SetStatFlag( Node::STATS_CACHE_STORE );
 
@@ -1599,9 +1756,226 @@ void ObjectNode::EmitCompilationMessage( const Args & fullArgs, bool useDeoptimi
 }
 
 
+// RemapIncludePath
+//------------------------------------------------------------------------------
+/*static*/ bool ObjectNode::RemapIncludePath( const Job * job, const AString & includeRoot, const Array< AString > & tokens, size_t & index, Args & fullArgs )
+{
+    // NOTE: -isystem-after must be checked before -isystem
+    static const char * const prefixes[] = { "-isystem-after", "-isystem", "-iquote", "-I" };
+
+    // The whole arg may be quoted (i.e. "-Ipath")
+    AStackString<> token( tokens[ index ] );
+    if ( ( token.GetLength() >= 2 ) && token.BeginsWith( '"' ) && token.EndsWith( '"' ) )
+    {
+        token.Assign( token.Get() + 1, token.GetEnd() - 1 );
+    }
+
+    for ( const char * prefix : prefixes )
+    {
+        if ( token.BeginsWith( prefix ) == false )
+        {
+            continue;
+        }
+
+        // Get include path part (which may be in the next token)
+        AStackString<> includePath;
+        const size_t prefixLen = AString::StrLen( prefix );
+        if ( token.GetLength() == prefixLen )
+        {
+            if ( ( index + 1 ) >= tokens.GetSize() )
+            {
+                return false; // malformed - leave it to the compiler to complain
+            }
+            ++index;
+            includePath = tokens[ index ];
+        }
+        else
+        {
+            includePath.Assign( token.Get() + prefixLen, token.GetEnd() );
+        }
+
+        // strip quotes if present
+        if ( ( includePath.GetLength() >= 2 ) && includePath.BeginsWith( '"' ) && includePath.EndsWith( '"' ) )
+        {
+            includePath.Assign( includePath.Get() + 1, includePath.GetEnd() - 1 );
+        }
+
+        // Relative paths are relative to the client's working dir
+        AStackString<> fullPath;
+        if ( PathUtils::IsFullPath( includePath ) == false )
+        {
+            fullPath = job->GetRemoteSourceRoot();
+            PathUtils::EnsureTrailingSlash( fullPath );
+        }
+        fullPath += includePath;
+        NodeGraph::CleanPath( fullPath );
+
+        AStackString<> pathInRoot;
+        HeaderBundle::GetPathInRoot( includeRoot, fullPath, pathInRoot );
+        fullArgs += prefix;
+        fullArgs += '"';
+        fullArgs += pathInRoot;
+        fullArgs += '"';
+        fullArgs.AddDelimiter();
+        return true;
+    }
+    return false;
+}
+
+// CanUseHeaderShipping
+//------------------------------------------------------------------------------
+bool ObjectNode::CanUseHeaderShipping( bool useCache ) const
+{
+    if ( GetCompiler()->GetUseHeaderShipping() == false )
+    {
+        return false;
+    }
+
+    // A worker's system headers didn't match ours
+    if ( AtomicLoadRelaxed( &m_HeaderShippingRejected ) )
+    {
+        return false;
+    }
+
+    // Must be possible to build remotely
+    if ( ( GetFlag( FLAG_CAN_BE_DISTRIBUTED ) && m_AllowDistribution && FBuild::Get().GetOptions().m_AllowDistributed ) == false )
+    {
+        return false;
+    }
+
+    // Only GCC can create a PCH in the include root. Clang PCHs record the
+    // paths of the headers they were created from, so must be created locally.
+    if ( GetFlag( FLAG_CREATING_PCH ) && ( GetFlag( FLAG_GCC ) == false ) )
+    {
+        return false;
+    }
+
+    // A PCH is shipped along with the headers, if it could be hashed
+    if ( GetFlag( FLAG_USING_PCH ) )
+    {
+        if ( m_PrecompiledHeader.IsEmpty() || ( GetPrecompiledHeader()->GetPCHContentHash() == 0 ) )
+        {
+            return false;
+        }
+    }
+
+    // Cache keys are calculated from the preprocessed output
+    if ( useCache && ( GetCompiler()->GetUseLightCache() == false ) )
+    {
+        return false;
+    }
+
+    // Options which pull in files the include graph doesn't see
+    Array< AString > tokens( 64, true );
+    m_CompilerOptions.Tokenize( tokens );
+    for ( const AString & token : tokens )
+    {
+        if ( token.BeginsWith( "-include" ) ||      // also -include-pch
+             token.BeginsWith( "-imacros" ) ||
+             token.BeginsWith( "-isysroot" ) ||
+             token.BeginsWith( "--sysroot" ) ||
+             token.BeginsWith( "-idirafter" ) ||
+             token.BeginsWith( "-iprefix" ) ||
+             token.BeginsWith( "-iwithprefix" ) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// GetIncludeRootDepFile
+//------------------------------------------------------------------------------
+/*static*/ void ObjectNode::GetIncludeRootDepFile( const AString & includeRoot, AString & outDepFile )
+{
+    outDepFile.Assign( includeRoot.Get(), includeRoot.GetEnd() - 1 ); // beside the root
+    outDepFile += ".d";
+}
+
+// RecordUnshippedHeaders
+//------------------------------------------------------------------------------
+bool ObjectNode::RecordUnshippedHeaders( Job * job, const AString & includeRoot ) const
+{
+    // The compiler lists every file it read (see BuildArgs)
+    AStackString<> depFileName;
+    GetIncludeRootDepFile( includeRoot, depFileName );
+    AString depFile;
+    FileStream fs;
+    if ( fs.Open( depFileName.Get(), FileStream::READ_ONLY ) )
+    {
+        depFile.SetLength( (uint32_t)fs.GetFileSize() );
+        if ( fs.ReadBuffer( depFile.Get(), depFile.GetLength() ) != depFile.GetLength() )
+        {
+            depFile.Clear();
+        }
+    }
+    Array< AString > files( 256, true );
+    if ( HeaderBundle::ParseDependencies( depFile, files ) == false )
+    {
+        job->Error( "Failed to read dependencies '%s'. Target: '%s'", depFileName.Get(), GetName().Get() );
+        job->OnSystemError();
+        return false;
+    }
+
+    // Shipped files are in the root. The compiler runs in the toolchain dir, so
+    // relative paths are also in the toolchain, which is verified by its hash.
+    AStackString<> toolchainPath;
+    job->GetToolManifest()->GetRemotePath( toolchainPath );
+    Array< AString > & headers = job->GetUnshippedHeaders();
+    Array< uint64_t > & contentHashes = job->GetUnshippedHeaderHashes();
+    for ( const AString & file : files )
+    {
+        if ( file.BeginsWith( includeRoot ) ||
+             file.BeginsWith( toolchainPath ) ||
+             ( PathUtils::IsFullPath( file ) == false ) )
+        {
+            continue;
+        }
+
+        uint64_t contentHash;
+        if ( GetFileContentHash( file, contentHash ) == false )
+        {
+            job->Error( "Failed to hash header '%s'. Target: '%s'", file.Get(), GetName().Get() );
+            job->OnSystemError();
+            return false;
+        }
+        headers.Append( file );
+        contentHashes.Append( contentHash );
+    }
+    return true;
+}
+
+// RejectHeaderShipping
+//------------------------------------------------------------------------------
+void ObjectNode::RejectHeaderShipping()
+{
+    AtomicStoreRelaxed( &m_HeaderShippingRejected, true );
+}
+
+// RecordPCHContentHash
+//------------------------------------------------------------------------------
+void ObjectNode::RecordPCHContentHash()
+{
+    // Only PCHs which can be shipped are hashed
+    if ( ( GetFlag( FLAG_CREATING_PCH ) && GetFlag( FLAG_GCC ) && GetCompiler()->GetUseHeaderShipping() ) == false )
+    {
+        return;
+    }
+
+    // Users of the PCH will build locally if it can't be hashed, or is too
+    // large to send
+    FileIO::FileInfo info;
+    if ( ( FileIO::GetFileInfo( m_Name, info ) == false ) ||
+         ( info.m_Size > HeaderBundle::MAX_FILE_SIZE ) ||
+         ( GetFileContentHash( m_Name, m_PCHContentHash ) == false ) )
+    {
+        m_PCHContentHash = 0;
+    }
+}
+
 // BuildArgs
 //------------------------------------------------------------------------------
-bool ObjectNode::BuildArgs( const Job * job, Args & fullArgs, Pass pass, bool useDeoptimization, bool showIncludes, bool useSourceMapping, bool finalize, const AString & overrideSrcFile ) const
+bool ObjectNode::BuildArgs( const Job * job, Args & fullArgs, Pass pass, bool useDeoptimization, bool showIncludes, bool useSourceMapping, bool finalize, const AString & overrideSrcFile, const AString & includeRoot ) const
 {
     PROFILE_FUNCTION
 
@@ -1847,6 +2221,31 @@ bool ObjectNode::BuildArgs( const Job * job, Args & fullArgs, Pass pass, bool us
             }
         }
 
+        // Compiling a header bundle in a virtual include root
+        if ( includeRoot.IsEmpty() == false )
+        {
+            ASSERT( isClang || isGCC );
+
+            // Remove dependency file generation so it's only performed on local system
+            // (the worker writes its own, to report system headers)
+            if ( StripToken( "-MD", token ) || StripToken( "-MMD", token ) )
+            {
+                continue;
+            }
+            if ( StripTokenWithArg( "-MF", token, i ) ||
+                 StripTokenWithArg( "-MT", token, i ) ||
+                 StripTokenWithArg( "-MQ", token, i ) )
+            {
+                continue; // skip this token in both cases
+            }
+
+            // Include paths must point inside the root
+            if ( RemapIncludePath( job, includeRoot, tokens, i, fullArgs ) )
+            {
+                continue;
+            }
+        }
+
         // Remove static analyzer from clang preprocessor
         if ( pass == PASS_PREPROCESSOR_ONLY )
         {
@@ -2082,6 +2481,21 @@ bool ObjectNode::BuildArgs( const Job * job, Args & fullArgs, Pass pass, bool us
         fullArgs += " -fdiagnostics-color=always";
     }
 
+    // Record the client's paths (not the include root) in debug info and __FILE__
+    if ( includeRoot.IsEmpty() == false )
+    {
+        const AStackString<> rootPrefix( includeRoot.Get(), includeRoot.GetEnd() - 1 ); // keep the leading slash of client paths
+        AStackString<> tmp;
+        tmp.Format( " \"-fdebug-prefix-map=%s=\" \"-fmacro-prefix-map=%s=\"", rootPrefix.Get(), rootPrefix.Get() );
+        fullArgs += tmp;
+
+        // List the files used, to report the system headers (see RecordUnshippedHeaders)
+        AStackString<> depFile;
+        GetIncludeRootDepFile( includeRoot, depFile );
+        tmp.Format( " -MD -MF \"%s\"", depFile.Get() );
+        fullArgs += tmp;
+    }
+
     if ( useSourceMapping && job->IsLocal() )
     {
         if ( isClang || isGCC )
@@ -2144,6 +2558,9 @@ void ObjectNode::ExpandCompilerForceUsing( Args & fullArgs, const AString & pre,
 //------------------------------------------------------------------------------
 bool ObjectNode::BuildPreprocessedOutput( const Args & fullArgs, Job * job, bool useDeoptimization ) const
 {
+    JobPhaseScope phaseScope( BuildTrace::PHASE_PREPROCESS, job );
+    BuildMetricsScope metricsScope( BuildMetrics::METRIC_PREPROCESS );
+
     const bool useDedicatedPreprocessor = ( GetDedicatedPreprocessor() != nullptr );
     EmitCompilationMessage( fullArgs, useDeoptimization, false, false, useDedicatedPreprocessor );
 
@@ -2178,6 +2595,7 @@ bool ObjectNode::BuildPreprocessedOutput( const Args & fullArgs, Job * job, bool
 
     // take a copy of the output because ReadAllData uses huge buffers to avoid re-sizing
     TransferPreprocessedData( ch.GetOut().Get(), ch.GetOut().GetLength(), job );
+    metricsScope.SetBytes( ch.GetOut().GetLength() );
 
     return true;
 }
@@ -2187,6 +2605,7 @@ bool ObjectNode::BuildPreprocessedOutput( const Args & fullArgs, Job * job, bool
 bool ObjectNode::LoadStaticSourceFileForDistribution( const Args & fullArgs, Job * job, bool useDeoptimization ) const
 {
     // PreProcessing for SimpleDistribution is just loading the source file
+    JobPhaseScope phaseScope( BuildTrace::PHASE_PREPROCESS, job );
 
     const bool useDedicatedPreprocessor = ( GetDedicatedPreprocessor() != nullptr );
     EmitCompilationMessage(fullArgs, useDeoptimization, false, false, useDedicatedPreprocessor);
@@ -2407,9 +2826,11 @@ bool ObjectNode::WriteTmpFile( Job * job, AString & tmpDirectory, AString & tmpF
     Compressor c; // scoped here so we can access decompression buffer
     if ( job->IsDataCompressed() )
     {
+        BuildMetricsScope metricsScope( BuildMetrics::METRIC_DECOMPRESS );
         VERIFY( c.Decompress( dataToWrite ) );
         dataToWrite = c.GetResult();
         dataToWriteSize = c.GetResultSize();
+        metricsScope.SetBytes( dataToWriteSize );
     }
 
     WorkerThread::GetTempFileDirectory( tmpDirectory );
@@ -2441,12 +2862,17 @@ bool ObjectNode::WriteTmpFile( Job * job, AString & tmpDirectory, AString & tmpF
         return NODE_RESULT_FAILED;
     }
     tmpFile.Close();
+    if ( MemoryStaging::IsThreadStagingInMemory() == false )
+    {
+        job->AddDiskBytesWritten( dataToWriteSize );
+    }
 
     FileIO::WorkAroundForWindowsFilePermissionProblem( tmpFileName );
 
     // On remote workers, free compressed buffer as we don't need it anymore
     // This reduces memory consumed on the remote worker.
-    if ( job->IsLocal() == false )
+    // (Unless staged in memory, as the job may need to be tried again on disk)
+    if ( ( job->IsLocal() == false ) && ( MemoryStaging::IsThreadStagingInMemory() == false ) )
     {
         job->OwnData( nullptr, 0, false ); // Free compressed buffer
     }
@@ -2473,6 +2899,7 @@ bool ObjectNode::BuildFinalOutput( Job * job, const Args & fullArgs ) const
     }
 
     // spawn the process
+    JobPhaseScope phaseScope( BuildTrace::PHASE_COMPILE, job );
     CompileHelper ch( true, job->GetAbortFlagPointer() );
     if ( !ch.SpawnCompiler( job, GetName(), GetCompiler(), compiler, fullArgs, workingDir.IsEmpty() ? nullptr : workingDir.Get() ) )
     {
@@ -2550,12 +2977,34 @@ bool ObjectNode::CompileHelper::SpawnCompiler( Job * job,
         environmentString = compilerNode->GetEnvironmentString();
     }
 
+    // Isolate remote jobs in their own cgroup if the worker is configured to
+    AStackString<> cgroupDir;
+    AStackString<> cgroupProcs;
+    if ( ( job->IsLocal() == false ) && WorkerCGroups::IsValid() )
+    {
+        if ( WorkerCGroups::Get().CreateJobGroup( cgroupDir ) == false )
+        {
+            job->Error( "Failed to create cgroup. Error: %s Target: '%s'\n", LAST_ERROR_STR, name.Get() );
+            job->OnSystemError();
+            return false;
+        }
+        #if defined( __LINUX__ )
+            cgroupProcs.Format( "%s/cgroup.procs", cgroupDir.Get() );
+            m_Process.SetCGroupProcsFile( cgroupProcs.Get() );
+        #endif
+    }
+
     // spawn the process
     if ( false == m_Process.Spawn( compiler.Get(),
                                    fullArgs.GetFinalArgs().Get(),
                                    workingDir,
                                    environmentString ) )
     {
+        if ( cgroupDir.IsEmpty() == false )
+        {
+            WorkerCGroups::Get().DestroyJobGroup( cgroupDir );
+        }
+
         if ( m_Process.HasAborted() )
         {
             return false;
@@ -2571,6 +3020,19 @@ bool ObjectNode::CompileHelper::SpawnCompiler( Job * job,
 
     // Get result
     m_Result = m_Process.WaitForExit();
+
+    // Record resource usage. A cgroup accounts for the whole process tree,
+    // including processes which were not waited for. Workers only report a
+    // cgroup's peak memory, as the process's is approximate (0 = unknown).
+    uint64_t peakMemory = job->IsLocal() ? m_Process.GetPeakMemoryBytes() : 0;
+    uint64_t cpuTime = m_Process.GetCPUTimeUS();
+    if ( cgroupDir.IsEmpty() == false )
+    {
+        WorkerCGroups::Get().ReadJobUsage( cgroupDir, peakMemory, cpuTime );
+        WorkerCGroups::Get().DestroyJobGroup( cgroupDir );
+    }
+    job->AddResourceUsage( peakMemory, cpuTime );
+
     if ( m_Process.HasAborted() )
     {
         return false;
@@ -96,7 +96,12 @@ public:
     const char * GetObjExtension() const;
 
     const AString & GetPCHObjectName() const { return m_PCHObjectFileName; }
+    inline uint64_t GetPCHContentHash() const { return m_PCHContentHash; }
     const AString & GetOwnerObjectList() const { return m_OwnerObjectList; }
+
+    // A worker compiled a header bundle with system headers which differ from
+    // ours, so preprocess from now on (see RecordUnshippedHeaders)
+    void RejectHeaderShipping();
 private:
     virtual BuildResult DoBuild( Job * job ) override;
     virtual BuildResult DoBuild2( Job * job, bool racingRemoteJob ) override;
@@ -131,7 +136,12 @@ private:
     static bool StripTokenWithArg_MSVC( const char * tokenToCheckFor, const AString & token, size_t & index );
     static bool StripToken( const char * tokenToCheckFor, const AString & token, bool allowStartsWith = false );
     static bool StripToken_MSVC( const char * tokenToCheckFor, const AString & token, bool allowStartsWith = false );
-    bool BuildArgs( const Job * job, Args & fullArgs, Pass pass, bool useDeoptimization, bool useShowIncludes, bool useSourceMapping, bool finalize, const AString & overrideSrcFile = AString::GetEmpty() ) const;
+    bool BuildArgs( const Job * job, Args & fullArgs, Pass pass, bool useDeoptimization, bool useShowIncludes, bool useSourceMapping, bool finalize, const AString & overrideSrcFile = AString::GetEmpty(), const AString & includeRoot = AString::GetEmpty() ) const;
+    static bool RemapIncludePath( const Job * job, const AString & includeRoot, const Array< AString > & tokens, size_t & index, Args & fullArgs );
+    bool CanUseHeaderShipping( bool useCache ) const;
+    static void GetIncludeRootDepFile( const AString & includeRoot, AString & outDepFile );
+    bool RecordUnshippedHeaders( Job * job, const AString & includeRoot ) const;
+    void RecordPCHContentHash();
 
     void ExpandCompilerForceUsing( Args & fullArgs, const AString & pre, const AString & post ) const;
     bool BuildPreprocessedOutput( const Args & fullArgs, Job * job, bool useDeoptimization ) const;
@@ -206,12 +216,14 @@ private:
     uint32_t            m_Flags                             = 0;
     uint32_t            m_PreprocessorFlags                 = 0;
     uint64_t            m_PCHCacheKey                       = 0;
+    uint64_t            m_PCHContentHash                    = 0;
     uint64_t            m_LightCacheKey                     = 0;
     AString             m_OwnerObjectList; // TODO:C This could be a pointer to the node in the future
 
     // Not serialized
     Array< AString >    m_Includes;
     bool                m_Remote                            = false;
+    bool                m_HeaderShippingRejected            = false;
 };
 
 //------------------------------------------------------------------------------
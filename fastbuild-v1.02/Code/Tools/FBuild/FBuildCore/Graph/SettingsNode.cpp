@@ -5,6 +5,7 @@
 //------------------------------------------------------------------------------
 #include "SettingsNode.h"
 
+#include "Tools/FBuild/FBuildCore/Error.h"
 #include "Tools/FBuild/FBuildCore/FBuild.h"
 #include "Tools/FBuild/FBuildCore/FLog.h"
 #include "Tools/FBuild/FBuildCore/BFF/Functions/Function.h"
@@ -31,6 +32,7 @@ REFLECT_NODE_BEGIN( SettingsNode, Node, MetaNone() )
     REFLECT(        m_CachePathMountPoint,      "CachePathMountPoint",      MetaOptional() )
     REFLECT(        m_CachePluginDLL,           "CachePluginDLL",           MetaOptional() )
     REFLECT(        m_CachePluginDLLConfig,     "CachePluginDLLConfig",     MetaOptional() )
+    REFLECT_ARRAY(  m_CacheRootMappings,        "CacheRootMappings",        MetaOptional() )
     REFLECT_ARRAY(  m_Workers,                  "Workers",                  MetaOptional() )
     REFLECT(        m_WorkerConnectionLimit,    "WorkerConnectionLimit",    MetaOptional() )
     REFLECT(        m_DistributableJobMemoryLimitMiB, "DistributableJobMemoryLimitMiB", MetaOptional() + MetaRange( DIST_MEMORY_LIMIT_MIN, DIST_MEMORY_LIMIT_MAX ) )
@@ -52,7 +54,7 @@ SettingsNode::SettingsNode()
 
 // Initialize
 //------------------------------------------------------------------------------
-/*virtual*/ bool SettingsNode::Initialize( NodeGraph & /*nodeGraph*/, const BFFToken * /*iter*/, const Function * /*function*/ )
+/*virtual*/ bool SettingsNode::Initialize( NodeGraph & /*nodeGraph*/, const BFFToken * iter, const Function * function )
 {
     // using a cache plugin?
     if ( m_CachePluginDLL.IsEmpty() == false )
@@ -60,6 +62,22 @@ SettingsNode::SettingsNode()
         FLOG_VERBOSE( "CachePluginDLL: '%s'", m_CachePluginDLL.Get() );
     }
 
+    // "CacheRootMappings" - roots are made absolute once, here
+    for ( AString & mapping : m_CacheRootMappings )
+    {
+        AStackString<> root;
+        AStackString<> name;
+        if ( CacheRootMappings::ParseMapping( mapping, root, name ) == false )
+        {
+            Error::Error_1106_MissingRequiredToken( iter, function, ".CacheRootMappings", "=" );
+            return false;
+        }
+        AStackString<> cleanRoot;
+        NodeGraph::CleanPath( root, cleanRoot );
+        mapping.Format( "%s=%s", cleanRoot.Get(), name.Get() );
+    }
+    ProcessCacheRootMappings();
+
     // "Environment"
     if ( m_Environment.IsEmpty() == false )
     {
@@ -80,6 +98,13 @@ SettingsNode::~SettingsNode() = default;
     return false;
 }
 
+// PostLoad
+//------------------------------------------------------------------------------
+/*virtual*/ void SettingsNode::PostLoad( NodeGraph & /*nodeGraph*/ )
+{
+    ProcessCacheRootMappings();
+}
+
 // GetCachePath
 //------------------------------------------------------------------------------
 const AString & SettingsNode::GetCachePath() const
@@ -158,4 +183,18 @@ void SettingsNode::ProcessEnvironment( const Array< AString > & envStrings ) con
     FBuild::Get().SetEnvironmentString( envString.Get(), size, libEnvVar );
 }
 
+// ProcessCacheRootMappings
+//------------------------------------------------------------------------------
+void SettingsNode::ProcessCacheRootMappings()
+{
+    for ( const AString & mapping : m_CacheRootMappings )
+    {
+        AStackString<> root;
+        AStackString<> name;
+        VERIFY( CacheRootMappings::ParseMapping( mapping, root, name ) ); // Validated in Initialize
+        m_CacheRoots.Add( root, name );
+        FLOG_VERBOSE( "CacheRootMapping: '%s' -> '%s'", root.Get(), name.Get() );
+    }
+}
+
 //------------------------------------------------------------------------------
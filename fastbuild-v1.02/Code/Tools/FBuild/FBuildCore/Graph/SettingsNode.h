@@ -5,6 +5,7 @@
 // Includes
 //------------------------------------------------------------------------------
 #include "Node.h"
+#include "Tools/FBuild/FBuildCore/Cache/CacheRootMappings.h"
 
 // Forward Declarations
 //------------------------------------------------------------------------------
@@ -23,12 +24,14 @@ public:
     static inline Node::Type GetTypeS() { return Node::SETTINGS_NODE; }
 
     virtual bool IsAFile() const override;
+    virtual void PostLoad( NodeGraph & nodeGraph ) override;
 
     // Access to settings
     const AString &                     GetCachePath() const;
     const AString &                     GetCachePathMountPoint() const;
     const AString &                     GetCachePluginDLL() const;
     const AString &                     GetCachePluginDLLConfig() const;
+    inline const CacheRootMappings &    GetCacheRootMappings() const { return m_CacheRoots; }
     inline const Array< AString > &     GetWorkerList() const { return m_Workers; }
     uint32_t                            GetWorkerConnectionLimit() const { return m_WorkerConnectionLimit; }
     uint32_t                            GetDistributableJobMemoryLimitMiB() const { return m_DistributableJobMemoryLimitMiB; }
@@ -36,6 +39,7 @@ public:
 
 private:
     void ProcessEnvironment( const Array< AString > & envStrings ) const;
+    void ProcessCacheRootMappings();
 
     // Settings from environment variables
     AString             m_CachePathFromEnvVar;
@@ -48,10 +52,14 @@ private:
     AString             m_CachePathMountPoint;
     AString             m_CachePluginDLL;
     AString             m_CachePluginDLLConfig;
+    Array< AString  >   m_CacheRootMappings;
     Array< AString  >   m_Workers;
     uint32_t            m_WorkerConnectionLimit;
     uint32_t            m_DistributableJobMemoryLimitMiB;
     bool                m_DisableDBMigration; // TODO:C Remove this option some time after v0.99
+
+    // Internal State
+    CacheRootMappings   m_CacheRoots;
 };
 
 //------------------------------------------------------------------------------
@@ -5,16 +5,23 @@
 //------------------------------------------------------------------------------
 #include "TestNode.h"
 
+#include "Tools/FBuild/FBuildCore/Cache/ICache.h"
+#include "Tools/FBuild/FBuildCore/Error.h"
 #include "Tools/FBuild/FBuildCore/FBuild.h"
 #include "Tools/FBuild/FBuildCore/FLog.h"
 #include "Tools/FBuild/FBuildCore/Graph/NodeGraph.h"
 #include "Tools/FBuild/FBuildCore/Graph/DirectoryListNode.h"
+#include "Tools/FBuild/FBuildCore/Graph/SettingsNode.h"
 #include "Tools/FBuild/FBuildCore/BFF/Functions/Function.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/Job.h"
 
+#include "Core/Env/Env.h"
 #include "Core/Env/ErrorFormat.h"
 #include "Core/FileIO/FileIO.h"
 #include "Core/FileIO/FileStream.h"
 #include "Core/Math/Conversions.h"
+#include "Core/Math/xxHash.h"
+#include "Core/Profile/Profile.h"
 #include "Core/Strings/AStackString.h"
 #include "Core/Process/Process.h"
 
@@ -33,11 +40,15 @@ REFLECT_NODE_BEGIN( TestNode, Node, MetaName( "TestOutput" ) + MetaFile() )
     REFLECT(        m_TestWorkingDir,           "TestWorkingDir",           MetaOptional() + MetaPath() )
     REFLECT(        m_TestTimeOut,              "TestTimeOut",              MetaOptional() + MetaRange( 0, 4 * 60 * 60 ) ) // 4hrs
     REFLECT(        m_TestAlwaysShowOutput,     "TestAlwaysShowOutput",     MetaOptional() )
+    REFLECT(        m_TestCacheable,            "TestCacheable",            MetaOptional() )
+    REFLECT(        m_TestShards,               "TestShards",               MetaOptional() + MetaRange( 1, 256 ) )
     REFLECT_ARRAY(  m_PreBuildDependencyNames,  "PreBuildDependencies",     MetaOptional() + MetaFile() + MetaAllowNonFile() )
     REFLECT_ARRAY(  m_Environment,              "Environment",              MetaOptional() )
 
     // Internal State
     REFLECT(        m_NumTestInputFiles,        "NumTestInputFiles",        MetaHidden() )
+    REFLECT(        m_IsShard,                  "IsShard",                  MetaHidden() )
+    REFLECT(        m_ShardIndex,               "ShardIndex",               MetaHidden() )
 REFLECT_END( TestNode )
 
 // CONSTRUCTOR
@@ -50,7 +61,11 @@ TestNode::TestNode()
     , m_TestTimeOut( 0 )
     , m_TestAlwaysShowOutput( false )
     , m_TestInputPathRecurse( true )
+    , m_TestCacheable( false )
+    , m_TestShards( 1 )
     , m_NumTestInputFiles( 0 )
+    , m_IsShard( false )
+    , m_ShardIndex( 0 )
     , m_EnvironmentString( nullptr )
 {
     m_Type = Node::TEST_NODE;
@@ -107,6 +122,12 @@ TestNode::TestNode()
     m_StaticDependencies.Append( testInputFiles );
     m_StaticDependencies.Append( testInputPaths );
 
+    // .TestShards
+    if ( HasShards() )
+    {
+        return CreateShards( nodeGraph, iter, function );
+    }
+
     return true;
 }
 
@@ -121,7 +142,47 @@ TestNode::~TestNode()
 //------------------------------------------------------------------------------
 const char * TestNode::GetEnvironmentString() const
 {
-    return Node::GetEnvironmentString( m_Environment, m_EnvironmentString );
+    if ( ( m_IsShard == false ) || m_EnvironmentString )
+    {
+        return Node::GetEnvironmentString( m_Environment, m_EnvironmentString );
+    }
+
+    // A shard always needs its own environment, based on the one it would
+    // otherwise have inherited
+    Array< AString > envVars;
+    const char * buildEnvString = FBuild::IsValid() ? FBuild::Get().GetEnvironmentString() : nullptr;
+    if ( m_Environment.IsEmpty() == false )
+    {
+        envVars.Append( m_Environment );
+    }
+    else if ( buildEnvString )
+    {
+        for ( const char * pos = buildEnvString; *pos; pos += ( AString::StrLen( pos ) + 1 ) )
+        {
+            envVars.EmplaceBack( pos );
+        }
+    }
+    else
+    {
+        Env::GetEnvironment( envVars );
+    }
+
+    // Replace any sharding settings with our own (as understood by GoogleTest)
+    for ( int32_t i = (int32_t)envVars.GetSize() - 1; i >= 0; --i )
+    {
+        if ( envVars[ (size_t)i ].BeginsWith( "GTEST_TOTAL_SHARDS=" ) ||
+             envVars[ (size_t)i ].BeginsWith( "GTEST_SHARD_INDEX=" ) )
+        {
+            envVars.EraseIndex( (size_t)i );
+        }
+    }
+    AStackString<> shardVar;
+    shardVar.Format( "GTEST_TOTAL_SHARDS=%u", m_TestShards );
+    envVars.Append( shardVar );
+    shardVar.Format( "GTEST_SHARD_INDEX=%u", m_ShardIndex );
+    envVars.Append( shardVar );
+
+    return Node::GetEnvironmentString( envVars, m_EnvironmentString );
 }
 
 // DoDynamicDependencies
@@ -170,6 +231,33 @@ const char * TestNode::GetEnvironmentString() const
 //------------------------------------------------------------------------------
 /*virtual*/ Node::BuildResult TestNode::DoBuild( Job * job )
 {
+    // The shards have done the work
+    if ( HasShards() )
+    {
+        return MergeShards();
+    }
+
+    // Restore the output of an identical passing run
+    AStackString<> cacheName;
+    Array< AString > cacheFileNames( 1, false );
+    cacheFileNames.Append( m_Name );
+    const bool useCache = ShouldUseCache() && GetCacheName( cacheName );
+    if ( useCache && RetrieveFilesFromCache( cacheName, cacheFileNames, "Running Test: " ) )
+    {
+        if ( m_TestAlwaysShowOutput )
+        {
+            FileStream fs;
+            AString output;
+            if ( fs.Open( m_Name.Get(), FileStream::READ_ONLY ) )
+            {
+                output.SetLength( (uint32_t)fs.GetFileSize() );
+                fs.ReadBuffer( output.Get(), output.GetLength() );
+            }
+            Node::DumpOutput( job, output );
+        }
+        return NODE_RESULT_OK;
+    }
+
     // If the workingDir is empty, use the current dir for the process
     const char * workingDir = m_TestWorkingDir.IsEmpty() ? nullptr : m_TestWorkingDir.Get();
 
@@ -202,6 +290,7 @@ const char * TestNode::GetEnvironmentString() const
 
     // Get result
     int result = p.WaitForExit();
+    job->AddResourceUsage( p.GetPeakMemoryBytes(), p.GetCPUTimeUS() );
     if ( p.HasAborted() )
     {
         return NODE_RESULT_FAILED;
@@ -249,9 +338,154 @@ const char * TestNode::GetEnvironmentString() const
     // record new file time
     RecordStampFromBuiltFile();
 
+    if ( useCache )
+    {
+        WriteFilesToCache( cacheName, cacheFileNames, "Running Test: " );
+    }
+
+    return NODE_RESULT_OK;
+}
+
+// CreateShards
+//------------------------------------------------------------------------------
+bool TestNode::CreateShards( NodeGraph & nodeGraph, const BFFToken * iter, const Function * function )
+{
+    Dependencies shards( m_TestShards, false );
+    for ( uint32_t i = 0; i < m_TestShards; ++i )
+    {
+        AStackString<> shardName;
+        shardName.Format( "%s.shard%u", m_Name.Get(), i );
+        if ( nodeGraph.FindNode( shardName ) )
+        {
+            Error::Error_1100_AlreadyDefined( iter, function, shardName );
+            return false;
+        }
+
+        // Each shard runs the same test, with the same inputs
+        TestNode * shard = nodeGraph.CreateTestNode( shardName );
+        shard->m_TestExecutable = m_TestExecutable;
+        shard->m_TestInput = m_TestInput;
+        shard->m_TestInputPath = m_TestInputPath;
+        shard->m_TestInputPattern = m_TestInputPattern;
+        shard->m_TestInputExcludePath = m_TestInputExcludePath;
+        shard->m_TestInputExcludedFiles = m_TestInputExcludedFiles;
+        shard->m_TestInputExcludePattern = m_TestInputExcludePattern;
+        shard->m_TestArguments = m_TestArguments;
+        shard->m_TestWorkingDir = m_TestWorkingDir;
+        shard->m_TestTimeOut = m_TestTimeOut;
+        shard->m_TestAlwaysShowOutput = m_TestAlwaysShowOutput;
+        shard->m_TestInputPathRecurse = m_TestInputPathRecurse;
+        shard->m_TestCacheable = m_TestCacheable;
+        shard->m_TestShards = m_TestShards;
+        shard->m_PreBuildDependencyNames = m_PreBuildDependencyNames;
+        shard->m_Environment = m_Environment;
+        shard->m_IsShard = true;
+        shard->m_ShardIndex = i;
+        if ( !shard->Initialize( nodeGraph, iter, function ) )
+        {
+            return false; // Initialize will have emitted an error
+        }
+        shards.EmplaceBack( shard );
+    }
+    m_StaticDependencies.Append( shards );
+    return true;
+}
+
+// MergeShards
+//------------------------------------------------------------------------------
+Node::BuildResult TestNode::MergeShards()
+{
+    FileStream fs;
+    if ( fs.Open( GetName().Get(), FileStream::WRITE_ONLY ) == false )
+    {
+        FLOG_ERROR( "Failed to open test output file '%s'", GetName().Get() );
+        return NODE_RESULT_FAILED;
+    }
+
+    // Shards follow the executable, inputs and input paths
+    const size_t firstShard = ( 1 + m_NumTestInputFiles + m_TestInputPath.GetSize() );
+    for ( size_t i = firstShard; i < m_StaticDependencies.GetSize(); ++i )
+    {
+        const AString & shardOutput = m_StaticDependencies[ i ].GetNode()->GetName();
+        FileStream shardFs;
+        AString output;
+        if ( shardFs.Open( shardOutput.Get(), FileStream::READ_ONLY ) == false )
+        {
+            FLOG_ERROR( "Failed to open test output file '%s'", shardOutput.Get() );
+            return NODE_RESULT_FAILED;
+        }
+        output.SetLength( (uint32_t)shardFs.GetFileSize() );
+        if ( ( shardFs.ReadBuffer( output.Get(), output.GetLength() ) != output.GetLength() ) ||
+             ( fs.Write( output.Get(), output.GetLength() ) != output.GetLength() ) )
+        {
+            FLOG_ERROR( "Failed to write test output file '%s'", GetName().Get() );
+            return NODE_RESULT_FAILED;
+        }
+    }
+    fs.Close();
+
+    // record new file time
+    RecordStampFromBuiltFile();
+
     return NODE_RESULT_OK;
 }
 
+// ShouldUseCache
+//------------------------------------------------------------------------------
+bool TestNode::ShouldUseCache() const
+{
+    return m_TestCacheable &&
+           ( FBuild::Get().GetOptions().m_UseCacheRead ||
+             FBuild::Get().GetOptions().m_UseCacheWrite );
+}
+
+// GetCacheName
+//------------------------------------------------------------------------------
+bool TestNode::GetCacheName( AString & outCacheName ) const
+{
+    PROFILE_FUNCTION
+
+    // The executable and declared data files, by content
+    uint64_t toolKey;
+    if ( GetFileContentHash( GetTestExecutable()->GetName(), toolKey ) == false )
+    {
+        return false;
+    }
+    Array< uint64_t > inputHashes( m_NumTestInputFiles + m_DynamicDependencies.GetSize(), false );
+    for ( size_t i = 1; i < ( 1 + m_NumTestInputFiles ); ++i ) // Note: Skip first dep (executable)
+    {
+        uint64_t hash;
+        if ( GetFileContentHash( m_StaticDependencies[ i ].GetNode()->GetName(), hash ) == false )
+        {
+            return false;
+        }
+        inputHashes.Append( hash );
+    }
+    for ( const Dependency & dep : m_DynamicDependencies ) // files found in .TestInputPath
+    {
+        uint64_t hash;
+        if ( GetFileContentHash( dep.GetNode()->GetName(), hash ) == false )
+        {
+            return false;
+        }
+        inputHashes.Append( hash );
+    }
+    const uint64_t inputsKey = xxHash::Calc64( inputHashes.Begin(), inputHashes.GetSize() * sizeof( uint64_t ) );
+
+    // Everything else which affects the run
+    AStackString< 4 * KILOBYTE > commandLine( m_TestArguments );
+    commandLine.AppendFormat( "|%s|%u|%u", m_TestWorkingDir.Get(), m_IsShard ? m_TestShards : 1, m_ShardIndex );
+    for ( const AString & envVar : m_Environment )
+    {
+        commandLine += '|';
+        commandLine += envVar;
+    }
+    const uint32_t commandLineKey = FBuild::Get().GetSettings()->GetCacheRootMappings().Calc32( commandLine );
+
+    ICache::GetCacheId( inputsKey, commandLineKey, toolKey, 0, outCacheName );
+    return true;
+}
+
 // EmitCompilationMessage
 //------------------------------------------------------------------------------
 void TestNode::EmitCompilationMessage( const char * workingDir ) const
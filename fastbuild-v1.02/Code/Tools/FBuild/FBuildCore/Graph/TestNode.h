@@ -31,6 +31,17 @@ private:
 
     void EmitCompilationMessage( const char * workingDir ) const;
 
+    // Sharding: with .TestShards > 1, the Test() node depends on one shard
+    // node per shard (each running the executable with the gtest sharding
+    // env vars set) and merges their output.
+    bool CreateShards( NodeGraph & nodeGraph, const BFFToken * iter, const Function * function );
+    BuildResult MergeShards();
+    inline bool HasShards() const { return ( m_TestShards > 1 ) && ( m_IsShard == false ); }
+
+    // Caching
+    bool ShouldUseCache() const;
+    bool GetCacheName( AString & outCacheName ) const;
+
     AString             m_TestExecutable;
     Array< AString >    m_TestInput;
     Array< AString >    m_TestInputPath;
@@ -43,11 +54,15 @@ private:
     uint32_t            m_TestTimeOut;
     bool                m_TestAlwaysShowOutput;
     bool                m_TestInputPathRecurse;
+    bool                m_TestCacheable;
+    uint32_t            m_TestShards;
     Array< AString >    m_PreBuildDependencyNames;
     Array< AString >    m_Environment;
 
     // Internal State
     uint32_t            m_NumTestInputFiles;
+    bool                m_IsShard;
+    uint32_t            m_ShardIndex;
     mutable const char * m_EnvironmentString;
 };
 
@@ -0,0 +1,321 @@
+// BuildMetrics - Always-on counters and histograms for build phases
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "BuildMetrics.h"
+
+// Core
+#include "Core/Env/Assert.h"
+#include "Core/FileIO/FileStream.h"
+#include "Core/Process/Atomic.h"
+#include "Core/Strings/AString.h"
+#include "Core/Time/Timer.h"
+
+// system
+#include <string.h> // for memset
+
+// Defines
+//------------------------------------------------------------------------------
+// Each thread which records metrics claims its own set of counters so updates
+// are never contended. Threads beyond this limit share the last set (updates
+// are atomic so this is safe, just slower).
+#define BUILD_METRICS_MAX_THREADS ( 128 )
+
+// Static Data
+//------------------------------------------------------------------------------
+/*static*/ BuildMetrics::Values BuildMetrics::s_StartValues[ BuildMetrics::NUM_METRICS ];
+/*static*/ BuildMetrics::Values BuildMetrics::s_BuildValues[ BuildMetrics::NUM_METRICS ];
+static BuildMetrics::Values g_BuildMetricsThreadValues[ BUILD_METRICS_MAX_THREADS ][ BuildMetrics::NUM_METRICS ];
+static volatile uint32_t g_BuildMetricsNumThreads = 0;
+static THREAD_LOCAL BuildMetrics::Values * g_BuildMetricsLocalValues = nullptr;
+
+// GetThreadValues
+//------------------------------------------------------------------------------
+static BuildMetrics::Values * GetThreadValues()
+{
+    if ( g_BuildMetricsLocalValues == nullptr )
+    {
+        uint32_t index = AtomicIncU32( &g_BuildMetricsNumThreads ) - 1;
+        if ( index >= BUILD_METRICS_MAX_THREADS )
+        {
+            index = ( BUILD_METRICS_MAX_THREADS - 1 );
+        }
+        g_BuildMetricsLocalValues = g_BuildMetricsThreadValues[ index ];
+    }
+    return g_BuildMetricsLocalValues;
+}
+
+// GetBucket
+//------------------------------------------------------------------------------
+static uint32_t GetBucket( uint64_t timeUS )
+{
+    uint32_t bucket = 0;
+    while ( ( timeUS != 0 ) && ( bucket < ( BuildMetrics::NUM_BUCKETS - 1 ) ) )
+    {
+        timeUS >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+// Record
+//------------------------------------------------------------------------------
+/*static*/ void BuildMetrics::Record( Metric metric, uint64_t timeUS, uint64_t bytes )
+{
+    ASSERT( metric < NUM_METRICS );
+    ASSERT( IsTimed( metric ) );
+    Values & values = GetThreadValues()[ metric ];
+    AtomicIncU64( &values.m_Count );
+    AtomicAddU64( &values.m_TotalUS, (int64_t)timeUS );
+    if ( bytes )
+    {
+        AtomicAddU64( &values.m_Bytes, (int64_t)bytes );
+    }
+    AtomicIncU64( &values.m_Buckets[ GetBucket( timeUS ) ] );
+}
+
+// RecordTicks
+//------------------------------------------------------------------------------
+/*static*/ void BuildMetrics::RecordTicks( Metric metric, int64_t ticks, uint64_t bytes )
+{
+    const double timeUS = ( (double)ticks * 1000000.0 / (double)Timer::GetFrequency() );
+    Record( metric, ( timeUS > 0.0 ) ? (uint64_t)timeUS : 0, bytes );
+}
+
+// RecordBytes
+//------------------------------------------------------------------------------
+/*static*/ void BuildMetrics::RecordBytes( Metric metric, uint64_t bytes )
+{
+    ASSERT( metric < NUM_METRICS );
+    ASSERT( IsTimed( metric ) == false );
+    Values & values = GetThreadValues()[ metric ];
+    AtomicIncU64( &values.m_Count );
+    AtomicAddU64( &values.m_Bytes, (int64_t)bytes );
+}
+
+// StartBuild
+//------------------------------------------------------------------------------
+/*static*/ void BuildMetrics::StartBuild()
+{
+    Gather( s_StartValues );
+    memset( s_BuildValues, 0, sizeof( s_BuildValues ) );
+}
+
+// StopBuild
+//------------------------------------------------------------------------------
+/*static*/ void BuildMetrics::StopBuild()
+{
+    Gather( s_BuildValues );
+    for ( uint32_t m = 0; m < NUM_METRICS; ++m )
+    {
+        Values & build = s_BuildValues[ m ];
+        const Values & start = s_StartValues[ m ];
+        build.m_Count -= start.m_Count;
+        build.m_TotalUS -= start.m_TotalUS;
+        build.m_Bytes -= start.m_Bytes;
+        for ( uint32_t b = 0; b < NUM_BUCKETS; ++b )
+        {
+            build.m_Buckets[ b ] -= start.m_Buckets[ b ];
+        }
+    }
+}
+
+// WriteJSON
+//------------------------------------------------------------------------------
+/*static*/ bool BuildMetrics::WriteJSON( const AString & fileName )
+{
+    AString buffer( 16 * 1024 );
+    buffer += "{\n\"version\":1,\n\"bucketsUS\":\"bucket N counts samples < 2^N us\",\n\"metrics\":{\n";
+    for ( uint32_t m = 0; m < NUM_METRICS; ++m )
+    {
+        const Values & values = s_BuildValues[ m ];
+        buffer.AppendFormat( "\"%s\":{\"count\":%" PRIu64 ",\"totalUS\":%" PRIu64 ",\"bytes\":%" PRIu64 ",\"p50US\":%" PRIu64 ",\"p90US\":%" PRIu64 ",\"p99US\":%" PRIu64 ",\"buckets\":[",
+                             GetMetricName( (Metric)m ),
+                             values.m_Count,
+                             values.m_TotalUS,
+                             values.m_Bytes,
+                             GetPercentileUS( values, 50 ),
+                             GetPercentileUS( values, 90 ),
+                             GetPercentileUS( values, 99 ) );
+        for ( uint32_t b = 0; b < NUM_BUCKETS; ++b )
+        {
+            buffer.AppendFormat( ( b == 0 ) ? "%" PRIu64 : ",%" PRIu64, values.m_Buckets[ b ] );
+        }
+        buffer += ( m == ( NUM_METRICS - 1 ) ) ? "]}\n" : "]},\n";
+    }
+    buffer += "}\n}\n";
+
+    FileStream fs;
+    if ( fs.Open( fileName.Get(), FileStream::WRITE_ONLY ) == false )
+    {
+        return false;
+    }
+    return ( fs.Write( buffer.Get(), buffer.GetLength() ) == buffer.GetLength() );
+}
+
+// WritePrometheus
+//------------------------------------------------------------------------------
+/*static*/ bool BuildMetrics::WritePrometheus( const AString & fileName )
+{
+    // Text exposition format, suitable for node_exporter's textfile collector
+    AString buffer( 32 * 1024 );
+    buffer += "# HELP fastbuild_phase_seconds Time spent in each phase of the last build.\n"
+              "# TYPE fastbuild_phase_seconds histogram\n";
+    for ( uint32_t m = 0; m < NUM_METRICS; ++m )
+    {
+        if ( IsTimed( (Metric)m ) == false )
+        {
+            continue;
+        }
+        const Values & values = s_BuildValues[ m ];
+        const char * name = GetMetricName( (Metric)m );
+        uint64_t cumulative = 0;
+        for ( uint32_t b = 0; b < ( NUM_BUCKETS - 1 ); ++b ) // Last bucket is unbounded (+Inf)
+        {
+            cumulative += values.m_Buckets[ b ];
+            const double le = ( (double)( (uint64_t)1 << b ) / 1000000.0 );
+            buffer.AppendFormat( "fastbuild_phase_seconds_bucket{phase=\"%s\",le=\"%.6f\"} %" PRIu64 "\n", name, le, cumulative );
+        }
+        buffer.AppendFormat( "fastbuild_phase_seconds_bucket{phase=\"%s\",le=\"+Inf\"} %" PRIu64 "\n", name, values.m_Count );
+        buffer.AppendFormat( "fastbuild_phase_seconds_sum{phase=\"%s\"} %.6f\n", name, (double)values.m_TotalUS / 1000000.0 );
+        buffer.AppendFormat( "fastbuild_phase_seconds_count{phase=\"%s\"} %" PRIu64 "\n", name, values.m_Count );
+    }
+    buffer += "# HELP fastbuild_phase_bytes_total Bytes processed in each phase of the last build.\n"
+              "# TYPE fastbuild_phase_bytes_total counter\n";
+    for ( uint32_t m = 0; m < NUM_METRICS; ++m )
+    {
+        if ( HasBytes( (Metric)m ) == false )
+        {
+            continue;
+        }
+        buffer.AppendFormat( "fastbuild_phase_bytes_total{phase=\"%s\"} %" PRIu64 "\n", GetMetricName( (Metric)m ), s_BuildValues[ m ].m_Bytes );
+    }
+
+    FileStream fs;
+    if ( fs.Open( fileName.Get(), FileStream::WRITE_ONLY ) == false )
+    {
+        return false;
+    }
+    return ( fs.Write( buffer.Get(), buffer.GetLength() ) == buffer.GetLength() );
+}
+
+// GetMetricName
+//------------------------------------------------------------------------------
+/*static*/ const char * BuildMetrics::GetMetricName( Metric metric )
+{
+    static const char * const names[] =
+    {
+        "queue_wait",
+        "preprocess",
+        "compress",
+        "send",
+        "remote_compile",
+        "receive",
+        "decompress",
+        "cache_read",
+        "cache_decompress",
+        "cache_write",
+        "memory_wait",
+        "remote_disk_write",
+        "copy_reflink",
+        "copy_hardlink",
+        "copy_kernel",
+        "copy_bytes",
+    };
+    static_assert( ( sizeof( names ) / sizeof( names[ 0 ] ) ) == NUM_METRICS, "Metric names out of sync" );
+    ASSERT( metric < NUM_METRICS );
+    return names[ metric ];
+}
+
+// IsTimed
+//------------------------------------------------------------------------------
+/*static*/ bool BuildMetrics::IsTimed( Metric metric )
+{
+    // Only bytes are known for these (see RecordBytes)
+    return ( metric != METRIC_REMOTE_DISK_WRITE );
+}
+
+// HasBytes
+//------------------------------------------------------------------------------
+/*static*/ bool BuildMetrics::HasBytes( Metric metric )
+{
+    switch ( metric )
+    {
+        case METRIC_QUEUE_WAIT:
+        case METRIC_REMOTE_COMPILE:
+        case METRIC_MEMORY_WAIT:
+            return false; // Waits and times only
+        default:
+            return true;
+    }
+}
+
+// GetPercentileUS
+//------------------------------------------------------------------------------
+/*static*/ uint64_t BuildMetrics::GetPercentileUS( const Values & values, uint32_t percentile )
+{
+    if ( values.m_Count == 0 )
+    {
+        return 0;
+    }
+
+    // Return the upper bound of the bucket containing the percentile
+    const uint64_t target = ( ( values.m_Count * percentile ) + 99 ) / 100;
+    uint64_t cumulative = 0;
+    for ( uint32_t b = 0; b < NUM_BUCKETS; ++b )
+    {
+        cumulative += values.m_Buckets[ b ];
+        if ( cumulative >= target )
+        {
+            return ( (uint64_t)1 << b );
+        }
+    }
+    return ( (uint64_t)1 << ( NUM_BUCKETS - 1 ) );
+}
+
+// Gather
+//------------------------------------------------------------------------------
+/*static*/ void BuildMetrics::Gather( Values * outValues )
+{
+    memset( outValues, 0, sizeof( Values ) * NUM_METRICS );
+
+    uint32_t numThreads = AtomicLoadRelaxed( &g_BuildMetricsNumThreads );
+    if ( numThreads > BUILD_METRICS_MAX_THREADS )
+    {
+        numThreads = BUILD_METRICS_MAX_THREADS;
+    }
+    for ( uint32_t t = 0; t < numThreads; ++t )
+    {
+        for ( uint32_t m = 0; m < NUM_METRICS; ++m )
+        {
+            const Values & src = g_BuildMetricsThreadValues[ t ][ m ];
+            Values & dst = outValues[ m ];
+            dst.m_Count += AtomicLoadRelaxed( &src.m_Count );
+            dst.m_TotalUS += AtomicLoadRelaxed( &src.m_TotalUS );
+            dst.m_Bytes += AtomicLoadRelaxed( &src.m_Bytes );
+            for ( uint32_t b = 0; b < NUM_BUCKETS; ++b )
+            {
+                dst.m_Buckets[ b ] += AtomicLoadRelaxed( &src.m_Buckets[ b ] );
+            }
+        }
+    }
+}
+
+// BuildMetricsScope (CONSTRUCTOR)
+//------------------------------------------------------------------------------
+BuildMetricsScope::BuildMetricsScope( BuildMetrics::Metric metric, uint64_t bytes )
+    : m_StartTime( Timer::GetNow() )
+    , m_Bytes( bytes )
+    , m_Metric( metric )
+{
+}
+
+// BuildMetricsScope (DESTRUCTOR)
+//------------------------------------------------------------------------------
+BuildMetricsScope::~BuildMetricsScope()
+{
+    BuildMetrics::RecordTicks( m_Metric, Timer::GetNow() - m_StartTime, m_Bytes );
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,94 @@
+// BuildMetrics - Always-on counters and histograms for build phases
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Env/Types.h"
+
+// Forward Declarations
+//------------------------------------------------------------------------------
+class AString;
+
+// BuildMetrics
+//------------------------------------------------------------------------------
+class BuildMetrics
+{
+public:
+    // Bytes for (de)compression are the uncompressed size
+    enum Metric : uint8_t
+    {
+        METRIC_QUEUE_WAIT,      // Job queued -> picked up (locally or by a worker)
+        METRIC_PREPROCESS,
+        METRIC_COMPRESS,
+        METRIC_SEND,            // Serializing and sending a job to a worker
+        METRIC_REMOTE_COMPILE,  // Compile time reported by the worker
+        METRIC_RECEIVE,         // Handling a job result from a worker
+        METRIC_DECOMPRESS,      // Job input decompressed by the worker
+        METRIC_CACHE_READ,
+        METRIC_CACHE_DECOMPRESS,
+        METRIC_CACHE_WRITE,
+        METRIC_MEMORY_WAIT,     // Local worker thread waiting for the memory budget
+        METRIC_REMOTE_DISK_WRITE, // Temp file bytes written to disk by the worker (no time)
+        METRIC_COPY_REFLINK,    // File copies, by FileIO::CopyMethod (same order)
+        METRIC_COPY_HARDLINK,
+        METRIC_COPY_KERNEL,
+        METRIC_COPY_BYTES,
+
+        NUM_METRICS
+    };
+
+    // Histogram buckets are powers of 2 in microseconds ( bucket N counts times < 2^N us )
+    static const uint32_t NUM_BUCKETS = 32;
+
+    struct Values
+    {
+        uint64_t m_Count;
+        uint64_t m_TotalUS;
+        uint64_t m_Bytes;
+        uint64_t m_Buckets[ NUM_BUCKETS ];
+    };
+
+    // Record a sample on the calling thread (lock-free)
+    static void Record( Metric metric, uint64_t timeUS, uint64_t bytes = 0 );
+    static void RecordTicks( Metric metric, int64_t ticks, uint64_t bytes = 0 );
+    static void RecordBytes( Metric metric, uint64_t bytes ); // for metrics which aren't timed
+
+    // Metrics for a build are the difference between snapshots at start and stop
+    static void StartBuild();
+    static void StopBuild();
+    static const Values & GetBuildValues( Metric metric ) { return s_BuildValues[ metric ]; }
+
+    // Output
+    static bool WriteJSON( const AString & fileName );
+    static bool WritePrometheus( const AString & fileName );
+
+    static const char * GetMetricName( Metric metric );
+    static bool         IsTimed( Metric metric );
+    static bool         HasBytes( Metric metric );
+    static uint64_t     GetPercentileUS( const Values & values, uint32_t percentile );
+
+private:
+    static void Gather( Values * outValues );
+
+    static Values s_StartValues[ NUM_METRICS ];
+    static Values s_BuildValues[ NUM_METRICS ];
+};
+
+// BuildMetricsScope - Time a scope
+//------------------------------------------------------------------------------
+class BuildMetricsScope
+{
+public:
+    explicit BuildMetricsScope( BuildMetrics::Metric metric, uint64_t bytes = 0 );
+    ~BuildMetricsScope();
+
+    inline void SetBytes( uint64_t bytes ) { m_Bytes = bytes; }
+
+private:
+    int64_t                 m_StartTime;
+    uint64_t                m_Bytes;
+    BuildMetrics::Metric    m_Metric;
+};
+
+//------------------------------------------------------------------------------
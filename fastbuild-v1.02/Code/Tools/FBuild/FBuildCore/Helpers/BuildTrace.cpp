@@ -0,0 +1,386 @@
+// BuildTrace - Record a timeline of all build jobs (Chrome/Perfetto format)
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "BuildTrace.h"
+
+// FBuild
+#include "Tools/FBuild/FBuildCore/FLog.h"
+#include "Tools/FBuild/FBuildCore/Helpers/CompilationDatabase.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/WorkerThread.h"
+
+// Core
+#include "Core/Containers/Array.h"
+#include "Core/FileIO/FileStream.h"
+#include "Core/Network/Network.h"
+#include "Core/Process/Mutex.h"
+#include "Core/Strings/AStackString.h"
+#include "Core/Strings/AString.h"
+#include "Core/Time/Timer.h"
+
+// Defines
+//------------------------------------------------------------------------------
+// Tracks encode the worker (0 == local machine) in the upper bits and the
+// thread/slot in the lower bits
+#define BUILD_TRACE_TRACK( worker, slot )   ( ( (uint32_t)( worker ) << 16 ) | (uint32_t)( slot ) )
+#define BUILD_TRACE_TRACK_WORKER( track )   ( ( track ) >> 16 )
+#define BUILD_TRACE_TRACK_SLOT( track )     ( ( track ) & 0xFFFF )
+
+// BuildTraceEvent
+//------------------------------------------------------------------------------
+struct BuildTraceEvent
+{
+    const Node *        m_Node;
+    const char *        m_Info; // Optional static string
+    int64_t             m_StartTime;
+    int64_t             m_EndTime;
+    uint32_t            m_Track;
+    BuildTrace::Phase   m_Phase;
+};
+
+// BuildTraceWorker
+//------------------------------------------------------------------------------
+struct BuildTraceWorker
+{
+    AString             m_Name;
+    Array< bool >       m_SlotsInUse;
+};
+
+// BuildTraceData
+//------------------------------------------------------------------------------
+struct BuildTraceData
+{
+    int64_t                         m_StartTime = 0;
+    uint32_t                        m_MaxLocalThreadIndex = 0;
+    Array< BuildTraceEvent >        m_Events;
+    Array< BuildTraceWorker * >     m_Workers; // Remote workers (index 0 is worker 1)
+};
+
+// Static Data
+//------------------------------------------------------------------------------
+/*static*/ volatile bool BuildTrace::s_Enabled( false );
+static Mutex g_BuildTraceMutex;
+static BuildTraceData * g_BuildTraceData = nullptr;
+static THREAD_LOCAL uint32_t g_BuildTraceThreadTrack = BuildTrace::INVALID_TRACK;
+
+// Start
+//------------------------------------------------------------------------------
+/*static*/ void BuildTrace::Start()
+{
+    MutexHolder mh( g_BuildTraceMutex );
+    ASSERT( g_BuildTraceData == nullptr );
+    g_BuildTraceData = FNEW( BuildTraceData );
+    g_BuildTraceData->m_Events.SetCapacity( 4096 );
+    g_BuildTraceData->m_StartTime = Timer::GetNow();
+    AtomicStoreRelaxed( &s_Enabled, true );
+}
+
+// Stop
+//------------------------------------------------------------------------------
+/*static*/ bool BuildTrace::Stop( const AString & fileName )
+{
+    // Take ownership of the recorded data
+    BuildTraceData * data;
+    {
+        MutexHolder mh( g_BuildTraceMutex );
+        AtomicStoreRelaxed( &s_Enabled, false );
+        data = g_BuildTraceData;
+        g_BuildTraceData = nullptr;
+    }
+    if ( data == nullptr )
+    {
+        return false;
+    }
+
+    FileStream fs;
+    bool ok = fs.Open( fileName.Get(), FileStream::WRITE_ONLY );
+    if ( ok )
+    {
+        AString buffer( 64 * 1024 );
+        buffer += "{\"traceEvents\":[\n";
+
+        // Local machine
+        AStackString<> hostName;
+        Network::GetHostName( hostName, false );
+        CompilationDatabase::JSONEscape( hostName );
+        buffer.AppendFormat( "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"%s (local)\"}},\n", hostName.Get() );
+        buffer += "{\"name\":\"process_sort_index\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"sort_index\":0}},\n";
+        for ( uint32_t i = 0; i <= data->m_MaxLocalThreadIndex; ++i )
+        {
+            if ( i == 0 )
+            {
+                buffer += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"MainThread\"}},\n";
+            }
+            else
+            {
+                buffer.AppendFormat( "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"WorkerThread_%u\"}},\n", i, i );
+            }
+        }
+
+        // Remote workers
+        for ( size_t w = 0; w < data->m_Workers.GetSize(); ++w )
+        {
+            const BuildTraceWorker * worker = data->m_Workers[ w ];
+            AStackString<> workerName( worker->m_Name );
+            CompilationDatabase::JSONEscape( workerName );
+            const uint32_t pid = (uint32_t)( w + 1 );
+            buffer.AppendFormat( "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":0,\"args\":{\"name\":\"%s\"}},\n", pid, workerName.Get() );
+            buffer.AppendFormat( "{\"name\":\"process_sort_index\",\"ph\":\"M\",\"pid\":%u,\"tid\":0,\"args\":{\"sort_index\":%u}},\n", pid, pid );
+            for ( size_t s = 0; s < worker->m_SlotsInUse.GetSize(); ++s )
+            {
+                buffer.AppendFormat( "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"Slot_%u\"}},\n", pid, (uint32_t)s, (uint32_t)( s + 1 ) );
+            }
+        }
+
+        // Events
+        //  - times are written in microseconds with nanosecond precision so that
+        //    nested phases are never rounded outside of their parent job
+        const double ticksToNS = ( 1000000000.0 / (double)Timer::GetFrequency() );
+        AStackString<> nodeName;
+        AStackString<> workerName;
+        const BuildTraceEvent * const end = data->m_Events.End();
+        for ( const BuildTraceEvent * it = data->m_Events.Begin(); it != end; ++it )
+        {
+            const BuildTraceEvent & e = *it;
+            const int64_t startNS = (int64_t)( (double)( e.m_StartTime - data->m_StartTime ) * ticksToNS );
+            const int64_t endNS = (int64_t)( (double)( e.m_EndTime - data->m_StartTime ) * ticksToNS );
+            const uint32_t worker = BUILD_TRACE_TRACK_WORKER( e.m_Track );
+            const uint32_t slot = BUILD_TRACE_TRACK_SLOT( e.m_Track );
+
+            nodeName = e.m_Node->GetName();
+            CompilationDatabase::JSONEscape( nodeName );
+
+            const bool isJob = ( e.m_Phase == PHASE_JOB );
+            buffer.AppendFormat( "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%u,\"tid\":%u,\"args\":{\"node\":\"%s\"",
+                                 isJob ? nodeName.Get() : GetPhaseName( e.m_Phase ),
+                                 isJob ? e.m_Node->GetTypeName() : "Phase",
+                                 (double)startNS / 1000.0,
+                                 (double)( endNS - startNS ) / 1000.0,
+                                 worker,
+                                 slot,
+                                 nodeName.Get() );
+            if ( isJob )
+            {
+                if ( worker == 0 )
+                {
+                    if ( slot == 0 )
+                    {
+                        workerName = "MainThread";
+                    }
+                    else
+                    {
+                        workerName.Format( "WorkerThread_%u", slot );
+                    }
+                }
+                else
+                {
+                    workerName = data->m_Workers[ worker - 1 ]->m_Name;
+                    CompilationDatabase::JSONEscape( workerName );
+                }
+                buffer.AppendFormat( ",\"worker\":\"%s\"", workerName.Get() );
+            }
+            if ( e.m_Info )
+            {
+                buffer.AppendFormat( ",\"result\":\"%s\"", e.m_Info );
+            }
+            buffer += ( ( it + 1 ) != end ) ? "}},\n" : "}}\n";
+
+            if ( buffer.GetLength() > ( 60 * 1024 ) )
+            {
+                ok &= ( fs.WriteBuffer( buffer.Get(), buffer.GetLength() ) == buffer.GetLength() );
+                buffer.Clear();
+            }
+        }
+
+        // Terminate the array (the last metadata entry has a trailing comma if there are no events)
+        if ( data->m_Events.IsEmpty() )
+        {
+            buffer += "{\"name\":\"trace_empty\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{}}\n";
+        }
+        buffer += "],\n\"displayTimeUnit\":\"ms\"}\n";
+        ok &= ( fs.WriteBuffer( buffer.Get(), buffer.GetLength() ) == buffer.GetLength() );
+        fs.Close();
+    }
+
+    if ( ok == false )
+    {
+        FLOG_ERROR( "Failed to write trace file '%s'", fileName.Get() );
+    }
+
+    // Free recorded data
+    for ( BuildTraceWorker * worker : data->m_Workers )
+    {
+        FDELETE worker;
+    }
+    FDELETE data;
+
+    return ok;
+}
+
+// Record
+//------------------------------------------------------------------------------
+/*static*/ void BuildTrace::Record( Phase phase, const Node * node, int64_t startTime, int64_t endTime, const char * info )
+{
+    if ( IsEnabled() == false )
+    {
+        return;
+    }
+
+    uint32_t track = g_BuildTraceThreadTrack;
+    if ( track == INVALID_TRACK )
+    {
+        track = BUILD_TRACE_TRACK( 0, WorkerThread::GetThreadIndex() );
+    }
+    RecordOnTrack( track, phase, node, startTime, endTime, info );
+}
+
+// RecordOnTrack
+//------------------------------------------------------------------------------
+/*static*/ void BuildTrace::RecordOnTrack( uint32_t track, Phase phase, const Node * node, int64_t startTime, int64_t endTime, const char * info )
+{
+    ASSERT( node );
+    if ( ( IsEnabled() == false ) || ( track == INVALID_TRACK ) )
+    {
+        return;
+    }
+
+    MutexHolder mh( g_BuildTraceMutex );
+    if ( g_BuildTraceData == nullptr )
+    {
+        return; // Stopped since we checked
+    }
+
+    if ( BUILD_TRACE_TRACK_WORKER( track ) == 0 )
+    {
+        const uint32_t threadIndex = BUILD_TRACE_TRACK_SLOT( track );
+        if ( threadIndex > g_BuildTraceData->m_MaxLocalThreadIndex )
+        {
+            g_BuildTraceData->m_MaxLocalThreadIndex = threadIndex;
+        }
+    }
+
+    BuildTraceEvent e;
+    e.m_Node = node;
+    e.m_Info = info;
+    e.m_StartTime = startTime;
+    e.m_EndTime = ( endTime > startTime ) ? endTime : startTime;
+    e.m_Track = track;
+    e.m_Phase = phase;
+    g_BuildTraceData->m_Events.Append( e );
+}
+
+// AcquireRemoteTrack
+//------------------------------------------------------------------------------
+/*static*/ uint32_t BuildTrace::AcquireRemoteTrack( const AString & workerName )
+{
+    if ( IsEnabled() == false )
+    {
+        return INVALID_TRACK;
+    }
+
+    MutexHolder mh( g_BuildTraceMutex );
+    if ( g_BuildTraceData == nullptr )
+    {
+        return INVALID_TRACK;
+    }
+
+    // Find (or add) worker
+    Array< BuildTraceWorker * > & workers = g_BuildTraceData->m_Workers;
+    size_t workerIndex = 0;
+    for ( ; workerIndex < workers.GetSize(); ++workerIndex )
+    {
+        if ( workers[ workerIndex ]->m_Name == workerName )
+        {
+            break;
+        }
+    }
+    if ( workerIndex == workers.GetSize() )
+    {
+        BuildTraceWorker * worker = FNEW( BuildTraceWorker );
+        worker->m_Name = workerName;
+        workers.Append( worker );
+    }
+
+    // Use the first free slot on this worker
+    Array< bool > & slots = workers[ workerIndex ]->m_SlotsInUse;
+    size_t slot = 0;
+    for ( ; slot < slots.GetSize(); ++slot )
+    {
+        if ( slots[ slot ] == false )
+        {
+            break;
+        }
+    }
+    if ( slot == slots.GetSize() )
+    {
+        slots.Append( false );
+    }
+    slots[ slot ] = true;
+
+    return BUILD_TRACE_TRACK( workerIndex + 1, slot );
+}
+
+// ReleaseRemoteTrack
+//------------------------------------------------------------------------------
+/*static*/ void BuildTrace::ReleaseRemoteTrack( uint32_t track )
+{
+    if ( track == INVALID_TRACK )
+    {
+        return;
+    }
+
+    MutexHolder mh( g_BuildTraceMutex );
+    if ( g_BuildTraceData == nullptr )
+    {
+        return;
+    }
+
+    const uint32_t workerIndex = BUILD_TRACE_TRACK_WORKER( track );
+    ASSERT( ( workerIndex > 0 ) && ( workerIndex <= g_BuildTraceData->m_Workers.GetSize() ) );
+    Array< bool > & slots = g_BuildTraceData->m_Workers[ workerIndex - 1 ]->m_SlotsInUse;
+    slots[ BUILD_TRACE_TRACK_SLOT( track ) ] = false;
+}
+
+// SetThreadTrack
+//------------------------------------------------------------------------------
+/*static*/ void BuildTrace::SetThreadTrack( uint32_t track )
+{
+    g_BuildTraceThreadTrack = track;
+}
+
+// GetPhaseName
+//------------------------------------------------------------------------------
+/*static*/ const char * BuildTrace::GetPhaseName( Phase phase )
+{
+    switch ( phase )
+    {
+        case PHASE_JOB:             return "Job";
+        case PHASE_PREPROCESS:      return "Preprocess";
+        case PHASE_COMPRESS:        return "Compress";
+        case PHASE_NETWORK:         return "Network";
+        case PHASE_COMPILE:         return "Compile";
+        case PHASE_CACHE_RETRIEVE:  return "CacheRetrieve";
+        case PHASE_CACHE_STORE:     return "CacheStore";
+        case NUM_PHASES:            break;
+    }
+    ASSERT( false );
+    return "";
+}
+
+// GetResultName
+//------------------------------------------------------------------------------
+/*static*/ const char * BuildTrace::GetResultName( Node::BuildResult result )
+{
+    switch ( result )
+    {
+        case Node::NODE_RESULT_OK:                      return "Built";
+        case Node::NODE_RESULT_NEED_SECOND_BUILD_PASS:  return "Preprocessed";
+        case Node::NODE_RESULT_OK_CACHE:                return "Cached";
+        case Node::NODE_RESULT_FAILED:                  return "Failed";
+    }
+    ASSERT( false );
+    return "";
+}
+
+//------------------------------------------------------------------------------
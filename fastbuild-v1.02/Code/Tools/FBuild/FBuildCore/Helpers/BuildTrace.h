@@ -0,0 +1,63 @@
+// BuildTrace - Record a timeline of all build jobs (Chrome/Perfetto format)
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Tools/FBuild/FBuildCore/Graph/Node.h"
+
+#include "Core/Env/Types.h"
+#include "Core/Process/Atomic.h"
+
+// Forward Declarations
+//------------------------------------------------------------------------------
+class AString;
+
+// BuildTrace
+//------------------------------------------------------------------------------
+class BuildTrace
+{
+public:
+    enum Phase : uint8_t
+    {
+        PHASE_JOB,              // The whole job (named after the node)
+        PHASE_PREPROCESS,
+        PHASE_COMPRESS,
+        PHASE_NETWORK,          // Remote job time not spent compiling (transfer, queuing on worker)
+        PHASE_COMPILE,
+        PHASE_CACHE_RETRIEVE,
+        PHASE_CACHE_STORE,
+
+        NUM_PHASES
+    };
+
+    // Tracks identify the timeline an event is displayed on
+    //  - local threads use their WorkerThread index
+    //  - remote jobs use a slot on the worker they were sent to
+    static const uint32_t INVALID_TRACK = 0xFFFFFFFF;
+
+    // Enable tracing for the duration of a build
+    static void Start();
+    static bool Stop( const AString & fileName );
+
+    static inline bool IsEnabled() { return AtomicLoadRelaxed( &s_Enabled ); }
+
+    // Record a completed event on the current thread's track
+    static void Record( Phase phase, const Node * node, int64_t startTime, int64_t endTime, const char * info = nullptr );
+    static void RecordOnTrack( uint32_t track, Phase phase, const Node * node, int64_t startTime, int64_t endTime, const char * info = nullptr );
+
+    // Manage tracks for jobs in flight on remote workers
+    static uint32_t AcquireRemoteTrack( const AString & workerName );
+    static void     ReleaseRemoteTrack( uint32_t track );
+
+    // Redirect events recorded on this thread to another track
+    static void     SetThreadTrack( uint32_t track );
+
+    static const char * GetPhaseName( Phase phase );
+    static const char * GetResultName( Node::BuildResult result );
+
+private:
+    static volatile bool s_Enabled; // Read without the lock from any thread
+};
+
+//------------------------------------------------------------------------------
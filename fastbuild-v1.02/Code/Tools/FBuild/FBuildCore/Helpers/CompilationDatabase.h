@@ -23,6 +23,8 @@ public:
 
     const AString & Generate( const NodeGraph & nodeGraph, Dependencies & dependencies );
 
+    static void JSONEscape( AString & string );
+
 protected:
     struct ObjectListContext
     {
@@ -37,7 +39,6 @@ protected:
     static void HandleInputFile( const AString & inputFile, const AString & baseDir, void * userData );
     void HandleInputFile( const AString & inputFile, const AString & baseDir, ObjectListContext * ctx );
 
-    static void JSONEscape( AString & string );
     static void Unquote( AString & string );
 
     AString m_Output;
@@ -56,6 +56,13 @@ bool Compressor::IsValidData( const void * data, size_t dataSize ) const
     return true;
 }
 
+// GetUncompressedSize
+//------------------------------------------------------------------------------
+/*static*/ size_t Compressor::GetUncompressedSize( const void * data )
+{
+    return ( (const Header *)data )->m_UncompressedSize;
+}
+
 // Compress
 //------------------------------------------------------------------------------
 bool Compressor::Compress( const void * data, size_t dataSize, int32_t compressionLevel )
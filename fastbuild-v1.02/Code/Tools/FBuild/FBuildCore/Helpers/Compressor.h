@@ -15,6 +15,7 @@ public:
     ~Compressor();
 
     bool IsValidData( const void * data, size_t dataSize ) const;
+    static size_t GetUncompressedSize( const void * data ); // data must be valid
 
     // compressionLevel:
     //   < 0 : use LZ4, with values directly mapping to "acceleration level"
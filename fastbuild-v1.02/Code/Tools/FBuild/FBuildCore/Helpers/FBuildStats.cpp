@@ -7,9 +7,11 @@
 
 // FBuild
 #include "Tools/FBuild/FBuildCore/FBuild.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildMetrics.h"
 #include "Tools/FBuild/FBuildCore/Helpers/Report.h"
 
 // Core
+#include "Core/FileIO/FileIO.h"
 #include "Core/Profile/Profile.h"
 #include "Core/Strings/AStackString.h"
 #include "Core/Tracing/Tracing.h"
@@ -196,6 +198,26 @@ void FBuildStats::OutputSummary() const
         output.AppendFormat( " - Stores     : %u\n", stores );
     }
 
+    // Bytes copied by Copy/CopyDir, by how they were copied
+    {
+        const char * const labels[] = { "Reflink", "Hard Link", "Kernel", "Bytes" };
+        static_assert( ( sizeof( labels ) / sizeof( labels[ 0 ] ) ) == FileIO::NUM_COPY_METHODS, "Labels out of sync" );
+        AStackString<> copyInfo;
+        for ( uint32_t i = 0; i < FileIO::NUM_COPY_METHODS; ++i )
+        {
+            const BuildMetrics::Values & copies = BuildMetrics::GetBuildValues( (BuildMetrics::Metric)( BuildMetrics::METRIC_COPY_REFLINK + i ) );
+            if ( copies.m_Count > 0 )
+            {
+                copyInfo.AppendFormat( " - %-11s: %2.1f MiB (%u files)\n", labels[ i ], (double)copies.m_Bytes / (double)MEGABYTE, (uint32_t)copies.m_Count );
+            }
+        }
+        if ( copyInfo.IsEmpty() == false )
+        {
+            output += "Copy:\n";
+            output += copyInfo;
+        }
+    }
+
     AStackString<> buffer;
     FormatTime( m_TotalBuildTime, buffer );
     output += "Time:\n";
@@ -208,6 +230,21 @@ void FBuildStats::OutputSummary() const
     FormatTime( totalRemoteCPUInSeconds, buffer );
     float remoteRatio = ( totalRemoteCPUInSeconds / m_TotalBuildTime );
     output.AppendFormat( " - Remote CPU : %s (%2.1f:1)\n", buffer.Get(), (double)remoteRatio );
+
+    // Time local worker threads were held back by the memory budget
+    const BuildMetrics::Values & memoryWait = BuildMetrics::GetBuildValues( BuildMetrics::METRIC_MEMORY_WAIT );
+    if ( memoryWait.m_Count > 0 )
+    {
+        FormatTime( (float)( (double)memoryWait.m_TotalUS / (double)1000000 ), buffer );
+        output.AppendFormat( " - Mem Wait   : %s (%u waits)\n", buffer.Get(), (uint32_t)memoryWait.m_Count );
+    }
+
+    // Temp files remote workers couldn't keep in memory
+    const BuildMetrics::Values & remoteDiskWrite = BuildMetrics::GetBuildValues( BuildMetrics::METRIC_REMOTE_DISK_WRITE );
+    if ( remoteDiskWrite.m_Count > 0 )
+    {
+        output.AppendFormat( " - Remote Disk: %2.1f MiB written (%u jobs)\n", (double)remoteDiskWrite.m_Bytes / (double)MEGABYTE, (uint32_t)remoteDiskWrite.m_Count );
+    }
     output += "-----------------------------------------------------------------\n";
 
     OUTPUT( "%s", output.Get() );
@@ -0,0 +1,664 @@
+// HeaderBundle
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "HeaderBundle.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/FBuild.h"
+#include "Tools/FBuild/FBuildCore/FLog.h"
+#include "Tools/FBuild/FBuildCore/Graph/Node.h"
+#include "Tools/FBuild/FBuildCore/Helpers/Compressor.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/Job.h"
+
+// Core
+#include "Core/Containers/Sort.h"
+#include "Core/Env/ErrorFormat.h"
+#include "Core/FileIO/ConstMemoryStream.h"
+#include "Core/FileIO/FileIO.h"
+#include "Core/FileIO/FileStream.h"
+#include "Core/FileIO/MemoryStream.h"
+#include "Core/FileIO/PathUtils.h"
+#include "Core/Strings/AStackString.h"
+
+// Helpers
+//------------------------------------------------------------------------------
+namespace
+{
+    bool ContainsHash( const Array< uint64_t > & hashes, size_t numSortedHashes, uint64_t hash )
+    {
+        size_t low = 0;
+        size_t high = numSortedHashes;
+        while ( low < high )
+        {
+            const size_t mid = ( low + high ) / 2;
+            if ( hashes[ mid ] < hash )
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+        return ( ( low < numSortedHashes ) && ( hashes[ low ] == hash ) );
+    }
+
+    class HeaderStoreEvictionCandidate
+    {
+    public:
+        inline bool operator < ( const HeaderStoreEvictionCandidate & other ) const { return ( m_LastUse < other.m_LastUse ); }
+
+        uint64_t    m_LastUse;
+        uint64_t    m_ContentHash;
+    };
+
+    class DeeperPathFirst
+    {
+    public:
+        inline bool operator () ( const AString & a, const AString & b ) const
+        {
+            return ( a.GetLength() > b.GetLength() );
+        }
+    };
+}
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+HeaderBundle::HeaderBundle()
+    : m_Files( 0, true )
+{
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+HeaderBundle::~HeaderBundle() = default;
+
+// AddFile
+//------------------------------------------------------------------------------
+void HeaderBundle::AddFile( const AString & fileName, uint64_t contentHash )
+{
+    File f;
+    f.m_FileName = fileName;
+    f.m_ContentHash = contentHash;
+    m_Files.Append( f );
+}
+
+// Save
+//------------------------------------------------------------------------------
+void HeaderBundle::Save( IOStream & stream ) const
+{
+    stream.Write( (uint32_t)m_Files.GetSize() );
+    for ( const File & f : m_Files )
+    {
+        stream.Write( f.m_FileName );
+        stream.Write( f.m_ContentHash );
+    }
+}
+
+// Load
+//------------------------------------------------------------------------------
+bool HeaderBundle::Load( IOStream & stream )
+{
+    uint32_t numFiles;
+    if ( stream.Read( numFiles ) == false )
+    {
+        return false;
+    }
+    m_Files.SetCapacity( numFiles );
+    for ( uint32_t i = 0; i < numFiles; ++i )
+    {
+        File f;
+        if ( ( stream.Read( f.m_FileName ) == false ) ||
+             ( stream.Read( f.m_ContentHash ) == false ) )
+        {
+            return false;
+        }
+        m_Files.Append( f );
+    }
+    return ( numFiles > 0 ); // must at least have the source file
+}
+
+// LoadFromJob
+//------------------------------------------------------------------------------
+bool HeaderBundle::LoadFromJob( const Job * job )
+{
+    ASSERT( job->IsDataHeaderBundle() );
+
+    if ( job->IsDataCompressed() )
+    {
+        Compressor c;
+        if ( ( c.IsValidData( job->GetData(), job->GetDataSize() ) == false ) ||
+             ( c.Decompress( job->GetData() ) == false ) )
+        {
+            return false;
+        }
+        ConstMemoryStream ms( c.GetResult(), c.GetResultSize() );
+        return Load( ms );
+    }
+
+    ConstMemoryStream ms( job->GetData(), job->GetDataSize() );
+    return Load( ms );
+}
+
+// SelectContents
+//------------------------------------------------------------------------------
+void HeaderBundle::SelectContents( Array< uint64_t > & knownHashes, Array< uint32_t > & outFiles ) const
+{
+    const size_t numKnownHashes = knownHashes.GetSize(); // only these are sorted
+    const size_t numFiles = m_Files.GetSize();
+    for ( size_t i = 0; i < numFiles; ++i )
+    {
+        const uint64_t contentHash = m_Files[ i ].m_ContentHash;
+        if ( ContainsHash( knownHashes, numKnownHashes, contentHash ) )
+        {
+            continue;
+        }
+
+        // Headers can include themselves, or appear via different paths
+        bool duplicate = false;
+        for ( size_t j = numKnownHashes; j < knownHashes.GetSize(); ++j )
+        {
+            if ( knownHashes[ j ] == contentHash )
+            {
+                duplicate = true;
+                break;
+            }
+        }
+        if ( duplicate )
+        {
+            continue;
+        }
+
+        knownHashes.Append( contentHash );
+        outFiles.Append( (uint32_t)i );
+    }
+    if ( knownHashes.GetSize() != numKnownHashes )
+    {
+        knownHashes.Sort();
+    }
+}
+
+// SaveContents
+//------------------------------------------------------------------------------
+bool HeaderBundle::SaveContents( const Array< uint32_t > & files, IOStream & stream, Array< uint64_t > & outOmittedHashes ) const
+{
+    MemoryStream contents;
+    uint32_t numFiles = 0;
+    for ( const uint32_t index : files )
+    {
+        const File & f = m_Files[ index ];
+
+        // Re-read the file (it might have changed since the bundle was made)
+        MemoryStream data;
+        uint64_t contentHash;
+        if ( ( Node::GetFileContentHash( f.m_FileName, contentHash, &data ) == false ) ||
+             ( contentHash != f.m_ContentHash ) ||
+             ( data.GetSize() > MAX_FILE_SIZE ) )
+        {
+            outOmittedHashes.Append( f.m_ContentHash );
+            continue;
+        }
+
+        contents.Write( f.m_ContentHash );
+        contents.Write( (uint32_t)data.GetSize() );
+        contents.WriteBuffer( data.GetData(), data.GetSize() );
+        ++numFiles;
+    }
+
+    stream.Write( numFiles );
+    if ( numFiles > 0 )
+    {
+        Compressor c;
+        c.Compress( contents.GetData(), contents.GetSize() );
+        stream.Write( (uint32_t)c.GetResultSize() );
+        stream.WriteBuffer( c.GetResult(), c.GetResultSize() );
+    }
+    return ( numFiles == files.GetSize() );
+}
+
+// ForgetContents
+//------------------------------------------------------------------------------
+/*static*/ void HeaderBundle::ForgetContents( Array< uint64_t > & knownHashes, const Array< uint64_t > & omittedHashes )
+{
+    for ( const uint64_t contentHash : omittedHashes )
+    {
+        knownHashes.FindAndErase( contentHash ); // remains sorted
+    }
+}
+
+// GetPathInRoot
+//------------------------------------------------------------------------------
+/*static*/ void HeaderBundle::GetPathInRoot( const AString & root, const AString & fileName, AString & outPath )
+{
+    ASSERT( root.EndsWith( NATIVE_SLASH ) );
+    outPath = root;
+
+    const char * pos = fileName.Get();
+    const bool hasDrive = ( ( pos[ 0 ] != '\000' ) && ( pos[ 1 ] == ':' ) );
+    if ( hasDrive )
+    {
+        outPath += pos[ 0 ]; // C:\ -> C\ (as ':' is not valid in a path)
+        pos += 2;
+    }
+    while ( ( *pos == NATIVE_SLASH ) || ( *pos == OTHER_SLASH ) )
+    {
+        ++pos;
+    }
+    if ( hasDrive )
+    {
+        outPath += NATIVE_SLASH;
+    }
+    outPath += pos;
+
+    #if defined( __WINDOWS__ )
+        outPath.Replace( OTHER_SLASH, NATIVE_SLASH );
+    #endif
+}
+
+// ParseDependencies
+//------------------------------------------------------------------------------
+/*static*/ bool HeaderBundle::ParseDependencies( const AString & depFile, Array< AString > & outFiles )
+{
+    // "target: file file" (with a trailing '\' continuing the list on the next
+    // line) where spaces and '#' in file names are escaped with '\', and '$' is
+    // written as "$$"
+    AStackString<> fileName;
+    bool foundTarget = false;
+    for ( const char * pos = depFile.Get(); ; ++pos )
+    {
+        char c = *pos;
+        if ( ( c == '\\' ) && ( pos[ 1 ] == '\n' ) )
+        {
+            c = ' '; // line continuation
+            pos += 1;
+        }
+        else if ( ( c == '\\' ) && ( pos[ 1 ] == '\r' ) && ( pos[ 2 ] == '\n' ) )
+        {
+            c = ' '; // line continuation
+            pos += 2;
+        }
+        else if ( ( c == '\\' ) && ( ( pos[ 1 ] == ' ' ) || ( pos[ 1 ] == '#' ) ) )
+        {
+            fileName += pos[ 1 ];
+            ++pos;
+            continue;
+        }
+        else if ( ( c == '$' ) && ( pos[ 1 ] == '$' ) )
+        {
+            fileName += c;
+            ++pos;
+            continue;
+        }
+
+        if ( ( c == ' ' ) || ( c == '\t' ) || ( c == '\r' ) || ( c == '\n' ) || ( c == '\000' ) )
+        {
+            if ( fileName.IsEmpty() == false )
+            {
+                if ( foundTarget )
+                {
+                    outFiles.Append( fileName );
+                }
+                else if ( fileName.EndsWith( ':' ) )
+                {
+                    foundTarget = true;
+                }
+                fileName.Clear();
+            }
+
+            // Only the first rule lists the files (-MP adds an empty rule per header)
+            if ( ( c == '\000' ) || ( foundTarget && ( c == '\n' ) ) )
+            {
+                break;
+            }
+            continue;
+        }
+        fileName += c;
+    }
+    return foundTarget;
+}
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+HeaderStore::HeaderStore( const AString & path, uint64_t budget )
+    : m_Path( path )
+    , m_Budget( budget )
+    , m_BytesInUse( 0 )
+    , m_UseCount( 0 )
+{
+    PathUtils::EnsureTrailingSlash( m_Path );
+
+    // Clients don't know what we had before we started, so start empty
+    Array< AString > files( 1024, true );
+    FileIO::GetFiles( m_Path, AStackString<>( "*" ), false, &files );
+    for ( const AString & file : files )
+    {
+        FileIO::FileDelete( file.Get() );
+    }
+    FileIO::EnsurePathExists( m_Path );
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+HeaderStore::~HeaderStore() = default;
+
+// LoadContents
+//------------------------------------------------------------------------------
+bool HeaderStore::LoadContents( IOStream & stream, Array< uint64_t > & clientHashes )
+{
+    uint32_t numFiles;
+    if ( stream.Read( numFiles ) == false )
+    {
+        return false;
+    }
+    if ( numFiles == 0 )
+    {
+        return true;
+    }
+
+    uint32_t compressedSize;
+    if ( stream.Read( compressedSize ) == false )
+    {
+        return false;
+    }
+    AString compressed;
+    compressed.SetLength( compressedSize );
+    if ( stream.ReadBuffer( compressed.Get(), compressedSize ) != compressedSize )
+    {
+        return false;
+    }
+    Compressor c;
+    if ( ( c.IsValidData( compressed.Get(), compressedSize ) == false ) ||
+         ( c.Decompress( compressed.Get() ) == false ) )
+    {
+        return false;
+    }
+
+    ConstMemoryStream ms( c.GetResult(), c.GetResultSize() );
+    AStackString<> fileName;
+    AStackString<> tmpFileName;
+    for ( uint32_t i = 0; i < numFiles; ++i )
+    {
+        uint64_t contentHash;
+        uint32_t size;
+        if ( ( ms.Read( contentHash ) == false ) ||
+             ( ms.Read( size ) == false ) ||
+             ( ( ms.Tell() + size ) > ms.GetSize() ) )
+        {
+            return false;
+        }
+        const char * data = static_cast< const char * >( ms.GetData() ) + ms.Tell();
+        ms.Seek( ms.Tell() + size );
+
+        GetFilePath( contentHash, fileName );
+
+        // Several clients can send the same header
+        MutexHolder mh( m_Mutex );
+        Entry * entry = FindEntry( contentHash );
+        if ( entry )
+        {
+            entry->m_LastUse = ++m_UseCount;
+            entry->m_NumRefs++;
+            clientHashes.Append( contentHash );
+            continue;
+        }
+
+        // Write to a temp file first, so a failure can't leave a partial header
+        tmpFileName = fileName;
+        tmpFileName += ".tmp";
+        FileStream fs;
+        if ( ( fs.Open( tmpFileName.Get(), FileStream::WRITE_ONLY ) == false ) ||
+             ( fs.WriteBuffer( data, size ) != size ) )
+        {
+            FLOG_WARN( "Failed to store header '%s'. Error: %s", fileName.Get(), LAST_ERROR_STR );
+            return false;
+        }
+        fs.Close();
+        if ( FileIO::FileMove( tmpFileName, fileName ) == false )
+        {
+            FLOG_WARN( "Failed to store header '%s'. Error: %s", fileName.Get(), LAST_ERROR_STR );
+            return false;
+        }
+
+        Entry newEntry;
+        newEntry.m_ContentHash = contentHash;
+        newEntry.m_LastUse = ++m_UseCount;
+        newEntry.m_Size = size;
+        newEntry.m_NumRefs = 1;
+        m_Entries[ contentHash % NUM_BUCKETS ].Append( newEntry );
+        m_BytesInUse += size;
+        clientHashes.Append( contentHash );
+    }
+
+    MutexHolder mh( m_Mutex );
+    Evict();
+    return true;
+}
+
+// ReleaseContents
+//------------------------------------------------------------------------------
+void HeaderStore::ReleaseContents( const Array< uint64_t > & clientHashes )
+{
+    MutexHolder mh( m_Mutex );
+    for ( const uint64_t contentHash : clientHashes )
+    {
+        Entry * entry = FindEntry( contentHash );
+        ASSERT( entry && ( entry->m_NumRefs > 0 ) );
+        entry->m_NumRefs--;
+    }
+    Evict();
+}
+
+// CreateRoot
+//------------------------------------------------------------------------------
+bool HeaderStore::CreateRoot( const HeaderBundle & bundle, const AString & root, AString & outError )
+{
+    const size_t numFiles = bundle.GetNumFiles();
+    {
+        MutexHolder mh( m_Mutex );
+        const uint64_t useCount = ++m_UseCount;
+        for ( size_t i = 0; i < numFiles; ++i )
+        {
+            Entry * entry = FindEntry( bundle.GetContentHash( i ) );
+            if ( entry )
+            {
+                entry->m_LastUse = useCount;
+            }
+        }
+    }
+
+    AStackString<> src;
+    AStackString<> dst;
+    AStackString<> dir;
+    AStackString<> lastDir;
+    for ( size_t i = 0; i < numFiles; ++i )
+    {
+        GetFilePath( bundle.GetContentHash( i ), src );
+        HeaderBundle::GetPathInRoot( root, bundle.GetFileName( i ), dst );
+
+        // Headers are mostly grouped by directory
+        const char * lastSlash = dst.FindLast( NATIVE_SLASH );
+        dir.Assign( dst.Get(), lastSlash );
+        if ( dir != lastDir )
+        {
+            if ( FileIO::EnsurePathExists( dir ) == false )
+            {
+                outError.Format( "Failed to create dir '%s'. Error: %s", dir.Get(), LAST_ERROR_STR );
+                return false;
+            }
+            lastDir = dir;
+        }
+
+        // Hard link from the store (no copying)
+        if ( FileIO::FileHardLink( src, dst ) )
+        {
+            continue;
+        }
+
+        // Left over from an interrupted job?
+        if ( FileIO::FileExists( dst.Get() ) )
+        {
+            FileIO::FileDelete( dst.Get() );
+            if ( FileIO::FileHardLink( src, dst ) )
+            {
+                continue;
+            }
+        }
+
+        if ( FileIO::FileExists( src.Get() ) == false )
+        {
+            outError.Format( "Missing header '%s'", bundle.GetFileName( i ).Get() );
+            return false;
+        }
+
+        // Links may not be supported (i.e. store and root on different volumes)
+        if ( FileIO::FileCopy( src.Get(), dst.Get() ) == false )
+        {
+            outError.Format( "Failed to create '%s'. Error: %s", dst.Get(), LAST_ERROR_STR );
+            return false;
+        }
+    }
+    return true;
+}
+
+// DeleteRoot
+//------------------------------------------------------------------------------
+/*static*/ void HeaderStore::DeleteRoot( const HeaderBundle & bundle, const AString & root )
+{
+    Array< AString > dirs( 64, true );
+    AStackString<> fileName;
+    AStackString<> dir;
+    const size_t numFiles = bundle.GetNumFiles();
+    for ( size_t i = 0; i < numFiles; ++i )
+    {
+        HeaderBundle::GetPathInRoot( root, bundle.GetFileName( i ), fileName );
+        FileIO::FileDelete( fileName.Get() );
+
+        // Record dirs, up to (but not including) the root
+        dir = fileName;
+        for ( ;; )
+        {
+            const char * lastSlash = dir.FindLast( NATIVE_SLASH );
+            if ( ( lastSlash == nullptr ) || ( (size_t)( lastSlash - dir.Get() ) < root.GetLength() ) )
+            {
+                break;
+            }
+            dir.SetLength( (uint32_t)( lastSlash - dir.Get() ) );
+            if ( dirs.Find( dir ) )
+            {
+                break; // parents already recorded
+            }
+            dirs.Append( dir );
+        }
+    }
+
+    // Delete children before parents
+    dirs.Sort( DeeperPathFirst() );
+    for ( const AString & d : dirs )
+    {
+        FileIO::DirectoryDelete( d );
+    }
+}
+
+// GetBytesInUse
+//------------------------------------------------------------------------------
+uint64_t HeaderStore::GetBytesInUse() const
+{
+    MutexHolder mh( m_Mutex );
+    return m_BytesInUse;
+}
+
+// GetTotalSize
+//------------------------------------------------------------------------------
+uint64_t HeaderStore::GetTotalSize( const HeaderBundle & bundle ) const
+{
+    MutexHolder mh( m_Mutex );
+    uint64_t totalSize = 0;
+    const size_t numFiles = bundle.GetNumFiles();
+    for ( size_t i = 0; i < numFiles; ++i )
+    {
+        const Entry * entry = FindEntry( bundle.GetContentHash( i ) );
+        if ( entry )
+        {
+            totalSize += entry->m_Size;
+        }
+    }
+    return totalSize;
+}
+
+// GetDefaultPath
+//------------------------------------------------------------------------------
+/*static*/ void HeaderStore::GetDefaultPath( AString & outPath )
+{
+    VERIFY( FBuild::GetTempDir( outPath ) );
+    #if defined( __WINDOWS__ )
+        outPath += ".fbuild.tmp\\worker\\headers\\";
+    #else
+        outPath += "_fbuild.tmp/worker/headers/";
+    #endif
+}
+
+// FindEntry
+//------------------------------------------------------------------------------
+HeaderStore::Entry * HeaderStore::FindEntry( uint64_t contentHash ) const
+{
+    // NOTE: m_Mutex must be held
+    return m_Entries[ contentHash % NUM_BUCKETS ].Find( contentHash );
+}
+
+// Evict
+//------------------------------------------------------------------------------
+void HeaderStore::Evict()
+{
+    // NOTE: m_Mutex must be held
+
+    if ( m_BytesInUse <= m_Budget )
+    {
+        return;
+    }
+
+    // Only headers no connected client expects us to have can be evicted
+    Array< HeaderStoreEvictionCandidate > candidates( 1024, true );
+    for ( const Array< Entry > & bucket : m_Entries )
+    {
+        for ( const Entry & entry : bucket )
+        {
+            if ( entry.m_NumRefs == 0 )
+            {
+                HeaderStoreEvictionCandidate candidate;
+                candidate.m_LastUse = entry.m_LastUse;
+                candidate.m_ContentHash = entry.m_ContentHash;
+                candidates.Append( candidate );
+            }
+        }
+    }
+    candidates.Sort(); // least recently used first
+
+    AStackString<> fileName;
+    for ( const HeaderStoreEvictionCandidate & candidate : candidates )
+    {
+        if ( m_BytesInUse <= m_Budget )
+        {
+            break;
+        }
+
+        // Jobs already using the header have their own link to it
+        GetFilePath( candidate.m_ContentHash, fileName );
+        FileIO::FileDelete( fileName.Get() );
+
+        Array< Entry > & bucket = m_Entries[ candidate.m_ContentHash % NUM_BUCKETS ];
+        Entry * entry = bucket.Find( candidate.m_ContentHash );
+        m_BytesInUse -= entry->m_Size;
+        bucket.Erase( entry );
+    }
+}
+
+// GetFilePath
+//------------------------------------------------------------------------------
+void HeaderStore::GetFilePath( uint64_t contentHash, AString & outPath ) const
+{
+    outPath.Format( "%s%016" PRIx64, m_Path.Get(), contentHash );
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,126 @@
+// HeaderBundle - a source file and the headers it includes, for compiling
+//                remotely without preprocessing
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Containers/Array.h"
+#include "Core/Containers/Singleton.h"
+#include "Core/Env/Types.h"
+#include "Core/Process/Mutex.h"
+#include "Core/Strings/AString.h"
+
+// Forward Declarations
+//------------------------------------------------------------------------------
+class IOStream;
+class Job;
+
+// HeaderBundle
+//------------------------------------------------------------------------------
+// Sent in place of preprocessed output. The bundle only describes the files
+// (by path and content hash); the contents are sent once per worker connection
+// and kept in the worker's HeaderStore. The worker recreates the client's
+// directory layout under a "virtual include root" to compile in:
+//
+//   /home/user/project/src/a.cpp  ->  <root>/home/user/project/src/a.cpp
+//   C:\project\src\a.cpp          ->  <root>\C\project\src\a.cpp
+//------------------------------------------------------------------------------
+class HeaderBundle
+{
+public:
+    static const uint64_t   MAX_FILE_SIZE = 0xFFFFFFFF; // sizes are sent as 32 bits
+
+    HeaderBundle();
+    ~HeaderBundle();
+
+    // The source file must be added first
+    void                    AddFile( const AString & fileName, uint64_t contentHash );
+
+    void                    Save( IOStream & stream ) const;
+    bool                    Load( IOStream & stream );
+    bool                    LoadFromJob( const Job * job ); // handles compressed job data
+
+    inline size_t           GetNumFiles() const                     { return m_Files.GetSize(); }
+    inline const AString &  GetFileName( size_t index ) const       { return m_Files[ index ].m_FileName; }
+    inline uint64_t         GetContentHash( size_t index ) const    { return m_Files[ index ].m_ContentHash; }
+
+    // Choose the files (by index) to send: those not in knownHashes (sorted),
+    // which is updated as though they have been sent. This doesn't touch the
+    // disk, so is cheap enough to do under the lock protecting knownHashes.
+    void                    SelectContents( Array< uint64_t > & knownHashes, Array< uint32_t > & outFiles ) const;
+
+    // Read and write the contents of the chosen files. Files which have changed
+    // since the bundle was created are omitted (and the job will fail on the
+    // worker), and should be forgotten with ForgetContents.
+    bool                    SaveContents( const Array< uint32_t > & files, IOStream & stream, Array< uint64_t > & outOmittedHashes ) const;
+    static void             ForgetContents( Array< uint64_t > & knownHashes, const Array< uint64_t > & omittedHashes );
+
+    // Location of a client file under a virtual include root
+    static void             GetPathInRoot( const AString & root, const AString & fileName, AString & outPath );
+
+    // Files listed in a make-style dependency file (as written by -MD)
+    static bool             ParseDependencies( const AString & depFile, Array< AString > & outFiles );
+
+private:
+    struct File
+    {
+        AString     m_FileName;
+        uint64_t    m_ContentHash;
+    };
+    Array< File >           m_Files;
+};
+
+// HeaderStore
+//------------------------------------------------------------------------------
+// Content addressed storage of headers on a worker. Clients remember which
+// headers they have sent for as long as they are connected, so headers are
+// referenced by each client that sent (or would have sent) them. Once over the
+// budget, the least recently used unreferenced headers are evicted. The store
+// is emptied on startup.
+//------------------------------------------------------------------------------
+class HeaderStore : public Singleton< HeaderStore >
+{
+public:
+    explicit HeaderStore( const AString & path, uint64_t budget );
+    ~HeaderStore();
+
+    // Store contents written by HeaderBundle::SaveContents, referencing them
+    // for a client (recorded in clientHashes) until released
+    bool                    LoadContents( IOStream & stream, Array< uint64_t > & clientHashes );
+    void                    ReleaseContents( const Array< uint64_t > & clientHashes );
+
+    // Populate (and clean up) a virtual include root for a bundle
+    bool                    CreateRoot( const HeaderBundle & bundle, const AString & root, AString & outError );
+    static void             DeleteRoot( const HeaderBundle & bundle, const AString & root );
+
+    inline const AString &  GetPath() const { return m_Path; }
+    uint64_t                GetBytesInUse() const;
+    uint64_t                GetTotalSize( const HeaderBundle & bundle ) const; // of the files in the store
+    static void             GetDefaultPath( AString & outPath );
+
+private:
+    struct Entry
+    {
+        inline bool operator == ( uint64_t contentHash ) const { return ( m_ContentHash == contentHash ); }
+
+        uint64_t    m_ContentHash;
+        uint64_t    m_LastUse;      // value of m_UseCount when last used
+        uint32_t    m_Size;
+        uint32_t    m_NumRefs;      // clients which have sent this header
+    };
+    static const uint32_t NUM_BUCKETS = 256;
+
+    Entry *                 FindEntry( uint64_t contentHash ) const;
+    void                    Evict();
+    void                    GetFilePath( uint64_t contentHash, AString & outPath ) const;
+
+    mutable Mutex           m_Mutex;
+    AString                 m_Path;
+    uint64_t                m_Budget;
+    uint64_t                m_BytesInUse;
+    uint64_t                m_UseCount;
+    Array< Entry >          m_Entries[ NUM_BUCKETS ]; // by content hash
+};
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,48 @@
+// JobPhaseScope
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "JobPhaseScope.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/Helpers/MonitorStream.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/Job.h"
+
+// Core
+#include "Core/Time/Timer.h"
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+JobPhaseScope::JobPhaseScope( BuildTrace::Phase phase, const Job * job )
+    : m_Job( nullptr )
+    , m_StartTime( 0 )
+    , m_Phase( phase )
+{
+    // Only local jobs are reported (nodes for remote jobs are transient)
+    if ( ( BuildTrace::IsEnabled() || MonitorStream::IsEnabled() ) && job->IsLocal() )
+    {
+        m_Job = job;
+        m_StartTime = Timer::GetNow();
+    }
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+JobPhaseScope::~JobPhaseScope()
+{
+    if ( m_Job )
+    {
+        const int64_t endTime = Timer::GetNow();
+        if ( BuildTrace::IsEnabled() )
+        {
+            BuildTrace::Record( m_Phase, m_Job->GetNode(), m_StartTime, endTime );
+        }
+        if ( MonitorStream::IsEnabled() )
+        {
+            MonitorStream::JobPhase( m_Job, m_Phase, m_StartTime, endTime );
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,29 @@
+// JobPhaseScope - Report a phase of a job to the build trace and monitor stream
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Tools/FBuild/FBuildCore/Helpers/BuildTrace.h"
+
+#include "Core/Env/Types.h"
+
+// Forward Declarations
+//------------------------------------------------------------------------------
+class Job;
+
+// JobPhaseScope
+//------------------------------------------------------------------------------
+class JobPhaseScope
+{
+public:
+    JobPhaseScope( BuildTrace::Phase phase, const Job * job );
+    ~JobPhaseScope();
+
+private:
+    const Job *         m_Job;
+    int64_t             m_StartTime;
+    BuildTrace::Phase   m_Phase;
+};
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,441 @@
+// MonitorStream - Structured build events for external monitoring tools
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "MonitorStream.h"
+
+// FBuild
+#include "Tools/FBuild/FBuildCore/FLog.h"
+#include "Tools/FBuild/FBuildCore/Graph/Node.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/Job.h"
+
+// Core
+#include "Core/Env/Assert.h"
+#include "Core/Mem/Mem.h"
+#include "Core/Process/Atomic.h"
+#include "Core/Process/Mutex.h"
+#include "Core/Process/Process.h"
+#include "Core/Process/SharedMemory.h"
+#include "Core/Process/SystemMutex.h"
+#include "Core/Strings/AStackString.h"
+#include "Core/Time/Timer.h"
+
+// system
+#include <string.h> // for memcpy
+
+// Defines
+//------------------------------------------------------------------------------
+#define MONITOR_STREAM_MAX_RECORD_SIZE  ( 64 * 1024 )
+#define MONITOR_STREAM_MAX_NAME_LENGTH  ( 4 * 1024 )
+
+// MonitorStreamHeader
+//------------------------------------------------------------------------------
+struct MonitorStreamHeader
+{
+    uint32_t            m_Magic;
+    uint32_t            m_Version;
+    uint32_t            m_RingSize;
+    uint32_t            m_ProcessId;
+    volatile uint64_t   m_WritePos;
+    volatile uint64_t   m_ReservePos;
+    uint8_t             m_Reserved[ 32 ];
+};
+static_assert( sizeof( MonitorStreamHeader ) == MonitorStream::HEADER_SIZE, "Header layout is part of the documented format" );
+
+// Static Data
+//------------------------------------------------------------------------------
+/*static*/ const char * const MonitorStream::DEFAULT_NAME( "FASTBuildMonitor" );
+/*static*/ volatile bool MonitorStream::s_Enabled( false );
+static Mutex g_MonitorStreamMutex;
+static SystemMutex * g_MonitorStreamSystemMutex = nullptr;
+static SharedMemory * g_MonitorStreamMemory = nullptr;
+static MonitorStreamHeader * g_MonitorStreamHeader = nullptr;
+static uint8_t * g_MonitorStreamRing = nullptr;
+static int64_t g_MonitorStreamStartTime = 0;
+
+// Helpers
+//------------------------------------------------------------------------------
+static inline uint32_t MonitorStreamAlign( uint32_t size )
+{
+    return ( ( size + 7 ) & ~7u );
+}
+
+static inline uint64_t MonitorStreamTicksToUS( int64_t ticks )
+{
+    return ( ticks > 0 ) ? (uint64_t)( ( (double)ticks * 1000000.0 ) / (double)Timer::GetFrequency() ) : 0;
+}
+
+// Open
+//------------------------------------------------------------------------------
+/*static*/ bool MonitorStream::Open( const char * name, uint32_t ringSize )
+{
+    ASSERT( ( ringSize & ( ringSize - 1 ) ) == 0 ); // Must be a power of 2
+    ASSERT( ringSize >= ( MONITOR_STREAM_MAX_RECORD_SIZE * 4 ) );
+
+    MutexHolder mh( g_MonitorStreamMutex );
+    ASSERT( g_MonitorStreamMemory == nullptr );
+
+    // Only one process can publish under a given name
+    AStackString<> lockName;
+    GetLockName( name, lockName );
+    g_MonitorStreamSystemMutex = FNEW( SystemMutex( lockName.Get() ) );
+    if ( g_MonitorStreamSystemMutex->TryLock() == false )
+    {
+        FLOG_WARN( "Monitor stream '%s' is in use by another process", name );
+        FDELETE g_MonitorStreamSystemMutex;
+        g_MonitorStreamSystemMutex = nullptr;
+        return false;
+    }
+
+    g_MonitorStreamMemory = FNEW( SharedMemory );
+    g_MonitorStreamMemory->Create( name, HEADER_SIZE + ringSize );
+    if ( g_MonitorStreamMemory->GetPtr() == nullptr )
+    {
+        FLOG_WARN( "Failed to create monitor stream '%s'", name );
+        FDELETE g_MonitorStreamMemory;
+        g_MonitorStreamMemory = nullptr;
+        FDELETE g_MonitorStreamSystemMutex; // unlocks
+        g_MonitorStreamSystemMutex = nullptr;
+        return false;
+    }
+
+    g_MonitorStreamHeader = static_cast< MonitorStreamHeader * >( g_MonitorStreamMemory->GetPtr() );
+    g_MonitorStreamRing = static_cast< uint8_t * >( g_MonitorStreamMemory->GetPtr() ) + HEADER_SIZE;
+    g_MonitorStreamStartTime = Timer::GetNow();
+
+    // Consumers validate the magic last, so a partially initialized header is never used
+    g_MonitorStreamHeader->m_Magic = 0;
+    g_MonitorStreamHeader->m_Version = MONITOR_STREAM_VERSION;
+    g_MonitorStreamHeader->m_RingSize = ringSize;
+    g_MonitorStreamHeader->m_ProcessId = Process::GetCurrentId();
+    AtomicStoreRelaxed( &g_MonitorStreamHeader->m_WritePos, (uint64_t)0 );
+    AtomicStoreRelaxed( &g_MonitorStreamHeader->m_ReservePos, (uint64_t)0 );
+    memset( g_MonitorStreamHeader->m_Reserved, 0, sizeof( g_MonitorStreamHeader->m_Reserved ) );
+    AtomicStoreRelease( &g_MonitorStreamHeader->m_Magic, MONITOR_STREAM_MAGIC );
+
+    AtomicStoreRelaxed( &s_Enabled, true );
+    return true;
+}
+
+// Close
+//------------------------------------------------------------------------------
+/*static*/ void MonitorStream::Close()
+{
+    MutexHolder mh( g_MonitorStreamMutex );
+    if ( g_MonitorStreamMemory == nullptr )
+    {
+        return;
+    }
+
+    AtomicStoreRelaxed( &s_Enabled, false );
+    g_MonitorStreamHeader = nullptr;
+    g_MonitorStreamRing = nullptr;
+    FDELETE g_MonitorStreamMemory;
+    g_MonitorStreamMemory = nullptr;
+    FDELETE g_MonitorStreamSystemMutex; // unlocks
+    g_MonitorStreamSystemMutex = nullptr;
+}
+
+// GetLockName
+//------------------------------------------------------------------------------
+/*static*/ void MonitorStream::GetLockName( const char * name, AString & outLockName )
+{
+    // The name is used for a file on Linux/OSX, so only keep characters safe
+    // for both a file and a kernel object name
+    outLockName = "FASTBuildMonitorStream_";
+    for ( const char * pos = name; *pos; ++pos )
+    {
+        const char c = *pos;
+        const bool safe = ( ( c >= 'a' ) && ( c <= 'z' ) ) ||
+                          ( ( c >= 'A' ) && ( c <= 'Z' ) ) ||
+                          ( ( c >= '0' ) && ( c <= '9' ) ) ||
+                          ( c == '_' ) || ( c == '-' );
+        outLockName += safe ? c : '_';
+    }
+}
+
+// StartBuild
+//------------------------------------------------------------------------------
+/*static*/ void MonitorStream::StartBuild()
+{
+    Write( EVENT_START_BUILD, 0, 0, Process::GetCurrentId() );
+}
+
+// StopBuild
+//------------------------------------------------------------------------------
+/*static*/ void MonitorStream::StopBuild()
+{
+    Write( EVENT_STOP_BUILD, 0, 0, 0 );
+}
+
+// JobStart
+//------------------------------------------------------------------------------
+/*static*/ void MonitorStream::JobStart( const Job * job, const char * workerName )
+{
+    Write( EVENT_JOB_START, 0, job->GetJobId(), 0, workerName, &job->GetNode()->GetName() );
+}
+
+// JobFinish
+//------------------------------------------------------------------------------
+/*static*/ void MonitorStream::JobFinish( const Job * job, const char * workerName, JobResult result, const AString & messages )
+{
+    Write( EVENT_JOB_FINISH, result, job->GetJobId(), 0, workerName, &job->GetNode()->GetName(), &messages );
+}
+
+// JobPhase
+//------------------------------------------------------------------------------
+/*static*/ void MonitorStream::JobPhase( const Job * job, uint8_t phase, int64_t startTime, int64_t endTime )
+{
+    const uint64_t durationUS = MonitorStreamTicksToUS( endTime - startTime );
+    Write( EVENT_JOB_PHASE, phase, job->GetJobId(), ( durationUS > 0xFFFFFFFF ) ? 0xFFFFFFFF : (uint32_t)durationUS );
+}
+
+// Progress
+//------------------------------------------------------------------------------
+/*static*/ void MonitorStream::Progress( float percent )
+{
+    Write( EVENT_PROGRESS, 0, 0, (uint32_t)( percent * 100.0f ) );
+}
+
+// Write
+//------------------------------------------------------------------------------
+/*static*/ void MonitorStream::Write( EventType type, uint8_t subType, uint32_t jobId, uint32_t value,
+                                      const char * workerName, const AString * nodeName, const AString * messages )
+{
+    // Clamp strings so every record fits in the maximum size
+    const uint32_t workerNameLen = workerName ? (uint32_t)AString::StrLen( workerName ) : 0;
+    const uint16_t workerLen = (uint16_t)( ( workerNameLen < MONITOR_STREAM_MAX_NAME_LENGTH ) ? workerNameLen : MONITOR_STREAM_MAX_NAME_LENGTH );
+    const uint32_t nodeNameLen = nodeName ? nodeName->GetLength() : 0;
+    const uint16_t nodeLen = (uint16_t)( ( nodeNameLen < MONITOR_STREAM_MAX_NAME_LENGTH ) ? nodeNameLen : MONITOR_STREAM_MAX_NAME_LENGTH );
+    const uint32_t maxMessagesLen = ( MONITOR_STREAM_MAX_RECORD_SIZE - RECORD_HEADER_SIZE - ( 3 * sizeof( uint16_t ) ) - ( 2 * MONITOR_STREAM_MAX_NAME_LENGTH ) - 8 );
+    const uint32_t messagesLen = messages ? messages->GetLength() : 0;
+    const uint16_t msgLen = (uint16_t)( ( messagesLen < maxMessagesLen ) ? messagesLen : maxMessagesLen );
+
+    uint32_t size = RECORD_HEADER_SIZE;
+    if ( workerName || nodeName || messages )
+    {
+        size += (uint32_t)( sizeof( uint16_t ) + workerLen + sizeof( uint16_t ) + nodeLen );
+        if ( messages )
+        {
+            size += (uint32_t)( sizeof( uint16_t ) + msgLen );
+        }
+    }
+    size = MonitorStreamAlign( size );
+    ASSERT( size <= MONITOR_STREAM_MAX_RECORD_SIZE );
+
+    MutexHolder mh( g_MonitorStreamMutex );
+    if ( g_MonitorStreamHeader == nullptr )
+    {
+        return;
+    }
+
+    const uint32_t ringSize = g_MonitorStreamHeader->m_RingSize;
+    uint64_t pos = AtomicLoadRelaxed( &g_MonitorStreamHeader->m_WritePos );
+    uint32_t offset = (uint32_t)( pos & ( ringSize - 1 ) );
+
+    // Records never wrap, so pad to the end of the ring if needed
+    uint32_t padding = 0;
+    if ( ( offset + size ) > ringSize )
+    {
+        padding = ( ringSize - offset );
+    }
+
+    // Announce the region we're about to overwrite before touching it
+    AtomicStoreRelease( &g_MonitorStreamHeader->m_ReservePos, pos + padding + size );
+
+    if ( padding )
+    {
+        uint8_t * pad = g_MonitorStreamRing + offset;
+        memcpy( pad, &padding, sizeof( uint32_t ) );
+        pad[ 4 ] = EVENT_PADDING;
+        pos += padding;
+        offset = 0;
+    }
+
+    // Record header
+    uint8_t * dst = g_MonitorStreamRing + offset;
+    const uint64_t timeUS = MonitorStreamTicksToUS( Timer::GetNow() - g_MonitorStreamStartTime );
+    const uint16_t reserved = 0;
+    memcpy( dst + 0, &size, sizeof( uint32_t ) );
+    dst[ 4 ] = type;
+    dst[ 5 ] = subType;
+    memcpy( dst + 6, &reserved, sizeof( uint16_t ) );
+    memcpy( dst + 8, &timeUS, sizeof( uint64_t ) );
+    memcpy( dst + 16, &jobId, sizeof( uint32_t ) );
+    memcpy( dst + 20, &value, sizeof( uint32_t ) );
+    dst += RECORD_HEADER_SIZE;
+
+    // Strings
+    if ( workerName || nodeName || messages )
+    {
+        memcpy( dst, &workerLen, sizeof( uint16_t ) );
+        memcpy( dst + sizeof( uint16_t ), workerName, workerLen );
+        dst += sizeof( uint16_t ) + workerLen;
+        memcpy( dst, &nodeLen, sizeof( uint16_t ) );
+        memcpy( dst + sizeof( uint16_t ), nodeName ? nodeName->Get() : "", nodeLen );
+        dst += sizeof( uint16_t ) + nodeLen;
+        if ( messages )
+        {
+            memcpy( dst, &msgLen, sizeof( uint16_t ) );
+            memcpy( dst + sizeof( uint16_t ), messages->Get(), msgLen );
+        }
+    }
+
+    // Publish
+    AtomicStoreRelease( &g_MonitorStreamHeader->m_WritePos, pos + size );
+}
+
+// MonitorStreamReader CONSTRUCTOR
+//------------------------------------------------------------------------------
+MonitorStreamReader::MonitorStreamReader()
+    : m_SharedMemory( nullptr )
+    , m_Ring( nullptr )
+    , m_RingSize( 0 )
+    , m_NumOverruns( 0 )
+    , m_ReadPos( 0 )
+    , m_Record( (uint8_t *)ALLOC( MONITOR_STREAM_MAX_RECORD_SIZE ) )
+{
+}
+
+// MonitorStreamReader DESTRUCTOR
+//------------------------------------------------------------------------------
+MonitorStreamReader::~MonitorStreamReader()
+{
+    FDELETE m_SharedMemory;
+    FREE( m_Record );
+}
+
+// Open
+//------------------------------------------------------------------------------
+bool MonitorStreamReader::Open( const char * name )
+{
+    ASSERT( m_SharedMemory == nullptr );
+
+    // Map the header to discover the size of the ring
+    uint32_t ringSize;
+    {
+        SharedMemory header;
+        if ( header.Open( name, MonitorStream::HEADER_SIZE ) == false )
+        {
+            return false;
+        }
+        const MonitorStreamHeader * h = static_cast< const MonitorStreamHeader * >( header.GetPtr() );
+        if ( ( h == nullptr ) ||
+             ( AtomicLoadAcquire( &h->m_Magic ) != MonitorStream::MONITOR_STREAM_MAGIC ) ||
+             ( h->m_Version != MonitorStream::MONITOR_STREAM_VERSION ) )
+        {
+            return false;
+        }
+        ringSize = h->m_RingSize;
+    }
+
+    m_SharedMemory = FNEW( SharedMemory );
+    if ( ( m_SharedMemory->Open( name, MonitorStream::HEADER_SIZE + ringSize ) == false ) ||
+         ( m_SharedMemory->GetPtr() == nullptr ) )
+    {
+        FDELETE m_SharedMemory;
+        m_SharedMemory = nullptr;
+        return false;
+    }
+    m_Ring = static_cast< const uint8_t * >( m_SharedMemory->GetPtr() ) + MonitorStream::HEADER_SIZE;
+    m_RingSize = ringSize;
+
+    // Start from the beginning if nothing has been overwritten yet, otherwise
+    // from the most recent event
+    const MonitorStreamHeader * h = static_cast< const MonitorStreamHeader * >( m_SharedMemory->GetPtr() );
+    const uint64_t writePos = AtomicLoadAcquire( &h->m_WritePos );
+    m_ReadPos = ( writePos <= ringSize ) ? 0 : writePos;
+    return true;
+}
+
+// ReadEvent
+//------------------------------------------------------------------------------
+bool MonitorStreamReader::ReadEvent( Event & outEvent )
+{
+    if ( m_SharedMemory == nullptr )
+    {
+        return false;
+    }
+    const MonitorStreamHeader * h = static_cast< const MonitorStreamHeader * >( m_SharedMemory->GetPtr() );
+
+    for ( ;; )
+    {
+        const uint64_t writePos = AtomicLoadAcquire( &h->m_WritePos );
+        if ( m_ReadPos == writePos )
+        {
+            return false; // No new events
+        }
+        if ( ( writePos - m_ReadPos ) > m_RingSize )
+        {
+            // Writer lapped us
+            ++m_NumOverruns;
+            m_ReadPos = writePos;
+            continue;
+        }
+
+        // Take a copy of the record
+        const uint32_t offset = (uint32_t)( m_ReadPos & ( m_RingSize - 1 ) );
+        uint32_t size;
+        memcpy( &size, m_Ring + offset, sizeof( uint32_t ) );
+        const bool sizeOK = ( size >= 8 ) && ( size <= MONITOR_STREAM_MAX_RECORD_SIZE ) && ( ( offset + size ) <= m_RingSize );
+        if ( sizeOK )
+        {
+            memcpy( m_Record, m_Ring + offset, size );
+        }
+
+        // Ensure the copy was not overwritten while we were reading it
+        #if defined( __WINDOWS__ )
+            MemoryBarrier();
+        #else
+            __atomic_thread_fence( __ATOMIC_ACQUIRE );
+        #endif
+        const uint64_t reservePos = AtomicLoadAcquire( &h->m_ReservePos );
+        if ( ( sizeOK == false ) || ( ( reservePos - m_ReadPos ) > m_RingSize ) )
+        {
+            ++m_NumOverruns;
+            m_ReadPos = AtomicLoadAcquire( &h->m_WritePos );
+            continue;
+        }
+        m_ReadPos += size;
+
+        // Decode
+        const uint8_t * src = m_Record;
+        const MonitorStream::EventType type = (MonitorStream::EventType)src[ 4 ];
+        if ( type == MonitorStream::EVENT_PADDING )
+        {
+            continue;
+        }
+        outEvent.m_Type = type;
+        outEvent.m_SubType = src[ 5 ];
+        memcpy( &outEvent.m_TimeUS, src + 8, sizeof( uint64_t ) );
+        memcpy( &outEvent.m_JobId, src + 16, sizeof( uint32_t ) );
+        memcpy( &outEvent.m_Value, src + 20, sizeof( uint32_t ) );
+        outEvent.m_WorkerName.Clear();
+        outEvent.m_NodeName.Clear();
+        outEvent.m_Messages.Clear();
+
+        const uint8_t * pos = src + MonitorStream::RECORD_HEADER_SIZE;
+        const uint8_t * end = src + size;
+        AString * strings[] = { &outEvent.m_WorkerName, &outEvent.m_NodeName, &outEvent.m_Messages };
+        for ( AString * string : strings )
+        {
+            if ( ( pos + sizeof( uint16_t ) ) > end )
+            {
+                break;
+            }
+            uint16_t len;
+            memcpy( &len, pos, sizeof( uint16_t ) );
+            pos += sizeof( uint16_t );
+            if ( ( pos + len ) > end )
+            {
+                break;
+            }
+            string->Assign( reinterpret_cast< const char * >( pos ), reinterpret_cast< const char * >( pos + len ) );
+            pos += len;
+        }
+        return true;
+    }
+}
+
+//------------------------------------------------------------------------------
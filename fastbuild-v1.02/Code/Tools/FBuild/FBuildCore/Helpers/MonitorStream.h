@@ -0,0 +1,160 @@
+// MonitorStream - Structured build events for external monitoring tools
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Env/Types.h"
+#include "Core/Process/Atomic.h"
+#include "Core/Strings/AString.h"
+
+// Forward Declarations
+//------------------------------------------------------------------------------
+class Job;
+class SharedMemory;
+
+// MonitorStream
+//------------------------------------------------------------------------------
+// Build events are written as length-prefixed binary records into a ring buffer
+// in shared memory. Unlike the text based monitor log (-monitor) this requires
+// no file I/O or formatting and consumers can follow the build with no latency.
+//
+// The writer never blocks on consumers. A consumer that falls more than a ring
+// buffer behind detects the overrun and skips ahead.
+//
+// Layout (all values little-endian):
+//
+//  Header (64 bytes)
+//    +0   uint32   Magic       - MONITOR_STREAM_MAGIC ('FBMS')
+//    +4   uint32   Version     - MONITOR_STREAM_VERSION
+//    +8   uint32   RingSize    - Size of ring buffer in bytes (power of 2)
+//    +12  uint32   ProcessId   - Process writing the stream
+//    +16  uint64   WritePos    - Total bytes of complete records written
+//    +24  uint64   ReservePos  - Total bytes reserved by the writer. Records
+//                                older than ( ReservePos - RingSize ) may have
+//                                been overwritten.
+//    +32  ...      Reserved
+//  Ring buffer (RingSize bytes)
+//
+//  Record (at ( pos % RingSize ), size is a multiple of 8, never wraps)
+//    +0   uint32   Size        - Record size in bytes, including this header
+//    +4   uint8    Type        - EventType
+//    +5   uint8    SubType     - JobResult for EVENT_JOB_FINISH,
+//                                BuildTrace::Phase for EVENT_JOB_PHASE
+//    +6   uint16   Reserved
+//    +8   uint64   Time        - Microseconds since the stream was opened
+//    +16  uint32   JobId
+//    +20  uint32   Value       - Progress (percent * 100) for EVENT_PROGRESS,
+//                                duration in microseconds for EVENT_JOB_PHASE,
+//                                process id for EVENT_START_BUILD
+//    +24  Strings              - Each is a uint16 length followed by that many
+//                                bytes (no terminator). Worker name, node name
+//                                and messages (EVENT_JOB_FINISH only).
+//
+//  EVENT_PADDING records fill the end of the ring when the next record would
+//  not fit and should be skipped.
+//
+//  Consumer algorithm:
+//    1) Load WritePos (acquire). If it equals your read position, wait.
+//    2) If ( WritePos - readPos ) > RingSize, events were lost: set readPos to
+//       WritePos and continue.
+//    3) Copy the record at ( readPos % RingSize ).
+//    4) Load ReservePos. If ( ReservePos - readPos ) > RingSize, the copy may be
+//       corrupt: treat as lost (as in 2).
+//    5) Advance readPos by Size and process the copy.
+//
+// MonitorStreamReader is a reference implementation of a consumer.
+//------------------------------------------------------------------------------
+class MonitorStream
+{
+public:
+    enum EventType : uint8_t
+    {
+        EVENT_PADDING       = 0,
+        EVENT_START_BUILD   = 1,
+        EVENT_STOP_BUILD    = 2,
+        EVENT_JOB_START     = 3,
+        EVENT_JOB_FINISH    = 4,
+        EVENT_JOB_PHASE     = 5,
+        EVENT_PROGRESS      = 6,
+    };
+
+    enum JobResult : uint8_t
+    {
+        RESULT_SUCCESS              = 0,
+        RESULT_SUCCESS_PREPROCESSED = 1, // First pass of a distributable job
+        RESULT_SUCCESS_CACHED       = 2,
+        RESULT_FAILED               = 3,
+        RESULT_TIMEOUT              = 4, // Remote worker disconnected
+        RESULT_SYSTEM_ERROR         = 5, // Remote worker failed, job will be retried
+    };
+
+    static const uint32_t MONITOR_STREAM_MAGIC      = 0x534D4246; // 'FBMS'
+    static const uint32_t MONITOR_STREAM_VERSION    = 1;
+    static const uint32_t HEADER_SIZE               = 64;
+    static const uint32_t RECORD_HEADER_SIZE        = 24;
+    static const uint32_t DEFAULT_RING_SIZE         = ( 4 * 1024 * 1024 );
+    static const char * const DEFAULT_NAME;
+
+    // Create/destroy the shared memory
+    static bool Open( const char * name = DEFAULT_NAME, uint32_t ringSize = DEFAULT_RING_SIZE );
+    static void Close();
+
+    // System-wide lock held by the process publishing under a given name
+    static void GetLockName( const char * name, AString & outLockName );
+
+    static inline bool IsEnabled() { return AtomicLoadRelaxed( &s_Enabled ); }
+
+    // Events
+    static void StartBuild();
+    static void StopBuild();
+    static void JobStart( const Job * job, const char * workerName );
+    static void JobFinish( const Job * job, const char * workerName, JobResult result, const AString & messages );
+    static void JobPhase( const Job * job, uint8_t phase, int64_t startTime, int64_t endTime );
+    static void Progress( float percent );
+
+private:
+    static void Write( EventType type, uint8_t subType, uint32_t jobId, uint32_t value,
+                       const char * workerName = nullptr, const AString * nodeName = nullptr, const AString * messages = nullptr );
+
+    static volatile bool s_Enabled; // Read without the lock from any thread
+};
+
+// MonitorStreamReader - Reference consumer of a MonitorStream
+//------------------------------------------------------------------------------
+class MonitorStreamReader
+{
+public:
+    MonitorStreamReader();
+    ~MonitorStreamReader();
+
+    struct Event
+    {
+        MonitorStream::EventType    m_Type;
+        uint8_t                     m_SubType;
+        uint64_t                    m_TimeUS;
+        uint32_t                    m_JobId;
+        uint32_t                    m_Value;
+        AString                     m_WorkerName;
+        AString                     m_NodeName;
+        AString                     m_Messages;
+    };
+
+    bool Open( const char * name = MonitorStream::DEFAULT_NAME );
+
+    // Returns false if no new events are available
+    bool ReadEvent( Event & outEvent );
+
+    // Number of times events were overwritten before being read
+    inline uint32_t GetNumOverruns() const { return m_NumOverruns; }
+
+private:
+    SharedMemory *  m_SharedMemory;
+    const uint8_t * m_Ring;
+    uint32_t        m_RingSize;
+    uint32_t        m_NumOverruns;
+    uint64_t        m_ReadPos;
+    uint8_t *       m_Record;
+};
+
+//------------------------------------------------------------------------------
@@ -5,13 +5,21 @@
 //------------------------------------------------------------------------------
 #include "MultiBuffer.h"
 
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/FLog.h"
+
 // Core
+#include "Core/Env/ErrorFormat.h"
 #include "Core/FileIO/ConstMemoryStream.h"
 #include "Core/FileIO/FileIO.h"
 #include "Core/FileIO/FileStream.h"
 #include "Core/FileIO/MemoryStream.h"
+#include "Core/Math/Conversions.h"
 #include "Core/Strings/AString.h"
 
+// system
+#include <string.h> // for memcpy
+
 // CONSTRUCTOR
 //------------------------------------------------------------------------------
 MultiBuffer::MultiBuffer()
@@ -126,6 +134,22 @@ bool MultiBuffer::ExtractFile( size_t index, const AString& fileName ) const
     const void * fileData = (void *)( (size_t)m_ReadStream->GetData() + offset );
 
     FileStream fs;
+    if ( !OpenFileForWrite( fs, fileName ) )
+    {
+        return false;
+    }
+    if ( fs.WriteBuffer( fileData, fileSize ) != fileSize )
+    {
+        return false;
+    }
+
+    return true;
+}
+
+// OpenFileForWrite
+//------------------------------------------------------------------------------
+/*static*/ bool MultiBuffer::OpenFileForWrite( FileStream & fs, const AString & fileName )
+{
     if ( !fs.Open( fileName.Get(), FileStream::WRITE_ONLY ) )
     {
         // On Windows, we can occasionally fail to open the file with error 1224 (ERROR_USER_MAPPED_FILE), due to
@@ -140,11 +164,6 @@ bool MultiBuffer::ExtractFile( size_t index, const AString& fileName ) const
             return false;
         }
     }
-    if ( fs.WriteBuffer( fileData, fileSize ) != fileSize )
-    {
-        return false;
-    }
-
     return true;
 }
 
@@ -171,4 +190,135 @@ void * MultiBuffer::Release( size_t & outSize )
     return m_WriteStream->Release();
 }
 
+// MultiBufferFileWriter CONSTRUCTOR
+//------------------------------------------------------------------------------
+MultiBufferFileWriter::MultiBufferFileWriter( const Array< AString > & fileNames )
+    : m_FileNames( fileNames )
+    , m_CurrentFile( 0 )
+    , m_CurrentFileRemaining( 0 )
+    , m_NumFiles( 0 )
+    , m_HeaderSize( 0 )
+    , m_Failed( false )
+{
+    ASSERT( fileNames.GetSize() <= MultiBuffer::MAX_FILES );
+}
+
+// MultiBufferFileWriter DESTRUCTOR
+//------------------------------------------------------------------------------
+MultiBufferFileWriter::~MultiBufferFileWriter() = default;
+
+// Write
+//------------------------------------------------------------------------------
+bool MultiBufferFileWriter::Write( const void * data, size_t dataSize )
+{
+    if ( m_Failed )
+    {
+        return false;
+    }
+
+    const uint8_t * pos = static_cast< const uint8_t * >( data );
+    const uint8_t * const end = ( pos + dataSize );
+    while ( pos < end )
+    {
+        // Header: number of files, followed by the size of each
+        const uint32_t headerSize = ( m_HeaderSize < sizeof( uint32_t ) ) ? (uint32_t)sizeof( uint32_t )
+                                                                          : (uint32_t)( sizeof( uint32_t ) + ( sizeof( uint64_t ) * m_NumFiles ) );
+        if ( m_HeaderSize < headerSize )
+        {
+            const uint32_t bytesToCopy = (uint32_t)Math::Min( (size_t)( headerSize - m_HeaderSize ), (size_t)( end - pos ) );
+            memcpy( m_Header + m_HeaderSize, pos, bytesToCopy );
+            m_HeaderSize += bytesToCopy;
+            pos += bytesToCopy;
+
+            if ( m_HeaderSize == sizeof( uint32_t ) )
+            {
+                memcpy( &m_NumFiles, m_Header, sizeof( uint32_t ) );
+                if ( ( m_NumFiles > MultiBuffer::MAX_FILES ) || ( m_NumFiles < m_FileNames.GetSize() ) )
+                {
+                    m_Failed = true; // corrupt, or missing files we need
+                    return false;
+                }
+            }
+            if ( m_HeaderSize == ( sizeof( uint32_t ) + ( sizeof( uint64_t ) * m_NumFiles ) ) )
+            {
+                if ( OpenNextFile() == false )
+                {
+                    return false;
+                }
+            }
+            continue;
+        }
+
+        // Data for files we don't need is ignored
+        if ( m_CurrentFile >= m_FileNames.GetSize() )
+        {
+            break;
+        }
+
+        // File data
+        const uint64_t bytesToWrite = Math::Min( m_CurrentFileRemaining, (uint64_t)( end - pos ) );
+        if ( m_File.WriteBuffer( pos, bytesToWrite ) != bytesToWrite )
+        {
+            FLOG_ERROR( "Failed to write file. Error: %s File: '%s'", LAST_ERROR_STR, m_FileNames[ m_CurrentFile ].Get() );
+            m_Failed = true;
+            return false;
+        }
+        pos += bytesToWrite;
+        m_CurrentFileRemaining -= bytesToWrite;
+
+        if ( m_CurrentFileRemaining == 0 )
+        {
+            m_File.Close();
+            ++m_CurrentFile;
+            if ( OpenNextFile() == false )
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Finish
+//------------------------------------------------------------------------------
+bool MultiBufferFileWriter::Finish()
+{
+    if ( m_Failed )
+    {
+        return false;
+    }
+
+    // header must have been received, and every file we need written completely
+    const bool headerComplete = ( m_HeaderSize >= sizeof( uint32_t ) ) &&
+                                ( m_HeaderSize == ( sizeof( uint32_t ) + ( sizeof( uint64_t ) * m_NumFiles ) ) );
+    return ( headerComplete && ( m_CurrentFile >= m_FileNames.GetSize() ) );
+}
+
+// OpenNextFile
+//------------------------------------------------------------------------------
+bool MultiBufferFileWriter::OpenNextFile()
+{
+    while ( m_CurrentFile < m_FileNames.GetSize() )
+    {
+        const AString & fileName = m_FileNames[ m_CurrentFile ];
+        if ( MultiBuffer::OpenFileForWrite( m_File, fileName ) == false )
+        {
+            FLOG_ERROR( "Failed to create file. Error: %s File: '%s'", LAST_ERROR_STR, fileName.Get() );
+            m_Failed = true;
+            return false;
+        }
+
+        memcpy( &m_CurrentFileRemaining, m_Header + sizeof( uint32_t ) + ( sizeof( uint64_t ) * m_CurrentFile ), sizeof( uint64_t ) );
+        if ( m_CurrentFileRemaining > 0 )
+        {
+            return true;
+        }
+
+        // empty files are complete as soon as they are created
+        m_File.Close();
+        ++m_CurrentFile;
+    }
+    return true;
+}
+
 //------------------------------------------------------------------------------
@@ -7,10 +7,11 @@
 // Core
 #include "Core/Containers/Array.h"
 #include "Core/Env/Types.h"
+#include "Core/FileIO/FileStream.h"
+#include "Core/Strings/AString.h"
 
 // Forward Declarations
 //------------------------------------------------------------------------------
-class AString;
 class ConstMemoryStream;
 class MemoryStream;
 
@@ -31,11 +32,41 @@ public:
 
     void *          Release( size_t & outSize );
 
-private:
     enum : uint32_t { MAX_FILES = 4 };
 
+private:
+    friend class MultiBufferFileWriter;
+    static bool     OpenFileForWrite( FileStream & fs, const AString & fileName );
+
     ConstMemoryStream * m_ReadStream;
     MemoryStream *      m_WriteStream;
 };
 
+// MultiBufferFileWriter - Extract files from a MultiBuffer which arrives in pieces
+//------------------------------------------------------------------------------
+class MultiBufferFileWriter
+{
+public:
+    explicit MultiBufferFileWriter( const Array< AString > & fileNames );
+    ~MultiBufferFileWriter();
+
+    // Data must be provided in order. Files are written as their data arrives.
+    bool Write( const void * data, size_t dataSize );
+
+    // Check all expected files were written completely
+    bool Finish();
+
+private:
+    bool OpenNextFile();
+
+    Array< AString >    m_FileNames;
+    FileStream          m_File;
+    size_t              m_CurrentFile;
+    uint64_t            m_CurrentFileRemaining;
+    uint32_t            m_NumFiles;
+    uint32_t            m_HeaderSize;
+    uint8_t             m_Header[ sizeof( uint32_t ) + ( sizeof( uint64_t ) * MultiBuffer::MAX_FILES ) ];
+    bool                m_Failed;
+};
+
 //------------------------------------------------------------------------------
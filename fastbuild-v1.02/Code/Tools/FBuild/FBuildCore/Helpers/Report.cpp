@@ -8,6 +8,7 @@
 // FBuild
 #include "Tools/FBuild/FBuildCore/FBuild.h"
 #include "Tools/FBuild/FBuildCore/FBuildVersion.h"
+#include "Tools/FBuild/FBuildCore/Graph/LibraryNode.h"
 #include "Tools/FBuild/FBuildCore/Graph/ObjectNode.h"
 #include "Tools/FBuild/FBuildCore/Helpers/FBuildStats.h"
 
@@ -47,6 +48,7 @@ uint32_t g_ReportNodeColors[] = {
                                   0x000000, // SETTINGS_NODE (never seen)
                                   0xFFFFFF, // VSPROJEXTERNAL_NODE
                                   0xFFFFFF, // TEXT_FILE_NODE
+                                  0xCCCCCC, // LINK_PREP_NODE
                                 };
 
 // CONSTRUCTOR
@@ -163,6 +165,7 @@ void Report::Generate( const FBuildStats & stats )
     DoCPUTimeByType( stats );
     DoCacheStats( stats );
     DoCPUTimeByLibrary();
+    DoIncrementalLibraries();
     DoCPUTimeByItem( stats );
 
     DoIncludes();
@@ -714,6 +717,51 @@ void Report::DoCPUTimeByLibrary()
     }
 }
 
+// DoIncrementalLibraries
+//------------------------------------------------------------------------------
+void Report::DoIncrementalLibraries()
+{
+    // Libraries which replaced only their changed members
+    Array< const LibraryNode * > libraries( m_LibraryStats.GetSize(), false );
+    for ( const LibraryStats * ls : m_LibraryStats )
+    {
+        if ( ls->library->GetType() == Node::LIBRARY_NODE )
+        {
+            const LibraryNode * ln = ls->library->CastTo< LibraryNode >();
+            if ( ln->GetNumMembersUpdated() > 0 )
+            {
+                libraries.Append( ln );
+            }
+        }
+    }
+    if ( libraries.IsEmpty() )
+    {
+        return; // Don't clutter the report when not in use
+    }
+
+    DoSectionTitle( "Incremental Libraries", "incrementalLibraries" );
+
+    DoTableStart();
+
+    // Headings
+    Write( "<tr><th style=\"width:80px;\">Saved</th><th style=\"width:100px;\">Updated</th><th>Name</th></tr>\n" );
+
+    // Saved time is relative to the last full build of each library
+    uint32_t totalSavedMS = 0;
+    for ( const LibraryNode * ln : libraries )
+    {
+        Write( "<tr><td>%2.3fs</td><td>%u / %u</td><td>%s</td></tr>\n",
+               (double)ln->GetIncrementalSavedMS() * 0.001,
+               ln->GetNumMembersUpdated(),
+               ln->GetNumMembers(),
+               ln->GetName().Get() );
+        totalSavedMS += ln->GetIncrementalSavedMS();
+    }
+    Write( "<tr><td>%2.3fs</td><td></td><td>Total</td></tr>\n", (double)totalSavedMS * 0.001 );
+
+    DoTableStop();
+}
+
 // DoIncludes
 //------------------------------------------------------------------------------
 PRAGMA_DISABLE_PUSH_MSVC( 6262 ) // warning C6262: Function uses '262212' bytes of stack
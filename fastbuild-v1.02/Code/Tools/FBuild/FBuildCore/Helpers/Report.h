@@ -36,6 +36,7 @@ private:
     void DoCPUTimeByType( const FBuildStats & stats );
     void DoCPUTimeByItem( const FBuildStats & stats );
     void DoCPUTimeByLibrary();
+    void DoIncrementalLibraries();
     void DoIncludes();
 
     void CreateFooter();
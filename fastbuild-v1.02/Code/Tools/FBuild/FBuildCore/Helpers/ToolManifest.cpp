@@ -7,15 +7,20 @@
 
 // Core
 #include "Core/Containers/AutoPtr.h"
+#include "Core/Containers/Move.h"
 #include "Core/Env/Env.h"
 #include "Core/FileIO/ConstMemoryStream.h"
 #include "Core/FileIO/FileIO.h"
 #include "Core/FileIO/FileStream.h"
 #include "Core/FileIO/MemoryStream.h"
 #include "Core/FileIO/PathUtils.h"
+#include "Core/Math/Conversions.h"
 #include "Core/Math/xxHash.h"
+#include "Core/Process/Atomic.h"
+#include "Core/Process/ThreadPool.h"
 #include "Core/Profile/Profile.h"
 #include "Core/Strings/AStackString.h"
+#include "Core/Time/Time.h"
 #include "Tools/FBuild/FBuildCore/FBuild.h"
 #include "Tools/FBuild/FBuildCore/FLog.h"
 #include "Tools/FBuild/FBuildCore/Graph/FileNode.h"
@@ -39,16 +44,38 @@ REFLECT_STRUCT_BEGIN( ToolManifestFile, Struct, MetaNone() )
     REFLECT( m_TimeStamp,   "TimeStamp",    MetaHidden() )
     REFLECT( m_Hash,        "Hash",         MetaHidden() )
     REFLECT( m_UncompressedContentSize, "UncompressedContentSize",  MetaHidden() )
-    REFLECT( m_CompressedContentSize, "CompressedContentSize",  MetaHidden() )
 REFLECT_END( ToolManifestFile )
 
+// Defines
+//------------------------------------------------------------------------------
+#define TOOL_MANIFEST_DEFAULT_CACHE_LIMIT   ( 256 * MEGABYTE )
+#define TOOL_MANIFEST_MIN_FILES_PER_THREAD  ( 8 ) // Not worth creating threads for small toolchains
+#define TOOL_MANIFEST_STORE_MAGIC           ( 'F' | ( 'T' << 8 ) | ( 'S' << 16 ) | ( 1 << 24 ) ) // Bump last byte on format change
+#define TOOL_MANIFEST_STORE_USE_INTERVAL_S  ( 60 ) // How often last use is written to the store
+
+// Static Data
+//------------------------------------------------------------------------------
+/*static*/ Mutex ToolManifestFile::s_CacheMutex;
+/*static*/ const ToolManifestFile * ToolManifestFile::s_CacheHead( nullptr );
+/*static*/ const ToolManifestFile * ToolManifestFile::s_CacheTail( nullptr );
+/*static*/ size_t ToolManifestFile::s_CacheSize( 0 );
+/*static*/ size_t ToolManifestFile::s_CacheLimit( TOOL_MANIFEST_DEFAULT_CACHE_LIMIT );
+
+// ToolManifestBuildContext
+//------------------------------------------------------------------------------
+struct ToolManifestBuildContext
+{
+    Array< ToolManifestFile > * m_Files;
+    volatile uint32_t           m_NumFailures;
+};
+
 // CONSTRUCTOR (ToolManifestFile)
 //------------------------------------------------------------------------------
 ToolManifestFile::ToolManifestFile() = default;
 
 // CONSTRUCTOR (ToolManifestFile)
 //------------------------------------------------------------------------------
-ToolManifestFile::ToolManifestFile( const AString & name, uint64_t stamp, uint32_t hash, uint32_t size )
+ToolManifestFile::ToolManifestFile( const AString & name, uint64_t stamp, uint64_t hash, uint32_t size )
     : m_Name( name )
     , m_TimeStamp( stamp )
     , m_Hash( hash )
@@ -59,10 +86,97 @@ ToolManifestFile::ToolManifestFile( const AString & name, uint64_t stamp, uint32
 //------------------------------------------------------------------------------
 ToolManifestFile::~ToolManifestFile()
 {
-    FREE( m_CompressedContent );
+    {
+        MutexHolder mh( s_CacheMutex );
+        if ( m_CompressedContent )
+        {
+            CacheEvict();
+        }
+    }
     FDELETE( m_FileLock );
 }
 
+// CONSTRUCTOR (ToolManifestFile) - Copy
+//------------------------------------------------------------------------------
+ToolManifestFile::ToolManifestFile( const ToolManifestFile & other )
+    : Struct()
+    , m_Name( other.m_Name )
+    , m_TimeStamp( other.m_TimeStamp )
+    , m_Hash( other.m_Hash )
+    , m_UncompressedContentSize( other.m_UncompressedContentSize )
+    , m_SyncState( other.m_SyncState )
+{
+}
+
+// CONSTRUCTOR (ToolManifestFile) - Move
+//------------------------------------------------------------------------------
+ToolManifestFile::ToolManifestFile( ToolManifestFile && other )
+    : Struct()
+    , m_Name( Move( other.m_Name ) )
+    , m_TimeStamp( other.m_TimeStamp )
+    , m_Hash( other.m_Hash )
+    , m_UncompressedContentSize( other.m_UncompressedContentSize )
+    , m_SyncState( other.m_SyncState )
+    , m_FileLock( other.m_FileLock )
+{
+    other.m_FileLock = nullptr;
+
+    MutexHolder mh( s_CacheMutex );
+    CacheTakeOver( other );
+}
+
+// operator = (ToolManifestFile) - Copy
+//------------------------------------------------------------------------------
+ToolManifestFile & ToolManifestFile::operator = ( const ToolManifestFile & other )
+{
+    if ( this == &other )
+    {
+        return *this;
+    }
+
+    m_Name = other.m_Name;
+    m_TimeStamp = other.m_TimeStamp;
+    m_Hash = other.m_Hash;
+    m_UncompressedContentSize = other.m_UncompressedContentSize;
+    m_SyncState = other.m_SyncState;
+    FDELETE( m_FileLock );
+    m_FileLock = nullptr;
+
+    MutexHolder mh( s_CacheMutex );
+    if ( m_CompressedContent )
+    {
+        CacheEvict();
+    }
+    return *this;
+}
+
+// operator = (ToolManifestFile) - Move
+//------------------------------------------------------------------------------
+ToolManifestFile & ToolManifestFile::operator = ( ToolManifestFile && other )
+{
+    if ( this == &other )
+    {
+        return *this;
+    }
+
+    m_Name = Move( other.m_Name );
+    m_TimeStamp = other.m_TimeStamp;
+    m_Hash = other.m_Hash;
+    m_UncompressedContentSize = other.m_UncompressedContentSize;
+    m_SyncState = other.m_SyncState;
+    FDELETE( m_FileLock );
+    m_FileLock = other.m_FileLock;
+    other.m_FileLock = nullptr;
+
+    MutexHolder mh( s_CacheMutex );
+    if ( m_CompressedContent )
+    {
+        CacheEvict();
+    }
+    CacheTakeOver( other );
+    return *this;
+}
+
 // CONSTRUCTOR
 //------------------------------------------------------------------------------
 ToolManifest::ToolManifest()
@@ -72,6 +186,10 @@ ToolManifest::ToolManifest()
     , m_Synchronized( false )
     , m_RemoteEnvironmentString( nullptr )
     , m_UserData( nullptr )
+    , m_Stored( false )
+    , m_NumJobRefs( 0 )
+    , m_LastUseTime( 0 )
+    , m_LastUseStoreTime( 0 )
 {
 }
 
@@ -84,6 +202,10 @@ ToolManifest::ToolManifest( uint64_t toolId )
     , m_Synchronized( false )
     , m_RemoteEnvironmentString( nullptr )
     , m_UserData( nullptr )
+    , m_Stored( false )
+    , m_NumJobRefs( 0 )
+    , m_LastUseTime( 0 )
+    , m_LastUseStoreTime( 0 )
 {
 }
 
@@ -94,28 +216,17 @@ ToolManifest::~ToolManifest()
     FREE( (void *)m_RemoteEnvironmentString );
 }
 
-// StoreCompressedContent (ToolManifestFile)
-//------------------------------------------------------------------------------
-void ToolManifestFile::StoreCompressedContent( const void * uncompressedData, const uint32_t uncompressedDataSize ) const
-{
-    ASSERT( m_CompressedContent == nullptr );
-    m_UncompressedContentSize = uncompressedDataSize;
-    Compressor c;
-    c.Compress( uncompressedData, m_UncompressedContentSize );
-    m_CompressedContentSize = (uint32_t)c.GetResultSize();
-    m_CompressedContent = c.ReleaseResult();
-}
-
 // DoBuild
 //------------------------------------------------------------------------------
 bool ToolManifestFile::DoBuild()
 {
+    // NOTE: Can be called from any thread
+
     // Name should be set
     ASSERT( m_Name.IsEmpty() == false );
 
     // Should not have any file data in memory
     ASSERT( m_CompressedContent == nullptr );
-    ASSERT( m_CompressedContentSize == 0 );
 
     // Do we already have a hash?
     if ( m_Hash != 0 )
@@ -140,14 +251,10 @@ bool ToolManifestFile::DoBuild()
     m_UncompressedContentSize = uncompressedContentSize;
 
     // Store the hash and timestamp
-    m_Hash = xxHash::Calc32( uncompressedContent, uncompressedContentSize ); // TODO:C Switch to 64 bit hash
+    m_Hash = xxHash::Calc64( uncompressedContent, uncompressedContentSize );
     m_TimeStamp = FileIO::GetFileLastWriteTime( m_Name );
 
-    // Compress and keep the data if it might be useful
-    if ( FBuild::Get().GetOptions().m_AllowDistributed )
-    {
-        StoreCompressedContent( uncompressedContent, uncompressedContentSize );
-    }
+    // NOTE: Data is compressed on demand if a worker requests it
 
     FREE( uncompressedContent );
 
@@ -175,7 +282,7 @@ void ToolManifest::Initialize( const AString & mainExecutableRoot, const Depende
     m_Files.SetCapacity( dependencies.GetSize() );
     for ( const Dependency & dep : dependencies )
     {
-        m_Files.EmplaceBack( dep.GetNode()->GetName(), (uint64_t)0, (uint32_t)0, (uint32_t)0 );
+        m_Files.EmplaceBack( dep.GetNode()->GetName(), (uint64_t)0, (uint64_t)0, (uint32_t)0 );
     }
 }
 
@@ -188,20 +295,31 @@ bool ToolManifest::DoBuild( const Dependencies & dependencies )
 
     m_TimeStamp = 0;
 
-    // Get timestamps and hashes
-    for ( ToolManifestFile & file : m_Files )
+    // Get timestamps and hashes (in parallel for large toolchains)
+    const size_t numFiles( m_Files.GetSize() );
+    ToolManifestBuildContext context = { &m_Files, 0 };
+    const uint32_t numThreads = Math::Min( (uint32_t)( numFiles / TOOL_MANIFEST_MIN_FILES_PER_THREAD ), Env::GetNumProcessors() );
+    if ( numThreads > 1 )
+    {
+        ThreadPool pool( numThreads );
+        pool.ParallelFor( (uint32_t)numFiles, DoBuildFile, &context );
+    }
+    else
     {
-        if ( !file.DoBuild() )
+        for ( size_t i = 0; i < numFiles; ++i )
         {
-            return false; // DoBuild will have emitted an rrror
+            DoBuildFile( &context, (uint32_t)i );
         }
     }
+    if ( context.m_NumFailures > 0 )
+    {
+        return false; // DoBuild will have emitted an error
+    }
 
     // create a hash for the whole tool chain
-    const size_t numFiles( m_Files.GetSize() );
-    const size_t memSize( numFiles * sizeof( uint32_t ) * 2 );
-    uint32_t * mem = (uint32_t *)ALLOC( memSize );
-    uint32_t * pos = mem;
+    const size_t memSize( numFiles * sizeof( uint64_t ) * 2 );
+    uint64_t * mem = (uint64_t *)ALLOC( memSize );
+    uint64_t * pos = mem;
     for ( size_t i=0; i<numFiles; ++i )
     {
         const ToolManifestFile & f = m_Files[ i ];
@@ -213,7 +331,7 @@ bool ToolManifest::DoBuild( const Dependencies & dependencies )
         // file name & sub-path (relative to remote folder)
         AStackString<> relativePath;
         GetRelativePath( m_MainExecutableRootPath, f.GetName(), relativePath );
-        *pos = xxHash::Calc32( relativePath );
+        *pos = xxHash::Calc64( relativePath );
         ++pos;
     }
     m_ToolId = xxHash::Calc64( mem, memSize );
@@ -230,6 +348,17 @@ bool ToolManifest::DoBuild( const Dependencies & dependencies )
     return true;
 }
 
+// DoBuildFile
+//------------------------------------------------------------------------------
+/*static*/ void ToolManifest::DoBuildFile( void * userData, uint32_t index )
+{
+    ToolManifestBuildContext & context = *static_cast< ToolManifestBuildContext * >( userData );
+    if ( ( *context.m_Files )[ index ].DoBuild() == false )
+    {
+        AtomicIncU32( &context.m_NumFailures );
+    }
+}
+
 // Migrate
 //------------------------------------------------------------------------------
 void ToolManifest::Migrate( const ToolManifest & oldManifest )
@@ -277,43 +406,12 @@ void ToolManifest::SerializeForRemote( IOStream & ms ) const
 //------------------------------------------------------------------------------
 void ToolManifest::DeserializeFromRemote( IOStream & ms )
 {
-    ms.Read( m_ToolId );
-    ms.Read( m_MainExecutableRootPath );
-
-    ASSERT( m_Files.IsEmpty() );
-
-    uint32_t numFiles( 0 );
-    ms.Read( numFiles );
-    m_Files.SetCapacity( numFiles );
-
-    for ( size_t i=0; i<(size_t)numFiles; ++i )
-    {
-        AStackString<> name;
-        uint64_t timeStamp( 0 );
-        uint32_t hash( 0 );
-        uint32_t uncompressedContentSize( 0 );
-        ms.Read( name );
-        ms.Read( timeStamp );
-        ms.Read( hash );
-        ms.Read( uncompressedContentSize );
-        m_Files.EmplaceBack( name, timeStamp, hash, uncompressedContentSize );
-    }
-
-    ASSERT( m_CustomEnvironmentVariables.IsEmpty() );
-
-    uint32_t numEnvVars( 0 );
-    ms.Read( numEnvVars );
-    m_CustomEnvironmentVariables.SetCapacity( numEnvVars );
-    for ( size_t i = 0; i < (size_t)numEnvVars; ++i )
-    {
-        AStackString<> envVar;
-        ms.Read( envVar );
-        m_CustomEnvironmentVariables.Append( envVar );
-    }
+    VERIFY( ReadFromRemote( ms ) );
 
     // determine if any files are remaining from a previous run
     size_t numFilesAlreadySynchronized = 0;
-    for ( size_t i=0; i<(size_t)numFiles; ++i )
+    const size_t numFiles = m_Files.GetSize();
+    for ( size_t i=0; i<numFiles; ++i )
     {
         AStackString<> localFile;
         GetRemoteFilePath( (uint32_t)i, localFile );
@@ -342,7 +440,7 @@ void ToolManifest::DeserializeFromRemote( IOStream & ms )
         {
             continue; // problem reading file
         }
-        if ( xxHash::Calc32( mem.Get(), (size_t)f.GetFileSize() ) != m_Files[ i ].GetHash() )
+        if ( xxHash::Calc64( mem.Get(), (size_t)f.GetFileSize() ) != m_Files[ i ].GetHash() )
         {
             continue; // file contents unexpected
         }
@@ -353,7 +451,75 @@ void ToolManifest::DeserializeFromRemote( IOStream & ms )
         numFilesAlreadySynchronized++;
     }
 
-    // Generate Environment
+    GenerateRemoteEnvironment();
+
+    // are all files already present?
+    if ( numFilesAlreadySynchronized == numFiles )
+    {
+        m_Synchronized = true;
+    }
+}
+
+// ReadFromRemote
+//------------------------------------------------------------------------------
+bool ToolManifest::ReadFromRemote( IOStream & ms )
+{
+    if ( ( ms.Read( m_ToolId ) == false ) ||
+         ( ms.Read( m_MainExecutableRootPath ) == false ) )
+    {
+        return false;
+    }
+
+    ASSERT( m_Files.IsEmpty() );
+
+    uint32_t numFiles( 0 );
+    if ( ( ms.Read( numFiles ) == false ) || ( numFiles > ms.GetFileSize() ) ) // sanity check before allocating
+    {
+        return false;
+    }
+    m_Files.SetCapacity( numFiles );
+
+    for ( size_t i=0; i<(size_t)numFiles; ++i )
+    {
+        AStackString<> name;
+        uint64_t timeStamp( 0 );
+        uint64_t hash( 0 );
+        uint32_t uncompressedContentSize( 0 );
+        if ( ( ms.Read( name ) == false ) ||
+             ( ms.Read( timeStamp ) == false ) ||
+             ( ms.Read( hash ) == false ) ||
+             ( ms.Read( uncompressedContentSize ) == false ) )
+        {
+            return false;
+        }
+        m_Files.EmplaceBack( name, timeStamp, hash, uncompressedContentSize );
+    }
+
+    ASSERT( m_CustomEnvironmentVariables.IsEmpty() );
+
+    uint32_t numEnvVars( 0 );
+    if ( ( ms.Read( numEnvVars ) == false ) || ( numEnvVars > ms.GetFileSize() ) ) // sanity check before allocating
+    {
+        return false;
+    }
+    m_CustomEnvironmentVariables.SetCapacity( numEnvVars );
+    for ( size_t i = 0; i < (size_t)numEnvVars; ++i )
+    {
+        AStackString<> envVar;
+        if ( ms.Read( envVar ) == false )
+        {
+            return false;
+        }
+        m_CustomEnvironmentVariables.Append( envVar );
+    }
+
+    return true;
+}
+
+// GenerateRemoteEnvironment
+//------------------------------------------------------------------------------
+void ToolManifest::GenerateRemoteEnvironment()
+{
     ASSERT( m_RemoteEnvironmentString == nullptr );
 
     // PATH=
@@ -380,6 +546,7 @@ void ToolManifest::DeserializeFromRemote( IOStream & ms )
         len += ( sysRoot.GetLength() + 1 );
     #endif
 
+    const size_t numEnvVars = m_CustomEnvironmentVariables.GetSize();
     for ( size_t i = 0; i < numEnvVars; ++i )
     {
         const AString & envVar = m_CustomEnvironmentVariables[i];
@@ -432,12 +599,6 @@ void ToolManifest::DeserializeFromRemote( IOStream & ms )
     }
 
     *mem = 0; ++mem; // double null
-
-    // are all files already present?
-    if ( numFilesAlreadySynchronized == m_Files.GetSize() )
-    {
-        m_Synchronized = true;
-    }
 }
 
 // GetSynchronizationStatus
@@ -495,39 +656,225 @@ void ToolManifest::CancelSynchronizingFiles()
 
 // GetFileData
 //------------------------------------------------------------------------------
-const void * ToolManifest::GetFileData( uint32_t fileId, size_t & dataSize ) const
+void * ToolManifest::GetFileData( uint32_t fileId, size_t & dataSize ) const
 {
     return m_Files[ fileId ].GetFileData( dataSize );
 }
 
 // GetFileData (ToolManifestFile)
 //------------------------------------------------------------------------------
-const void * ToolManifestFile::GetFileData( size_t & outDataSize ) const
+void * ToolManifestFile::GetFileData( size_t & outDataSize ) const
 {
     // Should only be possible to access data if we know it's up-to-date
     ASSERT( m_TimeStamp );
     ASSERT( m_Hash );
 
     // Do we have data already available?
-    if ( m_CompressedContent == nullptr )
     {
-        // Load the file content
-        void * uncompressedContent;
-        uint32_t uncompressedContentSize;
-        if ( LoadFile( uncompressedContent, uncompressedContentSize ) == false )
+        MutexHolder mh( s_CacheMutex );
+        if ( m_CompressedContent )
         {
-            return nullptr; // LoadFile emits an error
+            // Mark as most recently used
+            CacheUnlink();
+            CacheLink();
+
+            outDataSize = m_CompressedContentSize;
+            void * data = ALLOC( outDataSize );
+            memcpy( data, m_CompressedContent, outDataSize );
+            return data;
         }
+    }
 
-        // We should have previously recorded the uncompressed size
-        ASSERT( uncompressedContentSize == m_UncompressedContentSize );
+    // Load the file content
+    void * uncompressedContent;
+    uint32_t uncompressedContentSize;
+    if ( LoadFile( uncompressedContent, uncompressedContentSize ) == false )
+    {
+        return nullptr; // LoadFile emits an error
+    }
 
-        // Store the compressed version
-        StoreCompressedContent( uncompressedContent, uncompressedContentSize );
+    // The file might have changed since it was hashed, in which case it can't be
+    // sent as part of this toolchain (the ToolId is derived from the hash)
+    if ( ( uncompressedContentSize != m_UncompressedContentSize ) ||
+         ( xxHash::Calc64( uncompressedContent, uncompressedContentSize ) != m_Hash ) )
+    {
+        FLOG_ERROR( "Error: file '%s' in Compiler ToolManifest was modified during the build\n", m_Name.Get() );
         FREE( uncompressedContent );
+        return nullptr;
+    }
+
+    // Compress (outside of the lock, so other files can be served)
+    Compressor c;
+    c.Compress( uncompressedContent, uncompressedContentSize );
+    FREE( uncompressedContent );
+    outDataSize = c.GetResultSize();
+    void * data = c.ReleaseResult();
+
+    // Keep a copy in the cache (unless another thread got there first)
+    MutexHolder mh( s_CacheMutex );
+    if ( m_CompressedContent == nullptr )
+    {
+        m_CompressedContent = ALLOC( outDataSize );
+        memcpy( m_CompressedContent, data, outDataSize );
+        m_CompressedContentSize = (uint32_t)outDataSize;
+        CacheLink();
+
+        // Evict least recently used content if over the limit
+        while ( ( s_CacheSize > s_CacheLimit ) && ( s_CacheTail != this ) )
+        {
+            s_CacheTail->CacheEvict();
+        }
+    }
+    return data;
+}
+
+// SetCompressedContentCacheLimit (ToolManifestFile)
+//------------------------------------------------------------------------------
+/*static*/ void ToolManifestFile::SetCompressedContentCacheLimit( size_t limit )
+{
+    MutexHolder mh( s_CacheMutex );
+    s_CacheLimit = limit;
+    while ( ( s_CacheSize > s_CacheLimit ) && s_CacheTail )
+    {
+        s_CacheTail->CacheEvict();
+    }
+}
+
+// GetCompressedContentCacheLimit (ToolManifestFile)
+//------------------------------------------------------------------------------
+/*static*/ size_t ToolManifestFile::GetCompressedContentCacheLimit()
+{
+    MutexHolder mh( s_CacheMutex );
+    return s_CacheLimit;
+}
+
+// GetCompressedContentCacheSize (ToolManifestFile)
+//------------------------------------------------------------------------------
+/*static*/ size_t ToolManifestFile::GetCompressedContentCacheSize()
+{
+    MutexHolder mh( s_CacheMutex );
+    return s_CacheSize;
+}
+
+// IsCompressedContentCached (ToolManifestFile)
+//------------------------------------------------------------------------------
+bool ToolManifestFile::IsCompressedContentCached() const
+{
+    MutexHolder mh( s_CacheMutex );
+    return ( m_CompressedContent != nullptr );
+}
+
+// CacheLink (ToolManifestFile)
+//------------------------------------------------------------------------------
+void ToolManifestFile::CacheLink() const
+{
+    // NOTE: s_CacheMutex must be held
+    ASSERT( m_CompressedContent );
+    ASSERT( ( m_CachePrev == nullptr ) && ( m_CacheNext == nullptr ) && ( s_CacheHead != this ) );
+
+    // Insert as most recently used
+    m_CacheNext = s_CacheHead;
+    if ( s_CacheHead )
+    {
+        s_CacheHead->m_CachePrev = this;
+    }
+    s_CacheHead = this;
+    if ( s_CacheTail == nullptr )
+    {
+        s_CacheTail = this;
     }
-    outDataSize = m_CompressedContentSize;
-    return m_CompressedContent;
+    s_CacheSize += m_CompressedContentSize;
+}
+
+// CacheUnlink (ToolManifestFile)
+//------------------------------------------------------------------------------
+void ToolManifestFile::CacheUnlink() const
+{
+    // NOTE: s_CacheMutex must be held
+    ASSERT( m_CompressedContent );
+
+    if ( m_CachePrev )
+    {
+        m_CachePrev->m_CacheNext = m_CacheNext;
+    }
+    else
+    {
+        ASSERT( s_CacheHead == this );
+        s_CacheHead = m_CacheNext;
+    }
+    if ( m_CacheNext )
+    {
+        m_CacheNext->m_CachePrev = m_CachePrev;
+    }
+    else
+    {
+        ASSERT( s_CacheTail == this );
+        s_CacheTail = m_CachePrev;
+    }
+    m_CachePrev = nullptr;
+    m_CacheNext = nullptr;
+
+    ASSERT( s_CacheSize >= m_CompressedContentSize );
+    s_CacheSize -= m_CompressedContentSize;
+}
+
+// CacheEvict (ToolManifestFile)
+//------------------------------------------------------------------------------
+void ToolManifestFile::CacheEvict() const
+{
+    // NOTE: s_CacheMutex must be held
+    CacheUnlink();
+    FREE( m_CompressedContent );
+    m_CompressedContent = nullptr;
+    m_CompressedContentSize = 0;
+}
+
+// CacheTakeOver (ToolManifestFile)
+//------------------------------------------------------------------------------
+void ToolManifestFile::CacheTakeOver( const ToolManifestFile & other ) const
+{
+    // NOTE: s_CacheMutex must be held
+    ASSERT( m_CompressedContent == nullptr );
+
+    m_CompressedContent = other.m_CompressedContent;
+    m_CompressedContentSize = other.m_CompressedContentSize;
+    m_CachePrev = other.m_CachePrev;
+    m_CacheNext = other.m_CacheNext;
+    other.m_CompressedContent = nullptr;
+    other.m_CompressedContentSize = 0;
+    other.m_CachePrev = nullptr;
+    other.m_CacheNext = nullptr;
+
+    // Take the place of the other file in the list
+    if ( m_CompressedContent )
+    {
+        if ( m_CachePrev )
+        {
+            m_CachePrev->m_CacheNext = this;
+        }
+        else
+        {
+            ASSERT( s_CacheHead == &other );
+            s_CacheHead = this;
+        }
+        if ( m_CacheNext )
+        {
+            m_CacheNext->m_CachePrev = this;
+        }
+        else
+        {
+            ASSERT( s_CacheTail == &other );
+            s_CacheTail = this;
+        }
+    }
+}
+
+// ReleaseFileLock (ToolManifestFile)
+//------------------------------------------------------------------------------
+void ToolManifestFile::ReleaseFileLock()
+{
+    FDELETE( m_FileLock );
+    m_FileLock = nullptr;
 }
 
 // ReceiveFileData
@@ -557,6 +904,15 @@ bool ToolManifest::ReceiveFileData( uint32_t fileId, const void * data, size_t &
     const void * uncompressedData = c.GetResult();
     const size_t uncompressedDataSize = c.GetResultSize();
 
+    // The ToolId is derived from the file hashes, so the contents must match
+    // before they are stored (and trusted across restarts)
+    if ( ( uncompressedDataSize != f.GetUncompressedContentSize() ) ||
+         ( xxHash::Calc64( uncompressedData, uncompressedDataSize ) != f.GetHash() ) )
+    {
+        FLOG_WARN( "Mismatched data received for fileId %u", fileId );
+        return false;
+    }
+
     // prepare name for this file
     AStackString<> fileName;
     GetRemoteFilePath( fileId, fileName );
@@ -647,6 +1003,243 @@ bool ToolManifest::ReceiveFileData( uint32_t fileId, const void * data, size_t &
     }
 #endif
 
+// SaveToStore
+//------------------------------------------------------------------------------
+bool ToolManifest::SaveToStore()
+{
+    PROFILE_FUNCTION
+
+    ASSERT( m_Synchronized );
+
+    MemoryStream ms;
+    ms.Write( (uint32_t)TOOL_MANIFEST_STORE_MAGIC );
+    SerializeForRemote( ms );
+
+    // Write to a temp file and move it into place, so an interrupted
+    // write can't leave a partial index behind
+    AStackString<> indexFile;
+    GetStoreIndexPath( indexFile );
+    AStackString<> tmpFile( indexFile );
+    tmpFile += ".tmp";
+    {
+        FileStream fs;
+        if ( FileIO::EnsurePathExistsForFile( tmpFile ) == false )
+        {
+            return false;
+        }
+        if ( ( fs.Open( tmpFile.Get(), FileStream::WRITE_ONLY ) == false ) ||
+             ( fs.Write( ms.GetData(), ms.GetSize() ) != ms.GetSize() ) )
+        {
+            return false;
+        }
+    }
+    if ( FileIO::FileMove( tmpFile, indexFile ) == false )
+    {
+        FileIO::FileDelete( tmpFile.Get() );
+        return false;
+    }
+
+    m_Stored = true;
+    m_LastUseTime = Time::GetCurrentFileTime();
+    m_LastUseStoreTime = m_LastUseTime;
+    return true;
+}
+
+// LoadFromStore
+//------------------------------------------------------------------------------
+ToolManifest::StoreLoadResult ToolManifest::LoadFromStore( const AString & indexFile )
+{
+    PROFILE_FUNCTION
+
+    ASSERT( m_Files.IsEmpty() && ( m_Synchronized == false ) );
+
+    // Read the index
+    AutoPtr< char > mem;
+    size_t memSize = 0;
+    {
+        FileStream fs;
+        if ( fs.Open( indexFile.Get(), FileStream::READ_ONLY ) == false )
+        {
+            return STORE_UNREADABLE;
+        }
+        memSize = (size_t)fs.GetFileSize();
+        mem = (char *)ALLOC( memSize );
+        if ( fs.Read( mem.Get(), memSize ) != memSize )
+        {
+            return STORE_UNREADABLE;
+        }
+    }
+    ConstMemoryStream ms( mem.Get(), memSize );
+    uint32_t magic = 0;
+    if ( ( ms.Read( magic ) == false ) ||
+         ( magic != TOOL_MANIFEST_STORE_MAGIC ) ||
+         ( ReadFromRemote( ms ) == false ) )
+    {
+        return STORE_INVALID; // old or corrupt index
+    }
+
+    // The index must be named for the toolchain it describes
+    AStackString<> expectedIndexFile;
+    GetStoreIndexPath( expectedIndexFile );
+    const char * expectedName = expectedIndexFile.FindLast( NATIVE_SLASH ) + 1;
+    const char * name = indexFile.FindLast( NATIVE_SLASH );
+    if ( AString::StrNCmpI( name ? name + 1 : indexFile.Get(), expectedName, expectedIndexFile.GetLength() + 1 ) != 0 )
+    {
+        return STORE_INVALID;
+    }
+
+    // File contents were validated against their hashes when received. Checking
+    // they are all still present is enough, as hashing gigabytes of toolchains
+    // again would make restarts slow. Unlike toolchains synchronized in this
+    // session, the files are not kept open, as a worker can store many.
+    const size_t numFiles = m_Files.GetSize();
+    for ( size_t i = 0; i < numFiles; ++i )
+    {
+        AStackString<> localFile;
+        GetRemoteFilePath( (uint32_t)i, localFile );
+
+        // Set modification time to now (see DeserializeFromRemote)
+        FileIO::SetFileLastWriteTimeToNow( localFile );
+
+        FileIO::FileInfo info;
+        if ( FileIO::GetFileInfo( localFile, info ) == false )
+        {
+            return FileIO::FileExists( localFile.Get() ) ? STORE_UNREADABLE : STORE_INVALID; // missing
+        }
+        if ( info.m_Size != m_Files[ i ].GetUncompressedContentSize() )
+        {
+            return STORE_INVALID; // incomplete
+        }
+        m_Files[ i ].SetSyncState( ToolManifestFile::SYNCHRONIZED );
+    }
+
+    GenerateRemoteEnvironment();
+
+    m_Synchronized = true;
+    m_Stored = true;
+    m_LastUseTime = FileIO::GetFileLastWriteTime( indexFile );
+    m_LastUseStoreTime = m_LastUseTime;
+    return STORE_LOADED;
+}
+
+// DeleteFromStore
+//------------------------------------------------------------------------------
+void ToolManifest::DeleteFromStore()
+{
+    PROFILE_FUNCTION
+
+    MutexHolder mh( m_Mutex );
+
+    // Remove the index first, so an interrupted delete is not loaded again
+    AStackString<> indexFile;
+    GetStoreIndexPath( indexFile );
+    FileIO::FileDelete( indexFile.Get() );
+    m_Stored = false;
+    m_Synchronized = false;
+
+    AStackString<> basePath;
+    GetRemotePath( basePath );
+    const size_t numFiles = m_Files.GetSize();
+    for ( size_t i = 0; i < numFiles; ++i )
+    {
+        ToolManifestFile & f = m_Files[ i ];
+        f.ReleaseFileLock();
+        f.SetSyncState( ToolManifestFile::NOT_SYNCHRONIZED );
+
+        AStackString<> localFile;
+        GetRemoteFilePath( (uint32_t)i, localFile );
+        FileIO::FileDelete( localFile.Get() );
+
+        // Remove sub-directories as they become empty
+        AStackString<> dir( localFile.Get(), localFile.FindLast( NATIVE_SLASH ) );
+        while ( ( dir.GetLength() + 1 ) >= basePath.GetLength() ) // including the toolchain dir itself
+        {
+            if ( FileIO::DirectoryDelete( dir ) == false )
+            {
+                break; // not empty yet
+            }
+            const char * slash = dir.FindLast( NATIVE_SLASH );
+            if ( slash == nullptr )
+            {
+                break;
+            }
+            dir.SetLength( (uint32_t)( slash - dir.Get() ) );
+        }
+    }
+}
+
+// GetStoreIndexPath
+//------------------------------------------------------------------------------
+void ToolManifest::GetStoreIndexPath( AString & path ) const
+{
+    GetStorePath( path );
+    AStackString<> fileName;
+    fileName.Format( "toolchain.%016" PRIx64 ".manifest", m_ToolId );
+    path += fileName;
+}
+
+// GetStorePath
+//------------------------------------------------------------------------------
+/*static*/ void ToolManifest::GetStorePath( AString & path )
+{
+    VERIFY( FBuild::GetTempDir( path ) );
+    #if defined( __WINDOWS__ )
+        path += ".fbuild.tmp\\worker\\";
+    #else
+        path += "_fbuild.tmp/worker/";
+    #endif
+}
+
+// GetTotalFileSize
+//------------------------------------------------------------------------------
+uint64_t ToolManifest::GetTotalFileSize() const
+{
+    uint64_t totalSize = 0;
+    for ( const ToolManifestFile & f : m_Files )
+    {
+        totalSize += f.GetUncompressedContentSize();
+    }
+    return totalSize;
+}
+
+// AddJobRef
+//------------------------------------------------------------------------------
+void ToolManifest::AddJobRef()
+{
+    AtomicIncU32( &m_NumJobRefs );
+}
+
+// ReleaseJobRef
+//------------------------------------------------------------------------------
+void ToolManifest::ReleaseJobRef()
+{
+    ASSERT( AtomicLoadRelaxed( &m_NumJobRefs ) > 0 );
+    AtomicDecU32( &m_NumJobRefs );
+}
+
+// GetNumJobRefs
+//------------------------------------------------------------------------------
+uint32_t ToolManifest::GetNumJobRefs() const
+{
+    return AtomicLoadRelaxed( &m_NumJobRefs );
+}
+
+// MarkUsed
+//------------------------------------------------------------------------------
+void ToolManifest::MarkUsed()
+{
+    m_LastUseTime = Time::GetCurrentFileTime();
+
+    // Occasionally record use in the store too, so it survives restarts
+    if ( m_Stored && ( Time::FileTimeToSeconds( m_LastUseTime - m_LastUseStoreTime ) >= TOOL_MANIFEST_STORE_USE_INTERVAL_S ) )
+    {
+        AStackString<> indexFile;
+        GetStoreIndexPath( indexFile );
+        FileIO::SetFileLastWriteTimeToNow( indexFile );
+        m_LastUseStoreTime = m_LastUseTime;
+    }
+}
+
 // GetRemoteFilePath
 //------------------------------------------------------------------------------
 void ToolManifest::GetRemoteFilePath( uint32_t fileId, AString & remotePath ) const
@@ -665,13 +1258,9 @@ void ToolManifest::GetRemoteFilePath( uint32_t fileId, AString & remotePath ) co
 //------------------------------------------------------------------------------
 void ToolManifest::GetRemotePath( AString & path ) const
 {
-    VERIFY( FBuild::GetTempDir( path ) );
+    GetStorePath( path );
     AStackString<> subDir;
-    #if defined( __WINDOWS__ )
-        subDir.Format( ".fbuild.tmp\\worker\\toolchain.%016" PRIx64 "\\", m_ToolId );
-    #else
-        subDir.Format( "_fbuild.tmp/worker/toolchain.%016" PRIx64 "/", m_ToolId );
-    #endif
+    subDir.Format( "toolchain.%016" PRIx64 "%c", m_ToolId, NATIVE_SLASH );
     path += subDir;
 }
 
@@ -26,9 +26,16 @@ class ToolManifestFile : public Struct
     REFLECT_STRUCT_DECLARE( ToolManifestFile )
 public:
     ToolManifestFile();
-    explicit ToolManifestFile( const AString & name, uint64_t stamp, uint32_t hash, uint32_t size );
+    explicit ToolManifestFile( const AString & name, uint64_t stamp, uint64_t hash, uint32_t size );
     ~ToolManifestFile();
 
+    // Files are linked into the shared cache by address. A move takes over the
+    // cached contents and file lock, a copy starts with neither.
+    ToolManifestFile( const ToolManifestFile & other );
+    ToolManifestFile( ToolManifestFile && other );
+    ToolManifestFile & operator = ( const ToolManifestFile & other );
+    ToolManifestFile & operator = ( ToolManifestFile && other );
+
     enum SyncState
     {
         NOT_SYNCHRONIZED,
@@ -37,34 +44,54 @@ public:
     };
 
     bool                DoBuild();
-    void                StoreCompressedContent( const void * uncompressedData, const uint32_t uncompressedDataSize ) const;
     void                Migrate( const ToolManifestFile & oldFile );
 
-    const void *        GetFileData( size_t & outDataSize ) const;
+    // Get a copy of the compressed file contents (caller must FREE)
+    void *              GetFileData( size_t & outDataSize ) const;
+
+    // Compressed contents are created on demand and kept in memory by a
+    // shared LRU cache, up to a limit
+    static void         SetCompressedContentCacheLimit( size_t limit );
+    static size_t       GetCompressedContentCacheLimit();
+    static size_t       GetCompressedContentCacheSize();
+    bool                IsCompressedContentCached() const;
 
     // Access state
     const AString &     GetName() const                     { return m_Name; }
     uint64_t            GetTimeStamp() const                { return m_TimeStamp; }
-    uint32_t            GetHash() const                     { return m_Hash; }
+    uint64_t            GetHash() const                     { return m_Hash; }
     uint32_t            GetUncompressedContentSize() const  { return m_UncompressedContentSize; }
     SyncState           GetSyncState() const                { return m_SyncState; }
 
     // Modify state
     void                SetSyncState( SyncState state )         { m_SyncState = state; }
     void                SetFileLock( FileStream * fileLock )    { m_FileLock = fileLock; }
+    void                ReleaseFileLock();
 
 protected:
     bool                LoadFile( void * & uncompressedContent, uint32_t & uncompressedContentSize ) const;
+    void                CacheLink() const;
+    void                CacheUnlink() const;
+    void                CacheEvict() const;
+    void                CacheTakeOver( const ToolManifestFile & other ) const;
 
     // common members
     AString          m_Name;
     uint64_t         m_TimeStamp     = 0;
-    uint32_t         m_Hash          = 0;
-    mutable uint32_t m_UncompressedContentSize = 0;
-    mutable uint32_t m_CompressedContentSize = 0;
+    uint64_t         m_Hash          = 0;
+    uint32_t         m_UncompressedContentSize = 0;
 
-    // "local" members
-    mutable void *   m_CompressedContent = nullptr;
+    // "local" members (protected by s_CacheMutex)
+    mutable void *                      m_CompressedContent     = nullptr;
+    mutable uint32_t                    m_CompressedContentSize = 0;
+    mutable const ToolManifestFile *    m_CachePrev             = nullptr; // More recently used
+    mutable const ToolManifestFile *    m_CacheNext             = nullptr; // Less recently used
+
+    static Mutex                    s_CacheMutex;
+    static const ToolManifestFile * s_CacheHead;    // Most recently used
+    static const ToolManifestFile * s_CacheTail;    // Least recently used
+    static size_t                   s_CacheSize;
+    static size_t                   s_CacheLimit;
 
     // "remote" members
     SyncState       m_SyncState     = NOT_SYNCHRONIZED;
@@ -107,7 +134,7 @@ public:
     void MarkFileAsSynchronizing( size_t fileId ) { ASSERT( m_Files[ fileId ].GetSyncState() == ToolManifestFile::NOT_SYNCHRONIZED ); m_Files[ fileId ].SetSyncState( ToolManifestFile::SYNCHRONIZING ); }
     void CancelSynchronizingFiles();
 
-    const void *    GetFileData( uint32_t fileId, size_t & dataSize ) const;
+    void *          GetFileData( uint32_t fileId, size_t & dataSize ) const; // caller must FREE
     bool            ReceiveFileData( uint32_t fileId, const void * data, size_t & dataSize );
 
     void            GetRemotePath( AString & path ) const;
@@ -120,7 +147,33 @@ public:
         void            TouchFiles() const;
     #endif
 
+    // Worker side store, so synchronized toolchains survive worker restarts
+    enum StoreLoadResult : uint8_t
+    {
+        STORE_LOADED,
+        STORE_INVALID,      // index is stale or corrupt, so can be deleted
+        STORE_UNREADABLE,   // index or files could not be accessed right now
+    };
+    bool            SaveToStore();
+    StoreLoadResult LoadFromStore( const AString & indexFile );
+    void            DeleteFromStore();
+    void            GetStoreIndexPath( AString & path ) const;
+    static void     GetStorePath( AString & path );
+    uint64_t        GetTotalFileSize() const;
+
+    // Worker side usage tracking (for eviction from the store)
+    void            AddJobRef();
+    void            ReleaseJobRef();
+    uint32_t        GetNumJobRefs() const;
+    void            MarkUsed();
+    inline uint64_t GetLastUseTime() const { return m_LastUseTime; }
+
 private:
+    static void     DoBuildFile( void * userData, uint32_t index );
+
+    bool            ReadFromRemote( IOStream & ms );
+    void            GenerateRemoteEnvironment();
+
     mutable Mutex   m_Mutex;
 
     // Reflected
@@ -134,6 +187,10 @@ private:
     bool            m_Synchronized;
     const char *    m_RemoteEnvironmentString;
     void *          m_UserData;
+    bool            m_Stored;           // index is in the store
+    volatile uint32_t m_NumJobRefs;     // jobs using the toolchain
+    uint64_t        m_LastUseTime;      // file time
+    uint64_t        m_LastUseStoreTime; // file time last written to the index
 };
 
 //------------------------------------------------------------------------------
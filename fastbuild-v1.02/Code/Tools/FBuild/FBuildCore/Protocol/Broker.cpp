@@ -0,0 +1,293 @@
+// Broker.cpp - Optional service workers report to, and clients find workers from
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Broker.h"
+
+// FBuild
+#include "Tools/FBuild/FBuildCore/FLog.h"
+#include "Tools/FBuild/FBuildCore/Protocol/Protocol.h"
+
+// Core
+#include "Core/Env/Env.h"
+#include "Core/FileIO/ConstMemoryStream.h"
+#include "Core/FileIO/MemoryStream.h"
+#include "Core/Mem/Mem.h"
+#include "Core/Profile/Profile.h"
+#include "Core/Strings/AStackString.h"
+
+// BrokerWorkerInfo (CONSTRUCTOR)
+//------------------------------------------------------------------------------
+BrokerWorkerInfo::BrokerWorkerInfo()
+    : m_NumCPUs( 0 )
+    , m_NumFreeSlots( 0 )
+    , m_CPUScore( 0 )
+    , m_ToolIds( 0, true )
+{
+}
+
+// BrokerWorkerInfo::operator <
+//------------------------------------------------------------------------------
+bool BrokerWorkerInfo::operator < ( const BrokerWorkerInfo & other ) const
+{
+    // Free compute first, then the most CPUs (busy workers may free up)
+    const uint64_t capacity = ( (uint64_t)m_NumFreeSlots * m_CPUScore );
+    const uint64_t otherCapacity = ( (uint64_t)other.m_NumFreeSlots * other.m_CPUScore );
+    if ( capacity != otherCapacity )
+    {
+        return ( capacity > otherCapacity );
+    }
+    if ( m_NumCPUs != other.m_NumCPUs )
+    {
+        return ( m_NumCPUs > other.m_NumCPUs );
+    }
+    return ( m_HostName < other.m_HostName ); // stable order for equal workers
+}
+
+// BrokerWorkerInfo::Serialize
+//------------------------------------------------------------------------------
+void BrokerWorkerInfo::Serialize( IOStream & stream ) const
+{
+    stream.Write( m_HostName );
+    stream.Write( m_NumCPUs );
+    stream.Write( m_NumFreeSlots );
+    stream.Write( m_CPUScore );
+    stream.Write( m_ToolIds );
+}
+
+// BrokerWorkerInfo::Deserialize
+//------------------------------------------------------------------------------
+bool BrokerWorkerInfo::Deserialize( IOStream & stream )
+{
+    return ( stream.Read( m_HostName ) &&
+             stream.Read( m_NumCPUs ) &&
+             stream.Read( m_NumFreeSlots ) &&
+             stream.Read( m_CPUScore ) &&
+             stream.Read( m_ToolIds ) );
+}
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+Broker::Broker( float heartbeatTimeoutSeconds )
+    : m_HeartbeatTimeout( heartbeatTimeoutSeconds )
+    , m_Workers( 64, true )
+{
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+Broker::~Broker()
+{
+    ShutdownAllConnections();
+
+    for ( WorkerState * ws : m_Workers )
+    {
+        FDELETE ws;
+    }
+}
+
+// GetWorkers
+//------------------------------------------------------------------------------
+void Broker::GetWorkers( Array< BrokerWorkerInfo > & outWorkers ) const
+{
+    MutexHolder mh( m_WorkersMutex );
+
+    outWorkers.SetCapacity( outWorkers.GetSize() + m_Workers.GetSize() );
+    for ( const WorkerState * ws : m_Workers )
+    {
+        // Ignore workers which are unavailable or have stopped responding
+        if ( ( ws->m_Info.m_NumCPUs == 0 ) ||
+             ( ws->m_LastHeartbeat.GetElapsed() > m_HeartbeatTimeout ) )
+        {
+            continue;
+        }
+        outWorkers.Append( ws->m_Info );
+    }
+
+    outWorkers.Sort();
+}
+
+// OnConnected
+//------------------------------------------------------------------------------
+/*virtual*/ void Broker::OnConnected( const ConnectionInfo * connection )
+{
+    connection->SetUserData( FNEW( ConnectionState ) );
+}
+
+// OnDisconnected
+//------------------------------------------------------------------------------
+/*virtual*/ void Broker::OnDisconnected( const ConnectionInfo * connection )
+{
+    ConnectionState * cs = (ConnectionState *)connection->GetUserData();
+    ASSERT( cs );
+
+    RemoveWorker( connection );
+
+    // Might need to be freed if the connection dropped between message and payload
+    FREE( (void *)( cs->m_CurrentMessage ) );
+    FDELETE cs;
+}
+
+// OnReceive
+//------------------------------------------------------------------------------
+/*virtual*/ void Broker::OnReceive( const ConnectionInfo * connection, void * data, uint32_t size, bool & keepMemory )
+{
+    keepMemory = true; // we'll take care of freeing the memory
+
+    ConnectionState * cs = (ConnectionState *)connection->GetUserData();
+    ASSERT( cs );
+
+    // are we expecting a msg, or the payload for a msg?
+    void * payload = nullptr;
+    size_t payloadSize = 0;
+    if ( cs->m_CurrentMessage == nullptr )
+    {
+        // message
+        cs->m_CurrentMessage = static_cast< const Protocol::IMessage * >( data );
+        if ( cs->m_CurrentMessage->HasPayload() )
+        {
+            return;
+        }
+    }
+    else
+    {
+        // payload
+        ASSERT( cs->m_CurrentMessage->HasPayload() );
+        payload = data;
+        payloadSize = size;
+    }
+
+    // determine message type
+    const Protocol::IMessage * imsg = cs->m_CurrentMessage;
+    Protocol::MessageType messageType = imsg->GetType();
+
+    PROTOCOL_DEBUG( "Client -> Broker : %u (%s)\n", messageType, GetProtocolMessageDebugName( messageType ) );
+
+    switch ( messageType )
+    {
+        case Protocol::MSG_BROKER_HEARTBEAT:
+        {
+            const Protocol::MsgBrokerHeartbeat * msg = static_cast< const Protocol::MsgBrokerHeartbeat * >( imsg );
+            Process( connection, msg, payload, payloadSize );
+            break;
+        }
+        case Protocol::MSG_BROKER_REQUEST_WORKERS:
+        {
+            const Protocol::MsgBrokerRequestWorkers * msg = static_cast< const Protocol::MsgBrokerRequestWorkers * >( imsg );
+            Process( connection, msg );
+            break;
+        }
+        default:
+        {
+            // unknown message type (not something a worker or client sends to a broker)
+            Disconnect( connection );
+            break;
+        }
+    }
+
+    // free everything
+    FREE( (void *)( cs->m_CurrentMessage ) );
+    FREE( payload );
+    cs->m_CurrentMessage = nullptr;
+}
+
+// Process( MsgBrokerHeartbeat )
+//------------------------------------------------------------------------------
+void Broker::Process( const ConnectionInfo * connection, const Protocol::MsgBrokerHeartbeat * msg, const void * payload, size_t payloadSize )
+{
+    PROFILE_FUNCTION
+
+    // Workers of other versions and platforms can't be used by our clients
+    if ( ( msg->GetProtocolVersion() != Protocol::PROTOCOL_VERSION ) ||
+         ( msg->GetPlatform() != Env::GetPlatform() ) )
+    {
+        AStackString<> remoteAddr;
+        TCPConnectionPool::GetAddressAsString( connection->GetRemoteAddress(), remoteAddr );
+        FLOG_WARN( "Disconnecting '%s' (%s) due to bad protocol version or mismatched platform\n", remoteAddr.Get(), msg->GetHostName() );
+        Disconnect( connection );
+        return;
+    }
+
+    BrokerWorkerInfo info;
+    info.m_HostName = msg->GetHostName();
+    info.m_NumCPUs = msg->GetNumCPUs();
+    info.m_NumFreeSlots = msg->GetNumFreeSlots();
+    info.m_CPUScore = msg->GetCPUScore();
+    ConstMemoryStream ms( payload, payloadSize );
+    if ( ms.Read( info.m_ToolIds ) == false )
+    {
+        Disconnect( connection );
+        return;
+    }
+
+    MutexHolder mh( m_WorkersMutex );
+
+    // Find the worker, which might have reconnected
+    WorkerState * worker = nullptr;
+    for ( WorkerState * ws : m_Workers )
+    {
+        if ( ( ws->m_Connection == connection ) || ( ws->m_Info.m_HostName.CompareI( info.m_HostName ) == 0 ) )
+        {
+            worker = ws;
+            break;
+        }
+    }
+    if ( worker == nullptr )
+    {
+        worker = FNEW( WorkerState );
+        m_Workers.Append( worker );
+    }
+
+    worker->m_Connection = connection;
+    worker->m_Info = info;
+    worker->m_LastHeartbeat.Start();
+}
+
+// Process( MsgBrokerRequestWorkers )
+//------------------------------------------------------------------------------
+void Broker::Process( const ConnectionInfo * connection, const Protocol::MsgBrokerRequestWorkers * msg )
+{
+    PROFILE_FUNCTION
+
+    // The worker list format depends on the protocol version
+    if ( ( msg->GetProtocolVersion() != Protocol::PROTOCOL_VERSION ) ||
+         ( msg->GetPlatform() != Env::GetPlatform() ) )
+    {
+        Disconnect( connection );
+        return;
+    }
+
+    Array< BrokerWorkerInfo > workers( 0, true );
+    GetWorkers( workers );
+
+    MemoryStream ms;
+    ms.Write( (uint32_t)workers.GetSize() );
+    for ( const BrokerWorkerInfo & info : workers )
+    {
+        info.Serialize( ms );
+    }
+
+    Protocol::MsgBrokerWorkerList reply;
+    reply.Send( connection, ms );
+}
+
+// RemoveWorker
+//------------------------------------------------------------------------------
+void Broker::RemoveWorker( const ConnectionInfo * connection )
+{
+    MutexHolder mh( m_WorkersMutex );
+
+    const size_t numWorkers = m_Workers.GetSize();
+    for ( size_t i = 0; i < numWorkers; ++i )
+    {
+        if ( m_Workers[ i ]->m_Connection == connection )
+        {
+            FDELETE m_Workers[ i ];
+            m_Workers.EraseIndex( i );
+            return;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
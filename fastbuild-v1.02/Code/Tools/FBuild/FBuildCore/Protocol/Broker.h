@@ -0,0 +1,95 @@
+// Broker.h - Optional service workers report to, and clients find workers from
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Containers/Array.h"
+#include "Core/Network/TCPConnectionPool.h"
+#include "Core/Process/Mutex.h"
+#include "Core/Strings/AString.h"
+#include "Core/Time/Timer.h"
+
+// Forward Declarations
+//------------------------------------------------------------------------------
+class ConstMemoryStream;
+class IOStream;
+namespace Protocol
+{
+    class IMessage;
+    class MsgBrokerHeartbeat;
+    class MsgBrokerRequestWorkers;
+}
+
+// Defines
+//------------------------------------------------------------------------------
+#define BROKER_HEARTBEAT_INTERVAL_SECONDS   ( 2.0f )
+#define BROKER_HEARTBEAT_TIMEOUT_SECONDS    ( 10.0f )
+
+// BrokerWorkerInfo - what a worker last reported
+//------------------------------------------------------------------------------
+class BrokerWorkerInfo
+{
+public:
+    BrokerWorkerInfo();
+
+    // Most free capacity first
+    bool operator < ( const BrokerWorkerInfo & other ) const;
+
+    void Serialize( IOStream & stream ) const;
+    bool Deserialize( IOStream & stream );
+
+    AString             m_HostName;
+    uint32_t            m_NumCPUs;      // CPUs offered
+    uint32_t            m_NumFreeSlots; // CPUs offered but not busy
+    uint32_t            m_CPUScore;     // relative single core performance
+    Array< uint64_t >   m_ToolIds;      // toolchains the worker holds
+};
+
+// Broker
+//------------------------------------------------------------------------------
+// Workers keep a connection open and send a heartbeat with their status. A
+// worker is forgotten when its connection closes or its heartbeats stop, so
+// clients are never given stale workers.
+//------------------------------------------------------------------------------
+class Broker : public TCPConnectionPool
+{
+public:
+    explicit Broker( float heartbeatTimeoutSeconds = BROKER_HEARTBEAT_TIMEOUT_SECONDS );
+    ~Broker();
+
+    // Available workers, ranked
+    void GetWorkers( Array< BrokerWorkerInfo > & outWorkers ) const;
+
+private:
+    // TCPConnection interface
+    virtual void OnConnected( const ConnectionInfo * connection );
+    virtual void OnDisconnected( const ConnectionInfo * connection );
+    virtual void OnReceive( const ConnectionInfo * connection, void * data, uint32_t size, bool & keepMemory );
+
+    // helpers to handle messages
+    void Process( const ConnectionInfo * connection, const Protocol::MsgBrokerHeartbeat * msg, const void * payload, size_t payloadSize );
+    void Process( const ConnectionInfo * connection, const Protocol::MsgBrokerRequestWorkers * msg );
+
+    void RemoveWorker( const ConnectionInfo * connection );
+
+    struct ConnectionState
+    {
+        ConnectionState() : m_CurrentMessage( nullptr ) {}
+
+        const Protocol::IMessage *  m_CurrentMessage;
+    };
+
+    struct WorkerState
+    {
+        const ConnectionInfo *  m_Connection;   // connection the heartbeats arrive on
+        BrokerWorkerInfo        m_Info;
+        Timer                   m_LastHeartbeat;
+    };
+
+    float                   m_HeartbeatTimeout;
+    mutable Mutex           m_WorkersMutex;
+    Array< WorkerState * >  m_Workers;
+};
+
+//------------------------------------------------------------------------------
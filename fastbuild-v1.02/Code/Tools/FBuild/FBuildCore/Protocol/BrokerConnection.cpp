@@ -0,0 +1,202 @@
+// BrokerConnection.cpp - Worker and client side of a connection to a Broker
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "BrokerConnection.h"
+
+// FBuild
+#include "Tools/FBuild/FBuildCore/Protocol/Protocol.h"
+
+// Core
+#include "Core/FileIO/ConstMemoryStream.h"
+#include "Core/FileIO/MemoryStream.h"
+#include "Core/Mem/Mem.h"
+#include "Core/Process/Atomic.h"
+#include "Core/Profile/Profile.h"
+#include "Core/Time/Timer.h"
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+BrokerConnection::BrokerConnection( const AString & brokerHost, uint16_t brokerPort )
+    : m_BrokerHost( brokerHost )
+    , m_BrokerPort( brokerPort )
+    , m_Connection( nullptr )
+    , m_CurrentMessage( nullptr )
+    , m_ReplyReceived( false )
+    , m_Reply( 0, true )
+{
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+BrokerConnection::~BrokerConnection()
+{
+    SetShuttingDown();
+    ShutdownAllConnections();
+}
+
+// SendHeartbeat
+//------------------------------------------------------------------------------
+bool BrokerConnection::SendHeartbeat( const BrokerWorkerInfo & status )
+{
+    PROFILE_FUNCTION
+
+    const ConnectionInfo * connection = EnsureConnected( 2000 );
+    if ( connection == nullptr )
+    {
+        return false;
+    }
+
+    MemoryStream ms;
+    ms.Write( status.m_ToolIds );
+
+    Protocol::MsgBrokerHeartbeat msg( status.m_HostName.Get(), status.m_NumCPUs, status.m_NumFreeSlots, status.m_CPUScore );
+    return msg.Send( connection, ms );
+}
+
+// RequestWorkers
+//------------------------------------------------------------------------------
+bool BrokerConnection::RequestWorkers( Array< BrokerWorkerInfo > & outWorkers, uint32_t timeoutMS )
+{
+    PROFILE_FUNCTION
+
+    Timer t;
+    const ConnectionInfo * connection = EnsureConnected( timeoutMS );
+    if ( connection == nullptr )
+    {
+        return false;
+    }
+
+    {
+        MutexHolder mh( m_Mutex );
+        m_ReplyReceived = false;
+        m_Reply.Clear();
+    }
+
+    Protocol::MsgBrokerRequestWorkers msg;
+    if ( msg.Send( connection ) == false )
+    {
+        return false;
+    }
+
+    // wait for the reply, or the broker to hang up
+    for ( ;; )
+    {
+        const uint32_t elapsedMS = (uint32_t)t.GetElapsedMS();
+        if ( elapsedMS >= timeoutMS )
+        {
+            return false;
+        }
+        m_ReplySemaphore.Wait( timeoutMS - elapsedMS );
+
+        MutexHolder mh( m_Mutex );
+        if ( m_ReplyReceived )
+        {
+            outWorkers.Append( m_Reply );
+            return true;
+        }
+        if ( m_Connection == nullptr )
+        {
+            return false;
+        }
+    }
+}
+
+// IsConnected
+//------------------------------------------------------------------------------
+bool BrokerConnection::IsConnected() const
+{
+    return ( AtomicLoadRelaxed( &m_Connection ) != nullptr );
+}
+
+// OnDisconnected
+//------------------------------------------------------------------------------
+/*virtual*/ void BrokerConnection::OnDisconnected( const ConnectionInfo * /*connection*/ )
+{
+    MutexHolder mh( m_Mutex );
+
+    // Might need to be freed if the connection dropped between message and payload
+    FREE( (void *)( m_CurrentMessage ) );
+    m_CurrentMessage = nullptr;
+
+    AtomicStoreRelaxed( &m_Connection, static_cast< const ConnectionInfo * >( nullptr ) );
+    m_ReplySemaphore.Signal(); // wake anyone waiting for a reply
+}
+
+// OnReceive
+//------------------------------------------------------------------------------
+/*virtual*/ void BrokerConnection::OnReceive( const ConnectionInfo * connection, void * data, uint32_t size, bool & keepMemory )
+{
+    keepMemory = true; // we'll take care of freeing the memory
+
+    MutexHolder mh( m_Mutex );
+
+    // are we expecting a msg, or the payload for a msg?
+    if ( m_CurrentMessage == nullptr )
+    {
+        m_CurrentMessage = static_cast< const Protocol::IMessage * >( data );
+        if ( m_CurrentMessage->HasPayload() )
+        {
+            return;
+        }
+        data = nullptr;
+        size = 0;
+    }
+
+    const Protocol::MessageType messageType = m_CurrentMessage->GetType();
+
+    PROTOCOL_DEBUG( "Broker -> Client : %u (%s)\n", messageType, GetProtocolMessageDebugName( messageType ) );
+
+    if ( messageType == Protocol::MSG_BROKER_WORKER_LIST )
+    {
+        // payload is the number of workers, followed by each worker
+        ConstMemoryStream ms( data, size );
+        uint32_t numWorkers = 0;
+        bool ok = ms.Read( numWorkers ) && ( numWorkers <= size ); // sanity check before allocating
+        m_Reply.SetSize( ok ? numWorkers : 0 );
+        for ( uint32_t i = 0; ok && ( i < numWorkers ); ++i )
+        {
+            ok = m_Reply[ i ].Deserialize( ms );
+        }
+        if ( ok )
+        {
+            m_ReplyReceived = true;
+            m_ReplySemaphore.Signal();
+        }
+        else
+        {
+            m_Reply.Clear();
+            Disconnect( connection );
+        }
+    }
+    else
+    {
+        // unknown message type (brokers only reply to worker list requests)
+        Disconnect( connection );
+    }
+
+    // free everything
+    FREE( (void *)( m_CurrentMessage ) );
+    FREE( data );
+    m_CurrentMessage = nullptr;
+}
+
+// EnsureConnected
+//------------------------------------------------------------------------------
+const ConnectionInfo * BrokerConnection::EnsureConnected( uint32_t timeoutMS )
+{
+    if ( const ConnectionInfo * connection = AtomicLoadRelaxed( &m_Connection ) )
+    {
+        return connection;
+    }
+
+    const ConnectionInfo * ci = Connect( m_BrokerHost, m_BrokerPort, timeoutMS );
+    if ( ci )
+    {
+        AtomicStoreRelaxed( &m_Connection, ci );
+    }
+    return ci;
+}
+
+//------------------------------------------------------------------------------
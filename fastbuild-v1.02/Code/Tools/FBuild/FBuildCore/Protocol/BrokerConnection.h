@@ -0,0 +1,57 @@
+// BrokerConnection.h - Worker and client side of a connection to a Broker
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Tools/FBuild/FBuildCore/Protocol/Broker.h"
+
+#include "Core/Containers/Array.h"
+#include "Core/Network/TCPConnectionPool.h"
+#include "Core/Process/Mutex.h"
+#include "Core/Process/Semaphore.h"
+#include "Core/Strings/AString.h"
+
+// Forward Declarations
+//------------------------------------------------------------------------------
+namespace Protocol
+{
+    class IMessage;
+}
+
+// BrokerConnection
+//------------------------------------------------------------------------------
+class BrokerConnection : public TCPConnectionPool
+{
+public:
+    BrokerConnection( const AString & brokerHost, uint16_t brokerPort );
+    ~BrokerConnection();
+
+    // worker interface (connects if needed)
+    bool SendHeartbeat( const BrokerWorkerInfo & status );
+
+    // client interface
+    bool RequestWorkers( Array< BrokerWorkerInfo > & outWorkers, uint32_t timeoutMS = 2000 );
+
+    bool IsConnected() const;
+
+private:
+    virtual void OnDisconnected( const ConnectionInfo * connection );
+    virtual void OnReceive( const ConnectionInfo * connection, void * data, uint32_t size, bool & keepMemory );
+
+    const ConnectionInfo * EnsureConnected( uint32_t timeoutMS );
+
+    AString                     m_BrokerHost;
+    uint16_t                    m_BrokerPort;
+
+    mutable Mutex               m_Mutex;
+    const ConnectionInfo *      m_Connection;
+    const Protocol::IMessage *  m_CurrentMessage;
+
+    // reply to RequestWorkers
+    Semaphore                   m_ReplySemaphore;
+    bool                        m_ReplyReceived;
+    Array< BrokerWorkerInfo >   m_Reply;
+};
+
+//------------------------------------------------------------------------------
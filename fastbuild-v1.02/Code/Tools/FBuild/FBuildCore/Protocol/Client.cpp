@@ -12,24 +12,36 @@
 #include "Tools/FBuild/FBuildCore/Graph/FileNode.h"
 #include "Tools/FBuild/FBuildCore/Graph/Node.h"
 #include "Tools/FBuild/FBuildCore/Graph/ObjectNode.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildMetrics.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildTrace.h"
+#include "Tools/FBuild/FBuildCore/Helpers/HeaderBundle.h"
+#include "Tools/FBuild/FBuildCore/Helpers/MonitorStream.h"
 #include <Tools/FBuild/FBuildCore/Helpers/MultiBuffer.h>
 #include "Tools/FBuild/FBuildCore/WorkerPool/Job.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/JobQueue.h"
 
-#include "Core/Env/ErrorFormat.h"
+#include "Core/Containers/AutoPtr.h"
+#include "Core/Env/Env.h"
 #include "Core/FileIO/ConstMemoryStream.h"
 #include "Core/FileIO/FileIO.h"
 #include "Core/FileIO/FileStream.h"
 #include "Core/FileIO/MemoryStream.h"
+#include "Core/Math/Conversions.h"
 #include "Core/Math/Random.h"
 #include "Core/Process/Atomic.h"
+#include "Core/Process/Process.h"
 #include "Core/Profile/Profile.h"
+#include "Core/Time/Timer.h"
+
+#include <string.h> // for memcpy
 
 // Defines
 //------------------------------------------------------------------------------
 #define CLIENT_STATUS_UPDATE_FREQUENCY_SECONDS ( 0.1f )
 #define CONNECTION_REATTEMPT_DELAY_TIME ( 10.0f )
 #define SYSTEM_ERROR_ATTEMPT_COUNT ( 3 )
+#define CLIENT_MAX_IO_THREADS ( 4 )
+#define CLIENT_RANKED_WORKER_SPREAD ( 4 ) // Clients start connecting at one of this many best ranked workers
 #define DIST_INFO( ... ) if ( m_DetailedLogging ) { FLOG_OUTPUT( __VA_ARGS__ ); }
 
 // CONSTRUCTOR
@@ -37,16 +49,33 @@
 Client::Client( const Array< AString > & workerList,
                 uint16_t port,
                 uint32_t workerConnectionLimit,
-                bool detailedLogging )
+                bool detailedLogging,
+                bool workersRanked )
     : m_WorkerList( workerList )
     , m_ShouldExit( false )
     , m_DetailedLogging( detailedLogging )
+    , m_WorkersRanked( workersRanked )
     , m_WorkerConnectionLimit( workerConnectionLimit )
     , m_Port( port )
+    , m_IOThreads( CLIENT_MAX_IO_THREADS, false )
+    , m_IOShouldExit( false )
+    , m_IOQueue( 32, true )
 {
     // allocate space for server states
     m_ServerList.SetSize( workerList.GetSize() );
 
+    // output of remote jobs is written to disk off the connection threads
+    const uint32_t numIOThreads = Math::Min( Env::GetNumProcessors(), (uint32_t)CLIENT_MAX_IO_THREADS );
+    for ( uint32_t i = 0; i < numIOThreads; ++i )
+    {
+        Thread::ThreadHandle h = Thread::CreateThread( IOThreadFuncStatic,
+                                                       "ClientIO",
+                                                       ( 64 * KILOBYTE ),
+                                                       this );
+        ASSERT( h );
+        m_IOThreads.Append( h );
+    }
+
     m_Thread = Thread::CreateThread( ThreadFuncStatic,
                                      "Client",
                                      ( 64 * KILOBYTE ),
@@ -66,6 +95,16 @@ Client::~Client()
     ShutdownAllConnections();
 
     Thread::CloseHandle( m_Thread );
+
+    // finish writing any output we've already received
+    AtomicStoreRelaxed( &m_IOShouldExit, true );
+    m_IOSemaphore.Signal( (uint32_t)m_IOThreads.GetSize() );
+    for ( Thread::ThreadHandle h : m_IOThreads )
+    {
+        Thread::WaitForThread( h );
+        Thread::CloseHandle( h );
+    }
+    ASSERT( m_IOQueue.IsEmpty() );
 }
 
 //------------------------------------------------------------------------------
@@ -77,6 +116,14 @@ Client::~Client()
 
     MutexHolder mh( ss->m_Mutex );
     DIST_INFO( "Disconnected: %s\n", ss->m_RemoteName.Get() );
+
+    // results we were still receiving will be retried
+    for ( PendingResult * pr : ss->m_StreamedResults )
+    {
+        QueueResultAbort( pr );
+    }
+    ss->m_StreamedResults.Clear();
+
     if ( ss->m_Jobs.IsEmpty() == false )
     {
         Job ** it = ss->m_Jobs.Begin();
@@ -84,11 +131,19 @@ Client::~Client()
         while ( it != end )
         {
             FLOG_MONITOR( "FINISH_JOB TIMEOUT %s \"%s\" \n", ss->m_RemoteName.Get(), (*it)->GetNode()->GetName().Get() );
+            if ( MonitorStream::IsEnabled() )
+            {
+                MonitorStream::JobFinish( *it, ss->m_RemoteName.Get(), MonitorStream::RESULT_TIMEOUT, AString::GetEmpty() );
+            }
+            TraceRemoteJob( *it, Timer::GetNow(), 0, "Timeout" );
             JobQueue::Get().ReturnUnfinishedDistributableJob( *it );
             ++it;
         }
         ss->m_Jobs.Clear();
     }
+    ss->m_HeaderHashes.Clear();
+    ss->m_PCHKeys.Clear();
+    ss->m_PrewarmedManifests.Clear();
 
     // This is usually null here, but might need to be freed if
     // we had the connection drop between message and payload
@@ -175,9 +230,12 @@ void Client::LookForWorkers()
 
     // randomize the start index to better distribute workers when there
     // are many workers/clients - otherwise all clients will attempt to connect
-    // to the same subset of workers
-    Random r;
-    size_t startIndex = r.GetRandIndex( (uint32_t)numWorkers );
+    // to the same subset of workers. Ranked workers (from a broker) are
+    // already ordered by free capacity, so start at one of the best few.
+    // (The process id is mixed in as clients are often started together.)
+    Random r( (uint32_t)Timer::GetNow() + Process::GetCurrentId() );
+    const size_t startRange = m_WorkersRanked ? Math::Min( numWorkers, (size_t)CLIENT_RANKED_WORKER_SPREAD ) : numWorkers;
+    const size_t startIndex = r.GetRandIndex( (uint32_t)startRange );
 
     // find someone to connect to
     for ( size_t j=0; j<numWorkers; j++ )
@@ -351,13 +409,21 @@ void Client::SendMessageInternal( const ConnectionInfo * connection, const Proto
         case Protocol::MSG_REQUEST_JOB:
         {
             const Protocol::MsgRequestJob * msg = static_cast< const Protocol::MsgRequestJob * >( imsg );
-            Process( connection, msg );
+            Process( connection, msg, payload, payloadSize );
             break;
         }
         case Protocol::MSG_JOB_RESULT:
         {
             const Protocol::MsgJobResult * msg = static_cast< const Protocol::MsgJobResult * >( imsg );
             Process( connection, msg, payload, payloadSize );
+            payload = nullptr; // ownership passed on
+            break;
+        }
+        case Protocol::MSG_JOB_RESULT_CHUNK:
+        {
+            const Protocol::MsgJobResultChunk * msg = static_cast< const Protocol::MsgJobResultChunk * >( imsg );
+            Process( connection, msg, payload, payloadSize );
+            payload = nullptr; // ownership passed on
             break;
         }
         case Protocol::MSG_REQUEST_MANIFEST:
@@ -390,13 +456,28 @@ void Client::SendMessageInternal( const ConnectionInfo * connection, const Proto
 
 // Process( MsgRequestJob )
 //------------------------------------------------------------------------------
-void Client::Process( const ConnectionInfo * connection, const Protocol::MsgRequestJob * )
+void Client::Process( const ConnectionInfo * connection, const Protocol::MsgRequestJob *, const void * payload, size_t payloadSize )
 {
     PROFILE_SECTION( "MsgRequestJob" )
 
     ServerState * ss = (ServerState *)connection->GetUserData();
     ASSERT( ss );
 
+    // the server tells us which toolchains it already has
+    Array< uint64_t > toolIds( 0, true );
+    Array< uint64_t > pchKeys( 0, true );
+    {
+        ConstMemoryStream ms( payload, payloadSize );
+        if ( ms.Read( toolIds ) == false )
+        {
+            DIST_INFO( "Protocol Error: %s\n", ss->m_RemoteName.Get() );
+            Disconnect( connection );
+            return;
+        }
+        MutexHolder mh( ss->m_Mutex );
+        pchKeys = ss->m_PCHKeys;
+    }
+
     // no jobs for deny listed workers
     if ( ss->m_Denylisted )
     {
@@ -406,7 +487,9 @@ void Client::Process( const ConnectionInfo * connection, const Protocol::MsgRequ
         return;
     }
 
-    Job * job = JobQueue::Get().GetDistributableJobToProcess( true );
+    // prefer jobs the server won't have to synchronize a toolchain or receive a PCH for
+    const JobQueue::WorkerContents contents = { &toolIds, &pchKeys };
+    Job * job = JobQueue::Get().GetDistributableJobToProcess( true, &contents );
     if ( job == nullptr )
     {
         PROFILE_SECTION( "NoJob" )
@@ -419,16 +502,56 @@ void Client::Process( const ConnectionInfo * connection, const Protocol::MsgRequ
     }
 
     // send the job to the client
+    BuildMetricsScope metricsScope( BuildMetrics::METRIC_SEND );
     MemoryStream stream;
     job->Serialize( stream );
 
+    // Send any headers the server doesn't have yet along with the job
+    if ( job->IsDataHeaderBundle() )
+    {
+        HeaderBundle bundle;
+        VERIFY( bundle.LoadFromJob( job ) ); // created by ObjectNode
+
+        // Decide what to send under the lock. Requests from a server are handled
+        // in order on its connection's thread, so no other job can be sent
+        // before the headers selected here.
+        Array< uint32_t > files( bundle.GetNumFiles(), false );
+        const uint64_t pchKey = JobQueue::GetShippedPCHKey( job );
+        {
+            MutexHolder mh( ss->m_Mutex );
+            bundle.SelectContents( ss->m_HeaderHashes, files );
+
+            // Remember the PCH, so later users of it can be sent here in preference
+            if ( ( pchKey != 0 ) && ( ss->m_PCHKeys.Find( pchKey ) == nullptr ) )
+            {
+                ss->m_PCHKeys.Append( pchKey );
+            }
+        }
+
+        // Read and compress them without it
+        Array< uint64_t > omittedHashes;
+        if ( bundle.SaveContents( files, stream, omittedHashes ) == false )
+        {
+            DIST_INFO( "Headers modified during build of '%s'\n", job->GetNode()->GetName().Get() );
+
+            // Send them again if another job needs them
+            MutexHolder mh( ss->m_Mutex );
+            HeaderBundle::ForgetContents( ss->m_HeaderHashes, omittedHashes );
+            if ( ( pchKey != 0 ) && omittedHashes.Find( pchKey ) ) // keyed by content
+            {
+                ss->m_PCHKeys.FindAndErase( pchKey );
+            }
+        }
+    }
+    metricsScope.SetBytes( stream.GetSize() );
+
     MutexHolder mh( ss->m_Mutex );
 
     ss->m_Jobs.Append( job ); // Track in-flight job
+    job->SetRemoteStart( Timer::GetNow(), BuildTrace::AcquireRemoteTrack( ss->m_RemoteName ) );
 
     // if tool is explicity specified, get the id of the tool manifest
-    Node * n = job->GetNode()->CastTo< ObjectNode >()->GetCompiler();
-    const ToolManifest & manifest = n->CastTo< CompilerNode >()->GetManifest();
+    const ToolManifest & manifest = JobQueue::GetToolManifest( job );
     uint64_t toolId = manifest.GetToolId();
     ASSERT( toolId );
 
@@ -438,26 +561,67 @@ void Client::Process( const ConnectionInfo * connection, const Protocol::MsgRequ
         FLOG_OUTPUT( "-> Obj: %s <REMOTE: %s>\n", job->GetNode()->GetName().Get(), ss->m_RemoteName.Get() );
     }
     FLOG_MONITOR( "START_JOB %s \"%s\" \n", ss->m_RemoteName.Get(), job->GetNode()->GetName().Get() );
+    if ( MonitorStream::IsEnabled() )
+    {
+        MonitorStream::JobStart( job, ss->m_RemoteName.Get() );
+    }
 
     {
         PROFILE_SECTION( "SendJob" )
         Protocol::MsgJob msg( toolId );
         SendMessageInternal( connection, msg, stream );
     }
+
+    // If the server will need another toolchain soon, have it synchronize in the background
+    const ToolManifest * nextManifest = JobQueue::Get().GetNextDistributableToolManifest();
+    if ( nextManifest &&
+         ( nextManifest != &manifest ) &&
+         ( toolIds.Find( nextManifest->GetToolId() ) == nullptr ) &&
+         ( ss->m_PrewarmedManifests.Find( nextManifest ) == nullptr ) )
+    {
+        ss->m_PrewarmedManifests.Append( nextManifest );
+
+        PROFILE_SECTION( "PrewarmToolchain" )
+        DIST_INFO( "Prewarming toolchain 0x%" PRIx64 " on: %s\n", nextManifest->GetToolId(), ss->m_RemoteName.Get() );
+        Protocol::MsgPrewarmToolchain msg( nextManifest->GetToolId() );
+        SendMessageInternal( connection, msg );
+    }
 }
 
 // Process( MsgJobResult )
 //------------------------------------------------------------------------------
-void Client::Process( const ConnectionInfo * connection, const Protocol::MsgJobResult *, const void * payload, size_t payloadSize )
+void Client::Process( const ConnectionInfo * connection, const Protocol::MsgJobResult *, void * payload, size_t payloadSize )
 {
     PROFILE_SECTION( "MsgJobResult" )
 
+    const int64_t receiveTime = Timer::GetNow();
+    BuildMetricsScope metricsScope( BuildMetrics::METRIC_RECEIVE, payloadSize );
+
+    // small results are batched together
+    ConstMemoryStream ms( payload, payloadSize );
+    uint32_t numResults = 0;
+    ms.Read( numResults );
+    void * payloadToKeep = ( numResults == 1 ) ? payload : nullptr; // unbatched output is written without copying
+    for ( uint32_t i = 0; i < numResults; ++i )
+    {
+        ProcessJobResult( connection, ms, receiveTime, payloadToKeep );
+    }
+
+    // free payload unless it's still needed for writing output
+    if ( ( numResults != 1 ) || payloadToKeep )
+    {
+        FREE( payload );
+    }
+}
+
+// ProcessJobResult
+//------------------------------------------------------------------------------
+void Client::ProcessJobResult( const ConnectionInfo * connection, ConstMemoryStream & ms, int64_t receiveTime, void * & payload )
+{
     // find server
     ServerState * ss = (ServerState *)connection->GetUserData();
     ASSERT( ss );
 
-    ConstMemoryStream ms( payload, payloadSize );
-
     uint32_t jobId = 0;
     ms.Read( jobId );
 
@@ -475,11 +639,36 @@ void Client::Process( const ConnectionInfo * connection, const Protocol::MsgJobR
 
     uint32_t buildTime;
     ms.Read( buildTime );
+    BuildMetrics::Record( BuildMetrics::METRIC_REMOTE_COMPILE, (uint64_t)buildTime * 1000 );
+
+    // resources used by the compiler on the worker
+    uint64_t peakMemory = 0;
+    ms.Read( peakMemory );
+    uint64_t cpuTime = 0;
+    ms.Read( cpuTime );
+
+    // temp files the worker wrote to disk (see MemoryStaging)
+    uint64_t diskBytesWritten = 0;
+    ms.Read( diskBytesWritten );
+    BuildMetrics::RecordBytes( BuildMetrics::METRIC_REMOTE_DISK_WRITE, diskBytesWritten );
+
+    // system headers a header bundle was compiled with (see ObjectNode::RecordUnshippedHeaders)
+    Array< AString > unshippedHeaders;
+    ms.Read( unshippedHeaders );
+    Array< uint64_t > unshippedHeaderHashes;
+    ms.Read( unshippedHeaderHashes );
 
     // get result data (built data or errors if failed)
+    // (large outputs are streamed in subsequent MsgJobResultChunk messages)
     uint32_t size = 0;
     ms.Read( size );
+    bool streamed = false;
+    ms.Read( streamed );
     const void * data = (const char *)ms.GetData() + ms.Tell();
+    if ( streamed == false )
+    {
+        ms.Seek( ms.Tell() + size );
+    }
 
     {
         MutexHolder mh( ss->m_Mutex );
@@ -492,168 +681,510 @@ void Client::Process( const ConnectionInfo * connection, const Protocol::MsgJobR
     if ( job == nullptr )
     {
         // don't save result as we were cancelled
+        // (any streamed output for it will be ignored)
         return;
     }
 
-    DIST_INFO( "Got Result: %s - %s%s\n", ss->m_RemoteName.Get(),
+    DIST_INFO( "Got Result: %s - %s%s (%" PRIu64 " bytes to disk)\n", ss->m_RemoteName.Get(),
                                           job->GetNode()->GetName().Get(),
-                                          job->GetDistributionState() == Job::DIST_RACE_WON_REMOTELY ? " (Won Race)" : "" );
+                                          job->GetDistributionState() == Job::DIST_RACE_WON_REMOTELY ? " (Won Race)" : "",
+                                          diskBytesWritten );
+
+    // Were system headers different on the worker? If so, the output can't
+    // be used and the job is preprocessed (and distributed) instead
+    if ( result && ( CheckUnshippedHeaders( ss, job, unshippedHeaders, unshippedHeaderHashes ) == false ) )
+    {
+        // any streamed output will be ignored
+        TraceRemoteJob( job, receiveTime, buildTime, "HeadersMismatched" );
+        JobQueue::Get().ReturnRemoteJobForPreprocessing( job );
+        return;
+    }
 
     job->SetMessages( messages );
+    job->SetResourceUsage( peakMemory, cpuTime );
+    job->SetDiskBytesWritten( diskBytesWritten );
 
     if ( result == true )
     {
-        // built ok - serialize to disc
-        MultiBuffer mb( data, ms.GetSize() - ms.Tell() );
-
-        ObjectNode * objectNode = job->GetNode()->CastTo< ObjectNode >();
-        const AString & nodeName = objectNode->GetName();
-        if ( Node::EnsurePathExistsForFile( nodeName ) == false )
+        // built ok - output is written to disk (and the job finished) by the I/O threads
+        PendingResult * pr = FNEW( PendingResult( job, ss->m_RemoteName, receiveTime, buildTime, size ) );
+        if ( streamed )
         {
-            FLOG_ERROR( "Failed to create path for '%s'", nodeName.Get() );
-            result = false;
+            MutexHolder mh( ss->m_Mutex );
+            ss->m_StreamedResults.Append( pr );
+        }
+        else if ( payload )
+        {
+            QueueResultChunk( pr, payload, data, size, true );
+            payload = nullptr; // now owned by the I/O threads
         }
         else
         {
-            size_t fileIndex = 0;
+            void * mem = ALLOC( size );
+            memcpy( mem, data, size );
+            QueueResultChunk( pr, mem, mem, size, true );
+        }
+        return;
+    }
 
-            const ObjectNode * on = job->GetNode()->CastTo< ObjectNode >();
+    // Attribute any work done here to the remote job's trace
+    BuildTrace::SetThreadTrack( job->GetRemoteTraceTrack() );
 
-            // 1. Object file
-            result = WriteFileToDisk( nodeName, mb, fileIndex++ );
+    ((FileNode *)job->GetNode())->GetStatFlag( Node::STATS_FAILED );
 
-            // 2. PDB file (optional)
-            if ( result && on->IsUsingPDB() )
-            {
-                AStackString<> pdbName;
-                on->GetPDBName( pdbName );
-                result = WriteFileToDisk( pdbName, mb, fileIndex++ );
-            }
+    // failed - build list of errors
+    const AString & nodeName = job->GetNode()->GetName();
+    AStackString< 8192 > failureOutput;
+    failureOutput.Format( "PROBLEM: %s\n", nodeName.Get() );
+    for ( const AString * it = messages.Begin(); it != messages.End(); ++it )
+    {
+        failureOutput += *it;
+    }
 
-            // 3. .nativecodeanalysis.xml (optional)
-            if ( result && on->IsUsingStaticAnalysisMSVC() )
+    // was it a system error?
+    if ( systemError )
+    {
+        // deny list misbehaving worker
+        ss->m_Denylisted = true;
+
+        // take note of failure of job
+        job->OnSystemError();
+
+        // debugging message
+        const size_t workerIndex = (size_t)( ss - m_ServerList.Begin() );
+        const AString & workerName = m_WorkerList[ workerIndex ];
+        DIST_INFO( "Remote System Failure!\n"
+                   " - Deny listed Worker: %s\n"
+                   " - Node              : %s\n"
+                   " - Job Error Count   : %u / %u\n"
+                   " - Details           :\n"
+                   "%s",
+                   workerName.Get(),
+                   job->GetNode()->GetName().Get(),
+                   job->GetSystemErrorCount(), SYSTEM_ERROR_ATTEMPT_COUNT,
+                   failureOutput.Get()
+                  );
+
+        // should we retry on another worker?
+        if ( job->GetSystemErrorCount() < SYSTEM_ERROR_ATTEMPT_COUNT )
+        {
+            // re-queue job which will be re-attempted on another worker
+            if ( MonitorStream::IsEnabled() )
             {
-                AStackString<> xmlFileName;
-                on->GetNativeAnalysisXMLPath( xmlFileName );
-                result = WriteFileToDisk( xmlFileName, mb, fileIndex++ );
+                MonitorStream::JobFinish( job, ss->m_RemoteName.Get(), MonitorStream::RESULT_SYSTEM_ERROR, failureOutput );
             }
+            TraceRemoteJob( job, receiveTime, buildTime, "SystemError" );
+            JobQueue::Get().ReturnUnfinishedDistributableJob( job );
+            return;
+        }
 
-            if ( result )
-            {
-                // record new file time
-                objectNode->RecordStampFromBuiltFile();
+        // failed too many times on different workers, add info about this to
+        // error output
+        AStackString<> tmp;
+        tmp.Format( "FBuild: Error: Task failed on %u different workers\n", (uint32_t)SYSTEM_ERROR_ATTEMPT_COUNT );
+        if ( failureOutput.EndsWith( '\n' ) == false )
+        {
+            failureOutput += '\n';
+        }
+        failureOutput += tmp;
+    }
 
-                // record time taken to build
-                objectNode->SetLastBuildTime( buildTime );
-                objectNode->SetStatFlag(Node::STATS_BUILT);
-                objectNode->SetStatFlag(Node::STATS_BUILT_REMOTE);
+    Node::DumpOutput( nullptr, failureOutput, nullptr );
 
-                // commit to cache?
-                if ( FBuild::Get().GetOptions().m_UseCacheWrite &&
-                        objectNode->ShouldUseCache() )
-                {
-                    objectNode->WriteToCache( job );
-                }
-            }
-            else
-            {
-                objectNode->GetStatFlag( Node::STATS_FAILED );
-            }
+    FinishRemoteJob( job, ss->m_RemoteName, receiveTime, buildTime, false );
+}
+
+// CheckUnshippedHeaders
+//------------------------------------------------------------------------------
+bool Client::CheckUnshippedHeaders( ServerState * ss, const Job * job, const Array< AString > & headers, const Array< uint64_t > & contentHashes ) const
+{
+    if ( headers.GetSize() != contentHashes.GetSize() )
+    {
+        return false;
+    }
+
+    const size_t numHeaders = headers.GetSize();
+    for ( size_t i = 0; i < numHeaders; ++i )
+    {
+        uint64_t contentHash = 0;
+        if ( Node::GetFileContentHash( headers[ i ], contentHash ) && ( contentHash == contentHashes[ i ] ) )
+        {
+            continue;
         }
 
-        // get list of messages during remote work
-        AStackString<> msgBuffer;
-        job->GetMessagesForLog( msgBuffer );
+        // Stop shipping headers for this file
+        ObjectNode * objectNode = job->GetNode()->CastTo< ObjectNode >();
+        objectNode->RejectHeaderShipping();
 
-        if ( objectNode->IsMSVC())
+        DIST_INFO( "Header Mismatch: %s - %s (%s)\n", ss->m_RemoteName.Get(), objectNode->GetName().Get(), headers[ i ].Get() );
+        if ( ss->m_HeadersMismatched == false )
         {
-            if ( objectNode->GetFlag( ObjectNode::FLAG_WARNINGS_AS_ERRORS_MSVC ) == false )
-            {
-                FileNode::HandleWarningsMSVC( job, objectNode->GetName(), msgBuffer );
-            }
+            ss->m_HeadersMismatched = true;
+            FLOG_WARN( "Header '%s' on worker '%s' differs from the local one. Files using it will be preprocessed.\n", headers[ i ].Get(), ss->m_RemoteName.Get() );
         }
-        else if ( objectNode->IsClang() || objectNode->IsGCC() )
+        return false;
+    }
+    return true;
+}
+
+// Process( MsgJobResultChunk )
+//------------------------------------------------------------------------------
+void Client::Process( const ConnectionInfo * connection, const Protocol::MsgJobResultChunk * msg, void * payload, size_t payloadSize )
+{
+    PROFILE_SECTION( "MsgJobResultChunk" )
+
+    BuildMetricsScope metricsScope( BuildMetrics::METRIC_RECEIVE, payloadSize );
+
+    ServerState * ss = (ServerState *)connection->GetUserData();
+    ASSERT( ss );
+
+    // find the result this output belongs to
+    const uint32_t jobId = msg->GetJobId();
+    PendingResult * pr = nullptr;
+    {
+        MutexHolder mh( ss->m_Mutex );
+        for ( PendingResult * streamedResult : ss->m_StreamedResults )
         {
-            if ( !objectNode->GetFlag( ObjectNode::FLAG_WARNINGS_AS_ERRORS_CLANGGCC ) )
+            if ( streamedResult->m_Job->GetJobId() == jobId )
             {
-                FileNode::HandleWarningsClangGCC( job, objectNode->GetName(), msgBuffer );
+                pr = streamedResult;
+                break;
             }
         }
     }
-    else
+    if ( pr == nullptr )
     {
-        ((FileNode *)job->GetNode())->GetStatFlag( Node::STATS_FAILED );
+        // job was cancelled
+        FREE( payload );
+        return;
+    }
 
-        // failed - build list of errors
-        const AString & nodeName = job->GetNode()->GetName();
-        AStackString< 8192 > failureOutput;
-        failureOutput.Format( "PROBLEM: %s\n", nodeName.Get() );
-        for ( const AString * it = messages.Begin(); it != messages.End(); ++it )
+    // more output than we were told to expect, or less?
+    pr->m_DataReceived += (uint32_t)payloadSize;
+    const bool isLast = msg->IsLast();
+    const bool sizeOK = isLast ? ( pr->m_DataReceived == pr->m_DataSize )
+                               : ( pr->m_DataReceived < pr->m_DataSize );
+
+    if ( isLast || ( sizeOK == false ) )
+    {
+        MutexHolder mh( ss->m_Mutex );
+        VERIFY( ss->m_StreamedResults.FindAndErase( pr ) );
+    }
+
+    if ( sizeOK == false )
+    {
+        FREE( payload );
+        QueueResultAbort( pr );
+
+        ASSERT( false ); // this indicates a protocol bug
+        DIST_INFO( "Protocol Error: %s\n", ss->m_RemoteName.Get() );
+        Disconnect( connection );
+        return;
+    }
+
+    QueueResultChunk( pr, payload, payload, payloadSize, isLast );
+}
+
+// QueueResultChunk
+//------------------------------------------------------------------------------
+void Client::QueueResultChunk( PendingResult * pr, void * memory, const void * data, size_t dataSize, bool isLast )
+{
+    MutexHolder mh( m_IOMutex );
+
+    ResultChunk chunk;
+    chunk.m_Memory = memory;
+    chunk.m_Data = data;
+    chunk.m_DataSize = dataSize;
+    pr->m_Chunks.Append( chunk );
+    pr->m_Complete = isLast;
+
+    // output for each result is written by one I/O thread at a time, in order
+    if ( pr->m_Queued == false )
+    {
+        pr->m_Queued = true;
+        m_IOQueue.Append( pr );
+        m_IOSemaphore.Signal();
+    }
+}
+
+// QueueResultAbort
+//------------------------------------------------------------------------------
+void Client::QueueResultAbort( PendingResult * pr )
+{
+    MutexHolder mh( m_IOMutex );
+
+    pr->m_Complete = true;
+    pr->m_Aborted = true;
+
+    if ( pr->m_Queued == false )
+    {
+        pr->m_Queued = true;
+        m_IOQueue.Append( pr );
+        m_IOSemaphore.Signal();
+    }
+}
+
+// IOThreadFuncStatic
+//------------------------------------------------------------------------------
+/*static*/ uint32_t Client::IOThreadFuncStatic( void * param )
+{
+    PROFILE_SET_THREAD_NAME( "ClientIOThread" )
+
+    Client * c = (Client *)param;
+    c->IOThreadFunc();
+    return 0;
+}
+
+// IOThreadFunc
+//------------------------------------------------------------------------------
+void Client::IOThreadFunc()
+{
+    for ( ;; )
+    {
+        m_IOSemaphore.Wait();
+
+        PendingResult * pr = nullptr;
         {
-            failureOutput += *it;
+            MutexHolder mh( m_IOMutex );
+            if ( m_IOQueue.IsEmpty() == false )
+            {
+                pr = m_IOQueue[ 0 ];
+                m_IOQueue.PopFront();
+            }
         }
 
-        // was it a system error?
-        if ( systemError )
+        if ( pr )
         {
-            // deny list misbehaving worker
-            ss->m_Denylisted = true;
+            ProcessPendingResult( pr );
+            continue;
+        }
 
-            // take note of failure of job
-            job->OnSystemError();
+        // only exit once everything queued has been written
+        if ( AtomicLoadRelaxed( &m_IOShouldExit ) )
+        {
+            break;
+        }
+    }
+}
 
-            // debugging message
-            const size_t workerIndex = (size_t)( ss - m_ServerList.Begin() );
-            const AString & workerName = m_WorkerList[ workerIndex ];
-            DIST_INFO( "Remote System Failure!\n"
-                       " - Deny listed Worker: %s\n"
-                       " - Node              : %s\n"
-                       " - Job Error Count   : %u / %u\n"
-                       " - Details           :\n"
-                       "%s",
-                       workerName.Get(),
-                       job->GetNode()->GetName().Get(),
-                       job->GetSystemErrorCount(), SYSTEM_ERROR_ATTEMPT_COUNT,
-                       failureOutput.Get()
-                      );
+// ProcessPendingResult
+//------------------------------------------------------------------------------
+void Client::ProcessPendingResult( PendingResult * pr )
+{
+    PROFILE_FUNCTION
 
-            // should we retry on another worker?
-            if ( job->GetSystemErrorCount() < SYSTEM_ERROR_ATTEMPT_COUNT )
+    for ( ;; )
+    {
+        ResultChunk chunk;
+        bool aborted;
+        {
+            MutexHolder mh( m_IOMutex );
+            if ( pr->m_Chunks.IsEmpty() )
             {
-                // re-queue job which will be re-attempted on another worker
-                JobQueue::Get().ReturnUnfinishedDistributableJob( job );
+                if ( pr->m_Complete )
+                {
+                    break;
+                }
+                pr->m_Queued = false; // queued again when more output arrives
                 return;
             }
+            chunk = pr->m_Chunks[ 0 ];
+            pr->m_Chunks.PopFront();
+            aborted = pr->m_Aborted;
+        }
 
-            // failed too many times on different workers, add info about this to
-            // error output
-            AStackString<> tmp;
-            tmp.Format( "FBuild: Error: Task failed on %u different workers\n", (uint32_t)SYSTEM_ERROR_ATTEMPT_COUNT );
-            if ( failureOutput.EndsWith( '\n' ) == false )
+        if ( aborted == false )
+        {
+            if ( pr->m_WriteStarted == false )
             {
-                failureOutput += '\n';
+                StartWritingResult( pr );
             }
-            failureOutput += tmp;
+            if ( pr->m_Writer )
+            {
+                pr->m_Writer->Write( chunk.m_Data, chunk.m_DataSize ); // failure is reported by Finish
+            }
+        }
+        FREE( chunk.m_Memory );
+    }
+
+    FinishPendingResult( pr );
+    FDELETE pr;
+}
+
+// StartWritingResult
+//------------------------------------------------------------------------------
+void Client::StartWritingResult( PendingResult * pr ) const
+{
+    pr->m_WriteStarted = true;
+
+    const ObjectNode * on = pr->m_Job->GetNode()->CastTo< ObjectNode >();
+    const AString & nodeName = on->GetName();
+    if ( Node::EnsurePathExistsForFile( nodeName ) == false )
+    {
+        FLOG_ERROR( "Failed to create path for '%s'", nodeName.Get() );
+        return;
+    }
+
+    // 1. Object file
+    Array< AString > fileNames( 3, false );
+    fileNames.Append( nodeName );
+
+    // 2. PDB file (optional)
+    if ( on->IsUsingPDB() )
+    {
+        AStackString<> pdbName;
+        on->GetPDBName( pdbName );
+        fileNames.Append( pdbName );
+    }
+
+    // 3. .nativecodeanalysis.xml (optional)
+    if ( on->IsUsingStaticAnalysisMSVC() )
+    {
+        AStackString<> xmlFileName;
+        on->GetNativeAnalysisXMLPath( xmlFileName );
+        fileNames.Append( xmlFileName );
+    }
+
+    pr->m_Writer = FNEW( MultiBufferFileWriter( fileNames ) );
+}
+
+// FinishPendingResult
+//------------------------------------------------------------------------------
+void Client::FinishPendingResult( PendingResult * pr ) const
+{
+    Job * job = pr->m_Job;
+
+    // Attribute any work done here (writing to cache) to the remote job's trace
+    BuildTrace::SetThreadTrack( job->GetRemoteTraceTrack() );
+
+    // connection lost before we got all the output - try again
+    if ( pr->m_Aborted )
+    {
+        DIST_INFO( "Incomplete Result: %s - %s\n", pr->m_RemoteName.Get(), job->GetNode()->GetName().Get() );
+        FLOG_MONITOR( "FINISH_JOB TIMEOUT %s \"%s\" \n", pr->m_RemoteName.Get(), job->GetNode()->GetName().Get() );
+        if ( MonitorStream::IsEnabled() )
+        {
+            MonitorStream::JobFinish( job, pr->m_RemoteName.Get(), MonitorStream::RESULT_TIMEOUT, AString::GetEmpty() );
         }
+        TraceRemoteJob( job, Timer::GetNow(), 0, "Timeout" );
+        JobQueue::Get().ReturnUnfinishedDistributableJob( job );
+        return;
+    }
 
-        Node::DumpOutput( nullptr, failureOutput, nullptr );
+    if ( pr->m_WriteStarted == false )
+    {
+        StartWritingResult( pr );
     }
+    bool result = ( pr->m_Writer && pr->m_Writer->Finish() );
+
+    ObjectNode * objectNode = job->GetNode()->CastTo< ObjectNode >();
+    if ( result )
+    {
+        // record new file time
+        objectNode->RecordStampFromBuiltFile();
+        objectNode->RecordPCHContentHash();
+
+        // record time taken to build
+        objectNode->SetLastBuildTime( pr->m_BuildTime );
+        const uint64_t peakMemory = job->GetPeakMemoryBytes();
+        if ( peakMemory )
+        {
+            objectNode->SetLastPeakMemory( peakMemory );
+        }
+        objectNode->SetStatFlag(Node::STATS_BUILT);
+        objectNode->SetStatFlag(Node::STATS_BUILT_REMOTE);
 
-    if ( FLog::IsMonitorEnabled() )
+        // commit to cache?
+        if ( FBuild::Get().GetOptions().m_UseCacheWrite &&
+                objectNode->ShouldUseCache() )
+        {
+            objectNode->WriteToCache( job );
+        }
+    }
+    else
+    {
+        objectNode->GetStatFlag( Node::STATS_FAILED );
+    }
+
+    // get list of messages during remote work
+    AStackString<> msgBuffer;
+    job->GetMessagesForLog( msgBuffer );
+
+    if ( objectNode->IsMSVC())
+    {
+        if ( objectNode->GetFlag( ObjectNode::FLAG_WARNINGS_AS_ERRORS_MSVC ) == false )
+        {
+            FileNode::HandleWarningsMSVC( job, objectNode->GetName(), msgBuffer );
+        }
+    }
+    else if ( objectNode->IsClang() || objectNode->IsGCC() )
+    {
+        if ( !objectNode->GetFlag( ObjectNode::FLAG_WARNINGS_AS_ERRORS_CLANGGCC ) )
+        {
+            FileNode::HandleWarningsClangGCC( job, objectNode->GetName(), msgBuffer );
+        }
+    }
+
+    FinishRemoteJob( job, pr->m_RemoteName, pr->m_ReceiveTime, pr->m_BuildTime, result );
+}
+
+// FinishRemoteJob
+//------------------------------------------------------------------------------
+/*static*/ void Client::FinishRemoteJob( Job * job, const AString & remoteName, int64_t receiveTime, uint32_t buildTimeMS, bool result )
+{
+    if ( FLog::IsMonitorEnabled() || MonitorStream::IsEnabled() )
     {
         AStackString<> msgBuffer;
         job->GetMessagesForMonitorLog( msgBuffer );
 
         FLOG_MONITOR( "FINISH_JOB %s %s \"%s\" \"%s\"\n",
                       result ? "SUCCESS" : "ERROR",
-                      ss->m_RemoteName.Get(),
+                      remoteName.Get(),
                       job->GetNode()->GetName().Get(),
                       msgBuffer.Get() );
+        if ( MonitorStream::IsEnabled() )
+        {
+            MonitorStream::JobFinish( job, remoteName.Get(), result ? MonitorStream::RESULT_SUCCESS : MonitorStream::RESULT_FAILED, msgBuffer );
+        }
     }
 
+    TraceRemoteJob( job, receiveTime, buildTimeMS, result ? "Built" : "Failed" );
+
     JobQueue::Get().FinishedProcessingJob( job, result, true ); // remote job
 }
 
+// TraceRemoteJob
+//------------------------------------------------------------------------------
+/*static*/ void Client::TraceRemoteJob( Job * job, int64_t receiveTime, uint32_t buildTimeMS, const char * result )
+{
+    BuildTrace::SetThreadTrack( BuildTrace::INVALID_TRACK );
+
+    const uint32_t track = job->GetRemoteTraceTrack();
+    if ( track == BuildTrace::INVALID_TRACK )
+    {
+        return; // not tracing
+    }
+
+    // The worker only reports how long the compile took, so everything else
+    // between sending the job and receiving the result is network time
+    const Node * node = job->GetNode();
+    const int64_t startTime = job->GetRemoteStartTime();
+    int64_t compileStartTime = receiveTime - ( ( (int64_t)buildTimeMS * Timer::GetFrequency() ) / 1000 );
+    if ( compileStartTime < startTime )
+    {
+        compileStartTime = startTime;
+    }
+    if ( buildTimeMS > 0 )
+    {
+        BuildTrace::RecordOnTrack( track, BuildTrace::PHASE_NETWORK, node, startTime, compileStartTime );
+        BuildTrace::RecordOnTrack( track, BuildTrace::PHASE_COMPILE, node, compileStartTime, receiveTime );
+    }
+    BuildTrace::RecordOnTrack( track, BuildTrace::PHASE_JOB, node, startTime, Timer::GetNow(), result );
+
+    BuildTrace::ReleaseRemoteTrack( track );
+    job->SetRemoteStart( 0, BuildTrace::INVALID_TRACK );
+}
+
 // Process( MsgRequestManifest )
 //------------------------------------------------------------------------------
 void Client::Process( const ConnectionInfo * connection, const Protocol::MsgRequestManifest * msg )
@@ -678,6 +1209,8 @@ void Client::Process( const ConnectionInfo * connection, const Protocol::MsgRequ
 
     // Send manifest to worker
     Protocol::MsgManifest resultMsg( toolId );
+    ServerState * ss = (ServerState *)connection->GetUserData();
+    MutexHolder mh( ss->m_Mutex ); // serialize sends on this connection
     resultMsg.Send( connection, ms );
 }
 
@@ -702,18 +1235,20 @@ void Client::Process( const ConnectionInfo * connection, const Protocol::MsgRequ
 
     const uint32_t fileId = msg->GetFileId();
     size_t dataSize( 0 );
-    const void * data = manifest->GetFileData( fileId, dataSize );
-    if ( !data )
+    AutoPtr< void > data( manifest->GetFileData( fileId, dataSize ) );
+    if ( !data.Get() )
     {
-        ASSERT( false ); // something is terribly wrong
+        // The file is missing or was modified (GetFileData will have emitted an error)
         Disconnect( connection );
         return;
     }
 
-    ConstMemoryStream ms( data, dataSize );
+    ConstMemoryStream ms( data.Get(), dataSize );
 
     // Send file to worker
     Protocol::MsgFile resultMsg( toolId, fileId );
+    ServerState * ss = (ServerState *)connection->GetUserData();
+    MutexHolder mh( ss->m_Mutex ); // serialize sends on this connection
     resultMsg.Send( connection, ms );
 }
 
@@ -730,8 +1265,7 @@ const ToolManifest * Client::FindManifest( const ConnectionInfo * connection, ui
           it != ss->m_Jobs.End();
           ++it )
     {
-        Node * n = ( *it )->GetNode()->CastTo< ObjectNode >()->GetCompiler();
-        const ToolManifest & m = n->CastTo< CompilerNode >()->GetManifest();
+        const ToolManifest & m = JobQueue::GetToolManifest( *it );
         if ( m.GetToolId() == toolId )
         {
             // found a job with the same toolid
@@ -739,19 +1273,16 @@ const ToolManifest * Client::FindManifest( const ConnectionInfo * connection, ui
         }
     }
 
-    return nullptr;
-}
-
-// WriteFileToDisk
-//------------------------------------------------------------------------------
-bool Client::WriteFileToDisk( const AString & fileName, const MultiBuffer & multiBuffer, size_t index ) const
-{
-    if ( multiBuffer.ExtractFile( index, fileName ) == false )
+    // or a toolchain we asked the server to synchronize ahead of time
+    for ( const ToolManifest * m : ss->m_PrewarmedManifests )
     {
-        FLOG_ERROR( "Failed to create file. Error: %s File: '%s'", LAST_ERROR_STR, fileName.Get() );
-        return false;
+        if ( m->GetToolId() == toolId )
+        {
+            return m;
+        }
     }
-    return true;
+
+    return nullptr;
 }
 
 // CONSTRUCTOR( ServerState )
@@ -761,9 +1292,40 @@ Client::ServerState::ServerState()
     , m_CurrentMessage( nullptr )
     , m_NumJobsAvailable( 0 )
     , m_Jobs( 16, true )
+    , m_HeaderHashes( 0, true )
+    , m_PCHKeys( 0, true )
+    , m_PrewarmedManifests( 0, true )
+    , m_StreamedResults( 0, true )
     , m_Denylisted( false )
+    , m_HeadersMismatched( false )
 {
     m_DelayTimer.Start( 999.0f );
 }
 
+// CONSTRUCTOR( PendingResult )
+//------------------------------------------------------------------------------
+Client::PendingResult::PendingResult( Job * job, const AString & remoteName, int64_t receiveTime, uint32_t buildTime, uint32_t dataSize )
+    : m_Job( job )
+    , m_RemoteName( remoteName )
+    , m_ReceiveTime( receiveTime )
+    , m_BuildTime( buildTime )
+    , m_DataSize( dataSize )
+    , m_DataReceived( 0 )
+    , m_Writer( nullptr )
+    , m_WriteStarted( false )
+    , m_Chunks( 0, true )
+    , m_Complete( false )
+    , m_Aborted( false )
+    , m_Queued( false )
+{
+}
+
+// DESTRUCTOR( PendingResult )
+//------------------------------------------------------------------------------
+Client::PendingResult::~PendingResult()
+{
+    ASSERT( m_Chunks.IsEmpty() );
+    FDELETE m_Writer;
+}
+
 //------------------------------------------------------------------------------
@@ -6,19 +6,22 @@
 //------------------------------------------------------------------------------
 #include "Core/Containers/Array.h"
 #include "Core/Network/TCPConnectionPool.h"
+#include "Core/Process/Semaphore.h"
 #include "Core/Process/Thread.h"
 #include "Core/Strings/AString.h"
 #include "Core/Time/Timer.h"
 
 // Forward Declarations
 //------------------------------------------------------------------------------
+class ConstMemoryStream;
 class Job;
 class MemoryStream;
-class MultiBuffer;
+class MultiBufferFileWriter;
 namespace Protocol
 {
     class IMessage;
     class MsgJobResult;
+    class MsgJobResultChunk;
     class MsgRequestJob;
     class MsgRequestManifest;
     class MsgRequestFile;
@@ -34,20 +37,27 @@ public:
     Client( const Array< AString > & workerList,
             uint16_t port,
             uint32_t workerConnectionLimit,
-            bool detailedLogging );
+            bool detailedLogging,
+            bool workersRanked = false );
     ~Client();
 
 private:
     virtual void OnDisconnected( const ConnectionInfo * connection );
     virtual void OnReceive( const ConnectionInfo * connection, void * data, uint32_t size, bool & keepMemory );
 
-    void Process( const ConnectionInfo * connection, const Protocol::MsgRequestJob * msg );
-    void Process( const ConnectionInfo * connection, const Protocol::MsgJobResult *, const void * payload, size_t payloadSize );
+    void Process( const ConnectionInfo * connection, const Protocol::MsgRequestJob * msg, const void * payload, size_t payloadSize );
+    void Process( const ConnectionInfo * connection, const Protocol::MsgJobResult *, void * payload, size_t payloadSize ); // takes ownership of payload
+    void Process( const ConnectionInfo * connection, const Protocol::MsgJobResultChunk * msg, void * payload, size_t payloadSize ); // takes ownership of payload
     void Process( const ConnectionInfo * connection, const Protocol::MsgRequestManifest * msg );
     void Process( const ConnectionInfo * connection, const Protocol::MsgRequestFile * msg );
 
+    void ProcessJobResult( const ConnectionInfo * connection, ConstMemoryStream & ms, int64_t receiveTime, void * & payload );
+    struct ServerState;
+    bool CheckUnshippedHeaders( ServerState * ss, const Job * job, const Array< AString > & headers, const Array< uint64_t > & contentHashes ) const;
+
     const ToolManifest * FindManifest( const ConnectionInfo * connection, uint64_t toolId ) const;
-    bool WriteFileToDisk( const AString& fileName, const MultiBuffer & multiBuffer, size_t index ) const;
+    static void FinishRemoteJob( Job * job, const AString & remoteName, int64_t receiveTime, uint32_t buildTimeMS, bool result );
+    static void TraceRemoteJob( Job * job, int64_t receiveTime, uint32_t buildTimeMS, const char * result );
 
     static uint32_t ThreadFuncStatic( void * param );
     void            ThreadFunc();
@@ -59,9 +69,46 @@ private:
     void            SendMessageInternal( const ConnectionInfo * connection, const Protocol::IMessage & msg );
     void            SendMessageInternal( const ConnectionInfo * connection, const Protocol::IMessage & msg, const MemoryStream & memoryStream );
 
+    // Output of a successful remote job, written to disk by the I/O threads
+    struct ResultChunk
+    {
+        void *          m_Memory;   // allocation to free once written
+        const void *    m_Data;
+        size_t          m_DataSize;
+    };
+    struct PendingResult
+    {
+        explicit PendingResult( Job * job, const AString & remoteName, int64_t receiveTime, uint32_t buildTime, uint32_t dataSize );
+        ~PendingResult();
+
+        Job *                   m_Job;
+        AString                 m_RemoteName;
+        int64_t                 m_ReceiveTime;
+        uint32_t                m_BuildTime;
+        uint32_t                m_DataSize;         // total size of output
+        uint32_t                m_DataReceived;     // output received so far (connection thread only)
+        MultiBufferFileWriter * m_Writer;           // (I/O thread only)
+        bool                    m_WriteStarted;     // (I/O thread only)
+
+        // protected by m_IOMutex
+        Array< ResultChunk >    m_Chunks;           // output waiting to be written, in order
+        bool                    m_Complete;         // no more output will arrive
+        bool                    m_Aborted;          // connection was lost before all output arrived
+        bool                    m_Queued;           // waiting for, or being processed by, an I/O thread
+    };
+
+    static uint32_t IOThreadFuncStatic( void * param );
+    void            IOThreadFunc();
+    void            QueueResultChunk( PendingResult * pr, void * memory, const void * data, size_t dataSize, bool isLast );
+    void            QueueResultAbort( PendingResult * pr );
+    void            ProcessPendingResult( PendingResult * pr );
+    void            StartWritingResult( PendingResult * pr ) const;
+    void            FinishPendingResult( PendingResult * pr ) const;
+
     Array< AString >    m_WorkerList;   // workers to connect to
     volatile bool       m_ShouldExit;   // signal from main thread
     bool                m_DetailedLogging;
+    bool                m_WorkersRanked; // workers are ordered by preference
     Thread::ThreadHandle m_Thread;      // the thread to find and manage workers
 
     // state
@@ -79,13 +126,25 @@ private:
         Timer                   m_DelayTimer;
         uint32_t                m_NumJobsAvailable;     // num jobs we've told this server we have available
         Array< Job * >          m_Jobs;                 // jobs we've sent to this server
+        Array< uint64_t >       m_HeaderHashes;         // headers (by content) sent to this server (sorted)
+        Array< uint64_t >       m_PCHKeys;              // precompiled headers (by content) sent to this server
+        Array< const ToolManifest * > m_PrewarmedManifests; // toolchains we've asked this server to synchronize ahead of time
+        Array< PendingResult * > m_StreamedResults;     // results whose output is still arriving
 
         bool                    m_Denylisted;
+        bool                    m_HeadersMismatched;    // warned that this server's system headers differ from ours
     };
     Mutex                   m_ServerListMutex;
     Array< ServerState >    m_ServerList;
     uint32_t                m_WorkerConnectionLimit;
     uint16_t                m_Port;
+
+    // I/O threads to write the output of remote jobs to disk
+    Array< Thread::ThreadHandle > m_IOThreads;
+    volatile bool           m_IOShouldExit;
+    Mutex                   m_IOMutex;
+    Semaphore               m_IOSemaphore;
+    Array< PendingResult * > m_IOQueue;
 };
 
 //------------------------------------------------------------------------------
@@ -8,6 +8,7 @@
 #include "Core/Env/Env.h"
 #include "Core/FileIO/ConstMemoryStream.h"
 #include "Core/FileIO/MemoryStream.h"
+#include "Core/Math/Conversions.h"
 #include "Core/Network/TCPConnectionPool.h"
 
 // system
@@ -35,7 +36,11 @@
             "Manifest",
             "RequestFile",
             "File",
-            "ServerStatus"
+            "BrokerHeartbeat",
+            "BrokerRequestWorkers",
+            "BrokerWorkerList",
+            "PrewarmToolchain",
+            "JobResultChunk"
         };
         static_assert( ( sizeof( msgNames ) / sizeof(const char *) ) == Protocol::NUM_MESSAGES, "msgNames item count doesn't match NUM_MESSAGES" );
 
@@ -125,7 +130,7 @@ Protocol::MsgStatus::MsgStatus( uint32_t numJobsAvailable )
 // MsgRequestJob
 //------------------------------------------------------------------------------
 Protocol::MsgRequestJob::MsgRequestJob()
-    : Protocol::IMessage( Protocol::MSG_REQUEST_JOB, sizeof( MsgRequestJob ), false )
+    : Protocol::IMessage( Protocol::MSG_REQUEST_JOB, sizeof( MsgRequestJob ), true )
 {
 }
 
@@ -153,6 +158,16 @@ Protocol::MsgJobResult::MsgJobResult()
 {
 }
 
+// MsgJobResultChunk
+//------------------------------------------------------------------------------
+Protocol::MsgJobResultChunk::MsgJobResultChunk( uint32_t jobId, bool isLast )
+    : Protocol::IMessage( Protocol::MSG_JOB_RESULT_CHUNK, sizeof( MsgJobResultChunk ), true )
+    , m_JobId( jobId )
+    , m_IsLast( isLast ? 1 : 0 )
+{
+    memset( m_Padding2, 0, sizeof( m_Padding2 ) );
+}
+
 // MsgRequestManifest
 //------------------------------------------------------------------------------
 Protocol::MsgRequestManifest::MsgRequestManifest( uint64_t toolId )
@@ -189,4 +204,45 @@ Protocol::MsgFile::MsgFile( uint64_t toolId, uint32_t fileId )
 {
 }
 
+// MsgBrokerHeartbeat
+//------------------------------------------------------------------------------
+Protocol::MsgBrokerHeartbeat::MsgBrokerHeartbeat( const char * hostName, uint32_t numCPUs, uint32_t numFreeSlots, uint32_t cpuScore )
+    : Protocol::IMessage( Protocol::MSG_BROKER_HEARTBEAT, sizeof( MsgBrokerHeartbeat ), true )
+    , m_ProtocolVersion( PROTOCOL_VERSION )
+    , m_NumCPUs( numCPUs )
+    , m_NumFreeSlots( numFreeSlots )
+    , m_CPUScore( cpuScore )
+    , m_Platform( Env::GetPlatform() )
+{
+    memset( m_Padding2, 0, sizeof( m_Padding2 ) );
+    memset( m_HostName, 0, sizeof( m_HostName ) );
+    AString::Copy( hostName, m_HostName, Math::Min( AString::StrLen( hostName ), sizeof( m_HostName ) - 1 ) );
+}
+
+// MsgBrokerRequestWorkers
+//------------------------------------------------------------------------------
+Protocol::MsgBrokerRequestWorkers::MsgBrokerRequestWorkers()
+    : Protocol::IMessage( Protocol::MSG_BROKER_REQUEST_WORKERS, sizeof( MsgBrokerRequestWorkers ), false )
+    , m_ProtocolVersion( PROTOCOL_VERSION )
+    , m_Platform( Env::GetPlatform() )
+{
+    memset( m_Padding2, 0, sizeof( m_Padding2 ) );
+}
+
+// MsgBrokerWorkerList
+//------------------------------------------------------------------------------
+Protocol::MsgBrokerWorkerList::MsgBrokerWorkerList()
+    : Protocol::IMessage( Protocol::MSG_BROKER_WORKER_LIST, sizeof( MsgBrokerWorkerList ), true )
+{
+}
+
+// MsgPrewarmToolchain
+//------------------------------------------------------------------------------
+Protocol::MsgPrewarmToolchain::MsgPrewarmToolchain( uint64_t toolId )
+    : Protocol::IMessage( Protocol::MSG_PREWARM_TOOLCHAIN, sizeof( MsgPrewarmToolchain ), false )
+    , m_ToolId( toolId )
+{
+    memset( m_Padding2, 0, sizeof( m_Padding2 ) );
+}
+
 //------------------------------------------------------------------------------
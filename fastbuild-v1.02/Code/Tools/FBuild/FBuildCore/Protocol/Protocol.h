@@ -29,9 +29,10 @@ class TCPConnectionPool;
 namespace Protocol
 {
     enum : uint16_t { PROTOCOL_PORT = 31264 }; // Arbitrarily chosen port
-    enum { PROTOCOL_VERSION = 21 };
+    enum { PROTOCOL_VERSION = 29 };
 
     enum { PROTOCOL_TEST_PORT = PROTOCOL_PORT + 1 }; // Different port for use by tests
+    enum : uint16_t { BROKER_PORT = PROTOCOL_PORT + 2 }; // Default port of the optional broker service
 
     // Identifiers for all unique messages
     //------------------------------------------------------------------------------
@@ -40,11 +41,11 @@ namespace Protocol
         MSG_CONNECTION          = 1, // Server <- Client : Initial handshake
         MSG_STATUS              = 2, // Server <- Client : Update status (work available)
 
-        MSG_REQUEST_JOB         = 3, // Server -> Client : Ask for a job to do
+        MSG_REQUEST_JOB         = 3, // Server -> Client : Ask for a job to do (with toolchains held)
         MSG_NO_JOB_AVAILABLE    = 4, // Server <- Client : Respond that no jobs are available
         MSG_JOB                 = 5, // Server <- Client : Respond with a job to do
 
-        MSG_JOB_RESULT          = 6, // Server -> Client : Return completed job
+        MSG_JOB_RESULT          = 6, // Server -> Client : Return completed job(s)
 
         MSG_REQUEST_MANIFEST    = 7, // Server -> Client : Ask client for the manifest of tools required for a job
         MSG_MANIFEST            = 8, // Server <- Client : Respond with manifest details
@@ -52,6 +53,14 @@ namespace Protocol
         MSG_REQUEST_FILE        = 9, // Server -> Client : Ask client for a file
         MSG_FILE                = 10,// Server <- Client : Send a requested file
 
+        MSG_BROKER_HEARTBEAT    = 11,// Broker <- Server : Worker availability, load and toolchains
+        MSG_BROKER_REQUEST_WORKERS = 12,// Broker <- Client : Ask for available workers
+        MSG_BROKER_WORKER_LIST  = 13,// Broker -> Client : Respond with ranked worker list
+
+        MSG_PREWARM_TOOLCHAIN   = 14,// Server <- Client : Start synchronizing a toolchain before it's needed
+
+        MSG_JOB_RESULT_CHUNK    = 15,// Server -> Client : Part of the output of a large completed job
+
         NUM_MESSAGES            // leave last
     };
 };
@@ -125,7 +134,7 @@ namespace Protocol
     class MsgRequestJob : public IMessage
     {
     public:
-        MsgRequestJob();
+        MsgRequestJob(); // payload is the ids of synchronized toolchains
     };
     static_assert( sizeof( MsgRequestJob ) == sizeof( IMessage ), "MsgRequestJob message has incorrect size" );
 
@@ -161,6 +170,22 @@ namespace Protocol
     };
     static_assert( sizeof( MsgJobResult ) == sizeof( IMessage ), "MsgJobResult message has incorrect size" );
 
+    // MsgJobResultChunk
+    //------------------------------------------------------------------------------
+    class MsgJobResultChunk : public IMessage
+    {
+    public:
+        MsgJobResultChunk( uint32_t jobId, bool isLast );
+
+        inline uint32_t GetJobId() const { return m_JobId; }
+        inline bool     IsLast() const { return ( m_IsLast != 0 ); }
+    private:
+        uint32_t m_JobId;
+        uint8_t  m_IsLast;
+        uint8_t  m_Padding2[ 3 ];
+    };
+    static_assert( sizeof( MsgJobResultChunk ) == sizeof( IMessage ) + 8, "MsgJobResultChunk message has incorrect size" );
+
     // MsgRequestManifest
     //------------------------------------------------------------------------------
     class MsgRequestManifest : public IMessage
@@ -219,6 +244,69 @@ namespace Protocol
     };
     static_assert( sizeof( MsgFile ) == sizeof( IMessage ) + 12, "MsgFile message has incorrect size" );
 
+    // MsgBrokerHeartbeat
+    //------------------------------------------------------------------------------
+    class MsgBrokerHeartbeat : public IMessage
+    {
+    public:
+        MsgBrokerHeartbeat( const char * hostName, uint32_t numCPUs, uint32_t numFreeSlots, uint32_t cpuScore );
+
+        inline uint32_t GetProtocolVersion() const { return m_ProtocolVersion; }
+        inline uint8_t  GetPlatform() const { return m_Platform; }
+        inline uint32_t GetNumCPUs() const { return m_NumCPUs; }
+        inline uint32_t GetNumFreeSlots() const { return m_NumFreeSlots; }
+        inline uint32_t GetCPUScore() const { return m_CPUScore; }
+        const char * GetHostName() const { return m_HostName; }
+    private:
+        uint32_t        m_ProtocolVersion;
+        uint32_t        m_NumCPUs;          // CPUs offered (0 = unavailable)
+        uint32_t        m_NumFreeSlots;     // CPUs offered but not busy
+        uint32_t        m_CPUScore;         // relative single core performance
+        uint8_t         m_Platform;
+        uint8_t         m_Padding2[3];
+        char            m_HostName[ 64 ];
+    };
+    static_assert( sizeof( MsgBrokerHeartbeat ) == sizeof( IMessage ) + 84, "MsgBrokerHeartbeat message has incorrect size" );
+
+    // MsgBrokerRequestWorkers
+    //------------------------------------------------------------------------------
+    class MsgBrokerRequestWorkers : public IMessage
+    {
+    public:
+        MsgBrokerRequestWorkers();
+
+        inline uint32_t GetProtocolVersion() const { return m_ProtocolVersion; }
+        inline uint8_t  GetPlatform() const { return m_Platform; }
+    private:
+        uint32_t        m_ProtocolVersion;
+        uint8_t         m_Platform;
+        uint8_t         m_Padding2[3];
+    };
+    static_assert( sizeof( MsgBrokerRequestWorkers ) == sizeof( IMessage ) + 8, "MsgBrokerRequestWorkers message has incorrect size" );
+
+    // MsgBrokerWorkerList
+    //------------------------------------------------------------------------------
+    class MsgBrokerWorkerList : public IMessage
+    {
+    public:
+        MsgBrokerWorkerList();
+    };
+    static_assert( sizeof( MsgBrokerWorkerList ) == sizeof( IMessage ), "MsgBrokerWorkerList message has incorrect size" );
+
+    // MsgPrewarmToolchain
+    //------------------------------------------------------------------------------
+    class MsgPrewarmToolchain : public IMessage
+    {
+    public:
+        explicit MsgPrewarmToolchain( uint64_t toolId );
+
+        inline uint64_t GetToolId() const { return m_ToolId; }
+    private:
+        char     m_Padding2[ 4 ];
+        uint64_t m_ToolId;
+    };
+    static_assert( sizeof( MsgPrewarmToolchain ) == sizeof( IMessage ) + 4/*alignment*/ + 8, "MsgPrewarmToolchain message has incorrect size" );
+
     // MsgServerStatus
     //------------------------------------------------------------------------------
     class MsgServerStatus : public IMessage
@@ -7,6 +7,7 @@
 #include "Protocol.h"
 
 #include "Tools/FBuild/FBuildCore/FLog.h"
+#include "Tools/FBuild/FBuildCore/Helpers/HeaderBundle.h"
 #include "Tools/FBuild/FBuildCore/Helpers/ToolManifest.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/Job.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/JobQueueRemote.h"
@@ -14,26 +15,40 @@
 
 #include "Core/Env/Env.h"
 #include "Core/FileIO/ConstMemoryStream.h"
+#include "Core/FileIO/FileIO.h"
 #include "Core/FileIO/MemoryStream.h"
+#include "Core/Math/Conversions.h"
 #include "Core/Process/Atomic.h"
 #include "Core/Profile/Profile.h"
 #include "Core/Strings/AStackString.h"
 
+#include <string.h> // for memcpy
+
 // Defines
 //------------------------------------------------------------------------------
 #if defined( __OSX__ ) || defined( __LINUX__ )
     // Touch files every 4 hours
     #define SERVER_TOOLCHAIN_TIMESTAMP_REFRESH_INTERVAL_SECS (60.0f * 60.0f * 4.0f)
 #endif
+#define SERVER_RESULT_BATCH_MAX_DATA_SIZE ( 64 * KILOBYTE )     // Results smaller than this are batched
+#define SERVER_RESULT_BATCH_FLUSH_SIZE ( 512 * KILOBYTE )       // Send batched results once they reach this size
+#define SERVER_RESULT_CHUNK_SIZE ( 1 * MEGABYTE )               // Results larger than this are streamed in chunks of this size
+#define SERVER_HEADER_STORE_BUDGET ( 1024 * MEGABYTE )          // Headers unused by connected clients are evicted beyond this size
 
 // CONSTRUCTOR
 //------------------------------------------------------------------------------
 Server::Server( uint32_t numThreadsInJobQueue )
     : m_ShouldExit( false )
     , m_ClientList( 32, true )
+    , m_ToolchainStoreEnabled( false )
+    , m_ToolchainStoreBudget( 0 )
 {
     m_JobQueueRemote = FNEW( JobQueueRemote( numThreadsInJobQueue ? numThreadsInJobQueue : Env::GetNumProcessors() ) );
 
+    AStackString<> headerStorePath;
+    HeaderStore::GetDefaultPath( headerStorePath );
+    m_HeaderStore = FNEW( HeaderStore( headerStorePath, SERVER_HEADER_STORE_BUDGET ) );
+
     m_Thread = Thread::CreateThread( ThreadFuncStatic,
                                      "Server",
                                      ( 64 * KILOBYTE ),
@@ -54,6 +69,7 @@ Server::~Server()
     Thread::CloseHandle( m_Thread );
 
     FDELETE m_JobQueueRemote;
+    FDELETE m_HeaderStore;
 
     const ToolManifest * const * end = m_Tools.End();
     for ( ToolManifest ** it = m_Tools.Begin(); it != end; ++it )
@@ -106,6 +122,67 @@ bool Server::IsSynchingTool( AString & statusStr ) const
     return false; // no toolchain is currently synching
 }
 
+// GetToolIds
+//------------------------------------------------------------------------------
+void Server::GetToolIds( Array< uint64_t > & outToolIds ) const
+{
+    MutexHolder manifestMH( m_ToolManifestsMutex );
+
+    outToolIds.SetCapacity( outToolIds.GetSize() + m_Tools.GetSize() );
+    for ( const ToolManifest * manifest : m_Tools )
+    {
+        if ( manifest->IsSynchronized() )
+        {
+            outToolIds.Append( manifest->GetToolId() );
+        }
+    }
+}
+
+// EnableToolchainStore
+//------------------------------------------------------------------------------
+void Server::EnableToolchainStore( uint64_t diskBudget )
+{
+    PROFILE_FUNCTION
+
+    MutexHolder manifestMH( m_ToolManifestsMutex );
+
+    ASSERT( m_ToolchainStoreEnabled == false );
+    m_ToolchainStoreEnabled = true;
+    m_ToolchainStoreBudget = diskBudget;
+
+    // Load toolchains stored by previous sessions
+    AStackString<> storePath;
+    ToolManifest::GetStorePath( storePath );
+    Array< AString > indexFiles( 32, true );
+    FileIO::GetFiles( storePath, AStackString<>( "toolchain.*.manifest" ), false, &indexFiles );
+    for ( const AString & indexFile : indexFiles )
+    {
+        ToolManifest * manifest = FNEW( ToolManifest );
+        const ToolManifest::StoreLoadResult result = manifest->LoadFromStore( indexFile );
+        if ( ( result == ToolManifest::STORE_LOADED ) && ( m_Tools.FindDeref( manifest->GetToolId() ) == nullptr ) )
+        {
+            m_Tools.Append( manifest );
+            continue;
+        }
+        FDELETE manifest;
+
+        // Start without toolchains which can't be read right now, but keep
+        // them for the next session
+        if ( result == ToolManifest::STORE_UNREADABLE )
+        {
+            FLOG_WARN( "Unable to read toolchain store index '%s'\n", indexFile.Get() );
+            continue;
+        }
+
+        // Forget stale indices. Any files left behind are still reused (after
+        // checking their hashes) if a client sends the toolchain again.
+        FLOG_WARN( "Ignoring toolchain store index '%s'\n", indexFile.Get() );
+        FileIO::FileDelete( indexFile.Get() );
+    }
+
+    EvictToolchains();
+}
+
 // OnConnected
 //------------------------------------------------------------------------------
 /*virtual*/ void Server::OnConnected( const ConnectionInfo * connection )
@@ -192,6 +269,9 @@ bool Server::IsSynchingTool( AString & statusStr ) const
         delete *it;
     }
 
+    // The client's headers can be evicted now it no longer expects us to have them
+    HeaderStore::Get().ReleaseContents( cs->m_HeaderHashes );
+
     FDELETE cs;
 }
 
@@ -269,6 +349,12 @@ bool Server::IsSynchingTool( AString & statusStr ) const
             Process( connection, msg, payload, payloadSize );
             break;
         }
+        case Protocol::MSG_PREWARM_TOOLCHAIN:
+        {
+            const Protocol::MsgPrewarmToolchain * msg = static_cast< const Protocol::MsgPrewarmToolchain * >( imsg );
+            Process( connection, msg );
+            break;
+        }
         default:
         {
             // unknown message type
@@ -355,6 +441,13 @@ void Server::Process( const ConnectionInfo * connection, const Protocol::MsgJob
     Job * job = FNEW( Job( ms ) );
     job->SetUserData( cs );
 
+    // Headers we don't have yet follow the job
+    if ( job->IsDataHeaderBundle() && ( HeaderStore::Get().LoadContents( ms, cs->m_HeaderHashes ) == false ) )
+    {
+        // The job will fail (as a system error) if it needs any of them
+        FLOG_WARN( "Failed to store headers for job '%s'", job->GetNode()->GetName().Get() );
+    }
+
     //
     const uint64_t toolId = msg->GetToolId();
     ASSERT( toolId );
@@ -366,6 +459,7 @@ void Server::Process( const ConnectionInfo * connection, const Protocol::MsgJob
     if ( manifest )
     {
         job->SetToolManifest( manifest );
+        manifest->MarkUsed();
         if ( manifest->IsSynchronized() )
         {
             // we have all the files - we can do the job
@@ -383,17 +477,45 @@ void Server::Process( const ConnectionInfo * connection, const Protocol::MsgJob
         // create manifest object
         manifest = FNEW( ToolManifest( toolId ) );
         job->SetToolManifest( manifest );
+        manifest->MarkUsed();
         m_Tools.Append( manifest );
 
         // request manifest of tool chain
-        Protocol::MsgRequestManifest reqMsg( toolId );
-        reqMsg.Send( connection );
+        RequestMissingFiles( connection, manifest );
     }
 
     // can't start job yet - put it on hold
     cs->m_WaitingJobs.Append( job );
 }
 
+// Process( MsgPrewarmToolchain )
+//------------------------------------------------------------------------------
+void Server::Process( const ConnectionInfo * connection, const Protocol::MsgPrewarmToolchain * msg )
+{
+    const uint64_t toolId = msg->GetToolId();
+    ASSERT( toolId );
+
+    ClientState * cs = (ClientState *)connection->GetUserData();
+    MutexHolder mh( cs->m_Mutex ); // serialize sends on this connection
+    MutexHolder manifestMH( m_ToolManifestsMutex ); // ensure we don't make redundant requests
+
+    // Start synchronizing the toolchain (if we're not already) so jobs
+    // which need it can start right away
+    ToolManifest ** found = m_Tools.FindDeref( toolId );
+    ToolManifest * manifest = found ? *found : nullptr;
+    if ( manifest == nullptr )
+    {
+        manifest = FNEW( ToolManifest( toolId ) );
+        m_Tools.Append( manifest );
+    }
+    else if ( manifest->IsSynchronized() )
+    {
+        return;
+    }
+
+    RequestMissingFiles( connection, manifest );
+}
+
 // Process( MsgManifest )
 //------------------------------------------------------------------------------
 void Server::Process( const ConnectionInfo * connection, const Protocol::MsgManifest * msg, const void * payload, size_t payloadSize )
@@ -410,6 +532,11 @@ void Server::Process( const ConnectionInfo * connection, const Protocol::MsgMani
         ASSERT( found );
         manifest = *found;
         manifest->DeserializeFromRemote( ms );
+        if ( manifest->IsSynchronized() )
+        {
+            manifest->SetUserData( nullptr ); // not synchronizing from this connection
+            StoreToolchain( manifest );
+        }
     }
 
     // manifest has checked local files, from previous sessions an may
@@ -420,6 +547,8 @@ void Server::Process( const ConnectionInfo * connection, const Protocol::MsgMani
         return;
     }
 
+    ClientState * cs = (ClientState *)connection->GetUserData();
+    MutexHolder mh( cs->m_Mutex ); // serialize sends on this connection
     RequestMissingFiles( connection, manifest );
 }
 
@@ -455,6 +584,7 @@ void Server::Process( const ConnectionInfo * connection, const Protocol::MsgFile
             return;
         }
         manifest->SetUserData( nullptr );
+        StoreToolchain( manifest );
     }
 
     // ToolChain is now synchronized
@@ -467,9 +597,7 @@ void Server::Process( const ConnectionInfo * connection, const Protocol::MsgFile
 void Server::CheckWaitingJobs( const ToolManifest * manifest )
 {
     // queue for start any jobs that may now be ready
-    #ifdef ASSERTS_ENABLED
-        bool atLeastOneJobStarted = false;
-    #endif
+    // (there may be none if the ToolChain was synchronized ahead of time)
 
     MutexHolder mhC( m_ClientListMutex );
     const ClientState * const * end = m_ClientList.End();
@@ -491,16 +619,9 @@ void Server::CheckWaitingJobs( const ToolManifest * manifest )
                 cs->m_WaitingJobs.EraseIndex( (size_t)i );
                 JobQueueRemote::Get().QueueJob( job );
                 PROTOCOL_DEBUG( "Server: Job %x can now be started\n", job );
-                #ifdef ASSERTS_ENABLED
-                    atLeastOneJobStarted = true;
-                #endif
             }
         }
     }
-
-    // We should only have called this function when a ToolChain sync was complete
-    // so at least 1 job should have been waiting for it
-    ASSERT( atLeastOneJobStarted );
 }
 
 
@@ -542,6 +663,12 @@ void Server::FindNeedyClients()
 
     PROFILE_FUNCTION
 
+    // tell clients which toolchains we have, so they can favor jobs using them
+    Array< uint64_t > toolIds( 0, true );
+    GetToolIds( toolIds );
+    MemoryStream toolIdsStream;
+    toolIdsStream.Write( toolIds );
+
     MutexHolder mh( m_ClientListMutex );
 
     // determine job availability
@@ -595,7 +722,7 @@ void Server::FindNeedyClients()
             }
 
             // request job from this client
-            msg.Send( cs->m_Connection );
+            msg.Send( cs->m_Connection, toolIdsStream );
             cs->m_NumJobsRequested++;
             availableJobs--;
             anyJobsRequested = true;
@@ -626,27 +753,11 @@ void Server::FinalizeCompletedJobs()
         bool connectionStillActive = ( m_ClientList.Find( cs ) != nullptr );
         if ( connectionStillActive )
         {
-            Node::State result = job->GetNode()->GetState();
-            ASSERT( ( result == Node::UP_TO_DATE ) || ( result == Node::FAILED ) );
-
-            MemoryStream ms;
-            ms.Write( job->GetJobId() );
-            ms.Write( job->GetNode()->GetName() );
-            ms.Write( result == Node::UP_TO_DATE );
-            ms.Write( job->GetSystemErrorCount() > 0 );
-            ms.Write( job->GetMessages() );
-            ms.Write( job->GetNode()->GetLastBuildTime() );
-
-            // write the data - build result for success, or output+errors for failure
-            ms.Write( (uint32_t)job->GetDataSize() );
-            ms.WriteBuffer( job->GetData(), job->GetDataSize() );
-
             MutexHolder mh2( cs->m_Mutex );
             ASSERT( cs->m_NumJobsActive );
             cs->m_NumJobsActive--;
 
-            Protocol::MsgJobResult msg;
-            msg.Send( cs->m_Connection, ms );
+            SendJobResult( cs, job );
         }
         else
         {
@@ -656,6 +767,113 @@ void Server::FinalizeCompletedJobs()
 
         FDELETE job;
     }
+
+    // send any small results we've been holding on to
+    MutexHolder mh( m_ClientListMutex );
+    for ( ClientState * cs : m_ClientList )
+    {
+        MutexHolder mh2( cs->m_Mutex );
+        SendBatchedJobResults( cs );
+    }
+}
+
+// SendJobResult
+//------------------------------------------------------------------------------
+/*static*/ void Server::SendJobResult( ClientState * cs, const Job * job )
+{
+    const size_t dataSize = job->GetDataSize();
+
+    // Small results are batched to avoid per-message overhead
+    if ( dataSize <= SERVER_RESULT_BATCH_MAX_DATA_SIZE )
+    {
+        if ( cs->m_NumBatchedResults == 0 )
+        {
+            cs->m_ResultBatch.Write( (uint32_t)0 ); // num results, updated when sent
+        }
+        SerializeJobResult( job, false, cs->m_ResultBatch );
+        cs->m_NumBatchedResults++;
+
+        if ( cs->m_ResultBatch.GetSize() >= SERVER_RESULT_BATCH_FLUSH_SIZE )
+        {
+            SendBatchedJobResults( cs );
+        }
+        return;
+    }
+
+    // Large results are sent on their own, and the largest are streamed
+    // so the client can write them to disk as they arrive
+    const bool streamed = ( dataSize > SERVER_RESULT_CHUNK_SIZE );
+
+    MemoryStream ms;
+    ms.Write( (uint32_t)1 ); // num results
+    SerializeJobResult( job, streamed, ms );
+
+    Protocol::MsgJobResult msg;
+    if ( ( msg.Send( cs->m_Connection, ms ) == false ) || ( streamed == false ) )
+    {
+        return;
+    }
+
+    const char * data = static_cast< const char * >( job->GetData() );
+    for ( size_t offset = 0; offset < dataSize; offset += SERVER_RESULT_CHUNK_SIZE )
+    {
+        const size_t chunkSize = Math::Min( (size_t)SERVER_RESULT_CHUNK_SIZE, dataSize - offset );
+        const bool isLast = ( ( offset + chunkSize ) == dataSize );
+
+        Protocol::MsgJobResultChunk chunkMsg( job->GetJobId(), isLast );
+        if ( chunkMsg.Send( cs->m_Connection, ConstMemoryStream( data + offset, chunkSize ) ) == false )
+        {
+            return; // connection lost
+        }
+    }
+}
+
+// SendBatchedJobResults
+//------------------------------------------------------------------------------
+/*static*/ void Server::SendBatchedJobResults( ClientState * cs )
+{
+    if ( cs->m_NumBatchedResults == 0 )
+    {
+        return;
+    }
+
+    // fill in the number of results
+    memcpy( cs->m_ResultBatch.GetDataMutable(), &cs->m_NumBatchedResults, sizeof( uint32_t ) );
+
+    Protocol::MsgJobResult msg;
+    msg.Send( cs->m_Connection, cs->m_ResultBatch );
+
+    cs->m_ResultBatch.Reset();
+    cs->m_NumBatchedResults = 0;
+}
+
+// SerializeJobResult
+//------------------------------------------------------------------------------
+/*static*/ void Server::SerializeJobResult( const Job * job, bool streamed, MemoryStream & ms )
+{
+    Node::State result = job->GetNode()->GetState();
+    ASSERT( ( result == Node::UP_TO_DATE ) || ( result == Node::FAILED ) );
+
+    ms.Write( job->GetJobId() );
+    ms.Write( job->GetNode()->GetName() );
+    ms.Write( result == Node::UP_TO_DATE );
+    ms.Write( job->GetSystemErrorCount() > 0 );
+    ms.Write( job->GetMessages() );
+    ms.Write( job->GetNode()->GetLastBuildTime() );
+    ms.Write( job->GetPeakMemoryBytes() ); // 0 if unknown (no cgroup memory.peak)
+    ms.Write( job->GetCPUTimeUS() );
+    ms.Write( job->GetDiskBytesWritten() );
+    ms.Write( job->GetUnshippedHeaders() ); // see ObjectNode::RecordUnshippedHeaders
+    ms.Write( job->GetUnshippedHeaderHashes() );
+
+    // write the data - build result for success, or output+errors for failure
+    // (streamed data follows in MsgJobResultChunk messages)
+    ms.Write( (uint32_t)job->GetDataSize() );
+    ms.Write( streamed );
+    if ( streamed == false )
+    {
+        ms.WriteBuffer( job->GetData(), job->GetDataSize() );
+    }
 }
 
 // TouchToolchains
@@ -679,12 +897,93 @@ void Server::TouchToolchains()
     #endif
 }
 
+// StoreToolchain
+//------------------------------------------------------------------------------
+void Server::StoreToolchain( ToolManifest * manifest )
+{
+    // NOTE: m_ToolManifestsMutex must be held
+
+    if ( m_ToolchainStoreEnabled == false )
+    {
+        return;
+    }
+
+    if ( manifest->SaveToStore() == false )
+    {
+        FLOG_WARN( "Failed to store toolchain 0x%" PRIx64 "\n", manifest->GetToolId() );
+    }
+
+    EvictToolchains();
+}
+
+// EvictToolchains
+//------------------------------------------------------------------------------
+void Server::EvictToolchains()
+{
+    // NOTE: m_ToolManifestsMutex must be held
+
+    for ( ;; )
+    {
+        // Find the least recently used toolchain which could be evicted,
+        // and how much space toolchains are using in total
+        uint64_t totalSize = 0;
+        ToolManifest ** oldest = nullptr;
+        ToolManifest ** newest = nullptr;
+        for ( ToolManifest ** it = m_Tools.Begin(); it != m_Tools.End(); ++it )
+        {
+            const ToolManifest * manifest = *it;
+            totalSize += manifest->GetTotalFileSize();
+            if ( ( newest == nullptr ) || ( manifest->GetLastUseTime() > ( *newest )->GetLastUseTime() ) )
+            {
+                newest = it;
+            }
+
+            // Only fully synchronized toolchains not in use by jobs can be evicted
+            if ( ( manifest->IsSynchronized() == false ) ||
+                 ( manifest->GetUserData() != nullptr ) ||
+                 ( manifest->GetNumJobRefs() > 0 ) )
+            {
+                continue;
+            }
+            if ( ( oldest == nullptr ) || ( manifest->GetLastUseTime() < ( *oldest )->GetLastUseTime() ) )
+            {
+                oldest = it;
+            }
+        }
+
+        // Always keep the most recently used toolchain, even if it alone is
+        // over budget, so it is not synchronized over and over
+        if ( ( totalSize <= m_ToolchainStoreBudget ) || ( oldest == nullptr ) || ( oldest == newest ) )
+        {
+            return;
+        }
+
+        ToolManifest * manifest = *oldest;
+        FLOG_VERBOSE( "Evicting toolchain 0x%" PRIx64 " (%" PRIu64 " MiB)\n", manifest->GetToolId(), ( manifest->GetTotalFileSize() / MEGABYTE ) );
+        m_Tools.Erase( oldest );
+        manifest->DeleteFromStore();
+        FDELETE manifest;
+    }
+}
+
 // RequestMissingFiles
 //------------------------------------------------------------------------------
 void Server::RequestMissingFiles( const ConnectionInfo * connection, ToolManifest * manifest ) const
 {
     MutexHolder manifestMH( m_ToolManifestsMutex );
 
+    // The files aren't known until we have the manifest
+    if ( manifest->GetFiles().IsEmpty() )
+    {
+        if ( manifest->GetUserData() == nullptr ) // not already requested
+        {
+            Protocol::MsgRequestManifest reqMsg( manifest->GetToolId() );
+            reqMsg.Send( connection );
+            manifest->SetUserData( (void *)connection );
+        }
+        return;
+    }
+
     const Array< ToolManifestFile > & files = manifest->GetFiles();
     const size_t numFiles = files.GetSize();
     for ( size_t i=0; i<numFiles; ++i )
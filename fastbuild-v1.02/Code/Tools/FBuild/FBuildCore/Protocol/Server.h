@@ -4,11 +4,13 @@
 
 // Includes
 //------------------------------------------------------------------------------
+#include "Core/FileIO/MemoryStream.h"
 #include "Core/Network/TCPConnectionPool.h"
 #include "Core/Time/Timer.h"
 
 // Forward Declarations
 //------------------------------------------------------------------------------
+class HeaderStore;
 class Job;
 class JobQueueRemote;
 namespace Protocol
@@ -18,6 +20,7 @@ namespace Protocol
     class MsgJob;
     class MsgManifest;
     class MsgNoJobAvailable;
+    class MsgPrewarmToolchain;
     class MsgStatus;
     class MsgFile;
 }
@@ -34,6 +37,10 @@ public:
     static void GetHostForJob( const Job * job, AString & hostName );
 
     bool IsSynchingTool( AString & statusStr ) const;
+    void GetToolIds( Array< uint64_t > & outToolIds ) const;
+
+    // Keep synchronized toolchains on disk between sessions (within a budget)
+    void EnableToolchainStore( uint64_t diskBudget );
 
 private:
     // TCPConnection interface
@@ -48,6 +55,7 @@ private:
     void Process( const ConnectionInfo * connection, const Protocol::MsgJob * msg, const void * payload, size_t payloadSize );
     void Process( const ConnectionInfo * connection, const Protocol::MsgManifest * msg, const void * payload, size_t payloadSize );
     void Process( const ConnectionInfo * connection, const Protocol::MsgFile * msg, const void * payload, size_t payloadSize );
+    void Process( const ConnectionInfo * connection, const Protocol::MsgPrewarmToolchain * msg );
 
     static uint32_t ThreadFuncStatic( void * param );
     void            ThreadFunc();
@@ -55,13 +63,15 @@ private:
     void            FindNeedyClients();
     void            FinalizeCompletedJobs();
     void            TouchToolchains();
+    void            StoreToolchain( ToolManifest * manifest );
+    void            EvictToolchains();
     void            CheckWaitingJobs( const ToolManifest * manifest );
 
     void            RequestMissingFiles( const ConnectionInfo * connection, ToolManifest * manifest ) const;
 
     struct ClientState
     {
-        explicit ClientState( const ConnectionInfo * ci ) : m_CurrentMessage( nullptr ), m_Connection( ci ), m_NumJobsAvailable( 0 ), m_NumJobsRequested( 0 ), m_NumJobsActive( 0 ), m_WaitingJobs( 16, true ) {}
+        explicit ClientState( const ConnectionInfo * ci ) : m_CurrentMessage( nullptr ), m_Connection( ci ), m_NumJobsAvailable( 0 ), m_NumJobsRequested( 0 ), m_NumJobsActive( 0 ), m_WaitingJobs( 16, true ), m_HeaderHashes( 0, true ), m_NumBatchedResults( 0 ) {}
 
         inline bool operator < ( const ClientState & other ) const { return ( m_NumJobsAvailable > other.m_NumJobsAvailable ); }
 
@@ -76,11 +86,20 @@ private:
         AString                 m_HostName;
 
         Array< Job * >          m_WaitingJobs; // jobs waiting for manifests/toolchains
+        Array< uint64_t >       m_HeaderHashes; // headers (by content) this client has sent (referenced in the HeaderStore)
+
+        MemoryStream            m_ResultBatch;  // small job results waiting to be sent together
+        uint32_t                m_NumBatchedResults;
 
         Timer                   m_StatusTimer;
     };
 
+    static void     SendJobResult( ClientState * cs, const Job * job );
+    static void     SendBatchedJobResults( ClientState * cs );
+    static void     SerializeJobResult( const Job * job, bool streamed, MemoryStream & ms );
+
     JobQueueRemote *        m_JobQueueRemote;
+    HeaderStore *           m_HeaderStore;  // headers sent by clients using header shipping
 
     volatile bool           m_ShouldExit;   // signal from main thread
     Thread::ThreadHandle    m_Thread;       // the thread to manage workload
@@ -89,6 +108,8 @@ private:
 
     mutable Mutex           m_ToolManifestsMutex;
     Array< ToolManifest * > m_Tools;
+    bool                    m_ToolchainStoreEnabled;
+    uint64_t                m_ToolchainStoreBudget;
     
     #if defined( __OSX__ ) || ( __LINUX__ )
         Timer                   m_TouchToolchainTimer;
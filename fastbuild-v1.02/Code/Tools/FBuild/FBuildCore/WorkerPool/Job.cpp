@@ -7,13 +7,17 @@
 
 #include "Tools/FBuild/FBuildCore/Graph/Node.h"
 #include "Tools/FBuild/FBuildCore/FLog.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildTrace.h"
+#include "Tools/FBuild/FBuildCore/Helpers/ToolManifest.h"
 
 #include "Core/Env/Assert.h"
 #include "Core/FileIO/FileIO.h"
 #include "Core/FileIO/IOStream.h"
+#include "Core/Math/Conversions.h"
 #include "Core/Process/Atomic.h"
 #include "Core/Profile/Profile.h"
 #include "Core/Strings/AStackString.h"
+#include "Core/Time/Timer.h"
 
 
 // Static
@@ -25,6 +29,7 @@ static uint32_t s_LastJobId( 0 );
 //------------------------------------------------------------------------------
 Job::Job( Node * node )
     : m_Node( node )
+    , m_QueueTime( Timer::GetNow() )
 {
     m_JobId = AtomicIncU32( &s_LastJobId );
 }
@@ -46,10 +51,28 @@ Job::~Job()
         OwnData( nullptr, 0, false );
     }
 
+    // Free trace track if job was abandoned while in flight remotely
+    BuildTrace::ReleaseRemoteTrack( m_RemoteTraceTrack );
+
     if ( m_IsLocal == false )
     {
         FDELETE m_Node;
     }
+
+    if ( m_ToolManifest )
+    {
+        m_ToolManifest->ReleaseJobRef();
+    }
+}
+
+// SetToolManifest
+//------------------------------------------------------------------------------
+void Job::SetToolManifest( ToolManifest * manifest )
+{
+    // Toolchains in use by jobs are kept (not evicted) on the worker
+    ASSERT( m_ToolManifest == nullptr );
+    manifest->AddJobRef();
+    m_ToolManifest = manifest;
 }
 
 // Cancel
@@ -145,6 +168,14 @@ void Job::SetMessages( const Array< AString > & messages )
     m_Messages = messages;
 }
 
+// AddResourceUsage
+//------------------------------------------------------------------------------
+void Job::AddResourceUsage( uint64_t peakMemoryBytes, uint64_t cpuTimeUS )
+{
+    m_PeakMemoryBytes = Math::Max( m_PeakMemoryBytes, peakMemoryBytes );
+    m_CPUTimeUS += cpuTimeUS;
+}
+
 // Serialize
 //------------------------------------------------------------------------------
 void Job::Serialize( IOStream & stream )
@@ -162,6 +193,7 @@ void Job::Serialize( IOStream & stream )
     Node::SaveRemote( stream, m_Node );
 
     stream.Write( IsDataCompressed() );
+    stream.Write( IsDataHeaderBundle() );
 
     stream.Write( m_DataSize );
     stream.Write( m_Data, m_DataSize );
@@ -181,6 +213,7 @@ void Job::Deserialize( IOStream & stream )
 
     bool compressed;
     stream.Read( compressed );
+    stream.Read( m_DataIsHeaderBundle );
 
     // read extra data
     uint32_t dataSize;
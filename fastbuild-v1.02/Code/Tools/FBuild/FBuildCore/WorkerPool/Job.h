@@ -45,10 +45,12 @@ public:
     inline void     SetUserData( void * data )  { m_UserData = data; }
     inline void *   GetUserData() const         { return m_UserData; }
 
-    inline void             SetToolManifest( ToolManifest * manifest )  { m_ToolManifest = manifest; }
+    void                    SetToolManifest( ToolManifest * manifest );
     inline ToolManifest *   GetToolManifest() const                     { return m_ToolManifest; }
 
     inline bool     IsDataCompressed() const { return m_DataIsCompressed; }
+    inline bool     IsDataHeaderBundle() const { return m_DataIsHeaderBundle; }
+    inline void     SetDataIsHeaderBundle( bool headerBundle ) { m_DataIsHeaderBundle = headerBundle; }
     inline bool     IsLocal() const     { return m_IsLocal; }
 
     inline const Array< AString > & GetMessages() const { return m_Messages; }
@@ -62,6 +64,9 @@ public:
     void OnSystemError() { ++m_SystemErrorCount; }
     inline uint8_t GetSystemErrorCount() const { return m_SystemErrorCount; }
 
+    // Forget the errors of a failed attempt on a worker, before trying again
+    inline void ClearErrors() { m_Messages.Clear(); m_SystemErrorCount = 0; }
+
     // serialization for remote distribution
     void Serialize( IOStream & stream );
     void Deserialize( IOStream & stream );
@@ -91,6 +96,37 @@ public:
     // Access total memory usage by job data
     static uint64_t             GetTotalLocalDataMemoryUsage();
 
+    // Track when (and on which trace track) a job was sent to a remote worker
+    inline void                 SetRemoteStart( int64_t time, uint32_t traceTrack ) { m_RemoteStartTime = time; m_RemoteTraceTrack = traceTrack; }
+    inline int64_t              GetRemoteStartTime() const                          { return m_RemoteStartTime; }
+    inline uint32_t             GetRemoteTraceTrack() const                         { return m_RemoteTraceTrack; }
+
+    // Track when a job was (re)queued to measure time spent waiting for a thread/worker
+    inline void                 SetQueueTime( int64_t time )                        { m_QueueTime = time; }
+    inline int64_t              GetQueueTime() const                                { return m_QueueTime; }
+
+    // Resources used by processes spawned for this job (peak is the largest single process)
+    void                        AddResourceUsage( uint64_t peakMemoryBytes, uint64_t cpuTimeUS );
+    inline void                 SetResourceUsage( uint64_t peakMemoryBytes, uint64_t cpuTimeUS ) { m_PeakMemoryBytes = peakMemoryBytes; m_CPUTimeUS = cpuTimeUS; }
+    inline uint64_t             GetPeakMemoryBytes() const                          { return m_PeakMemoryBytes; }
+    inline uint64_t             GetCPUTimeUS() const                                { return m_CPUTimeUS; }
+
+    // Memory reserved from the local memory budget while building (see JobMemoryBudget)
+    inline void                 SetMemoryReservation( uint64_t bytes )              { m_MemoryReservation = bytes; }
+    inline uint64_t             GetMemoryReservation() const                        { return m_MemoryReservation; }
+
+    // Temp file bytes which went to disk when building remotely (see MemoryStaging)
+    inline void                 AddDiskBytesWritten( uint64_t bytes )               { m_DiskBytesWritten += bytes; }
+    inline void                 SetDiskBytesWritten( uint64_t bytes )               { m_DiskBytesWritten = bytes; }
+    inline uint64_t             GetDiskBytesWritten() const                         { return m_DiskBytesWritten; }
+
+    // Headers from outside the include root a header bundle was compiled with
+    // (i.e. system headers), for the client to check against its own
+    inline Array< AString > &           GetUnshippedHeaders()                       { return m_UnshippedHeaders; }
+    inline const Array< AString > &     GetUnshippedHeaders() const                 { return m_UnshippedHeaders; }
+    inline Array< uint64_t > &          GetUnshippedHeaderHashes()                  { return m_UnshippedHeaderHashes; }
+    inline const Array< uint64_t > &    GetUnshippedHeaderHashes() const            { return m_UnshippedHeaderHashes; }
+
 private:
     uint32_t            m_JobId             = 0;
     uint32_t            m_DataSize          = 0;
@@ -99,9 +135,17 @@ private:
     void *              m_UserData          = nullptr;
     volatile bool       m_Abort             = false;
     bool                m_DataIsCompressed  = false;
+    bool                m_DataIsHeaderBundle = false; // HeaderBundle instead of preprocessed output
     bool                m_IsLocal           = true;
     uint8_t             m_SystemErrorCount  = 0; // On client, the total error count, on the worker a flag for the current attempt
     DistributionState   m_DistributionState = DIST_NONE;
+    uint32_t            m_RemoteTraceTrack  = 0xFFFFFFFF; // BuildTrace::INVALID_TRACK
+    int64_t             m_RemoteStartTime   = 0;
+    int64_t             m_QueueTime         = 0;
+    uint64_t            m_PeakMemoryBytes   = 0;
+    uint64_t            m_CPUTimeUS         = 0;
+    uint64_t            m_MemoryReservation = 0;
+    uint64_t            m_DiskBytesWritten  = 0;
     AString             m_RemoteName;
     AString             m_RemoteSourceRoot;
     AString             m_CacheName;
@@ -109,6 +153,8 @@ private:
     ToolManifest *      m_ToolManifest      = nullptr;
 
     Array< AString >    m_Messages;
+    Array< AString >    m_UnshippedHeaders;
+    Array< uint64_t >   m_UnshippedHeaderHashes;
 
     static int64_t s_TotalLocalDataMemoryUsage; // Total memory being managed by OwnData
 };
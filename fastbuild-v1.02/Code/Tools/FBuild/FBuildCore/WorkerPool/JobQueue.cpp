@@ -9,8 +9,12 @@
 
 #include "Tools/FBuild/FBuildCore/FBuild.h"
 #include "Tools/FBuild/FBuildCore/FLog.h"
+#include "Tools/FBuild/FBuildCore/Graph/CompilerNode.h"
 #include "Tools/FBuild/FBuildCore/Graph/Node.h"
 #include "Tools/FBuild/FBuildCore/Graph/ObjectNode.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildMetrics.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildTrace.h"
+#include "Tools/FBuild/FBuildCore/Helpers/MonitorStream.h"
 
 #include "Core/Time/Timer.h"
 #include "Core/FileIO/FileIO.h"
@@ -18,6 +22,82 @@
 #include "Core/Process/Thread.h"
 #include "Core/Profile/Profile.h"
 
+// Static Data
+//------------------------------------------------------------------------------
+static THREAD_LOCAL int64_t s_MemoryThrottledSince = 0; // When this worker thread started waiting for memory
+
+// JobMemoryBudget CONSTRUCTOR
+//------------------------------------------------------------------------------
+JobMemoryBudget::JobMemoryBudget()
+    : m_Budget( 0 )
+    , m_Reserved( 0 )
+{
+}
+
+// GetReserved
+//------------------------------------------------------------------------------
+uint64_t JobMemoryBudget::GetReserved() const
+{
+    MutexHolder mh( m_Mutex );
+    return m_Reserved;
+}
+
+// GetAvailable
+//------------------------------------------------------------------------------
+uint64_t JobMemoryBudget::GetAvailable() const
+{
+    if ( m_Budget == 0 )
+    {
+        return (uint64_t)-1; // Unlimited
+    }
+
+    MutexHolder mh( m_Mutex );
+    if ( m_Reserved == 0 )
+    {
+        return (uint64_t)-1; // Any job is admitted when nothing else is reserved
+    }
+    return ( m_Reserved < m_Budget ) ? ( m_Budget - m_Reserved ) : 0;
+}
+
+// TryReserve
+//------------------------------------------------------------------------------
+bool JobMemoryBudget::TryReserve( Job * job )
+{
+    ASSERT( job->GetMemoryReservation() == 0 );
+
+    const uint64_t estimate = job->GetNode()->GetLastPeakMemory();
+    if ( ( m_Budget == 0 ) || ( estimate == 0 ) )
+    {
+        return true; // Unlimited, or nothing known about the job
+    }
+
+    MutexHolder mh( m_Mutex );
+    if ( ( m_Reserved > 0 ) && ( ( m_Reserved + estimate ) > m_Budget ) )
+    {
+        return false;
+    }
+    m_Reserved += estimate;
+    job->SetMemoryReservation( estimate );
+    return true;
+}
+
+// Release
+//------------------------------------------------------------------------------
+bool JobMemoryBudget::Release( Job * job )
+{
+    const uint64_t reservation = job->GetMemoryReservation();
+    if ( reservation == 0 )
+    {
+        return false;
+    }
+
+    MutexHolder mh( m_Mutex );
+    ASSERT( m_Reserved >= reservation );
+    m_Reserved -= reservation;
+    job->SetMemoryReservation( 0 );
+    return true;
+}
+
 // JobCostSorter
 //------------------------------------------------------------------------------
 class JobCostSorter
@@ -34,6 +114,8 @@ public:
 JobSubQueue::JobSubQueue()
     : m_Count( 0 )
     , m_Jobs( 1024, true )
+    , m_MinPeakMemory( (uint64_t)-1 )
+    , m_NumUnknownPeakMemory( 0 )
 {
 }
 
@@ -75,6 +157,19 @@ void JobSubQueue::QueueJobs( Array< Node * > & nodes )
     m_Jobs.Append( jobs );
     AtomicAddU32( &m_Count, (int32_t)jobs.GetSize() );
 
+    for ( const Job * job : jobs )
+    {
+        const uint64_t peakMemory = job->GetNode()->GetLastPeakMemory();
+        if ( peakMemory == 0 )
+        {
+            ++m_NumUnknownPeakMemory;
+        }
+        else if ( peakMemory < m_MinPeakMemory )
+        {
+            m_MinPeakMemory = peakMemory;
+        }
+    }
+
     if ( wasEmpty )
     {
         return; // skip re-sorting
@@ -86,7 +181,7 @@ void JobSubQueue::QueueJobs( Array< Node * > & nodes )
 
 // RemoveJob
 //------------------------------------------------------------------------------
-Job * JobSubQueue::RemoveJob()
+Job * JobSubQueue::RemoveJob( JobMemoryBudget * budget, bool * outMemoryThrottled )
 {
     // lock-free early out if there are no jobs
     if ( AtomicLoadRelaxed( &m_Count ) == 0 )
@@ -103,10 +198,52 @@ Job * JobSubQueue::RemoveJob()
         return nullptr;
     }
 
+    // take the most expensive job which fits in the memory budget
+    const uint64_t available = budget ? budget->GetAvailable() : (uint64_t)-1;
+    bool found = false;
+    size_t index = m_Jobs.GetSize();
+    uint64_t peakMemory = 0;
+    if ( ( m_NumUnknownPeakMemory > 0 ) || ( available >= m_MinPeakMemory ) )
+    {
+        uint64_t minPeakMemory = (uint64_t)-1;
+        while ( index > 0 )
+        {
+            --index;
+            peakMemory = m_Jobs[ index ]->GetNode()->GetLastPeakMemory();
+            if ( peakMemory <= available )
+            {
+                // Only the chosen job is reserved (which fails if another
+                // thread reserved memory since GetAvailable)
+                found = ( ( budget == nullptr ) || budget->TryReserve( m_Jobs[ index ] ) );
+                break;
+            }
+            minPeakMemory = ( peakMemory < minPeakMemory ) ? peakMemory : minPeakMemory;
+        }
+        if ( ( found == false ) && ( index == 0 ) && ( peakMemory > available ) )
+        {
+            m_MinPeakMemory = minPeakMemory; // every job was checked, so this is exact
+        }
+    }
+    if ( found == false )
+    {
+        if ( outMemoryThrottled )
+        {
+            *outMemoryThrottled = true;
+        }
+        return nullptr;
+    }
+
     VERIFY( AtomicDecU32( &m_Count ) != static_cast< uint32_t >( -1 ) );
 
-    Job * job = m_Jobs.Top();
-    m_Jobs.Pop();
+    Job * job = m_Jobs[ index ];
+    m_Jobs.EraseIndex( index );
+    if ( peakMemory == 0 )
+    {
+        ASSERT( m_NumUnknownPeakMemory > 0 );
+        --m_NumUnknownPeakMemory;
+    }
+
+    BuildMetrics::RecordTicks( BuildMetrics::METRIC_QUEUE_WAIT, Timer::GetNow() - job->GetQueueTime() );
 
     return job;
 }
@@ -115,8 +252,8 @@ Job * JobSubQueue::RemoveJob()
 //------------------------------------------------------------------------------
 JobQueue::JobQueue( uint32_t numWorkerThreads ) :
     m_NumLocalJobsActive( 0 ),
-    m_DistributableJobs_Available( 1024, true ),
-    m_DistributableJobs_InProgress( 1024, true ),
+    m_DistributableJobs_Available( 1024 ),
+    m_DistributableJobs_InProgress( 1024 ),
     m_CompletedJobs( 1024, true ),
     m_CompletedJobsFailed( 1024, true ),
     m_CompletedJobs2( 1024, true ),
@@ -167,7 +304,7 @@ JobQueue::~JobQueue()
         const size_t numJobsAvailable = m_DistributableJobs_Available.GetSize();
         for ( size_t i=0; i<numJobsAvailable; ++i )
         {
-            FDELETE m_DistributableJobs_Available[ i ];
+            FDELETE m_DistributableJobs_Available.GetJob( i );
         }
         m_DistributableJobs_Available.Clear();
     }
@@ -263,12 +400,15 @@ void JobQueue::QueueDistributableJob( Job * job )
     ASSERT( job->GetNode()->GetState() == Node::BUILDING );
     ASSERT( job->GetDistributionState() == Job::DIST_NONE );
 
+    ReleaseMemory( job ); // 2nd pass may build elsewhere
+
     {
         MutexHolder m( m_DistributedJobsMutex );
 
-        m_DistributableJobs_Available.Append( job );
+        m_DistributableJobs_Available.Push( job, job->GetNode()->GetRecursiveCost() );
 
         job->SetDistributionState( Job::DIST_AVAILABLE );
+        job->SetQueueTime( Timer::GetNow() );
     }
 
     ASSERT( m_NumLocalJobsActive > 0 );
@@ -279,27 +419,119 @@ void JobQueue::QueueDistributableJob( Job * job )
 
 // GetDistributableJobToProcess
 //------------------------------------------------------------------------------
-Job * JobQueue::GetDistributableJobToProcess( bool remote )
+Job * JobQueue::GetDistributableJobToProcess( bool remote, const WorkerContents * preferredContents )
 {
     MutexHolder m( m_DistributedJobsMutex );
 
-    if ( m_DistributableJobs_Available.IsEmpty() )
+    // most expensive job first (in the order they are queued for equal cost)
+    Job * job = m_DistributableJobs_Available.Peek();
+    if ( job == nullptr )
     {
         return nullptr;
     }
 
-    // building jobs in the order they are queued
-    Job * job = m_DistributableJobs_Available[ 0 ];
-    m_DistributableJobs_Available.PopFront();
+    // workers prefer the most expensive job they already have the toolchain (and PCH) for,
+    // to avoid waiting for a synchronization
+    if ( preferredContents && ( preferredContents->m_ToolIds->IsEmpty() == false ) && ( IsHeldByWorker( job, preferredContents ) == false ) )
+    {
+        ASSERT( remote );
+        const size_t index = m_DistributableJobs_Available.FindHighestPriority( IsHeldByWorker, preferredContents );
+        if ( index != (size_t)-1 )
+        {
+            job = m_DistributableJobs_Available.Remove( index );
+            return OnDistributableJobTaken( job, remote );
+        }
+    }
+
+    // local builds must fit in the memory budget, so take the most expensive job
+    // which does (a job which doesn't fit mustn't hold up smaller ones behind it)
+    size_t index = 0; // top of the heap
+    if ( remote == false )
+    {
+        const uint64_t available = m_MemoryBudget.GetAvailable();
+        if ( FitsInMemory( job, &available ) == false )
+        {
+            index = m_DistributableJobs_Available.FindHighestPriority( FitsInMemory, &available );
+        }
+        const bool admitted = ( index != (size_t)-1 ) &&
+                              m_MemoryBudget.TryReserve( m_DistributableJobs_Available.GetJob( index ) );
+        OnMemoryThrottled( admitted == false );
+        if ( admitted == false )
+        {
+            return nullptr;
+        }
+    }
+    job = m_DistributableJobs_Available.Remove( index );
 
+    return OnDistributableJobTaken( job, remote );
+}
+
+// OnDistributableJobTaken
+//------------------------------------------------------------------------------
+Job * JobQueue::OnDistributableJobTaken( Job * job, bool remote )
+{
     ASSERT( job->GetDistributionState() == Job::DIST_AVAILABLE );
 
+    BuildMetrics::RecordTicks( BuildMetrics::METRIC_QUEUE_WAIT, Timer::GetNow() - job->GetQueueTime() );
+
     // Tag job as in-use
     job->SetDistributionState( remote ? Job::DIST_BUILDING_REMOTELY : Job::DIST_BUILDING_LOCALLY );
-    m_DistributableJobs_InProgress.Append( job );
+    m_DistributableJobs_InProgress.Add( job );
     return job;
 }
 
+// GetNextDistributableToolManifest
+//------------------------------------------------------------------------------
+const ToolManifest * JobQueue::GetNextDistributableToolManifest() const
+{
+    MutexHolder m( m_DistributedJobsMutex );
+
+    const Job * job = m_DistributableJobs_Available.Peek();
+    return job ? &GetToolManifest( job ) : nullptr;
+}
+
+// GetToolManifest
+//------------------------------------------------------------------------------
+/*static*/ const ToolManifest & JobQueue::GetToolManifest( const Job * job )
+{
+    return job->GetNode()->CastTo< ObjectNode >()->GetCompiler()->GetManifest();
+}
+
+// GetShippedPCHKey
+//------------------------------------------------------------------------------
+/*static*/ uint64_t JobQueue::GetShippedPCHKey( const Job * job )
+{
+    // A PCH is only sent to workers with the headers of its users
+    if ( job->IsDataHeaderBundle() == false )
+    {
+        return 0;
+    }
+    const ObjectNode * on = job->GetNode()->CastTo< ObjectNode >();
+    return on->IsUsingPCH() ? on->GetPrecompiledHeader()->GetPCHContentHash() : 0;
+}
+
+// IsHeldByWorker
+//------------------------------------------------------------------------------
+/*static*/ bool JobQueue::IsHeldByWorker( const Job * job, const void * workerContents )
+{
+    const WorkerContents * contents = static_cast< const WorkerContents * >( workerContents );
+    const uint64_t toolId = GetToolManifest( job ).GetToolId();
+    if ( contents->m_ToolIds->Find( toolId ) == nullptr )
+    {
+        return false;
+    }
+    const uint64_t pchKey = GetShippedPCHKey( job );
+    return ( ( pchKey == 0 ) || ( contents->m_PCHKeys->Find( pchKey ) != nullptr ) );
+}
+
+// FitsInMemory
+//------------------------------------------------------------------------------
+/*static*/ bool JobQueue::FitsInMemory( const Job * job, const void * availableMemory )
+{
+    // Jobs with no peak memory history are always admitted
+    return ( job->GetNode()->GetLastPeakMemory() <= *static_cast< const uint64_t * >( availableMemory ) );
+}
+
 // GetDistributableJobToRace
 //------------------------------------------------------------------------------
 Job * JobQueue::GetDistributableJobToRace()
@@ -312,21 +544,43 @@ Job * JobQueue::GetDistributableJobToRace()
 
     // take newest job, which is least likely to finish first
     // compared to older distributed jobs
-    const int32_t numJobs = (int32_t)m_DistributableJobs_InProgress.GetSize();
-    for ( int32_t i = ( numJobs - 1 ); i >= 0; --i )
+    Job * newestJob = nullptr;
+    uint32_t newestOrder = 0;
+    const size_t numJobs = m_DistributableJobs_InProgress.GetSize();
+    for ( size_t i = 0; i < numJobs; ++i )
     {
-        Job * job = m_DistributableJobs_InProgress[ (size_t)i ];
+        Job * job = m_DistributableJobs_InProgress.GetJob( i );
 
         // Don't Race jobs already building locally
         const Job::DistributionState distState = job->GetDistributionState();
-        if ( distState == Job::DIST_BUILDING_REMOTELY )
+        if ( distState != Job::DIST_BUILDING_REMOTELY )
         {
-            job->SetDistributionState( Job::DIST_RACING );
-            return job;
+            continue;
         }
+
+        const uint32_t order = m_DistributableJobs_InProgress.GetAddOrder( i );
+        if ( ( newestJob == nullptr ) || ( (int32_t)( order - newestOrder ) > 0 ) )
+        {
+            newestJob = job;
+            newestOrder = order;
+        }
+    }
+
+    if ( newestJob == nullptr )
+    {
+        return nullptr; // No job found to race (all were local or races already)
+    }
+
+    // racing must fit in the memory budget
+    const bool admitted = m_MemoryBudget.TryReserve( newestJob );
+    OnMemoryThrottled( admitted == false );
+    if ( admitted == false )
+    {
+        return nullptr;
     }
 
-    return nullptr; // No job found to race (all were local or races already)
+    newestJob->SetDistributionState( Job::DIST_RACING );
+    return newestJob;
 }
 
 // OnReturnRemoteJob
@@ -334,10 +588,9 @@ Job * JobQueue::GetDistributableJobToRace()
 Job * JobQueue::OnReturnRemoteJob( uint32_t jobId )
 {
     MutexHolder m( m_DistributedJobsMutex );
-    Job * * jobIt = m_DistributableJobs_InProgress.FindDeref( jobId );
-    if ( jobIt )
+    Job * job = m_DistributableJobs_InProgress.Find( jobId );
+    if ( job )
     {
-        Job * job = *jobIt;
 
         // What state is the job in?
         const Job::DistributionState distState = job->GetDistributionState();
@@ -352,7 +605,7 @@ Job * JobQueue::OnReturnRemoteJob( uint32_t jobId )
         // Did a local race complete this already?
         if ( distState == Job::DIST_RACE_WON_LOCALLY )
         {
-            m_DistributableJobs_InProgress.Erase( jobIt );
+            m_DistributableJobs_InProgress.Remove( job );
             FDELETE job;
             return nullptr;
         }
@@ -373,7 +626,7 @@ Job * JobQueue::OnReturnRemoteJob( uint32_t jobId )
                     Thread::Sleep( 1 );
                     m_DistributedJobsMutex.Lock();
 
-                    if ( !m_DistributableJobs_InProgress.FindDeref( jobId ) )
+                    if ( !m_DistributableJobs_InProgress.Find( jobId ) )
                     {
                         return nullptr; // Job disappeared - FinishedProcessingJob reaped it
                     }
@@ -413,8 +666,9 @@ void JobQueue::ReturnUnfinishedDistributableJob( Job * job )
             return;
         }
 
-        // Remove from in progress (keep order)
-        VERIFY( m_DistributableJobs_InProgress.FindAndErase( job ) );
+        // Remove from in progress
+        ASSERT( m_DistributableJobs_InProgress.Find( job->GetJobId() ) == job );
+        m_DistributableJobs_InProgress.Remove( job );
 
         // Did a local race complete?
         if ( job->GetDistributionState() == Job::DIST_RACE_WON_LOCALLY )
@@ -426,10 +680,11 @@ void JobQueue::ReturnUnfinishedDistributableJob( Job * job )
         else
         {
             // If not racing, only standard remote build is valid
-            if ( job->GetDistributionState() == Job::DIST_COMPLETED_REMOTELY )
+            if ( ( job->GetDistributionState() == Job::DIST_COMPLETED_REMOTELY ) ||
+                 ( job->GetDistributionState() == Job::DIST_RACE_WON_REMOTELY ) )
             {
-                // Can be "completed" due to error
-                ASSERT( job->GetSystemErrorCount() > 0 );
+                // Can be "completed" due to error, or if the connection was
+                // lost while the job's output was being streamed back
             }
             else
             {
@@ -437,8 +692,9 @@ void JobQueue::ReturnUnfinishedDistributableJob( Job * job )
             }
 
             // Put back in available queue
-            m_DistributableJobs_Available.Append( job );
+            m_DistributableJobs_Available.Push( job, job->GetNode()->GetRecursiveCost() );
             job->SetDistributionState( Job::DIST_AVAILABLE );
+            job->SetQueueTime( Timer::GetNow() );
         }
     }
 
@@ -446,6 +702,30 @@ void JobQueue::ReturnUnfinishedDistributableJob( Job * job )
     m_WorkerThreadSemaphore.Signal();
 }
 
+// ReturnRemoteJobForPreprocessing
+//------------------------------------------------------------------------------
+void JobQueue::ReturnRemoteJobForPreprocessing( Job * job )
+{
+    {
+        MutexHolder m( m_DistributedJobsMutex );
+
+        // We own the job (see OnReturnRemoteJob)
+        ASSERT( ( job->GetDistributionState() == Job::DIST_COMPLETED_REMOTELY ) ||
+                ( job->GetDistributionState() == Job::DIST_RACE_WON_REMOTELY ) );
+        ASSERT( m_DistributableJobs_InProgress.Find( job->GetJobId() ) == job );
+        m_DistributableJobs_InProgress.Remove( job );
+    }
+
+    // Build the node again from the start, so the data sent can be changed
+    Array< Node * > nodes( 1 );
+    nodes.Append( job->GetNode() );
+    FDELETE job;
+    m_LocalJobs_Available.QueueJobs( nodes );
+
+    // Signal local threads that new work is available
+    m_WorkerThreadSemaphore.Signal();
+}
+
 // FinalizeCompletedJobs (Main Thread)
 //------------------------------------------------------------------------------
 void JobQueue::FinalizeCompletedJobs( NodeGraph & nodeGraph )
@@ -562,29 +842,65 @@ void JobQueue::WorkerThreadWait( uint32_t maxWaitMS )
 //------------------------------------------------------------------------------
 Job * JobQueue::GetJobToProcess()
 {
-    Job * job = m_LocalJobs_Available.RemoveJob();
+    bool memoryThrottled = false;
+    Job * job = m_LocalJobs_Available.RemoveJob( &m_MemoryBudget, &memoryThrottled );
     if ( job )
     {
+        OnMemoryThrottled( false );
         AtomicIncU32( &m_NumLocalJobsActive );
         return job;
     }
 
+    if ( memoryThrottled )
+    {
+        OnMemoryThrottled( true );
+    }
     return nullptr;
 }
 
+// ReleaseMemory (Worker Thread)
+//------------------------------------------------------------------------------
+void JobQueue::ReleaseMemory( Job * job )
+{
+    if ( m_MemoryBudget.Release( job ) )
+    {
+        m_WorkerThreadSemaphore.Signal(); // Wake a thread waiting for memory
+    }
+}
+
+// OnMemoryThrottled (Worker Thread)
+//------------------------------------------------------------------------------
+/*static*/ void JobQueue::OnMemoryThrottled( bool throttled )
+{
+    // Record the time from first being refused a job, until getting one
+    if ( throttled )
+    {
+        if ( s_MemoryThrottledSince == 0 )
+        {
+            s_MemoryThrottledSince = Timer::GetNow();
+        }
+    }
+    else if ( s_MemoryThrottledSince != 0 )
+    {
+        BuildMetrics::RecordTicks( BuildMetrics::METRIC_MEMORY_WAIT, Timer::GetNow() - s_MemoryThrottledSince );
+        s_MemoryThrottledSince = 0;
+    }
+}
+
 // FinishedProcessingJob (Worker Thread)
 //------------------------------------------------------------------------------
 void JobQueue::FinishedProcessingJob( Job * job, bool success, bool wasARemoteJob )
 {
     ASSERT( job->GetNode()->GetState() == Node::BUILDING );
 
+    ReleaseMemory( job );
+
     if ( wasARemoteJob )
     {
         MutexHolder mh( m_DistributedJobsMutex );
 
         // Find the in-progress job
-        Job ** it = m_DistributableJobs_InProgress.Find( job );
-        ASSERT( it );
+        ASSERT( m_DistributableJobs_InProgress.Find( job->GetJobId() ) == job );
 
         // Handle the various states
         const Job::DistributionState distState = job->GetDistributionState();
@@ -605,7 +921,7 @@ void JobQueue::FinishedProcessingJob( Job * job, bool success, bool wasARemoteJo
             // Local Job finished while trying to cancel, so fail cancellation
             // Local thread now entirely owns Job, so set state as if race
             // never happened
-            m_DistributableJobs_InProgress.Erase( it );
+            m_DistributableJobs_InProgress.Remove( job );
             job->SetDistributionState( Job::DIST_COMPLETED_LOCALLY ); // Cancellation has failed
 
         }
@@ -613,12 +929,12 @@ void JobQueue::FinishedProcessingJob( Job * job, bool success, bool wasARemoteJo
                   ( distState == Job::DIST_RACE_WON_REMOTELY ) )
         {
             // Normal remote build
-            m_DistributableJobs_InProgress.Erase( it );
+            m_DistributableJobs_InProgress.Remove( job );
         }
         else if ( distState == Job::DIST_BUILDING_LOCALLY )
         {
             // Normal local build of a distributable job
-            m_DistributableJobs_InProgress.Erase( it );
+            m_DistributableJobs_InProgress.Remove( job );
             job->SetDistributionState( Job::DIST_COMPLETED_LOCALLY );
         }
         else
@@ -657,6 +973,7 @@ void JobQueue::FinishedProcessingJob( Job * job, bool success, bool wasARemoteJo
 /*static*/ Node::BuildResult JobQueue::DoBuild( Job * job )
 {
     Timer timer; // track how long the item takes
+    const int64_t startTime = BuildTrace::IsEnabled() ? Timer::GetNow() : 0;
 
     Node * node = job->GetNode();
 
@@ -674,6 +991,10 @@ void JobQueue::FinishedProcessingJob( Job * job, bool success, bool wasARemoteJo
     {
         nodeRelevantToMonitorLog = true;
         FLOG_MONITOR( "START_JOB local \"%s\" \n", nodeName.Get() );
+        if ( MonitorStream::IsEnabled() )
+        {
+            MonitorStream::JobStart( job, "local" );
+        }
     }
 
     // make sure the output path exists for files
@@ -715,6 +1036,10 @@ void JobQueue::FinishedProcessingJob( Job * job, bool success, bool wasARemoteJo
         // record new build time only if built (i.e. if cached or failed, the time
         // does not represent how long it takes to create this resource)
         node->SetLastBuildTime( timeTakenMS );
+        if ( job->GetPeakMemoryBytes() )
+        {
+            node->SetLastPeakMemory( job->GetPeakMemoryBytes() );
+        }
         node->SetStatFlag( Node::STATS_BUILT );
         FLOG_VERBOSE( "-Build: %u ms\t%s", timeTakenMS, node->GetName().Get() );
     }
@@ -751,15 +1076,21 @@ void JobQueue::FinishedProcessingJob( Job * job, bool success, bool wasARemoteJo
     // log processing time
     node->AddProcessingTime( timeTakenMS );
 
-    if ( nodeRelevantToMonitorLog && FLog::IsMonitorEnabled() )
+    if ( BuildTrace::IsEnabled() )
+    {
+        BuildTrace::Record( BuildTrace::PHASE_JOB, node, startTime, Timer::GetNow(), BuildTrace::GetResultName( result ) );
+    }
+
+    if ( nodeRelevantToMonitorLog && ( FLog::IsMonitorEnabled() || MonitorStream::IsEnabled() ) )
     {
         const char * resultString = nullptr;
+        MonitorStream::JobResult streamResult = MonitorStream::RESULT_FAILED;
         switch ( result )
         {
-            case Node::NODE_RESULT_OK:                      resultString = "SUCCESS_COMPLETE";      break;
-            case Node::NODE_RESULT_NEED_SECOND_BUILD_PASS:  resultString = "SUCCESS_PREPROCESSED";  break;
-            case Node::NODE_RESULT_OK_CACHE:                resultString = "SUCCESS_CACHED";        break;
-            case Node::NODE_RESULT_FAILED:                  resultString = "FAILED";                break;
+            case Node::NODE_RESULT_OK:                      resultString = "SUCCESS_COMPLETE";      streamResult = MonitorStream::RESULT_SUCCESS;               break;
+            case Node::NODE_RESULT_NEED_SECOND_BUILD_PASS:  resultString = "SUCCESS_PREPROCESSED";  streamResult = MonitorStream::RESULT_SUCCESS_PREPROCESSED;  break;
+            case Node::NODE_RESULT_OK_CACHE:                resultString = "SUCCESS_CACHED";        streamResult = MonitorStream::RESULT_SUCCESS_CACHED;        break;
+            case Node::NODE_RESULT_FAILED:                  resultString = "FAILED";                streamResult = MonitorStream::RESULT_FAILED;                break;
         }
 
         AStackString<> msgBuffer;
@@ -769,6 +1100,10 @@ void JobQueue::FinishedProcessingJob( Job * job, bool success, bool wasARemoteJo
                       resultString,
                       nodeName.Get(),
                       msgBuffer.Get() );
+        if ( MonitorStream::IsEnabled() )
+        {
+            MonitorStream::JobFinish( job, "local", streamResult, msgBuffer );
+        }
     }
 
     return result;
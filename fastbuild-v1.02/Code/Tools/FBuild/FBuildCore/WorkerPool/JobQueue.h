@@ -8,6 +8,7 @@
 #include "Core/Containers/Singleton.h"
 
 #include "Tools/FBuild/FBuildCore/Graph/Node.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/JobTables.h"
 #include "Core/Process/Semaphore.h"
 #include "Core/Process/Mutex.h"
 
@@ -15,8 +16,33 @@
 //------------------------------------------------------------------------------
 class Node;
 class Job;
+class ToolManifest;
 class WorkerThread;
 
+// JobMemoryBudget
+//------------------------------------------------------------------------------
+// Limits the combined peak memory (as recorded by previous builds) of the jobs
+// building locally. Jobs with no history are not limited, and a job is always
+// admitted when no other memory is reserved so it can't stall the build.
+//------------------------------------------------------------------------------
+class JobMemoryBudget
+{
+public:
+    JobMemoryBudget();
+
+    inline void     SetBudget( uint64_t bytes ) { m_Budget = bytes; } // 0 = unlimited
+    inline uint64_t GetBudget() const           { return m_Budget; }
+    uint64_t        GetReserved() const;
+    uint64_t        GetAvailable() const; // largest job which would be admitted now
+
+    bool            TryReserve( Job * job );
+    bool            Release( Job * job ); // returns true if memory was released
+
+private:
+    mutable Mutex   m_Mutex;
+    uint64_t        m_Budget;
+    uint64_t        m_Reserved;
+};
 
 // JobSubQueue
 //------------------------------------------------------------------------------
@@ -31,12 +57,17 @@ public:
     // jobs pushed by the main thread
     void QueueJobs( Array< Node * > & nodes );
 
-    // jobs consumed by workers
-    Job * RemoveJob();
+    // jobs consumed by workers (most expensive job which fits the budget)
+    Job * RemoveJob( JobMemoryBudget * budget = nullptr, bool * outMemoryThrottled = nullptr );
 private:
     uint32_t    m_Count;    // access the current count
     Mutex       m_Mutex;    // lock to add/remove jobs
     Array< Job * > m_Jobs;  // Sorted, most expensive at end
+
+    // Peak memory of queued jobs, so a throttled worker can give up without
+    // scanning the queue (protected by m_Mutex)
+    uint64_t    m_MinPeakMemory;        // lower bound (exact after a failed scan)
+    uint32_t    m_NumUnknownPeakMemory; // jobs with no history (always admitted)
 };
 
 // JobQueue
@@ -66,6 +97,9 @@ public:
     void GetJobStats( uint32_t & numJobs, uint32_t & numJobsActive,
                       uint32_t & numJobsDist, uint32_t & numJobsDistActive ) const;
 
+    // memory admission for local jobs
+    inline JobMemoryBudget & GetMemoryBudget() { return m_MemoryBudget; }
+
 private:
     // worker threads call these
     friend class WorkerThread;
@@ -76,12 +110,26 @@ private:
     void        FinishedProcessingJob( Job * job, bool result, bool wasARemoteJob );
 
     void        QueueDistributableJob( Job * job );
+    void        ReleaseMemory( Job * job );
+    Job *       OnDistributableJobTaken( Job * job, bool remote );
+    static void OnMemoryThrottled( bool throttled );
+    static const ToolManifest & GetToolManifest( const Job * job );
+    static uint64_t GetShippedPCHKey( const Job * job );
+    static bool IsHeldByWorker( const Job * job, const void * workerContents );
+    static bool FitsInMemory( const Job * job, const void * availableMemory );
 
     // client side of protocol consumes jobs via this interface
     friend class Client;
-    Job *       GetDistributableJobToProcess( bool remote );
+    struct WorkerContents
+    {
+        const Array< uint64_t > *   m_ToolIds;  // toolchains the worker has synchronized
+        const Array< uint64_t > *   m_PCHKeys;  // precompiled headers the worker has been sent
+    };
+    Job *       GetDistributableJobToProcess( bool remote, const WorkerContents * preferredContents = nullptr );
+    const ToolManifest * GetNextDistributableToolManifest() const;
     Job *       OnReturnRemoteJob( uint32_t jobId );
     void        ReturnUnfinishedDistributableJob( Job * job );
+    void        ReturnRemoteJobForPreprocessing( Job * job );
 
     // Semaphore to manage work
     Semaphore           m_WorkerThreadSemaphore;
@@ -92,11 +140,12 @@ private:
 
     // Jobs in progress locally
     uint32_t            m_NumLocalJobsActive;
+    JobMemoryBudget     m_MemoryBudget;
 
     // Jobs available for distributed processing (can also be done locally)
     mutable Mutex       m_DistributedJobsMutex;
-    Array< Job * >      m_DistributableJobs_Available;  // Available, not in progress anywhere
-    Array< Job * >      m_DistributableJobs_InProgress; // In progress remotely, locally or both
+    JobCostHeap         m_DistributableJobs_Available;  // Available, not in progress anywhere
+    JobIdTable          m_DistributableJobs_InProgress; // In progress remotely, locally or both
 
     // Semaphore to manage thread idle
     Semaphore           m_MainThreadSemaphore;
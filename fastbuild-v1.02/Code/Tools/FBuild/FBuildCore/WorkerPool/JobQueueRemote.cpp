@@ -11,7 +11,10 @@
 #include "Tools/FBuild/FBuildCore/FLog.h"
 #include "Tools/FBuild/FBuildCore/Graph/Node.h"
 #include "Tools/FBuild/FBuildCore/Graph/ObjectNode.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildTrace.h"
+#include "Tools/FBuild/FBuildCore/Helpers/MonitorStream.h"
 #include "Tools/FBuild/FBuildCore/Helpers/MultiBuffer.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/MemoryStaging.h"
 
 // Core
 #include "Core/Env/ErrorFormat.h"
@@ -94,6 +97,14 @@ void JobQueueRemote::GetWorkerStatus( size_t index, AString & hostName, AString
     ( (WorkerThreadRemote *)m_Workers[ index ] )->GetStatus( hostName, status, isIdle );
 }
 
+// GetNumInFlightJobs
+//------------------------------------------------------------------------------
+size_t JobQueueRemote::GetNumInFlightJobs() const
+{
+    MutexHolder mh( m_InFlightJobsMutex );
+    return m_InFlightJobs.GetSize();
+}
+
 // MainThreadWait
 //------------------------------------------------------------------------------
 void JobQueueRemote::MainThreadWait( uint32_t timeoutMS )
@@ -276,48 +287,76 @@ void JobQueueRemote::FinishedProcessingJob( Job * job, bool success )
 /*static*/ Node::BuildResult JobQueueRemote::DoBuild( Job * job, bool racingRemoteJob )
 {
     Timer timer; // track how long the item takes
+    const int64_t startTime = ( BuildTrace::IsEnabled() && job->IsLocal() ) ? Timer::GetNow() : 0;
 
     ObjectNode * node = job->GetNode()->CastTo< ObjectNode >();
 
     if ( job->IsLocal() )
     {
         FLOG_MONITOR( "START_JOB local \"%s\" \n", job->GetNode()->GetName().Get() );
+        if ( MonitorStream::IsEnabled() )
+        {
+            MonitorStream::JobStart( job, "local" );
+        }
     }
 
-    // remote tasks must output to a tmp file
-    if ( job->IsLocal() == false )
+    // remote tasks must output to a tmp file, in memory if it fits
+    MemoryStagingScope memoryStaging( job );
+    Node::BuildResult result;
+    for ( ;; )
     {
-        // file name should be the same as on host
-        const char * fileName = ( job->GetRemoteName().FindLast( NATIVE_SLASH ) + 1 );
+        if ( job->IsLocal() == false )
+        {
+            // file name should be the same as on host
+            const char * fileName = ( job->GetRemoteName().FindLast( NATIVE_SLASH ) + 1 );
 
-        AStackString<> tmpFileName;
-        WorkerThread::CreateTempFilePath( fileName, tmpFileName );
-        node->ReplaceDummyName( tmpFileName );
+            AStackString<> tmpFileName;
+            WorkerThread::CreateTempFilePath( fileName, tmpFileName );
+            node->ReplaceDummyName( tmpFileName );
 
-        //DEBUGSPAM( "REMOTE: %s (%s)\n", fileName, job->GetRemoteName().Get() );
-    }
+            //DEBUGSPAM( "REMOTE: %s (%s)\n", fileName, job->GetRemoteName().Get() );
+        }
 
-    ASSERT( node->IsAFile() );
+        ASSERT( node->IsAFile() );
 
-    // make sure the output path exists
-    if ( Node::EnsurePathExistsForFile( node->GetName() ) == false )
-    {
-        // error already output by EnsurePathExistsForFile
-        return Node::NODE_RESULT_FAILED;
-    }
+        // make sure the output path exists
+        const bool pathExists = Node::EnsurePathExistsForFile( node->GetName() );
+        if ( pathExists )
+        {
+            // Delete any left over PDB from a previous run (to be sure we have a clean pdb)
+            if ( node->IsUsingPDB() && ( job->IsLocal() == false ) )
+            {
+                AStackString<> pdbName;
+                node->GetPDBName( pdbName );
+                FileIO::FileDelete( pdbName.Get() );
+            }
 
-    // Delete any left over PDB from a previous run (to be sure we have a clean pdb)
-    if ( node->IsUsingPDB() && ( job->IsLocal() == false ) )
-    {
-        AStackString<> pdbName;
-        node->GetPDBName( pdbName );
-        FileIO::FileDelete( pdbName.Get() );
-    }
+            PROFILE_SECTION( racingRemoteJob ? "RACE" : "LOCAL" );
+            result = ((Node *)node )->DoBuild2( job, racingRemoteJob );
+        }
+        else
+        {
+            result = Node::NODE_RESULT_FAILED;
+        }
 
-    Node::BuildResult result;
-    {
-        PROFILE_SECTION( racingRemoteJob ? "RACE" : "LOCAL" );
-        result = ((Node *)node )->DoBuild2( job, racingRemoteJob );
+        // If writing temp files in memory failed, or the tmpfs filled up (it
+        // can be shared), try again on disk
+        if ( ( result == Node::NODE_RESULT_FAILED ) &&
+             memoryStaging.IsInMemory() &&
+             ( ( pathExists == false ) || ( job->GetSystemErrorCount() > 0 ) || MemoryStaging::Get().IsFull() ) )
+        {
+            FLOG_VERBOSE( "Retrying '%s' with temp files on disk\n", job->GetRemoteName().Get() );
+            memoryStaging.FallBackToDisk();
+            job->ClearErrors();
+            continue;
+        }
+
+        if ( pathExists == false )
+        {
+            // error already output by EnsurePathExistsForFile
+            return Node::NODE_RESULT_FAILED;
+        }
+        break;
     }
 
     // Ignore result if job was cancelled
@@ -343,6 +382,10 @@ void JobQueueRemote::FinishedProcessingJob( Job * job, bool success )
         // record new build time only if built (i.e. if failed, the time
         // does not represent how long it takes to create this resource)
         node->SetLastBuildTime( timeTakenMS );
+        if ( job->GetPeakMemoryBytes() )
+        {
+            node->SetLastPeakMemory( job->GetPeakMemoryBytes() );
+        }
         node->SetStatFlag( Node::STATS_BUILT );
 
         #ifdef DEBUG
@@ -383,7 +426,12 @@ void JobQueueRemote::FinishedProcessingJob( Job * job, bool success )
     // log processing time
     node->AddProcessingTime( timeTakenMS );
 
-    if ( job->IsLocal() && FLog::IsMonitorEnabled() )
+    if ( startTime != 0 )
+    {
+        BuildTrace::Record( BuildTrace::PHASE_JOB, node, startTime, Timer::GetNow(), BuildTrace::GetResultName( result ) );
+    }
+
+    if ( job->IsLocal() && ( FLog::IsMonitorEnabled() || MonitorStream::IsEnabled() ) )
     {
         AStackString<> msgBuffer;
         job->GetMessagesForMonitorLog( msgBuffer );
@@ -392,6 +440,10 @@ void JobQueueRemote::FinishedProcessingJob( Job * job, bool success )
                       ( result == Node::NODE_RESULT_FAILED ) ? "ERROR" : "SUCCESS",
                       job->GetNode()->GetName().Get(),
                       msgBuffer.Get());
+        if ( MonitorStream::IsEnabled() )
+        {
+            MonitorStream::JobFinish( job, "local", ( result == Node::NODE_RESULT_FAILED ) ? MonitorStream::RESULT_FAILED : MonitorStream::RESULT_SUCCESS, msgBuffer );
+        }
     }
 
     return result;
@@ -438,6 +490,19 @@ void JobQueueRemote::FinishedProcessingJob( Job * job, bool success )
         FLOG_ERROR( "Error reading file: '%s'", fileNames[ problemFileIndex ].Get() );
     }
 
+    // Account for outputs the compiler wrote to disk
+    if ( MemoryStaging::IsThreadStagingInMemory() == false )
+    {
+        for ( const AString & fileName : fileNames )
+        {
+            FileIO::FileInfo info;
+            if ( FileIO::GetFileInfo( fileName, info ) )
+            {
+                job->AddDiskBytesWritten( info.m_Size );
+            }
+        }
+    }
+
     // transfer data to job
     size_t memSize;
     void * mem = mb.Release( memSize );
@@ -0,0 +1,291 @@
+// JobTables - containers for tracking distributable jobs
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "JobTables.h"
+
+#include "Tools/FBuild/FBuildCore/WorkerPool/Job.h"
+
+#include "Core/Env/Assert.h"
+
+// JobCostHeap CONSTRUCTOR
+//------------------------------------------------------------------------------
+JobCostHeap::JobCostHeap( size_t initialCapacity )
+    : m_Entries( initialCapacity, true )
+    , m_NextOrder( 0 )
+{
+}
+
+// Push
+//------------------------------------------------------------------------------
+void JobCostHeap::Push( Job * job, uint32_t cost )
+{
+    Entry entry;
+    entry.m_Job = job;
+    entry.m_Cost = cost;
+    entry.m_Order = m_NextOrder++;
+    m_Entries.Append( entry );
+    SiftUp( m_Entries.GetSize() - 1 );
+}
+
+// Pop
+//------------------------------------------------------------------------------
+Job * JobCostHeap::Pop()
+{
+    if ( m_Entries.IsEmpty() )
+    {
+        return nullptr;
+    }
+
+    Job * job = m_Entries[ 0 ].m_Job;
+
+    // Move last item to the root and restore heap order
+    m_Entries[ 0 ] = m_Entries.Top();
+    m_Entries.Pop();
+    if ( m_Entries.IsEmpty() == false )
+    {
+        SiftDown( 0 );
+    }
+
+    return job;
+}
+
+// FindHighestPriority
+//------------------------------------------------------------------------------
+size_t JobCostHeap::FindHighestPriority( JobFilter filter, const void * userData ) const
+{
+    size_t best = (size_t)-1;
+    const size_t size = m_Entries.GetSize();
+    for ( size_t i = 0; i < size; ++i )
+    {
+        if ( ( best != (size_t)-1 ) && ( IsHigherPriority( m_Entries[ i ], m_Entries[ best ] ) == false ) )
+        {
+            continue; // can't be better than what we have
+        }
+        if ( filter( m_Entries[ i ].m_Job, userData ) )
+        {
+            best = i;
+        }
+    }
+    return best;
+}
+
+// Remove
+//------------------------------------------------------------------------------
+Job * JobCostHeap::Remove( size_t index )
+{
+    Job * job = m_Entries[ index ].m_Job;
+
+    // Move last item into the gap and restore heap order
+    const size_t last = ( m_Entries.GetSize() - 1 );
+    if ( index != last )
+    {
+        m_Entries[ index ] = m_Entries[ last ];
+        m_Entries.Pop();
+        if ( ( index > 0 ) && IsHigherPriority( m_Entries[ index ], m_Entries[ ( index - 1 ) / 2 ] ) )
+        {
+            SiftUp( index );
+        }
+        else
+        {
+            SiftDown( index );
+        }
+    }
+    else
+    {
+        m_Entries.Pop();
+    }
+
+    return job;
+}
+
+// IsHigherPriority
+//------------------------------------------------------------------------------
+/*static*/ inline bool JobCostHeap::IsHigherPriority( const Entry & a, const Entry & b )
+{
+    if ( a.m_Cost != b.m_Cost )
+    {
+        return ( a.m_Cost > b.m_Cost );
+    }
+    // NOTE: Order can wrap, so compare the difference
+    return ( (int32_t)( a.m_Order - b.m_Order ) < 0 );
+}
+
+// SiftUp
+//------------------------------------------------------------------------------
+void JobCostHeap::SiftUp( size_t index )
+{
+    const Entry entry = m_Entries[ index ];
+    while ( index > 0 )
+    {
+        const size_t parent = ( ( index - 1 ) / 2 );
+        if ( IsHigherPriority( entry, m_Entries[ parent ] ) == false )
+        {
+            break;
+        }
+        m_Entries[ index ] = m_Entries[ parent ];
+        index = parent;
+    }
+    m_Entries[ index ] = entry;
+}
+
+// SiftDown
+//------------------------------------------------------------------------------
+void JobCostHeap::SiftDown( size_t index )
+{
+    const size_t size = m_Entries.GetSize();
+    const Entry entry = m_Entries[ index ];
+    for ( ;; )
+    {
+        size_t child = ( ( index * 2 ) + 1 );
+        if ( child >= size )
+        {
+            break;
+        }
+        if ( ( ( child + 1 ) < size ) && IsHigherPriority( m_Entries[ child + 1 ], m_Entries[ child ] ) )
+        {
+            ++child;
+        }
+        if ( IsHigherPriority( m_Entries[ child ], entry ) == false )
+        {
+            break;
+        }
+        m_Entries[ index ] = m_Entries[ child ];
+        index = child;
+    }
+    m_Entries[ index ] = entry;
+}
+
+// JobIdTable CONSTRUCTOR
+//------------------------------------------------------------------------------
+JobIdTable::JobIdTable( size_t initialCapacity )
+    : m_Entries( initialCapacity, true )
+    , m_Buckets( 0, true )
+    , m_Mask( 0 )
+    , m_NextOrder( 0 )
+{
+    // Keep load factor <= 50%
+    uint32_t numBuckets = 16;
+    while ( numBuckets < ( initialCapacity * 2 ) )
+    {
+        numBuckets *= 2;
+    }
+    Rehash( numBuckets );
+}
+
+// Add
+//------------------------------------------------------------------------------
+void JobIdTable::Add( Job * job )
+{
+    ASSERT( Find( job->GetJobId() ) == nullptr ); // JobIds must be unique
+
+    if ( ( ( m_Entries.GetSize() + 1 ) * 2 ) > m_Buckets.GetSize() )
+    {
+        Rehash( (uint32_t)m_Buckets.GetSize() * 2 );
+    }
+
+    Entry entry;
+    entry.m_Job = job;
+    entry.m_JobId = job->GetJobId();
+    entry.m_Order = m_NextOrder++;
+    m_Entries.Append( entry );
+
+    uint32_t bucket = ( Hash( entry.m_JobId ) & m_Mask );
+    while ( m_Buckets[ bucket ] != 0 )
+    {
+        bucket = ( ( bucket + 1 ) & m_Mask );
+    }
+    m_Buckets[ bucket ] = (uint32_t)m_Entries.GetSize();
+}
+
+// Find
+//------------------------------------------------------------------------------
+Job * JobIdTable::Find( uint32_t jobId ) const
+{
+    const uint32_t bucket = FindBucket( jobId );
+    return ( bucket == (uint32_t)-1 ) ? nullptr : m_Entries[ m_Buckets[ bucket ] - 1 ].m_Job;
+}
+
+// Remove
+//------------------------------------------------------------------------------
+void JobIdTable::Remove( Job * job )
+{
+    uint32_t hole = FindBucket( job->GetJobId() );
+    ASSERT( hole != (uint32_t)-1 );
+    const uint32_t entryIndex = ( m_Buckets[ hole ] - 1 );
+    ASSERT( m_Entries[ entryIndex ].m_Job == job );
+
+    // Remove from buckets, shifting back any following items in the same
+    // probe sequence so lookups don't stop early
+    uint32_t bucket = ( ( hole + 1 ) & m_Mask );
+    while ( m_Buckets[ bucket ] != 0 )
+    {
+        const uint32_t ideal = ( Hash( m_Entries[ m_Buckets[ bucket ] - 1 ].m_JobId ) & m_Mask );
+        if ( ( ( bucket - ideal ) & m_Mask ) >= ( ( bucket - hole ) & m_Mask ) )
+        {
+            m_Buckets[ hole ] = m_Buckets[ bucket ];
+            hole = bucket;
+        }
+        bucket = ( ( bucket + 1 ) & m_Mask );
+    }
+    m_Buckets[ hole ] = 0;
+
+    // Remove from entries, moving the last entry into the gap
+    const uint32_t lastIndex = (uint32_t)( m_Entries.GetSize() - 1 );
+    if ( entryIndex != lastIndex )
+    {
+        const uint32_t lastBucket = FindBucket( m_Entries[ lastIndex ].m_JobId );
+        ASSERT( m_Buckets[ lastBucket ] == ( lastIndex + 1 ) );
+        m_Buckets[ lastBucket ] = ( entryIndex + 1 );
+        m_Entries[ entryIndex ] = m_Entries[ lastIndex ];
+    }
+    m_Entries.Pop();
+}
+
+// FindBucket
+//------------------------------------------------------------------------------
+uint32_t JobIdTable::FindBucket( uint32_t jobId ) const
+{
+    uint32_t bucket = ( Hash( jobId ) & m_Mask );
+    for ( ;; )
+    {
+        const uint32_t index = m_Buckets[ bucket ];
+        if ( index == 0 )
+        {
+            return (uint32_t)-1; // Not found
+        }
+        if ( m_Entries[ index - 1 ].m_JobId == jobId )
+        {
+            return bucket;
+        }
+        bucket = ( ( bucket + 1 ) & m_Mask );
+    }
+}
+
+// Rehash
+//------------------------------------------------------------------------------
+void JobIdTable::Rehash( uint32_t numBuckets )
+{
+    ASSERT( ( numBuckets & ( numBuckets - 1 ) ) == 0 ); // Must be power of 2
+
+    m_Buckets.SetSize( numBuckets );
+    for ( uint32_t & bucket : m_Buckets )
+    {
+        bucket = 0;
+    }
+    m_Mask = ( numBuckets - 1 );
+
+    const uint32_t numEntries = (uint32_t)m_Entries.GetSize();
+    for ( uint32_t i = 0; i < numEntries; ++i )
+    {
+        uint32_t bucket = ( Hash( m_Entries[ i ].m_JobId ) & m_Mask );
+        while ( m_Buckets[ bucket ] != 0 )
+        {
+            bucket = ( ( bucket + 1 ) & m_Mask );
+        }
+        m_Buckets[ bucket ] = ( i + 1 );
+    }
+}
+
+//------------------------------------------------------------------------------
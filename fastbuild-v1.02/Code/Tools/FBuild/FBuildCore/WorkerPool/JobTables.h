@@ -0,0 +1,90 @@
+// JobTables - containers for tracking distributable jobs
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Containers/Array.h"
+#include "Core/Env/Types.h"
+
+// Forward Declarations
+//------------------------------------------------------------------------------
+class Job;
+
+// JobCostHeap
+//------------------------------------------------------------------------------
+// Jobs waiting to be processed. The most expensive job is removed first, with
+// jobs of equal cost removed in the order they were added.
+//------------------------------------------------------------------------------
+class JobCostHeap
+{
+public:
+    explicit JobCostHeap( size_t initialCapacity );
+
+    void    Push( Job * job, uint32_t cost );
+    Job *   Pop(); // returns nullptr if empty
+    inline Job *    Peek() const                    { return m_Entries.IsEmpty() ? nullptr : m_Entries[ 0 ].m_Job; } // next job Pop will return
+
+    // Highest priority job accepted by the filter (index for Remove), or -1 if none
+    typedef bool (*JobFilter)( const Job * job, const void * userData );
+    size_t  FindHighestPriority( JobFilter filter, const void * userData ) const;
+    Job *   Remove( size_t index );
+
+    inline size_t   GetSize() const                 { return m_Entries.GetSize(); }
+    inline bool     IsEmpty() const                 { return m_Entries.IsEmpty(); }
+    inline Job *    GetJob( size_t index ) const    { return m_Entries[ index ].m_Job; } // Unordered
+    inline void     Clear()                         { m_Entries.Clear(); }
+
+private:
+    struct Entry
+    {
+        Job *       m_Job;
+        uint32_t    m_Cost;
+        uint32_t    m_Order;
+    };
+    static inline bool IsHigherPriority( const Entry & a, const Entry & b );
+    void SiftUp( size_t index );
+    void SiftDown( size_t index );
+
+    Array< Entry >  m_Entries;
+    uint32_t        m_NextOrder;
+};
+
+// JobIdTable
+//------------------------------------------------------------------------------
+// Jobs in progress, indexed by JobId. Add, Find and Remove are O(1).
+//------------------------------------------------------------------------------
+class JobIdTable
+{
+public:
+    explicit JobIdTable( size_t initialCapacity );
+
+    void    Add( Job * job );
+    Job *   Find( uint32_t jobId ) const; // returns nullptr if not found
+    void    Remove( Job * job );
+
+    inline size_t   GetSize() const                         { return m_Entries.GetSize(); }
+    inline bool     IsEmpty() const                         { return m_Entries.IsEmpty(); }
+
+    // Access in no particular order, with the relative order jobs were added
+    inline Job *    GetJob( size_t index ) const            { return m_Entries[ index ].m_Job; }
+    inline uint32_t GetAddOrder( size_t index ) const       { return m_Entries[ index ].m_Order; }
+
+private:
+    struct Entry
+    {
+        Job *       m_Job;
+        uint32_t    m_JobId;
+        uint32_t    m_Order;
+    };
+    static inline uint32_t Hash( uint32_t jobId ) { return ( jobId * 0x9E3779B1 ); }
+    uint32_t FindBucket( uint32_t jobId ) const;
+    void Rehash( uint32_t numBuckets );
+
+    Array< Entry >      m_Entries;  // Dense
+    Array< uint32_t >   m_Buckets;  // Index into m_Entries + 1 (0 = empty), linear probing
+    uint32_t            m_Mask;     // num buckets - 1
+    uint32_t            m_NextOrder;
+};
+
+//------------------------------------------------------------------------------
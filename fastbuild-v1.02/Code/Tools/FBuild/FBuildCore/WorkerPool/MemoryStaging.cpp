@@ -0,0 +1,227 @@
+// MemoryStaging - keep the temp files of remote jobs in memory
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "MemoryStaging.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/Helpers/Compressor.h"
+#include "Tools/FBuild/FBuildCore/Helpers/HeaderBundle.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/Job.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/WorkerResources.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/WorkerThread.h"
+
+// Core
+#include "Core/Containers/Array.h"
+#include "Core/FileIO/FileIO.h"
+#include "Core/FileIO/PathUtils.h"
+#include "Core/Math/Conversions.h"
+#include "Core/Strings/AStackString.h"
+
+// system
+#if defined( __LINUX__ )
+    #include <sys/vfs.h>
+#endif
+
+// Defines
+//------------------------------------------------------------------------------
+#define MEMORY_STAGING_TMPFS_MAGIC      ( 0x01021994 ) // TMPFS_MAGIC from linux/magic.h
+#define MEMORY_STAGING_OUTPUT_RATIO     ( 2 )             // object, debug info etc. relative to the (preprocessed) source
+#define MEMORY_STAGING_MIN_OUTPUT       ( 1 * MEGABYTE )  // for tiny sources
+#define MEMORY_STAGING_FULL_FREE_BYTES  ( 1 * MEGABYTE )  // less free space than this and the tmpfs is full
+
+// Static Data
+//------------------------------------------------------------------------------
+static THREAD_LOCAL bool s_ThreadStagingInMemory = false;
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+MemoryStaging::MemoryStaging( const AString & root, uint64_t budgetBytes )
+    : m_Root( root )
+    , m_Budget( budgetBytes )
+    , m_BytesInUse( 0 )
+{
+    PathUtils::EnsureTrailingSlash( m_Root );
+
+    // Anything left over from a previous run is still using memory
+    Array< AString > files( 256, true );
+    FileIO::GetFiles( m_Root, AStackString<>( "*" ), true, &files );
+    for ( const AString & file : files )
+    {
+        FileIO::FileDelete( file.Get() );
+    }
+    FileIO::EnsurePathExists( m_Root );
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+MemoryStaging::~MemoryStaging()
+{
+    ASSERT( m_BytesInUse == 0 );
+}
+
+// GetDefaultRoot
+//------------------------------------------------------------------------------
+/*static*/ bool MemoryStaging::GetDefaultRoot( AString & outRoot )
+{
+    #if defined( __LINUX__ )
+        struct statfs info;
+        if ( ( statfs( "/dev/shm", &info ) != 0 ) ||
+             ( (uint64_t)info.f_type != MEMORY_STAGING_TMPFS_MAGIC ) )
+        {
+            return false;
+        }
+        outRoot = "/dev/shm/_fbuild.tmp/worker/";
+        return true;
+    #else
+        (void)outRoot;
+        return false; // TODO:B Support RAM disks on Windows and OSX
+    #endif
+}
+
+// Reserve
+//------------------------------------------------------------------------------
+bool MemoryStaging::Reserve( uint64_t bytes )
+{
+    MutexHolder lock( m_Mutex );
+
+    if ( ( m_BytesInUse + bytes ) > m_Budget )
+    {
+        return false;
+    }
+
+    // The tmpfs can be filled by other things too
+    uint64_t freeBytes;
+    if ( ( WorkerResources::GetFreeDiskSpace( m_Root, freeBytes ) == false ) ||
+         ( freeBytes < bytes ) )
+    {
+        return false;
+    }
+
+    m_BytesInUse += bytes;
+    return true;
+}
+
+// Release
+//------------------------------------------------------------------------------
+void MemoryStaging::Release( uint64_t bytes )
+{
+    MutexHolder lock( m_Mutex );
+    ASSERT( m_BytesInUse >= bytes );
+    m_BytesInUse -= bytes;
+}
+
+// IsFull
+//------------------------------------------------------------------------------
+bool MemoryStaging::IsFull() const
+{
+    uint64_t freeBytes;
+    return ( ( WorkerResources::GetFreeDiskSpace( m_Root, freeBytes ) == false ) ||
+             ( freeBytes < MEMORY_STAGING_FULL_FREE_BYTES ) );
+}
+
+// GetBytesInUse
+//------------------------------------------------------------------------------
+uint64_t MemoryStaging::GetBytesInUse() const
+{
+    MutexHolder lock( m_Mutex );
+    return m_BytesInUse;
+}
+
+// IsThreadStagingInMemory
+//------------------------------------------------------------------------------
+/*static*/ bool MemoryStaging::IsThreadStagingInMemory()
+{
+    return s_ThreadStagingInMemory;
+}
+
+// SetThreadStagingInMemory
+//------------------------------------------------------------------------------
+/*static*/ void MemoryStaging::SetThreadStagingInMemory( bool inMemory )
+{
+    s_ThreadStagingInMemory = inMemory;
+}
+
+// MemoryStagingScope (CONSTRUCTOR)
+//------------------------------------------------------------------------------
+MemoryStagingScope::MemoryStagingScope( const Job * job )
+    : m_ReservedBytes( 0 )
+{
+    // Only remote jobs build in the worker thread's temp dir
+    if ( ( MemoryStaging::IsValid() == false ) || job->IsLocal() )
+    {
+        return;
+    }
+
+    // If it doesn't fit, the job falls back to disk
+    const uint64_t bytes = EstimateBytes( job );
+    if ( MemoryStaging::Get().Reserve( bytes ) )
+    {
+        m_ReservedBytes = bytes;
+        MemoryStaging::SetThreadStagingInMemory( true );
+    }
+}
+
+// MemoryStagingScope (DESTRUCTOR)
+//------------------------------------------------------------------------------
+MemoryStagingScope::~MemoryStagingScope()
+{
+    if ( m_ReservedBytes )
+    {
+        MemoryStaging::SetThreadStagingInMemory( false );
+        MemoryStaging::Get().Release( m_ReservedBytes );
+    }
+}
+
+// FallBackToDisk
+//------------------------------------------------------------------------------
+void MemoryStagingScope::FallBackToDisk()
+{
+    ASSERT( IsInMemory() );
+
+    // Free whatever the failed attempt left behind
+    AStackString<> tmpDir;
+    WorkerThread::GetTempFileDirectory( tmpDir );
+    Array< AString > files( 16, true );
+    FileIO::GetFiles( tmpDir, AStackString<>( "*" ), true, &files );
+    for ( const AString & file : files )
+    {
+        FileIO::FileDelete( file.Get() );
+    }
+
+    MemoryStaging::SetThreadStagingInMemory( false );
+    MemoryStaging::Get().Release( m_ReservedBytes );
+    m_ReservedBytes = 0;
+}
+
+// EstimateBytes
+//------------------------------------------------------------------------------
+/*static*/ uint64_t MemoryStagingScope::EstimateBytes( const Job * job )
+{
+    // The preprocessed source is written to the temp dir, while header bundles
+    // are linked from the on-disk HeaderStore
+    uint64_t inputBytes = 0;
+    uint64_t sourceBytes = 0;
+    if ( job->IsDataHeaderBundle() )
+    {
+        HeaderBundle bundle;
+        if ( HeaderStore::IsValid() && bundle.LoadFromJob( job ) )
+        {
+            sourceBytes = HeaderStore::Get().GetTotalSize( bundle );
+        }
+    }
+    else if ( job->GetData() )
+    {
+        inputBytes = job->IsDataCompressed() ? Compressor::GetUncompressedSize( job->GetData() )
+                                             : job->GetDataSize();
+        sourceBytes = inputBytes;
+    }
+
+    // Outputs scale with the source (if the guess is too low for the tmpfs,
+    // the job is tried again on disk)
+    const uint64_t outputBytes = Math::Max< uint64_t >( sourceBytes * MEMORY_STAGING_OUTPUT_RATIO, MEMORY_STAGING_MIN_OUTPUT );
+    return ( inputBytes + outputBytes );
+}
+
+//------------------------------------------------------------------------------
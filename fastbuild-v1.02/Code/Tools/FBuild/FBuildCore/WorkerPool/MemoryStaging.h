@@ -0,0 +1,84 @@
+// MemoryStaging - keep the temp files of remote jobs in memory
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Containers/Singleton.h"
+#include "Core/Env/Types.h"
+#include "Core/Process/Mutex.h"
+#include "Core/Strings/AString.h"
+
+// Forward Declarations
+//------------------------------------------------------------------------------
+class Job;
+
+// MemoryStaging
+//------------------------------------------------------------------------------
+// A remote job writes its preprocessed input to the worker thread's temp dir,
+// the compiler writes the object there and the worker reads it back. When
+// enabled, jobs which fit in a budget use a RAM-backed directory (tmpfs)
+// instead, so none of this reaches the disk:
+//
+//   <tmp>/_fbuild.tmp/0x00000000/core_N/   - jobs which don't fit
+//   /dev/shm/_fbuild.tmp/worker/core_N/    - jobs staged in memory
+//
+// Headers (see HeaderBundle) stay on disk, as they are hard linked from the
+// worker's header store. A job which fails because the tmpfs filled up (it
+// can be shared with other processes) is tried again on disk.
+//------------------------------------------------------------------------------
+class MemoryStaging : public Singleton< MemoryStaging >
+{
+public:
+    explicit MemoryStaging( const AString & root, uint64_t budgetBytes );
+    ~MemoryStaging();
+
+    // RAM-backed directory to use by default (false if there isn't one)
+    static bool GetDefaultRoot( AString & outRoot );
+
+    // Space is reserved for a job up front. It fails if the budget, or the
+    // tmpfs itself (which may be shared), is full.
+    bool                    Reserve( uint64_t bytes );
+    void                    Release( uint64_t bytes );
+
+    // Has the tmpfs run out of space (whatever was reserved)?
+    bool                    IsFull() const;
+
+    // Is the current thread's job staged in memory?
+    static bool             IsThreadStagingInMemory();
+
+    inline const AString &  GetRoot() const         { return m_Root; }
+    inline uint64_t         GetBudget() const       { return m_Budget; }
+    uint64_t                GetBytesInUse() const;
+
+private:
+    friend class MemoryStagingScope;
+    static void             SetThreadStagingInMemory( bool inMemory );
+
+    mutable Mutex           m_Mutex;
+    AString                 m_Root;
+    uint64_t                m_Budget;
+    uint64_t                m_BytesInUse;
+};
+
+// MemoryStagingScope - stage a remote job in memory, if it fits
+//------------------------------------------------------------------------------
+class MemoryStagingScope
+{
+public:
+    explicit MemoryStagingScope( const Job * job );
+    ~MemoryStagingScope();
+
+    inline bool IsInMemory() const { return ( m_ReservedBytes != 0 ); }
+
+    // Discard the thread's temp files and stage on disk from now on
+    void FallBackToDisk();
+
+    // Space for a job's input and output
+    static uint64_t EstimateBytes( const Job * job );
+
+private:
+    uint64_t m_ReservedBytes;
+};
+
+//------------------------------------------------------------------------------
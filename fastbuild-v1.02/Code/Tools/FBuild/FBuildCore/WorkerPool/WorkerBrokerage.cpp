@@ -8,9 +8,11 @@
 #include "Tools/FBuild/FBuildWorker/Worker/WorkerSettings.h"
 
 // FBuild
+#include "Tools/FBuild/FBuildCore/Protocol/BrokerConnection.h"
 #include "Tools/FBuild/FBuildCore/Protocol/Protocol.h"
 #include "Tools/FBuild/FBuildCore/FBuildVersion.h"
 #include "Tools/FBuild/FBuildCore/FLog.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/WorkerResources.h"
 #include "Tools/FBuild/FBuildWorker/Worker/WorkerSettings.h"
 
 // Core
@@ -18,12 +20,17 @@
 #include "Core/FileIO/FileIO.h"
 #include "Core/FileIO/FileStream.h"
 #include "Core/FileIO/PathUtils.h"
+#include "Core/Mem/Mem.h"
 #include "Core/Network/Network.h"
+#include "Core/Process/Atomic.h"
 #include "Core/Profile/Profile.h"
 #include "Core/Strings/AStackString.h"
 #include "Core/Process/Thread.h"
 #include "Core/Time/Time.h"
 
+// system
+#include <stdio.h> // for sscanf
+
 #if defined( __APPLE__ )
 
 #include <sys/socket.h>
@@ -69,6 +76,7 @@ static bool ConvertHostNameToLocalIP4( AString& hostName )
 //------------------------------------------------------------------------------
 static const float sBrokerageElapsedTimeBetweenClean = ( 12 * 60 * 60.0f );
 static const uint32_t sBrokerageCleanOlderThan = ( 24 * 60 * 60 );
+static const float sBrokerReconnectDelay = 10.0f;
 
 // CONSTRUCTOR
 //------------------------------------------------------------------------------
@@ -76,6 +84,11 @@ WorkerBrokerage::WorkerBrokerage()
     : m_Availability( false )
     , m_Initialized( false )
     , m_SettingsWriteTime( 0 )
+    , m_BrokerPort( Protocol::BROKER_PORT )
+    , m_BrokerAvailability( false )
+    , m_BrokerThread( INVALID_THREAD_HANDLE )
+    , m_BrokerThreadExit( false )
+    , m_WorkersFromBroker( false )
 {
 }
 
@@ -146,6 +159,28 @@ void WorkerBrokerage::Init()
         }
     }
 
+    // optional broker service
+    AStackString<> brokerAddress;
+    if ( Env::GetEnvVariable( "FASTBUILD_BROKER", brokerAddress ) && ( brokerAddress.IsEmpty() == false ) )
+    {
+        m_BrokerAddress = brokerAddress;
+        m_BrokerHost = brokerAddress;
+        const char * colon = brokerAddress.Find( ':' );
+        if ( colon )
+        {
+            m_BrokerHost.SetLength( (uint32_t)( colon - brokerAddress.Get() ) );
+            uint32_t port = 0;
+            PRAGMA_DISABLE_PUSH_MSVC( 4996 ) // This function or variable may be unsafe...
+            if ( ( sscanf( colon + 1, "%u", &port ) != 1 ) || ( port == 0 ) || ( port > 0xFFFF ) ) // TODO:C Consider using sscanf_s
+            PRAGMA_DISABLE_POP_MSVC // 4996
+            {
+                FLOG_WARN( "Ignoring invalid port in FASTBUILD_BROKER '%s'", brokerAddress.Get() );
+                port = Protocol::BROKER_PORT;
+            }
+            m_BrokerPort = (uint16_t)port;
+        }
+    }
+
     Network::GetHostName(m_HostName);
 #if defined( __APPLE__ )
     ConvertHostNameToLocalIP4(m_HostName);
@@ -165,6 +200,15 @@ void WorkerBrokerage::Init()
 //------------------------------------------------------------------------------
 WorkerBrokerage::~WorkerBrokerage()
 {
+    // Closing the connection removes us from the broker
+    if ( m_BrokerThread != INVALID_THREAD_HANDLE )
+    {
+        AtomicStoreRelaxed( &m_BrokerThreadExit, true );
+        m_BrokerSemaphore.Signal();
+        Thread::WaitForThread( m_BrokerThread );
+        Thread::CloseHandle( m_BrokerThread );
+    }
+
     // Ensure the file disapears when closing
     if ( m_Availability )
     {
@@ -180,9 +224,16 @@ void WorkerBrokerage::FindWorkers( Array< AString > & workerList )
 
     Init();
 
+    // A broker provides a ranked list of live workers. If it can't be
+    // reached, or has no workers, fall back to the shared folder.
+    if ( ( m_BrokerHost.IsEmpty() == false ) && FindWorkersFromBroker( workerList ) )
+    {
+        return;
+    }
+
     if ( m_BrokerageRoots.IsEmpty() )
     {
-        FLOG_WARN( "No brokerage root; did you set FASTBUILD_BROKERAGE_PATH?" );
+        FLOG_WARN( "No brokerage root; did you set FASTBUILD_BROKERAGE_PATH or FASTBUILD_BROKER?" );
         return;
     }
 
@@ -223,12 +274,57 @@ void WorkerBrokerage::FindWorkers( Array< AString > & workerList )
     }
 }
 
+// FindWorkersFromBroker
+//------------------------------------------------------------------------------
+bool WorkerBrokerage::FindWorkersFromBroker( Array< AString > & workerList )
+{
+    PROFILE_FUNCTION
+
+    BrokerConnection broker( m_BrokerHost, m_BrokerPort );
+    Array< BrokerWorkerInfo > workers( 0, true );
+    if ( broker.RequestWorkers( workers ) == false )
+    {
+        FLOG_WARN( "Failed to get workers from broker '%s'", m_BrokerAddress.Get() );
+        return false;
+    }
+    FLOG_VERBOSE( "%zu workers found from broker '%s'", workers.GetSize(), m_BrokerAddress.Get() );
+
+    // workers are ranked, so keep their order
+    const size_t numWorkersBefore = workerList.GetSize();
+    workerList.SetCapacity( workerList.GetSize() + workers.GetSize() );
+    for ( const BrokerWorkerInfo & worker : workers )
+    {
+        if ( worker.m_HostName.CompareI( m_HostName ) != 0 )
+        {
+            workerList.Append( worker.m_HostName );
+        }
+    }
+    if ( workerList.GetSize() == numWorkersBefore )
+    {
+        return false; // Workers might still be registered in the shared folder
+    }
+    m_WorkersFromBroker = true;
+    return true;
+}
+
+// SetBrokerStatus
+//------------------------------------------------------------------------------
+void WorkerBrokerage::SetBrokerStatus( uint32_t numCPUs, uint32_t numFreeSlots, const Array< uint64_t > & toolIds )
+{
+    MutexHolder mh( m_BrokerMutex );
+    m_BrokerStatus.m_NumCPUs = numCPUs;
+    m_BrokerStatus.m_NumFreeSlots = numFreeSlots;
+    m_BrokerStatus.m_ToolIds = toolIds;
+}
+
 // SetAvailability
 //------------------------------------------------------------------------------
 void WorkerBrokerage::SetAvailability(bool available)
 {
     Init();
 
+    UpdateBroker( available );
+
     // ignore if brokerage not configured
     if ( m_BrokerageRoots.IsEmpty() )
     {
@@ -337,4 +433,90 @@ void WorkerBrokerage::SetAvailability(bool available)
     }    
 }
 
+// UpdateBroker
+//------------------------------------------------------------------------------
+void WorkerBrokerage::UpdateBroker( bool available )
+{
+    // ignore if broker not configured
+    if ( m_BrokerHost.IsEmpty() )
+    {
+        return;
+    }
+
+    bool changed;
+    {
+        MutexHolder mh( m_BrokerMutex );
+        changed = ( available != m_BrokerAvailability );
+        m_BrokerAvailability = available;
+    }
+
+    if ( m_BrokerThread == INVALID_THREAD_HANDLE )
+    {
+        m_BrokerStatus.m_HostName = m_HostName;
+        m_BrokerStatus.m_CPUScore = WorkerResources::CalcCPUScore();
+        m_BrokerThread = Thread::CreateThread( BrokerThreadFuncStatic,
+                                               "BrokerHeartbeat",
+                                               ( 64 * KILOBYTE ),
+                                               this );
+        ASSERT( m_BrokerThread != INVALID_THREAD_HANDLE );
+    }
+    else if ( changed )
+    {
+        m_BrokerSemaphore.Signal(); // send changes in availability right away
+    }
+}
+
+// BrokerThreadFuncStatic
+//------------------------------------------------------------------------------
+/*static*/ uint32_t WorkerBrokerage::BrokerThreadFuncStatic( void * param )
+{
+    PROFILE_SET_THREAD_NAME( "BrokerHeartbeat" )
+
+    WorkerBrokerage * brokerage = static_cast< WorkerBrokerage * >( param );
+    brokerage->BrokerThreadFunc();
+    return 0;
+}
+
+// BrokerThreadFunc
+//------------------------------------------------------------------------------
+void WorkerBrokerage::BrokerThreadFunc()
+{
+    BrokerConnection connection( m_BrokerHost, m_BrokerPort );
+
+    Timer timerLastHeartbeat;
+    bool first = true;
+    bool lastAvailability = false;
+    while ( AtomicLoadRelaxed( &m_BrokerThreadExit ) == false )
+    {
+        BrokerWorkerInfo status;
+        bool available;
+        {
+            MutexHolder mh( m_BrokerMutex );
+            status = m_BrokerStatus;
+            available = m_BrokerAvailability;
+        }
+
+        // Send heartbeats regularly, and changes in availability right away.
+        // Retry less often if the broker can't be reached.
+        const float interval = connection.IsConnected() ? BROKER_HEARTBEAT_INTERVAL_SECONDS : sBrokerReconnectDelay;
+        if ( first || ( available != lastAvailability ) || ( timerLastHeartbeat.GetElapsed() >= interval ) )
+        {
+            first = false;
+            lastAvailability = available;
+            timerLastHeartbeat.Start();
+
+            if ( available == false )
+            {
+                status.m_NumCPUs = 0;
+                status.m_NumFreeSlots = 0;
+            }
+            connection.SendHeartbeat( status );
+        }
+
+        m_BrokerSemaphore.Wait( 500 );
+    }
+
+    // Closing the connection (when it goes out of scope) removes us from the broker
+}
+
 //------------------------------------------------------------------------------
@@ -4,12 +4,14 @@
 
 // Includes
 //------------------------------------------------------------------------------
+#include "Tools/FBuild/FBuildCore/Protocol/Broker.h"
+
+#include "Core/Process/Mutex.h"
+#include "Core/Process/Semaphore.h"
+#include "Core/Process/Thread.h"
 #include "Core/Strings/AString.h"
 #include "Core/Time/Timer.h"
 
-// Forward Declarations
-//------------------------------------------------------------------------------
-
 // WorkerBrokerage
 //------------------------------------------------------------------------------
 class WorkerBrokerage
@@ -20,14 +22,23 @@ public:
 
     inline const Array<AString> & GetBrokerageRoots() const { return m_BrokerageRoots; }
     inline const AString & GetBrokerageRootPaths() const { return m_BrokerageRootPaths; }
+    inline const AString & GetBrokerAddress() const { return m_BrokerAddress; }
 
     // client interface
     void FindWorkers( Array< AString > & workerList );
+    inline bool WorkersCameFromBroker() const { return m_WorkersFromBroker; } // list is ranked
 
     // server interface
+    void SetBrokerStatus( uint32_t numCPUs, uint32_t numFreeSlots, const Array< uint64_t > & toolIds );
     void SetAvailability( bool available );
 private:
     void Init();
+    bool FindWorkersFromBroker( Array< AString > & workerList );
+    void UpdateBroker( bool available );
+
+    // Heartbeats are sent from a thread, so an unreachable broker can't block the worker
+    static uint32_t BrokerThreadFuncStatic( void * param );
+    void            BrokerThreadFunc();
 
     Array<AString>      m_BrokerageRoots;
     AString             m_BrokerageRootPaths;
@@ -38,6 +49,18 @@ private:
     Timer               m_TimerLastUpdate;      // Throttle network access
     uint64_t            m_SettingsWriteTime;    // FileTime of settings time when last changed
     Timer               m_TimerLastCleanBroker;
+
+    // optional broker service (FASTBUILD_BROKER=<host>[:<port>])
+    AString             m_BrokerAddress;
+    AString             m_BrokerHost;
+    uint16_t            m_BrokerPort;
+    Mutex               m_BrokerMutex;          // protects status shared with the thread
+    BrokerWorkerInfo    m_BrokerStatus;
+    bool                m_BrokerAvailability;   // availability to send to the broker
+    Thread::ThreadHandle m_BrokerThread;
+    Semaphore           m_BrokerSemaphore;      // wakes the thread early
+    volatile bool       m_BrokerThreadExit;
+    bool                m_WorkersFromBroker;
 };
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,231 @@
+// WorkerCGroups - isolate remote jobs in their own cgroup v2 on Linux workers
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "WorkerCGroups.h"
+
+// Core
+#include "Core/Env/Assert.h"
+#include "Core/FileIO/FileIO.h"
+#include "Core/FileIO/FileStream.h"
+#include "Core/Process/Atomic.h"
+#include "Core/Process/Process.h"
+#include "Core/Process/Thread.h"
+#include "Core/Strings/AStackString.h"
+
+// system
+#include <stdio.h>
+
+// Defines
+//------------------------------------------------------------------------------
+#define CGROUP_DESTROY_ATTEMPTS         ( 20 )
+#define CGROUP_DESTROY_RETRY_DELAY_MS   ( 10 )
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+WorkerCGroups::WorkerCGroups( const char * systemRoot )
+    : m_Resources( systemRoot )
+    , m_JobCPUWeight( 0 )
+    , m_JobMemoryLimit( 0 )
+    , m_NextJobGroupId( 0 )
+{
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+WorkerCGroups::~WorkerCGroups() = default;
+
+// Init
+//------------------------------------------------------------------------------
+bool WorkerCGroups::Init( uint32_t jobCPUWeight, uint64_t jobMemoryLimitBytes, AString & outError )
+{
+    #if defined( __LINUX__ )
+        ASSERT( ( jobCPUWeight >= 1 ) && ( jobCPUWeight <= 10000 ) ); // cgroup v2 cpu.weight range
+        m_JobCPUWeight = jobCPUWeight;
+        m_JobMemoryLimit = jobMemoryLimitBytes;
+
+        // Find the cgroup we were started in
+        AStackString<> groupPath;
+        if ( m_Resources.GetCGroupPath( groupPath ) == false )
+        {
+            outError = "cgroup v2 is not available";
+            return false;
+        }
+        if ( groupPath.EndsWith( '/' ) )
+        {
+            groupPath.SetLength( groupPath.GetLength() - 1 ); // the root becomes empty
+        }
+        m_BaseDir.Format( "%s/sys/fs/cgroup%s", m_Resources.GetSystemRoot().Get(), groupPath.Get() );
+
+        // The controllers must be available to us
+        AStackString<> controllersFile( m_BaseDir );
+        controllersFile += "/cgroup.controllers";
+        AStackString<> controllers;
+        if ( ( WorkerResources::ReadVirtualFile( controllersFile.Get(), controllers ) == false ) ||
+             ( HasController( controllers, "cpu" ) == false ) ||
+             ( HasController( controllers, "memory" ) == false ) )
+        {
+            outError.Format( "cpu and memory controllers are not delegated to '%s'", m_BaseDir.Get() );
+            return false;
+        }
+
+        // Processes can only live in leaves once controllers are enabled for
+        // child groups, so move ourselves into a leaf
+        AStackString<> workerDir( m_BaseDir );
+        workerDir += "/worker";
+        AStackString<> workerProcs( workerDir );
+        workerProcs += "/cgroup.procs";
+        AStackString<> pid;
+        pid.Format( "%u", Process::GetCurrentId() );
+        if ( ( FileIO::DirectoryCreate( workerDir ) == false ) ||
+             ( WriteFile( workerProcs, pid.Get() ) == false ) )
+        {
+            outError.Format( "Failed to move worker into '%s'", workerDir.Get() );
+            return false;
+        }
+
+        // Enable the controllers for the job groups
+        AStackString<> subtreeControl( m_BaseDir );
+        subtreeControl += "/cgroup.subtree_control";
+        if ( WriteFile( subtreeControl, "+cpu +memory" ) == false )
+        {
+            outError.Format( "Failed to enable controllers in '%s' (are other processes in this cgroup?)", subtreeControl.Get() );
+            return false;
+        }
+
+        return true;
+    #else
+        (void)jobCPUWeight;
+        (void)jobMemoryLimitBytes;
+        outError = "cgroups are only supported on Linux";
+        return false;
+    #endif
+}
+
+// CreateJobGroup
+//------------------------------------------------------------------------------
+bool WorkerCGroups::CreateJobGroup( AString & outGroupDir )
+{
+    ASSERT( m_BaseDir.IsEmpty() == false ); // Init not called?
+
+    // Job ids are only unique per client, so use our own numbering
+    const uint32_t id = AtomicIncU32( &m_NextJobGroupId );
+    outGroupDir.Format( "%s/job-%u", m_BaseDir.Get(), id );
+    if ( FileIO::DirectoryCreate( outGroupDir ) == false )
+    {
+        return false;
+    }
+
+    // Apply limits. Out of memory kills the whole job rather than one
+    // process, so a compiler driver can't report a partial failure.
+    AStackString<> fileName;
+    AStackString<> value;
+    fileName.Format( "%s/cpu.weight", outGroupDir.Get() );
+    value.Format( "%u", m_JobCPUWeight );
+    bool ok = WriteFile( fileName, value.Get() );
+    if ( ok && m_JobMemoryLimit )
+    {
+        fileName.Format( "%s/memory.max", outGroupDir.Get() );
+        value.Format( "%llu", (unsigned long long)m_JobMemoryLimit );
+        ok = WriteFile( fileName, value.Get() );
+        fileName.Format( "%s/memory.oom.group", outGroupDir.Get() );
+        ok = ok && WriteFile( fileName, "1" );
+    }
+    if ( ok == false )
+    {
+        DestroyJobGroup( outGroupDir );
+        return false;
+    }
+    return true;
+}
+
+// ReadJobUsage
+//------------------------------------------------------------------------------
+bool WorkerCGroups::ReadJobUsage( const AString & groupDir, uint64_t & outPeakMemoryBytes, uint64_t & outCPUTimeUS ) const
+{
+    // memory.peak requires Linux 5.19
+    AStackString<> fileName;
+    AStackString<> contents;
+    unsigned long long peak = 0;
+    fileName.Format( "%s/memory.peak", groupDir.Get() );
+    if ( ( WorkerResources::ReadVirtualFile( fileName.Get(), contents ) == false ) ||
+         ( sscanf( contents.Get(), "%llu", &peak ) != 1 ) )
+    {
+        return false;
+    }
+
+    // cpu.stat contains "usage_usec <n>" as its first entry
+    unsigned long long usage = 0;
+    fileName.Format( "%s/cpu.stat", groupDir.Get() );
+    const char * usageEntry = nullptr;
+    if ( ( WorkerResources::ReadVirtualFile( fileName.Get(), contents ) == false ) ||
+         ( ( usageEntry = contents.Find( "usage_usec " ) ) == nullptr ) ||
+         ( sscanf( usageEntry + 11, "%llu", &usage ) != 1 ) )
+    {
+        return false;
+    }
+
+    outPeakMemoryBytes = (uint64_t)peak;
+    outCPUTimeUS = (uint64_t)usage;
+    return true;
+}
+
+// DestroyJobGroup
+//------------------------------------------------------------------------------
+bool WorkerCGroups::DestroyJobGroup( const AString & groupDir )
+{
+    // Kill anything left behind (cgroup.kill requires Linux 5.14)
+    AStackString<> killFile( groupDir );
+    killFile += "/cgroup.kill";
+    if ( FileIO::FileExists( killFile.Get() ) )
+    {
+        WriteFile( killFile, "1" );
+    }
+
+    // The group can only be removed once killed processes have exited
+    for ( uint32_t i = 0; i < CGROUP_DESTROY_ATTEMPTS; ++i )
+    {
+        if ( FileIO::DirectoryDelete( groupDir ) )
+        {
+            return true;
+        }
+        Thread::Sleep( CGROUP_DESTROY_RETRY_DELAY_MS );
+    }
+    return false;
+}
+
+// WriteFile
+//------------------------------------------------------------------------------
+/*static*/ bool WorkerCGroups::WriteFile( const AString & fileName, const char * contents )
+{
+    // cgroup files must be written with a single write
+    FileStream f;
+    if ( f.Open( fileName.Get(), FileStream::WRITE_ONLY ) == false )
+    {
+        return false;
+    }
+    const uint64_t len = AString::StrLen( contents );
+    return ( f.WriteBuffer( contents, len ) == len );
+}
+
+// HasController
+//------------------------------------------------------------------------------
+/*static*/ bool WorkerCGroups::HasController( const AString & controllers, const char * controller )
+{
+    // Space separated list, e.g. "cpuset cpu io memory pids"
+    const size_t len = AString::StrLen( controller );
+    for ( const char * pos = controllers.Find( controller ); pos; pos = controllers.Find( controller, pos + 1 ) )
+    {
+        const bool startOk = ( pos == controllers.Get() ) || ( pos[ -1 ] == ' ' );
+        const char end = pos[ len ];
+        const bool endOk = ( end == '\0' ) || ( end == ' ' ) || ( end == '\n' );
+        if ( startOk && endOk )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,52 @@
+// WorkerCGroups - isolate remote jobs in their own cgroup v2 on Linux workers
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Tools/FBuild/FBuildCore/WorkerPool/WorkerResources.h"
+
+#include "Core/Containers/Singleton.h"
+#include "Core/Env/Types.h"
+#include "Core/Strings/AString.h"
+
+// WorkerCGroups
+//------------------------------------------------------------------------------
+// The worker must be started in a cgroup delegated to it (for example a
+// systemd service with Delegate=yes). The worker process moves itself into a
+// "worker" leaf so the cpu and memory controllers can be enabled for its
+// cgroup, and each job gets a sibling "job-<n>" group with its own limits:
+//
+//   <worker cgroup>/worker     - FBuildWorker itself
+//   <worker cgroup>/job-<n>    - one compiler process tree
+//
+// The system root can be redirected so tests can provide a fake /proc and /sys.
+//------------------------------------------------------------------------------
+class WorkerCGroups : public Singleton< WorkerCGroups >
+{
+public:
+    explicit WorkerCGroups( const char * systemRoot = "" );
+    ~WorkerCGroups();
+
+    // Prepare the hierarchy. Limits are applied to every job (0 = no memory limit).
+    bool Init( uint32_t jobCPUWeight, uint64_t jobMemoryLimitBytes, AString & outError );
+
+    // Per-job groups, identified by their directory
+    bool CreateJobGroup( AString & outGroupDir );
+    bool ReadJobUsage( const AString & groupDir, uint64_t & outPeakMemoryBytes, uint64_t & outCPUTimeUS ) const;
+    bool DestroyJobGroup( const AString & groupDir );
+
+    inline const AString & GetBaseDir() const { return m_BaseDir; }
+
+private:
+    static bool WriteFile( const AString & fileName, const char * contents );
+    static bool HasController( const AString & controllers, const char * controller );
+
+    WorkerResources     m_Resources;
+    AString             m_BaseDir;
+    uint32_t            m_JobCPUWeight;
+    uint64_t            m_JobMemoryLimit;
+    volatile uint32_t   m_NextJobGroupId;
+};
+
+//------------------------------------------------------------------------------
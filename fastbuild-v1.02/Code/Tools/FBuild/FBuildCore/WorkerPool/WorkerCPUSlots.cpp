@@ -0,0 +1,83 @@
+// WorkerCPUSlots - number of CPUs a shared worker offers, from observed load
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "WorkerCPUSlots.h"
+
+// Core
+#include "Core/Math/Conversions.h"
+
+// Defines
+//------------------------------------------------------------------------------
+#define WORKER_CPU_SLOTS_MARGIN         ( 0.5f )    // CPUs of extra usage tolerated before shrinking
+#define WORKER_CPU_SLOTS_GROW_UPDATES   ( 10 )      // ~5s
+#define WORKER_CPU_SLOTS_SHRINK_UPDATES ( 2 )       // ~1s
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+WorkerCPUSlots::WorkerCPUSlots()
+    : m_NumCPUs( 0 )
+    , m_GrowTarget( 0 )
+    , m_GrowCount( 0 )
+    , m_ShrinkTarget( 0 )
+    , m_ShrinkCount( 0 )
+{
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+WorkerCPUSlots::~WorkerCPUSlots() = default;
+
+// Update
+//------------------------------------------------------------------------------
+uint32_t WorkerCPUSlots::Update( uint32_t maxCPUs, uint32_t numProcessors, float otherCPUUsagePercent )
+{
+    // A lowered limit applies immediately
+    if ( m_NumCPUs > maxCPUs )
+    {
+        m_NumCPUs = maxCPUs;
+        m_GrowCount = 0;
+        m_ShrinkCount = 0;
+    }
+
+    // CPUs not used by anything else
+    const float otherUsage = Math::Clamp( otherCPUUsagePercent * 0.01f, 0.0f, 1.0f );
+    const float freeCPUs = ( (float)numProcessors * ( 1.0f - otherUsage ) );
+
+    // Grow only by whole free CPUs, but shrink only once usage is clearly
+    // above the current count, so small fluctuations fall in the dead band
+    const uint32_t growTarget = Math::Min( (uint32_t)freeCPUs, maxCPUs );
+    const uint32_t shrinkTarget = Math::Min( (uint32_t)( freeCPUs + WORKER_CPU_SLOTS_MARGIN ), maxCPUs );
+
+    if ( shrinkTarget < m_NumCPUs )
+    {
+        m_GrowCount = 0;
+        m_ShrinkTarget = ( m_ShrinkCount == 0 ) ? shrinkTarget : Math::Max( m_ShrinkTarget, shrinkTarget );
+        if ( ++m_ShrinkCount >= WORKER_CPU_SLOTS_SHRINK_UPDATES )
+        {
+            m_NumCPUs = m_ShrinkTarget;
+            m_ShrinkCount = 0;
+        }
+    }
+    else if ( growTarget > m_NumCPUs )
+    {
+        m_ShrinkCount = 0;
+        m_GrowTarget = ( m_GrowCount == 0 ) ? growTarget : Math::Min( m_GrowTarget, growTarget );
+        if ( ++m_GrowCount >= WORKER_CPU_SLOTS_GROW_UPDATES )
+        {
+            m_NumCPUs = m_GrowTarget;
+            m_GrowCount = 0;
+        }
+    }
+    else
+    {
+        // Within the dead band
+        m_GrowCount = 0;
+        m_ShrinkCount = 0;
+    }
+
+    return m_NumCPUs;
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,37 @@
+// WorkerCPUSlots - number of CPUs a shared worker offers, from observed load
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Env/Types.h"
+
+// WorkerCPUSlots
+//------------------------------------------------------------------------------
+// Offers the CPUs not used by anything other than FASTBuild, up to a maximum.
+// To avoid oscillating with noisy measurements, the count only shrinks once the
+// free CPUs fall more than a margin below it, and the change must persist for a
+// number of updates. CPUs are given back to the user more quickly than they
+// are taken.
+//------------------------------------------------------------------------------
+class WorkerCPUSlots
+{
+public:
+    WorkerCPUSlots();
+    ~WorkerCPUSlots();
+
+    // otherCPUUsagePercent is the load of everything except FASTBuild, as a
+    // percentage of all numProcessors. Expected to be called every ~500ms.
+    uint32_t Update( uint32_t maxCPUs, uint32_t numProcessors, float otherCPUUsagePercent );
+
+    inline uint32_t GetNumCPUs() const { return m_NumCPUs; }
+
+private:
+    uint32_t    m_NumCPUs;
+    uint32_t    m_GrowTarget;   // smallest target seen while waiting to grow
+    uint32_t    m_GrowCount;    // consecutive updates wanting to grow
+    uint32_t    m_ShrinkTarget; // largest target seen while waiting to shrink
+    uint32_t    m_ShrinkCount;  // consecutive updates wanting to shrink
+};
+
+//------------------------------------------------------------------------------
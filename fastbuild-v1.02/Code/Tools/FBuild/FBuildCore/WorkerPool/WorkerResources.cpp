@@ -0,0 +1,297 @@
+// WorkerResources - query memory and disk availability for worker admission
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "WorkerResources.h"
+
+// Core
+#include "Core/Containers/AutoPtr.h"
+#include "Core/Env/Assert.h"
+#include "Core/FileIO/FileStream.h"
+#include "Core/Math/Conversions.h"
+#include "Core/Math/xxHash.h"
+#include "Core/Mem/Mem.h"
+#include "Core/Strings/AStackString.h"
+#include "Core/Time/Timer.h"
+
+// system
+#if defined( __WINDOWS__ )
+    #include "Core/Env/WindowsHeader.h"
+#endif
+#if defined( __LINUX__ ) || defined( __OSX__ )
+    #include <sys/statvfs.h>
+#endif
+#include <stdio.h>
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+WorkerResources::WorkerResources( const char * systemRoot )
+    : m_SystemRoot( systemRoot )
+{
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+WorkerResources::~WorkerResources() = default;
+
+// GetAvailableMemory
+//------------------------------------------------------------------------------
+bool WorkerResources::GetAvailableMemory( uint64_t & outAvailableBytes ) const
+{
+    #if defined( __LINUX__ )
+        // System wide availability
+        uint64_t available = 0;
+        if ( ReadMemInfo( available ) == false )
+        {
+            return false;
+        }
+
+        // Containers and systemd slices limit memory independently of the system
+        uint64_t headroom = 0;
+        if ( ReadCGroupHeadroom( headroom ) )
+        {
+            available = Math::Min( available, headroom );
+        }
+
+        outAvailableBytes = available;
+        return true;
+    #else
+        (void)outAvailableBytes;
+        return false; // Not implemented
+    #endif
+}
+
+// GetFreeDiskSpace
+//------------------------------------------------------------------------------
+/*static*/ bool WorkerResources::GetFreeDiskSpace( const AString & path, uint64_t & outFreeBytes )
+{
+    #if defined( __WINDOWS__ )
+        unsigned __int64 freeBytesAvailable = 0;
+        if ( GetDiskFreeSpaceExA( path.Get(), (PULARGE_INTEGER)&freeBytesAvailable, nullptr, nullptr ) == FALSE )
+        {
+            return false;
+        }
+        outFreeBytes = freeBytesAvailable;
+        return true;
+    #else
+        struct statvfs info;
+        if ( statvfs( path.Get(), &info ) != 0 )
+        {
+            return false;
+        }
+        outFreeBytes = ( (uint64_t)info.f_bavail * (uint64_t)info.f_frsize );
+        return true;
+    #endif
+}
+
+// CalcMemoryLimitedCPUs
+//------------------------------------------------------------------------------
+/*static*/ uint32_t WorkerResources::CalcMemoryLimitedCPUs( uint32_t numCPUs,
+                                                            uint32_t numActiveJobs,
+                                                            uint64_t availableMiB,
+                                                            uint64_t minFreeMiB,
+                                                            uint64_t memoryPerJobMiB )
+{
+    ASSERT( memoryPerJobMiB > 0 );
+
+    // How many more jobs can start without dipping below the minimum?
+    const uint64_t headroomMiB = ( availableMiB > minFreeMiB ) ? ( availableMiB - minFreeMiB ) : 0;
+    const uint64_t numNewJobs = ( headroomMiB / memoryPerJobMiB );
+
+    // Never take CPUs from jobs which are already running
+    const uint64_t numJobs = ( (uint64_t)numActiveJobs + numNewJobs );
+    return (uint32_t)Math::Min( (uint64_t)numCPUs, numJobs );
+}
+
+// CalcCPUScore
+//------------------------------------------------------------------------------
+/*static*/ uint32_t WorkerResources::CalcCPUScore()
+{
+    // Hashing throughput (MiB/s) on one core is a rough, but cheap and
+    // repeatable, measure of how quickly a worker will compile
+    const size_t bufferSize = MEGABYTE;
+    AutoPtr< uint8_t > buffer( (uint8_t *)ALLOC( bufferSize ) );
+    for ( size_t i = 0; i < bufferSize; ++i )
+    {
+        buffer.Get()[ i ] = (uint8_t)i;
+    }
+
+    uint64_t numMiB = 0;
+    volatile uint64_t hash = 0; // keep the work from being optimized away
+    Timer t;
+    do
+    {
+        hash = hash + xxHash::Calc64( buffer.Get(), bufferSize );
+        ++numMiB;
+    } while ( t.GetElapsedMS() < 20.0f );
+
+    const float elapsedSeconds = Math::Max( t.GetElapsed(), 0.001f );
+    return Math::Max( (uint32_t)( (float)numMiB / elapsedSeconds ), (uint32_t)1 );
+}
+
+// ReadMemInfo
+//------------------------------------------------------------------------------
+bool WorkerResources::ReadMemInfo( uint64_t & outAvailableBytes ) const
+{
+    AStackString< 4096 > memInfo;
+    if ( ReadSystemFile( "/proc/meminfo", memInfo ) == false )
+    {
+        return false;
+    }
+
+    // MemAvailable is the kernel's estimate, accounting for reclaimable caches
+    if ( ReadMemInfoValue( memInfo, "MemAvailable:", outAvailableBytes ) )
+    {
+        return true;
+    }
+
+    // Older kernels (pre 3.14) don't provide MemAvailable, so approximate it
+    uint64_t memFree = 0;
+    uint64_t buffers = 0;
+    uint64_t cached = 0;
+    if ( ReadMemInfoValue( memInfo, "MemFree:", memFree ) == false )
+    {
+        return false;
+    }
+    ReadMemInfoValue( memInfo, "Buffers:", buffers );
+    ReadMemInfoValue( memInfo, "Cached:", cached );
+    outAvailableBytes = ( memFree + buffers + cached );
+    return true;
+}
+
+// ReadCGroupHeadroom
+//------------------------------------------------------------------------------
+bool WorkerResources::ReadCGroupHeadroom( uint64_t & outHeadroomBytes ) const
+{
+    AStackString<> groupPath;
+    if ( GetCGroupPath( groupPath ) == false )
+    {
+        return false;
+    }
+
+    // Limits apply hierarchically, so check each level up to the root
+    bool foundLimit = false;
+    uint64_t headroom = 0;
+    for ( ;; )
+    {
+        // Remove trailing slash (the root becomes empty)
+        if ( groupPath.EndsWith( '/' ) )
+        {
+            groupPath.SetLength( groupPath.GetLength() - 1 );
+        }
+
+        AStackString<> maxPath;
+        maxPath.Format( "/sys/fs/cgroup%s/memory.max", groupPath.Get() );
+        AStackString<> maxContents;
+        uint64_t limit = 0;
+        if ( ReadSystemFile( maxPath.Get(), maxContents ) &&
+             ( sscanf( maxContents.Get(), "%llu", (unsigned long long *)&limit ) == 1 ) ) // "max" means no limit
+        {
+            AStackString<> currentPath;
+            currentPath.Format( "/sys/fs/cgroup%s/memory.current", groupPath.Get() );
+            AStackString<> currentContents;
+            uint64_t current = 0;
+            if ( ReadSystemFile( currentPath.Get(), currentContents ) )
+            {
+                sscanf( currentContents.Get(), "%llu", (unsigned long long *)&current );
+            }
+
+            const uint64_t levelHeadroom = ( limit > current ) ? ( limit - current ) : 0;
+            headroom = foundLimit ? Math::Min( headroom, levelHeadroom ) : levelHeadroom;
+            foundLimit = true;
+        }
+
+        // Move to parent
+        const char * lastSlash = groupPath.FindLast( '/' );
+        if ( lastSlash == nullptr )
+        {
+            break;
+        }
+        groupPath.SetLength( (uint32_t)( lastSlash - groupPath.Get() ) );
+    }
+
+    outHeadroomBytes = headroom;
+    return foundLimit;
+}
+
+// GetCGroupPath
+//------------------------------------------------------------------------------
+bool WorkerResources::GetCGroupPath( AString & outPath ) const
+{
+    // Find our cgroup v2 path (the "0::" entry)
+    AStackString< 4096 > cgroups;
+    if ( ReadSystemFile( "/proc/self/cgroup", cgroups ) == false )
+    {
+        return false;
+    }
+    const char * entry = cgroups.BeginsWith( "0::" ) ? cgroups.Get() : cgroups.Find( "\n0::" );
+    if ( entry == nullptr )
+    {
+        return false; // cgroup v1 only, or no cgroups
+    }
+    entry += ( *entry == '\n' ) ? 4 : 3;
+    const char * entryEnd = cgroups.Find( '\n', entry );
+    outPath.Assign( entry, entryEnd ? entryEnd : cgroups.GetEnd() );
+    return true;
+}
+
+// ReadSystemFile
+//------------------------------------------------------------------------------
+bool WorkerResources::ReadSystemFile( const char * relativePath, AString & outContents ) const
+{
+    AStackString<> fullPath( m_SystemRoot );
+    fullPath += relativePath;
+    return ReadVirtualFile( fullPath.Get(), outContents );
+}
+
+// ReadVirtualFile
+//------------------------------------------------------------------------------
+/*static*/ bool WorkerResources::ReadVirtualFile( const char * path, AString & outContents )
+{
+    FileStream f;
+    if ( f.Open( path, FileStream::READ_ONLY ) == false )
+    {
+        return false;
+    }
+
+    // NOTE: procfs and sysfs report a size of 0, so read until EOF
+    outContents.Clear();
+    char buffer[ 1024 ];
+    for ( ;; )
+    {
+        const uint32_t bytesRead = (uint32_t)f.ReadBuffer( buffer, sizeof( buffer ) );
+        if ( bytesRead == 0 )
+        {
+            break;
+        }
+        outContents.Append( buffer, bytesRead );
+    }
+    return true;
+}
+
+// ReadMemInfoValue
+//------------------------------------------------------------------------------
+/*static*/ bool WorkerResources::ReadMemInfoValue( const AString & memInfo, const char * key, uint64_t & outBytes )
+{
+    // Entries look like "MemAvailable:   12345678 kB"
+    const char * pos = memInfo.Find( key );
+    while ( pos && ( pos != memInfo.Get() ) && ( pos[ -1 ] != '\n' ) )
+    {
+        pos = memInfo.Find( key, pos + 1 ); // Only match at start of line
+    }
+    if ( pos == nullptr )
+    {
+        return false;
+    }
+
+    unsigned long long value = 0;
+    if ( sscanf( pos + AString::StrLen( key ), "%llu", &value ) != 1 )
+    {
+        return false;
+    }
+    outBytes = ( (uint64_t)value * 1024 ); // Values are in kB (KiB)
+    return true;
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,57 @@
+// WorkerResources - query memory and disk availability for worker admission
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Env/Types.h"
+#include "Core/Strings/AString.h"
+
+// WorkerResources
+//------------------------------------------------------------------------------
+// On Linux, memory availability is the smaller of /proc/meminfo MemAvailable
+// and the headroom under any cgroup v2 memory.max limits of this process. The
+// system root can be redirected so tests can provide a fake /proc and /sys.
+//------------------------------------------------------------------------------
+class WorkerResources
+{
+public:
+    explicit WorkerResources( const char * systemRoot = "" );
+    ~WorkerResources();
+
+    // Memory available to new processes, in bytes
+    bool GetAvailableMemory( uint64_t & outAvailableBytes ) const;
+
+    // Path of this process' cgroup v2 under /sys/fs/cgroup (e.g. "/system.slice/fbuild.service")
+    bool GetCGroupPath( AString & outPath ) const;
+
+    // Read a file relative to the system root
+    bool ReadSystemFile( const char * relativePath, AString & outContents ) const;
+    inline const AString & GetSystemRoot() const { return m_SystemRoot; }
+
+    // Read all of a file, including procfs and sysfs files which report no size
+    static bool ReadVirtualFile( const char * path, AString & outContents );
+
+    // Free space (for unprivileged users) of the volume containing path, in bytes
+    static bool GetFreeDiskSpace( const AString & path, uint64_t & outFreeBytes );
+
+    // Limit the number of CPUs offered so each new job has enough memory.
+    // Jobs already running have their memory accounted for in availableMiB.
+    static uint32_t CalcMemoryLimitedCPUs( uint32_t numCPUs,
+                                           uint32_t numActiveJobs,
+                                           uint64_t availableMiB,
+                                           uint64_t minFreeMiB,
+                                           uint64_t memoryPerJobMiB );
+
+    // Relative single core performance, from a short benchmark
+    static uint32_t CalcCPUScore();
+
+private:
+    bool ReadMemInfo( uint64_t & outAvailableBytes ) const;
+    bool ReadCGroupHeadroom( uint64_t & outHeadroomBytes ) const;
+    static bool ReadMemInfoValue( const AString & memInfo, const char * key, uint64_t & outBytes );
+
+    AString m_SystemRoot;
+};
+
+//------------------------------------------------------------------------------
@@ -11,6 +11,7 @@
 #include "Tools/FBuild/FBuildCore/Graph/Node.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/JobQueue.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/JobQueueRemote.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/MemoryStaging.h"
 
 // Core
 #include "Core/FileIO/FileIO.h"
@@ -242,6 +243,20 @@ void WorkerThread::WaitForStop()
 // GetTempFileDirectory
 //------------------------------------------------------------------------------
 /*static*/ void WorkerThread::GetTempFileDirectory( AString & tmpFileDirectory )
+{
+    // Remote jobs may be staged in memory
+    if ( MemoryStaging::IsThreadStagingInMemory() )
+    {
+        tmpFileDirectory.Format( "%score_%u%c", MemoryStaging::Get().GetRoot().Get(), WorkerThread::GetThreadIndex(), NATIVE_SLASH );
+        return;
+    }
+
+    GetDiskTempFileDirectory( tmpFileDirectory );
+}
+
+// GetDiskTempFileDirectory
+//------------------------------------------------------------------------------
+/*static*/ void WorkerThread::GetDiskTempFileDirectory( AString & tmpFileDirectory )
 {
     // get the index for the worker thread
     // (for the main thread, this will be 0 which is OK)
@@ -32,6 +32,7 @@ public:
     static uint32_t GetThreadIndex();
 
     static void GetTempFileDirectory( AString & tmpFileDirectory );
+    static void GetDiskTempFileDirectory( AString & tmpFileDirectory ); // never in memory (see MemoryStaging)
 
     static void CreateTempFilePath( const char * fileName,
                                     AString & tmpFileName );
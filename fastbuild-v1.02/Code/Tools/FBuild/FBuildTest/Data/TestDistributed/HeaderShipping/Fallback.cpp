@@ -0,0 +1,7 @@
+#define STRINGIFY( x ) #x
+#include STRINGIFY( Local.h )
+
+int Fallback()
+{
+    return LOCAL_VALUE;
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+#define DETAIL_VALUE 42
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "Detail.h" // found next to this header
+
+inline int Value()
+{
+    return DETAIL_VALUE;
+}
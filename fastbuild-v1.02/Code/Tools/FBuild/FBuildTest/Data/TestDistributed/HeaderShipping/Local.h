@@ -0,0 +1,3 @@
+#pragma once
+
+#define LOCAL_VALUE 1
@@ -0,0 +1,16 @@
+#ifndef SHARED_H
+#define SHARED_H
+
+#include "SharedDetail.h" // found next to this header
+
+// Only defined when creating the PCH, so users only compile if they use it
+#if __INCLUDE_LEVEL__ == 0
+    #define SHARED_FROM_PCH 1
+#endif
+
+inline int Shared()
+{
+    return SHARED_DETAIL_VALUE + SHARED_FROM_PCH;
+}
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef SHARED_DETAIL_H
+#define SHARED_DETAIL_H
+
+#define SHARED_DETAIL_VALUE 1
+
+#endif
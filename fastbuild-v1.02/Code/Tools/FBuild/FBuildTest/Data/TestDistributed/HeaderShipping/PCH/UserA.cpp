@@ -0,0 +1,6 @@
+#include "Shared.h"
+
+int UserA()
+{
+    return Shared();
+}
@@ -0,0 +1,6 @@
+#include "Shared.h"
+
+int UserB()
+{
+    return Shared() + 1;
+}
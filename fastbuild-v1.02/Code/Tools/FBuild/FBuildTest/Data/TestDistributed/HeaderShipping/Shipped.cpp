@@ -0,0 +1,13 @@
+#include "Local.h"
+#include <Lib/Value.h>
+#include <errno.h> // not shipped, but checked
+
+int Shipped()
+{
+    return Value() + LOCAL_VALUE;
+}
+
+const char * ShippedFile()
+{
+    return __FILE__;
+}
@@ -0,0 +1,2 @@
+// Initialized data makes for a large object file, which is streamed back in chunks
+char g_LargeOutput[ 3 * 1024 * 1024 ] = { 1 };
@@ -0,0 +1,4 @@
+int SmallA()
+{
+    return 0;
+}
@@ -0,0 +1,4 @@
+int SmallB()
+{
+    return 0;
+}
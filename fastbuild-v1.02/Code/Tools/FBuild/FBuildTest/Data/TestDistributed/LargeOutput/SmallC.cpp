@@ -0,0 +1,4 @@
+int SmallC()
+{
+    return 0;
+}
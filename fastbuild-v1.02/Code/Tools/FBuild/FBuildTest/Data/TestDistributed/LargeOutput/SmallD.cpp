@@ -0,0 +1,4 @@
+int SmallD()
+{
+    return 0;
+}
@@ -0,0 +1,4 @@
+int FunctionA()
+{
+    return 0;
+}
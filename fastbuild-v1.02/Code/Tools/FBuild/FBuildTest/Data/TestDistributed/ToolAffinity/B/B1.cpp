@@ -0,0 +1,4 @@
+int FunctionB1()
+{
+    return 0;
+}
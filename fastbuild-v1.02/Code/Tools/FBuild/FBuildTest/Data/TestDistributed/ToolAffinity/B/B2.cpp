@@ -0,0 +1,4 @@
+int FunctionB2()
+{
+    return 0;
+}
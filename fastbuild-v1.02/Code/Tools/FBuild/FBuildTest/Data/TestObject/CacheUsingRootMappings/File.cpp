@@ -0,0 +1,6 @@
+#include "Subdir/Header.h"
+
+int Function()
+{
+    return GetValue(); // From included header
+}
@@ -0,0 +1,4 @@
+inline int GetValue()
+{
+    return 1;
+}
@@ -0,0 +1,21 @@
+//
+// An simple executable to run as a sharded test, reporting which shard it is
+//
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined( _MSC_VER )
+    #pragma warning( disable : 4996 ) // getenv may be unsafe
+#endif
+
+int main(int, char **)
+{
+    const char * totalShards = getenv( "GTEST_TOTAL_SHARDS" );
+    const char * shardIndex = getenv( "GTEST_SHARD_INDEX" );
+    if ( ( totalShards == nullptr ) || ( shardIndex == nullptr ) )
+    {
+        return 1; // not run as a shard
+    }
+    printf( "Shard %s of %s\n", shardIndex, totalShards );
+    return 0;
+}
@@ -0,0 +1,6 @@
+#include "string.h"
+
+const char * TraceFunctionA()
+{
+    return "TraceFunctionAString";
+}
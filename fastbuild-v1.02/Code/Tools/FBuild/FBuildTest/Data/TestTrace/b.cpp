@@ -0,0 +1,6 @@
+#include "string.h"
+
+const char * TraceFunctionB()
+{
+    return "TraceFunctionBString";
+}
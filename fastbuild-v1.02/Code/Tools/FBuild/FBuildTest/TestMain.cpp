@@ -13,7 +13,11 @@ int main( int, char *[] )
     REGISTER_TESTGROUP( TestAlias )
     REGISTER_TESTGROUP( TestArgs )
     REGISTER_TESTGROUP( TestBFFParsing )
+    REGISTER_TESTGROUP( TestBFFTokenCache )
+    REGISTER_TESTGROUP( TestBroker )
     REGISTER_TESTGROUP( TestBuildAndLinkLibrary )
+    REGISTER_TESTGROUP( TestBuildMetrics )
+    REGISTER_TESTGROUP( TestBuildTrace )
     REGISTER_TESTGROUP( TestBuildFBuild )
     REGISTER_TESTGROUP( TestCache )
     REGISTER_TESTGROUP( TestCachePlugin )
@@ -30,8 +34,10 @@ int main( int, char *[] )
     REGISTER_TESTGROUP( TestGraph )
     REGISTER_TESTGROUP( TestIf )
     REGISTER_TESTGROUP( TestIncludeParser )
+    REGISTER_TESTGROUP( TestJobTables )
     REGISTER_TESTGROUP( TestLibrary )
     REGISTER_TESTGROUP( TestLinker )
+    REGISTER_TESTGROUP( TestMonitorStream )
     REGISTER_TESTGROUP( TestNodeReflection )
     REGISTER_TESTGROUP( TestObject )
     REGISTER_TESTGROUP( TestObjectList )
@@ -40,10 +46,14 @@ int main( int, char *[] )
     REGISTER_TESTGROUP( TestRemoveDir )
     REGISTER_TESTGROUP( TestTest )
     REGISTER_TESTGROUP( TestTextFile )
+    REGISTER_TESTGROUP( TestToolManifest )
     REGISTER_TESTGROUP( TestUnity )
     REGISTER_TESTGROUP( TestUserFunctions )
     REGISTER_TESTGROUP( TestVariableStack )
     REGISTER_TESTGROUP( TestWarnings )
+    REGISTER_TESTGROUP( TestWorkerCGroups )
+    REGISTER_TESTGROUP( TestWorkerCPUSlots )
+    REGISTER_TESTGROUP( TestWorkerResources )
 
     // Windows-specific tests
     #if defined( __WINDOWS__ )
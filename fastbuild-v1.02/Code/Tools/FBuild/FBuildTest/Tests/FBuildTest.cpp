@@ -265,6 +265,9 @@ FBuildTestOptions::FBuildTestOptions()
 
     // Ensure any distributed compilation tests use the test port
     m_DistributionPort = Protocol::PROTOCOL_TEST_PORT;
+
+    // Avoid writing token caches next to test data (tests opt-in explicitly)
+    m_UseBFFTokenCache = false;
 }
 
 // GetRecursiveDependencyCount
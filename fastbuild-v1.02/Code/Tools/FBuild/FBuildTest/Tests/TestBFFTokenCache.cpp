@@ -0,0 +1,296 @@
+// TestBFFTokenCache.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "FBuildTest.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/BFF/Tokenizer/BFFTokenizer.h"
+#include "Tools/FBuild/FBuildCore/FBuild.h"
+
+// Core
+#include "Core/Env/Env.h"
+#include "Core/FileIO/FileIO.h"
+#include "Core/Strings/AStackString.h"
+
+// TestBFFTokenCache
+//------------------------------------------------------------------------------
+class TestBFFTokenCache : public FBuildTest
+{
+private:
+    DECLARE_TESTS
+
+    void Reuse() const;
+    void ChangedInclude() const;
+    void ChangedEnvVar() const;
+    void Corrupt() const;
+    void Option() const;
+
+    // Helpers
+    void PrepareFiles() const;
+    void Tokenize( BFFTokenizer & tokenizer, bool useCache ) const;
+    void Tokenize( bool useCache, AString & outTokens ) const;
+    void DescribeTokens( const BFFTokenizer & tokenizer, AString & outTokens ) const;
+
+    const char * const mDataDir = "Tools/FBuild/FBuildTest/Data/TestBFFTokenCache/";
+    const char * const mTestDir = "../tmp/Test/BFFTokenCache/";
+    const char * const mRootFile = "../tmp/Test/BFFTokenCache/fbuild.bff";
+    const char * const mCacheFile = "../tmp/Test/BFFTokenCache/fbuild.bffcache";
+    const char * const mDBFile = "../tmp/Test/BFFTokenCache/fbuild.fdb";
+    const char * const mEnvVar = "BFF_TOKEN_CACHE_TEST_VAR";
+
+    TestBFFTokenCache & operator = ( TestBFFTokenCache & other ) = delete; // Avoid warnings about implicit deletion of operators
+};
+
+// Register Tests
+//------------------------------------------------------------------------------
+REGISTER_TESTS_BEGIN( TestBFFTokenCache )
+    REGISTER_TEST( Reuse )
+    REGISTER_TEST( ChangedInclude )
+    REGISTER_TEST( ChangedEnvVar )
+    REGISTER_TEST( Corrupt )
+    REGISTER_TEST( Option )
+REGISTER_TESTS_END
+
+// Reuse
+//------------------------------------------------------------------------------
+void TestBFFTokenCache::Reuse() const
+{
+    FBuild fBuild; // needed for exists() and file_exists()
+    PrepareFiles();
+
+    // Populate cache
+    {
+        BFFTokenizer tokenizer;
+        Tokenize( tokenizer, true );
+        TEST_ASSERT( tokenizer.GetCache()->GetNumHits() == 0 );
+        TEST_ASSERT( tokenizer.GetCache()->GetNumMisses() == 3 );
+        EnsureFileExists( mCacheFile );
+    }
+
+    // Re-use cache - tokens must be identical to tokenizing from scratch
+    AString cachedTokens;
+    {
+        BFFTokenizer cached;
+        Tokenize( cached, true );
+        TEST_ASSERT( cached.GetCache()->GetNumHits() == 3 );
+        TEST_ASSERT( cached.GetCache()->GetNumMisses() == 0 );
+        TEST_ASSERT( cached.GetUsedFiles().GetSize() == 3 );
+        DescribeTokens( cached, cachedTokens );
+    }
+    AString uncachedTokens;
+    Tokenize( false, uncachedTokens );
+    TEST_ASSERT( cachedTokens == uncachedTokens );
+}
+
+// ChangedInclude
+//------------------------------------------------------------------------------
+void TestBFFTokenCache::ChangedInclude() const
+{
+    FBuild fBuild; // needed for exists() and file_exists()
+    PrepareFiles();
+
+    // Populate cache
+    {
+        BFFTokenizer tokenizer;
+        Tokenize( tokenizer, true );
+    }
+
+    // Modify one include
+    AStackString<> otherFile( mTestDir );
+    otherFile += "other.bff";
+    AString contents;
+    LoadFileContentsAsString( otherFile.Get(), contents );
+    contents += "\n.Modified = true\n";
+    MakeFile( otherFile.Get(), contents.Get() );
+
+    // Modified file and file including it are tokenized, but other files are not
+    AString cachedTokens;
+    {
+        BFFTokenizer cached;
+        Tokenize( cached, true );
+        TEST_ASSERT( cached.GetCache()->GetNumHits() == 1 );
+        TEST_ASSERT( cached.GetCache()->GetNumMisses() == 2 );
+        DescribeTokens( cached, cachedTokens );
+    }
+    AString uncachedTokens;
+    Tokenize( false, uncachedTokens );
+    TEST_ASSERT( cachedTokens == uncachedTokens );
+
+    // Everything is re-used again
+    {
+        BFFTokenizer cached;
+        Tokenize( cached, true );
+        TEST_ASSERT( cached.GetCache()->GetNumHits() == 3 );
+        TEST_ASSERT( cached.GetCache()->GetNumMisses() == 0 );
+    }
+}
+
+// ChangedEnvVar
+//------------------------------------------------------------------------------
+void TestBFFTokenCache::ChangedEnvVar() const
+{
+    PrepareFiles();
+
+    // Populate cache
+    {
+        FBuild fBuild; // needed for exists() and file_exists()
+        BFFTokenizer tokenizer;
+        Tokenize( tokenizer, true );
+    }
+
+    // Change imported environment variable
+    Env::SetEnvVariable( mEnvVar, AStackString<>( "Changed" ) );
+
+    // File importing the variable (and file including it) are tokenized again
+    FBuild fBuild; // imported variables can't change during the lifetime of an FBuild
+    AString cachedTokens;
+    {
+        BFFTokenizer cached;
+        Tokenize( cached, true );
+        TEST_ASSERT( cached.GetCache()->GetNumHits() == 1 );
+        TEST_ASSERT( cached.GetCache()->GetNumMisses() == 2 );
+        DescribeTokens( cached, cachedTokens );
+    }
+    AString uncachedTokens;
+    Tokenize( false, uncachedTokens );
+    TEST_ASSERT( cachedTokens == uncachedTokens );
+}
+
+// Corrupt
+//------------------------------------------------------------------------------
+void TestBFFTokenCache::Corrupt() const
+{
+    FBuild fBuild; // needed for exists() and file_exists()
+    PrepareFiles();
+
+    // Populate cache
+    {
+        BFFTokenizer tokenizer;
+        Tokenize( tokenizer, true );
+    }
+
+    // Truncate cache
+    AString contents;
+    LoadFileContentsAsString( mCacheFile, contents );
+    contents.SetLength( contents.GetLength() / 2 );
+    MakeFile( mCacheFile, contents.Get() );
+
+    // Cache is ignored and re-written
+    AString cachedTokens;
+    {
+        BFFTokenizer cached;
+        Tokenize( cached, true );
+        TEST_ASSERT( cached.GetCache()->GetNumHits() == 0 );
+        TEST_ASSERT( cached.GetCache()->GetNumMisses() == 3 );
+        DescribeTokens( cached, cachedTokens );
+    }
+    AString uncachedTokens;
+    Tokenize( false, uncachedTokens );
+    TEST_ASSERT( cachedTokens == uncachedTokens );
+    {
+        BFFTokenizer cached;
+        Tokenize( cached, true );
+        TEST_ASSERT( cached.GetCache()->GetNumHits() == 3 );
+    }
+}
+
+// Option
+//------------------------------------------------------------------------------
+void TestBFFTokenCache::Option() const
+{
+    PrepareFiles();
+
+    AStackString<> cacheFile( mDBFile );
+    cacheFile += ".bffcache";
+
+    FBuildTestOptions options;
+    options.m_ConfigFile = mRootFile;
+
+    // Disabled
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( mDBFile ) );
+        EnsureFileDoesNotExist( cacheFile );
+    }
+
+    // Enabled - cache is stored alongside DB
+    options.m_UseBFFTokenCache = true;
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( mDBFile ) );
+        EnsureFileExists( cacheFile );
+    }
+}
+
+// PrepareFiles
+//------------------------------------------------------------------------------
+void TestBFFTokenCache::PrepareFiles() const
+{
+    // Copy files so they can be modified
+    TEST_ASSERT( FileIO::EnsurePathExists( AStackString<>( mTestDir ) ) );
+    const char * files[] = { "fbuild.bff", "common.bff", "other.bff" };
+    for ( const char * file : files )
+    {
+        AStackString<> src( mDataDir );
+        src += file;
+        AStackString<> dst( mTestDir );
+        dst += file;
+        TEST_ASSERT( FileIO::FileCopy( src.Get(), dst.Get() ) );
+    }
+
+    // Clear state from previous tests
+    FileIO::FileDelete( mCacheFile );
+    FileIO::FileDelete( mDBFile );
+    AStackString<> dbCacheFile( mDBFile );
+    dbCacheFile += ".bffcache";
+    FileIO::FileDelete( dbCacheFile.Get() );
+
+    Env::SetEnvVariable( mEnvVar, AStackString<>( "Value" ) );
+}
+
+// Tokenize
+//------------------------------------------------------------------------------
+void TestBFFTokenCache::Tokenize( BFFTokenizer & tokenizer, bool useCache ) const
+{
+    if ( useCache )
+    {
+        tokenizer.LoadCache( AStackString<>( mCacheFile ) );
+    }
+    TEST_ASSERT( tokenizer.TokenizeFromFile( AStackString<>( mRootFile ), nullptr ) );
+    if ( useCache )
+    {
+        TEST_ASSERT( tokenizer.SaveCache() );
+    }
+}
+
+// Tokenize
+//------------------------------------------------------------------------------
+void TestBFFTokenCache::Tokenize( bool useCache, AString & outTokens ) const
+{
+    // NOTE: Only one BFFTokenizer can exist at a time (BFFMacros is a singleton)
+    BFFTokenizer tokenizer;
+    Tokenize( tokenizer, useCache );
+    DescribeTokens( tokenizer, outTokens );
+}
+
+// DescribeTokens
+//------------------------------------------------------------------------------
+void TestBFFTokenCache::DescribeTokens( const BFFTokenizer & tokenizer, AString & outTokens ) const
+{
+    for ( const BFFToken & token : tokenizer.GetTokens() )
+    {
+        // Error reporting relies on the position within the file
+        const uint32_t offset = (uint32_t)( token.GetSourcePos() - token.GetSourceFileContents().Get() );
+        outTokens.AppendFormat( "%u|%s|%s|%u|%i|%u\n", (uint32_t)token.GetType(),
+                                                       token.GetValueString().Get(),
+                                                       token.GetSourceFileName().Get(),
+                                                       offset,
+                                                       token.GetValueInt(),
+                                                       (uint32_t)token.GetBoolean() );
+    }
+    TEST_ASSERT( outTokens.IsEmpty() == false );
+}
+
+//------------------------------------------------------------------------------
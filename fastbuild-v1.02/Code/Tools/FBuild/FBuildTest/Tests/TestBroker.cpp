@@ -0,0 +1,279 @@
+// TestBroker.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "FBuildTest.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/Protocol/Broker.h"
+#include "Tools/FBuild/FBuildCore/Protocol/BrokerConnection.h"
+#include "Tools/FBuild/FBuildCore/Protocol/Protocol.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/WorkerBrokerage.h"
+
+// Core
+#include "Core/Env/Env.h"
+#include "Core/Network/Network.h"
+#include "Core/Process/Thread.h"
+#include "Core/Strings/AStackString.h"
+#include "Core/Time/Timer.h"
+
+// Defines
+//------------------------------------------------------------------------------
+#define TEST_BROKER_PORT ( Protocol::BROKER_PORT + 1 ) // Avoid conflict with real broker
+
+// TestBroker
+//------------------------------------------------------------------------------
+class TestBroker : public FBuildTest
+{
+private:
+    DECLARE_TESTS
+
+    void Ranking() const;
+    void Disconnect() const;
+    void StaleHeartbeat() const;
+    void Brokerage() const;
+    void BrokerageFallback() const;
+
+    // Helpers
+    static bool WaitForWorkers( const Broker & broker, size_t numWorkers, Array< BrokerWorkerInfo > & outWorkers );
+    static BrokerWorkerInfo MakeInfo( const char * hostName, uint32_t numCPUs, uint32_t numFreeSlots, uint32_t cpuScore );
+};
+
+// Register Tests
+//------------------------------------------------------------------------------
+REGISTER_TESTS_BEGIN( TestBroker )
+    REGISTER_TEST( Ranking )
+    REGISTER_TEST( Disconnect )
+    REGISTER_TEST( StaleHeartbeat )
+    REGISTER_TEST( Brokerage )
+    REGISTER_TEST( BrokerageFallback )
+REGISTER_TESTS_END
+
+// Ranking
+//------------------------------------------------------------------------------
+void TestBroker::Ranking() const
+{
+    Broker broker;
+    TEST_ASSERT( broker.Listen( TEST_BROKER_PORT ) );
+
+    AStackString<> host( "127.0.0.1" );
+    BrokerConnection workerA( host, TEST_BROKER_PORT );
+    BrokerConnection workerB( host, TEST_BROKER_PORT );
+    BrokerConnection workerC( host, TEST_BROKER_PORT );
+    BrokerConnection workerD( host, TEST_BROKER_PORT );
+    TEST_ASSERT( workerA.SendHeartbeat( MakeInfo( "WorkerA", 8, 2, 1000 ) ) );  // 2 free slow CPUs
+    TEST_ASSERT( workerB.SendHeartbeat( MakeInfo( "WorkerB", 4, 4, 2000 ) ) );  // 4 free fast CPUs
+    TEST_ASSERT( workerC.SendHeartbeat( MakeInfo( "WorkerC", 16, 0, 3000 ) ) ); // busy
+    TEST_ASSERT( workerD.SendHeartbeat( MakeInfo( "WorkerD", 0, 0, 3000 ) ) );  // unavailable
+
+    // Unavailable workers are not offered
+    Array< BrokerWorkerInfo > workers( 0, true );
+    TEST_ASSERT( WaitForWorkers( broker, 3, workers ) );
+
+    // Clients get the most free compute first
+    BrokerConnection client( host, TEST_BROKER_PORT );
+    workers.Clear();
+    TEST_ASSERT( client.RequestWorkers( workers ) );
+    TEST_ASSERT( workers.GetSize() == 3 );
+    TEST_ASSERT( workers[ 0 ].m_HostName == "WorkerB" );
+    TEST_ASSERT( workers[ 1 ].m_HostName == "WorkerA" );
+    TEST_ASSERT( workers[ 2 ].m_HostName == "WorkerC" );
+
+    // Status is passed through
+    TEST_ASSERT( workers[ 0 ].m_NumCPUs == 4 );
+    TEST_ASSERT( workers[ 0 ].m_CPUScore == 2000 );
+    TEST_ASSERT( workers[ 0 ].m_ToolIds.GetSize() == 1 );
+    TEST_ASSERT( workers[ 0 ].m_ToolIds[ 0 ] == 0x1234 );
+
+    // Updates replace what was reported before
+    TEST_ASSERT( workerC.SendHeartbeat( MakeInfo( "WorkerC", 16, 16, 3000 ) ) );
+    Timer t;
+    for ( ;; )
+    {
+        workers.Clear();
+        TEST_ASSERT( client.RequestWorkers( workers ) );
+        TEST_ASSERT( workers.GetSize() == 3 );
+        if ( workers[ 0 ].m_HostName == "WorkerC" )
+        {
+            break;
+        }
+        TEST_ASSERT( t.GetElapsed() < 5.0f );
+        Thread::Sleep( 10 );
+    }
+}
+
+// Disconnect
+//------------------------------------------------------------------------------
+void TestBroker::Disconnect() const
+{
+    Broker broker;
+    TEST_ASSERT( broker.Listen( TEST_BROKER_PORT ) );
+
+    AStackString<> host( "127.0.0.1" );
+    BrokerConnection workerA( host, TEST_BROKER_PORT );
+    TEST_ASSERT( workerA.SendHeartbeat( MakeInfo( "WorkerA", 8, 8, 1000 ) ) );
+    Array< BrokerWorkerInfo > workers( 0, true );
+    {
+        BrokerConnection workerB( host, TEST_BROKER_PORT );
+        TEST_ASSERT( workerB.SendHeartbeat( MakeInfo( "WorkerB", 8, 8, 1000 ) ) );
+        TEST_ASSERT( WaitForWorkers( broker, 2, workers ) );
+    }
+
+    // A worker is forgotten as soon as its connection closes
+    TEST_ASSERT( WaitForWorkers( broker, 1, workers ) );
+    TEST_ASSERT( workers[ 0 ].m_HostName == "WorkerA" );
+}
+
+// StaleHeartbeat
+//------------------------------------------------------------------------------
+void TestBroker::StaleHeartbeat() const
+{
+    Broker broker( 0.5f ); // short heartbeat timeout
+    TEST_ASSERT( broker.Listen( TEST_BROKER_PORT ) );
+
+    AStackString<> host( "127.0.0.1" );
+    BrokerConnection worker( host, TEST_BROKER_PORT );
+    TEST_ASSERT( worker.SendHeartbeat( MakeInfo( "WorkerA", 8, 8, 1000 ) ) );
+    Array< BrokerWorkerInfo > workers( 0, true );
+    TEST_ASSERT( WaitForWorkers( broker, 1, workers ) );
+
+    // A worker which stops sending heartbeats is not offered, even if connected
+    Thread::Sleep( 1000 );
+    workers.Clear();
+    broker.GetWorkers( workers );
+    TEST_ASSERT( workers.IsEmpty() );
+
+    // until it sends another
+    TEST_ASSERT( worker.SendHeartbeat( MakeInfo( "WorkerA", 8, 8, 1000 ) ) );
+    TEST_ASSERT( WaitForWorkers( broker, 1, workers ) );
+}
+
+// Brokerage
+//------------------------------------------------------------------------------
+void TestBroker::Brokerage() const
+{
+    Broker broker;
+    TEST_ASSERT( broker.Listen( TEST_BROKER_PORT ) );
+
+    AStackString<> brokerAddress;
+    brokerAddress.Format( "127.0.0.1:%u", (uint32_t)TEST_BROKER_PORT );
+    Env::SetEnvVariable( "FASTBUILD_BROKER", brokerAddress );
+
+    // A worker registers itself
+    Array< BrokerWorkerInfo > workers( 0, true );
+    {
+        WorkerBrokerage worker;
+        Array< uint64_t > toolIds( 0, true );
+        toolIds.Append( 0x1234 );
+        worker.SetBrokerStatus( 8, 6, toolIds );
+        worker.SetAvailability( true );
+        TEST_ASSERT( WaitForWorkers( broker, 1, workers ) );
+
+        AStackString<> hostName;
+        Network::GetHostName( hostName );
+        TEST_ASSERT( workers[ 0 ].m_HostName == hostName );
+        TEST_ASSERT( workers[ 0 ].m_NumCPUs == 8 );
+        TEST_ASSERT( workers[ 0 ].m_NumFreeSlots == 6 );
+        TEST_ASSERT( workers[ 0 ].m_CPUScore > 0 );
+        TEST_ASSERT( workers[ 0 ].m_ToolIds.GetSize() == 1 );
+
+        // Becoming unavailable is reported right away
+        worker.SetAvailability( false );
+        TEST_ASSERT( WaitForWorkers( broker, 0, workers ) );
+    }
+
+    // Clients find workers through the broker, excluding themselves
+    AStackString<> host( "127.0.0.1" );
+    BrokerConnection otherWorker( host, TEST_BROKER_PORT );
+    TEST_ASSERT( otherWorker.SendHeartbeat( MakeInfo( "OtherWorker", 8, 8, 1000 ) ) );
+    TEST_ASSERT( WaitForWorkers( broker, 1, workers ) );
+    {
+        WorkerBrokerage client;
+        Array< AString > workerList;
+        client.FindWorkers( workerList );
+        TEST_ASSERT( client.WorkersCameFromBroker() );
+        TEST_ASSERT( client.GetBrokerAddress() == brokerAddress );
+        TEST_ASSERT( workerList.GetSize() == 1 );
+        TEST_ASSERT( workerList[ 0 ] == "OtherWorker" );
+    }
+
+    Env::SetEnvVariable( "FASTBUILD_BROKER", AString::GetEmpty() );
+}
+
+// BrokerageFallback
+//------------------------------------------------------------------------------
+void TestBroker::BrokerageFallback() const
+{
+    // No broker listening
+    AStackString<> brokerAddress;
+    brokerAddress.Format( "127.0.0.1:%u", (uint32_t)TEST_BROKER_PORT );
+    Env::SetEnvVariable( "FASTBUILD_BROKER", brokerAddress );
+
+    // Clients fall back to the brokerage folder (none here)
+    {
+        WorkerBrokerage client;
+        Array< AString > workerList;
+        client.FindWorkers( workerList );
+        TEST_ASSERT( client.WorkersCameFromBroker() == false );
+        TEST_ASSERT( workerList.IsEmpty() );
+    }
+
+    // Including when a broker is reachable, but has no workers
+    {
+        Broker broker;
+        TEST_ASSERT( broker.Listen( TEST_BROKER_PORT ) );
+
+        WorkerBrokerage client;
+        Array< AString > workerList;
+        client.FindWorkers( workerList );
+        TEST_ASSERT( client.WorkersCameFromBroker() == false );
+        TEST_ASSERT( workerList.IsEmpty() );
+    }
+
+    // Workers keep working without one
+    {
+        WorkerBrokerage worker;
+        worker.SetAvailability( true );
+        worker.SetAvailability( false );
+    }
+
+    Env::SetEnvVariable( "FASTBUILD_BROKER", AString::GetEmpty() );
+}
+
+// WaitForWorkers
+//------------------------------------------------------------------------------
+/*static*/ bool TestBroker::WaitForWorkers( const Broker & broker, size_t numWorkers, Array< BrokerWorkerInfo > & outWorkers )
+{
+    // heartbeats are processed asynchronously
+    Timer t;
+    for ( ;; )
+    {
+        outWorkers.Clear();
+        broker.GetWorkers( outWorkers );
+        if ( outWorkers.GetSize() == numWorkers )
+        {
+            return true;
+        }
+        if ( t.GetElapsed() > 5.0f )
+        {
+            return false;
+        }
+        Thread::Sleep( 10 );
+    }
+}
+
+// MakeInfo
+//------------------------------------------------------------------------------
+/*static*/ BrokerWorkerInfo TestBroker::MakeInfo( const char * hostName, uint32_t numCPUs, uint32_t numFreeSlots, uint32_t cpuScore )
+{
+    BrokerWorkerInfo info;
+    info.m_HostName = hostName;
+    info.m_NumCPUs = numCPUs;
+    info.m_NumFreeSlots = numFreeSlots;
+    info.m_CPUScore = cpuScore;
+    info.m_ToolIds.Append( (uint64_t)0x1234 );
+    return info;
+}
+
+//------------------------------------------------------------------------------
@@ -6,8 +6,10 @@
 #include "FBuildTest.h"
 
 #include "Tools/FBuild/FBuildCore/FBuild.h"
+#include "Tools/FBuild/FBuildCore/Graph/LibraryNode.h"
 
 #include "Core/FileIO/FileIO.h"
+#include "Core/FileIO/FileStream.h"
 #include "Core/Strings/AStackString.h"
 
 // TestBuildAndLinkLibrary
@@ -25,6 +27,9 @@ private:
     void TestLibMerge_NoRebuild() const;
     void TestLibMerge_NoRebuild_BFFChange() const;
     void DeleteFile() const;
+    #if !defined( __WINDOWS__ )
+        void Incremental() const;
+    #endif
 
     const char * GetBuildLibDBFileName() const { return "../tmp/Test/BuildAndLinkLibrary/buildlib.fdb"; }
     const char * GetMergeLibDBFileName() const { return "../tmp/Test/BuildAndLinkLibrary/mergelib.fdb"; }
@@ -41,6 +46,9 @@ REGISTER_TESTS_BEGIN( TestBuildAndLinkLibrary )
     REGISTER_TEST( TestLibMerge_NoRebuild )
     REGISTER_TEST( TestLibMerge_NoRebuild_BFFChange )
     REGISTER_TEST( DeleteFile )
+    #if !defined( __WINDOWS__ ) // Incremental updates are only supported with ar
+        REGISTER_TEST( Incremental )
+    #endif
 REGISTER_TESTS_END
 
 // TestStackFramesEmpty
@@ -304,4 +312,105 @@ void TestBuildAndLinkLibrary::DeleteFile() const
     }
 }
 
+// Incremental
+//------------------------------------------------------------------------------
+//  - Ensure only changed members are replaced, and removal triggers a full rebuild
+#if !defined( __WINDOWS__ )
+void TestBuildAndLinkLibrary::Incremental() const
+{
+    const char * fileA = "../tmp/Test/BuildAndLinkLibrary/Incremental/GeneratedInput/FileA.cpp";
+    const char * fileB = "../tmp/Test/BuildAndLinkLibrary/Incremental/GeneratedInput/FileB.cpp";
+    const char * fileC = "../tmp/Test/BuildAndLinkLibrary/Incremental/GeneratedInput/FileC.cpp";
+    const char * lib = "../tmp/Test/BuildAndLinkLibrary/Incremental/test.lib";
+    const char * database = "../tmp/Test/BuildAndLinkLibrary/Incremental/fbuild.fdb";
+
+    // Each file exports a function with a unique name
+    EnsureDirExists( "../tmp/Test/BuildAndLinkLibrary/Incremental/GeneratedInput/" );
+    const char * const files[] = { fileA, fileB, fileC };
+    const char * const functions[] = { "extern \"C\" int FileA_v1() { return 1; }\n",
+                                       "extern \"C\" int FileB_v1() { return 1; }\n",
+                                       "extern \"C\" int FileC_v1() { return 1; }\n" };
+    for ( size_t i = 0; i < 3; ++i )
+    {
+        FileStream f;
+        TEST_ASSERT( f.Open( files[ i ], FileStream::WRITE_ONLY ) );
+        f.WriteBuffer( functions[ i ], AString::StrLen( functions[ i ] ) );
+    }
+
+    // Full build
+    {
+        FBuildTestOptions options;
+        options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestBuildAndLinkLibrary/Incremental/fbuild.bff";
+        options.m_ForceCleanBuild = true;
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "TestLib" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( database ) );
+
+        const LibraryNode * libNode = fBuild.GetNode( "TestLib" )->GetStaticDependencies()[ 0 ].GetNode()->CastTo< LibraryNode >();
+        TEST_ASSERT( libNode->GetNumMembers() == 3 );
+        TEST_ASSERT( libNode->GetNumMembersUpdated() == 0 );
+    }
+
+    // Change one file
+    {
+        FileStream f;
+        TEST_ASSERT( f.Open( fileB, FileStream::WRITE_ONLY ) );
+        const char * newFunction = "extern \"C\" int FileB_v2() { return 2; }\n";
+        f.WriteBuffer( newFunction, AString::StrLen( newFunction ) );
+    }
+
+    // Only the changed member is replaced
+    {
+        FBuildTestOptions options;
+        options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestBuildAndLinkLibrary/Incremental/fbuild.bff";
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( database ) );
+        TEST_ASSERT( fBuild.Build( "TestLib" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( database ) );
+
+        CheckStatsNode( 3,      1,      Node::OBJECT_NODE );
+        CheckStatsNode( 1,      1,      Node::LIBRARY_NODE );
+
+        const LibraryNode * libNode = fBuild.GetNode( "TestLib" )->GetStaticDependencies()[ 0 ].GetNode()->CastTo< LibraryNode >();
+        TEST_ASSERT( libNode->GetNumMembers() == 3 );
+        TEST_ASSERT( libNode->GetNumMembersUpdated() == 1 );
+
+        // Symbols come from the new object, and the others are retained
+        AString libContents;
+        FileStream f;
+        TEST_ASSERT( f.Open( lib, FileStream::READ_ONLY ) );
+        libContents.SetLength( (uint32_t)f.GetFileSize() );
+        TEST_ASSERT( f.ReadBuffer( libContents.Get(), libContents.GetLength() ) == libContents.GetLength() );
+        TEST_ASSERT( libContents.Find( "FileA_v1" ) );
+        TEST_ASSERT( libContents.Find( "FileB_v1" ) == nullptr );
+        TEST_ASSERT( libContents.Find( "FileB_v2" ) );
+        TEST_ASSERT( libContents.Find( "FileC_v1" ) );
+    }
+
+    // Remove a file
+    EnsureFileDoesNotExist( fileC );
+
+    // The library is rebuilt in full, without the removed member
+    {
+        FBuildTestOptions options;
+        options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestBuildAndLinkLibrary/Incremental/fbuild.bff";
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( database ) );
+        TEST_ASSERT( fBuild.Build( "TestLib" ) );
+
+        const LibraryNode * libNode = fBuild.GetNode( "TestLib" )->GetStaticDependencies()[ 0 ].GetNode()->CastTo< LibraryNode >();
+        TEST_ASSERT( libNode->GetNumMembers() == 2 );
+        TEST_ASSERT( libNode->GetNumMembersUpdated() == 0 );
+
+        AString libContents;
+        FileStream f;
+        TEST_ASSERT( f.Open( lib, FileStream::READ_ONLY ) );
+        libContents.SetLength( (uint32_t)f.GetFileSize() );
+        TEST_ASSERT( f.ReadBuffer( libContents.Get(), libContents.GetLength() ) == libContents.GetLength() );
+        TEST_ASSERT( libContents.Find( "FileC_v1" ) == nullptr );
+    }
+}
+#endif
+
 //------------------------------------------------------------------------------
@@ -0,0 +1,246 @@
+// TestBuildMetrics.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "FBuildTest.h"
+
+// FBuild
+#include "Tools/FBuild/FBuildCore/FBuild.h"
+#include "Tools/FBuild/FBuildCore/Graph/Node.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildMetrics.h"
+#include "Tools/FBuild/FBuildCore/Protocol/Protocol.h"
+#include "Tools/FBuild/FBuildCore/Protocol/Server.h"
+
+// Core
+#include "Core/Strings/AStackString.h"
+
+// Defines
+//------------------------------------------------------------------------------
+#define TEST_PROTOCOL_PORT ( Protocol::PROTOCOL_PORT + 1 ) // Avoid conflict with real worker
+
+// TestBuildMetrics
+//------------------------------------------------------------------------------
+class TestBuildMetrics : public FBuildTest
+{
+private:
+    DECLARE_TESTS
+
+    void Histogram() const;
+    void Cache() const;
+    void Distributed() const;
+    void Output() const;
+    void MemoryBudget() const;
+
+    const char * const mConfigFile = "Tools/FBuild/FBuildTest/Data/TestMetrics/fbuild.bff";
+    const char * const mMetricsFile = "../tmp/Test/Metrics/metrics.json";
+    const char * const mPrometheusFile = "../tmp/Test/Metrics/metrics.prom";
+
+    TestBuildMetrics & operator = ( TestBuildMetrics & other ) = delete; // Avoid warnings about implicit deletion of operators
+};
+
+// Register Tests
+//------------------------------------------------------------------------------
+REGISTER_TESTS_BEGIN( TestBuildMetrics )
+    REGISTER_TEST( Histogram )
+    REGISTER_TEST( Cache )
+    REGISTER_TEST( Distributed )
+    REGISTER_TEST( Output )
+    REGISTER_TEST( MemoryBudget )
+REGISTER_TESTS_END
+
+// Histogram
+//------------------------------------------------------------------------------
+void TestBuildMetrics::Histogram() const
+{
+    BuildMetrics::Values values = {};
+
+    // No samples
+    TEST_ASSERT( BuildMetrics::GetPercentileUS( values, 50 ) == 0 );
+
+    // 90 fast samples (< 1ms) and 10 slow ones (< 1s)
+    values.m_Count = 100;
+    values.m_Buckets[ 10 ] = 90;
+    values.m_Buckets[ 20 ] = 10;
+    TEST_ASSERT( BuildMetrics::GetPercentileUS( values, 50 ) == 1024 );
+    TEST_ASSERT( BuildMetrics::GetPercentileUS( values, 90 ) == 1024 );
+    TEST_ASSERT( BuildMetrics::GetPercentileUS( values, 99 ) == ( 1024 * 1024 ) );
+}
+
+// Cache
+//------------------------------------------------------------------------------
+void TestBuildMetrics::Cache() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = mConfigFile;
+    options.m_ForceCleanBuild = true;
+
+    // Write
+    {
+        options.m_UseCacheWrite = true;
+
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+
+        TEST_ASSERT( BuildMetrics::GetBuildValues( BuildMetrics::METRIC_QUEUE_WAIT ).m_Count >= 2 );
+        TEST_ASSERT( BuildMetrics::GetBuildValues( BuildMetrics::METRIC_PREPROCESS ).m_Count == 2 );
+        TEST_ASSERT( BuildMetrics::GetBuildValues( BuildMetrics::METRIC_PREPROCESS ).m_Bytes > 0 );
+        TEST_ASSERT( BuildMetrics::GetBuildValues( BuildMetrics::METRIC_CACHE_WRITE ).m_Count == 2 );
+        TEST_ASSERT( BuildMetrics::GetBuildValues( BuildMetrics::METRIC_CACHE_WRITE ).m_Bytes > 0 );
+        TEST_ASSERT( BuildMetrics::GetBuildValues( BuildMetrics::METRIC_CACHE_READ ).m_Count == 0 );
+    }
+
+    // Read
+    {
+        options.m_UseCacheWrite = false;
+        options.m_UseCacheRead = true;
+
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+
+        // Values are for this build only
+        TEST_ASSERT( BuildMetrics::GetBuildValues( BuildMetrics::METRIC_CACHE_WRITE ).m_Count == 0 );
+        TEST_ASSERT( BuildMetrics::GetBuildValues( BuildMetrics::METRIC_CACHE_READ ).m_Count == 2 );
+        TEST_ASSERT( BuildMetrics::GetBuildValues( BuildMetrics::METRIC_CACHE_READ ).m_Bytes > 0 );
+        TEST_ASSERT( BuildMetrics::GetBuildValues( BuildMetrics::METRIC_CACHE_DECOMPRESS ).m_Count == 2 );
+        TEST_ASSERT( BuildMetrics::GetBuildValues( BuildMetrics::METRIC_CACHE_DECOMPRESS ).m_Bytes > BuildMetrics::GetBuildValues( BuildMetrics::METRIC_CACHE_READ ).m_Bytes );
+        TEST_ASSERT( BuildMetrics::GetBuildValues( BuildMetrics::METRIC_DECOMPRESS ).m_Count == 0 );
+    }
+}
+
+// Distributed
+//------------------------------------------------------------------------------
+void TestBuildMetrics::Distributed() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = mConfigFile;
+    options.m_ForceCleanBuild = true;
+    options.m_AllowDistributed = true;
+    options.m_NumWorkerThreads = 1;
+    options.m_NoLocalConsumptionOfRemoteJobs = true; // ensure all jobs happen on the remote worker
+    options.m_AllowLocalRace = false;
+    options.m_DistributionPort = TEST_PROTOCOL_PORT;
+
+    FBuildForTest fBuild( options );
+    TEST_ASSERT( fBuild.Initialize() );
+
+    // start a client to emulate the other end
+    Server s( 1 );
+    s.Listen( TEST_PROTOCOL_PORT );
+
+    TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+
+    // Preparation happens locally
+    TEST_ASSERT( BuildMetrics::GetBuildValues( BuildMetrics::METRIC_PREPROCESS ).m_Count == 2 );
+    TEST_ASSERT( BuildMetrics::GetBuildValues( BuildMetrics::METRIC_COMPRESS ).m_Count == 2 );
+    TEST_ASSERT( BuildMetrics::GetBuildValues( BuildMetrics::METRIC_COMPRESS ).m_Bytes > 0 );
+
+    // Transfer and compilation
+    TEST_ASSERT( BuildMetrics::GetBuildValues( BuildMetrics::METRIC_SEND ).m_Count == 2 );
+    TEST_ASSERT( BuildMetrics::GetBuildValues( BuildMetrics::METRIC_SEND ).m_Bytes > 0 );
+    TEST_ASSERT( BuildMetrics::GetBuildValues( BuildMetrics::METRIC_REMOTE_COMPILE ).m_Count == 2 );
+    TEST_ASSERT( BuildMetrics::GetBuildValues( BuildMetrics::METRIC_RECEIVE ).m_Count == 2 );
+    TEST_ASSERT( BuildMetrics::GetBuildValues( BuildMetrics::METRIC_RECEIVE ).m_Bytes > 0 );
+
+    // Worker is in the same process, so its decompression is visible too
+    TEST_ASSERT( BuildMetrics::GetBuildValues( BuildMetrics::METRIC_DECOMPRESS ).m_Count == 2 );
+    TEST_ASSERT( BuildMetrics::GetBuildValues( BuildMetrics::METRIC_DECOMPRESS ).m_Bytes == BuildMetrics::GetBuildValues( BuildMetrics::METRIC_COMPRESS ).m_Bytes );
+    TEST_ASSERT( BuildMetrics::GetBuildValues( BuildMetrics::METRIC_CACHE_DECOMPRESS ).m_Count == 0 );
+}
+
+// Output
+//------------------------------------------------------------------------------
+void TestBuildMetrics::Output() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = mConfigFile;
+    options.m_ForceCleanBuild = true;
+    options.m_UseCacheWrite = true;
+    options.m_MetricsFile = mMetricsFile;
+    options.m_MetricsPrometheusFile = mPrometheusFile;
+
+    EnsureFileDoesNotExist( mMetricsFile );
+    EnsureFileDoesNotExist( mPrometheusFile );
+
+    FBuildForTest fBuild( options );
+    TEST_ASSERT( fBuild.Initialize() );
+    TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+
+    // JSON
+    {
+        EnsureFileExists( mMetricsFile );
+        AString json;
+        LoadFileContentsAsString( mMetricsFile, json );
+        TEST_ASSERT( json.BeginsWith( "{" ) );
+        TEST_ASSERT( json.EndsWith( "}\n" ) );
+        TEST_ASSERT( json.Find( "\"preprocess\":{\"count\":2," ) );
+        TEST_ASSERT( json.Find( "\"cache_write\":{\"count\":2," ) );
+        TEST_ASSERT( json.Find( "]},\n}" ) == nullptr ); // No trailing comma
+    }
+
+    // Prometheus
+    {
+        EnsureFileExists( mPrometheusFile );
+        AString prom;
+        LoadFileContentsAsString( mPrometheusFile, prom );
+        TEST_ASSERT( prom.Find( "# TYPE fastbuild_phase_seconds histogram\n" ) );
+        TEST_ASSERT( prom.Find( "fastbuild_phase_seconds_count{phase=\"preprocess\"} 2\n" ) );
+        TEST_ASSERT( prom.Find( "fastbuild_phase_seconds_bucket{phase=\"preprocess\",le=\"+Inf\"} 2\n" ) );
+        TEST_ASSERT( prom.Find( "fastbuild_phase_bytes_total{phase=\"preprocess\"}" ) );
+
+        // Bytes aren't reported as (zero duration) times, and vice versa
+        TEST_ASSERT( prom.Find( "# TYPE fastbuild_phase_bytes_total counter\n" ) );
+        TEST_ASSERT( prom.Find( "fastbuild_phase_bytes_total{phase=\"remote_disk_write\"}" ) );
+        TEST_ASSERT( prom.Find( "fastbuild_phase_seconds_count{phase=\"remote_disk_write\"}" ) == nullptr );
+        TEST_ASSERT( prom.Find( "fastbuild_phase_bytes_total{phase=\"queue_wait\"}" ) == nullptr );
+    }
+}
+
+// MemoryBudget
+//------------------------------------------------------------------------------
+void TestBuildMetrics::MemoryBudget() const
+{
+    const char * database = "../tmp/Test/Metrics/MemoryBudget/fbuild.fdb";
+
+    FBuildTestOptions options;
+    options.m_ConfigFile = mConfigFile;
+    options.m_ForceCleanBuild = true;
+    options.m_NumWorkerThreads = 2;
+
+    // Build without a budget, recording the memory used by each job
+    {
+        options.m_MemoryBudgetMiB = 0; // unlimited
+
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( database ) );
+
+        TEST_ASSERT( BuildMetrics::GetBuildValues( BuildMetrics::METRIC_MEMORY_WAIT ).m_Count == 0 );
+    }
+
+    // History is loaded from the DB and limits the jobs running together
+    {
+        options.m_MemoryBudgetMiB = 1; // less than any compiler needs
+
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( database ) );
+        #if defined( __LINUX__ ) // Peak memory is sampled on Linux
+            Array< const Node * > nodes;
+            fBuild.GetNodesOfType( Node::OBJECT_NODE, nodes );
+            TEST_ASSERT( nodes.GetSize() == 2 );
+            for ( const Node * node : nodes )
+            {
+                TEST_ASSERT( node->GetLastPeakMemory() > MEGABYTE );
+            }
+        #endif
+
+        // Jobs are admitted one at a time rather than stalling the build
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+        CheckStatsNode( 2, 2, Node::OBJECT_NODE );
+    }
+}
+
+//------------------------------------------------------------------------------
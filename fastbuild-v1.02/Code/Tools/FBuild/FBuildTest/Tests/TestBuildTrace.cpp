@@ -0,0 +1,173 @@
+// TestBuildTrace.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "FBuildTest.h"
+
+// FBuild
+#include "Tools/FBuild/FBuildCore/FBuild.h"
+#include "Tools/FBuild/FBuildCore/Protocol/Protocol.h"
+#include "Tools/FBuild/FBuildCore/Protocol/Server.h"
+
+// Core
+#include "Core/FileIO/FileIO.h"
+#include "Core/Strings/AStackString.h"
+
+// Defines
+//------------------------------------------------------------------------------
+#define TEST_PROTOCOL_PORT ( Protocol::PROTOCOL_PORT + 1 ) // Avoid conflict with real worker
+
+// TestBuildTrace
+//------------------------------------------------------------------------------
+class TestBuildTrace : public FBuildTest
+{
+private:
+    DECLARE_TESTS
+
+    void Local() const;
+    void Cache() const;
+    void Distributed() const;
+
+    // Helpers
+    void CheckTrace( AString & outTrace ) const;
+
+    const char * const mConfigFile = "Tools/FBuild/FBuildTest/Data/TestTrace/fbuild.bff";
+    const char * const mTraceFile = "../tmp/Test/Trace/trace.json";
+
+    TestBuildTrace & operator = ( TestBuildTrace & other ) = delete; // Avoid warnings about implicit deletion of operators
+};
+
+// Register Tests
+//------------------------------------------------------------------------------
+REGISTER_TESTS_BEGIN( TestBuildTrace )
+    REGISTER_TEST( Local )
+    REGISTER_TEST( Cache )
+    REGISTER_TEST( Distributed )
+REGISTER_TESTS_END
+
+// Local
+//------------------------------------------------------------------------------
+void TestBuildTrace::Local() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = mConfigFile;
+    options.m_ForceCleanBuild = true;
+    options.m_TraceFile = mTraceFile;
+
+    EnsureFileDoesNotExist( mTraceFile );
+
+    FBuildForTest fBuild( options );
+    TEST_ASSERT( fBuild.Initialize() );
+    TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+
+    AString trace;
+    CheckTrace( trace );
+
+    // Jobs are on local threads and include the compile
+    TEST_ASSERT( trace.Find( "\"worker\":\"WorkerThread_1\"" ) );
+    TEST_ASSERT( trace.Find( "\"name\":\"Compile\"" ) );
+    TEST_ASSERT( trace.Find( "\"result\":\"Built\"" ) );
+}
+
+// Cache
+//------------------------------------------------------------------------------
+void TestBuildTrace::Cache() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = mConfigFile;
+    options.m_ForceCleanBuild = true;
+    options.m_TraceFile = mTraceFile;
+
+    // Write
+    {
+        options.m_UseCacheWrite = true;
+
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+
+        AString trace;
+        CheckTrace( trace );
+        TEST_ASSERT( trace.Find( "\"name\":\"Preprocess\"" ) );
+        TEST_ASSERT( trace.Find( "\"name\":\"CacheStore\"" ) );
+    }
+
+    // Read
+    {
+        options.m_UseCacheWrite = false;
+        options.m_UseCacheRead = true;
+
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+
+        AString trace;
+        CheckTrace( trace );
+        TEST_ASSERT( trace.Find( "\"name\":\"CacheRetrieve\"" ) );
+        TEST_ASSERT( trace.Find( "\"result\":\"Cached\"" ) );
+        TEST_ASSERT( trace.Find( "\"name\":\"Compile\"" ) == nullptr );
+    }
+}
+
+// Distributed
+//------------------------------------------------------------------------------
+void TestBuildTrace::Distributed() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = mConfigFile;
+    options.m_ForceCleanBuild = true;
+    options.m_AllowDistributed = true;
+    options.m_NumWorkerThreads = 1;
+    options.m_NoLocalConsumptionOfRemoteJobs = true; // ensure all jobs happen on the remote worker
+    options.m_AllowLocalRace = false;
+    options.m_DistributionPort = TEST_PROTOCOL_PORT;
+    options.m_TraceFile = mTraceFile;
+
+    FBuildForTest fBuild( options );
+    TEST_ASSERT( fBuild.Initialize() );
+
+    // start a client to emulate the other end
+    Server s( 1 );
+    s.Listen( TEST_PROTOCOL_PORT );
+
+    TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+
+    AString trace;
+    CheckTrace( trace );
+
+    // Preparation happens locally
+    TEST_ASSERT( trace.Find( "\"name\":\"Preprocess\"" ) );
+    TEST_ASSERT( trace.Find( "\"name\":\"Compress\"" ) );
+    TEST_ASSERT( trace.Find( "\"result\":\"Preprocessed\"" ) );
+
+    // Compilation happens on the worker
+    TEST_ASSERT( trace.Find( "\"args\":{\"name\":\"127.0.0.1\"}" ) );
+    TEST_ASSERT( trace.Find( "\"worker\":\"127.0.0.1\"" ) );
+    TEST_ASSERT( trace.Find( "\"name\":\"Network\"" ) || trace.Find( "\"name\":\"Compile\"" ) );
+}
+
+// CheckTrace
+//------------------------------------------------------------------------------
+void TestBuildTrace::CheckTrace( AString & outTrace ) const
+{
+    EnsureFileExists( mTraceFile );
+    LoadFileContentsAsString( mTraceFile, outTrace );
+
+    // Complete JSON object in Chrome trace format
+    TEST_ASSERT( outTrace.BeginsWith( "{\"traceEvents\":[" ) );
+    TEST_ASSERT( outTrace.EndsWith( "}\n" ) );
+    TEST_ASSERT( outTrace.Find( ",\n]" ) == nullptr ); // No trailing comma
+
+    // One event per job
+    TEST_ASSERT( outTrace.Find( "\"ph\":\"X\"" ) );
+    #if defined( __WINDOWS__ )
+        TEST_ASSERT( outTrace.Find( "Trace\\\\a." ) ); // Escaped in JSON
+        TEST_ASSERT( outTrace.Find( "Trace\\\\b." ) );
+    #else
+        TEST_ASSERT( outTrace.Find( "Trace/a." ) );
+        TEST_ASSERT( outTrace.Find( "Trace/b." ) );
+    #endif
+}
+
+//------------------------------------------------------------------------------
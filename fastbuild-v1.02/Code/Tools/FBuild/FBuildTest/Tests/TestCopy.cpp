@@ -7,6 +7,7 @@
 #include "Tools/FBuild/FBuildCore/FBuild.h"
 #include "Tools/FBuild/FBuildCore/Graph/CopyFileNode.h"
 #include "Tools/FBuild/FBuildCore/Graph/NodeGraph.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildMetrics.h"
 
 #include "Core/FileIO/FileIO.h"
 #include "Core/Strings/AStackString.h"
@@ -35,6 +36,7 @@ private:
     void CopyDir_NoRebuild() const;
     void CopyDir_NoRebuild_BFFChange() const;
     void CopyDirDeleteSrc() const;
+    void CopyDirHardLinks() const;
     void CopyEmpty() const;
     void MissingTrailingSlash() const;
     void ObjectListChaining() const;
@@ -61,6 +63,7 @@ REGISTER_TESTS_BEGIN( TestCopy )
     REGISTER_TEST( CopyDir_NoRebuild )
     REGISTER_TEST( CopyDir_NoRebuild_BFFChange )
     REGISTER_TEST( CopyDirDeleteSrc )
+    REGISTER_TEST( CopyDirHardLinks )
     REGISTER_TEST( CopyEmpty )
     REGISTER_TEST( MissingTrailingSlash )
     REGISTER_TEST( ObjectListChaining )
@@ -531,6 +534,44 @@ void TestCopy::CopyDirDeleteSrc() const
     }
 }
 
+// CopyDirHardLinks
+//------------------------------------------------------------------------------
+void TestCopy::CopyDirHardLinks() const
+{
+    // Sources on the same volume as the destination, so they can be linked
+    AStackString<> srcA( "../tmp/Test/Copy/CopyDirHardLinks/Src/a.txt" );
+    AStackString<> srcB( "../tmp/Test/Copy/CopyDirHardLinks/Src/b.txt" );
+    AStackString<> dstA( "../tmp/Test/Copy/CopyDirHardLinks/Dst/a.txt" );
+    AStackString<> dstB( "../tmp/Test/Copy/CopyDirHardLinks/Dst/b.txt" );
+    TEST_ASSERT( FileIO::EnsurePathExists( AStackString<>( "../tmp/Test/Copy/CopyDirHardLinks/Src/" ) ) );
+    TEST_ASSERT( FileIO::FileCopy( "Tools/FBuild/FBuildTest/Data/TestCopy/a.txt", srcA.Get() ) );
+    TEST_ASSERT( FileIO::FileCopy( "Tools/FBuild/FBuildTest/Data/TestCopy/b.txt", srcB.Get() ) );
+    TEST_ASSERT( FileIO::SetReadOnly( srcA.Get(), false ) );
+    TEST_ASSERT( FileIO::SetReadOnly( srcB.Get(), false ) );
+    EnsureFileDoesNotExist( dstA );
+    EnsureFileDoesNotExist( dstB );
+
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestCopy/copy.bff";
+    FBuild fBuild( options );
+    TEST_ASSERT( fBuild.Initialize() );
+
+    TEST_ASSERT( fBuild.Build( "CopyDirHardLinks" ) );
+
+    EnsureFileExists( dstA );
+    EnsureFileExists( dstB );
+
+    // Files are linked, unless the file system can clone them
+    const uint64_t numReflinks = BuildMetrics::GetBuildValues( BuildMetrics::METRIC_COPY_REFLINK ).m_Count;
+    const uint64_t numHardLinks = BuildMetrics::GetBuildValues( BuildMetrics::METRIC_COPY_HARDLINK ).m_Count;
+    TEST_ASSERT( ( numReflinks + numHardLinks ) == 2 );
+    TEST_ASSERT( BuildMetrics::GetBuildValues( BuildMetrics::METRIC_COPY_BYTES ).m_Count == 0 );
+
+    // Bytes for each kind of copy are shown in the summary
+    TEST_ASSERT( GetRecordedOutput().Find( "Copy:\n" ) );
+    TEST_ASSERT( GetRecordedOutput().Find( numHardLinks ? " - Hard Link  : " : " - Reflink    : " ) );
+}
+
 // CopyEmpty
 //------------------------------------------------------------------------------
 void TestCopy::CopyEmpty() const
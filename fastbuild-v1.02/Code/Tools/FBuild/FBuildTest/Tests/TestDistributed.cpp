@@ -6,14 +6,26 @@
 #include "Tools/FBuild/FBuildTest/Tests/FBuildTest.h"
 
 #include "Tools/FBuild/FBuildCore/FBuild.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildMetrics.h"
+#include "Tools/FBuild/FBuildCore/Helpers/HeaderBundle.h"
 #include "Tools/FBuild/FBuildCore/Protocol/Protocol.h"
 #include "Tools/FBuild/FBuildCore/Protocol/Server.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/Job.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/JobQueue.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/JobQueueRemote.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/MemoryStaging.h"
 
+#include "Core/Env/Env.h"
+#include "Core/FileIO/ConstMemoryStream.h"
 #include "Core/FileIO/FileIO.h"
+#include "Core/FileIO/MemoryStream.h"
+#include "Core/FileIO/PathUtils.h"
+#include "Core/Math/xxHash.h"
 #include "Core/Strings/AStackString.h"
 
+// System
+#include <string.h>
+
 // Defines
 //------------------------------------------------------------------------------
 #define TEST_PROTOCOL_PORT ( Protocol::PROTOCOL_PORT + 1 ) // Avoid conflict with real worker
@@ -36,6 +48,13 @@ private:
     void TestLocalRace();
     void RemoteRaceWinRemote();
     void AnonymousNamespaces();
+    void LargeOutput() const;
+    void HeaderShipping() const;
+    void HeaderShippingWithPCH() const;
+    void HeaderStoreEviction() const;
+    void HeaderDependencies() const;
+    void MemoryStaging() const;
+    void ToolAffinity() const;
     void ErrorsAreCorrectlyReported_MSVC() const;
     void ErrorsAreCorrectlyReported_Clang() const;
     void WarningsAreCorrectlyReported_MSVC() const;
@@ -50,6 +69,10 @@ private:
                      uint32_t numRemoteWorkers,
                      bool shouldFail = false,
                      bool allowRace = false ) const;
+    void SendHeaders( const HeaderBundle & bundle,
+                      Array< uint64_t > & knownHashes,
+                      HeaderStore & store,
+                      Array< uint64_t > & clientHashes ) const;
 };
 
 // Register Tests
@@ -62,7 +85,16 @@ REGISTER_TESTS_BEGIN( TestDistributed )
     REGISTER_TEST( TestLocalRace )
     REGISTER_TEST( RemoteRaceWinRemote )
     REGISTER_TEST( AnonymousNamespaces )
+    REGISTER_TEST( LargeOutput )
     REGISTER_TEST( ShutdownMemoryLeak )
+    REGISTER_TEST( HeaderStoreEviction )
+    REGISTER_TEST( HeaderDependencies )
+    #if defined( __LINUX__ )
+        REGISTER_TEST( HeaderShipping )
+        REGISTER_TEST( HeaderShippingWithPCH )
+        REGISTER_TEST( MemoryStaging )
+        REGISTER_TEST( ToolAffinity )
+    #endif
     #if defined( __WINDOWS__ )
         REGISTER_TEST( ErrorsAreCorrectlyReported_MSVC ) // TODO:B Enable for OSX and Linux
         REGISTER_TEST( ErrorsAreCorrectlyReported_Clang ) // TODO:B Enable for OSX and Linux
@@ -209,6 +241,239 @@ void TestDistributed::AnonymousNamespaces()
     TestHelper( target, 1 );
 }
 
+// LargeOutput
+//------------------------------------------------------------------------------
+void TestDistributed::LargeOutput() const
+{
+    // A large object is streamed back in chunks, while small ones are batched
+    const char * target( "../tmp/Test/Distributed/LargeOutput/LargeOutput.lib" );
+    TestHelper( target, 4 );
+
+    #if defined( __WINDOWS__ )
+        AStackString<> largeObj( "../tmp/Test/Distributed/LargeOutput/Large.obj" );
+    #else
+        AStackString<> largeObj( "../tmp/Test/Distributed/LargeOutput/Large.o" );
+    #endif
+    FileIO::FileInfo info;
+    TEST_ASSERT( FileIO::GetFileInfo( largeObj, info ) );
+    TEST_ASSERT( info.m_Size > ( 3 * MEGABYTE ) );
+}
+
+// HeaderShipping
+//------------------------------------------------------------------------------
+void TestDistributed::HeaderShipping() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestDistributed/HeaderShipping/fbuild.bff";
+    options.m_AllowDistributed = true;
+    options.m_NumWorkerThreads = 1;
+    options.m_ForceCleanBuild = true;
+    options.m_NoLocalConsumptionOfRemoteJobs = true; // ensure all jobs happen on the remote worker
+    options.m_DistributionPort = TEST_PROTOCOL_PORT;
+
+    AStackString<> headerStorePath;
+    HeaderStore::GetDefaultPath( headerStorePath );
+
+    // Source and headers are sent instead of preprocessed output
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+
+        Server s( 1 );
+        s.Listen( TEST_PROTOCOL_PORT );
+
+        TEST_ASSERT( fBuild.Build( "HeaderShipping" ) );
+
+        // Worker received the source and 3 headers (found next to the source,
+        // via the include path and next to another header)
+        Array< AString > files;
+        FileIO::GetFiles( headerStorePath, AStackString<>( "*" ), false, &files );
+        TEST_ASSERT( files.GetSize() == 4 );
+
+        // Debug info and __FILE__ refer to the source on this machine, not the
+        // include root in the worker's thread tmp dir (core_N/root/)
+        AString obj;
+        LoadFileContentsAsString( "../tmp/Test/Distributed/HeaderShipping/Shipped.o", obj );
+        AStackString<> sourceFile;
+        VERIFY( FileIO::GetCurrentDir( sourceFile ) );
+        PathUtils::EnsureTrailingSlash( sourceFile );
+        sourceFile += "Tools/FBuild/FBuildTest/Data/TestDistributed/HeaderShipping/Shipped.cpp";
+        TEST_ASSERT( memmem( obj.Get(), obj.GetLength(), sourceFile.Get(), sourceFile.GetLength() ) );
+        TEST_ASSERT( memmem( obj.Get(), obj.GetLength(), "/core_", 6 ) == nullptr );
+    }
+
+    // Preprocessed output is sent when the include graph can't be determined
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+
+        Server s( 1 );
+        s.Listen( TEST_PROTOCOL_PORT );
+
+        TEST_ASSERT( fBuild.Build( "HeaderShipping-Fallback" ) );
+
+        Array< AString > files;
+        FileIO::GetFiles( headerStorePath, AStackString<>( "*" ), false, &files );
+        TEST_ASSERT( files.IsEmpty() );
+    }
+}
+
+// HeaderShippingWithPCH
+//------------------------------------------------------------------------------
+void TestDistributed::HeaderShippingWithPCH() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestDistributed/HeaderShipping/fbuild.bff";
+    options.m_AllowDistributed = true;
+    options.m_NumWorkerThreads = 1;
+    options.m_ForceCleanBuild = true;
+    options.m_NoLocalConsumptionOfRemoteJobs = true; // ensure all jobs happen on the remote worker
+    options.m_DistributionPort = TEST_PROTOCOL_PORT;
+
+    FBuild fBuild( options );
+    TEST_ASSERT( fBuild.Initialize() );
+
+    Server s( 1 );
+    s.Listen( TEST_PROTOCOL_PORT );
+
+    TEST_ASSERT( fBuild.Build( "HeaderShipping-PCH" ) );
+
+    // Worker received the PCH header (and the header it includes), the PCH
+    // it created from them and the 2 sources using it
+    AStackString<> headerStorePath;
+    HeaderStore::GetDefaultPath( headerStorePath );
+    Array< AString > files;
+    FileIO::GetFiles( headerStorePath, AStackString<>( "*" ), false, &files );
+    TEST_ASSERT( files.GetSize() == 5 );
+
+    // The PCH is in the store (the users only compile if they used it)
+    AString pch;
+    LoadFileContentsAsString( "../tmp/Test/Distributed/HeaderShipping/PCH/Shared.h.gch", pch );
+    AStackString<> pchInStore;
+    pchInStore.Format( "%s%016" PRIx64, headerStorePath.Get(), xxHash::Calc64( pch ) );
+    TEST_ASSERT( FileIO::FileExists( pchInStore.Get() ) );
+}
+
+// HeaderStoreEviction
+//------------------------------------------------------------------------------
+void TestDistributed::HeaderStoreEviction() const
+{
+    FBuild fBuild; // owns the file content hashes made when sending headers
+
+    const char * const headers[] = { "../tmp/Test/Distributed/HeaderStore/A.h",
+                                     "../tmp/Test/Distributed/HeaderStore/B.h",
+                                     "../tmp/Test/Distributed/HeaderStore/C.h" };
+    TEST_ASSERT( FileIO::EnsurePathExists( AStackString<>( "../tmp/Test/Distributed/HeaderStore/" ) ) );
+    uint64_t hashes[ 3 ];
+    for ( size_t i = 0; i < 3; ++i )
+    {
+        AString contents;
+        contents.SetLength( 1000 );
+        memset( contents.Get(), (int)( 'A' + i ), 1000 );
+        MakeFile( headers[ i ], contents.Get() );
+        hashes[ i ] = xxHash::Calc64( contents );
+    }
+
+    // Room for 2 of the 3 headers
+    const AStackString<> storePath( "../tmp/Test/Distributed/HeaderStore/Store/" );
+    HeaderStore store( storePath, 2500 );
+    AStackString<> storedA;
+    AStackString<> storedB;
+    AStackString<> storedC;
+    storedA.Format( "%s%016" PRIx64, storePath.Get(), hashes[ 0 ] );
+    storedB.Format( "%s%016" PRIx64, storePath.Get(), hashes[ 1 ] );
+    storedC.Format( "%s%016" PRIx64, storePath.Get(), hashes[ 2 ] );
+
+    // One client sends A and B
+    HeaderBundle bundleAB;
+    bundleAB.AddFile( AStackString<>( headers[ 0 ] ), hashes[ 0 ] );
+    bundleAB.AddFile( AStackString<>( headers[ 1 ] ), hashes[ 1 ] );
+    Array< uint64_t > knownHashes1( 0, true );
+    Array< uint64_t > clientHashes1( 0, true );
+    SendHeaders( bundleAB, knownHashes1, store, clientHashes1 );
+    TEST_ASSERT( store.GetBytesInUse() == 2000 );
+
+    // Which it then knows not to send again
+    Array< uint32_t > files;
+    bundleAB.SelectContents( knownHashes1, files );
+    TEST_ASSERT( files.IsEmpty() );
+
+    // Another sends B and C, and nothing either client might use can be evicted
+    HeaderBundle bundleBC;
+    bundleBC.AddFile( AStackString<>( headers[ 1 ] ), hashes[ 1 ] );
+    bundleBC.AddFile( AStackString<>( headers[ 2 ] ), hashes[ 2 ] );
+    Array< uint64_t > knownHashes2( 0, true );
+    Array< uint64_t > clientHashes2( 0, true );
+    SendHeaders( bundleBC, knownHashes2, store, clientHashes2 );
+    TEST_ASSERT( store.GetBytesInUse() == 3000 );
+    TEST_ASSERT( FileIO::FileExists( storedA.Get() ) );
+
+    // Once the first disconnects, A is the least recently used
+    store.ReleaseContents( clientHashes1 );
+    TEST_ASSERT( store.GetBytesInUse() == 2000 );
+    TEST_ASSERT( FileIO::FileExists( storedA.Get() ) == false );
+    TEST_ASSERT( FileIO::FileExists( storedB.Get() ) );
+    TEST_ASSERT( FileIO::FileExists( storedC.Get() ) );
+
+    // Within budget again
+    store.ReleaseContents( clientHashes2 );
+    TEST_ASSERT( store.GetBytesInUse() == 2000 );
+
+    // Headers modified since the bundle was made are omitted, and forgotten
+    MakeFile( headers[ 2 ], "modified" );
+    Array< uint64_t > knownHashes3( 0, true );
+    files.Clear();
+    bundleBC.SelectContents( knownHashes3, files );
+    TEST_ASSERT( files.GetSize() == 2 );
+    MemoryStream ms;
+    Array< uint64_t > omittedHashes;
+    TEST_ASSERT( bundleBC.SaveContents( files, ms, omittedHashes ) == false );
+    TEST_ASSERT( ( omittedHashes.GetSize() == 1 ) && ( omittedHashes[ 0 ] == hashes[ 2 ] ) );
+    HeaderBundle::ForgetContents( knownHashes3, omittedHashes );
+    TEST_ASSERT( ( knownHashes3.GetSize() == 1 ) && ( knownHashes3[ 0 ] == hashes[ 1 ] ) );
+}
+
+// HeaderDependencies
+//------------------------------------------------------------------------------
+void TestDistributed::HeaderDependencies() const
+{
+    // Files read by a compilation on a worker, as listed by -MD (the system
+    // headers are reported to the client to check)
+    const AStackString<> depFile( "/tmp/core_1/root/src/a.o: /tmp/core_1/root/src/a.cpp \\\n"
+                                  " /usr/include/stdio.h /opt/My\\ SDK/\\#1/cost$$.h \\\r\n"
+                                  "  /usr/include/stddef.h\n"
+                                  "\n"
+                                  "/usr/include/stdio.h:\n" ); // -MP
+    Array< AString > files;
+    TEST_ASSERT( HeaderBundle::ParseDependencies( depFile, files ) );
+    TEST_ASSERT( files.GetSize() == 4 );
+    TEST_ASSERT( files[ 0 ] == "/tmp/core_1/root/src/a.cpp" );
+    TEST_ASSERT( files[ 1 ] == "/usr/include/stdio.h" );
+    TEST_ASSERT( files[ 2 ] == "/opt/My SDK/#1/cost$.h" );
+    TEST_ASSERT( files[ 3 ] == "/usr/include/stddef.h" );
+
+    // Not a dependency file
+    files.Clear();
+    TEST_ASSERT( HeaderBundle::ParseDependencies( AStackString<>( "" ), files ) == false );
+}
+
+// SendHeaders
+//------------------------------------------------------------------------------
+void TestDistributed::SendHeaders( const HeaderBundle & bundle,
+                                   Array< uint64_t > & knownHashes,
+                                   HeaderStore & store,
+                                   Array< uint64_t > & clientHashes ) const
+{
+    Array< uint32_t > files;
+    bundle.SelectContents( knownHashes, files );
+    MemoryStream ms;
+    Array< uint64_t > omittedHashes;
+    TEST_ASSERT( bundle.SaveContents( files, ms, omittedHashes ) );
+
+    ConstMemoryStream cms( ms.GetData(), ms.GetSize() );
+    TEST_ASSERT( store.LoadContents( cms, clientHashes ) );
+}
+
 // TestForceInclude
 //------------------------------------------------------------------------------
 void TestDistributed::TestForceInclude() const
@@ -217,6 +482,167 @@ void TestDistributed::TestForceInclude() const
     TestHelper( target, 1 );
 }
 
+// MemoryStaging
+//------------------------------------------------------------------------------
+void TestDistributed::MemoryStaging() const
+{
+    const char * target( "../tmp/Test/Distributed/dist.lib" );
+
+    // Use a tmpfs if there is one (the behaviour is the same either way)
+    AStackString<> root;
+    if ( ::MemoryStaging::GetDefaultRoot( root ) == false )
+    {
+        VERIFY( FileIO::GetTempDir( root ) );
+        root += "_fbuild.tmp/worker_memory/";
+    }
+    root += "Test/";
+
+    // Temp files of jobs which fit are kept in memory
+    {
+        ::MemoryStaging staging( root, 256 * MEGABYTE );
+        TestHelper( target, 4 );
+
+        const BuildMetrics::Values & diskWrite = BuildMetrics::GetBuildValues( BuildMetrics::METRIC_REMOTE_DISK_WRITE );
+        TEST_ASSERT( diskWrite.m_Count > 0 );
+        TEST_ASSERT( diskWrite.m_Bytes == 0 );
+        TEST_ASSERT( staging.GetBytesInUse() == 0 );
+    }
+
+    // Jobs which don't fit use the disk
+    {
+        ::MemoryStaging staging( root, 1 );
+        TestHelper( target, 4 );
+
+        const BuildMetrics::Values & diskWrite = BuildMetrics::GetBuildValues( BuildMetrics::METRIC_REMOTE_DISK_WRITE );
+        TEST_ASSERT( diskWrite.m_Count > 0 );
+        TEST_ASSERT( diskWrite.m_Bytes > 0 );
+    }
+
+    // Jobs which fail to write their temp files in memory are tried again on disk
+    {
+        ::MemoryStaging staging( root, 256 * MEGABYTE );
+
+        // Block the temp dirs of the worker threads (1001 onwards)
+        Array< AString > blockers;
+        for ( uint32_t i = 0; i < 4; ++i )
+        {
+            AStackString<> blocker;
+            blocker.Format( "%score_%u", root.Get(), ( 1001 + i ) );
+            FileIO::DirectoryDelete( blocker ); // left by earlier builds
+            MakeFile( blocker.Get(), "" );
+            blockers.Append( blocker );
+        }
+
+        TestHelper( target, 4 );
+
+        const BuildMetrics::Values & diskWrite = BuildMetrics::GetBuildValues( BuildMetrics::METRIC_REMOTE_DISK_WRITE );
+        TEST_ASSERT( diskWrite.m_Count > 0 );
+        TEST_ASSERT( diskWrite.m_Bytes > 0 );
+        TEST_ASSERT( staging.GetBytesInUse() == 0 );
+
+        for ( const AString & blocker : blockers )
+        {
+            TEST_ASSERT( FileIO::FileDelete( blocker.Get() ) );
+        }
+    }
+
+    // Nothing is left behind
+    Array< AString > files;
+    FileIO::GetFiles( root, AStackString<>( "*" ), true, &files );
+    TEST_ASSERT( files.IsEmpty() );
+}
+
+// ToolAffinity
+//------------------------------------------------------------------------------
+void TestDistributed::ToolAffinity() const
+{
+    // Keep the toolchain store out of the real temp dir
+    AStackString<> tempDir;
+    TEST_ASSERT( FBuild::GetTempDir( tempDir ) );
+    AStackString<> testTempDir;
+    VERIFY( FileIO::GetCurrentDir( testTempDir ) );
+    PathUtils::EnsureTrailingSlash( testTempDir );
+    testTempDir += "../tmp/Test/Distributed/ToolAffinity/Temp/";
+    Env::SetEnvVariable( "FASTBUILD_TEMP_PATH", testTempDir );
+
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestDistributed/ToolAffinity/fbuild.bff";
+    options.m_AllowDistributed = true;
+    options.m_NumWorkerThreads = 1;
+    options.m_ForceCleanBuild = true;
+    options.m_NoLocalConsumptionOfRemoteJobs = true; // ensure all jobs happen on the remote worker
+    options.m_DistributionPort = TEST_PROTOCOL_PORT;
+
+    // The worker synchronizes (and stores) the toolchain of one ObjectList
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+
+        Server s( 1 );
+        s.EnableToolchainStore( 1024 * MEGABYTE );
+        s.Listen( TEST_PROTOCOL_PORT );
+
+        TEST_ASSERT( fBuild.Build( "ToolAffinity-A" ) );
+    }
+
+    // Build both ObjectLists with a worker which still has that toolchain
+    options.m_DistVerbose = true;
+    options.m_ShowCommandSummary = true;
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+
+        Server s( 1 );
+        s.EnableToolchainStore( 1024 * MEGABYTE );
+        Array< uint64_t > toolIds( 0, true );
+        s.GetToolIds( toolIds );
+        TEST_ASSERT( toolIds.GetSize() == 1 );
+
+        // Make the worker available once all the jobs are queued, so it has a choice
+        class Helper
+        {
+        public:
+            static uint32_t ListenWhenJobsQueued( void * data )
+            {
+                Timer t;
+                while ( t.GetElapsed() < 30.0f )
+                {
+                    if ( JobQueue::IsValid() && ( JobQueue::Get().GetNumDistributableJobsAvailable() == 3 ) )
+                    {
+                        break;
+                    }
+                    Thread::Sleep( 1 );
+                }
+                static_cast< Server * >( data )->Listen( TEST_PROTOCOL_PORT );
+                return 0;
+            }
+        };
+        Thread::ThreadHandle h = Thread::CreateThread( Helper::ListenWhenJobsQueued, nullptr, 64 * KILOBYTE, &s );
+
+        TEST_ASSERT( fBuild.Build( "ToolAffinity" ) );
+
+        Thread::WaitForThread( h );
+        Thread::CloseHandle( h );
+
+        // The job for the toolchain the worker has is sent first, even if
+        // the others are more expensive
+        const AString & output = GetRecordedOutput();
+        const char * const jobA = output.Find( "A.o <REMOTE" );
+        const char * const jobB1 = output.Find( "B1.o <REMOTE" );
+        const char * const jobB2 = output.Find( "B2.o <REMOTE" );
+        TEST_ASSERT( jobA && jobB1 && jobB2 );
+        TEST_ASSERT( ( jobA < jobB1 ) && ( jobA < jobB2 ) );
+
+        // and the other toolchain is synchronized in the background meanwhile
+        TEST_ASSERT( output.Find( "Prewarming toolchain" ) );
+        toolIds.Clear();
+        s.GetToolIds( toolIds );
+        TEST_ASSERT( toolIds.GetSize() == 2 );
+    }
+
+    Env::SetEnvVariable( "FASTBUILD_TEMP_PATH", tempDir );
+}
+
 // ErrorsAreCorrectlyReported_MSVC
 //------------------------------------------------------------------------------
 void TestDistributed::ErrorsAreCorrectlyReported_MSVC() const
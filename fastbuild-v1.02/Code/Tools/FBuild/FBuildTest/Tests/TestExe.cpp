@@ -6,6 +6,7 @@
 #include "FBuildTest.h"
 #include "Tools/FBuild/FBuildCore/FBuild.h"
 #include "Tools/FBuild/FBuildCore/Graph/ExeNode.h"
+#include "Tools/FBuild/FBuildCore/Graph/LinkPrepNode.h"
 #include "Tools/FBuild/FBuildCore/Graph/NodeGraph.h"
 
 #include "Core/FileIO/FileIO.h"
@@ -23,6 +24,7 @@ private:
     void Build() const;
     void CheckValidExe() const;
     void Build_NoRebuild() const;
+    void LinkerPrepare() const;
 };
 
 // Register Tests
@@ -32,6 +34,7 @@ REGISTER_TESTS_BEGIN( TestExe )
     REGISTER_TEST( Build )
     REGISTER_TEST( CheckValidExe )
     REGISTER_TEST( Build_NoRebuild )
+    REGISTER_TEST( LinkerPrepare )
 REGISTER_TESTS_END
 
 // CreateNode
@@ -119,4 +122,70 @@ void TestExe::Build_NoRebuild() const
 
 }
 
+// LinkerPrepare
+//------------------------------------------------------------------------------
+void TestExe::LinkerPrepare() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestExe/LinkerPrepare/fbuild.bff";
+    const char * const db = "../tmp/Test/Exe/LinkerPrepare/exe.fdb";
+    const char * const linkPrepName = "../tmp/Test/Exe/LinkerPrepare/exe.exe.linkprep";
+
+    // Build
+    {
+        options.m_ForceCleanBuild = true;
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "Exe" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( db ) );
+
+        // Nothing to prepare the first time, but the inputs are recorded
+        CheckStatsNode ( 1,     1,      Node::LINK_PREP_NODE );
+        CheckStatsNode ( 1,     1,      Node::EXE_NODE );
+        const LinkPrepNode * linkPrep = fBuild.GetNode( linkPrepName )->CastTo< LinkPrepNode >();
+        TEST_ASSERT( linkPrep->IsHidden() );
+        TEST_ASSERT( linkPrep->GetInputFiles().GetSize() == 1 );
+        TEST_ASSERT( linkPrep->GetInputFiles()[ 0 ].Find( "exe." ) );
+        TEST_ASSERT( linkPrep->GetBytesPrefetched() == 0 );
+
+        // Doesn't wait for any of the inputs
+        TEST_ASSERT( linkPrep->GetStaticDependencies().IsEmpty() );
+    }
+
+    // No rebuild
+    AStackString<> objectFile;
+    {
+        options.m_ForceCleanBuild = false;
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( db ) );
+        TEST_ASSERT( fBuild.Build( "Exe" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( db ) );
+
+        // Inputs are prepared, but don't cause a re-link
+        CheckStatsNode ( 1,     1,      Node::LINK_PREP_NODE );
+        CheckStatsNode ( 1,     0,      Node::OBJECT_NODE );
+        CheckStatsNode ( 1,     0,      Node::EXE_NODE );
+        const LinkPrepNode * linkPrep = fBuild.GetNode( linkPrepName )->CastTo< LinkPrepNode >();
+        TEST_ASSERT( linkPrep->GetInputFiles().GetSize() == 1 );
+        TEST_ASSERT( linkPrep->GetBytesPrefetched() > 0 );
+        objectFile = linkPrep->GetInputFiles()[ 0 ];
+    }
+
+    // Rebuild the object
+    TEST_ASSERT( FileIO::FileDelete( objectFile.Get() ) );
+    {
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( db ) );
+        TEST_ASSERT( fBuild.Build( "Exe" ) );
+
+        // Re-linked, and the inputs recorded again
+        CheckStatsNode ( 1,     1,      Node::LINK_PREP_NODE );
+        CheckStatsNode ( 1,     1,      Node::OBJECT_NODE );
+        CheckStatsNode ( 1,     1,      Node::EXE_NODE );
+        const LinkPrepNode * linkPrep = fBuild.GetNode( linkPrepName )->CastTo< LinkPrepNode >();
+        TEST_ASSERT( linkPrep->GetInputFiles().GetSize() == 1 );
+        TEST_ASSERT( linkPrep->GetInputFiles()[ 0 ] == objectFile );
+    }
+}
+
 //------------------------------------------------------------------------------
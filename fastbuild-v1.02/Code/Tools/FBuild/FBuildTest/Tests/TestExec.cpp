@@ -27,6 +27,7 @@ private:
     void Build_ExecCommand_MultipleInputChange() const;
     void Build_ExecCommand_UseStdOut() const;
     void Build_ExecCommand_ExpectedFailures() const;
+    void Build_ExecCommand_Cacheable() const;
     void Exclusions() const;
 };
 
@@ -40,6 +41,7 @@ REGISTER_TESTS_BEGIN( TestExec )
     REGISTER_TEST( Build_ExecCommand_MultipleInputChange )
     REGISTER_TEST( Build_ExecCommand_UseStdOut )
     REGISTER_TEST( Build_ExecCommand_ExpectedFailures )
+    REGISTER_TEST( Build_ExecCommand_Cacheable )
     REGISTER_TEST( Exclusions )
 REGISTER_TESTS_END
 
@@ -300,6 +302,60 @@ void TestExec::Build_ExecCommand_ExpectedFailures() const
     TEST_ASSERT( !fBuild.Build( targets ) );
 }
 
+//------------------------------------------------------------------------------
+void TestExec::Build_ExecCommand_Cacheable() const
+{
+    const AStackString<> inFile( "../tmp/Test/Exec/Cacheable.txt" );
+    const AStackString<> outFile( "../tmp/Test/Exec/Cacheable.txt.out" );
+    const AStackString<> extraOutFile( "../tmp/Test/Exec/CacheableExtra.out" );
+    CreateInputFile( inFile );
+
+    // Run and store the outputs
+    {
+        FBuildTestOptions options;
+        options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestExec/exec.bff";
+        options.m_UseCacheWrite = true;
+
+        FBuild fBuild( options );
+        fBuild.Initialize( "../tmp/Test/Exec/exec.fdb" );
+
+        EnsureFileDoesNotExist( outFile );
+        EnsureFileDoesNotExist( extraOutFile );
+
+        TEST_ASSERT( fBuild.Build( "ExecCommandTest_Cacheable" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( "../tmp/Test/Exec/exec.fdb" ) );
+
+        EnsureFileExists( outFile );
+        EnsureFileExists( extraOutFile );
+
+        const FBuildStats::Stats & execStats = fBuild.GetStats().GetStatsFor( Node::EXEC_NODE );
+        TEST_ASSERT( execStats.m_NumBuilt == 1 );
+        TEST_ASSERT( execStats.m_NumCacheStores == 1 );
+    }
+
+    // Restore the outputs without running
+    {
+        FBuildTestOptions options;
+        options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestExec/exec.bff";
+        options.m_UseCacheRead = true;
+
+        FBuild fBuild( options );
+        fBuild.Initialize( "../tmp/Test/Exec/exec.fdb" );
+
+        EnsureFileDoesNotExist( outFile );
+        EnsureFileDoesNotExist( extraOutFile );
+
+        TEST_ASSERT( fBuild.Build( "ExecCommandTest_Cacheable" ) );
+
+        EnsureFileExists( outFile );
+        EnsureFileExists( extraOutFile );
+
+        const FBuildStats::Stats & execStats = fBuild.GetStats().GetStatsFor( Node::EXEC_NODE );
+        TEST_ASSERT( execStats.m_NumCacheHits == 1 );
+        TEST_ASSERT( execStats.m_NumCacheStores == 0 );
+    }
+}
+
 // Exclusions
 //------------------------------------------------------------------------------
 void TestExec::Exclusions() const
@@ -24,6 +24,7 @@
 
 // Core
 #include "Core/Containers/AutoPtr.h"
+#include "Core/Env/Env.h"
 #include "Core/FileIO/FileIO.h"
 #include "Core/FileIO/FileStream.h"
 #include "Core/FileIO/MemoryStream.h"
@@ -32,6 +33,7 @@
 #include "Core/Process/Thread.h"
 #include "Core/Strings/AStackString.h"
 #include "Core/Time/Timer.h"
+#include "Core/Tracing/Tracing.h"
 
 // TestGraph
 //------------------------------------------------------------------------------
@@ -49,6 +51,7 @@ private:
     void TestDirectoryListNode() const;
     void TestSerialization() const;
     void TestDeepGraph() const;
+    void TestParallelParse() const;
     void TestNoStopOnFirstError() const;
     void DBLocationChanged() const;
     void DBCorrupt() const;
@@ -68,6 +71,7 @@ REGISTER_TESTS_BEGIN( TestGraph )
     REGISTER_TEST( TestDirectoryListNode )
     REGISTER_TEST( TestSerialization )
     REGISTER_TEST( TestDeepGraph )
+    REGISTER_TEST( TestParallelParse )
     REGISTER_TEST( TestNoStopOnFirstError )
     REGISTER_TEST( DBLocationChanged )
     REGISTER_TEST( DBCorrupt )
@@ -577,6 +581,67 @@ void TestGraph::TestDeepGraph() const
     }
 }
 
+// TestParallelParse
+//------------------------------------------------------------------------------
+void TestGraph::TestParallelParse() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestGraph/ParallelParse.bff";
+
+    // Parse on the main thread only, and with helper threads, timing each
+    AString graphs[ 2 ];
+    const uint32_t numThreads[ 2 ] = { 1, 8 };
+    for ( size_t i = 0; i < 2; ++i )
+    {
+        options.m_NumWorkerThreads = numThreads[ i ];
+
+        Timer t;
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        const float parseTime = t.GetElapsed();
+
+        // 100 ObjectLists of 202 files (200 unique, 2 via an Alias)
+        Array< const Node * > nodes;
+        fBuild.GetNodesOfType( Node::OBJECT_LIST_NODE, nodes );
+        TEST_ASSERT( nodes.GetSize() == 100 );
+        nodes.Clear();
+        fBuild.GetNodesOfType( Node::FILE_NODE, nodes );
+        TEST_ASSERT( nodes.GetSize() >= ( 100 * 200 ) + 2 );
+
+        // Names are only resolved in parallel with helper threads
+        if ( ( numThreads[ i ] == 1 ) || ( Env::GetNumProcessors() == 1 ) )
+        {
+            TEST_ASSERT( fBuild.GetNumParallelParseLoops() == 0 );
+        }
+        else
+        {
+            TEST_ASSERT( fBuild.GetNumParallelParseLoops() >= 100 );
+        }
+
+        fBuild.SerializeDepGraphToText( "All", graphs[ i ] );
+
+        OUTPUT( "Parse with %u thread(s) : %2.3fs\n", numThreads[ i ], (double)parseTime );
+    }
+
+    // Resulting graph must be identical
+    TEST_ASSERT( graphs[ 0 ].IsEmpty() == false );
+    TEST_ASSERT( graphs[ 0 ] == graphs[ 1 ] );
+
+    // Loading the DB without parsing the BFF doesn't need helper threads
+    const char * const dbFile = "../tmp/Test/Graph/ParallelParse/fbuild.fdb";
+    {
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( dbFile ) );
+    }
+    {
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( dbFile ) );
+        TEST_ASSERT( fBuild.GetNumParallelParseLoops() == 0 );
+        TEST_ASSERT( fBuild.GetThreadPool() == nullptr );
+    }
+}
+
 // TestNoStopOnFirstError
 //------------------------------------------------------------------------------
 void TestGraph::TestNoStopOnFirstError() const
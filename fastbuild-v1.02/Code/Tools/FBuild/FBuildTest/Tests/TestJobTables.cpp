@@ -0,0 +1,355 @@
+// TestJobTables.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "FBuildTest.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/WorkerPool/Job.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/JobTables.h"
+
+// Core
+#include "Core/Math/Conversions.h"
+#include "Core/Math/Random.h"
+#include "Core/Mem/Mem.h"
+
+// TestJobTables
+//------------------------------------------------------------------------------
+class TestJobTables : public FBuildTest
+{
+private:
+    DECLARE_TESTS
+
+    void CostHeapOrder() const;
+    void CostHeapStress() const;
+    void CostHeapFilter() const;
+    void IdTableStress() const;
+    void DistributionStress() const;
+
+    // Helpers
+    static void CreateJobs( size_t numJobs, Array< Job * > & outJobs );
+    static void DeleteJobs( Array< Job * > & jobs );
+    static bool IsJobInList( const Job * job, const void * jobs );
+};
+
+// Register Tests
+//------------------------------------------------------------------------------
+REGISTER_TESTS_BEGIN( TestJobTables )
+    REGISTER_TEST( CostHeapOrder )
+    REGISTER_TEST( CostHeapStress )
+    REGISTER_TEST( CostHeapFilter )
+    REGISTER_TEST( IdTableStress )
+    REGISTER_TEST( DistributionStress )
+REGISTER_TESTS_END
+
+// CostHeapOrder
+//------------------------------------------------------------------------------
+void TestJobTables::CostHeapOrder() const
+{
+    Array< Job * > jobs;
+    CreateJobs( 6, jobs );
+
+    JobCostHeap heap( 4 );
+    TEST_ASSERT( heap.Pop() == nullptr );
+
+    // Most expensive first, then in the order they were added
+    heap.Push( jobs[ 0 ], 10 );
+    heap.Push( jobs[ 1 ], 30 );
+    heap.Push( jobs[ 2 ], 10 );
+    heap.Push( jobs[ 3 ], 20 );
+    heap.Push( jobs[ 4 ], 30 );
+    heap.Push( jobs[ 5 ], 10 );
+    TEST_ASSERT( heap.GetSize() == 6 );
+    TEST_ASSERT( heap.Pop() == jobs[ 1 ] );
+    TEST_ASSERT( heap.Pop() == jobs[ 4 ] );
+    TEST_ASSERT( heap.Pop() == jobs[ 3 ] );
+
+    // A re-queued job goes behind others of equal cost
+    heap.Push( jobs[ 1 ], 10 );
+    TEST_ASSERT( heap.Pop() == jobs[ 0 ] );
+    TEST_ASSERT( heap.Pop() == jobs[ 2 ] );
+    TEST_ASSERT( heap.Pop() == jobs[ 5 ] );
+    TEST_ASSERT( heap.Pop() == jobs[ 1 ] );
+    TEST_ASSERT( heap.IsEmpty() );
+    TEST_ASSERT( heap.Pop() == nullptr );
+
+    DeleteJobs( jobs );
+}
+
+// CostHeapStress
+//------------------------------------------------------------------------------
+void TestJobTables::CostHeapStress() const
+{
+    const size_t numJobs = 20000;
+    Array< Job * > jobs;
+    CreateJobs( numJobs, jobs );
+
+    Random r( 0x1234 );
+    JobCostHeap heap( 16 );
+
+    // Costs of jobs, for validation
+    Array< uint32_t > costs( numJobs, false );
+    costs.SetSize( numJobs );
+
+    // Interleave pushes and pops, checking each pop against the items remaining
+    Array< uint32_t > remaining( numJobs, false ); // indices into jobs
+    size_t nextJob = 0;
+    while ( ( nextJob < numJobs ) || ( remaining.IsEmpty() == false ) )
+    {
+        // Push a batch
+        const size_t numToPush = Math::Min< size_t >( r.GetRandIndex( 64 ), numJobs - nextJob );
+        for ( size_t i = 0; i < numToPush; ++i )
+        {
+            costs[ nextJob ] = r.GetRandIndex( 16 ); // many collisions
+            heap.Push( jobs[ nextJob ], costs[ nextJob ] );
+            remaining.Append( (uint32_t)nextJob );
+            ++nextJob;
+        }
+
+        // Pop a batch
+        const size_t numToPop = Math::Min< size_t >( r.GetRandIndex( 64 ), remaining.GetSize() );
+        for ( size_t i = 0; i < numToPop; ++i )
+        {
+            // Expected is most expensive, and earliest of those (remaining is in push order)
+            uint32_t * expected = remaining.Begin();
+            for ( uint32_t * it = remaining.Begin(); it != remaining.End(); ++it )
+            {
+                if ( costs[ *it ] > costs[ *expected ] )
+                {
+                    expected = it;
+                }
+            }
+            TEST_ASSERT( heap.Pop() == jobs[ *expected ] );
+            remaining.Erase( expected );
+        }
+        TEST_ASSERT( heap.GetSize() == remaining.GetSize() );
+    }
+
+    TEST_ASSERT( heap.IsEmpty() );
+
+    DeleteJobs( jobs );
+}
+
+// CostHeapFilter
+//------------------------------------------------------------------------------
+void TestJobTables::CostHeapFilter() const
+{
+    Array< Job * > jobs;
+    CreateJobs( 6, jobs );
+
+    JobCostHeap heap( 4 );
+    heap.Push( jobs[ 0 ], 10 );
+    heap.Push( jobs[ 1 ], 30 );
+    heap.Push( jobs[ 2 ], 10 );
+    heap.Push( jobs[ 3 ], 20 );
+    heap.Push( jobs[ 4 ], 30 );
+    heap.Push( jobs[ 5 ], 10 );
+
+    // Nothing accepted
+    Array< Job * > accepted( 4, true );
+    TEST_ASSERT( heap.FindHighestPriority( IsJobInList, &accepted ) == (size_t)-1 );
+
+    // Most expensive accepted job, then the earliest of those
+    accepted.Append( jobs[ 5 ] );
+    accepted.Append( jobs[ 2 ] );
+    accepted.Append( jobs[ 3 ] );
+    size_t index = heap.FindHighestPriority( IsJobInList, &accepted );
+    TEST_ASSERT( heap.Remove( index ) == jobs[ 3 ] );
+    index = heap.FindHighestPriority( IsJobInList, &accepted );
+    TEST_ASSERT( heap.Remove( index ) == jobs[ 2 ] );
+
+    // Remaining jobs keep their order
+    TEST_ASSERT( heap.Pop() == jobs[ 1 ] );
+    TEST_ASSERT( heap.Pop() == jobs[ 4 ] );
+    TEST_ASSERT( heap.Pop() == jobs[ 0 ] );
+    TEST_ASSERT( heap.Pop() == jobs[ 5 ] );
+    TEST_ASSERT( heap.IsEmpty() );
+
+    // Removing from anywhere keeps the heap valid
+    const size_t numJobs = 2000;
+    DeleteJobs( jobs );
+    CreateJobs( numJobs, jobs );
+    Random r( 0x1234 );
+    Array< uint32_t > costs( numJobs, false );
+    costs.SetSize( numJobs );
+    for ( size_t i = 0; i < numJobs; ++i )
+    {
+        costs[ i ] = r.GetRandIndex( 16 ); // many collisions
+        heap.Push( jobs[ i ], costs[ i ] );
+    }
+    for ( size_t i = 0; i < ( numJobs / 2 ); ++i )
+    {
+        heap.Remove( r.GetRandIndex( (uint32_t)heap.GetSize() ) );
+    }
+    uint32_t lastCost = 0xFFFFFFFF;
+    while ( Job * job = heap.Pop() )
+    {
+        const uint32_t cost = costs[ (size_t)( jobs.Find( job ) - jobs.Begin() ) ];
+        TEST_ASSERT( cost <= lastCost );
+        lastCost = cost;
+    }
+
+    DeleteJobs( jobs );
+}
+
+// IdTableStress
+//------------------------------------------------------------------------------
+void TestJobTables::IdTableStress() const
+{
+    const size_t numJobs = 20000;
+    Array< Job * > jobs;
+    CreateJobs( numJobs, jobs );
+
+    Random r( 0x5678 );
+    JobIdTable table( 0 );
+
+    // Track which jobs are in the table
+    Array< bool > inTable( numJobs, false );
+    inTable.SetSize( numJobs );
+    for ( bool & in : inTable )
+    {
+        in = false;
+    }
+    size_t numInTable = 0;
+
+    for ( size_t i = 0; i < 200000; ++i )
+    {
+        const uint32_t index = r.GetRandIndex( (uint32_t)numJobs );
+        Job * job = jobs[ index ];
+        switch ( r.GetRandIndex( 3 ) )
+        {
+            case 0: // Add
+            {
+                if ( inTable[ index ] == false )
+                {
+                    table.Add( job );
+                    inTable[ index ] = true;
+                    ++numInTable;
+                }
+                break;
+            }
+            case 1: // Remove
+            {
+                if ( inTable[ index ] )
+                {
+                    table.Remove( job );
+                    inTable[ index ] = false;
+                    --numInTable;
+                }
+                break;
+            }
+            default: // Find
+            {
+                TEST_ASSERT( table.Find( job->GetJobId() ) == ( inTable[ index ] ? job : nullptr ) );
+                break;
+            }
+        }
+        TEST_ASSERT( table.GetSize() == numInTable );
+    }
+
+    // Every job can be found (or not) as expected
+    for ( size_t i = 0; i < numJobs; ++i )
+    {
+        TEST_ASSERT( table.Find( jobs[ i ]->GetJobId() ) == ( inTable[ i ] ? jobs[ i ] : nullptr ) );
+    }
+
+    // Iteration visits each job once (JobIds are sequential)
+    for ( size_t i = 0; i < table.GetSize(); ++i )
+    {
+        const size_t index = ( table.GetJob( i )->GetJobId() - jobs[ 0 ]->GetJobId() );
+        TEST_ASSERT( index < numJobs );
+        TEST_ASSERT( jobs[ index ] == table.GetJob( i ) );
+        TEST_ASSERT( inTable[ index ] );
+        inTable[ index ] = false;
+    }
+
+    // Empty the table
+    while ( table.IsEmpty() == false )
+    {
+        Job * job = table.GetJob( r.GetRandIndex( (uint32_t)table.GetSize() ) );
+        table.Remove( job );
+        TEST_ASSERT( table.Find( job->GetJobId() ) == nullptr );
+    }
+
+    DeleteJobs( jobs );
+}
+
+// DistributionStress
+//------------------------------------------------------------------------------
+void TestJobTables::DistributionStress() const
+{
+    // Simulate a large distributed build: jobs are taken from the available heap,
+    // tracked in progress by many remote slots, and either completed or returned
+    // for another attempt
+    const size_t numJobs = 20000;
+    const size_t numSlots = 300;
+    Array< Job * > jobs;
+    CreateJobs( numJobs, jobs );
+
+    Random r( 0x9ABC );
+    JobCostHeap available( 1024 );
+    JobIdTable inProgress( 1024 );
+    for ( Job * job : jobs )
+    {
+        available.Push( job, r.GetRandIndex( 1000 ) );
+    }
+
+    size_t numCompleted = 0;
+    while ( numCompleted < numJobs )
+    {
+        // Fill free slots
+        while ( ( inProgress.GetSize() < numSlots ) && ( available.IsEmpty() == false ) )
+        {
+            inProgress.Add( available.Pop() );
+        }
+
+        // A random job returns
+        Job * job = inProgress.GetJob( r.GetRandIndex( (uint32_t)inProgress.GetSize() ) );
+        TEST_ASSERT( inProgress.Find( job->GetJobId() ) == job );
+        inProgress.Remove( job );
+        if ( r.GetRandIndex( 10 ) == 0 )
+        {
+            available.Push( job, 0 ); // Failed - try again
+        }
+        else
+        {
+            ++numCompleted;
+        }
+    }
+    TEST_ASSERT( available.IsEmpty() );
+    TEST_ASSERT( inProgress.IsEmpty() );
+
+    DeleteJobs( jobs );
+}
+
+// CreateJobs
+//------------------------------------------------------------------------------
+/*static*/ void TestJobTables::CreateJobs( size_t numJobs, Array< Job * > & outJobs )
+{
+    outJobs.SetCapacity( numJobs );
+    for ( size_t i = 0; i < numJobs; ++i )
+    {
+        outJobs.Append( FNEW( Job( nullptr ) ) );
+    }
+}
+
+// DeleteJobs
+//------------------------------------------------------------------------------
+/*static*/ void TestJobTables::DeleteJobs( Array< Job * > & jobs )
+{
+    for ( Job * job : jobs )
+    {
+        FDELETE job;
+    }
+    jobs.Clear();
+}
+
+// IsJobInList
+//------------------------------------------------------------------------------
+/*static*/ bool TestJobTables::IsJobInList( const Job * job, const void * jobs )
+{
+    return ( static_cast< const Array< Job * > * >( jobs )->Find( const_cast< Job * >( job ) ) != nullptr );
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,260 @@
+// TestMonitorStream.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "FBuildTest.h"
+
+// FBuild
+#include "Tools/FBuild/FBuildCore/FBuild.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildTrace.h"
+#include "Tools/FBuild/FBuildCore/Helpers/MonitorStream.h"
+#include "Tools/FBuild/FBuildCore/Protocol/Protocol.h"
+#include "Tools/FBuild/FBuildCore/Protocol/Server.h"
+
+// Core
+#include "Core/Containers/Array.h"
+#include "Core/Process/SystemMutex.h"
+#include "Core/Strings/AStackString.h"
+
+// Defines
+//------------------------------------------------------------------------------
+#define TEST_PROTOCOL_PORT ( Protocol::PROTOCOL_PORT + 1 ) // Avoid conflict with real worker
+
+// TestMonitorStream
+//------------------------------------------------------------------------------
+class TestMonitorStream : public FBuildTest
+{
+private:
+    DECLARE_TESTS
+
+    void RingBuffer() const;
+    void Local() const;
+    void Distributed() const;
+
+    // Helpers
+    void ReadAll( MonitorStreamReader & reader, Array< MonitorStreamReader::Event > & outEvents ) const;
+    uint32_t Count( const Array< MonitorStreamReader::Event > & events, MonitorStream::EventType type ) const;
+
+    const char * const mConfigFile = "Tools/FBuild/FBuildTest/Data/TestMonitorStream/fbuild.bff";
+
+    TestMonitorStream & operator = ( TestMonitorStream & other ) = delete; // Avoid warnings about implicit deletion of operators
+};
+
+// Register Tests
+//------------------------------------------------------------------------------
+REGISTER_TESTS_BEGIN( TestMonitorStream )
+    REGISTER_TEST( RingBuffer )
+    REGISTER_TEST( Local )
+    REGISTER_TEST( Distributed )
+REGISTER_TESTS_END
+
+// RingBuffer
+//------------------------------------------------------------------------------
+void TestMonitorStream::RingBuffer() const
+{
+    const char * const name = "FBuildMonitorStreamTest";
+
+    // Nothing to read before the stream exists
+    {
+        MonitorStreamReader reader;
+        TEST_ASSERT( reader.Open( name ) == false );
+    }
+
+    // Only one process can publish under a given name
+    {
+        AStackString<> lockName;
+        MonitorStream::GetLockName( name, lockName );
+        SystemMutex otherProcess( lockName.Get() );
+        TEST_ASSERT( otherProcess.TryLock() );
+        TEST_ASSERT( MonitorStream::Open( name, 256 * 1024 ) == false );
+    }
+
+    // but the lock is per name
+    {
+        SystemMutex otherStream( "FASTBuildMonitorStream_OtherStream" );
+        TEST_ASSERT( otherStream.TryLock() );
+        TEST_ASSERT( MonitorStream::Open( name, 256 * 1024 ) );
+    }
+
+    MonitorStreamReader reader;
+    TEST_ASSERT( reader.Open( name ) );
+
+    MonitorStreamReader::Event event;
+    TEST_ASSERT( reader.ReadEvent( event ) == false );
+
+    // Events are read back in order
+    for ( uint32_t i = 0; i < 10; ++i )
+    {
+        MonitorStream::Progress( (float)i );
+    }
+    for ( uint32_t i = 0; i < 10; ++i )
+    {
+        TEST_ASSERT( reader.ReadEvent( event ) );
+        TEST_ASSERT( event.m_Type == MonitorStream::EVENT_PROGRESS );
+        TEST_ASSERT( event.m_Value == ( i * 100 ) );
+    }
+    TEST_ASSERT( reader.ReadEvent( event ) == false );
+
+    // Writer laps the reader (more than a ring buffer of events)
+    for ( uint32_t i = 0; i < 20000; ++i )
+    {
+        MonitorStream::Progress( 1.0f );
+    }
+    TEST_ASSERT( reader.ReadEvent( event ) == false );
+    TEST_ASSERT( reader.GetNumOverruns() == 1 );
+
+    // Reader recovers, including across wrapping at the end of the ring
+    for ( uint32_t j = 0; j < 20; ++j )
+    {
+        for ( uint32_t i = 0; i < 1000; ++i )
+        {
+            MonitorStream::Progress( (float)i );
+        }
+        for ( uint32_t i = 0; i < 1000; ++i )
+        {
+            TEST_ASSERT( reader.ReadEvent( event ) );
+            TEST_ASSERT( event.m_Type == MonitorStream::EVENT_PROGRESS );
+            TEST_ASSERT( event.m_Value == ( i * 100 ) );
+        }
+    }
+    TEST_ASSERT( reader.GetNumOverruns() == 1 );
+
+    MonitorStream::Close();
+    TEST_ASSERT( MonitorStream::IsEnabled() == false );
+}
+
+// Local
+//------------------------------------------------------------------------------
+void TestMonitorStream::Local() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = mConfigFile;
+    options.m_ForceCleanBuild = true;
+    options.m_EnableMonitorStream = true;
+
+    FBuildForTest fBuild( options );
+    TEST_ASSERT( fBuild.Initialize() );
+
+    // Attach before the build
+    MonitorStreamReader reader;
+    TEST_ASSERT( reader.Open() );
+
+    TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+
+    Array< MonitorStreamReader::Event > events;
+    ReadAll( reader, events );
+
+    // Build is bracketed by start/stop
+    TEST_ASSERT( events.GetSize() > 2 );
+    TEST_ASSERT( events[ 0 ].m_Type == MonitorStream::EVENT_START_BUILD );
+    TEST_ASSERT( events.Top().m_Type == MonitorStream::EVENT_STOP_BUILD );
+
+    // Each job has a start and finish
+    TEST_ASSERT( Count( events, MonitorStream::EVENT_JOB_START ) == 2 );
+    TEST_ASSERT( Count( events, MonitorStream::EVENT_JOB_FINISH ) == 2 );
+    uint32_t numCompilePhases = 0;
+    for ( const MonitorStreamReader::Event & event : events )
+    {
+        if ( event.m_Type == MonitorStream::EVENT_JOB_FINISH )
+        {
+            TEST_ASSERT( event.m_SubType == MonitorStream::RESULT_SUCCESS );
+            TEST_ASSERT( event.m_WorkerName == "local" );
+            TEST_ASSERT( event.m_NodeName.Find( "MonitorStream" ) );
+        }
+        else if ( event.m_Type == MonitorStream::EVENT_JOB_PHASE )
+        {
+            TEST_ASSERT( event.m_JobId != 0 );
+            numCompilePhases += ( event.m_SubType == BuildTrace::PHASE_COMPILE ) ? 1 : 0;
+        }
+    }
+    TEST_ASSERT( numCompilePhases == 2 );
+    TEST_ASSERT( reader.GetNumOverruns() == 0 );
+}
+
+// Distributed
+//------------------------------------------------------------------------------
+void TestMonitorStream::Distributed() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = mConfigFile;
+    options.m_ForceCleanBuild = true;
+    options.m_AllowDistributed = true;
+    options.m_NumWorkerThreads = 1;
+    options.m_NoLocalConsumptionOfRemoteJobs = true; // ensure all jobs happen on the remote worker
+    options.m_AllowLocalRace = false;
+    options.m_DistributionPort = TEST_PROTOCOL_PORT;
+    options.m_EnableMonitorStream = true;
+    options.m_EnableMonitor = true; // Text log is still written alongside the stream
+
+    FBuildForTest fBuild( options );
+    TEST_ASSERT( fBuild.Initialize() );
+
+    MonitorStreamReader reader;
+    TEST_ASSERT( reader.Open() );
+
+    // start a client to emulate the other end
+    Server s( 1 );
+    s.Listen( TEST_PROTOCOL_PORT );
+
+    TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+
+    Array< MonitorStreamReader::Event > events;
+    ReadAll( reader, events );
+
+    // Local preprocessing and remote compilation
+    uint32_t numPreprocessed = 0;
+    uint32_t numRemoteStarts = 0;
+    uint32_t numRemoteSuccess = 0;
+    for ( const MonitorStreamReader::Event & event : events )
+    {
+        if ( event.m_Type == MonitorStream::EVENT_JOB_FINISH )
+        {
+            if ( event.m_SubType == MonitorStream::RESULT_SUCCESS_PREPROCESSED )
+            {
+                TEST_ASSERT( event.m_WorkerName == "local" );
+                ++numPreprocessed;
+            }
+            else if ( ( event.m_SubType == MonitorStream::RESULT_SUCCESS ) && ( event.m_WorkerName == "127.0.0.1" ) )
+            {
+                ++numRemoteSuccess;
+            }
+        }
+        else if ( ( event.m_Type == MonitorStream::EVENT_JOB_START ) && ( event.m_WorkerName == "127.0.0.1" ) )
+        {
+            ++numRemoteStarts;
+        }
+    }
+    TEST_ASSERT( numPreprocessed == 2 );
+    TEST_ASSERT( numRemoteStarts == 2 );
+    TEST_ASSERT( numRemoteSuccess == 2 );
+}
+
+// ReadAll
+//------------------------------------------------------------------------------
+void TestMonitorStream::ReadAll( MonitorStreamReader & reader, Array< MonitorStreamReader::Event > & outEvents ) const
+{
+    MonitorStreamReader::Event event;
+    while ( reader.ReadEvent( event ) )
+    {
+        // Progress is time based, so not deterministic
+        if ( event.m_Type != MonitorStream::EVENT_PROGRESS )
+        {
+            outEvents.Append( event );
+        }
+    }
+}
+
+// Count
+//------------------------------------------------------------------------------
+uint32_t TestMonitorStream::Count( const Array< MonitorStreamReader::Event > & events, MonitorStream::EventType type ) const
+{
+    uint32_t count = 0;
+    for ( const MonitorStreamReader::Event & event : events )
+    {
+        count += ( event.m_Type == type ) ? 1 : 0;
+    }
+    return count;
+}
+
+//------------------------------------------------------------------------------
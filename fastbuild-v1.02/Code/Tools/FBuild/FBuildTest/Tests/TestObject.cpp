@@ -31,6 +31,7 @@ private:
     void TestStaleDynamicDeps() const;
     void ModTimeChangeBackwards() const;
     void CacheUsingRelativePaths() const;
+    void CacheUsingRootMappings() const;
     void SourceMapping() const;
 };
 
@@ -42,6 +43,7 @@ REGISTER_TESTS_BEGIN( TestObject )
     REGISTER_TEST( TestStaleDynamicDeps )       // Test dynamic deps are cleared when necessary
     REGISTER_TEST( ModTimeChangeBackwards )
     REGISTER_TEST( CacheUsingRelativePaths )
+    REGISTER_TEST( CacheUsingRootMappings )
     REGISTER_TEST( SourceMapping )
 REGISTER_TESTS_END
 
@@ -419,6 +421,88 @@ void TestObject::CacheUsingRelativePaths() const
     }
 }
 
+// CacheUsingRootMappings
+//------------------------------------------------------------------------------
+void TestObject::CacheUsingRootMappings() const
+{
+    // Source files
+    const char * srcPath = "Tools/FBuild/FBuildTest/Data/TestObject/CacheUsingRootMappings/";
+    const char * fileA = "File.cpp";
+    const char * fileB = "Subdir/Header.h";
+    const char * fileC = "fbuild.bff";
+    const char * files[] = { fileA, fileB, fileC };
+
+    // Two checkouts of the same code
+    const char * dstPathA = "../tmp/Test/Object/CacheUsingRootMappings/A/Code";
+    const char * dstPathB = "../tmp/Test/Object/CacheUsingRootMappings/B/Code";
+    const char * dstPaths[] = { dstPathA, dstPathB };
+
+    #if defined( __WINDOWS__ )
+        const char * objFileName = "out/File.obj";
+    #else
+        const char * objFileName = "out/File.o";
+    #endif
+
+    // Copy file structure to both destinations
+    for ( const char * dstPath : dstPaths )
+    {
+        for ( const char * file : files )
+        {
+            AStackString<> src, dst;
+            src.Format( "%s/%s", srcPath, file );
+            dst.Format( "%s/%s", dstPath, file );
+            TEST_ASSERT( FileIO::EnsurePathExistsForFile( dst ) );
+            TEST_ASSERT( FileIO::FileCopy( src.Get(), dst.Get() ) );
+        }
+    }
+    AStackString<> objFileB;
+    objFileB.Format( "%s/%s", dstPathB, objFileName );
+    EnsureFileDoesNotExist( objFileB );
+
+    // Build in checkout A, writing to the cache
+    {
+        FBuildTestOptions options;
+        options.m_ConfigFile = "fbuild.bff";
+        options.m_UseCacheWrite = true;
+        options.m_ForceCleanBuild = true;
+        AStackString<> codeDir;
+        GetCodeDir( codeDir );
+        codeDir.Trim( 0, 5 ); // Remove Code/
+        codeDir += "tmp/Test/Object/CacheUsingRootMappings/A/Code/";
+        options.SetWorkingDir( codeDir );
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+
+        TEST_ASSERT( fBuild.Build( AStackString<>( "ObjectList" ) ) );
+
+        TEST_ASSERT( fBuild.GetStats().GetCacheStores() == 1 );
+    }
+
+    // Build in checkout B, reading the result of A from the cache
+    {
+        FBuildTestOptions options;
+        options.m_ConfigFile = "fbuild.bff";
+        options.m_UseCacheRead = true;
+        options.m_ForceCleanBuild = true;
+        AStackString<> codeDir;
+        GetCodeDir( codeDir );
+        codeDir.Trim( 0, 5 ); // Remove Code/
+        codeDir += "tmp/Test/Object/CacheUsingRootMappings/B/Code/";
+        options.SetWorkingDir( codeDir );
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+
+        TEST_ASSERT( fBuild.Build( AStackString<>( "ObjectList" ) ) );
+
+        TEST_ASSERT( fBuild.GetStats().GetCacheHits() == 1 );
+
+        // Working dir was changed by the build, so check using the full path
+        AStackString<> objFile( codeDir );
+        objFile += objFileName;
+        EnsureFileExists( objFile );
+    }
+}
+
 // SourceMapping
 //------------------------------------------------------------------------------
 void TestObject::SourceMapping() const
@@ -11,6 +11,7 @@
 #include "Tools/FBuild/FBuildCore/Graph/TestNode.h"
 
 #include "Core/FileIO/FileIO.h"
+#include "Core/FileIO/FileStream.h"
 #include "Core/Strings/AStackString.h"
 
 // TestTest
@@ -27,6 +28,7 @@ private:
     void Fail_Crash() const;
     void TimeOut() const;
     void Exclusions() const;
+    void Sharding() const;
 };
 
 // Register Tests
@@ -39,6 +41,7 @@ REGISTER_TESTS_BEGIN( TestTest )
     REGISTER_TEST( Fail_Crash )
     REGISTER_TEST( TimeOut )
     REGISTER_TEST( Exclusions )
+    REGISTER_TEST( Sharding )
 REGISTER_TESTS_END
 
 // CreateNode
@@ -204,4 +207,67 @@ void TestTest::Exclusions() const
     }
 }
 
+// Sharding
+//------------------------------------------------------------------------------
+void TestTest::Sharding() const
+{
+    const char * const shardOutputs[] =
+    {
+        "../tmp/Test/Test/Sharding/testoutput.txt.shard0",
+        "../tmp/Test/Test/Sharding/testoutput.txt.shard1",
+        "../tmp/Test/Test/Sharding/testoutput.txt.shard2",
+    };
+    const AStackString<> testOutput( "../tmp/Test/Test/Sharding/testoutput.txt" );
+
+    // Run each shard, storing the results
+    {
+        FBuildTestOptions options;
+        options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestTest/Sharding/fbuild.bff";
+        options.m_ForceCleanBuild = true;
+        options.m_UseCacheWrite = true;
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+
+        TEST_ASSERT( fBuild.Build( "Sharding" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( "../tmp/Test/Test/Sharding/fbuild.fdb" ) );
+
+        // 3 shards and the Test() merging them
+        const FBuildStats::Stats & testStats = fBuild.GetStats().GetStatsFor( Node::TEST_NODE );
+        TEST_ASSERT( testStats.m_NumBuilt == 4 );
+        TEST_ASSERT( testStats.m_NumCacheStores == 3 );
+    }
+
+    // The merged output has each shard
+    {
+        FileStream fs;
+        TEST_ASSERT( fs.Open( testOutput.Get(), FileStream::READ_ONLY ) );
+        AString output;
+        output.SetLength( (uint32_t)fs.GetFileSize() );
+        TEST_ASSERT( fs.ReadBuffer( output.Get(), output.GetLength() ) == output.GetLength() );
+        TEST_ASSERT( output.Find( "Shard 0 of 3" ) );
+        TEST_ASSERT( output.Find( "Shard 1 of 3" ) );
+        TEST_ASSERT( output.Find( "Shard 2 of 3" ) );
+    }
+
+    // Remove the results so the shards must run again, which the cache avoids
+    for ( const char * const shardOutput : shardOutputs )
+    {
+        EnsureFileDoesNotExist( shardOutput );
+    }
+    EnsureFileDoesNotExist( testOutput );
+    {
+        FBuildTestOptions options;
+        options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestTest/Sharding/fbuild.bff";
+        options.m_UseCacheRead = true;
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( "../tmp/Test/Test/Sharding/fbuild.fdb" ) );
+
+        TEST_ASSERT( fBuild.Build( "Sharding" ) );
+
+        const FBuildStats::Stats & testStats = fBuild.GetStats().GetStatsFor( Node::TEST_NODE );
+        TEST_ASSERT( testStats.m_NumCacheHits == 3 );
+        EnsureFileExists( testOutput );
+    }
+}
+
 //------------------------------------------------------------------------------
@@ -0,0 +1,563 @@
+// TestToolManifest.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "FBuildTest.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/FBuild.h"
+#include "Tools/FBuild/FBuildCore/Graph/CompilerNode.h"
+#include "Tools/FBuild/FBuildCore/Helpers/Compressor.h"
+#include "Tools/FBuild/FBuildCore/Helpers/ToolManifest.h"
+#include "Tools/FBuild/FBuildCore/Protocol/Server.h"
+
+// Core
+#include "Core/Containers/AutoPtr.h"
+#include "Core/Env/Env.h"
+#include "Core/FileIO/ConstMemoryStream.h"
+#include "Core/FileIO/FileIO.h"
+#include "Core/FileIO/MemoryStream.h"
+#include "Core/FileIO/PathUtils.h"
+#include "Core/Math/xxHash.h"
+#include "Core/Strings/AStackString.h"
+
+#include <memory.h>
+#include <stdlib.h>
+
+// TestToolManifest
+//------------------------------------------------------------------------------
+class TestToolManifest : public FBuildTest
+{
+private:
+    DECLARE_TESTS
+
+    void HashFile() const;
+    void CompressOnDemand() const;
+    void ModifiedFile() const;
+    void CacheLimit() const;
+    void ManyFiles() const;
+    void ReceiveMismatchedData() const;
+    void Store() const;
+    void StoreEviction() const;
+
+    // Helpers
+    void MakeRemoteToolchain( uint32_t seed, ToolManifest & outManifest ) const;
+    static void SetTempDir( const char * path );
+    void MakeTestFile( const char * fileName, uint32_t seed, AString & outContents ) const;
+    void CheckFileData( const ToolManifestFile & file, const AString & expectedContents ) const;
+};
+
+// Register Tests
+//------------------------------------------------------------------------------
+REGISTER_TESTS_BEGIN( TestToolManifest )
+    REGISTER_TEST( HashFile )
+    REGISTER_TEST( CompressOnDemand )
+    REGISTER_TEST( ModifiedFile )
+    REGISTER_TEST( CacheLimit )
+    REGISTER_TEST( ManyFiles )
+    REGISTER_TEST( ReceiveMismatchedData )
+    REGISTER_TEST( Store )
+    REGISTER_TEST( StoreEviction )
+REGISTER_TESTS_END
+
+// HashFile
+//------------------------------------------------------------------------------
+void TestToolManifest::HashFile() const
+{
+    EnsureDirExists( "../tmp/Test/ToolManifest/" );
+    AStackString<> contents;
+    MakeTestFile( "../tmp/Test/ToolManifest/HashFile.txt", 1, contents );
+
+    ToolManifestFile file( AStackString<>( "../tmp/Test/ToolManifest/HashFile.txt" ), 0, 0, 0 );
+    TEST_ASSERT( file.DoBuild() );
+
+    // Hash is 64 bit
+    TEST_ASSERT( file.GetHash() == xxHash::Calc64( contents.Get(), contents.GetLength() ) );
+    TEST_ASSERT( file.GetUncompressedContentSize() == contents.GetLength() );
+    TEST_ASSERT( file.GetTimeStamp() != 0 );
+
+    // Content is not compressed or kept in memory when hashing
+    TEST_ASSERT( file.IsCompressedContentCached() == false );
+}
+
+// CompressOnDemand
+//------------------------------------------------------------------------------
+void TestToolManifest::CompressOnDemand() const
+{
+    EnsureDirExists( "../tmp/Test/ToolManifest/" );
+    AStackString<> contents;
+    MakeTestFile( "../tmp/Test/ToolManifest/CompressOnDemand.txt", 2, contents );
+
+    const size_t cacheSizeBefore = ToolManifestFile::GetCompressedContentCacheSize();
+    {
+        ToolManifestFile file( AStackString<>( "../tmp/Test/ToolManifest/CompressOnDemand.txt" ), 0, 0, 0 );
+        TEST_ASSERT( file.DoBuild() );
+        TEST_ASSERT( ToolManifestFile::GetCompressedContentCacheSize() == cacheSizeBefore );
+
+        // First request compresses and caches the data
+        CheckFileData( file, contents );
+        TEST_ASSERT( file.IsCompressedContentCached() );
+        const size_t cacheSize = ToolManifestFile::GetCompressedContentCacheSize();
+        TEST_ASSERT( cacheSize > cacheSizeBefore );
+
+        // Subsequent requests are served from the cache
+        CheckFileData( file, contents );
+        TEST_ASSERT( ToolManifestFile::GetCompressedContentCacheSize() == cacheSize );
+    }
+
+    // Destroying the file releases the cached data
+    TEST_ASSERT( ToolManifestFile::GetCompressedContentCacheSize() == cacheSizeBefore );
+}
+
+// ModifiedFile
+//------------------------------------------------------------------------------
+void TestToolManifest::ModifiedFile() const
+{
+    EnsureDirExists( "../tmp/Test/ToolManifest/" );
+    const char * const fileName = "../tmp/Test/ToolManifest/ModifiedFile.txt";
+    AStackString<> contents;
+    MakeTestFile( fileName, 3, contents );
+
+    ToolManifestFile file( AStackString<>( fileName ), 0, 0, 0 );
+    TEST_ASSERT( file.DoBuild() );
+
+    // Contents changed after hashing (same size) are not sent under the old hash
+    AStackString<> modifiedContents;
+    MakeTestFile( fileName, 4, modifiedContents );
+    TEST_ASSERT( modifiedContents.GetLength() == contents.GetLength() );
+    size_t dataSize = 0;
+    AutoPtr< void > data( file.GetFileData( dataSize ) );
+    TEST_ASSERT( data.Get() == nullptr );
+    TEST_ASSERT( file.IsCompressedContentCached() == false );
+
+    // Once hashed again, the new contents are sent
+    ToolManifestFile rehashedFile( AStackString<>( fileName ), 0, 0, 0 );
+    TEST_ASSERT( rehashedFile.DoBuild() );
+    CheckFileData( rehashedFile, modifiedContents );
+}
+
+// CacheLimit
+//------------------------------------------------------------------------------
+void TestToolManifest::CacheLimit() const
+{
+    EnsureDirExists( "../tmp/Test/ToolManifest/CacheLimit/" );
+
+    const uint32_t numFiles = 8;
+    AString contents[ numFiles ];
+    Array< ToolManifestFile > files( numFiles, true );
+    for ( uint32_t i = 0; i < numFiles; ++i )
+    {
+        AStackString<> fileName;
+        fileName.Format( "../tmp/Test/ToolManifest/CacheLimit/File%u.txt", i );
+        MakeTestFile( fileName.Get(), 100 + i, contents[ i ] );
+        files.EmplaceBack( fileName, (uint64_t)0, (uint64_t)0, (uint32_t)0 );
+        TEST_ASSERT( files[ i ].DoBuild() );
+    }
+
+    // Find the compressed size of one file
+    size_t compressedSize = 0;
+    {
+        AutoPtr< void > data( files[ 0 ].GetFileData( compressedSize ) );
+        TEST_ASSERT( data.Get() );
+    }
+
+    // Limit the cache to (roughly) 3 files
+    const size_t defaultLimit = ToolManifestFile::GetCompressedContentCacheLimit();
+    ToolManifestFile::SetCompressedContentCacheLimit( ( compressedSize * 3 ) + ( compressedSize / 2 ) );
+
+    // Request each file in turn
+    for ( uint32_t i = 0; i < numFiles; ++i )
+    {
+        CheckFileData( files[ i ], contents[ i ] );
+        TEST_ASSERT( files[ i ].IsCompressedContentCached() );
+    }
+
+    // Only the most recently requested files remain
+    for ( uint32_t i = 0; i < numFiles; ++i )
+    {
+        TEST_ASSERT( files[ i ].IsCompressedContentCached() == ( i >= ( numFiles - 3 ) ) );
+    }
+
+    // Using a file keeps it in the cache
+    CheckFileData( files[ numFiles - 3 ], contents[ numFiles - 3 ] ); // Now most recently used
+    CheckFileData( files[ 0 ], contents[ 0 ] ); // Evicts least recently used
+    TEST_ASSERT( files[ numFiles - 3 ].IsCompressedContentCached() );
+    TEST_ASSERT( files[ numFiles - 2 ].IsCompressedContentCached() == false );
+    TEST_ASSERT( files[ numFiles - 1 ].IsCompressedContentCached() );
+    TEST_ASSERT( files[ 0 ].IsCompressedContentCached() );
+
+    // Moving files (as the array grows) keeps them in the cache
+    files.SetCapacity( numFiles * 2 );
+    TEST_ASSERT( files[ numFiles - 3 ].IsCompressedContentCached() );
+    TEST_ASSERT( files[ numFiles - 1 ].IsCompressedContentCached() );
+    TEST_ASSERT( files[ 0 ].IsCompressedContentCached() );
+
+    // A copy has its own cached data
+    {
+        const ToolManifestFile copy( files[ 0 ] );
+        TEST_ASSERT( copy.IsCompressedContentCached() == false );
+        CheckFileData( copy, contents[ 0 ] );
+        TEST_ASSERT( copy.IsCompressedContentCached() );
+        TEST_ASSERT( files[ 0 ].IsCompressedContentCached() );
+    }
+
+    // A file larger than the limit is served, but is the only one kept
+    ToolManifestFile::SetCompressedContentCacheLimit( 1 );
+    TEST_ASSERT( ToolManifestFile::GetCompressedContentCacheSize() == 0 );
+    CheckFileData( files[ 1 ], contents[ 1 ] );
+    CheckFileData( files[ 2 ], contents[ 2 ] );
+    TEST_ASSERT( files[ 1 ].IsCompressedContentCached() == false );
+    TEST_ASSERT( files[ 2 ].IsCompressedContentCached() );
+
+    // Restore default limit
+    ToolManifestFile::SetCompressedContentCacheLimit( defaultLimit );
+}
+
+// ManyFiles
+//------------------------------------------------------------------------------
+void TestToolManifest::ManyFiles() const
+{
+    // A toolchain with enough files to be hashed in parallel
+    const uint32_t numFiles = 200;
+    AString contents[ numFiles ];
+    EnsureDirExists( "../tmp/Test/ToolManifest/ManyFiles/" );
+    AStackString<> bff( "Compiler( 'Compiler' )\n"
+                        "{\n"
+                        "    .CompilerFamily = 'custom'\n"
+                        "    .Executable     = '../tmp/Test/ToolManifest/ManyFiles/File0.txt'\n"
+                        "    .ExtraFiles     = {\n" );
+    for ( uint32_t i = 0; i < numFiles; ++i )
+    {
+        AStackString<> fileName;
+        fileName.Format( "../tmp/Test/ToolManifest/ManyFiles/File%u.txt", i );
+        MakeTestFile( fileName.Get(), 1000 + i, contents[ i ] );
+        if ( i > 0 )
+        {
+            bff.AppendFormat( "                        '%s',\n", fileName.Get() );
+        }
+    }
+    bff += "                      }\n"
+           "}\n";
+    MakeFile( "../tmp/Test/ToolManifest/ManyFiles/fbuild.bff", bff.Get() );
+
+    uint64_t toolIdA = 0;
+    for ( uint32_t pass = 0; pass < 2; ++pass )
+    {
+        FBuildTestOptions options;
+        options.m_ForceCleanBuild = true;
+        options.m_ConfigFile = "../tmp/Test/ToolManifest/ManyFiles/fbuild.bff";
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "Compiler" ) );
+
+        Array< const Node * > nodes;
+        fBuild.GetNodesOfType( Node::COMPILER_NODE, nodes );
+        TEST_ASSERT( nodes.GetSize() == 1 );
+        const ToolManifest & manifest = nodes[ 0 ]->CastTo< CompilerNode >()->GetManifest();
+
+        // Every file was hashed, and nothing was compressed
+        const Array< ToolManifestFile > & files = manifest.GetFiles();
+        TEST_ASSERT( files.GetSize() == numFiles );
+        for ( const ToolManifestFile & file : files )
+        {
+            const AString & name = file.GetName();
+            const uint32_t index = (uint32_t)atoi( name.FindLast( "File" ) + 4 );
+            TEST_ASSERT( index < numFiles );
+            TEST_ASSERT( file.GetHash() == xxHash::Calc64( contents[ index ].Get(), contents[ index ].GetLength() ) );
+            TEST_ASSERT( file.IsCompressedContentCached() == false );
+        }
+
+        // ToolId is stable
+        if ( pass == 0 )
+        {
+            toolIdA = manifest.GetToolId();
+            TEST_ASSERT( toolIdA );
+        }
+        else
+        {
+            TEST_ASSERT( manifest.GetToolId() == toolIdA );
+        }
+    }
+}
+
+// ReceiveMismatchedData
+//------------------------------------------------------------------------------
+void TestToolManifest::ReceiveMismatchedData() const
+{
+    // Keep the received files out of the real temp dir
+    AStackString<> tempDir;
+    TEST_ASSERT( FBuild::GetTempDir( tempDir ) );
+    SetTempDir( "../tmp/Test/ToolManifest/ReceiveMismatchedData/" );
+
+    // A toolchain of one file (repeated contents so they compress)
+    AString contents( "Expected contents" );
+    AString otherContents( "Modified contents" );
+    for ( uint32_t i = 0; i < 8; ++i )
+    {
+        contents += contents;
+        otherContents += otherContents;
+    }
+    AStackString<> root( "Client" );
+    root += NATIVE_SLASH;
+    AStackString<> name( root );
+    name += "File.txt";
+    MemoryStream ms;
+    ms.Write( (uint64_t)0x7E57000000000001ULL );
+    ms.Write( root );
+    ms.Write( (uint32_t)1 );
+    ms.Write( name );
+    ms.Write( (uint64_t)0 );
+    ms.Write( xxHash::Calc64( contents.Get(), contents.GetLength() ) );
+    ms.Write( (uint32_t)contents.GetLength() );
+    ms.Write( (uint32_t)0 ); // no environment variables
+
+    // Remove the file left by a previous run, before it's seen as synchronized
+    AStackString<> remoteFile;
+    {
+        ToolManifest previous;
+        ConstMemoryStream cms( ms.GetData(), ms.GetSize() );
+        previous.DeserializeFromRemote( cms );
+        previous.GetRemoteFilePath( 0, remoteFile );
+        FileIO::FileDelete( remoteFile.Get() );
+    }
+
+    ToolManifest manifest;
+    ConstMemoryStream cms( ms.GetData(), ms.GetSize() );
+    manifest.DeserializeFromRemote( cms );
+    manifest.MarkFileAsSynchronizing( 0 );
+
+    // Contents which don't match the hash (same size) are rejected
+    {
+        TEST_ASSERT( otherContents.GetLength() == contents.GetLength() );
+        Compressor c;
+        TEST_ASSERT( c.Compress( otherContents.Get(), otherContents.GetLength() ) );
+        size_t dataSize = c.GetResultSize();
+        TEST_ASSERT( manifest.ReceiveFileData( 0, c.GetResult(), dataSize ) == false );
+        TEST_ASSERT( manifest.GetFiles()[ 0 ].GetSyncState() == ToolManifestFile::SYNCHRONIZING );
+        TEST_ASSERT( FileIO::FileExists( remoteFile.Get() ) == false );
+    }
+
+    // The expected contents are stored
+    {
+        Compressor c;
+        TEST_ASSERT( c.Compress( contents.Get(), contents.GetLength() ) );
+        size_t dataSize = c.GetResultSize();
+        TEST_ASSERT( manifest.ReceiveFileData( 0, c.GetResult(), dataSize ) );
+        TEST_ASSERT( manifest.IsSynchronized() );
+    }
+
+    SetTempDir( tempDir.Get() );
+}
+
+// Store
+//------------------------------------------------------------------------------
+void TestToolManifest::Store() const
+{
+    // Keep the store out of the real temp dir
+    AStackString<> tempDir;
+    TEST_ASSERT( FBuild::GetTempDir( tempDir ) );
+    SetTempDir( "../tmp/Test/ToolManifest/Store/" );
+
+    // A toolchain received by a worker
+    AStackString<> indexFile;
+    AStackString<> firstFile;
+    uint64_t toolId = 0;
+    {
+        ToolManifest manifest;
+        MakeRemoteToolchain( 1, manifest );
+        TEST_ASSERT( manifest.SaveToStore() );
+        manifest.GetStoreIndexPath( indexFile );
+        manifest.GetRemoteFilePath( 0, firstFile );
+        toolId = manifest.GetToolId();
+    }
+    TEST_ASSERT( FileIO::FileExists( indexFile.Get() ) );
+
+    // is available again after a restart, without any files being sent
+    {
+        ToolManifest manifest;
+        TEST_ASSERT( manifest.LoadFromStore( indexFile ) == ToolManifest::STORE_LOADED );
+        TEST_ASSERT( manifest.IsSynchronized() );
+        TEST_ASSERT( manifest.GetToolId() == toolId );
+        TEST_ASSERT( manifest.GetFiles().GetSize() == 2 );
+        TEST_ASSERT( manifest.GetRemoteEnvironmentString() != nullptr );
+        for ( const ToolManifestFile & file : manifest.GetFiles() )
+        {
+            TEST_ASSERT( file.GetSyncState() == ToolManifestFile::SYNCHRONIZED );
+        }
+    }
+
+    // An index which can't be read is not mistaken for a stale one (so it's kept)
+    {
+        AStackString<> unreadableIndex( indexFile );
+        unreadableIndex += ".dir";
+        TEST_ASSERT( FileIO::EnsurePathExists( unreadableIndex ) );
+        ToolManifest manifest;
+        TEST_ASSERT( manifest.LoadFromStore( unreadableIndex ) == ToolManifest::STORE_UNREADABLE );
+        TEST_ASSERT( FileIO::DirectoryDelete( unreadableIndex ) );
+    }
+
+    // unless some of its files have gone
+    TEST_ASSERT( FileIO::FileDelete( firstFile.Get() ) );
+    {
+        ToolManifest manifest;
+        TEST_ASSERT( manifest.LoadFromStore( indexFile ) == ToolManifest::STORE_INVALID );
+
+        // Everything is removed when deleted from the store
+        manifest.DeleteFromStore();
+        AStackString<> remotePath;
+        manifest.GetRemotePath( remotePath );
+        TEST_ASSERT( FileIO::FileExists( indexFile.Get() ) == false );
+        TEST_ASSERT( FileIO::DirectoryExists( remotePath ) == false );
+    }
+
+    SetTempDir( tempDir.Get() );
+}
+
+// StoreEviction
+//------------------------------------------------------------------------------
+void TestToolManifest::StoreEviction() const
+{
+    // Keep the store out of the real temp dir
+    AStackString<> tempDir;
+    TEST_ASSERT( FBuild::GetTempDir( tempDir ) );
+    SetTempDir( "../tmp/Test/ToolManifest/StoreEviction/" );
+
+    // Three stored toolchains, used in turn
+    const uint32_t numToolchains = 3;
+    uint64_t toolIds[ numToolchains ];
+    AStackString<> indexFiles[ numToolchains ];
+    uint64_t toolchainSize = 0;
+    for ( uint32_t i = 0; i < numToolchains; ++i )
+    {
+        ToolManifest manifest;
+        MakeRemoteToolchain( 100 + i, manifest );
+        TEST_ASSERT( manifest.SaveToStore() );
+        toolIds[ i ] = manifest.GetToolId();
+        manifest.GetStoreIndexPath( indexFiles[ i ] );
+        toolchainSize = manifest.GetTotalFileSize();
+    }
+    const uint64_t now = FileIO::GetFileLastWriteTime( indexFiles[ numToolchains - 1 ] );
+    for ( uint32_t i = 0; i < numToolchains; ++i )
+    {
+        TEST_ASSERT( FileIO::SetFileLastWriteTime( indexFiles[ i ], now - ( ( numToolchains - i ) * 1000000000ULL ) ) );
+    }
+
+    // A worker with room for two evicts the least recently used
+    {
+        Server server;
+        server.EnableToolchainStore( 2 * toolchainSize );
+
+        Array< uint64_t > loadedToolIds( 0, true );
+        server.GetToolIds( loadedToolIds );
+        TEST_ASSERT( loadedToolIds.GetSize() == 2 );
+        TEST_ASSERT( loadedToolIds.Find( toolIds[ 0 ] ) == nullptr );
+        TEST_ASSERT( loadedToolIds.Find( toolIds[ 1 ] ) );
+        TEST_ASSERT( loadedToolIds.Find( toolIds[ 2 ] ) );
+        TEST_ASSERT( FileIO::FileExists( indexFiles[ 0 ].Get() ) == false );
+        TEST_ASSERT( FileIO::FileExists( indexFiles[ 1 ].Get() ) );
+    }
+
+    // The most recently used is kept, even when over budget
+    {
+        Server server;
+        server.EnableToolchainStore( 1 );
+
+        Array< uint64_t > loadedToolIds( 0, true );
+        server.GetToolIds( loadedToolIds );
+        TEST_ASSERT( loadedToolIds.GetSize() == 1 );
+        TEST_ASSERT( loadedToolIds[ 0 ] == toolIds[ 2 ] );
+    }
+
+    SetTempDir( tempDir.Get() );
+}
+
+// MakeRemoteToolchain
+//------------------------------------------------------------------------------
+void TestToolManifest::MakeRemoteToolchain( uint32_t seed, ToolManifest & outManifest ) const
+{
+    // What a client sends for a toolchain of two files
+    AStackString<> root( "Client" );
+    root += NATIVE_SLASH;
+    AString contents[ 2 ];
+    MemoryStream ms;
+    ms.Write( (uint64_t)( 0x7E57000000000000ULL + seed ) );
+    ms.Write( root );
+    ms.Write( (uint32_t)2 );
+    for ( uint32_t i = 0; i < 2; ++i )
+    {
+        contents[ i ].Format( "Toolchain %u file %u", seed, i );
+        for ( uint32_t j = 0; j < 8; ++j )
+        {
+            contents[ i ] += contents[ i ];
+        }
+        AStackString<> name( root );
+        name.AppendFormat( "File%u.txt", i );
+        ms.Write( name );
+        ms.Write( (uint64_t)0 );
+        ms.Write( xxHash::Calc64( contents[ i ].Get(), contents[ i ].GetLength() ) );
+        ms.Write( (uint32_t)contents[ i ].GetLength() );
+    }
+    ms.Write( (uint32_t)0 ); // no environment variables
+
+    // is received by a worker (files might be left from a previous run)
+    ConstMemoryStream cms( ms.GetData(), ms.GetSize() );
+    outManifest.DeserializeFromRemote( cms );
+    for ( uint32_t i = 0; i < 2; ++i )
+    {
+        if ( outManifest.GetFiles()[ i ].GetSyncState() == ToolManifestFile::SYNCHRONIZED )
+        {
+            continue;
+        }
+        outManifest.MarkFileAsSynchronizing( i );
+        Compressor c;
+        TEST_ASSERT( c.Compress( contents[ i ].Get(), contents[ i ].GetLength() ) );
+        size_t dataSize = c.GetResultSize();
+        TEST_ASSERT( outManifest.ReceiveFileData( i, c.GetResult(), dataSize ) );
+    }
+    TEST_ASSERT( outManifest.IsSynchronized() );
+}
+
+// SetTempDir
+//------------------------------------------------------------------------------
+/*static*/ void TestToolManifest::SetTempDir( const char * path )
+{
+    // Worker temp dirs are expected to be full paths
+    AStackString<> fullPath;
+    if ( PathUtils::IsFullPath( AStackString<>( path ) ) == false )
+    {
+        FileIO::GetCurrentDir( fullPath );
+        PathUtils::EnsureTrailingSlash( fullPath );
+    }
+    fullPath += path;
+    Env::SetEnvVariable( "FASTBUILD_TEMP_PATH", fullPath );
+}
+
+// MakeTestFile
+//------------------------------------------------------------------------------
+void TestToolManifest::MakeTestFile( const char * fileName, uint32_t seed, AString & outContents ) const
+{
+    // Somewhat compressible content, unique per seed
+    outContents.Clear();
+    for ( uint32_t i = 0; i < 512; ++i )
+    {
+        outContents.AppendFormat( "Line %u of file %u: %08x\n", i, seed, ( i * 2654435761u ) ^ seed );
+    }
+    MakeFile( fileName, outContents.Get() );
+}
+
+// CheckFileData
+//------------------------------------------------------------------------------
+void TestToolManifest::CheckFileData( const ToolManifestFile & file, const AString & expectedContents ) const
+{
+    size_t dataSize = 0;
+    AutoPtr< void > data( file.GetFileData( dataSize ) );
+    TEST_ASSERT( data.Get() );
+
+    Compressor c;
+    TEST_ASSERT( c.Decompress( data.Get() ) );
+    TEST_ASSERT( c.GetResultSize() == expectedContents.GetLength() );
+    TEST_ASSERT( memcmp( c.GetResult(), expectedContents.Get(), expectedContents.GetLength() ) == 0 );
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,247 @@
+// TestWorkerCGroups.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "FBuildTest.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/WorkerPool/WorkerCGroups.h"
+
+// Core
+#include "Core/FileIO/FileIO.h"
+#include "Core/Process/Process.h"
+#include "Core/Strings/AStackString.h"
+
+// TestWorkerCGroups
+//------------------------------------------------------------------------------
+class TestWorkerCGroups : public FBuildTest
+{
+private:
+    DECLARE_TESTS
+
+    void Init() const;
+    void Init_NotDelegated() const;
+    void JobGroup() const;
+    void JobGroupUsage() const;
+    void ProcessUsage() const;
+
+    // Helpers
+    void MakeSystemFile( const char * root, const char * relativePath, const char * contents ) const;
+    void CheckFileContents( const AString & fileName, const char * expected ) const;
+    void MakeDelegatedRoot( const char * root ) const;
+};
+
+// Register Tests
+//------------------------------------------------------------------------------
+REGISTER_TESTS_BEGIN( TestWorkerCGroups )
+    #if defined( __LINUX__ )
+        REGISTER_TEST( Init )
+        REGISTER_TEST( Init_NotDelegated )
+        REGISTER_TEST( JobGroup )
+        REGISTER_TEST( JobGroupUsage )
+        REGISTER_TEST( ProcessUsage )
+    #endif
+REGISTER_TESTS_END
+
+// Init
+//------------------------------------------------------------------------------
+void TestWorkerCGroups::Init() const
+{
+    const char * root = "../tmp/Test/WorkerCGroups/Init";
+    MakeDelegatedRoot( root );
+
+    WorkerCGroups cgroups( root );
+    AStackString<> error;
+    TEST_ASSERT( cgroups.Init( 100, 0, error ) );
+
+    // Worker moved itself into a leaf, and enabled controllers for the jobs
+    AStackString<> baseDir( root );
+    baseDir += "/sys/fs/cgroup/fbuild.service";
+    TEST_ASSERT( cgroups.GetBaseDir() == baseDir );
+    AStackString<> pid;
+    pid.Format( "%u", Process::GetCurrentId() );
+    CheckFileContents( AStackString<>( "../tmp/Test/WorkerCGroups/Init/sys/fs/cgroup/fbuild.service/worker/cgroup.procs" ), pid.Get() );
+    CheckFileContents( AStackString<>( "../tmp/Test/WorkerCGroups/Init/sys/fs/cgroup/fbuild.service/cgroup.subtree_control" ), "+cpu +memory" );
+}
+
+// Init_NotDelegated
+//------------------------------------------------------------------------------
+void TestWorkerCGroups::Init_NotDelegated() const
+{
+    // Memory controller is not available ("cpuset" must not be mistaken for "cpu")
+    {
+        const char * root = "../tmp/Test/WorkerCGroups/Init_NotDelegated/NoMemory";
+        MakeSystemFile( root, "/proc/self/cgroup", "0::/fbuild.service\n" );
+        MakeSystemFile( root, "/sys/fs/cgroup/fbuild.service/cgroup.controllers", "cpuset io memoryx pids\n" );
+
+        WorkerCGroups cgroups( root );
+        AStackString<> error;
+        TEST_ASSERT( cgroups.Init( 100, 0, error ) == false );
+        TEST_ASSERT( error.Find( "not delegated" ) );
+    }
+
+    // cgroup v1
+    {
+        const char * root = "../tmp/Test/WorkerCGroups/Init_NotDelegated/V1";
+        MakeSystemFile( root, "/proc/self/cgroup", "12:memory:/fbuild\n" );
+
+        WorkerCGroups cgroups( root );
+        AStackString<> error;
+        TEST_ASSERT( cgroups.Init( 100, 0, error ) == false );
+        TEST_ASSERT( error.Find( "not available" ) );
+    }
+}
+
+// JobGroup
+//------------------------------------------------------------------------------
+void TestWorkerCGroups::JobGroup() const
+{
+    const char * root = "../tmp/Test/WorkerCGroups/JobGroup";
+    MakeDelegatedRoot( root );
+
+    WorkerCGroups cgroups( root );
+    AStackString<> error;
+    TEST_ASSERT( cgroups.Init( 50, ( 512 * MEGABYTE ), error ) );
+
+    // Each job gets a unique group with limits applied
+    AStackString<> groupA;
+    AStackString<> groupB;
+    TEST_ASSERT( cgroups.CreateJobGroup( groupA ) );
+    TEST_ASSERT( cgroups.CreateJobGroup( groupB ) );
+    TEST_ASSERT( groupA != groupB );
+    TEST_ASSERT( groupA.BeginsWith( cgroups.GetBaseDir() ) );
+
+    AStackString<> fileName;
+    fileName.Format( "%s/cpu.weight", groupA.Get() );
+    CheckFileContents( fileName, "50" );
+    fileName.Format( "%s/memory.max", groupA.Get() );
+    CheckFileContents( fileName, "536870912" );
+    fileName.Format( "%s/memory.oom.group", groupA.Get() );
+    CheckFileContents( fileName, "1" );
+
+    // Spawned process joins the group
+    AStackString<> procsFile;
+    procsFile.Format( "%s/cgroup.procs", groupA.Get() );
+    MakeFile( procsFile.Get(), "" ); // Child doesn't create it
+    Process p;
+    p.SetCGroupProcsFile( procsFile.Get() );
+    TEST_ASSERT( p.Spawn( "/bin/true", "", nullptr, nullptr ) );
+    AStackString<> out;
+    AStackString<> err;
+    p.ReadAllData( out, err );
+    TEST_ASSERT( p.WaitForExit() == 0 );
+    CheckFileContents( procsFile, "0" );
+
+    // Process is not started outside the group if it can't join it
+    TEST_ASSERT( FileIO::FileDelete( procsFile.Get() ) );
+    Process p2;
+    p2.SetCGroupProcsFile( procsFile.Get() );
+    TEST_ASSERT( p2.Spawn( "/bin/true", "", nullptr, nullptr ) == false );
+
+    // Destroying kills remaining processes. A fake group can't be removed
+    // while it contains files, which real cgroup directories can.
+    fileName.Format( "%s/cgroup.kill", groupB.Get() );
+    MakeFile( fileName.Get(), "" );
+    TEST_ASSERT( cgroups.DestroyJobGroup( groupB ) == false );
+    CheckFileContents( fileName, "1" );
+    const char * files[] = { "cgroup.kill", "cpu.weight", "memory.max", "memory.oom.group" };
+    for ( const char * file : files )
+    {
+        fileName.Format( "%s/%s", groupB.Get(), file );
+        TEST_ASSERT( FileIO::FileDelete( fileName.Get() ) );
+    }
+    TEST_ASSERT( cgroups.DestroyJobGroup( groupB ) );
+    TEST_ASSERT( FileIO::DirectoryExists( groupB ) == false );
+}
+
+// JobGroupUsage
+//------------------------------------------------------------------------------
+void TestWorkerCGroups::JobGroupUsage() const
+{
+    const char * root = "../tmp/Test/WorkerCGroups/JobGroupUsage";
+    MakeDelegatedRoot( root );
+
+    WorkerCGroups cgroups( root );
+    AStackString<> error;
+    TEST_ASSERT( cgroups.Init( 100, 0, error ) );
+    AStackString<> group;
+    TEST_ASSERT( cgroups.CreateJobGroup( group ) );
+
+    // No memory.max without a limit
+    AStackString<> fileName;
+    fileName.Format( "%s/memory.max", group.Get() );
+    TEST_ASSERT( FileIO::FileExists( fileName.Get() ) == false );
+
+    // Older kernels without memory.peak
+    uint64_t peakMemory = 1;
+    uint64_t cpuTime = 2;
+    TEST_ASSERT( cgroups.ReadJobUsage( group, peakMemory, cpuTime ) == false );
+    TEST_ASSERT( ( peakMemory == 1 ) && ( cpuTime == 2 ) ); // Unmodified
+
+    // Usage of the whole group
+    fileName.Format( "%s/memory.peak", group.Get() );
+    MakeFile( fileName.Get(), "734003200\n" );
+    fileName.Format( "%s/cpu.stat", group.Get() );
+    MakeFile( fileName.Get(), "usage_usec 1234567\n"
+                              "user_usec 1000000\n"
+                              "system_usec 234567\n" );
+    TEST_ASSERT( cgroups.ReadJobUsage( group, peakMemory, cpuTime ) );
+    TEST_ASSERT( peakMemory == 734003200 );
+    TEST_ASSERT( cpuTime == 1234567 );
+}
+
+// ProcessUsage
+//------------------------------------------------------------------------------
+void TestWorkerCGroups::ProcessUsage() const
+{
+    // Without cgroups, usage comes from the process itself (with peak memory
+    // sampled while it runs, so it must run for a while)
+    Process p;
+    TEST_ASSERT( p.Spawn( "/bin/dd", "if=/dev/zero of=/dev/null bs=16M count=256", nullptr, nullptr ) );
+    AStackString<> out;
+    AStackString<> err;
+    p.ReadAllData( out, err );
+    TEST_ASSERT( p.WaitForExit() == 0 );
+    TEST_ASSERT( p.GetPeakMemoryBytes() >= ( 16 * MEGABYTE ) ); // dd's buffer
+    TEST_ASSERT( p.GetCPUTimeUS() > 0 );
+}
+
+// MakeSystemFile
+//------------------------------------------------------------------------------
+void TestWorkerCGroups::MakeSystemFile( const char * root, const char * relativePath, const char * contents ) const
+{
+    AStackString<> fileName( root );
+    fileName += relativePath;
+    TEST_ASSERT( FileIO::EnsurePathExistsForFile( fileName ) );
+    MakeFile( fileName.Get(), contents );
+}
+
+// CheckFileContents
+//------------------------------------------------------------------------------
+void TestWorkerCGroups::CheckFileContents( const AString & fileName, const char * expected ) const
+{
+    AStackString<> contents;
+    TEST_ASSERT( WorkerResources::ReadVirtualFile( fileName.Get(), contents ) );
+    TEST_ASSERT( contents == expected );
+}
+
+// MakeDelegatedRoot
+//------------------------------------------------------------------------------
+void TestWorkerCGroups::MakeDelegatedRoot( const char * root ) const
+{
+    // Clean up groups from previous runs
+    AStackString<> baseDir( root );
+    baseDir += "/sys/fs/cgroup/fbuild.service/";
+    Array< AString > files( 16, true );
+    FileIO::GetFiles( baseDir, AStackString<>( "*" ), true, &files );
+    for ( const AString & file : files )
+    {
+        FileIO::FileDelete( file.Get() );
+    }
+
+    MakeSystemFile( root, "/proc/self/cgroup", "0::/fbuild.service\n" );
+    MakeSystemFile( root, "/sys/fs/cgroup/fbuild.service/cgroup.controllers", "cpuset cpu io memory pids\n" );
+}
+
+//------------------------------------------------------------------------------
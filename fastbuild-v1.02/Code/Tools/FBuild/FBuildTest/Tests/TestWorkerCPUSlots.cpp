@@ -0,0 +1,123 @@
+// TestWorkerCPUSlots.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "FBuildTest.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/WorkerPool/WorkerCPUSlots.h"
+
+// TestWorkerCPUSlots
+//------------------------------------------------------------------------------
+class TestWorkerCPUSlots : public FBuildTest
+{
+private:
+    DECLARE_TESTS
+
+    void Grow() const;
+    void Shrink() const;
+    void DeadBand() const;
+    void MaxCPUs() const;
+
+    // Helpers
+    static uint32_t Update( WorkerCPUSlots & slots, uint32_t numUpdates, uint32_t maxCPUs, float otherCPUUsagePercent );
+};
+
+// Register Tests
+//------------------------------------------------------------------------------
+REGISTER_TESTS_BEGIN( TestWorkerCPUSlots )
+    REGISTER_TEST( Grow )
+    REGISTER_TEST( Shrink )
+    REGISTER_TEST( DeadBand )
+    REGISTER_TEST( MaxCPUs )
+REGISTER_TESTS_END
+
+// Grow
+//------------------------------------------------------------------------------
+void TestWorkerCPUSlots::Grow() const
+{
+    // Nothing is offered until the machine has been idle for a while
+    WorkerCPUSlots slots;
+    TEST_ASSERT( Update( slots, 9, 8, 0.0f ) == 0 );
+    TEST_ASSERT( Update( slots, 1, 8, 0.0f ) == 8 );
+
+    // Growth is limited by the busiest update while waiting
+    WorkerCPUSlots slots2;
+    for ( uint32_t i = 0; i < 5; ++i )
+    {
+        Update( slots2, 1, 8, 0.0f );
+        Update( slots2, 1, 8, 25.0f ); // 6 CPUs free
+    }
+    TEST_ASSERT( slots2.GetNumCPUs() == 6 );
+
+    // Only whole free CPUs are offered
+    TEST_ASSERT( Update( slots2, 10, 8, 20.0f ) == 6 ); // 6.4 CPUs free
+}
+
+// Shrink
+//------------------------------------------------------------------------------
+void TestWorkerCPUSlots::Shrink() const
+{
+    WorkerCPUSlots slots;
+    TEST_ASSERT( Update( slots, 10, 8, 0.0f ) == 8 );
+
+    // A brief spike is ignored
+    TEST_ASSERT( Update( slots, 1, 8, 50.0f ) == 8 );
+    TEST_ASSERT( Update( slots, 1, 8, 0.0f ) == 8 );
+
+    // CPUs are given back more quickly than they are taken
+    TEST_ASSERT( Update( slots, 1, 8, 50.0f ) == 8 );
+    TEST_ASSERT( Update( slots, 1, 8, 25.0f ) == 6 ); // Least disruptive of the two
+
+    // A fully loaded machine offers nothing
+    TEST_ASSERT( Update( slots, 2, 8, 100.0f ) == 0 );
+}
+
+// DeadBand
+//------------------------------------------------------------------------------
+void TestWorkerCPUSlots::DeadBand() const
+{
+    WorkerCPUSlots slots;
+    TEST_ASSERT( Update( slots, 10, 8, 25.0f ) == 6 );
+
+    // Fluctuating between 5.6 and 6.9 free CPUs doesn't change anything
+    for ( uint32_t i = 0; i < 20; ++i )
+    {
+        TEST_ASSERT( Update( slots, 1, 8, 30.0f ) == 6 );
+        TEST_ASSERT( Update( slots, 1, 8, 13.75f ) == 6 );
+    }
+
+    // Falling further below does
+    TEST_ASSERT( Update( slots, 2, 8, 37.5f ) == 5 );
+}
+
+// MaxCPUs
+//------------------------------------------------------------------------------
+void TestWorkerCPUSlots::MaxCPUs() const
+{
+    // Never more than the configured maximum
+    WorkerCPUSlots slots;
+    TEST_ASSERT( Update( slots, 10, 4, 0.0f ) == 4 );
+
+    // A lower maximum applies immediately
+    TEST_ASSERT( Update( slots, 1, 2, 0.0f ) == 2 );
+
+    // A higher one is grown into
+    TEST_ASSERT( Update( slots, 9, 8, 0.0f ) == 2 );
+    TEST_ASSERT( Update( slots, 1, 8, 0.0f ) == 8 );
+}
+
+// Update
+//------------------------------------------------------------------------------
+/*static*/ uint32_t TestWorkerCPUSlots::Update( WorkerCPUSlots & slots, uint32_t numUpdates, uint32_t maxCPUs, float otherCPUUsagePercent )
+{
+    uint32_t numCPUs = 0;
+    for ( uint32_t i = 0; i < numUpdates; ++i )
+    {
+        numCPUs = slots.Update( maxCPUs, 8, otherCPUUsagePercent ); // 8 CPU machine
+    }
+    return numCPUs;
+}
+
+//------------------------------------------------------------------------------
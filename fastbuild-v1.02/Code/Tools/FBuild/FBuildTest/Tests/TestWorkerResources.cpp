@@ -0,0 +1,201 @@
+// TestWorkerResources.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "FBuildTest.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/WorkerPool/WorkerResources.h"
+
+// Core
+#include "Core/FileIO/FileIO.h"
+#include "Core/Strings/AStackString.h"
+
+// TestWorkerResources
+//------------------------------------------------------------------------------
+class TestWorkerResources : public FBuildTest
+{
+private:
+    DECLARE_TESTS
+
+    void MemAvailable() const;
+    void MemAvailable_OldKernel() const;
+    void MemAvailable_Missing() const;
+    void CGroupLimit() const;
+    void CGroupOverLimit() const;
+    void CGroupV1() const;
+    void DiskSpace() const;
+    void MemoryLimitedCPUs() const;
+
+    // Helpers
+    void MakeSystemFile( const char * root, const char * relativePath, const char * contents ) const;
+};
+
+// Register Tests
+//------------------------------------------------------------------------------
+REGISTER_TESTS_BEGIN( TestWorkerResources )
+    #if defined( __LINUX__ )
+        REGISTER_TEST( MemAvailable )
+        REGISTER_TEST( MemAvailable_OldKernel )
+        REGISTER_TEST( MemAvailable_Missing )
+        REGISTER_TEST( CGroupLimit )
+        REGISTER_TEST( CGroupOverLimit )
+        REGISTER_TEST( CGroupV1 )
+    #endif
+    REGISTER_TEST( DiskSpace )
+    REGISTER_TEST( MemoryLimitedCPUs )
+REGISTER_TESTS_END
+
+// MemAvailable
+//------------------------------------------------------------------------------
+void TestWorkerResources::MemAvailable() const
+{
+    const char * root = "../tmp/Test/WorkerResources/MemAvailable";
+    MakeSystemFile( root, "/proc/meminfo", "MemTotal:       16000000 kB\n"
+                                           "MemFree:          500000 kB\n"
+                                           "MemAvailable:    8000000 kB\n"
+                                           "Buffers:          100000 kB\n"
+                                           "Cached:          7000000 kB\n" );
+
+    uint64_t available = 0;
+    TEST_ASSERT( WorkerResources( root ).GetAvailableMemory( available ) );
+    TEST_ASSERT( available == ( 8000000ULL * 1024 ) );
+}
+
+// MemAvailable_OldKernel
+//------------------------------------------------------------------------------
+void TestWorkerResources::MemAvailable_OldKernel() const
+{
+    // Without MemAvailable, free memory plus caches is used. SwapCached must
+    // not be mistaken for Cached.
+    const char * root = "../tmp/Test/WorkerResources/MemAvailable_OldKernel";
+    MakeSystemFile( root, "/proc/meminfo", "MemTotal:       16000000 kB\n"
+                                           "MemFree:          500000 kB\n"
+                                           "Buffers:          100000 kB\n"
+                                           "SwapCached:       999999 kB\n"
+                                           "Cached:          7000000 kB\n" );
+
+    uint64_t available = 0;
+    TEST_ASSERT( WorkerResources( root ).GetAvailableMemory( available ) );
+    TEST_ASSERT( available == ( 7600000ULL * 1024 ) );
+}
+
+// MemAvailable_Missing
+//------------------------------------------------------------------------------
+void TestWorkerResources::MemAvailable_Missing() const
+{
+    // No meminfo at all
+    {
+        const char * root = "../tmp/Test/WorkerResources/MemAvailable_Missing/NoFile";
+        FileIO::EnsurePathExists( AStackString<>( root ) );
+        uint64_t available = 0;
+        TEST_ASSERT( WorkerResources( root ).GetAvailableMemory( available ) == false );
+    }
+
+    // Unrecognized meminfo
+    {
+        const char * root = "../tmp/Test/WorkerResources/MemAvailable_Missing/BadFile";
+        MakeSystemFile( root, "/proc/meminfo", "garbage\n" );
+        uint64_t available = 0;
+        TEST_ASSERT( WorkerResources( root ).GetAvailableMemory( available ) == false );
+    }
+}
+
+// CGroupLimit
+//------------------------------------------------------------------------------
+void TestWorkerResources::CGroupLimit() const
+{
+    // A limit on a parent cgroup applies to us
+    const char * root = "../tmp/Test/WorkerResources/CGroupLimit";
+    MakeSystemFile( root, "/proc/meminfo", "MemAvailable:   10485760 kB\n" ); // 10 GiB
+    MakeSystemFile( root, "/proc/self/cgroup", "0::/workers.slice/worker.scope\n" );
+    MakeSystemFile( root, "/sys/fs/cgroup/workers.slice/worker.scope/memory.max", "max\n" );
+    MakeSystemFile( root, "/sys/fs/cgroup/workers.slice/worker.scope/memory.current", "1073741824\n" );
+    MakeSystemFile( root, "/sys/fs/cgroup/workers.slice/memory.max", "8589934592\n" );       // 8 GiB
+    MakeSystemFile( root, "/sys/fs/cgroup/workers.slice/memory.current", "6442450944\n" );   // 6 GiB
+
+    uint64_t available = 0;
+    TEST_ASSERT( WorkerResources( root ).GetAvailableMemory( available ) );
+    TEST_ASSERT( available == ( 2048ULL * MEGABYTE ) );
+
+    // If the system has less available than the cgroup allows, that's the limit
+    MakeSystemFile( root, "/proc/meminfo", "MemAvailable:    1048576 kB\n" ); // 1 GiB
+    TEST_ASSERT( WorkerResources( root ).GetAvailableMemory( available ) );
+    TEST_ASSERT( available == ( 1024ULL * MEGABYTE ) );
+}
+
+// CGroupOverLimit
+//------------------------------------------------------------------------------
+void TestWorkerResources::CGroupOverLimit() const
+{
+    const char * root = "../tmp/Test/WorkerResources/CGroupOverLimit";
+    MakeSystemFile( root, "/proc/meminfo", "MemAvailable:   10485760 kB\n" );
+    MakeSystemFile( root, "/proc/self/cgroup", "0::/worker\n" );
+    MakeSystemFile( root, "/sys/fs/cgroup/worker/memory.max", "1073741824\n" );
+    MakeSystemFile( root, "/sys/fs/cgroup/worker/memory.current", "1073745920\n" );
+
+    uint64_t available = 1;
+    TEST_ASSERT( WorkerResources( root ).GetAvailableMemory( available ) );
+    TEST_ASSERT( available == 0 );
+}
+
+// CGroupV1
+//------------------------------------------------------------------------------
+void TestWorkerResources::CGroupV1() const
+{
+    // cgroup v1 hierarchies are ignored
+    const char * root = "../tmp/Test/WorkerResources/CGroupV1";
+    MakeSystemFile( root, "/proc/meminfo", "MemAvailable:   10485760 kB\n" );
+    MakeSystemFile( root, "/proc/self/cgroup", "12:memory:/worker\n"
+                                               "11:cpu,cpuacct:/worker\n" );
+    MakeSystemFile( root, "/sys/fs/cgroup/worker/memory.max", "1073741824\n" );
+
+    uint64_t available = 0;
+    TEST_ASSERT( WorkerResources( root ).GetAvailableMemory( available ) );
+    TEST_ASSERT( available == ( 10240ULL * MEGABYTE ) );
+}
+
+// DiskSpace
+//------------------------------------------------------------------------------
+void TestWorkerResources::DiskSpace() const
+{
+    uint64_t freeBytes = 0;
+    TEST_ASSERT( WorkerResources::GetFreeDiskSpace( AStackString<>( "." ), freeBytes ) );
+    TEST_ASSERT( freeBytes > 0 );
+
+    TEST_ASSERT( WorkerResources::GetFreeDiskSpace( AStackString<>( "../tmp/Test/WorkerResources/DoesNotExist/" ), freeBytes ) == false );
+}
+
+// MemoryLimitedCPUs
+//------------------------------------------------------------------------------
+void TestWorkerResources::MemoryLimitedCPUs() const
+{
+    //                                                  CPUs,   Active, Avail,  MinFree,    PerJob
+    // Plenty of memory: CPU limit applies
+    TEST_ASSERT( WorkerResources::CalcMemoryLimitedCPUs( 8,     0,      65536,  1024,       1024 ) == 8 );
+    TEST_ASSERT( WorkerResources::CalcMemoryLimitedCPUs( 8,     6,      65536,  1024,       1024 ) == 8 );
+
+    // Memory for only some new jobs
+    TEST_ASSERT( WorkerResources::CalcMemoryLimitedCPUs( 8,     0,      4096,   1024,       1024 ) == 3 );
+    TEST_ASSERT( WorkerResources::CalcMemoryLimitedCPUs( 8,     2,      4095,   1024,       1024 ) == 4 );
+
+    // No memory for new jobs: running jobs keep their CPUs
+    TEST_ASSERT( WorkerResources::CalcMemoryLimitedCPUs( 8,     3,      1500,   1024,       1024 ) == 3 );
+    TEST_ASSERT( WorkerResources::CalcMemoryLimitedCPUs( 8,     0,      512,    1024,       1024 ) == 0 );
+
+    // Active jobs never exceed the CPU limit
+    TEST_ASSERT( WorkerResources::CalcMemoryLimitedCPUs( 4,     6,      512,    1024,       1024 ) == 4 );
+}
+
+// MakeSystemFile
+//------------------------------------------------------------------------------
+void TestWorkerResources::MakeSystemFile( const char * root, const char * relativePath, const char * contents ) const
+{
+    AStackString<> fileName( root );
+    fileName += relativePath;
+    TEST_ASSERT( FileIO::EnsurePathExistsForFile( fileName ) );
+    MakeFile( fileName.Get(), contents );
+}
+
+//------------------------------------------------------------------------------
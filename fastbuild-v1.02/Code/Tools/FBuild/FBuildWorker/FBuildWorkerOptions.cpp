@@ -7,6 +7,7 @@
 
 // FBuildCore
 #include "Tools/FBuild/FBuildCore/FBuildVersion.h"
+#include "Tools/FBuild/FBuildCore/Protocol/Protocol.h"
 
 // Core
 #include "Core/Containers/Array.h"
@@ -31,7 +32,17 @@ FBuildWorkerOptions::FBuildWorkerOptions() :
     m_OverrideWorkMode( false ),
     m_WorkMode( WorkerSettings::WHEN_IDLE ),
     m_MinimumFreeMemoryMiB( 0 ),
-    m_ConsoleMode( false )
+    m_OverrideToolchainDiskBudget( false ),
+    m_ToolchainDiskBudgetMiB( 0 ),
+#if defined( __LINUX__ )
+    m_UseCGroups( false ),
+    m_JobCPUWeight( 100 ),
+    m_JobMemoryLimitMiB( 0 ),
+    m_MemoryStagingMiB( 0 ),
+#endif
+    m_ConsoleMode( false ),
+    m_RunBroker( false ),
+    m_BrokerPort( Protocol::BROKER_PORT )
 {
     #ifdef __LINUX__
         m_ConsoleMode = true; // Only console mode supported on Linux
@@ -61,7 +72,25 @@ bool FBuildWorkerOptions::ProcessCommandLine( const AString & commandLine )
                 continue;
             }
         #endif
-        if ( token.BeginsWith( "-cpus=" ) )
+        if ( token == "-broker" )
+        {
+            m_RunBroker = true;
+            continue;
+        }
+        else if ( token.BeginsWith( "-broker=" ) )
+        {
+            uint32_t port( 0 );
+            PRAGMA_DISABLE_PUSH_MSVC( 4996 ) // This function or variable may be unsafe...
+            if ( ( sscanf( token.Get() + 8, "%u", &port ) == 1 ) && ( port > 0 ) && ( port <= 0xFFFF ) ) // TODO:C consider sscanf_s
+            PRAGMA_DISABLE_POP_MSVC // 4996
+            {
+                m_RunBroker = true;
+                m_BrokerPort = (uint16_t)port;
+                continue;
+            }
+            // problem... fall through
+        }
+        else if ( token.BeginsWith( "-cpus=" ) )
         {
             int32_t numCPUs = (int32_t)Env::GetNumProcessors();
             int32_t num( 0 );
@@ -116,6 +145,19 @@ bool FBuildWorkerOptions::ProcessCommandLine( const AString & commandLine )
             m_OverrideWorkMode = true;
             continue;
         }
+        else if ( token.BeginsWith( "-toolchaindisk=" ) )
+        {
+            uint32_t num( 0 );
+            PRAGMA_DISABLE_PUSH_MSVC( 4996 ) // This function or variable may be unsafe...
+            if ( sscanf( token.Get() + 15, "%u", &num ) == 1 ) // TODO:C consider sscanf_s
+            PRAGMA_DISABLE_POP_MSVC // 4996
+            {
+                m_ToolchainDiskBudgetMiB = num;
+                m_OverrideToolchainDiskBudget = true;
+                continue;
+            }
+            // problem... fall through
+        }
         #if defined( __WINDOWS__ )
             else if ( token.BeginsWith( "-minfreememory=" ) )
             {
@@ -144,6 +186,43 @@ bool FBuildWorkerOptions::ProcessCommandLine( const AString & commandLine )
                 continue;
             }
         #endif
+        #if defined( __LINUX__ )
+            else if ( token == "-cgroups" )
+            {
+                m_UseCGroups = true;
+                continue;
+            }
+            else if ( token.BeginsWith( "-jobcpuweight=" ) )
+            {
+                uint32_t num( 0 );
+                if ( ( sscanf( token.Get() + 14, "%u", &num ) == 1 ) && ( num >= 1 ) && ( num <= 10000 ) )
+                {
+                    m_JobCPUWeight = num;
+                    continue;
+                }
+                // problem... fall through
+            }
+            else if ( token.BeginsWith( "-jobmemorylimit=" ) )
+            {
+                uint32_t num( 0 );
+                if ( sscanf( token.Get() + 16, "%u", &num ) == 1 )
+                {
+                    m_JobMemoryLimitMiB = num;
+                    continue;
+                }
+                // problem... fall through
+            }
+            else if ( token.BeginsWith( "-stagememory=" ) )
+            {
+                uint32_t num( 0 );
+                if ( sscanf( token.Get() + 13, "%u", &num ) == 1 )
+                {
+                    m_MemoryStagingMiB = num;
+                    continue;
+                }
+                // problem... fall through
+            }
+        #endif
 
         ShowUsageError();
         return false;
@@ -161,6 +240,11 @@ void FBuildWorkerOptions::ShowUsageError()
                        "\n"
                        "Command Line Options:\n"
                        "---------------------------------------------------------------------------\n"
+                       " -broker[=port]\n"
+                       "        Run a broker for worker discovery instead of a worker.\n"
+                       "        Workers and clients find it with FASTBUILD_BROKER=host[:port].\n"
+                       " -cgroups\n"
+                       "        (Linux) Run each job in its own cgroup v2 (requires a delegated cgroup).\n"
                        " -console\n"
                        "        (Windows/OSX) Operate from console instead of GUI.\n"
                        " -cpus=<n|-n|n%>   Set number of CPUs to use:\n"
@@ -174,11 +258,21 @@ void FBuildWorkerOptions::ShowUsageError()
                        "        - disabled : Don't accept any work.\n"
                        "        - idle : Accept work when PC is idle.\n"
                        "        - dedicated : Accept work always.\n"
-                       "        - proportional : Accept work proportional to free CPUs.\n"
+                       "        - proportional : Accept work on CPUs left idle by other processes.\n"
+                       " -jobcpuweight=<1-10000>\n"
+                       "        (Linux) CPU weight of each job's cgroup (default 100).\n"
+                       " -jobmemorylimit=<MiB>\n"
+                       "        (Linux) Memory limit of each job's cgroup (default unlimited).\n"
                        " -minfreememory <MiB>\n"
                        "        Set minimum free memory (MiB) required to accept work.\n"
                        " -nosubprocess\n"
                        "        (Windows) Don't spawn a sub-process worker copy.\n"
+                       " -stagememory=<MiB>\n"
+                       "        (Linux) Keep temp files of jobs in memory (/dev/shm), up to this size.\n"
+                       "        Jobs which don't fit use the disk. 0 disables (default).\n"
+                       " -toolchaindisk=<MiB>\n"
+                       "        Disk space for toolchains kept between sessions (default 16384).\n"
+                       "        Least recently used toolchains are removed first. 0 disables.\n"
                        "---------------------------------------------------------------------------\n"
                        ;
 
@@ -35,10 +35,26 @@ public:
     bool m_OverrideWorkMode;
     WorkerSettings::Mode m_WorkMode;
     uint32_t m_MinimumFreeMemoryMiB; // Minimum OS free memory including virtual memory to let worker do its work
+    bool m_OverrideToolchainDiskBudget;
+    uint32_t m_ToolchainDiskBudgetMiB; // Disk space for toolchains kept between sessions
+
+    // job isolation
+    #if defined( __LINUX__ )
+        bool m_UseCGroups;              // Run each job in its own cgroup v2
+        uint32_t m_JobCPUWeight;        // cpu.weight of each job's cgroup
+        uint32_t m_JobMemoryLimitMiB;   // memory.max of each job's cgroup (0 = unlimited)
+
+        // temp files
+        uint32_t m_MemoryStagingMiB;    // Budget for temp files kept in memory (0 = disabled)
+    #endif
 
     // Console mode
     bool m_ConsoleMode;
 
+    // Broker mode (run a broker instead of a worker)
+    bool m_RunBroker;
+    uint16_t m_BrokerPort;
+
 private:
     void ShowUsageError();
 };
@@ -8,6 +8,11 @@
 #include "Tools/FBuild/FBuildWorker/FBuildWorkerOptions.h"
 #include "Tools/FBuild/FBuildWorker/Worker/Worker.h"
 
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/Protocol/Broker.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/MemoryStaging.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/WorkerCGroups.h"
+
 // Core
 #include "Core/Env/Assert.h"
 #include "Core/Env/Env.h"
@@ -32,6 +37,7 @@ SystemMutex g_OneProcessMutex( "Global\\FBuildWorker" );
 // Functions
 //------------------------------------------------------------------------------
 int MainCommon( const AString & args );
+int RunBroker( uint16_t port );
 #if defined( __WINDOWS__ )
     int LaunchSubProcess( const AString & args );
 #endif
@@ -81,6 +87,12 @@ int MainCommon( const AString & args )
         return -3;
     }
 
+    // a broker runs instead of a worker (run a second process to have both)
+    if ( options.m_RunBroker )
+    {
+        return RunBroker( options.m_BrokerPort );
+    }
+
     // only allow 1 worker per system
     Timer t;
     while ( g_OneProcessMutex.TryLock() == false )
@@ -116,6 +128,37 @@ int MainCommon( const AString & args )
         // TODO:LINUX SetPriorityClass equivalent
     #endif
 
+    // isolate jobs in their own cgroups
+    #if defined( __LINUX__ )
+        WorkerCGroups * cgroups = nullptr;
+        if ( options.m_UseCGroups )
+        {
+            cgroups = FNEW( WorkerCGroups );
+            AStackString<> error;
+            if ( cgroups->Init( options.m_JobCPUWeight, ( (uint64_t)options.m_JobMemoryLimitMiB * MEGABYTE ), error ) == false )
+            {
+                printf( "Failed to set up cgroups: %s\n", error.Get() );
+                FDELETE cgroups;
+                return -4;
+            }
+        }
+
+        // keep temp files of jobs in memory
+        MemoryStaging * memoryStaging = nullptr;
+        if ( options.m_MemoryStagingMiB > 0 )
+        {
+            AStackString<> memoryRoot;
+            if ( MemoryStaging::GetDefaultRoot( memoryRoot ) )
+            {
+                memoryStaging = FNEW( MemoryStaging( memoryRoot, ( (uint64_t)options.m_MemoryStagingMiB * MEGABYTE ) ) );
+            }
+            else
+            {
+                printf( "Memory staging unavailable: /dev/shm is not a tmpfs\n" );
+            }
+        }
+    #endif
+
     // start the worker and wait for it to be closed
     int ret;
     {
@@ -132,12 +175,40 @@ int MainCommon( const AString & args )
         {
             WorkerSettings::Get().SetMinimumFreeMemoryMiB( options.m_MinimumFreeMemoryMiB );
         }
+        if ( options.m_OverrideToolchainDiskBudget )
+        {
+            WorkerSettings::Get().SetToolchainDiskBudgetMiB( options.m_ToolchainDiskBudgetMiB );
+        }
         ret = worker.Work();
     }
 
+    #if defined( __LINUX__ )
+        FDELETE memoryStaging;
+        FDELETE cgroups;
+    #endif
+
     return ret;
 }
 
+// RunBroker
+//------------------------------------------------------------------------------
+int RunBroker( uint16_t port )
+{
+    Broker broker;
+    if ( broker.Listen( port ) == false )
+    {
+        printf( "Failed to listen on port %u.  Check port is not in use.\n", (uint32_t)port );
+        return -5;
+    }
+    printf( "FBuildWorker Broker listening on port %u\n", (uint32_t)port );
+
+    // Serve workers and clients until killed
+    for ( ;; )
+    {
+        Thread::Sleep( 1000 );
+    }
+}
+
 // LaunchSubProcess
 //------------------------------------------------------------------------------
 #if defined( __WINDOWS__ )
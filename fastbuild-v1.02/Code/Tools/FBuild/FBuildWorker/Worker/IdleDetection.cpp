@@ -39,10 +39,7 @@ IdleDetection::IdleDetection()
     : m_CPUUsageFASTBuild( 0.0f )
     , m_CPUUsageTotal( 0.0f )
     , m_IsIdle( false )
-    , m_IsIdleFloat( 0.0f )
-    , m_IsIdleCurrent( 0.0f )
     , m_IdleSmoother( 0 )
-    , m_IdleFloatSmoother( 0 )
     , m_ProcessesInOurHierarchy( 32, true )
     , m_LastTimeIdle( 0 )
     , m_LastTimeBusy( 0 )
@@ -66,7 +63,7 @@ IdleDetection::~IdleDetection() = default;
 void IdleDetection::Update( uint32_t idleThresholdPercent )
 {
     // apply smoothing based on current "idle" state
-    if ( IsIdleInternal( idleThresholdPercent, m_IsIdleCurrent ) )
+    if ( IsIdleInternal( idleThresholdPercent ) )
     {
         ++m_IdleSmoother;
     }
@@ -85,28 +82,19 @@ void IdleDetection::Update( uint32_t idleThresholdPercent )
     {
         m_IsIdle = false;
     }
+}
 
-    // separate smoothing for idle float values. They behave differently.
-    if ( m_IsIdleCurrent >= m_IsIdleFloat )
-    {
-        ++m_IdleFloatSmoother;
-    }
-    else
-    {
-        m_IdleFloatSmoother -= 2; // become non-idle more quickly than we become idle
-    }
-    m_IdleFloatSmoother = Math::Clamp( m_IdleFloatSmoother, 0, 10 );
-
-    // change state only when at extreme of either end of scale
-    if ( ( m_IdleFloatSmoother == 10 ) || ( m_IdleFloatSmoother == 0 ) ) // 5 secs (called every ~500ms)
-    {
-        m_IsIdleFloat = m_IsIdleCurrent;
-    }
+// GetOtherCPUUsagePercent
+//------------------------------------------------------------------------------
+float IdleDetection::GetOtherCPUUsagePercent() const
+{
+    // FASTBuild usage is sampled less often, so can briefly exceed the total
+    return Math::Clamp( ( m_CPUUsageTotal - m_CPUUsageFASTBuild ), 0.0f, m_CPUUsageTotal );
 }
 
 // IsIdleInternal
 //------------------------------------------------------------------------------
-bool IdleDetection::IsIdleInternal( uint32_t idleThresholdPercent, float & idleCurrent )
+bool IdleDetection::IsIdleInternal( uint32_t idleThresholdPercent )
 {
     // determine total cpu time (including idle)
     uint64_t systemTime = 0;
@@ -131,7 +119,6 @@ bool IdleDetection::IsIdleInternal( uint32_t idleThresholdPercent, float & idleC
     // check to know acurately what the cpu use of FASTBuild is
     if ( m_CPUUsageTotal < (float)idleThresholdPercent )
     {
-        idleCurrent = 1.0f;
         return true;
     }
 
@@ -169,7 +156,6 @@ bool IdleDetection::IsIdleInternal( uint32_t idleThresholdPercent, float & idleC
         m_Timer.Start();
     }
 
-    idleCurrent = ( 1.0f - ( ( m_CPUUsageTotal - m_CPUUsageFASTBuild ) * 0.01f ) );
     return ( ( m_CPUUsageTotal - m_CPUUsageFASTBuild ) < (float)idleThresholdPercent );
 }
 
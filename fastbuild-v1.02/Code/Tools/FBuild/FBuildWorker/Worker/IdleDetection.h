@@ -26,7 +26,9 @@ public:
 
     // query status
     inline bool IsIdle() const { return m_IsIdle; }
-    inline float IsIdleFloat() const { return m_IsIdleFloat; }
+
+    // CPU usage of everything except FASTBuild, as a percentage of all CPUs
+    float GetOtherCPUUsagePercent() const;
 
 private:
     // struct to track processes with
@@ -42,7 +44,7 @@ private:
         uint64_t    m_LastTime;
     };
 
-    bool IsIdleInternal( uint32_t idleThresholdPercent, float & idleCurrent );
+    bool IsIdleInternal( uint32_t idleThresholdPercent );
 
     static void GetSystemTotalCPUUsage( uint64_t & outIdleTime,
                                         uint64_t & outKernTime,
@@ -63,10 +65,7 @@ private:
     float   m_CPUUsageFASTBuild;
     float   m_CPUUsageTotal;
     bool    m_IsIdle;
-    float   m_IsIdleFloat;
-    float   m_IsIdleCurrent;
     int32_t m_IdleSmoother;
-    int32_t m_IdleFloatSmoother;
     Array< ProcessInfo > m_ProcessesInOurHierarchy;
     uint64_t m_LastTimeIdle;
     uint64_t m_LastTimeBusy;
@@ -19,6 +19,7 @@
 #include "Tools/FBuild/FBuildCore/Protocol/Protocol.h"
 #include "Tools/FBuild/FBuildCore/Protocol/Server.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/JobQueueRemote.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/WorkerResources.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/WorkerThreadRemote.h"
 
 // Core
@@ -38,6 +39,11 @@
 #endif
 #include <stdio.h>
 
+// Defines
+//------------------------------------------------------------------------------
+#define WORKER_MIN_DISK_SPACE       ( 1024 * MEGABYTE ) // 1 GiB
+#define WORKER_MEMORY_PER_JOB_MIB   ( 1024 )            // Estimated peak memory of a job
+
 // CONSTRUCTOR
 //------------------------------------------------------------------------------
 Worker::Worker( const AString & args, bool consoleMode )
@@ -49,10 +55,9 @@ Worker::Worker( const AString & args, bool consoleMode )
     , m_LastWriteTime( 0 )
     , m_WantToQuit( false )
     , m_RestartNeeded( false )
-    #if defined( __WINDOWS__ )
-        , m_LastDiskSpaceResult( -1 )
-        , m_LastMemoryCheckResult( -1 )
-    #endif
+    , m_LastDiskSpaceResult( -1 )
+    , m_LastMemoryCheckResult( -1 )
+    , m_LastAvailableMemoryMiB( (uint64_t)-1 )
 {
     m_WorkerSettings = FNEW( WorkerSettings );
     m_NetworkStartupHelper = FNEW( NetworkStartupHelper );
@@ -158,6 +163,14 @@ uint32_t Worker::WorkThread()
     // Initial status message
     StatusMessage( "FBuildWorker %s", FBUILD_VERSION_STRING );
 
+    // reuse toolchains synchronized in previous sessions
+    const uint32_t toolchainDiskBudgetMiB = m_WorkerSettings->GetToolchainDiskBudgetMiB();
+    if ( toolchainDiskBudgetMiB > 0 )
+    {
+        StatusMessage( "Loading stored toolchains (%u MiB budget)\n", toolchainDiskBudgetMiB );
+        m_ConnectionPool->EnableToolchainStore( (uint64_t)toolchainDiskBudgetMiB * MEGABYTE );
+    }
+
     // start listening
     StatusMessage( "Listening on port %u\n", Protocol::PROTOCOL_PORT );
     if ( m_ConnectionPool->Listen( Protocol::PROTOCOL_PORT ) == false )
@@ -225,37 +238,27 @@ uint32_t Worker::WorkThread()
 //------------------------------------------------------------------------------
 bool Worker::HasEnoughDiskSpace()
 {
-    #if defined( __WINDOWS__ )
-        // Only check disk space every few seconds
-        float elapsedTime = m_TimerLastDiskSpaceCheck.GetElapsedMS();
-        if ( ( elapsedTime < 15000.0f ) && ( m_LastDiskSpaceResult != -1 ) )
-        {
-            return ( m_LastDiskSpaceResult != 0 );
-        }
-        m_TimerLastDiskSpaceCheck.Start();
-
-        static const uint64_t MIN_DISK_SPACE = 1024 * 1024 * 1024; // 1 GiB
-
-        unsigned __int64 freeBytesAvailable = 0;
-        unsigned __int64 totalNumberOfBytes = 0;
-        unsigned __int64 totalNumberOfFreeBytes = 0;
+    // Only check disk space every few seconds
+    float elapsedTime = m_TimerLastDiskSpaceCheck.GetElapsedMS();
+    if ( ( elapsedTime < 15000.0f ) && ( m_LastDiskSpaceResult != -1 ) )
+    {
+        return ( m_LastDiskSpaceResult != 0 );
+    }
+    m_TimerLastDiskSpaceCheck.Start();
 
-        // Check available disk space of temp path
-        AStackString<> tmpPath;
-        VERIFY( FBuild::GetTempDir( tmpPath ) );
-        BOOL result = GetDiskFreeSpaceExA( tmpPath.Get(), (PULARGE_INTEGER)&freeBytesAvailable, (PULARGE_INTEGER)&totalNumberOfBytes, (PULARGE_INTEGER)&totalNumberOfFreeBytes );
-        if ( result && ( freeBytesAvailable >= MIN_DISK_SPACE ) )
-        {
-            m_LastDiskSpaceResult = 1;
-            return true;
-        }
+    // Check available disk space of temp path
+    AStackString<> tmpPath;
+    VERIFY( FBuild::GetTempDir( tmpPath ) );
+    uint64_t freeBytesAvailable = 0;
+    if ( WorkerResources::GetFreeDiskSpace( tmpPath, freeBytesAvailable ) && ( freeBytesAvailable >= WORKER_MIN_DISK_SPACE ) )
+    {
+        m_LastDiskSpaceResult = 1;
+        return true;
+    }
 
-        // The drive doesn't have enough free space or could not be queried. Exclude this machine from worker pool.
-        m_LastDiskSpaceResult = 0;
-        return false;
-    #else
-        return true; // TODO:MAC TODO:LINUX Implement disk space checks
-    #endif
+    // The drive doesn't have enough free space or could not be queried. Exclude this machine from worker pool.
+    m_LastDiskSpaceResult = 0;
+    return false;
 }
 
 // HasEnoughMemory
@@ -290,11 +293,42 @@ bool Worker::HasEnoughMemory()
             }
         }
     
+        // The machine doesn't have enough memory or query failed. Exclude this machine from worker pool.
+        m_LastMemoryCheckResult = 0;
+        return false;
+    #elif defined( __LINUX__ )
+        // Only check free memory every few seconds
+        float elapsedTime = m_TimerLastMemoryCheck.GetElapsedMS();
+        if ( ( elapsedTime < 1000.0f ) && ( m_LastMemoryCheckResult != -1 ) )
+        {
+            return ( m_LastMemoryCheckResult != 0 );
+        }
+        m_TimerLastMemoryCheck.Start();
+
+        // Memory available to us, respecting any cgroup (container) limits
+        uint64_t availableBytes = 0;
+        if ( WorkerResources().GetAvailableMemory( availableBytes ) )
+        {
+            m_LastAvailableMemoryMiB = ( availableBytes / MEGABYTE );
+
+            // Check if the free memory is high enough
+            WorkerSettings & ws = WorkerSettings::Get();
+            if ( m_LastAvailableMemoryMiB > ws.GetMinimumFreeMemoryMiB() )
+            {
+                m_LastMemoryCheckResult = 1;
+                return true;
+            }
+        }
+        else
+        {
+            m_LastAvailableMemoryMiB = (uint64_t)-1;
+        }
+
         // The machine doesn't have enough memory or query failed. Exclude this machine from worker pool.
         m_LastMemoryCheckResult = 0;
         return false;
     #else
-        return true; // TODO:LINUX TODO:OSX Implement
+        return true; // TODO:OSX Implement
     #endif
 }
 
@@ -323,14 +357,10 @@ void Worker::UpdateAvailability()
         }
         case WorkerSettings::PROPORTIONAL:
         {
-            if ( ( m_IdleDetection.IsIdleFloat() >= 0.0f ) && ( m_IdleDetection.IsIdleFloat() <= 1.0f ) )
-            {
-                numCPUsToUse = uint32_t( (float)numCPUsToUse * m_IdleDetection.IsIdleFloat() );
-            }
-            else
-            {
-                numCPUsToUse = 0;
-            }
+            // use the CPUs other processes leave free, with hysteresis
+            numCPUsToUse = m_CPUSlots.Update( numCPUsToUse,
+                                              Env::GetNumProcessors(),
+                                              m_IdleDetection.GetOtherCPUUsagePercent() );
             break;
         }
         case WorkerSettings::DEDICATED:
@@ -344,6 +374,16 @@ void Worker::UpdateAvailability()
         }
     }
 
+    // offer fewer CPUs if there isn't enough memory for each job
+    if ( ( numCPUsToUse > 0 ) && ( m_LastAvailableMemoryMiB != (uint64_t)-1 ) )
+    {
+        numCPUsToUse = WorkerResources::CalcMemoryLimitedCPUs( numCPUsToUse,
+                                                               (uint32_t)JobQueueRemote::Get().GetNumInFlightJobs(),
+                                                               m_LastAvailableMemoryMiB,
+                                                               ws.GetMinimumFreeMemoryMiB(),
+                                                               WORKER_MEMORY_PER_JOB_MIB );
+    }
+
     // don't accept any new work while waiting for a restart
     if ( m_RestartNeeded || ( hasEnoughDiskSpace == false ) || ( hasEnoughMemory == false ) )
     {
@@ -352,6 +392,13 @@ void Worker::UpdateAvailability()
 
     WorkerThreadRemote::SetNumCPUsToUse( numCPUsToUse );
 
+    // status reported to the broker (if there is one)
+    const uint32_t numInFlightJobs = (uint32_t)JobQueueRemote::Get().GetNumInFlightJobs();
+    const uint32_t numFreeSlots = ( numCPUsToUse > numInFlightJobs ) ? ( numCPUsToUse - numInFlightJobs ) : 0;
+    Array< uint64_t > toolIds( 0, true );
+    m_ConnectionPool->GetToolIds( toolIds );
+    m_WorkerBrokerage.SetBrokerStatus( numCPUsToUse, numFreeSlots, toolIds );
+
     m_WorkerBrokerage.SetAvailability( numCPUsToUse > 0 );
 }
 
@@ -373,12 +420,14 @@ void Worker::UpdateUI()
     {
         status += " (Restart Pending)";
     }
-    #if defined( __WINDOWS__ )
-        if ( m_LastDiskSpaceResult == 0 )
-        {
-            status += " (Low Disk Space)";
-        }
-    #endif
+    if ( m_LastDiskSpaceResult == 0 )
+    {
+        status += " (Low Disk Space)";
+    }
+    if ( m_LastMemoryCheckResult == 0 )
+    {
+        status += " (Low Memory)";
+    }
     if ( InConsoleMode() )
     {
         status += '\n';
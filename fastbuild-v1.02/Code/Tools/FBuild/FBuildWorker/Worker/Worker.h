@@ -8,6 +8,7 @@
 
 // FBuild
 #include "Tools/FBuild/FBuildCore/WorkerPool/WorkerBrokerage.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/WorkerCPUSlots.h"
 
 // Core
 #include "Core/Containers/Singleton.h"
@@ -56,6 +57,7 @@ private:
     NetworkStartupHelper * m_NetworkStartupHelper;
     WorkerSettings      * m_WorkerSettings;
     IdleDetection       m_IdleDetection;
+    WorkerCPUSlots      m_CPUSlots;
     WorkerBrokerage     m_WorkerBrokerage;
     AString             m_BaseExeName;
     AString             m_BaseArgs;
@@ -64,13 +66,12 @@ private:
     bool                m_RestartNeeded;
     Timer               m_UIUpdateTimer;
     FileStream          m_TargetIncludeFolderLock;
-    #if defined( __WINDOWS__ )
-        Timer               m_TimerLastDiskSpaceCheck;
-        int32_t             m_LastDiskSpaceResult;      // -1 : No check done yet. 0=Not enough space right now. 1=OK for now.
+    Timer               m_TimerLastDiskSpaceCheck;
+    int32_t             m_LastDiskSpaceResult;      // -1 : No check done yet. 0=Not enough space right now. 1=OK for now.
 
-        Timer               m_TimerLastMemoryCheck;
-        int32_t             m_LastMemoryCheckResult;    // -1 : No check done yet. 0=Not enough memory right now. 1=OK for now.
-#endif
+    Timer               m_TimerLastMemoryCheck;
+    int32_t             m_LastMemoryCheckResult;    // -1 : No check done yet. 0=Not enough memory right now. 1=OK for now.
+    uint64_t            m_LastAvailableMemoryMiB;   // Result of last memory check, or (uint64_t)-1 if unknown
     mutable AString     m_LastStatusMessage;
     Thread::ThreadHandle m_WorkThread;
 };
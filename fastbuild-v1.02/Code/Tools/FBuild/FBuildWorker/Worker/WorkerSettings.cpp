@@ -30,6 +30,7 @@ WorkerSettings::WorkerSettings()
     , m_StartMinimized( false )
     , m_SettingsWriteTime( 0 )
     , m_MinimumFreeMemoryMiB( 1024 ) // 1 GiB
+    , m_ToolchainDiskBudgetMiB( 16 * 1024 ) // 16 GiB
 {
     // half CPUs available to use by default
     uint32_t numCPUs = Env::GetNumProcessors();
@@ -80,6 +81,13 @@ void WorkerSettings::SetMinimumFreeMemoryMiB( uint32_t value )
     m_MinimumFreeMemoryMiB = value;
 }
 
+// SetToolchainDiskBudgetMiB
+//------------------------------------------------------------------------------
+void WorkerSettings::SetToolchainDiskBudgetMiB( uint32_t value )
+{
+    m_ToolchainDiskBudgetMiB = value;
+}
+
 // Load
 //------------------------------------------------------------------------------
 void WorkerSettings::Load()
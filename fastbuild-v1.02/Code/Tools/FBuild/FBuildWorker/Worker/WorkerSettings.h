@@ -45,6 +45,10 @@ public:
     inline uint32_t GetMinimumFreeMemoryMiB() { return m_MinimumFreeMemoryMiB; }
     void SetMinimumFreeMemoryMiB( uint32_t value );
 
+    // Disk space for toolchains kept between sessions (0 = don't keep them)
+    inline uint32_t GetToolchainDiskBudgetMiB() const { return m_ToolchainDiskBudgetMiB; }
+    void SetToolchainDiskBudgetMiB( uint32_t value );
+
     void Load();
     void Save();
 
@@ -55,6 +59,7 @@ private:
     bool        m_StartMinimized;
     uint64_t    m_SettingsWriteTime;    // FileTime of settings when last changed/written to disk
     uint32_t    m_MinimumFreeMemoryMiB; // Minimum OS free memory including virtual memory to let worker do its work
+    uint32_t    m_ToolchainDiskBudgetMiB; // Disk space for toolchains kept between sessions
 };
 
 //------------------------------------------------------------------------------